@@ -0,0 +1,12 @@
+
+#ifndef PODOFO_WRAPPER_PDFTHREADSH
+#define PODOFO_WRAPPER_PDFTHREADSH
+/*
+ * This is a simple wrapper include file that lets you include
+ * <podofo/base/PdfThreads.h> when building against a podofo build directory
+ * rather than an installed copy of podofo. You'll probably need
+ * this if you're including your own (probably static) copy of podofo
+ * using a mechanism like svn:externals .
+ */
+#include "../../../src/base/util/PdfThreads.h"
+#endif
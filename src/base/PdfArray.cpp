@@ -73,11 +73,11 @@ void PdfArray::Write( PdfOutputDevice* pDevice, EPdfWriteMode eWriteMode,
 
     if( (eWriteMode & ePdfWriteMode_Clean) == ePdfWriteMode_Clean ) 
     {
-        pDevice->Print( "[ " );
+        pDevice->Write( "[ ", 2 );
     }
     else
     {
-        pDevice->Print( "[" );
+        pDevice->Write( "[", 1 );
     }
 
     while( it != this->end() )
@@ -85,14 +85,14 @@ void PdfArray::Write( PdfOutputDevice* pDevice, EPdfWriteMode eWriteMode,
         (*it).Write( pDevice, eWriteMode, pEncrypt );
         if( (eWriteMode & ePdfWriteMode_Clean) == ePdfWriteMode_Clean ) 
         {
-            pDevice->Print( (count % 10 == 0) ? "\n" : " " );
+            pDevice->Write( (count % 10 == 0) ? "\n" : " ", 1 );
         }
 
         ++it;
         ++count;
     }
 
-    pDevice->Print( "]" );
+    pDevice->Write( "]", 1 );
 }
 
 bool PdfArray::ContainsString( const std::string& cmpString ) const
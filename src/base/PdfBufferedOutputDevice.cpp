@@ -0,0 +1,298 @@
+/***************************************************************************
+ *   Copyright (C) 2006 by Dominik Seichter                                *
+ *   domseichter@web.de                                                    *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Library General Public License as       *
+ *   published by the Free Software Foundation; either version 2 of the    *
+ *   License, or (at your option) any later version.                       *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this program; if not, write to the                 *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#include "PdfBufferedOutputDevice.h"
+#include "PdfDefinesPrivate.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <vector>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif // _WIN32
+
+namespace PoDoFo {
+
+const size_t PdfBufferedOutputDevice::DEFAULT_BUFFER_SIZE = 1024 * 1024;
+
+#ifdef _WIN32
+static const int PDF_OPEN_FLAGS = _O_RDWR | _O_CREAT | _O_TRUNC | _O_BINARY;
+static const int PDF_OPEN_MODE  = _S_IREAD | _S_IWRITE;
+#else
+static const int PDF_OPEN_FLAGS = O_RDWR | O_CREAT | O_TRUNC;
+static const int PDF_OPEN_MODE  = 0666;
+#endif // _WIN32
+
+PdfBufferedOutputDevice::PdfBufferedOutputDevice( const char* pszFilename, size_t lBufferSize, int nPolicies )
+    : m_nPolicies( nPolicies )
+{
+    if( !pszFilename ) 
+    {
+        PODOFO_RAISE_ERROR( ePdfError_InvalidHandle );
+    }
+
+#ifdef _WIN32
+    m_nFile = _open( pszFilename, PDF_OPEN_FLAGS, PDF_OPEN_MODE );
+#else
+    m_nFile = open( pszFilename, PDF_OPEN_FLAGS, PDF_OPEN_MODE );
+#endif // _WIN32
+    if( m_nFile == -1 ) 
+    {
+        PODOFO_RAISE_ERROR_INFO( ePdfError_FileNotFound, pszFilename );
+    }
+
+    this->Init( lBufferSize );
+}
+
+#ifdef _WIN32
+PdfBufferedOutputDevice::PdfBufferedOutputDevice( const wchar_t* pszFilename, size_t lBufferSize, int nPolicies )
+    : m_nPolicies( nPolicies )
+{
+    if( !pszFilename ) 
+    {
+        PODOFO_RAISE_ERROR( ePdfError_InvalidHandle );
+    }
+
+    m_nFile = _wopen( pszFilename, PDF_OPEN_FLAGS, PDF_OPEN_MODE );
+    if( m_nFile == -1 ) 
+    {
+        PdfError e( ePdfError_FileNotFound, __FILE__, __LINE__ );
+        e.SetErrorInformation( pszFilename );
+        throw e;
+    }
+
+    this->Init( lBufferSize );
+}
+#endif // _WIN32
+
+PdfBufferedOutputDevice::~PdfBufferedOutputDevice()
+{
+    try { 
+        this->FlushBuffer();
+    } catch( const PdfError & e ) {
+        e.PrintErrorMsg();
+    }
+
+#ifdef _WIN32
+    _close( m_nFile );
+#else
+    close( m_nFile );
+#endif // _WIN32
+    podofo_free( m_pWriteBuffer );
+}
+
+void PdfBufferedOutputDevice::Init( size_t lBufferSize )
+{
+    m_lBufferSize   = PDF_MAX( lBufferSize, static_cast<size_t>(4096) );
+    m_lBufferOffset = 0;
+    m_lBufferPos    = 0;
+    m_lBufferUsed   = 0;
+    m_pWriteBuffer  = static_cast<char*>(podofo_malloc( m_lBufferSize ));
+    if( !m_pWriteBuffer ) 
+    {
+#ifdef _WIN32
+        _close( m_nFile );
+#else
+        close( m_nFile );
+#endif // _WIN32
+        PODOFO_RAISE_ERROR( ePdfError_OutOfMemory );
+    }
+
+#if defined(POSIX_FADV_SEQUENTIAL)
+    if( m_nPolicies & ePdfOutputPolicy_Sequential ) 
+        posix_fadvise( m_nFile, 0, 0, POSIX_FADV_SEQUENTIAL );
+#endif // POSIX_FADV_SEQUENTIAL
+}
+
+void PdfBufferedOutputDevice::WriteAt( size_t offset, const char* pBuffer, size_t lLen )
+{
+#ifdef _WIN32
+    if( _lseeki64( m_nFile, offset, SEEK_SET ) == -1 ) 
+    {
+        PODOFO_RAISE_ERROR( ePdfError_ValueOutOfRange );
+    }
+#endif // _WIN32
+
+    while( lLen ) 
+    {
+#ifdef _WIN32
+        int lWritten = _write( m_nFile, pBuffer, static_cast<unsigned int>(PDF_MIN( lLen, static_cast<size_t>(0x40000000) )) );
+#else
+        ssize_t lWritten = pwrite( m_nFile, pBuffer, lLen, offset );
+#endif // _WIN32
+        if( lWritten <= 0 ) 
+        {
+            if( lWritten == -1 && errno == EINTR ) 
+                continue;
+
+            PODOFO_RAISE_ERROR( ePdfError_UnexpectedEOF );
+        }
+
+        pBuffer += lWritten;
+        offset  += lWritten;
+        lLen    -= lWritten;
+    }
+}
+
+void PdfBufferedOutputDevice::FlushBuffer()
+{
+    if( m_lBufferUsed ) 
+        this->WriteAt( m_lBufferOffset, m_pWriteBuffer, m_lBufferUsed );
+
+    // Data behind m_lBufferPos is on disk now, so a new buffer can start at the write position
+    m_lBufferOffset += m_lBufferPos;
+    m_lBufferPos     = 0;
+    m_lBufferUsed    = 0;
+}
+
+void PdfBufferedOutputDevice::PrintV( const char* pszFormat, long lBytes, va_list args )
+{
+    if( !pszFormat || lBytes < 0 )
+    {
+        PODOFO_RAISE_ERROR( ePdfError_InvalidHandle );
+    }
+
+    // vsnprintf needs room for a terminating zero
+    size_t lNeeded = static_cast<size_t>(lBytes) + 1;
+    if( lNeeded > m_lBufferSize - m_lBufferPos ) 
+        this->FlushBuffer();
+
+    // Format directly into the buffer, unless the 
+    // terminating zero would overwrite buffered data
+    if( lNeeded <= m_lBufferSize - m_lBufferPos && m_lBufferPos + lBytes >= m_lBufferUsed )
+    {
+        vsnprintf( m_pWriteBuffer + m_lBufferPos, lNeeded, pszFormat, args );
+        m_lBufferPos += lBytes;
+        m_lBufferUsed = m_lBufferPos;
+        m_ulLength    = PDF_MAX( m_ulLength, this->Tell() );
+    }
+    else
+    {
+        std::vector<char> buffer( lNeeded );
+        vsnprintf( &buffer[0], lNeeded, pszFormat, args );
+        this->Write( &buffer[0], lBytes );
+    }
+}
+
+void PdfBufferedOutputDevice::Write( const char* pBuffer, size_t lLen )
+{
+    if( lLen > m_lBufferSize - m_lBufferPos ) 
+    {
+        this->FlushBuffer();
+
+        if( lLen >= m_lBufferSize ) 
+        {
+            // Copying does not pay off for large blocks
+            this->WriteAt( m_lBufferOffset, pBuffer, lLen );
+            m_lBufferOffset += lLen;
+            m_ulLength       = PDF_MAX( m_ulLength, m_lBufferOffset );
+            return;
+        }
+    }
+
+    memcpy( m_pWriteBuffer + m_lBufferPos, pBuffer, lLen );
+    m_lBufferPos += lLen;
+    m_lBufferUsed = PDF_MAX( m_lBufferUsed, m_lBufferPos );
+    m_ulLength    = PDF_MAX( m_ulLength, this->Tell() );
+}
+
+size_t PdfBufferedOutputDevice::Read( char* pBuffer, size_t lLen )
+{
+    this->FlushBuffer();
+
+#ifdef _WIN32
+    if( _lseeki64( m_nFile, m_lBufferOffset, SEEK_SET ) == -1 ) 
+    {
+        PODOFO_RAISE_ERROR( ePdfError_ValueOutOfRange );
+    }
+#endif // _WIN32
+
+    size_t numRead = 0;
+    while( numRead < lLen ) 
+    {
+#ifdef _WIN32
+        int lRead = _read( m_nFile, pBuffer + numRead, static_cast<unsigned int>(PDF_MIN( lLen - numRead, static_cast<size_t>(0x40000000) )) );
+#else
+        ssize_t lRead = pread( m_nFile, pBuffer + numRead, lLen - numRead, m_lBufferOffset + numRead );
+#endif // _WIN32
+        if( lRead == 0 ) 
+            break; // EOF
+        else if( lRead == -1 ) 
+        {
+            if( errno == EINTR ) 
+                continue;
+
+            PODOFO_RAISE_ERROR( ePdfError_InvalidDeviceOperation );
+        }
+
+        numRead += lRead;
+    }
+
+    m_lBufferOffset += numRead;
+    return numRead;
+}
+
+void PdfBufferedOutputDevice::Seek( size_t offset )
+{
+    if( offset >= m_lBufferOffset && offset - m_lBufferOffset <= m_lBufferUsed ) 
+    {
+        // Inside the buffer, no I/O required
+        m_lBufferPos = offset - m_lBufferOffset;
+    }
+    else
+    {
+        this->FlushBuffer();
+        m_lBufferOffset = offset;
+    }
+
+    // Seek should not change the length of the device
+}
+
+void PdfBufferedOutputDevice::Flush()
+{
+    this->FlushBuffer();
+
+    if( m_nPolicies & ePdfOutputPolicy_SyncOnFlush ) 
+    {
+#if defined(_WIN32)
+        int nRet = _commit( m_nFile );
+#elif defined(_POSIX_SYNCHRONIZED_IO) && _POSIX_SYNCHRONIZED_IO > 0
+        int nRet = fdatasync( m_nFile );
+#else
+        int nRet = fsync( m_nFile );
+#endif
+        if( nRet == -1 ) 
+        {
+            PODOFO_RAISE_ERROR( ePdfError_InvalidDeviceOperation );
+        }
+    }
+
+#if defined(POSIX_FADV_DONTNEED)
+    if( m_nPolicies & ePdfOutputPolicy_DropCache ) 
+        posix_fadvise( m_nFile, 0, 0, POSIX_FADV_DONTNEED );
+#endif // POSIX_FADV_DONTNEED
+}
+
+};
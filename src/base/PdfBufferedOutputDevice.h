@@ -0,0 +1,160 @@
+/***************************************************************************
+ *   Copyright (C) 2006 by Dominik Seichter                                *
+ *   domseichter@web.de                                                    *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Library General Public License as       *
+ *   published by the Free Software Foundation; either version 2 of the    *
+ *   License, or (at your option) any later version.                       *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this program; if not, write to the                 *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#ifndef _PDF_BUFFERED_OUTPUT_DEVICE_H_
+#define _PDF_BUFFERED_OUTPUT_DEVICE_H_
+
+#include "PdfDefines.h"
+#include "PdfOutputDevice.h"
+
+namespace PoDoFo {
+
+/** Policies for the PdfBufferedOutputDevice, 
+ *  which can be combined using bitwise or.
+ *
+ *  Policies which are not supported by the operating system are ignored.
+ */
+enum EPdfOutputPolicy {
+    ePdfOutputPolicy_None       = 0x00, ///< Just write the data
+    ePdfOutputPolicy_Sequential = 0x01, ///< Tell the operating system that the file is written sequentially (posix_fadvise)
+    ePdfOutputPolicy_SyncOnFlush= 0x02, ///< Make sure all data has reached the disk when Flush() is called (fdatasync)
+    ePdfOutputPolicy_DropCache  = 0x04  ///< Remove the written data from the page cache when Flush() is called. 
+                                        ///< Use this together with ePdfOutputPolicy_SyncOnFlush, as only data 
+                                        ///< which has already been written to disk can be dropped.
+};
+
+/** An output device which writes to a file using a large buffer
+ *  in user space.
+ *
+ *  PdfWriter writes a PDF file in many very small pieces. 
+ *  This device collects all of them in a buffer and passes
+ *  the buffer to the operating system in one large block 
+ *  once it is full, so that there is only one system call 
+ *  for each block instead of one library call for each piece.
+ *
+ *  Seeking inside the data which is still in the buffer is free,
+ *  so that overwriting the last few bytes written (as done by 
+ *  PdfImmediateWriter) does not cause any I/O.
+ *
+ *  The file can also be read back after it was written, 
+ *  e.g. by PdfSignOutputDevice.
+ *
+ *  Data is written to disk when the buffer is full, on Flush(), 
+ *  before Seek() or Read() leave the buffered data and when the 
+ *  device is destroyed. Call Flush() before destroying the device
+ *  if you want to know whether writing all data succeeded,
+ *  as the destructor cannot report errors.
+ *
+ *  This is the device used by PdfMemDocument::Write and 
+ *  PdfStreamedDocument when a filename is passed.
+ */
+class PODOFO_API PdfBufferedOutputDevice : public PdfOutputDevice {
+ public:
+    /** The default size of the buffer in bytes.
+     */
+    static const size_t DEFAULT_BUFFER_SIZE;
+
+    /** Create a new file and write all data to it.
+     *  An existing file is truncated.
+     *
+     *  \param pszFilename path to a file that will be created
+     *  \param lBufferSize size of the write buffer in bytes
+     *  \param nPolicies a combination of EPdfOutputPolicy values
+     */
+    PdfBufferedOutputDevice( const char* pszFilename, size_t lBufferSize = DEFAULT_BUFFER_SIZE, 
+                             int nPolicies = ePdfOutputPolicy_None );
+
+#ifdef _WIN32
+    /** Create a new file and write all data to it.
+     *  An existing file is truncated.
+     *
+     *  \param pszFilename path to a file that will be created
+     *  \param lBufferSize size of the write buffer in bytes
+     *  \param nPolicies a combination of EPdfOutputPolicy values
+     *
+     *  This is an overloaded member function to allow working
+     *  with unicode characters. On Unix systes you can also path
+     *  UTF-8 to the const char* overload.
+     */
+    PdfBufferedOutputDevice( const wchar_t* pszFilename, size_t lBufferSize = DEFAULT_BUFFER_SIZE, 
+                             int nPolicies = ePdfOutputPolicy_None );
+#endif // _WIN32
+
+    /** Write all buffered data and close the file.
+     */
+    virtual ~PdfBufferedOutputDevice();
+
+    virtual void PrintV( const char* pszFormat, long lBytes, va_list argptr );
+
+    virtual void Write( const char* pBuffer, size_t lLen );
+
+    virtual size_t Read( char* pBuffer, size_t lLen );
+
+    virtual void Seek( size_t offset );
+
+    virtual inline size_t Tell() const;
+
+    /** Write all buffered data to the file.
+     *  Depending on the policies passed to the constructor
+     *  the data is also synced to disk and removed from the
+     *  page cache.
+     */
+    virtual void Flush();
+
+ private:
+    PdfBufferedOutputDevice( const PdfBufferedOutputDevice & rhs );
+    const PdfBufferedOutputDevice & operator=( const PdfBufferedOutputDevice & rhs );
+
+    /** Allocate the buffer and apply the open time policies 
+     *  after m_nFile has been opened.
+     */
+    void Init( size_t lBufferSize );
+
+    /** Write the buffered data to the file and start a new,
+     *  empty buffer at the current position.
+     */
+    void FlushBuffer();
+
+    /** Write lLen bytes to the file at position offset.
+     */
+    void WriteAt( size_t offset, const char* pBuffer, size_t lLen );
+
+ private:
+    int     m_nFile;
+    int     m_nPolicies;
+
+    char*   m_pWriteBuffer;     ///< the write buffer
+    size_t  m_lBufferSize;      ///< allocated size of m_pWriteBuffer
+    size_t  m_lBufferOffset;    ///< file position of the first byte in m_pWriteBuffer
+    size_t  m_lBufferPos;       ///< position of the next write in m_pWriteBuffer
+    size_t  m_lBufferUsed;      ///< number of valid bytes in m_pWriteBuffer, never less than m_lBufferPos
+};
+
+// -----------------------------------------------------
+// 
+// -----------------------------------------------------
+size_t PdfBufferedOutputDevice::Tell() const
+{
+    return m_lBufferOffset + m_lBufferPos;
+}
+
+};
+
+#endif // _PDF_BUFFERED_OUTPUT_DEVICE_H_
@@ -0,0 +1,795 @@
+/***************************************************************************
+ *   Copyright (C) 2007 by Dominik Seichter                                *
+ *   domseichter@web.de                                                    *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Library General Public License as       *
+ *   published by the Free Software Foundation; either version 2 of the    *
+ *   License, or (at your option) any later version.                       *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this program; if not, write to the                 *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#include "PdfContentsParser.h"
+
+#include "PdfArray.h"
+#include "PdfCanvas.h"
+#include "PdfName.h"
+#include "PdfOutputStream.h"
+#include "PdfStream.h"
+#include "PdfString.h"
+#include "PdfTokenizer.h"
+#include "PdfVariant.h"
+#include "PdfVecObjects.h"
+#include "PdfDefinesPrivate.h"
+
+#include <string.h>
+
+namespace PoDoFo {
+
+/** Names of all operators in the order of EPdfContentsOperator
+ */
+static const char* const s_ppszOperators[] = {
+    "b", "B", "b*", "B*", "BDC", "BI", "BMC", "BT", "BX", "c",
+    "cm", "CS", "cs", "d", "d0", "d1", "Do", "DP", "EI", "EMC",
+    "ET", "EX", "f", "F", "f*", "G", "g", "gs", "h", "i",
+    "ID", "j", "J", "K", "k", "l", "m", "M", "MP", "n",
+    "q", "Q", "re", "RG", "rg", "ri", "s", "S", "SC", "sc",
+    "SCN", "scn", "sh", "T*", "Tc", "Td", "TD", "Tf", "Tj", "TJ",
+    "TL", "Tm", "Tr", "Ts", "Tw", "Tz", "v", "w", "W", "W*",
+    "y", "'", "\"",
+};
+
+/** Perfect hash of all operators: the up to three characters of an
+ *  operator are multiplied by s_nOperatorHashKey and the high byte
+ *  of the result is the index into this table. The operator is then
+ *  compared with s_ppszOperators to reject unknown keywords.
+ */
+static const pdf_uint32 s_nOperatorHashKey = 0x1EDB0E3B;
+
+static const unsigned char s_aOperatorHash[256] = {
+    73, 47, 73, 73, 35, 73, 73, 73, 73, 73, 33, 73, 73, 13, 73, 73,
+    53, 73, 73, 73, 73, 73, 73, 73, 11, 72, 73, 73, 73, 73, 73, 73,
+    14, 73, 73, 36, 73, 73, 73, 73, 60, 73, 42, 73, 73, 16, 73, 73,
+    73, 20, 73, 10, 73, 73, 73, 73, 66, 73, 73, 24, 73, 73, 73, 73,
+    73,  8, 39, 73, 73, 73, 73, 37, 73, 73, 73, 22, 73, 73, 73, 56,
+    73, 73, 73, 73, 73, 48, 12, 67, 73, 73, 73, 73, 73, 73, 73, 73,
+    73, 73, 73, 73, 61, 73, 73, 57, 73, 73, 26,  5, 69, 73, 73, 23,
+    73, 59, 73, 73, 73, 73, 73, 73, 73, 73, 73, 73, 68, 73, 73, 73,
+    73, 73, 73, 73, 65, 73, 73, 63, 28, 73, 73, 73, 73, 73, 25, 73,
+    73,  6, 49, 73, 73, 70, 45, 73, 73, 73, 73, 73, 73, 21, 40, 73,
+    73, 73, 73, 43, 73, 73, 17, 29, 73, 73, 73, 50, 62, 73, 73, 73,
+    51, 55, 73, 71, 73, 73, 73, 73, 73, 73, 73, 73, 38, 73, 73, 73,
+     2, 73, 73, 41, 73, 73, 31, 73, 18, 73, 73, 73, 73, 73, 73,  0,
+    73, 27, 73, 58, 73,  7, 54, 73, 73, 73, 52, 73, 46,  4, 73, 73,
+    44, 73, 73, 73,  3, 34, 73, 73, 73, 73, 73, 32, 73, 19,  9, 73,
+    73, 73, 73, 64,  1, 73, 73, 73, 73, 73, 73, 15, 30, 73, 73, 73
+};
+
+/** Powers of ten to scale the mantissa of real numbers
+ */
+static const double s_adPowersOf10[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,
+    1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18
+};
+
+/** Maximum number of significant digits read into the mantissa of a number
+ */
+static const int s_nMaxDigits = 18;
+
+static inline const char* SkipWhitespaceAndComments( const char* pCur, const char* pEnd )
+{
+    while( pCur < pEnd )
+    {
+        if( PdfTokenizer::IsWhitespace( *pCur ) )
+            ++pCur;
+        else if( *pCur == '%' )
+        {
+            while( pCur < pEnd && *pCur != '\r' && *pCur != '\n' )
+                ++pCur;
+        }
+        else
+            break;
+    }
+
+    return pCur;
+}
+
+/** \param pCur the position after the opening parenthesis
+ *  \returns the position of the closing parenthesis or pEnd
+ */
+static const char* SkipString( const char* pCur, const char* pEnd )
+{
+    int nDepth = 1;
+
+    while( pCur < pEnd )
+    {
+        switch( *pCur )
+        {
+            case '\\':
+                // Skip the escaped character
+                if( ++pCur == pEnd )
+                    return pEnd;
+                break;
+            case '(':
+                ++nDepth;
+                break;
+            case ')':
+                if( --nDepth == 0 )
+                    return pCur;
+                break;
+            default:
+                break;
+        }
+
+        ++pCur;
+    }
+
+    return pEnd;
+}
+
+static inline int GetHexDigit( char c )
+{
+    if( c >= '0' && c <= '9' )
+        return c - '0';
+    else if( c >= 'a' && c <= 'f' )
+        return c - 'a' + 10;
+    else if( c >= 'A' && c <= 'F' )
+        return c - 'A' + 10;
+
+    return -1;
+}
+
+/** Parse an integer or real number as written in PDF files,
+ *  i.e. without exponent and independent of the locale.
+ *
+ *  \returns false if the token is not a number
+ */
+static bool ParseNumber( const char* pCur, const char* pEnd, pdf_int64 & rnNumber, double & rdReal, bool & rbReal )
+{
+    bool      bNegative = false;
+    bool      bPoint    = false;
+    bool      bDigits   = false;
+    pdf_int64 nMantissa = 0;
+    int       nDigits   = 0;
+    int       nFraction = 0;
+    int       nScale    = 0;  // integer digits which did not fit into the mantissa
+
+    if( *pCur == '-' || *pCur == '+' )
+    {
+        bNegative = (*pCur == '-');
+        ++pCur;
+    }
+
+    for( ; pCur < pEnd; ++pCur )
+    {
+        const char c = *pCur;
+        if( c >= '0' && c <= '9' )
+        {
+            bDigits = true;
+            if( !nMantissa && c == '0' && !bPoint )
+                continue; // leading zeros
+
+            if( nDigits < s_nMaxDigits )
+            {
+                nMantissa = nMantissa * 10 + (c - '0');
+                ++nDigits;
+                if( bPoint )
+                    ++nFraction;
+            }
+            else if( !bPoint )
+                ++nScale;
+        }
+        else if( c == '.' && !bPoint )
+            bPoint = true;
+        else
+            return false;
+    }
+
+    if( !bDigits )
+        return false;
+
+    double dValue = static_cast<double>(nMantissa);
+    if( nScale )
+    {
+        while( nScale-- )
+            dValue *= 10.0;
+
+        // Too large for an integer
+        bPoint = true;
+    }
+    else if( nFraction )
+        dValue /= s_adPowersOf10[nFraction];
+
+    rbReal   = bPoint;
+    rnNumber = bNegative ? -nMantissa : nMantissa;
+    rdReal   = bNegative ? -dValue : dValue;
+    return true;
+}
+
+// -----------------------------------------------------
+// PdfContentsOperand
+// -----------------------------------------------------
+
+bool PdfContentsOperand::IsName( const char* pszName ) const
+{
+    if( m_eType != ePdfContentsOperandType_Name )
+        return false;
+
+    const char* pCur = m_pData;
+    const char* pEnd = m_pData + m_lLen;
+    while( pCur < pEnd )
+    {
+        char c = *pCur++;
+        if( c == '#' && pEnd - pCur >= 2 && GetHexDigit( pCur[0] ) >= 0 && GetHexDigit( pCur[1] ) >= 0 )
+        {
+            c = static_cast<char>((GetHexDigit( pCur[0] ) << 4) | GetHexDigit( pCur[1] ));
+            pCur += 2;
+        }
+
+        if( *pszName++ != c )
+            return false;
+    }
+
+    return *pszName == '\0';
+}
+
+pdf_long PdfContentsOperand::DecodeString( char* pBuffer ) const
+{
+    const char* pCur = m_pData;
+    const char* pEnd = m_pData + m_lLen;
+    char*       pOut = pBuffer;
+
+    if( m_eType == ePdfContentsOperandType_HexString )
+    {
+        bool bHigh = true;
+        for( ; pCur < pEnd; ++pCur )
+        {
+            int nDigit = GetHexDigit( *pCur );
+            if( nDigit < 0 )
+                continue; // whitespace
+
+            if( bHigh )
+                *pOut = static_cast<char>(nDigit << 4);
+            else
+                *pOut++ |= static_cast<char>(nDigit);
+
+            bHigh = !bHigh;
+        }
+
+        // An odd number of digits is completed by a zero
+        if( !bHigh )
+            ++pOut;
+
+        return pOut - pBuffer;
+    }
+    else if( m_eType != ePdfContentsOperandType_String )
+    {
+        PODOFO_RAISE_ERROR( ePdfError_InvalidDataType );
+    }
+
+    while( pCur < pEnd )
+    {
+        char c = *pCur++;
+        if( c != '\\' || pCur == pEnd )
+        {
+            *pOut++ = c;
+            continue;
+        }
+
+        c = *pCur++;
+        switch( c )
+        {
+            case 'n': *pOut++ = '\n'; break;
+            case 'r': *pOut++ = '\r'; break;
+            case 't': *pOut++ = '\t'; break;
+            case 'b': *pOut++ = '\b'; break;
+            case 'f': *pOut++ = '\f'; break;
+            case '\r':
+                // A backslash at the end of a line continues the string
+                if( pCur < pEnd && *pCur == '\n' )
+                    ++pCur;
+                break;
+            case '\n':
+                break;
+            default:
+                if( c >= '0' && c <= '7' )
+                {
+                    int nValue = c - '0';
+                    for( int i = 0; i < 2 && pCur < pEnd && *pCur >= '0' && *pCur <= '7'; i++ )
+                        nValue = (nValue << 3) | (*pCur++ - '0');
+
+                    *pOut++ = static_cast<char>(nValue);
+                }
+                else
+                    // \( \) \\ and unknown escapes, which are ignored
+                    *pOut++ = c;
+                break;
+        }
+    }
+
+    return pOut - pBuffer;
+}
+
+bool PdfContentsOperand::GetNextElement( pdf_long & rlPos, PdfContentsOperand & rElement ) const
+{
+    if( m_eType != ePdfContentsOperandType_Array && m_eType != ePdfContentsOperandType_Dictionary )
+    {
+        PODOFO_RAISE_ERROR( ePdfError_InvalidDataType );
+    }
+
+    // Skip the opening delimiter
+    const char* pEnd = m_pData + m_lLen;
+    const char* pCur = m_pData + PDF_MAX( rlPos, static_cast<pdf_long>(m_eType == ePdfContentsOperandType_Array ? 1 : 2) );
+    bool        bKeyword;
+
+    pCur = SkipWhitespaceAndComments( pCur, pEnd );
+    if( pCur >= pEnd || *pCur == ']' || *pCur == '>' )
+    {
+        rlPos = m_lLen;
+        return false;
+    }
+
+    pCur = PdfContentsParser::ReadToken( pCur, pEnd, rElement, bKeyword );
+    if( !pCur )
+    {
+        rlPos = m_lLen;
+        return false;
+    }
+
+    if( bKeyword )
+        // Keywords like R are invalid in content streams, return them as names
+        rElement.m_eType = ePdfContentsOperandType_Name;
+
+    rlPos = pCur - m_pData;
+    return true;
+}
+
+PdfName PdfContentsOperand::ToName() const
+{
+    if( m_eType != ePdfContentsOperandType_Name )
+    {
+        PODOFO_RAISE_ERROR( ePdfError_InvalidDataType );
+    }
+
+    return m_lLen ? PdfName::FromEscaped( m_pData, m_lLen ) : PdfName();
+}
+
+PdfString PdfContentsOperand::ToString() const
+{
+    if( m_eType == ePdfContentsOperandType_HexString )
+    {
+        PdfString string;
+        string.SetHexData( m_pData, m_lLen );
+        return string;
+    }
+    else if( m_eType != ePdfContentsOperandType_String )
+    {
+        PODOFO_RAISE_ERROR( ePdfError_InvalidDataType );
+    }
+
+    if( !m_lLen )
+        return PdfString( "" );
+
+    PdfRefCountedBuffer buffer( m_lLen );
+    pdf_long            lLen = this->DecodeString( buffer.GetBuffer() );
+    return PdfString( buffer.GetBuffer(), lLen );
+}
+
+void PdfContentsOperand::ToVariant( PdfVariant & rVariant ) const
+{
+    switch( m_eType )
+    {
+        case ePdfContentsOperandType_Null:
+            rVariant = PdfVariant();
+            break;
+        case ePdfContentsOperandType_Bool:
+            rVariant = PdfVariant( m_nNumber != 0 );
+            break;
+        case ePdfContentsOperandType_Number:
+            rVariant = PdfVariant( m_nNumber );
+            break;
+        case ePdfContentsOperandType_Real:
+            rVariant = PdfVariant( m_dReal );
+            break;
+        case ePdfContentsOperandType_Name:
+            rVariant = this->ToName();
+            break;
+        case ePdfContentsOperandType_String:
+        case ePdfContentsOperandType_HexString:
+            rVariant = this->ToString();
+            break;
+        case ePdfContentsOperandType_Array:
+        case ePdfContentsOperandType_Dictionary:
+        default:
+        {
+            PdfTokenizer tokenizer( m_pData, m_lLen );
+            tokenizer.GetNextVariant( rVariant, NULL );
+            break;
+        }
+    }
+}
+
+// -----------------------------------------------------
+// PdfContentsHandler
+// -----------------------------------------------------
+
+PdfContentsHandler::~PdfContentsHandler()
+{
+}
+
+void PdfContentsHandler::HandleUnknownOperator( const char*, pdf_long, const PdfContentsOperand*, int )
+{
+}
+
+void PdfContentsHandler::HandleInlineImage( const PdfContentsOperand*, int, const char*, pdf_long )
+{
+}
+
+// -----------------------------------------------------
+// PdfContentsParser
+// -----------------------------------------------------
+
+const int PdfContentsParser::MAX_OPERANDS;
+
+PdfContentsParser::PdfContentsParser( const char* pBuffer, pdf_long lLen )
+    : m_pBuffer( pBuffer ), m_lLen( lLen ), m_nOperands( 0 )
+{
+}
+
+PdfContentsParser::PdfContentsParser( PdfCanvas* pCanvas )
+    : m_pBuffer( NULL ), m_lLen( 0 ), m_nOperands( 0 )
+{
+    if( !pCanvas )
+    {
+        PODOFO_RAISE_ERROR( ePdfError_InvalidHandle );
+    }
+
+    // Collect the content streams like PdfContentsTokenizer does
+    std::vector<PdfObject*> vecContents;
+    PdfObject*              pContents = pCanvas->GetContents();
+    if( pContents && pContents->IsArray()  )
+    {
+        PdfArray& a = pContents->GetArray();
+        for ( PdfArray::iterator it = a.begin(); it != a.end() ; ++it )
+        {
+            if ( !(*it).IsReference() )
+            {
+                PODOFO_RAISE_ERROR_INFO( ePdfError_InvalidDataType, "/Contents array contained non-references" );
+            }
+
+            PdfObject* pObject = pContents->GetOwner()->GetObject( (*it).GetReference() );
+            if( pObject && pObject->HasStream() )
+                vecContents.push_back( pObject );
+        }
+    }
+    else if ( pContents && pContents->HasStream() )
+    {
+        vecContents.push_back( pContents );
+    }
+    else if ( !pContents || !pContents->IsDictionary() )
+    {
+        PODOFO_RAISE_ERROR_INFO( ePdfError_InvalidDataType, "Page /Contents not stream or array of streams" );
+    }
+
+    // Decode all streams into one buffer, separated by whitespace, as
+    // the division between streams may only occur between tokens.
+    // Operands of an operator may therefore be spread over two streams.
+    PdfBufferOutputStream stream( &m_buffer );
+    for( size_t i = 0; i < vecContents.size(); i++ )
+    {
+        if( i )
+            stream.Write( "\n", 1 );
+
+        vecContents[i]->GetStream()->GetFilteredCopy( &stream );
+    }
+    stream.Close();
+
+    m_pBuffer = m_buffer.GetBuffer();
+    m_lLen    = stream.GetLength();
+}
+
+PdfContentsParser::~PdfContentsParser()
+{
+}
+
+void PdfContentsParser::Parse( PdfContentsHandler & rHandler )
+{
+    const char*        pCur = m_pBuffer;
+    const char*        pEnd = m_pBuffer + m_lLen;
+    PdfContentsOperand token;
+    bool               bKeyword;
+
+    m_nOperands = 0;
+    if( !pCur )
+        return;
+
+    while( (pCur = ReadToken( pCur, pEnd, token, bKeyword )) )
+    {
+        if( !bKeyword )
+        {
+            PushOperand( token );
+            continue;
+        }
+
+        // Only the operators of inline images need special treatment, 
+        // a switch would have to list all other operators.
+        EPdfContentsOperator eOperator = FindOperator( token.m_pData, token.m_lLen );
+        if( eOperator == ePdfContentsOperator_BI )
+        {
+            // The image dictionary follows
+            m_nOperands = 0;
+        }
+        else if( eOperator == ePdfContentsOperator_ID )
+        {
+            pdf_long lLen;
+
+            pCur = ReadInlineImage( pCur, pEnd, lLen );
+            if( pCur == pEnd )
+                // No EI found, PdfContentsTokenizer stops in this case, too
+                return;
+
+            rHandler.HandleInlineImage( m_aOperands, m_nOperands, pCur - lLen, lLen );
+            m_nOperands = 0;
+
+            // Skip EI
+            pCur += 2;
+        }
+        else if( eOperator == ePdfContentsOperator_Unknown )
+        {
+            rHandler.HandleUnknownOperator( token.m_pData, token.m_lLen, m_aOperands, m_nOperands );
+            m_nOperands = 0;
+        }
+        else
+        {
+            rHandler.HandleOperator( eOperator, m_aOperands, m_nOperands );
+            m_nOperands = 0;
+        }
+    }
+}
+
+EPdfContentsOperator PdfContentsParser::FindOperator( const char* pszOperator, pdf_long lLen )
+{
+    if( lLen < 1 || lLen > 3 )
+        return ePdfContentsOperator_Unknown;
+
+    pdf_uint32 nKey = static_cast<unsigned char>(pszOperator[0]);
+    if( lLen > 1 )
+        nKey |= static_cast<pdf_uint32>(static_cast<unsigned char>(pszOperator[1])) << 8;
+    if( lLen > 2 )
+        nKey |= static_cast<pdf_uint32>(static_cast<unsigned char>(pszOperator[2])) << 16;
+
+    int nOperator = s_aOperatorHash[(static_cast<pdf_uint32>(nKey * s_nOperatorHashKey) >> 24) & 0xff];
+    if( nOperator == ePdfContentsOperator_Unknown )
+        return ePdfContentsOperator_Unknown;
+
+    const char* pszName = s_ppszOperators[nOperator];
+    if( strncmp( pszName, pszOperator, lLen ) != 0 || pszName[lLen] != '\0' )
+        return ePdfContentsOperator_Unknown;
+
+    return static_cast<EPdfContentsOperator>(nOperator);
+}
+
+const char* PdfContentsParser::GetOperatorName( EPdfContentsOperator eOperator )
+{
+    if( eOperator < ePdfContentsOperator_b || eOperator >= ePdfContentsOperator_Unknown )
+        return NULL;
+
+    return s_ppszOperators[eOperator];
+}
+
+const char* PdfContentsParser::ReadToken( const char* pCur, const char* pEnd,
+                                          PdfContentsOperand & rOperand, bool & rbKeyword )
+{
+    pCur = SkipWhitespaceAndComments( pCur, pEnd );
+    if( pCur >= pEnd )
+        return NULL;
+
+    const char* pStart = pCur;
+    rbKeyword = false;
+
+    switch( *pCur )
+    {
+        case '/':
+            ++pCur;
+            while( pCur < pEnd && PdfTokenizer::IsRegular( *pCur ) )
+                ++pCur;
+
+            rOperand.m_eType = ePdfContentsOperandType_Name;
+            rOperand.m_pData = pStart + 1;
+            rOperand.m_lLen  = pCur - pStart - 1;
+            return pCur;
+
+        case '(':
+            pCur = SkipString( pCur + 1, pEnd );
+
+            rOperand.m_eType = ePdfContentsOperandType_String;
+            rOperand.m_pData = pStart + 1;
+            rOperand.m_lLen  = pCur - pStart - 1;
+            return pCur < pEnd ? pCur + 1 : pEnd;
+
+        case '<':
+            if( pCur + 1 < pEnd && pCur[1] == '<' )
+            {
+                pCur = SkipContainer( pCur + 2, pEnd );
+
+                rOperand.m_eType = ePdfContentsOperandType_Dictionary;
+                rOperand.m_pData = pStart;
+                rOperand.m_lLen  = pCur - pStart;
+                return pCur;
+            }
+
+            ++pCur;
+            while( pCur < pEnd && *pCur != '>' )
+                ++pCur;
+
+            rOperand.m_eType = ePdfContentsOperandType_HexString;
+            rOperand.m_pData = pStart + 1;
+            rOperand.m_lLen  = pCur - pStart - 1;
+            return pCur < pEnd ? pCur + 1 : pEnd;
+
+        case '[':
+            pCur = SkipContainer( pCur + 1, pEnd );
+
+            rOperand.m_eType = ePdfContentsOperandType_Array;
+            rOperand.m_pData = pStart;
+            rOperand.m_lLen  = pCur - pStart;
+            return pCur;
+
+        case ']':
+        case '>':
+        case ')':
+        case '{':
+        case '}':
+            // Stray delimiters are returned as unknown keywords
+            rbKeyword        = true;
+            rOperand.m_pData = pStart;
+            rOperand.m_lLen  = 1;
+            return pCur + 1;
+
+        default:
+            break;
+    }
+
+    while( pCur < pEnd && PdfTokenizer::IsRegular( *pCur ) )
+        ++pCur;
+
+    const pdf_long lLen = pCur - pStart;
+    const char     c    = *pStart;
+    bool           bReal;
+
+    rOperand.m_pData = pStart;
+    rOperand.m_lLen  = lLen;
+
+    if( ((c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.')
+        && ParseNumber( pStart, pCur, rOperand.m_nNumber, rOperand.m_dReal, bReal ) )
+    {
+        rOperand.m_eType = bReal ? ePdfContentsOperandType_Real : ePdfContentsOperandType_Number;
+    }
+    else if( lLen == 4 && strncmp( pStart, "true", 4 ) == 0 )
+    {
+        rOperand.m_eType   = ePdfContentsOperandType_Bool;
+        rOperand.m_nNumber = 1;
+    }
+    else if( lLen == 5 && strncmp( pStart, "false", 5 ) == 0 )
+    {
+        rOperand.m_eType   = ePdfContentsOperandType_Bool;
+        rOperand.m_nNumber = 0;
+    }
+    else if( lLen == 4 && strncmp( pStart, "null", 4 ) == 0 )
+        rOperand.m_eType = ePdfContentsOperandType_Null;
+    else
+        rbKeyword = true;
+
+    return pCur;
+}
+
+const char* PdfContentsParser::SkipContainer( const char* pCur, const char* pEnd )
+{
+    // Arrays and dictionaries are skipped without recursion,
+    // so that deeply nested containers cannot overflow the stack.
+    // Mismatched delimiters are tolerated.
+    int nDepth = 1;
+
+    while( pCur < pEnd )
+    {
+        switch( *pCur )
+        {
+            case '%':
+                pCur = SkipWhitespaceAndComments( pCur, pEnd );
+                break;
+
+            case '(':
+                pCur = SkipString( pCur + 1, pEnd );
+                if( pCur < pEnd )
+                    ++pCur;
+                break;
+
+            case '[':
+                ++nDepth;
+                ++pCur;
+                break;
+
+            case '<':
+                if( pCur + 1 < pEnd && pCur[1] == '<' )
+                {
+                    ++nDepth;
+                    pCur += 2;
+                }
+                else
+                {
+                    // Hex string
+                    while( pCur < pEnd && *pCur != '>' )
+                        ++pCur;
+                    if( pCur < pEnd )
+                        ++pCur;
+                }
+                break;
+
+            case ']':
+            case '>':
+                if( *pCur == '>' && pCur + 1 < pEnd && pCur[1] == '>' )
+                    ++pCur;
+
+                ++pCur;
+                if( --nDepth == 0 )
+                    return pCur;
+                break;
+
+            default:
+                ++pCur;
+                break;
+        }
+    }
+
+    return pEnd;
+}
+
+const char* PdfContentsParser::ReadInlineImage( const char* pCur, const char* pEnd, pdf_long & rlLen )
+{
+    // Consume the only whitespace between ID and data
+    if( pCur < pEnd && PdfTokenizer::IsWhitespace( *pCur ) )
+        ++pCur;
+
+    // The data ends at the first EI followed by whitespace or the end of the data
+    const char* pStart = pCur;
+    while( pCur < pEnd )
+    {
+        const char* pE = static_cast<const char*>(memchr( pCur, 'E', pEnd - pCur ));
+        if( !pE || pE + 1 >= pEnd )
+            break;
+
+        if( pE[1] == 'I' && (pE + 2 == pEnd || PdfTokenizer::IsWhitespace( pE[2] )) )
+        {
+            rlLen = pE - pStart;
+            return pE;
+        }
+
+        pCur = pE + 1;
+    }
+
+    rlLen = pEnd - pStart;
+    return pEnd;
+}
+
+inline void PdfContentsParser::PushOperand( const PdfContentsOperand & rOperand )
+{
+    if( m_nOperands == MAX_OPERANDS )
+    {
+        // Invalid content stream, keep the topmost operands
+        memmove( m_aOperands, m_aOperands + 1, sizeof(PdfContentsOperand) * (MAX_OPERANDS - 1) );
+        --m_nOperands;
+    }
+
+    m_aOperands[m_nOperands++] = rOperand;
+}
+
+};
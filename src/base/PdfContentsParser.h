@@ -0,0 +1,467 @@
+/***************************************************************************
+ *   Copyright (C) 2007 by Dominik Seichter                                *
+ *   domseichter@web.de                                                    *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Library General Public License as       *
+ *   published by the Free Software Foundation; either version 2 of the    *
+ *   License, or (at your option) any later version.                       *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this program; if not, write to the                 *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#ifndef _PDF_CONTENTS_PARSER_H_
+#define _PDF_CONTENTS_PARSER_H_
+
+#include "PdfDefines.h"
+#include "PdfRefCountedBuffer.h"
+
+namespace PoDoFo {
+
+class PdfCanvas;
+class PdfName;
+class PdfString;
+class PdfVariant;
+
+/** All operators which may appear in a content stream,
+ *  see PDF Reference 1.7, Appendix A.
+ */
+enum EPdfContentsOperator {
+    ePdfContentsOperator_b = 0,     /**< Close, fill, and stroke path using nonzero winding number rule */
+    ePdfContentsOperator_B,         /**< Fill and stroke path using nonzero winding number rule */
+    ePdfContentsOperator_bStar,     /**< b*: Close, fill, and stroke path using even-odd rule */
+    ePdfContentsOperator_BStar,     /**< B*: Fill and stroke path using even-odd rule */
+    ePdfContentsOperator_BDC,       /**< Begin marked-content sequence with property list */
+    ePdfContentsOperator_BI,        /**< Begin inline image object */
+    ePdfContentsOperator_BMC,       /**< Begin marked-content sequence */
+    ePdfContentsOperator_BT,        /**< Begin text object */
+    ePdfContentsOperator_BX,        /**< Begin compatibility section */
+    ePdfContentsOperator_c,         /**< Append curved segment to path (three control points) */
+    ePdfContentsOperator_cm,        /**< Concatenate matrix to current transformation matrix */
+    ePdfContentsOperator_CS,        /**< Set color space for stroking operations */
+    ePdfContentsOperator_cs,        /**< Set color space for nonstroking operations */
+    ePdfContentsOperator_d,         /**< Set line dash pattern */
+    ePdfContentsOperator_d0,        /**< Set glyph width in Type 3 font */
+    ePdfContentsOperator_d1,        /**< Set glyph width and bounding box in Type 3 font */
+    ePdfContentsOperator_Do,        /**< Invoke named XObject */
+    ePdfContentsOperator_DP,        /**< Define marked-content point with property list */
+    ePdfContentsOperator_EI,        /**< End inline image object */
+    ePdfContentsOperator_EMC,       /**< End marked-content sequence */
+    ePdfContentsOperator_ET,        /**< End text object */
+    ePdfContentsOperator_EX,        /**< End compatibility section */
+    ePdfContentsOperator_f,         /**< Fill path using nonzero winding number rule */
+    ePdfContentsOperator_F,         /**< Fill path using nonzero winding number rule (obsolete) */
+    ePdfContentsOperator_fStar,     /**< f*: Fill path using even-odd rule */
+    ePdfContentsOperator_G,         /**< Set gray level for stroking operations */
+    ePdfContentsOperator_g,         /**< Set gray level for nonstroking operations */
+    ePdfContentsOperator_gs,        /**< Set parameters from graphics state parameter dictionary */
+    ePdfContentsOperator_h,         /**< Close subpath */
+    ePdfContentsOperator_i,         /**< Set flatness tolerance */
+    ePdfContentsOperator_ID,        /**< Begin inline image data */
+    ePdfContentsOperator_j,         /**< Set line join style */
+    ePdfContentsOperator_J,         /**< Set line cap style */
+    ePdfContentsOperator_K,         /**< Set CMYK color for stroking operations */
+    ePdfContentsOperator_k,         /**< Set CMYK color for nonstroking operations */
+    ePdfContentsOperator_l,         /**< Append straight line segment to path */
+    ePdfContentsOperator_m,         /**< Begin new subpath */
+    ePdfContentsOperator_M,         /**< Set miter limit */
+    ePdfContentsOperator_MP,        /**< Define marked-content point */
+    ePdfContentsOperator_n,         /**< End path without filling or stroking */
+    ePdfContentsOperator_q,         /**< Save graphics state */
+    ePdfContentsOperator_Q,         /**< Restore graphics state */
+    ePdfContentsOperator_re,        /**< Append rectangle to path */
+    ePdfContentsOperator_RG,        /**< Set RGB color for stroking operations */
+    ePdfContentsOperator_rg,        /**< Set RGB color for nonstroking operations */
+    ePdfContentsOperator_ri,        /**< Set color rendering intent */
+    ePdfContentsOperator_s,         /**< Close and stroke path */
+    ePdfContentsOperator_S,         /**< Stroke path */
+    ePdfContentsOperator_SC,        /**< Set color for stroking operations */
+    ePdfContentsOperator_sc,        /**< Set color for nonstroking operations */
+    ePdfContentsOperator_SCN,       /**< Set color for stroking operations (ICCBased and special color spaces) */
+    ePdfContentsOperator_scn,       /**< Set color for nonstroking operations (ICCBased and special color spaces) */
+    ePdfContentsOperator_sh,        /**< Paint area defined by shading pattern */
+    ePdfContentsOperator_TStar,     /**< T*: Move to start of next text line */
+    ePdfContentsOperator_Tc,        /**< Set character spacing */
+    ePdfContentsOperator_Td,        /**< Move text position */
+    ePdfContentsOperator_TD,        /**< Move text position and set leading */
+    ePdfContentsOperator_Tf,        /**< Set text font and size */
+    ePdfContentsOperator_Tj,        /**< Show text */
+    ePdfContentsOperator_TJ,        /**< Show text, allowing individual glyph positioning */
+    ePdfContentsOperator_TL,        /**< Set text leading */
+    ePdfContentsOperator_Tm,        /**< Set text matrix and text line matrix */
+    ePdfContentsOperator_Tr,        /**< Set text rendering mode */
+    ePdfContentsOperator_Ts,        /**< Set text rise */
+    ePdfContentsOperator_Tw,        /**< Set word spacing */
+    ePdfContentsOperator_Tz,        /**< Set horizontal text scaling */
+    ePdfContentsOperator_v,         /**< Append curved segment to path (initial point replicated) */
+    ePdfContentsOperator_w,         /**< Set line width */
+    ePdfContentsOperator_W,         /**< Set clipping path using nonzero winding number rule */
+    ePdfContentsOperator_WStar,     /**< W*: Set clipping path using even-odd rule */
+    ePdfContentsOperator_y,         /**< Append curved segment to path (final point replicated) */
+    ePdfContentsOperator_Quote,     /**< ': Move to next line and show text */
+    ePdfContentsOperator_DoubleQuote, /**< ": Set word and character spacing, move to next line, and show text */
+
+    ePdfContentsOperator_Unknown    /**< Not an operator defined by the PDF Reference */
+};
+
+/** The type of an operand read by PdfContentsParser
+ */
+enum EPdfContentsOperandType {
+    ePdfContentsOperandType_Null,
+    ePdfContentsOperandType_Bool,
+    ePdfContentsOperandType_Number,     /**< An integer number */
+    ePdfContentsOperandType_Real,       /**< A real number */
+    ePdfContentsOperandType_Name,
+    ePdfContentsOperandType_String,     /**< A literal string */
+    ePdfContentsOperandType_HexString,
+    ePdfContentsOperandType_Array,
+    ePdfContentsOperandType_Dictionary
+};
+
+/** An operand of a content stream operator as read by PdfContentsParser.
+ *
+ *  Numbers and booleans are already converted. All other operands
+ *  are views into the decoded content stream, which are only valid
+ *  until the handler method they were passed to returns:
+ *
+ *  - names without the leading slash and with #xx escapes intact
+ *  - literal strings without the parentheses and with escapes intact
+ *  - hex strings without the angle brackets
+ *  - arrays and dictionaries including their delimiters,
+ *    use GetNextElement() to walk their elements
+ *
+ *  Nothing is copied or allocated unless one of the To...()
+ *  conversion methods is called.
+ */
+class PODOFO_API PdfContentsOperand {
+    friend class PdfContentsParser;
+
+ public:
+    PdfContentsOperand()
+        : m_eType( ePdfContentsOperandType_Null ), m_pData( NULL ), m_lLen( 0 ), m_nNumber( 0 ), m_dReal( 0.0 )
+    {
+    }
+
+    /** \returns the type of this operand
+     */
+    inline EPdfContentsOperandType GetType() const;
+
+    /** \returns true if this operand is an integer or a real number
+     */
+    inline bool IsNumber() const;
+
+    /** \returns the value of an integer or real number operand.
+     *           Raises ePdfError_InvalidDataType for other types.
+     */
+    inline double GetReal() const;
+
+    /** \returns the value of an integer or real number operand,
+     *           reals are truncated. Raises ePdfError_InvalidDataType
+     *           for other types.
+     */
+    inline pdf_int64 GetNumber() const;
+
+    /** \returns the value of a boolean operand.
+     *           Raises ePdfError_InvalidDataType for other types.
+     */
+    inline bool GetBool() const;
+
+    /** \returns a pointer to the text of this operand in the content stream,
+     *           the data is not terminated by a zero byte
+     */
+    inline const char* GetData() const;
+
+    /** \returns the length of GetData() in bytes
+     */
+    inline pdf_long GetLength() const;
+
+    /** Compare a name operand with a name without creating a PdfName.
+     *
+     *  \param pszName an unescaped name without the leading slash
+     *  \returns true if this operand is a name equal to pszName
+     */
+    bool IsName( const char* pszName ) const;
+
+    /** Decode a literal or hex string operand into a buffer.
+     *
+     *  \param pBuffer the decoded bytes are written to this buffer,
+     *                 which has to be at least GetLength() bytes large.
+     *  \returns the number of decoded bytes
+     */
+    pdf_long DecodeString( char* pBuffer ) const;
+
+    /** Read the next element of an array or dictionary operand.
+     *  The element is again a view into the content stream.
+     *
+     *  \param rlPos the position inside the array or dictionary,
+     *               start with 0. It is advanced to the next element.
+     *  \param rElement the element is stored here.
+     *               Dictionaries yield keys and values alternately.
+     *  \returns false if there are no more elements
+     */
+    bool GetNextElement( pdf_long & rlPos, PdfContentsOperand & rElement ) const;
+
+    /** \returns the name of a name operand as PdfName
+     */
+    PdfName ToName() const;
+
+    /** \returns the string of a literal or hex string operand as PdfString
+     */
+    PdfString ToString() const;
+
+    /** Convert this operand into a PdfVariant.
+     *  Arrays and dictionaries are parsed completely.
+     *
+     *  \param rVariant the operand is stored here
+     */
+    void ToVariant( PdfVariant & rVariant ) const;
+
+ private:
+    EPdfContentsOperandType m_eType;
+    const char*             m_pData;
+    pdf_long                m_lLen;
+    pdf_int64               m_nNumber;   ///< Value of integers and booleans
+    double                  m_dReal;     ///< Value of integers and reals
+};
+
+/** An interface for the events generated by PdfContentsParser.
+ *
+ *  All operands passed to the handler are only valid until
+ *  the handler method returns.
+ */
+class PODOFO_API PdfContentsHandler {
+ public:
+    virtual ~PdfContentsHandler();
+
+    /** Called for every operator defined by the PDF Reference
+     *  except for inline images, see HandleInlineImage().
+     *
+     *  \param eOperator the operator
+     *  \param pOperands the operands of the operator in the order they
+     *                   appeared in the content stream
+     *  \param nOperands the number of operands, which is not checked
+     *                   against the number of operands the operator expects
+     */
+    virtual void HandleOperator( EPdfContentsOperator eOperator,
+                                 const PdfContentsOperand* pOperands, int nOperands ) = 0;
+
+    /** Called for every other keyword in the content stream,
+     *  e.g. inside of BX/EX compatibility sections.
+     *  The default implementation ignores the operator.
+     *
+     *  \param pszOperator the keyword, not terminated by a zero byte
+     *  \param lLen the length of pszOperator
+     *  \param pOperands the operands of the operator
+     *  \param nOperands the number of operands
+     */
+    virtual void HandleUnknownOperator( const char* pszOperator, pdf_long lLen,
+                                        const PdfContentsOperand* pOperands, int nOperands );
+
+    /** Called for every inline image (BI ... ID ... EI).
+     *  The BI, ID and EI operators are not passed to HandleOperator().
+     *  The default implementation ignores the image.
+     *
+     *  \param pOperands the keys and values of the image dictionary, alternately
+     *  \param nOperands the number of operands
+     *  \param pData the image data between ID and EI, which is not decoded.
+     *               The single whitespace character after ID is not part
+     *               of the data, as in PdfContentsTokenizer.
+     *  \param lLen the length of pData
+     */
+    virtual void HandleInlineImage( const PdfContentsOperand* pOperands, int nOperands,
+                                    const char* pData, pdf_long lLen );
+};
+
+/** An event driven parser for content streams.
+ *
+ *  Compared to PdfContentsTokenizer, the parser does not create
+ *  a PdfVariant for each operand. Operands are collected on a fixed size
+ *  stack of PdfContentsOperand, which point into the decoded content stream,
+ *  and each operator is passed together with its operands to a
+ *  PdfContentsHandler. Operators are identified using a perfect hash,
+ *  so that handlers can switch on an EPdfContentsOperator instead of
+ *  comparing strings. Except for decoding the content streams
+ *  no memory is allocated while parsing.
+ *
+ *  \see PdfContentsTokenizer
+ */
+class PODOFO_API PdfContentsParser {
+    friend class PdfContentsOperand;
+
+ public:
+    /** Maximum number of operands of a single operator. If an operator
+     *  has more operands, the oldest operands are dropped.
+     */
+    static const int MAX_OPERANDS = 128;
+
+    /** Construct a PdfContentsParser for a decoded content stream.
+     *
+     *  \param pBuffer the content stream, which has to be valid
+     *                 until parsing is done
+     *  \param lLen length of the buffer
+     */
+    PdfContentsParser( const char* pBuffer, pdf_long lLen );
+
+    /** Construct a PdfContentsParser for all content streams
+     *  of a PdfCanvas (i.e. PdfPage or a PdfXObject).
+     *
+     *  The content streams are decoded into a single buffer
+     *  in the constructor.
+     *
+     *  \param pCanvas an object that hold a PDF contents stream
+     */
+    PdfContentsParser( PdfCanvas* pCanvas );
+
+    ~PdfContentsParser();
+
+    /** Parse the content stream and pass all operators
+     *  to a handler. Exceptions thrown by the handler
+     *  stop parsing.
+     *
+     *  \param rHandler the handler for all operators
+     */
+    void Parse( PdfContentsHandler & rHandler );
+
+    /** Find an operator by its name.
+     *
+     *  \param pszOperator name of the operator, does not need to be terminated by a zero byte
+     *  \param lLen length of pszOperator
+     *  \returns the operator or ePdfContentsOperator_Unknown
+     */
+    static EPdfContentsOperator FindOperator( const char* pszOperator, pdf_long lLen );
+
+    /** \param eOperator an operator
+     *  \returns the name of the operator as it is written in content streams
+     *           or NULL for ePdfContentsOperator_Unknown
+     */
+    static const char* GetOperatorName( EPdfContentsOperator eOperator );
+
+ private:
+    /** Read the next operand or keyword.
+     *
+     *  \param pCur the current position
+     *  \param pEnd the end of the buffer
+     *  \param rOperand the operand or the keyword is stored here
+     *  \param rbKeyword set to true if a keyword was read
+     *  \returns the position after the token or NULL if
+     *           there is no token left
+     */
+    static const char* ReadToken( const char* pCur, const char* pEnd,
+                                  PdfContentsOperand & rOperand, bool & rbKeyword );
+
+    /** Skip over an array or dictionary including all nested
+     *  arrays and dictionaries.
+     *
+     *  \param pCur the position after the opening delimiter
+     *  \param pEnd the end of the buffer
+     *  \returns the position after the closing delimiter
+     */
+    static const char* SkipContainer( const char* pCur, const char* pEnd );
+
+    /** Read the data of an inline image like PdfContentsTokenizer does.
+     *
+     *  \param pCur the position after the ID keyword
+     *  \param pEnd the end of the buffer
+     *  \param rlLen the length of the image data is stored here
+     *  \returns the position of the EI keyword or pEnd
+     */
+    static const char* ReadInlineImage( const char* pCur, const char* pEnd, pdf_long & rlLen );
+
+    /** Push an operand onto the stack, dropping the oldest
+     *  operand if the stack is full.
+     */
+    inline void PushOperand( const PdfContentsOperand & rOperand );
+
+ private:
+    const char*         m_pBuffer;
+    pdf_long            m_lLen;
+    PdfRefCountedBuffer m_buffer;       ///< Decoded content streams of a PdfCanvas
+
+    PdfContentsOperand  m_aOperands[MAX_OPERANDS];
+    int                 m_nOperands;
+};
+
+// -----------------------------------------------------
+//
+// -----------------------------------------------------
+inline EPdfContentsOperandType PdfContentsOperand::GetType() const
+{
+    return m_eType;
+}
+
+// -----------------------------------------------------
+//
+// -----------------------------------------------------
+inline bool PdfContentsOperand::IsNumber() const
+{
+    return m_eType == ePdfContentsOperandType_Number || m_eType == ePdfContentsOperandType_Real;
+}
+
+// -----------------------------------------------------
+//
+// -----------------------------------------------------
+inline double PdfContentsOperand::GetReal() const
+{
+    if( !IsNumber() )
+    {
+        PODOFO_RAISE_ERROR( ePdfError_InvalidDataType );
+    }
+
+    return m_dReal;
+}
+
+// -----------------------------------------------------
+//
+// -----------------------------------------------------
+inline pdf_int64 PdfContentsOperand::GetNumber() const
+{
+    if( m_eType == ePdfContentsOperandType_Real )
+        return static_cast<pdf_int64>(m_dReal);
+    else if( m_eType != ePdfContentsOperandType_Number )
+    {
+        PODOFO_RAISE_ERROR( ePdfError_InvalidDataType );
+    }
+
+    return m_nNumber;
+}
+
+// -----------------------------------------------------
+//
+// -----------------------------------------------------
+inline bool PdfContentsOperand::GetBool() const
+{
+    if( m_eType != ePdfContentsOperandType_Bool )
+    {
+        PODOFO_RAISE_ERROR( ePdfError_InvalidDataType );
+    }
+
+    return m_nNumber != 0;
+}
+
+// -----------------------------------------------------
+//
+// -----------------------------------------------------
+inline const char* PdfContentsOperand::GetData() const
+{
+    return m_pData;
+}
+
+// -----------------------------------------------------
+//
+// -----------------------------------------------------
+inline pdf_long PdfContentsOperand::GetLength() const
+{
+    return m_lLen;
+}
+
+};
+
+#endif // _PDF_CONTENTS_PARSER_H_
@@ -23,8 +23,76 @@
 #include "PdfOutputDevice.h"
 #include "PdfDefinesPrivate.h"
 
+#include <algorithm>
+
 namespace PoDoFo {
 
+namespace PdfDictionaryNameSpace {
+
+/** Compares the name of a key in a PdfKeyMap with another name
+ */
+class KeyLess {
+ public:
+    bool operator()( const PdfKeyMap::value_type & lhs, const PdfName & rhs ) const
+    {
+        return lhs.first < rhs;
+    }
+};
+
+};
+
+PdfKeyMap::iterator PdfKeyMap::LowerBound( const PdfName & rKey )
+{
+    if( m_vecKeys.size() < PODOFO_KEYMAP_LINEAR_SEARCH ) 
+    {
+        iterator it = m_vecKeys.begin();
+        while( it != m_vecKeys.end() && (*it).first < rKey )
+            ++it;
+
+        return it;
+    }
+
+    return std::lower_bound( m_vecKeys.begin(), m_vecKeys.end(), rKey, PdfDictionaryNameSpace::KeyLess() );
+}
+
+PdfKeyMap::iterator PdfKeyMap::find( const PdfName & rKey )
+{
+    iterator it = this->LowerBound( rKey );
+    if( it != m_vecKeys.end() && (*it).first == rKey )
+        return it;
+
+    return m_vecKeys.end();
+}
+
+PdfKeyMap::const_iterator PdfKeyMap::find( const PdfName & rKey ) const
+{
+    return const_cast<PdfKeyMap*>(this)->find( rKey );
+}
+
+std::pair<PdfKeyMap::iterator,bool> PdfKeyMap::insert( const value_type & rValue )
+{
+    iterator it = this->LowerBound( rValue.first );
+    if( it != m_vecKeys.end() && (*it).first == rValue.first )
+        return std::pair<iterator,bool>( it, false );
+
+    return std::pair<iterator,bool>( m_vecKeys.insert( it, rValue ), true );
+}
+
+PdfObject* & PdfKeyMap::operator[]( const PdfName & rKey )
+{
+    return (*this->insert( value_type( rKey, NULL ) ).first).second;
+}
+
+PdfKeyMap::size_type PdfKeyMap::erase( const PdfName & rKey )
+{
+    iterator it = this->find( rKey );
+    if( it == m_vecKeys.end() )
+        return 0;
+
+    m_vecKeys.erase( it );
+    return 1;
+}
+
 PdfDictionary::PdfDictionary()
     : m_bDirty( false )
 {
@@ -47,12 +115,18 @@ const PdfDictionary & PdfDictionary::operator=( const PdfDictionary & rhs )
 {
     TCIKeyMap it;
 
+    if( this == &rhs )
+        return *this;
+
     this->Clear();
 
+    // The keys of rhs are sorted already, so they are simply appended
+    m_mapKeys.reserve( rhs.m_mapKeys.size() );
     it = rhs.m_mapKeys.begin();
     while( it != rhs.m_mapKeys.end() )
     {
-        m_mapKeys[(*it).first] = new PdfObject( *(*it).second );
+        PdfObject* pObject = new PdfObject( *(*it).second );
+        m_mapKeys.insert( TKeyMap::value_type( (*it).first, pObject ) );
         ++it;
     }
     
@@ -73,10 +147,10 @@ bool PdfDictionary::operator==( const PdfDictionary& rhs ) const
     // keys are stored in a SORTED map, and there may be only one instance of
     // every key, we can do lockstep iteration and compare that way.
 
-    const TCIKeyMap thisIt = m_mapKeys.begin();
+    TCIKeyMap       thisIt  = m_mapKeys.begin();
     const TCIKeyMap thisEnd = m_mapKeys.end();
-    const TCIKeyMap rhsIt = rhs.m_mapKeys.begin();
-    const TCIKeyMap rhsEnd = rhs.m_mapKeys.end();
+    TCIKeyMap       rhsIt   = rhs.m_mapKeys.begin();
+    const TCIKeyMap rhsEnd  = rhs.m_mapKeys.end();
     while ( thisIt != thisEnd && rhsIt != rhsEnd )
     {
         if ( (*thisIt).first != (*rhsIt).first )
@@ -86,6 +160,9 @@ bool PdfDictionary::operator==( const PdfDictionary& rhs ) const
         if ( *(*thisIt).second != *(*rhsIt).second )
             // Value mismatch on same-named keys.
             return false;
+
+        ++thisIt;
+        ++rhsIt;
     }
     // BOTH dictionaries must now be on their end iterators - since we checked that they were
     // the same size initially, we know they should run out of keys at the same time.
@@ -126,13 +203,15 @@ void PdfDictionary::AddKey( const PdfName & identifier, const PdfObject & rObjec
     }
     */
 
-    if( m_mapKeys.find( identifier ) != m_mapKeys.end() )
+    // Copy the object first, rObject might be the value which is replaced
+    PdfObject*               pObject  = new PdfObject( rObject );
+    std::pair<TIKeyMap,bool> inserted = m_mapKeys.insert( TKeyMap::value_type( identifier, pObject ) );
+    if( !inserted.second )
     {
-        delete m_mapKeys[identifier];
-        m_mapKeys.erase( identifier );
+        delete (*inserted.first).second;
+        (*inserted.first).second = pObject;
     }
 
-	m_mapKeys[identifier] = new PdfObject( rObject );
     m_bDirty = true;
 }
 
@@ -145,10 +224,11 @@ const PdfObject* PdfDictionary::GetKey( const PdfName & key ) const
 {
     TCIKeyMap it;
 
-    if( HasKey( key ) )
+    if( key.GetLength() )
     {
         it = m_mapKeys.find( key );
-        return (*it).second;
+        if( it != m_mapKeys.end() )
+            return (*it).second;
     }
     
     return NULL;
@@ -158,10 +238,11 @@ PdfObject* PdfDictionary::GetKey( const PdfName & key )
 {
     TIKeyMap it;
 
-    if( HasKey( key ) )
+    if( key.GetLength() )
     {
         it = m_mapKeys.find( key );
-        return (*it).second;
+        if( it != m_mapKeys.end() )
+            return (*it).second;
     }
     
     return NULL;
@@ -229,9 +310,11 @@ bool PdfDictionary::RemoveKey( const PdfName & identifier )
     if( HasKey( identifier ) )
     {
         AssertMutable();
-        delete m_mapKeys[identifier];
 
-        m_mapKeys.erase( identifier );
+        TIKeyMap it = m_mapKeys.find( identifier );
+        delete (*it).second;
+
+        m_mapKeys.erase( it );
         m_bDirty = true;
         return true;
     }
@@ -245,11 +328,11 @@ void PdfDictionary::Write( PdfOutputDevice* pDevice, EPdfWriteMode eWriteMode, c
 
     if( (eWriteMode & ePdfWriteMode_Clean) == ePdfWriteMode_Clean ) 
     {
-        pDevice->Print( "<<\n" );
+        pDevice->Write( "<<\n", 3 );
     } 
     else
     {
-        pDevice->Print( "<<" );
+        pDevice->Write( "<<", 2 );
     }
     itKeys     = m_mapKeys.begin();
 
@@ -261,18 +344,18 @@ void PdfDictionary::Write( PdfOutputDevice* pDevice, EPdfWriteMode eWriteMode, c
         // Type has to be the first key in any dictionary
         if( (eWriteMode & ePdfWriteMode_Clean) == ePdfWriteMode_Clean ) 
         {
-            pDevice->Print( "/Type " );
+            pDevice->Write( "/Type ", 6 );
         }
         else
         {
-            pDevice->Print( "/Type" );
+            pDevice->Write( "/Type", 5 );
         }
 
         this->GetKey( PdfName::KeyType )->Write( pDevice, eWriteMode, pEncrypt );
 
         if( (eWriteMode & ePdfWriteMode_Clean) == ePdfWriteMode_Clean ) 
         {
-            pDevice->Print( "\n" );
+            pDevice->Write( "\n", 1 );
         }
     }
 
@@ -298,7 +381,7 @@ void PdfDictionary::Write( PdfOutputDevice* pDevice, EPdfWriteMode eWriteMode, c
         ++itKeys;
     }
 
-    pDevice->Print( ">>" );
+    pDevice->Write( ">>", 2 );
 }
 
 bool PdfDictionary::IsDirty() const
@@ -27,44 +27,102 @@
 #include "PdfName.h"
 #include "PdfObject.h"
 
+#include <vector>
+
+namespace PoDoFo {
+
+/** Dictionaries with less keys than this are searched linearly,
+ *  larger dictionaries are searched using a binary search.
+ */
+#define PODOFO_KEYMAP_LINEAR_SEARCH 8
+
 /**
- * PODOFO_USE_UNORDERED_MAP
- * 
- * If you set this define, PoDoFo
- * will use std::tr1::unordered_map instead
- * of std::map for PdfDictionary.
+ * The keys of a PdfDictionary.
  *
- * Some benchmarking tests using callgrind have shown
- * that unordered_map is a little faster for writing and AddKey
- * but of course slower for GetKey and HasKey. As PdfDictionaries
- * are usually very small the difference for GetKey and HasKey is
- * not very large and should therefore be rarely noticeable.
+ * Most dictionaries in PDF files have only a few keys. Instead of
+ * a tree with one heap node per key, the keys are stored in a single
+ * vector sorted by their names. Small dictionaries are searched
+ * linearly, larger ones using a binary search.
  *
- * By default this define is not set and std::map will be used.
+ * PdfKeyMap provides the parts of the std::map interface used with
+ * dictionaries, so that code iterating over the keys of a dictionary
+ * works like before. Iteration is in the order of the key names.
+ * Unlike std::map, iterators are invalidated by inserting or
+ * removing keys. The values are owned by the PdfDictionary and are
+ * not moved, though.
  */
-#ifdef PODOFO_USE_UNORDERED_MAP
-#include <tr1/unordered_map>
-#endif // PODOFO_USE_ORDERED_MAP
+class PODOFO_API PdfKeyMap {
+ public:
+    typedef PdfName                                 key_type;
+    typedef PdfObject*                              mapped_type;
+    typedef std::pair<PdfName,PdfObject*>           value_type;
+    typedef std::vector<value_type>::size_type      size_type;
+    typedef std::vector<value_type>::iterator       iterator;
+    typedef std::vector<value_type>::const_iterator const_iterator;
+
+    inline iterator begin();
+    inline const_iterator begin() const;
+    inline iterator end();
+    inline const_iterator end() const;
+
+    inline size_type size() const;
+    inline bool empty() const;
+    inline void clear();
+
+    /** Allocate memory for a number of keys
+     *  \param n the number of keys
+     */
+    inline void reserve( size_type n );
 
-namespace PoDoFo {
+    /** Find a key
+     *  \param rKey the name of the key
+     *  \returns an iterator pointing to the key or end()
+     */
+    iterator find( const PdfName & rKey );
+    const_iterator find( const PdfName & rKey ) const;
 
-#ifdef PODOFO_USE_UNORDERED_MAP
-class PdfNameHash : public std::unary_function<PdfName, size_t>
-{
-public:
-    size_t operator()( const PdfName& v ) const
-    {
-        std::tr1::hash<std::string> hasher;
-        
-        return hasher( v.GetName() );
-    }
-};
+    /** 
+     *  \param rKey the name of a key
+     *  \returns 1 if the key exists, otherwise 0
+     */
+    inline size_type count( const PdfName & rKey ) const;
+
+    /** Insert a key, unless a key with the same name exists already.
+     *  \param rValue the name and value of the key
+     *  \returns an iterator to the key with the name and true if
+     *            the key was inserted
+     */
+    std::pair<iterator,bool> insert( const value_type & rValue );
+
+    /** Access the value of a key. If there is no such key,
+     *  a key with a NULL value is inserted.
+     *  \param rKey the name of the key
+     *  \returns the value of the key
+     */
+    PdfObject* & operator[]( const PdfName & rKey );
+
+    /** Remove a key. The value is not deleted.
+     *  \param it the key to remove
+     */
+    inline void erase( iterator it );
+
+    /** Remove a key. The value is not deleted.
+     *  \param rKey the name of the key to remove
+     *  \returns the number of removed keys
+     */
+    size_type erase( const PdfName & rKey );
+
+ private:
+    /** 
+     *  \returns the first key which is not less than rKey
+     */
+    iterator LowerBound( const PdfName & rKey );
 
-typedef std::tr1::unordered_map<PdfName,PdfObject*, PdfNameHash>      TKeyMap;
-#else
-typedef std::map<PdfName,PdfObject*>      TKeyMap;
-#endif // PODOFO_USE_UNORDERED_MAP
+ private:
+    std::vector<value_type> m_vecKeys;
+};
 
+typedef PdfKeyMap                         TKeyMap;
 typedef TKeyMap::iterator                 TIKeyMap;
 typedef TKeyMap::const_iterator           TCIKeyMap;
 
@@ -251,15 +309,95 @@ class PODOFO_API PdfDictionary : public PdfDataType {
     virtual void SetDirty( bool bDirty );
 
  private: 
-    TKeyMap      m_mapKeys; 
-
     bool         m_bDirty; ///< Indicates if this object was modified after construction
+
+    TKeyMap      m_mapKeys; 
 };
 
 typedef std::vector<PdfDictionary*>      TVecDictionaries; 
 typedef	TVecDictionaries::iterator       TIVecDictionaries; 
 typedef	TVecDictionaries::const_iterator TCIVecDictionaries;
 
+// -----------------------------------------------------
+// 
+// -----------------------------------------------------
+PdfKeyMap::iterator PdfKeyMap::begin()
+{
+    return m_vecKeys.begin();
+}
+
+// -----------------------------------------------------
+// 
+// -----------------------------------------------------
+PdfKeyMap::const_iterator PdfKeyMap::begin() const
+{
+    return m_vecKeys.begin();
+}
+
+// -----------------------------------------------------
+// 
+// -----------------------------------------------------
+PdfKeyMap::iterator PdfKeyMap::end()
+{
+    return m_vecKeys.end();
+}
+
+// -----------------------------------------------------
+// 
+// -----------------------------------------------------
+PdfKeyMap::const_iterator PdfKeyMap::end() const
+{
+    return m_vecKeys.end();
+}
+
+// -----------------------------------------------------
+// 
+// -----------------------------------------------------
+PdfKeyMap::size_type PdfKeyMap::size() const
+{
+    return m_vecKeys.size();
+}
+
+// -----------------------------------------------------
+// 
+// -----------------------------------------------------
+bool PdfKeyMap::empty() const
+{
+    return m_vecKeys.empty();
+}
+
+// -----------------------------------------------------
+// 
+// -----------------------------------------------------
+void PdfKeyMap::clear()
+{
+    m_vecKeys.clear();
+}
+
+// -----------------------------------------------------
+// 
+// -----------------------------------------------------
+void PdfKeyMap::reserve( size_type n )
+{
+    m_vecKeys.reserve( n );
+}
+
+// -----------------------------------------------------
+// 
+// -----------------------------------------------------
+PdfKeyMap::size_type PdfKeyMap::count( const PdfName & rKey ) const
+{
+    return this->find( rKey ) != m_vecKeys.end() ? 1 : 0;
+}
+
+// -----------------------------------------------------
+// 
+// -----------------------------------------------------
+void PdfKeyMap::erase( iterator it )
+{
+    m_vecKeys.erase( it );
+}
+
 // -----------------------------------------------------
 // 
 // -----------------------------------------------------
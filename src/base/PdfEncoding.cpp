@@ -21,8 +21,10 @@
 #include "PdfEncoding.h"
 
 #include "PdfDictionary.h"
+#include "PdfEncodingFactory.h"
 #include "PdfLocale.h"
 #include "util/PdfMutexWrapper.h"
+#include "util/PdfThreads.h"
 #include "PdfDefinesPrivate.h"
 
 #include <stdlib.h>
@@ -45,6 +47,34 @@ PdfEncoding::~PdfEncoding()
 
 }
 
+bool PdfEncoding::GetStringUnicodeTable( const PdfString & rString, const pdf_utf16be** ppTable )
+{
+    *ppTable = NULL;
+    if( rString.IsUnicode() ) 
+        return true;
+
+    const PdfSimpleEncoding* pEncoding = (rString.GetEncoding() ? 
+                                          dynamic_cast<const PdfSimpleEncoding*>(rString.GetEncoding()) :
+                                          static_cast<const PdfSimpleEncoding*>(PdfEncodingFactory::GlobalPdfDocEncodingInstance()));
+    if( !pEncoding ) 
+        return false;
+
+    *ppTable = pEncoding->GetToUnicodeTable();
+    return true;
+}
+
+pdf_long PdfEncoding::ConvertToEncodingBuffer( const PdfString & rString, const PdfFont* pFont, 
+                                               char* pBuffer, pdf_long lBufferLen ) const
+{
+    PdfRefCountedBuffer buffer = this->ConvertToEncoding( rString, pFont );
+    pdf_long            lLen   = static_cast<pdf_long>(buffer.GetSize());
+
+    if( lLen && pBuffer ) 
+        memcpy( pBuffer, buffer.GetBuffer(), PDF_MIN( lLen, lBufferLen ) );
+
+    return lLen;
+}
+
 // -----------------------------------------------------
 // PdfSimpleEncoding
 // -----------------------------------------------------
@@ -67,16 +97,25 @@ void PdfSimpleEncoding::InitEncodingTable()
 
     if( !m_pEncodingTable ) // double check
     {
-        m_pEncodingTable = static_cast<char*>(malloc(sizeof(char)*lTableLength));
+        char* pTable = static_cast<char*>(malloc(sizeof(char)*lTableLength));
+        if( !pTable ) 
+        {
+            PODOFO_RAISE_ERROR( ePdfError_OutOfMemory );
+        }
     
         // fill the table with 0
-        memset( m_pEncodingTable, 0, lTableLength * sizeof(char) ); 
+        memset( pTable, 0, lTableLength * sizeof(char) ); 
         // fill the table with data
         for( size_t i=0; i<256; i++ )
         {
-            m_pEncodingTable[ static_cast<size_t>(cpUnicodeTable[i]) ] = 
+            pTable[ static_cast<size_t>(cpUnicodeTable[i]) ] = 
                 static_cast<unsigned char>(i);
         }
+
+        // Other threads read m_pEncodingTable without locking,
+        // so it may only be set once the table is complete
+        Util::PdfMemoryBarrier();
+        m_pEncodingTable = pTable;
     }
 }
 
@@ -138,50 +177,52 @@ PdfString PdfSimpleEncoding::ConvertToUnicode( const PdfString & rEncodedString,
     return sStr;
 }
 
-PdfRefCountedBuffer PdfSimpleEncoding::ConvertToEncoding( const PdfString & rString, const PdfFont* ) const
+PdfRefCountedBuffer PdfSimpleEncoding::ConvertToEncoding( const PdfString & rString, const PdfFont* pFont ) const
 {
-    if( !m_pEncodingTable )
-        const_cast<PdfSimpleEncoding*>(this)->InitEncodingTable();
-
-    PdfString sSrc = rString.ToUnicode(); // make sure the string is unicode and not PdfDocEncoding!
-    pdf_long  lLen = sSrc.GetCharacterLength();
-
+    // A simple encoding never needs more than one byte per character
+    pdf_long lLen = rString.IsUnicode() ? rString.GetCharacterLength() : rString.GetLength();
     if( !lLen )
         return PdfRefCountedBuffer();
 
-    char* pDest = static_cast<char*>(malloc( sizeof(char) * (lLen + 1) ));
-    if( !pDest ) 
+    PdfRefCountedBuffer cDest( lLen );
+    lLen = this->ConvertToEncodingBuffer( rString, pFont, cDest.GetBuffer(), lLen );
+    cDest.Resize( lLen );
+
+    return cDest;
+}
+
+pdf_long PdfSimpleEncoding::ConvertToEncodingBuffer( const PdfString & rString, const PdfFont*, 
+                                                     char* pBuffer, pdf_long lBufferLen ) const
+{
+    // The mutex is only locked until the table has been created,
+    // InitEncodingTable() sets m_pEncodingTable when the table is complete
+    const char* pEncodingTable = m_pEncodingTable;
+    if( !pEncodingTable )
     {
-        PODOFO_RAISE_ERROR( ePdfError_OutOfMemory );
+        const_cast<PdfSimpleEncoding*>(this)->InitEncodingTable();
+        pEncodingTable = m_pEncodingTable;
     }
-        
-    const pdf_utf16be* pszUtf16 = sSrc.GetUnicode();
-    char*              pCur     = pDest;
-    long               lNewLen  = 0L;
 
-    for( int i=0;i<lLen;i++ ) 
-    {
-        pdf_utf16be val = pszUtf16[i];
-#ifdef PODOFO_IS_LITTLE_ENDIAN
-        val = ((val & 0xff00) >> 8) | ((val & 0xff) << 8);
-#endif // PODOFO_IS_LITTLE_ENDIAN
+    // Only strings in other encodings have to be converted to unicode first
+    PdfString          sUnicode;
+    const pdf_utf16be* pTable;
+    const PdfString &  rSrc    = (GetStringUnicodeTable( rString, &pTable ) ? rString : (sUnicode = rString.ToUnicode()));
+    pdf_long           lLen    = rSrc.GetCharacterLength();
+    pdf_long           lNewLen = 0L;
 
-        *pCur = m_pEncodingTable[val]; 
-        if( *pCur ) // ignore 0 characters, as they cannot be converted to the current encoding
+    for( pdf_long i=0;i<lLen;i++ ) 
+    {
+        const char c = pEncodingTable[GetUnicodeCharAt( rSrc, pTable, i )]; 
+        if( c ) // ignore 0 characters, as they cannot be converted to the current encoding
         {
-            ++pCur; 
+            if( lNewLen < lBufferLen )
+                pBuffer[lNewLen] = c;
+
             ++lNewLen;
         }
     }
-    
-    *pCur = '\0';
-    
 
-    PdfRefCountedBuffer cDest( lNewLen );
-    memcpy( cDest.GetBuffer(), pDest, lNewLen );
-    free( pDest );
-
-    return cDest;
+    return lNewLen;
 }
 
 // -----------------------------------------------------
@@ -61,6 +61,28 @@ class PODOFO_API PdfEncoding {
      */
     virtual const PdfName & GetID() const = 0;
 
+    /** Get the table which converts the characters of a string to unicode,
+     *  so that single characters can be read with GetUnicodeCharAt()
+     *  without converting the whole string to unicode.
+     *
+     *  \param rString a string
+     *  \param ppTable set to the table of the simple encoding of rString 
+     *                 or to NULL if rString is unicode
+     *
+     *  \returns false if rString has to be converted using PdfString::ToUnicode() first
+     */
+    static bool GetStringUnicodeTable( const PdfString & rString, const pdf_utf16be** ppTable );
+
+    /** Get the unicode value of a single character of a string.
+     *
+     *  \param rString a string
+     *  \param pTable the table returned by GetStringUnicodeTable() for rString
+     *  \param lIndex index of the character, smaller than rString.GetCharacterLength()
+     *
+     *  \returns the unicode value in host byte order
+     */
+    static inline pdf_utf16be GetUnicodeCharAt( const PdfString & rString, const pdf_utf16be* pTable, pdf_long lIndex );
+
  public:
 #if defined(_MSC_VER)  &&  _MSC_VER <= 1200			// ab Visualstudio 6
     class PODOFO_API const_iterator : public std::iterator<
@@ -164,6 +186,25 @@ class PODOFO_API PdfEncoding {
      */
     virtual PdfRefCountedBuffer ConvertToEncoding( const PdfString & rString, const PdfFont* pFont ) const = 0;
 
+    /** Convert a unicode PdfString to a string encoded with this encoding
+     *  and write the result to a buffer supplied by the caller.
+     *
+     *  This avoids the allocation of an intermediate PdfRefCountedBuffer
+     *  if the encoded string is written to a content stream directly.
+     *  The default implementation calls ConvertToEncoding() and copies the result.
+     *
+     *  \param rString an unicode PdfString.
+     *  \param pFont the font for which this string is converted
+     *  \param pBuffer the encoded bytes are written to this buffer
+     *  \param lBufferLen size of pBuffer in bytes
+     *
+     *  \returns the number of bytes of the encoded string. If this is larger
+     *            than lBufferLen, only the first lBufferLen bytes were written and
+     *            the call has to be repeated with a buffer of the returned size.
+     */
+    virtual pdf_long ConvertToEncodingBuffer( const PdfString & rString, const PdfFont* pFont, 
+                                              char* pBuffer, pdf_long lBufferLen ) const;
+
     /** 
      * \returns true if this encoding should be deleted automatically with the
      *          font.
@@ -234,6 +275,22 @@ inline bool PdfEncoding::operator==( const PdfEncoding & rhs ) const
     return (this->GetID() == rhs.GetID());
 }
 
+// -----------------------------------------------------
+// 
+// -----------------------------------------------------
+inline pdf_utf16be PdfEncoding::GetUnicodeCharAt( const PdfString & rString, const pdf_utf16be* pTable, pdf_long lIndex )
+{
+    if( pTable ) 
+        return pTable[static_cast<unsigned char>(rString.GetString()[lIndex])];
+
+    pdf_utf16be val = rString.GetUnicode()[lIndex];
+#ifdef PODOFO_IS_LITTLE_ENDIAN
+    val = ((val & 0xff00) >> 8) | ((val & 0xff) << 8);
+#endif // PODOFO_IS_LITTLE_ENDIAN
+
+    return val;
+}
+
 // -----------------------------------------------------
 // 
 // -----------------------------------------------------
@@ -288,6 +345,8 @@ inline PdfEncoding::const_iterator PdfEncoding::end() const
  *
  */
 class PODOFO_API PdfSimpleEncoding : public PdfEncoding {
+    friend class PdfEncoding;
+
  public:
     /*
      *  Create a new simple PdfEncoding which uses 1 byte.
@@ -348,6 +407,14 @@ class PODOFO_API PdfSimpleEncoding : public PdfEncoding {
      */
     virtual PdfRefCountedBuffer ConvertToEncoding( const PdfString & rString, const PdfFont* pFont ) const;
 
+    /** Convert a unicode PdfString to a string encoded with this encoding
+     *  and write the result to a buffer supplied by the caller.
+     *
+     *  \see PdfEncoding::ConvertToEncodingBuffer
+     */
+    virtual pdf_long ConvertToEncodingBuffer( const PdfString & rString, const PdfFont* pFont, 
+                                              char* pBuffer, pdf_long lBufferLen ) const;
+
     /** 
      * PdfSimpleEncoding subclasses are usuylla not auto-deleted, as
      * they are allocated statically only once.
@@ -32,6 +32,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <sstream>
+#include <vector>
 
 #ifdef PODOFO_HAVE_CRYPTO_LIBS
 // AES-256 dependencies :
@@ -44,6 +45,10 @@
 #include <CommonCrypto/CommonDigest.h>
 #else
 #include <openssl/sha.h>
+
+// AES using OpenSSL, which uses the AES instructions of the CPU if available
+#include <openssl/evp.h>
+#define PODOFO_HAVE_OPENSSL_AES
 #endif
 #endif // PODOFO_HAVE_CRYPTO_LIBS
 
@@ -248,6 +253,410 @@ private:
     PdfRC4Stream    m_stream;
 };
 
+/** A class that can encrypt/decrypt streamed data block wise
+ *  using the AES algorithm in CBC mode as required by the
+ *  AESV2 and AESV3 encryption algorithms.
+ *
+ *  The data is passed to OpenSSL if available, which uses
+ *  the AES instructions of the CPU if present.
+ *  Otherwise PdfRijndael is used.
+ *
+ *  Encrypted data is padded according to PKCS#5 by Final().
+ *  When decrypting, the last block is kept back until Final()
+ *  is called, which removes the padding.
+ */
+class PdfAESStream {
+public:
+    /** Create a new AES stream
+     *
+     *  \param bEncrypt true to encrypt, false to decrypt
+     *  \param pKey the key
+     *  \param nKeyLen the length of the key, either 16 or 32 bytes
+     *  \param pIV the 16 bytes initial vector
+     */
+    PdfAESStream( bool bEncrypt, const unsigned char* pKey, int nKeyLen, const unsigned char* pIV )
+        : m_bEncrypt( bEncrypt ), m_nPending( 0 )
+    {
+        if( nKeyLen != 16 && nKeyLen != 32 )
+        {
+            PODOFO_RAISE_ERROR_INFO( ePdfError_InternalLogic, "Invalid AES key length" );
+        }
+
+#ifdef PODOFO_HAVE_OPENSSL_AES
+        m_ctx = EVP_CIPHER_CTX_new();
+        if( !m_ctx 
+            || EVP_CipherInit_ex( m_ctx, nKeyLen == 16 ? EVP_aes_128_cbc() : EVP_aes_256_cbc(), NULL,
+                                  pKey, pIV, bEncrypt ? 1 : 0 ) != 1 )
+        {
+            EVP_CIPHER_CTX_free( m_ctx );
+            PODOFO_RAISE_ERROR_INFO( ePdfError_InternalLogic, "Error initializing AES encryption engine" );
+        }
+
+        // Padding is handled by this class, as broken padding
+        // has to be accepted when decrypting
+        EVP_CIPHER_CTX_set_padding( m_ctx, 0 );
+#else
+        memcpy( m_key, pKey, nKeyLen );
+        memcpy( m_iv, pIV, 16 );
+        m_eKeyLen = nKeyLen == 16 ? PdfRijndael::Key16Bytes : PdfRijndael::Key32Bytes;
+#endif // PODOFO_HAVE_OPENSSL_AES
+    }
+
+    ~PdfAESStream()
+    {
+#ifdef PODOFO_HAVE_OPENSSL_AES
+        EVP_CIPHER_CTX_free( m_ctx );
+#endif // PODOFO_HAVE_OPENSSL_AES
+    }
+
+    /** Encrypt or decrypt a block of data
+     *
+     *  \param pIn the input data
+     *  \param lLen the length of pIn
+     *  \param pOut the output buffer, which has to be at least lLen + 16 bytes large.
+     *              pOut may be equal to pIn for the first call only.
+     *
+     *  \returns the number of bytes written to pOut
+     */
+    pdf_long Update( const unsigned char* pIn, pdf_long lLen, unsigned char* pOut )
+    {
+        const pdf_long lTotal = m_nPending + lLen;
+        pdf_long       lKeep  = lTotal % 16;
+        // Keep back the last block when decrypting, as it contains the padding
+        if( !m_bEncrypt && !lKeep && lTotal )
+            lKeep = 16;
+
+        if( lTotal - lKeep <= 0 )
+        {
+            memcpy( m_pending + m_nPending, pIn, lLen );
+            m_nPending += static_cast<int>(lLen);
+            return 0;
+        }
+
+        pdf_long lWritten = 0;
+        if( m_nPending ) 
+        {
+            const int nFill = 16 - m_nPending;
+            memcpy( m_pending + m_nPending, pIn, nFill );
+            Cipher( m_pending, 16, pOut );
+
+            pIn      += nFill;
+            lLen     -= nFill;
+            lWritten += 16;
+        }
+
+        const pdf_long lBlocks = lLen - lKeep;
+        if( lBlocks )
+            Cipher( pIn, lBlocks, pOut + lWritten );
+
+        memcpy( m_pending, pIn + lBlocks, lKeep );
+        m_nPending = static_cast<int>(lKeep);
+
+        return lWritten + lBlocks;
+    }
+
+    /** Finish encryption or decryption
+     *
+     *  \param pOut the output buffer, which has to be at least 16 bytes large.
+     *
+     *  \returns the number of bytes written to pOut
+     */
+    pdf_long Final( unsigned char* pOut )
+    {
+        if( m_bEncrypt ) 
+        {
+            const unsigned char cPad = static_cast<unsigned char>(16 - m_nPending);
+            memset( m_pending + m_nPending, cPad, cPad );
+            m_nPending = 0;
+
+            Cipher( m_pending, 16, pOut );
+            return 16;
+        }
+
+        // A trailing partial block cannot be decrypted, drop it
+        if( m_nPending != 16 )
+        {
+            m_nPending = 0;
+            return 0;
+        }
+
+        m_nPending = 0;
+        Cipher( m_pending, 16, pOut );
+
+        // Be lenient with broken padding, as some producers do not pad at all
+        const int nPad = pOut[15];
+        return ( nPad >= 1 && nPad <= 16 ) ? 16 - nPad : 16;
+    }
+
+private:
+    /** Encrypt or decrypt complete blocks
+     *
+     *  \param pIn the input data
+     *  \param lLen the length of pIn, a multiple of 16
+     *  \param pOut the output buffer of at least lLen bytes, may be equal to pIn
+     */
+    void Cipher( const unsigned char* pIn, pdf_long lLen, unsigned char* pOut )
+    {
+#ifdef PODOFO_HAVE_OPENSSL_AES
+        // EVP_CipherUpdate takes the length as int
+        const pdf_long lMaxChunk = 1L << 30;
+        while( lLen ) 
+        {
+            const int nChunk = static_cast<int>(PDF_MIN( lLen, lMaxChunk ));
+            int       nOut   = 0;
+            if( EVP_CipherUpdate( m_ctx, pOut, &nOut, pIn, nChunk ) != 1 || nOut != nChunk )
+            {
+                PODOFO_RAISE_ERROR_INFO( ePdfError_InternalLogic, "Error on AES encryption" );
+            }
+
+            pIn  += nChunk;
+            pOut += nChunk;
+            lLen -= nChunk;
+        }
+#else
+        // PdfRijndael takes the length in bits as int and does not
+        // keep the CBC state between calls, so pass the last
+        // cipher block as initial vector to the next call
+        const pdf_long lMaxChunk = 1L << 20;
+        while( lLen ) 
+        {
+            const pdf_long lChunk = PDF_MIN( lLen, lMaxChunk );
+            unsigned char  next[16];
+
+            if( !m_bEncrypt ) 
+                memcpy( next, pIn + lChunk - 16, 16 );
+
+            int ret = m_aes.init( PdfRijndael::CBC, m_bEncrypt ? PdfRijndael::Encrypt : PdfRijndael::Decrypt, 
+                                  m_key, m_eKeyLen, m_iv );
+            if( ret >= 0 ) 
+                ret = m_bEncrypt ? m_aes.blockEncrypt( pIn, static_cast<int>(lChunk * 8), pOut )
+                                 : m_aes.blockDecrypt( pIn, static_cast<int>(lChunk * 8), pOut );
+            if( ret < 0 )
+            {
+                PODOFO_RAISE_ERROR_INFO( ePdfError_InternalLogic, "Error on AES encryption" );
+            }
+
+            memcpy( m_iv, m_bEncrypt ? pOut + lChunk - 16 : next, 16 );
+
+            pIn  += lChunk;
+            pOut += lChunk;
+            lLen -= lChunk;
+        }
+#endif // PODOFO_HAVE_OPENSSL_AES
+    }
+
+private:
+    bool          m_bEncrypt;
+    unsigned char m_pending[16];   ///< Data of an incomplete block or the block kept back for decryption
+    int           m_nPending;
+
+#ifdef PODOFO_HAVE_OPENSSL_AES
+    EVP_CIPHER_CTX* m_ctx;
+#else
+    PdfRijndael            m_aes;
+    unsigned char          m_key[32];
+    unsigned char          m_iv[16];
+    PdfRijndael::KeyLength m_eKeyLen;
+#endif // PODOFO_HAVE_OPENSSL_AES
+};
+
+/** A PdfOutputStream that encrypt all data written
+ *  using the AES encryption algorithm
+ */
+class PdfAESOutputStream : public PdfOutputStream {
+public:
+    PdfAESOutputStream( PdfOutputStream* pOutputStream, const unsigned char* key, int keylen, const unsigned char iv[16] )
+    : m_pOutputStream( pOutputStream ), m_stream( true, key, keylen, iv ), m_bClosed( false )
+    {
+        m_pOutputStream->Write( reinterpret_cast<const char*>(iv), 16 );
+    }
+    
+    virtual ~PdfAESOutputStream()
+    {
+    }
+    
+    /** Write data to the output stream
+     *  
+     *  \param pBuffer the data is read from this buffer
+     *  \param lLen    the size of the buffer 
+     */
+    virtual pdf_long Write( const char* pBuffer, pdf_long lLen )
+    {
+        // Do not encode data with no length
+        if( !lLen )
+            return lLen;
+
+        if( m_buffer.size() < static_cast<size_t>(lLen + 16) )
+            m_buffer.resize( lLen + 16 );
+        
+        pdf_long lOut = m_stream.Update( reinterpret_cast<const unsigned char*>(pBuffer), lLen, &m_buffer[0] );
+        if( lOut )
+            m_pOutputStream->Write( reinterpret_cast<const char*>(&m_buffer[0]), lOut );
+        
+        return lLen;
+    }
+    
+    /** Close the PdfOutputStream.
+     *  This method may throw exceptions and has to be called 
+     *  before the descructor to end writing.
+     *
+     *  No more data may be written to the output device
+     *  after calling close.
+     */
+    virtual void Close() 
+    {
+        // A filter closes its output stream, so PdfFileStream
+        // closes the encryption stream a second time
+        if( m_bClosed )
+            return;
+
+        unsigned char last[16];
+
+        pdf_long lOut = m_stream.Final( last );
+        m_pOutputStream->Write( reinterpret_cast<const char*>(last), lOut );
+        m_bClosed = true;
+    }
+    
+private:
+    PdfOutputStream*           m_pOutputStream;
+    PdfAESStream               m_stream;
+    std::vector<unsigned char> m_buffer;
+    bool                       m_bClosed;   ///< The padding has been written
+};
+
+/** A PdfInputStream that decrypts all data read
+ *  using the AES encryption algorithm
+ *
+ *  The data is read from the underlying stream and decrypted
+ *  in large blocks, independent of the size of the reads.
+ */
+class PdfAESInputStream : public PdfInputStream {
+public:
+    PdfAESInputStream( PdfInputStream* pInputStream, pdf_long lInputLen, const unsigned char* key, int keylen )
+    : m_pInputStream( pInputStream ), m_lInputLen( lInputLen ), m_pStream( NULL ), 
+      m_lPos( 0 ), m_lAvailable( 0 ), m_bEof( false )
+    {
+        memcpy( m_key, key, keylen );
+        m_nKeyLen = keylen;
+    }
+    
+    virtual ~PdfAESInputStream() 
+    {
+        delete m_pStream;
+    }
+    
+    /** Read data from the input stream
+     *  
+     *  \param pBuffer the data will be stored into this buffer
+     *  \param lLen    the size of the buffer and number of bytes
+     *                 that will be read
+     *
+     *  \returns the number of bytes read, -1 if an error ocurred
+     *           and zero if no more bytes are available for reading.
+     */
+    virtual pdf_long Read( char* pBuffer, pdf_long lLen )
+    {
+        pdf_long lRead = 0;
+        while( lRead < lLen ) 
+        {
+            if( !m_lAvailable ) 
+            {
+                if( m_bEof || !this->Fill() )
+                    break;
+
+                continue;
+            }
+
+            const pdf_long lCopy = PDF_MIN( lLen - lRead, m_lAvailable );
+            memcpy( pBuffer + lRead, &m_buffer[m_lPos], lCopy );
+
+            lRead        += lCopy;
+            m_lPos       += lCopy;
+            m_lAvailable -= lCopy;
+        }
+        
+        return lRead;
+    }
+    
+private:
+    /** Read data from the underlying stream
+     *
+     *  \param pBuffer the data will be stored into this buffer
+     *  \param lLen the number of bytes to read
+     *
+     *  \returns the number of bytes read, less than lLen only at the end of the data
+     */
+    pdf_long ReadInput( unsigned char* pBuffer, pdf_long lLen )
+    {
+        if( m_lInputLen != -1 )
+            lLen = PDF_MIN( lLen, m_lInputLen );
+
+        pdf_long lRead = 0;
+        while( lRead < lLen ) 
+        {
+            const pdf_long lCur = m_pInputStream->Read( reinterpret_cast<char*>(pBuffer) + lRead, lLen - lRead );
+            if( lCur <= 0 )
+                break;
+
+            lRead += lCur;
+        }
+
+        if( m_lInputLen != -1 )
+            m_lInputLen -= lRead;
+
+        return lRead;
+    }
+
+    /** Read and decrypt the next block of data into m_buffer
+     *
+     *  \returns false if the end of the data was reached 
+     *           and no more data is available
+     */
+    bool Fill()
+    {
+        const pdf_long lBlockSize = 256 * 1024;
+
+        if( !m_pStream ) 
+        {
+            unsigned char iv[16];
+            if( ReadInput( iv, 16 ) != 16 ) 
+            {
+                m_bEof = true;
+                return false;
+            }
+
+            m_pStream = new PdfAESStream( false, m_key, m_nKeyLen, iv );
+            m_input.resize( lBlockSize );
+            m_buffer.resize( lBlockSize + 16 );
+        }
+
+        pdf_long lIn  = ReadInput( &m_input[0], lBlockSize );
+        pdf_long lOut = m_pStream->Update( &m_input[0], lIn, &m_buffer[0] );
+        if( lIn < lBlockSize ) 
+        {
+            lOut  += m_pStream->Final( &m_buffer[lOut] );
+            m_bEof = true;
+        }
+
+        m_lPos       = 0;
+        m_lAvailable = lOut;
+        return m_lAvailable || !m_bEof;
+    }
+
+private:
+    PdfInputStream*            m_pInputStream;
+    pdf_long                   m_lInputLen;     ///< Number of encrypted bytes left in m_pInputStream or -1
+    unsigned char              m_key[32];
+    int                        m_nKeyLen;
+    PdfAESStream*              m_pStream;       ///< Created after reading the initial vector
+    
+    std::vector<unsigned char> m_input;
+    std::vector<unsigned char> m_buffer;        ///< Decrypted data
+    pdf_long                   m_lPos;
+    pdf_long                   m_lAvailable;
+    bool                       m_bEof;
+};
+
 // ----------------
 // MD5 by RSA
 // ----------------
@@ -647,6 +1056,22 @@ PdfEncryptAESBase::~PdfEncryptAESBase()
     delete m_aes;
 }
 
+void PdfEncryptAESBase::BaseDecrypt(const unsigned char* key, int keylen,
+                                    const unsigned char* textin, pdf_long textlen,
+                                    unsigned char* textout, pdf_long &textoutlen) const
+{
+    // The first block is the initial vector
+    if( textlen < 16 ) 
+    {
+        textoutlen = 0;
+        return;
+    }
+
+    PdfAESStream stream( false, key, keylen, textin );
+    textoutlen  = stream.Update( textin + 16, textlen - 16, textout );
+    textoutlen += stream.Final( textout + textoutlen );
+}
+
 int PdfEncrypt::GetEnabledEncryptionAlgorithms()
 {
     return PdfEncrypt::s_nEnabledEncryptionAlgorithms;
@@ -943,6 +1368,7 @@ PdfEncryptSHABase::ComputeEncryptionKey()
 bool PdfEncryptAESV3::Authenticate( const std::string & password, const PdfString & )
 {
     bool ok = false;
+    bool owner = false;
     
     // Prepare password
     unsigned char pswd_sasl[127];
@@ -977,11 +1403,35 @@ bool PdfEncryptAESV3::Authenticate( const std::string & password, const PdfStrin
         ok = CheckKey(hashValue, m_oValue);
         
         if(ok)
+        {
             m_ownerPass = password;
+            owner = true;
+        }
     }
     else
         m_userPass = password;
     
+    if(ok)
+    {
+        // Generate hash for UE or OE
+        SHA256_Init(&context);
+        SHA256_Update(&context, pswd_sasl, pswdLen);
+        SHA256_Update(&context, keySalt, 8);
+        if(owner)
+            SHA256_Update(&context, m_uValue, 48);
+        SHA256_Final(hashValue, &context);
+        
+        // Decode the file encryption key from UE or OE with key=hash
+        // CBC mode, no padding, init vector=0
+        int ret = m_aes->init( PdfRijndael::CBC, PdfRijndael::Decrypt, hashValue, PdfRijndael::Key32Bytes);
+        if(ret < 0)
+            PODOFO_RAISE_ERROR_INFO( ePdfError_InternalLogic, "Error initializing AES encryption engine" );
+        
+        ret = m_aes->blockDecrypt(owner ? m_oeValue : m_ueValue, m_eKeyLength, m_encryptionKey);
+        if (ret < 0)
+            PdfError::DebugMessage( "PdfEncrypt::AES: Error on decrypting." );
+    }
+    
     // TODO Validate permissions (or not...)
     
     return ok;
@@ -1395,12 +1845,31 @@ PdfEncryptAESV2::Encrypt(unsigned char* str, pdf_long len) const
     const_cast<PdfEncryptAESV2*>(this)->AES(objkey, keylen, str, len, str);
 }
 
+void
+PdfEncryptAESV2::Decrypt(const unsigned char* inStr, pdf_long inLen,
+                         unsigned char* outStr, pdf_long & outLen) const
+{
+    unsigned char objkey[MD5_HASHBYTES];
+    int keylen;
+    
+    CreateObjKey( objkey, &keylen );
+    
+    BaseDecrypt(objkey, keylen, inStr, inLen, outStr, outLen);
+}
+
 #ifdef PODOFO_HAVE_CRYPTO_LIBS
 void
 PdfEncryptAESV3::Encrypt(unsigned char* str, pdf_long len) const
 {
     const_cast<PdfEncryptAESV3*>(this)->AES(const_cast<unsigned char*>(m_encryptionKey), m_keyLength, str, len, str);
 }
+
+void
+PdfEncryptAESV3::Decrypt(const unsigned char* inStr, pdf_long inLen,
+                         unsigned char* outStr, pdf_long & outLen) const
+{
+    BaseDecrypt(m_encryptionKey, m_keyLength, inStr, inLen, outStr, outLen);
+}
 #endif // PODOFO_HAVE_CRYPTO_LIBS
 
 PdfEncryptAESV2::PdfEncryptAESV2( const std::string & userPassword, const std::string & ownerPassword, int protection) : PdfEncryptAESBase()
@@ -1519,57 +1988,49 @@ PdfEncryptRC4::CalculateStreamLength(pdf_long length) const
 }
 
 void
-PdfEncryptAESV2::AES(unsigned char* key, int,
+PdfEncryptAESV2::AES(unsigned char* key, int keylen,
                      unsigned char* textin, pdf_long textlen,
                      unsigned char* textout)
 {
     GenerateInitialVector(textout);
     
-    int ret = m_aes->init( PdfRijndael::CBC, PdfRijndael::Encrypt, key, PdfRijndael::Key16Bytes, textout);
-    if(ret < 0)
-        PODOFO_RAISE_ERROR_INFO( ePdfError_InternalLogic, "Error initializing AES encryption engine" );
-    
     pdf_long offset = CalculateStreamOffset();
     
-    ret = m_aes->padEncrypt(&textin[offset], textlen, &textout[offset]);
-    if (ret < 0)
-        PdfError::DebugMessage( "PdfEncryptAESV2::AES: Error on encrypting." );
+    PdfAESStream stream( true, key, keylen, textout );
+    pdf_long written = stream.Update( &textin[offset], textlen, &textout[offset] );
+    stream.Final( &textout[offset + written] );
 }
 
 #ifdef PODOFO_HAVE_CRYPTO_LIBS
 void
-PdfEncryptAESV3::AES(unsigned char* key, int,
+PdfEncryptAESV3::AES(unsigned char* key, int keylen,
                      unsigned char* textin, pdf_long textlen,
                      unsigned char* textout)
 {
     GenerateInitialVector(textout);
     
-    int ret = m_aes->init( PdfRijndael::CBC, PdfRijndael::Encrypt, key, PdfRijndael::Key32Bytes, textout);
-    if(ret < 0)
-        PODOFO_RAISE_ERROR_INFO( ePdfError_InternalLogic, "Error initializing AES encryption engine" );
-    
     pdf_long offset = CalculateStreamOffset();
     
-    ret = m_aes->padEncrypt(&textin[offset], textlen, &textout[offset]);
-    if (ret < 0)
-        PdfError::DebugMessage( "PdfEncryptAESV3::AES: Error on encrypting." );
+    PdfAESStream stream( true, key, keylen, textout );
+    pdf_long written = stream.Update( &textin[offset], textlen, &textout[offset] );
+    stream.Final( &textout[offset + written] );
 }
 #endif // PODOFO_HAVE_CRYPTO_LIBS
 
-PdfInputStream* PdfEncryptAESV2::CreateEncryptionInputStream( PdfInputStream* )
+PdfInputStream* PdfEncryptAESV2::CreateEncryptionInputStream( PdfInputStream* pInputStream, pdf_long lInputLen )
 {
-    /*unsigned char objkey[MD5_HASHBYTES];
+    unsigned char objkey[MD5_HASHBYTES];
     int keylen;
     
-    this->CreateObjKey( objkey, &keylen );*/
+    this->CreateObjKey( objkey, &keylen );
     
-    PODOFO_RAISE_ERROR_INFO( ePdfError_InternalLogic, "CreateEncryptionInputStream does not yet support AESV2" );
+    return new PdfAESInputStream( pInputStream, lInputLen, objkey, keylen );
 }
 
 #ifdef PODOFO_HAVE_CRYPTO_LIBS
-PdfInputStream* PdfEncryptAESV3::CreateEncryptionInputStream( PdfInputStream* )
+PdfInputStream* PdfEncryptAESV3::CreateEncryptionInputStream( PdfInputStream* pInputStream, pdf_long lInputLen )
 {
-    PODOFO_RAISE_ERROR_INFO( ePdfError_InternalLogic, "CreateEncryptionInputStream does not yet support AESV3" );
+    return new PdfAESInputStream( pInputStream, lInputLen, m_encryptionKey, m_keyLength );
 }
 #endif // PODOFO_HAVE_CRYPTO_LIBS
 
@@ -1648,20 +2109,26 @@ void PdfEncryptSHABase::CreateEncryptionDictionary( PdfDictionary & rDictionary
 }
 
 
-PdfOutputStream* PdfEncryptAESV3::CreateEncryptionOutputStream( PdfOutputStream* )
+PdfOutputStream* PdfEncryptAESV3::CreateEncryptionOutputStream( PdfOutputStream* pOutputStream )
 {
-    PODOFO_RAISE_ERROR_INFO( ePdfError_InternalLogic, "CreateEncryptionOutputStream does not yet support AESV3" );
+    unsigned char iv[16];
+    
+    this->GenerateInitialVector( iv );
+    
+    return new PdfAESOutputStream( pOutputStream, m_encryptionKey, m_keyLength, iv );
 }
 #endif // PODOFO_HAVE_CRYPTO_LIBS
 
-PdfOutputStream* PdfEncryptAESV2::CreateEncryptionOutputStream( PdfOutputStream* )
+PdfOutputStream* PdfEncryptAESV2::CreateEncryptionOutputStream( PdfOutputStream* pOutputStream )
 {
-    /*unsigned char objkey[MD5_HASHBYTES];
+    unsigned char objkey[MD5_HASHBYTES];
+    unsigned char iv[16];
     int keylen;
     
-    this->CreateObjKey( objkey, &keylen );*/
+    this->CreateObjKey( objkey, &keylen );
+    this->GenerateInitialVector( iv );
     
-    PODOFO_RAISE_ERROR_INFO( ePdfError_InternalLogic, "CreateEncryptionOutputStream does not yet support AESV3" );
+    return new PdfAESOutputStream( pOutputStream, objkey, keylen, iv );
 }
 
 void
@@ -1675,7 +2142,21 @@ PdfEncryptRC4::Encrypt(unsigned char* str, pdf_long len) const
     const_cast<PdfEncryptRC4*>(this)->RC4(objkey, keylen, str, len, str);  
 }
 
-PdfInputStream* PdfEncryptRC4::CreateEncryptionInputStream( PdfInputStream* pInputStream )
+void
+PdfEncryptRC4::Decrypt(const unsigned char* inStr, pdf_long inLen,
+                       unsigned char* outStr, pdf_long & outLen) const
+{
+    unsigned char objkey[MD5_HASHBYTES];
+    int keylen;
+    
+    CreateObjKey( objkey, &keylen );
+    
+    memcpy( outStr, inStr, inLen );
+    const_cast<PdfEncryptRC4*>(this)->RC4(objkey, keylen, outStr, inLen, outStr);
+    outLen = inLen;
+}
+
+PdfInputStream* PdfEncryptRC4::CreateEncryptionInputStream( PdfInputStream* pInputStream, pdf_long )
 {
     unsigned char objkey[MD5_HASHBYTES];
     int keylen;
@@ -206,7 +206,9 @@ public:
     /** Create a PdfOutputStream that encrypts all data written to 
      *  it using the current settings of the PdfEncrypt object.
      *
-     *  Warning: Currently only RC4 based encryption is supported using output streams!
+     *  For AES based encryption the initial vector is written
+     *  when the stream is created and the padding when it is closed,
+     *  so that the written data is CalculateStreamLength() bytes long.
      *  
      *  \param pOutputStream the created PdfOutputStream writes all encrypted
      *         data to this output stream.
@@ -218,14 +220,18 @@ public:
     /** Create a PdfInputStream that decrypts all data read from 
      *  it using the current settings of the PdfEncrypt object.
      *
-     *  Warning: Currently only RC4 based encryption is supported using output streams!
+     *  AES encrypted data is read and decrypted in large blocks,
+     *  so that the returned stream may read ahead of the data
+     *  returned to the caller, but never more than lInputLen bytes.
      *  
      *  \param pInputStream the created PdfInputStream reads all decrypted
      *         data to this input stream.
+     *  \param lInputLen the number of encrypted bytes available in pInputStream
+     *         or -1 to read until the end of pInputStream
      *
      *  \returns a PdfInputStream that decrypts all data.
      */
-    virtual PdfInputStream* CreateEncryptionInputStream( PdfInputStream* pInputStream ) = 0;
+    virtual PdfInputStream* CreateEncryptionInputStream( PdfInputStream* pInputStream, pdf_long lInputLen = -1 ) = 0;
 
     /**
      * Tries to authenticate a user using either the user or owner password
@@ -338,6 +344,17 @@ public:
     /// Encrypt a character string
     virtual void Encrypt(unsigned char* str, pdf_long len) const = 0;
     
+    /** Decrypt a character string
+     *
+     *  \param inStr the encrypted data, including the initial vector for AES
+     *  \param inLen the length of inStr
+     *  \param outStr the decrypted data is written to this buffer, which
+     *         has to be at least inLen bytes large and must not overlap inStr
+     *  \param outLen the number of decrypted bytes is stored here
+     */
+    virtual void Decrypt(const unsigned char* inStr, pdf_long inLen,
+                         unsigned char* outStr, pdf_long & outLen) const = 0;
+    
     /// Calculate stream size
     virtual pdf_long CalculateStreamLength(pdf_long length) const = 0;
     
@@ -399,7 +416,7 @@ public:
      */ 
     virtual ~PdfEncryptSHABase() {};
     
-    virtual PdfInputStream* CreateEncryptionInputStream( PdfInputStream* pInputStream ) = 0;
+    virtual PdfInputStream* CreateEncryptionInputStream( PdfInputStream* pInputStream, pdf_long lInputLen = -1 ) = 0;
     virtual PdfOutputStream* CreateEncryptionOutputStream( PdfOutputStream* pOutputStream ) = 0;
     
     virtual void CreateEncryptionDictionary( PdfDictionary & rDictionary ) const;
@@ -409,6 +426,10 @@ public:
     /// Encrypt a character string
     virtual void Encrypt(unsigned char* str, pdf_long len) const = 0;
     
+    /// Decrypt a character string
+    virtual void Decrypt(const unsigned char* inStr, pdf_long inLen,
+                         unsigned char* outStr, pdf_long & outLen) const = 0;
+    
     virtual void GenerateEncryptionKey(const PdfString & documentId) = 0;
     
     /// Get the UE object value (user)
@@ -474,7 +495,7 @@ public:
      */ 
     virtual ~PdfEncryptMD5Base() {};
     
-    virtual PdfInputStream* CreateEncryptionInputStream( PdfInputStream* pInputStream ) = 0;
+    virtual PdfInputStream* CreateEncryptionInputStream( PdfInputStream* pInputStream, pdf_long lInputLen = -1 ) = 0;
     virtual PdfOutputStream* CreateEncryptionOutputStream( PdfOutputStream* pOutputStream ) = 0;
     
     virtual void CreateEncryptionDictionary( PdfDictionary & rDictionary ) const;
@@ -484,6 +505,10 @@ public:
     /// Encrypt a character string
     virtual void Encrypt(unsigned char* str, pdf_long len) const = 0;
     
+    /// Decrypt a character string
+    virtual void Decrypt(const unsigned char* inStr, pdf_long inLen,
+                         unsigned char* outStr, pdf_long & outLen) const = 0;
+    
     virtual void GenerateEncryptionKey(const PdfString & documentId) = 0;
     
     /** Create a PdfString of MD5 data generated from a buffer in memory.
@@ -560,7 +585,12 @@ protected:
              unsigned char* textin, pdf_long textlen,
              unsigned char* textout) = 0;
     
-    PdfRijndael*   m_aes;                ///< AES encryptor
+    /// AES decryption, textin starts with the initial vector
+    void BaseDecrypt(const unsigned char* key, int keylen,
+                     const unsigned char* textin, pdf_long textlen,
+                     unsigned char* textout, pdf_long &textoutlen) const;
+    
+    PdfRijndael*   m_aes;                ///< AES encryptor used to derive the AESV3 keys
 };
     
 /** A class that is used to encrypt a PDF file (AES-128)
@@ -594,7 +624,7 @@ public:
 	*/ 
 	virtual ~PdfEncryptAESV2() {};
     
-	virtual PdfInputStream* CreateEncryptionInputStream( PdfInputStream* pInputStream );
+	virtual PdfInputStream* CreateEncryptionInputStream( PdfInputStream* pInputStream, pdf_long lInputLen = -1 );
 	virtual PdfOutputStream* CreateEncryptionOutputStream( PdfOutputStream* pOutputStream );
     
     virtual bool Authenticate( const std::string & password, const PdfString & documentId );
@@ -602,6 +632,10 @@ public:
     /// Encrypt a character string
     virtual void Encrypt(unsigned char* str, pdf_long len) const;
     
+    /// Decrypt a character string
+    virtual void Decrypt(const unsigned char* inStr, pdf_long inLen,
+                         unsigned char* outStr, pdf_long & outLen) const;
+    
     virtual void GenerateEncryptionKey(const PdfString & documentId);
     
     virtual pdf_long CalculateStreamOffset() const;
@@ -646,7 +680,7 @@ public:
      */ 
     virtual ~PdfEncryptAESV3() {};
     
-    virtual PdfInputStream* CreateEncryptionInputStream( PdfInputStream* pInputStream );
+    virtual PdfInputStream* CreateEncryptionInputStream( PdfInputStream* pInputStream, pdf_long lInputLen = -1 );
     virtual PdfOutputStream* CreateEncryptionOutputStream( PdfOutputStream* pOutputStream );
     
     virtual bool Authenticate( const std::string & password, const PdfString & documentId );
@@ -654,6 +688,10 @@ public:
     /// Encrypt a character string
     virtual void Encrypt(unsigned char* str, pdf_long len) const;
     
+    /// Decrypt a character string
+    virtual void Decrypt(const unsigned char* inStr, pdf_long inLen,
+                         unsigned char* outStr, pdf_long & outLen) const;
+    
     virtual void GenerateEncryptionKey(const PdfString & documentId);
     
     virtual pdf_long CalculateStreamOffset() const;
@@ -705,8 +743,12 @@ public:
     
     /// Encrypt a character string
     virtual void Encrypt(unsigned char* str, pdf_long len) const;
+    
+    /// Decrypt a character string
+    virtual void Decrypt(const unsigned char* inStr, pdf_long inLen,
+                         unsigned char* outStr, pdf_long & outLen) const;
 
-	virtual PdfInputStream* CreateEncryptionInputStream( PdfInputStream* pInputStream );
+	virtual PdfInputStream* CreateEncryptionInputStream( PdfInputStream* pInputStream, pdf_long lInputLen = -1 );
 	virtual PdfOutputStream* CreateEncryptionOutputStream( PdfOutputStream* pOutputStream );
     
     virtual void GenerateEncryptionKey(const PdfString & documentId);
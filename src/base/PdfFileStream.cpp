@@ -60,6 +60,10 @@ void PdfFileStream::BeginAppendImpl( const TVecFilters & vecFilters )
         }
         else
             m_pStream        = PdfFilterFactory::CreateEncodeStream( vecFilters, m_pDeviceStream );
+
+        // Many small appends, e.g. from PdfPainter, are collected
+        // before they are passed to the encoder
+        m_pStream = new PdfBatchingOutputStream( m_pStream, true );
     }
     else 
     {
@@ -101,11 +105,9 @@ void PdfFileStream::EndAppendImpl()
         m_pDeviceStream = NULL;
     }
 
+    // The encryption stream has already written the initial vector
+    // and the padding, so the device length is the final length
     m_lLength = m_pDevice->GetLength() - m_lLenInitial;
-    if( m_pCurEncrypt ) 
-    {
-        m_lLength = m_pCurEncrypt->CalculateStreamLength(m_lLength);
-    }
     m_pLength->SetNumber( static_cast<long>(m_lLength) );
 }
 
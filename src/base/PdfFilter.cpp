@@ -94,6 +94,17 @@ class PdfFilteredEncodeStream : public PdfOutputStream{
             m_pOutputStream = NULL;
     }
 
+    /** Create a filtered output stream using an already configured filter.
+     *
+     *  \param pOutputStream write all data to this output stream after encoding the data.
+     *  \param filter use this filter for encoding, ownership is taken.
+     */
+    PdfFilteredEncodeStream( PdfOutputStream* pOutputStream, std::auto_ptr<PdfFilter> filter )
+        : m_pOutputStream( NULL ), m_filter( filter )
+    {
+        m_filter->BeginEncode( pOutputStream );
+    }
+
     virtual ~PdfFilteredEncodeStream()
     {
         delete m_pOutputStream;
@@ -281,15 +292,13 @@ std::auto_ptr<PdfFilter> PdfFilterFactory::Create( const EPdfFilter eFilter )
 #endif // PODOFO_HAVE_JPEG_LIB
 
         case ePdfFilter_CCITTFaxDecode:
-#ifdef PODOFO_HAVE_TIFF_LIB
             pFilter = new PdfCCITTFilter();
             break;
-#else
-            break;
-#endif // PODOFO_HAVE_TIFF_LIB
-
 
         case ePdfFilter_JBIG2Decode:
+            pFilter = new PdfJBIG2Filter();
+            break;
+
         case ePdfFilter_JPXDecode:
         case ePdfFilter_Crypt:
         default:
@@ -317,6 +326,20 @@ PdfOutputStream* PdfFilterFactory::CreateEncodeStream( const TVecFilters & filte
     return pFilter;
 }
 
+PdfOutputStream* PdfFilterFactory::CreateCCITTEncodeStream( PdfOutputStream* pStream, pdf_long lColumns )
+{
+    if( lColumns <= 0 ) 
+    {
+        PODOFO_RAISE_ERROR_INFO( ePdfError_ValueOutOfRange, "CCITTFaxDecode requires /Columns to be positive" );
+    }
+
+    PdfCCITTFilter* pCCITT = new PdfCCITTFilter();
+    std::auto_ptr<PdfFilter> filter( pCCITT );
+
+    pCCITT->SetEncodeColumns( lColumns );
+    return new PdfFilteredEncodeStream( pStream, filter );
+}
+
 PdfOutputStream* PdfFilterFactory::CreateDecodeStream( const TVecFilters & filters, PdfOutputStream* pStream,
                                                        const PdfDictionary* pDictionary ) 
 {
@@ -454,6 +454,23 @@ class PODOFO_API PdfFilterFactory {
      */
     static PdfOutputStream* CreateEncodeStream( const TVecFilters & filters, PdfOutputStream* pStream );
 
+    /** Create a PdfOutputStream that encodes all data written to it
+     *  as CCITT Group 4 data.
+     *
+     *  The CCITTFaxDecode filter cannot be used with CreateEncodeStream(),
+     *  because it needs to know the number of pixels per row.
+     *  The data written to the stream has to consist of rows of 1 bit pixels,
+     *  each starting at a byte boundary, where 0 is black.
+     *
+     *  The encoded stream has to get /DecodeParms with /K -1 and /Columns lColumns,
+     *  so that it can be decoded again.
+     *
+     *  \param pStream write all data to this PdfOutputStream after it has been encoded.
+     *  \param lColumns the number of pixels in each row
+     *  \returns a new PdfOutputStream that has to be deleted by the caller.
+     */
+    static PdfOutputStream* CreateCCITTEncodeStream( PdfOutputStream* pStream, pdf_long lColumns );
+
     /** Create a PdfOutputStream that applies a list of filters 
      *  on all data written to it.
      *
@@ -33,21 +33,10 @@ extern "C" {
 }
 #endif // PODOFO_HAVE_JPEG_LIB
 
+#include <algorithm>
 #include <stdlib.h>
 #include <string.h>
 
-#ifdef PODOFO_HAVE_TIFF_LIB
-extern "C" {
-#ifdef _WIN32		// For O_RDONLY
-    // TODO: DS
-#else
-#include <sys/types.h>
-#include <sys/stat.h>
-#include <fcntl.h>
-#endif
-}
-#endif // PODOFO_HAVE_TIFF_LIB
-
 
 #define LZW_TABLE_SIZE      4096
 
@@ -1081,147 +1070,1568 @@ jpeg_memory_src (j_decompress_ptr cinfo, const JOCTET * buffer, size_t bufsize)
 
 #endif // PODOFO_HAVE_JPEG_LIB
 
-#ifdef PODOFO_HAVE_TIFF_LIB
-
-#ifdef DS_CCITT_DEVELOPMENT_CODE
 // -------------------------------------------------------
-// 
+// CCITT
 // -------------------------------------------------------
-static tsize_t dummy_read(thandle_t, tdata_t, tsize_t)
-{
-    return 0;
-}
 
-// -------------------------------------------------------
-// 
-// -------------------------------------------------------
-static tsize_t dummy_write(thandle_t, tdata_t, tsize_t size)
-{
-    return size;
-}
+namespace {
 
-// -------------------------------------------------------
-// 
-// -------------------------------------------------------
-static toff_t dummy_seek(thandle_t, toff_t, int)
-{
+struct TFaxCode {
+    unsigned short nCode;
+    unsigned char  nBits;
+};
 
-}
+// White terminating codes for run lengths 0 to 63
+const TFaxCode s_faxWhiteTerm[64] = {
+    { 0x035,  8 }, { 0x007,  6 }, { 0x007,  4 }, { 0x008,  4 },
+    { 0x00b,  4 }, { 0x00c,  4 }, { 0x00e,  4 }, { 0x00f,  4 },
+    { 0x013,  5 }, { 0x014,  5 }, { 0x007,  5 }, { 0x008,  5 },
+    { 0x008,  6 }, { 0x003,  6 }, { 0x034,  6 }, { 0x035,  6 },
+    { 0x02a,  6 }, { 0x02b,  6 }, { 0x027,  7 }, { 0x00c,  7 },
+    { 0x008,  7 }, { 0x017,  7 }, { 0x003,  7 }, { 0x004,  7 },
+    { 0x028,  7 }, { 0x02b,  7 }, { 0x013,  7 }, { 0x024,  7 },
+    { 0x018,  7 }, { 0x002,  8 }, { 0x003,  8 }, { 0x01a,  8 },
+    { 0x01b,  8 }, { 0x012,  8 }, { 0x013,  8 }, { 0x014,  8 },
+    { 0x015,  8 }, { 0x016,  8 }, { 0x017,  8 }, { 0x028,  8 },
+    { 0x029,  8 }, { 0x02a,  8 }, { 0x02b,  8 }, { 0x02c,  8 },
+    { 0x02d,  8 }, { 0x004,  8 }, { 0x005,  8 }, { 0x00a,  8 },
+    { 0x00b,  8 }, { 0x052,  8 }, { 0x053,  8 }, { 0x054,  8 },
+    { 0x055,  8 }, { 0x024,  8 }, { 0x025,  8 }, { 0x058,  8 },
+    { 0x059,  8 }, { 0x05a,  8 }, { 0x05b,  8 }, { 0x04a,  8 },
+    { 0x04b,  8 }, { 0x032,  8 }, { 0x033,  8 }, { 0x034,  8 }
+};
 
-// -------------------------------------------------------
-// 
-// -------------------------------------------------------
-static int dummy_close(thandle_t)
-{
+// White make-up codes for run lengths 64 to 1728
+const TFaxCode s_faxWhiteMakeup[27] = {
+    { 0x01b,  5 }, { 0x012,  5 }, { 0x017,  6 }, { 0x037,  7 },
+    { 0x036,  8 }, { 0x037,  8 }, { 0x064,  8 }, { 0x065,  8 },
+    { 0x068,  8 }, { 0x067,  8 }, { 0x0cc,  9 }, { 0x0cd,  9 },
+    { 0x0d2,  9 }, { 0x0d3,  9 }, { 0x0d4,  9 }, { 0x0d5,  9 },
+    { 0x0d6,  9 }, { 0x0d7,  9 }, { 0x0d8,  9 }, { 0x0d9,  9 },
+    { 0x0da,  9 }, { 0x0db,  9 }, { 0x098,  9 }, { 0x099,  9 },
+    { 0x09a,  9 }, { 0x018,  6 }, { 0x09b,  9 }
+};
 
-}
+// Black terminating codes for run lengths 0 to 63
+const TFaxCode s_faxBlackTerm[64] = {
+    { 0x037, 10 }, { 0x002,  3 }, { 0x003,  2 }, { 0x002,  2 },
+    { 0x003,  3 }, { 0x003,  4 }, { 0x002,  4 }, { 0x003,  5 },
+    { 0x005,  6 }, { 0x004,  6 }, { 0x004,  7 }, { 0x005,  7 },
+    { 0x007,  7 }, { 0x004,  8 }, { 0x007,  8 }, { 0x018,  9 },
+    { 0x017, 10 }, { 0x018, 10 }, { 0x008, 10 }, { 0x067, 11 },
+    { 0x068, 11 }, { 0x06c, 11 }, { 0x037, 11 }, { 0x028, 11 },
+    { 0x017, 11 }, { 0x018, 11 }, { 0x0ca, 12 }, { 0x0cb, 12 },
+    { 0x0cc, 12 }, { 0x0cd, 12 }, { 0x068, 12 }, { 0x069, 12 },
+    { 0x06a, 12 }, { 0x06b, 12 }, { 0x0d2, 12 }, { 0x0d3, 12 },
+    { 0x0d4, 12 }, { 0x0d5, 12 }, { 0x0d6, 12 }, { 0x0d7, 12 },
+    { 0x06c, 12 }, { 0x06d, 12 }, { 0x0da, 12 }, { 0x0db, 12 },
+    { 0x054, 12 }, { 0x055, 12 }, { 0x056, 12 }, { 0x057, 12 },
+    { 0x064, 12 }, { 0x065, 12 }, { 0x052, 12 }, { 0x053, 12 },
+    { 0x024, 12 }, { 0x037, 12 }, { 0x038, 12 }, { 0x027, 12 },
+    { 0x028, 12 }, { 0x058, 12 }, { 0x059, 12 }, { 0x02b, 12 },
+    { 0x02c, 12 }, { 0x05a, 12 }, { 0x066, 12 }, { 0x067, 12 }
+};
 
-// -------------------------------------------------------
-// 
-// -------------------------------------------------------
-static toff_t dummy_size(thandle_t)
-{
+// Black make-up codes for run lengths 64 to 1728
+const TFaxCode s_faxBlackMakeup[27] = {
+    { 0x00f, 10 }, { 0x0c8, 12 }, { 0x0c9, 12 }, { 0x05b, 12 },
+    { 0x033, 12 }, { 0x034, 12 }, { 0x035, 12 }, { 0x06c, 13 },
+    { 0x06d, 13 }, { 0x04a, 13 }, { 0x04b, 13 }, { 0x04c, 13 },
+    { 0x04d, 13 }, { 0x072, 13 }, { 0x073, 13 }, { 0x074, 13 },
+    { 0x075, 13 }, { 0x076, 13 }, { 0x077, 13 }, { 0x052, 13 },
+    { 0x053, 13 }, { 0x054, 13 }, { 0x055, 13 }, { 0x05a, 13 },
+    { 0x05b, 13 }, { 0x064, 13 }, { 0x065, 13 }
+};
 
-}
-#endif
+// Make-up codes for run lengths 1792 to 2560 shared by both colors
+const TFaxCode s_faxExtMakeup[13] = {
+    { 0x008, 11 }, { 0x00c, 11 }, { 0x00d, 11 }, { 0x012, 12 },
+    { 0x013, 12 }, { 0x014, 12 }, { 0x015, 12 }, { 0x016, 12 },
+    { 0x017, 12 }, { 0x01c, 12 }, { 0x01d, 12 }, { 0x01e, 12 },
+    { 0x01f, 12 }
+};
 
-// -------------------------------------------------------
-// Actual filter code below
-// -------------------------------------------------------
-PdfCCITTFilter::PdfCCITTFilter()
-    : m_tiff( NULL )
-{
-}
+enum EFaxMode {
+    eFaxMode_Invalid = 0,
+    eFaxMode_Pass,
+    eFaxMode_Horizontal,
+    eFaxMode_V0,
+    eFaxMode_VR1,
+    eFaxMode_VR2,
+    eFaxMode_VR3,
+    eFaxMode_VL1,
+    eFaxMode_VL2,
+    eFaxMode_VL3
+};
 
-PdfCCITTFilter::~PdfCCITTFilter()
-{
-}
+// Two-dimensional mode codes, indexed by EFaxMode
+const TFaxCode s_faxModeCodes[10] = {
+    { 0x00, 0 }, { 0x01, 4 }, { 0x01, 3 }, { 0x01, 1 }, { 0x03, 3 },
+    { 0x03, 6 }, { 0x03, 7 }, { 0x02, 3 }, { 0x02, 6 }, { 0x02, 7 }
+};
 
-void PdfCCITTFilter::BeginEncodeImpl()
-{
-    PODOFO_RAISE_ERROR( ePdfError_UnsupportedFilter );
-}
+const unsigned int s_faxEOL     = 0x001;
+const int          s_faxEOLBits = 12;
 
-void PdfCCITTFilter::EncodeBlockImpl( const char*, pdf_long )
-{
-    PODOFO_RAISE_ERROR( ePdfError_UnsupportedFilter );
-}
+struct TFaxTableEntry {
+    short         nRun;  ///< run length or mode of the code
+    unsigned char nBits; ///< length of the code, 0 if the code is invalid
+};
 
-void PdfCCITTFilter::EndEncodeImpl()
+/** Lookup tables for decoding run length and mode codes.
+ *  The tables are indexed by the next 12 (white), 13 (black)
+ *  or 7 (mode) bits of the input.
+ */
+class PdfFaxTables {
+ public:
+    PdfFaxTables() 
+    {
+        memset( m_white, 0, sizeof(m_white) );
+        memset( m_black, 0, sizeof(m_black) );
+        memset( m_mode,  0, sizeof(m_mode) );
+
+        for( int i=0;i<64;i++ ) 
+        {
+            Fill( m_white, 12, s_faxWhiteTerm[i], i );
+            Fill( m_black, 13, s_faxBlackTerm[i], i );
+        }
+
+        for( int i=0;i<27;i++ ) 
+        {
+            Fill( m_white, 12, s_faxWhiteMakeup[i], (i + 1) * 64 );
+            Fill( m_black, 13, s_faxBlackMakeup[i], (i + 1) * 64 );
+        }
+
+        for( int i=0;i<13;i++ ) 
+        {
+            Fill( m_white, 12, s_faxExtMakeup[i], 1792 + i * 64 );
+            Fill( m_black, 13, s_faxExtMakeup[i], 1792 + i * 64 );
+        }
+
+        for( int i=eFaxMode_Pass;i<=eFaxMode_VL3;i++ ) 
+            Fill( m_mode, 7, s_faxModeCodes[i], i );
+    }
+
+    TFaxTableEntry m_white[1 << 12];
+    TFaxTableEntry m_black[1 << 13];
+    TFaxTableEntry m_mode[1 << 7];
+
+ private:
+    static void Fill( TFaxTableEntry* pTable, int nTableBits, const TFaxCode & code, int nRun ) 
+    {
+        const int nShift = nTableBits - code.nBits;
+        const int nFirst = code.nCode << nShift;
+        const int nLast  = (code.nCode + 1) << nShift;
+
+        for( int i=nFirst;i<nLast;i++ ) 
+        {
+            pTable[i].nRun  = static_cast<short>(nRun);
+            pTable[i].nBits = code.nBits;
+        }
+    }
+};
+
+const PdfFaxTables s_faxTables;
+
+/** Set or clear the bits nFrom (inclusive) to nTo (exclusive)
+ *  in a row of 1 bit pixels.
+ */
+void SetBitRange( unsigned char* pRow, int nFrom, int nTo, bool bSet )
 {
-    PODOFO_RAISE_ERROR( ePdfError_UnsupportedFilter );
+    while( nFrom < nTo && (nFrom & 7) ) 
+    {
+        const unsigned char cMask = static_cast<unsigned char>(0x80 >> (nFrom & 7));
+        pRow[nFrom >> 3] = bSet ? (pRow[nFrom >> 3] | cMask) : (pRow[nFrom >> 3] & ~cMask);
+        ++nFrom;
+    }
+
+    if( nTo - nFrom >= 8 ) 
+    {
+        const int nBytes = (nTo - nFrom) >> 3;
+        memset( pRow + (nFrom >> 3), bSet ? 0xFF : 0x00, nBytes );
+        nFrom += nBytes << 3;
+    }
+
+    while( nFrom < nTo ) 
+    {
+        const unsigned char cMask = static_cast<unsigned char>(0x80 >> (nFrom & 7));
+        pRow[nFrom >> 3] = bSet ? (pRow[nFrom >> 3] | cMask) : (pRow[nFrom >> 3] & ~cMask);
+        ++nFrom;
+    }
 }
 
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wunused-parameter"
-void PdfCCITTFilter::BeginDecodeImpl( const PdfDictionary* pDict )
-{ 
-#ifdef DS_CCITT_DEVELOPMENT_CODE
+} // end anonymous namespace
 
-    if( !pDict )
+/** 
+ * Decoder for CCITT Group 3 and Group 4 encoded data.
+ *
+ * Data is appended as it arrives and decoded one row at a time.
+ * A row is only returned once all of its bits are available, so
+ * the decoder can be used from DecodeBlockImpl() with arbitrarily
+ * split input. Each row is stored as a list of changing elements
+ * (the end position of every run, starting with a white run)
+ * as described in ITU-T T.4 and T.6.
+ */
+class PdfCCITTDecoder {
+ public:
+    PdfCCITTDecoder( int nColumns, int nRows, int nK, bool bEndOfLine, bool bByteAlign, 
+                     bool bEndOfBlock, bool bBlackIs1, int nDamagedRowsBeforeError )
+        : m_nBitPos( 0 ), m_bOverrun( false ), m_bRowError( false ), 
+          m_nColumns( nColumns ), m_nRows( nRows ), m_nK( nK ), 
+          m_bEndOfLine( bEndOfLine ), m_bByteAlign( bByteAlign ), m_bEndOfBlock( bEndOfBlock ),
+          m_bBlackIs1( bBlackIs1 ), m_nDamagedRowsBeforeError( nDamagedRowsBeforeError ),
+          m_nRow( 0 ), m_nDamagedRows( 0 ), m_bFinished( false ), 
+          m_codingLine( nColumns + 3, nColumns ), m_refLine( nColumns + 3, nColumns ),
+          m_nA0i( 0 ), m_row( (nColumns + 7) >> 3 )
     {
-        PODOFO_RAISE_ERROR_INFO( ePdfError_InvalidHandle, "PdfCCITTFilter required a DecodeParms dictionary" );
-    } 
+        if( nColumns <= 0 ) 
+        {
+            PODOFO_RAISE_ERROR_INFO( ePdfError_ValueOutOfRange, "CCITTFaxDecode requires /Columns to be positive" );
+        }
+    }
+
+    /** Append encoded data
+     */
+    void Append( const char* pBuffer, pdf_long lLen ) 
+    {
+        // Throw away data of rows which have been decoded already
+        const size_t nUsed = m_nBitPos >> 3;
+        if( nUsed >= PODOFO_FILTER_INTERNAL_BUFFER_SIZE ) 
+        {
+            m_data.erase( m_data.begin(), m_data.begin() + nUsed );
+            m_nBitPos -= nUsed << 3;
+        }
+
+        m_data.insert( m_data.end(), 
+                       reinterpret_cast<const unsigned char*>(pBuffer), 
+                       reinterpret_cast<const unsigned char*>(pBuffer) + lLen );
+    }
+
+    /** Decode the next row.
+     *
+     *  \param bFinal if true all data has been appended and missing
+     *                bits at the end of the data are treated as zero.
+     *  \returns true if a row was decoded and is available using GetRow().
+     *           false if more data is needed or the end of data was reached.
+     */
+    bool DecodeRow( bool bFinal )
+    {
+        if( m_bFinished )
+            return false;
+
+        if( m_nRows > 0 && m_nRow >= m_nRows ) 
+        {
+            m_bFinished = true;
+            return false;
+        }
+
+        const size_t nStart = m_nBitPos;
+        m_bOverrun  = false;
+        m_bRowError = false;
+
+        bool b2D  = (m_nK < 0);
+        bool bEnd = !ReadRowStart( &b2D );
+        if( !bEnd && bFinal && !HasData() ) 
+            bEnd = true;
+
+        bool bOk = true;
+        if( !bEnd ) 
+            bOk = (b2D ? Decode2D() : Decode1D()) && !m_bRowError;
+
+        if( m_bOverrun && !bFinal ) 
+        {
+            // Wait for the remaining bits of this row
+            m_nBitPos = nStart;
+            return false;
+        }
+
+        if( bEnd ) 
+        {
+            m_bFinished = true;
+            return false;
+        }
+
+        if( !bOk ) 
+        {
+            if( !m_bEndOfLine || ++m_nDamagedRows > m_nDamagedRowsBeforeError ) 
+            {
+                PODOFO_RAISE_ERROR_INFO( ePdfError_InvalidStream, "Corrupted data in CCITTFaxDecode stream" );
+            }
+
+            // Output the damaged row as white and continue at the next EOL
+            m_codingLine[0] = m_nColumns;
+            m_nA0i          = 0;
+            while( m_nBitPos < m_data.size() << 3 && PeekBits( s_faxEOLBits ) != s_faxEOL ) 
+                SkipBits( 1 );
+        }
+
+        FillRow();
+
+        // The current row becomes the reference row of the next one
+        std::copy( m_codingLine.begin(), m_codingLine.begin() + m_nA0i + 1, m_refLine.begin() );
+        std::fill( m_refLine.begin() + m_nA0i + 1, m_refLine.end(), m_nColumns );
+        ++m_nRow;
+
+        return true;
+    }
+
+    inline const unsigned char* GetRow() const 
+    {
+        return &(m_row[0]);
+    }
+
+    inline pdf_long GetRowLength() const 
+    {
+        return static_cast<pdf_long>(m_row.size());
+    }
+
+ private:
+    inline unsigned int PeekBits( int nBits ) 
+    {
+        const size_t nByte  = m_nBitPos >> 3;
+        const int    nShift = static_cast<int>(m_nBitPos & 7);
+        const size_t nSize  = m_data.size();
+
+        unsigned int nValue = 0;
+        if( nByte + 4 <= nSize ) 
+        {
+            nValue = (static_cast<unsigned int>(m_data[nByte]) << 24) | (m_data[nByte+1] << 16) | 
+                     (m_data[nByte+2] << 8) | m_data[nByte+3];
+        }
+        else
+        {
+            for( size_t i=nByte;i<nByte+4;i++ ) 
+                nValue = (nValue << 8) | (i < nSize ? m_data[i] : 0);
+        }
+
+        if( m_nBitPos + nBits > nSize << 3 ) 
+            m_bOverrun = true;
 
-    m_tiff = TIFFClientOpen("podofo", "w", reinterpret_cast<thandle_t>(-1),
-                            dummy_read, dummy_write,
-                            dummy_seek, dummy_close, dummy_size, NULL, NULL);
+        return (nValue >> (32 - nShift - nBits)) & ((1u << nBits) - 1);
+    }
 
-    if( !m_tiff ) 
+    inline void SkipBits( int nBits ) 
     {
-        PODOFO_RAISE_ERROR_INFO( ePdfError_InvalidHandle, "TIFFClientOpen failed" );
+        m_nBitPos += nBits;
     }
 
-    m_tiff->tif_mode = O_RDONLY;
+    /** \returns true if any of the remaining bits is set
+     */
+    bool HasData() const
+    {
+        size_t nByte = m_nBitPos >> 3;
+        if( nByte >= m_data.size() ) 
+            return false;
+
+        if( m_data[nByte] & (0xFF >> (m_nBitPos & 7)) )
+            return true;
 
-    TIFFSetField(m_tiff, TIFFTAG_IMAGEWIDTH,      pDict->GetKeyAsLong( PdfName("Columns"), 1728 )->GetNumber() );
-    TIFFSetField(m_tiff, TIFFTAG_SAMPLESPERPIXEL, 1);
-    TIFFSetField(m_tiff, TIFFTAG_BITSPERSAMPLE,   1);
-    TIFFSetField(m_tiff, TIFFTAG_FILLORDER,       FILLORDER_LSB2MSB);
-    TIFFSetField(m_tiff, TIFFTAG_PLANARCONFIG,    PLANARCONFIG_CONTIG);
-    TIFFSetField(m_tiff, TIFFTAG_PHOTOMETRIC,     PHOTOMETRIC_MINISWHITE);
-    TIFFSetField(m_tiff, TIFFTAG_YRESOLUTION,     196.);
-    TIFFSetField(m_tiff, TIFFTAG_RESOLUTIONUNIT,  RESUNIT_INCH);
+        for( ++nByte; nByte < m_data.size(); ++nByte ) 
+            if( m_data[nByte] ) 
+                return true;
 
-    /*
-    m_tiff->tif_scanlinesize = TIFFSetField(m_tiff );
+        return false;
+    }
 
-    if( pDict ) 
+    /** Handle EOL markers, byte alignment, the 1D/2D tag bit and the
+     *  end of block marker in front of the next row.
+     *
+     *  \param pb2D set to true if the next row is 2D encoded
+     *  \returns false if the end of the data has been reached
+     */
+    bool ReadRowStart( bool* pb2D ) 
     {
-        long lEncoding = pDict->GetKeyAsLong( PdfName("K"), 0 );
-        if( lEncoding == 0 ) // pure 1D encoding, Group3 1D
+        const size_t nTotal = m_data.size() << 3;
+        bool bGotEOL = false;
+
+        if( !m_nRow ) 
+        {
+            // Skip leading fill bits and an optional EOL
+            while( m_nBitPos < nTotal && PeekBits( s_faxEOLBits ) == 0 ) 
+                SkipBits( 1 );
+
+            if( PeekBits( s_faxEOLBits ) == s_faxEOL ) 
+            {
+                SkipBits( s_faxEOLBits );
+                m_bEndOfLine = true;
+            }
+        }
+        else
         {
-            TIFFSetField(faxTIFF,TIFFTAG_GROUP3OPTIONS, GROUP3OPT_1DENCODING);
+            if( m_bEndOfLine || !m_bByteAlign ) 
+            {
+                unsigned int nCode = PeekBits( s_faxEOLBits );
+                while( m_nBitPos < nTotal && (m_bEndOfLine ? nCode != s_faxEOL : nCode == 0) ) 
+                {
+                    SkipBits( 1 );
+                    nCode = PeekBits( s_faxEOLBits );
+                }
+
+                if( nCode == s_faxEOL ) 
+                {
+                    SkipBits( s_faxEOLBits );
+                    bGotEOL = true;
+                }
+            }
+
+            if( m_bByteAlign && !bGotEOL ) 
+                m_nBitPos = (m_nBitPos + 7) & ~static_cast<size_t>(7);
+        }
 
+        if( m_nBitPos >= nTotal ) 
+        {
+            m_bOverrun = true;
+            return false;
         }
-        else if( lEncoding < 0 ) // pure 2D encoding, Group4
+
+        if( m_nK > 0 ) 
         {
-            TIFFSetField(faxTIFF,TIFFTAG_GROUP4OPTIONS, GROUP4OPT_2DENCODING);
+            *pb2D = !PeekBits( 1 );
+            SkipBits( 1 );
         }
-        else //if( lEncoding > 0 )  // mixed, Group3 2D
+
+        if( m_nRow && m_bEndOfBlock ) 
         {
-            TIFFSetField(faxTIFF,TIFFTAG_GROUP3OPTIONS, GROUP3OPT_2DENCODING);
+            if( !m_bEndOfLine && m_bByteAlign && PeekBits( 24 ) == ((s_faxEOL << 12) | s_faxEOL) ) 
+            {
+                SkipBits( s_faxEOLBits );
+                bGotEOL = true;
+            }
+
+            // A second EOL marks the end of the data (EOFB or RTC)
+            if( bGotEOL && PeekBits( s_faxEOLBits ) == s_faxEOL ) 
+                return false;
         }
 
+        return true;
     }
-    */
 
-#endif // DS_CCITT_DEVELOPMENT_CODE
+    /** Decode a run length of the given color
+     *  \returns the run length or -1 on an invalid code
+     */
+    inline int DecodeRun( int nBlack ) 
+    {
+        int nRun = 0;
+        for( ;; ) 
+        {
+            const TFaxTableEntry & entry = nBlack ? 
+                s_faxTables.m_black[PeekBits( 13 )] : s_faxTables.m_white[PeekBits( 12 )];
+            if( !entry.nBits ) 
+                return -1;
 
+            SkipBits( entry.nBits );
+            nRun += entry.nRun;
 
-}
-#pragma GCC diagnostic pop
+            if( entry.nRun < 64 ) 
+                return nRun;
+        }
+    }
+
+    /** Append the run of color nBlack which ends at a1 to the coding line.
+     */
+    inline void AddPixels( int a1, int nBlack ) 
+    {
+        if( a1 > m_codingLine[m_nA0i] ) 
+        {
+            if( a1 > m_nColumns ) 
+            {
+                m_bRowError = true;
+                a1 = m_nColumns;
+            }
+
+            if( (m_nA0i & 1) ^ nBlack ) 
+                ++m_nA0i;
+
+            m_codingLine[m_nA0i] = a1;
+        }
+    }
+
+    /** Like AddPixels() but a1 might be left of the current position.
+     */
+    inline void AddPixelsNeg( int a1, int nBlack ) 
+    {
+        if( a1 > m_codingLine[m_nA0i] ) 
+        {
+            AddPixels( a1, nBlack );
+        }
+        else if( a1 < m_codingLine[m_nA0i] ) 
+        {
+            if( a1 < 0 ) 
+            {
+                m_bRowError = true;
+                a1 = 0;
+            }
+
+            while( m_nA0i > 0 && a1 <= m_codingLine[m_nA0i - 1] ) 
+                --m_nA0i;
+
+            m_codingLine[m_nA0i] = a1;
+        }
+    }
+
+    bool Decode1D() 
+    {
+        int nBlack = 0;
+
+        m_codingLine[0] = 0;
+        m_nA0i          = 0;
+        while( m_codingLine[m_nA0i] < m_nColumns && !m_bRowError ) 
+        {
+            const int nRun = DecodeRun( nBlack );
+            if( nRun < 0 ) 
+                return false;
+
+            AddPixels( m_codingLine[m_nA0i] + nRun, nBlack );
+            nBlack ^= 1;
+        }
+
+        return true;
+    }
+
+    bool Decode2D() 
+    {
+        const std::vector<int> & ref = m_refLine;
+        int nBlack = 0;
+        int b1     = 0;
+
+        m_codingLine[0] = 0;
+        m_nA0i          = 0;
+        while( m_codingLine[m_nA0i] < m_nColumns && !m_bRowError ) 
+        {
+            const TFaxTableEntry & mode = s_faxTables.m_mode[PeekBits( 7 )];
+            if( !mode.nBits ) 
+                return false;
+
+            SkipBits( mode.nBits );
+            switch( mode.nRun ) 
+            {
+                case eFaxMode_Pass:
+                    AddPixels( ref[b1 + 1], nBlack );
+                    if( ref[b1 + 1] < m_nColumns ) 
+                        b1 += 2;
+                    break;
+
+                case eFaxMode_Horizontal:
+                {
+                    const int nRun1 = DecodeRun( nBlack );
+                    const int nRun2 = nRun1 < 0 ? -1 : DecodeRun( nBlack ^ 1 );
+                    if( nRun2 < 0 ) 
+                        return false;
+
+                    AddPixels( m_codingLine[m_nA0i] + nRun1, nBlack );
+                    if( m_codingLine[m_nA0i] < m_nColumns ) 
+                        AddPixels( m_codingLine[m_nA0i] + nRun2, nBlack ^ 1 );
+
+                    while( ref[b1] <= m_codingLine[m_nA0i] && ref[b1] < m_nColumns ) 
+                        b1 += 2;
+                    break;
+                }
+
+                case eFaxMode_V0:
+                case eFaxMode_VR1:
+                case eFaxMode_VR2:
+                case eFaxMode_VR3:
+                    AddPixels( ref[b1] + (mode.nRun - eFaxMode_V0), nBlack );
+                    nBlack ^= 1;
+                    if( m_codingLine[m_nA0i] < m_nColumns ) 
+                    {
+                        ++b1;
+                        while( ref[b1] <= m_codingLine[m_nA0i] && ref[b1] < m_nColumns ) 
+                            b1 += 2;
+                    }
+                    break;
+
+                case eFaxMode_VL1:
+                case eFaxMode_VL2:
+                case eFaxMode_VL3:
+                    AddPixelsNeg( ref[b1] - (mode.nRun - eFaxMode_VL1 + 1), nBlack );
+                    nBlack ^= 1;
+                    if( m_codingLine[m_nA0i] < m_nColumns ) 
+                    {
+                        if( b1 > 0 ) 
+                            --b1;
+                        else
+                            ++b1;
+
+                        while( ref[b1] <= m_codingLine[m_nA0i] && ref[b1] < m_nColumns ) 
+                            b1 += 2;
+                    }
+                    break;
+
+                default:
+                    return false;
+            }
+        }
 
-void PdfCCITTFilter::DecodeBlockImpl( const char*, pdf_long )
+        return true;
+    }
+
+    /** Convert the coding line into a row of 1 bit pixels
+     */
+    void FillRow() 
+    {
+        unsigned char* pRow = &(m_row[0]);
+        int            nX   = 0;
+
+        memset( pRow, m_bBlackIs1 ? 0x00 : 0xFF, m_row.size() );
+        for( int i=0;i<=m_nA0i;i++ ) 
+        {
+            if( i & 1 ) 
+                SetBitRange( pRow, nX, m_codingLine[i], m_bBlackIs1 );
+
+            nX = m_codingLine[i];
+        }
+    }
+
+ private:
+    std::vector<unsigned char> m_data;
+    size_t m_nBitPos;
+    bool   m_bOverrun;  ///< bits after the end of m_data were requested
+    bool   m_bRowError;
+
+    int  m_nColumns;
+    int  m_nRows;
+    int  m_nK;
+    bool m_bEndOfLine;
+    bool m_bByteAlign;
+    bool m_bEndOfBlock;
+    bool m_bBlackIs1;
+    int  m_nDamagedRowsBeforeError;
+
+    int  m_nRow;
+    int  m_nDamagedRows;
+    bool m_bFinished;
+
+    std::vector<int> m_codingLine;
+    std::vector<int> m_refLine;
+    int              m_nA0i;
+
+    std::vector<unsigned char> m_row;
+};
+
+PdfCCITTFilter::PdfCCITTFilter()
+    : m_pDecoder( NULL ), m_lColumns( 0 )
 {
+}
 
+PdfCCITTFilter::~PdfCCITTFilter()
+{
+    delete m_pDecoder;
 }
 
-void PdfCCITTFilter::EndDecodeImpl()
+void PdfCCITTFilter::BeginEncodeImpl()
 {
+    if( m_lColumns <= 0 ) 
+    {
+        PODOFO_RAISE_ERROR_INFO( ePdfError_UnsupportedFilter, "CCITTFaxDecode can only encode through PdfFilterFactory::CreateCCITTEncodeStream()" );
+    }
+
+    const int nColumns = static_cast<int>(m_lColumns);
+
+    m_row.assign( (nColumns + 7) >> 3, 0 );
+    m_lRowFill = 0;
+
+    // The imaginary row above the first row is white
+    m_refLine.assign( nColumns + 3, nColumns );
+    m_codingLine.assign( nColumns + 3, nColumns );
+
+    m_nBitBuffer  = 0;
+    m_nBitCount   = 0;
+    m_nBufferFill = 0;
 }
 
-#endif // PODOFO_HAVE_TIFF_LIB
+void PdfCCITTFilter::EncodeBlockImpl( const char* pBuffer, pdf_long lLen )
+{
+    const pdf_long lRowLen = static_cast<pdf_long>(m_row.size());
+
+    while( lLen ) 
+    {
+        if( !m_lRowFill && lLen >= lRowLen ) 
+        {
+            // Encode complete rows without copying them
+            EncodeRow( reinterpret_cast<const unsigned char*>(pBuffer) );
+            pBuffer += lRowLen;
+            lLen    -= lRowLen;
+            continue;
+        }
+
+        const pdf_long lCopy = PDF_MIN( lLen, lRowLen - m_lRowFill );
+        memcpy( &(m_row[m_lRowFill]), pBuffer, lCopy );
+        m_lRowFill += lCopy;
+        pBuffer    += lCopy;
+        lLen       -= lCopy;
+
+        if( m_lRowFill == lRowLen ) 
+        {
+            EncodeRow( &(m_row[0]) );
+            m_lRowFill = 0;
+        }
+    }
+}
+
+void PdfCCITTFilter::EndEncodeImpl()
+{
+    if( m_lRowFill ) 
+    {
+        // Pad an incomplete last row with white pixels
+        memset( &(m_row[m_lRowFill]), 0xFF, m_row.size() - m_lRowFill );
+        EncodeRow( &(m_row[0]) );
+        m_lRowFill = 0;
+    }
+
+    // EOFB
+    PutBits( s_faxEOL, s_faxEOLBits );
+    PutBits( s_faxEOL, s_faxEOLBits );
+    FlushBits();
+}
+
+void PdfCCITTFilter::EncodeRow( const unsigned char* pRow )
+{
+    const int nColumns = static_cast<int>(m_lColumns);
+
+    // Collect the changing elements of the row. 0 bits are black.
+    int* pCoding = &(m_codingLine[0]);
+    int  nCount  = 0;
+    int  nColor  = 0;
+    int  nX      = 0;
+    while( nX < nColumns ) 
+    {
+        const unsigned char cByte = pRow[nX >> 3];
+        if( !(nX & 7) && nX + 8 <= nColumns && cByte == (nColor ? 0x00 : 0xFF) ) 
+        {
+            // Whole byte has the current color
+            nX += 8;
+            continue;
+        }
+
+        const int nPixel = (cByte & (0x80 >> (nX & 7))) ? 0 : 1;
+        if( nPixel != nColor ) 
+        {
+            pCoding[nCount++] = nX;
+            nColor = nPixel;
+        }
+
+        ++nX;
+    }
+    
+    pCoding[nCount] = pCoding[nCount + 1] = pCoding[nCount + 2] = nColumns;
+
+    // Two-dimensional coding as described in ITU-T T.6
+    const int* pRef = &(m_refLine[0]);
+    int a0  = -1;
+    int nA  = 0;
+    int nB  = 0;
+    nColor  = 0;
+    while( a0 < nColumns ) 
+    {
+        while( pCoding[nA] <= a0 && pCoding[nA] < nColumns ) 
+            ++nA;
+
+        while( pRef[nB] <= a0 && pRef[nB] < nColumns ) 
+            ++nB;
+
+        // b1 has to be of the opposite color of a0,
+        // even changing elements start a black run
+        const int nB1 = nB + (((nB & 1) != nColor) ? 1 : 0);
+        const int a1  = pCoding[nA];
+        const int b1  = pRef[nB1];
+        const int b2  = pRef[nB1 + 1];
+
+        if( b2 < a1 ) 
+        {
+            PutBits( s_faxModeCodes[eFaxMode_Pass].nCode, s_faxModeCodes[eFaxMode_Pass].nBits );
+            a0 = b2;
+        }
+        else if( a1 - b1 <= 3 && b1 - a1 <= 3 ) 
+        {
+            const int nMode = a1 >= b1 ? eFaxMode_V0 + (a1 - b1) : eFaxMode_VL1 + (b1 - a1) - 1;
+            PutBits( s_faxModeCodes[nMode].nCode, s_faxModeCodes[nMode].nBits );
+            a0      = a1;
+            nColor ^= 1;
+        }
+        else
+        {
+            const int a2 = pCoding[nA + 1];
+
+            PutBits( s_faxModeCodes[eFaxMode_Horizontal].nCode, s_faxModeCodes[eFaxMode_Horizontal].nBits );
+            PutRun( a1 - PDF_MAX( a0, 0 ), nColor != 0 );
+            PutRun( a2 - a1, nColor == 0 );
+            a0 = a2;
+        }
+    }
+
+    m_refLine.swap( m_codingLine );
+}
+
+void PdfCCITTFilter::PutBits( unsigned int nCode, int nBits )
+{
+    m_nBitBuffer = (m_nBitBuffer << nBits) | nCode;
+    m_nBitCount += nBits;
+
+    while( m_nBitCount >= 8 ) 
+    {
+        m_nBitCount -= 8;
+        m_buffer[m_nBufferFill++] = static_cast<unsigned char>(m_nBitBuffer >> m_nBitCount);
+
+        if( m_nBufferFill == PODOFO_FILTER_INTERNAL_BUFFER_SIZE ) 
+        {
+            GetStream()->Write( reinterpret_cast<const char*>(m_buffer), m_nBufferFill );
+            m_nBufferFill = 0;
+        }
+    }
+}
+
+void PdfCCITTFilter::PutRun( int nRun, bool bBlack )
+{
+    const TFaxCode* pTerm   = bBlack ? s_faxBlackTerm   : s_faxWhiteTerm;
+    const TFaxCode* pMakeup = bBlack ? s_faxBlackMakeup : s_faxWhiteMakeup;
+
+    while( nRun >= 2560 ) 
+    {
+        PutBits( s_faxExtMakeup[12].nCode, s_faxExtMakeup[12].nBits );
+        nRun -= 2560;
+    }
+
+    if( nRun >= 1792 ) 
+    {
+        const TFaxCode & code = s_faxExtMakeup[(nRun - 1792) >> 6];
+        PutBits( code.nCode, code.nBits );
+    }
+    else if( nRun >= 64 ) 
+    {
+        const TFaxCode & code = pMakeup[(nRun >> 6) - 1];
+        PutBits( code.nCode, code.nBits );
+    }
+
+    PutBits( pTerm[nRun & 63].nCode, pTerm[nRun & 63].nBits );
+}
+
+void PdfCCITTFilter::FlushBits()
+{
+    if( m_nBitCount ) 
+        PutBits( 0, 8 - m_nBitCount );
+
+    if( m_nBufferFill ) 
+    {
+        GetStream()->Write( reinterpret_cast<const char*>(m_buffer), m_nBufferFill );
+        m_nBufferFill = 0;
+    }
+}
+
+void PdfCCITTFilter::BeginDecodeImpl( const PdfDictionary* pDecodeParms )
+{ 
+    long long lColumns    = 1728;
+    long long lRows       = 0;
+    long long lK          = 0;
+    long long lDamaged    = 0;
+    bool      bEndOfLine  = false;
+    bool      bByteAlign  = false;
+    bool      bEndOfBlock = true;
+    bool      bBlackIs1   = false;
+
+    if( pDecodeParms ) 
+    {
+        lColumns    = pDecodeParms->GetKeyAsLong( "Columns", lColumns );
+        lRows       = pDecodeParms->GetKeyAsLong( "Rows", lRows );
+        lK          = pDecodeParms->GetKeyAsLong( "K", lK );
+        lDamaged    = pDecodeParms->GetKeyAsLong( "DamagedRowsBeforeError", lDamaged );
+        bEndOfLine  = pDecodeParms->GetKeyAsBool( "EndOfLine", bEndOfLine );
+        bByteAlign  = pDecodeParms->GetKeyAsBool( "EncodedByteAlign", bByteAlign );
+        bEndOfBlock = pDecodeParms->GetKeyAsBool( "EndOfBlock", bEndOfBlock );
+        bBlackIs1   = pDecodeParms->GetKeyAsBool( "BlackIs1", bBlackIs1 );
+    }
+
+    if( lColumns <= 0 || lColumns > 0x100000 || lRows < 0 || lRows > 0x7FFFFFFF ) 
+    {
+        PODOFO_RAISE_ERROR_INFO( ePdfError_ValueOutOfRange, "Invalid /Columns or /Rows in CCITTFaxDecode parameters" );
+    }
+
+    delete m_pDecoder;
+    m_pDecoder = new PdfCCITTDecoder( static_cast<int>(lColumns), static_cast<int>(lRows), 
+                                      static_cast<int>(PDF_MAX( PDF_MIN( lK, 1LL ), -1LL )),
+                                      bEndOfLine, bByteAlign, bEndOfBlock, bBlackIs1, 
+                                      static_cast<int>(PDF_MIN( lDamaged, 0x7FFFFFFFLL )) );
+}
+
+void PdfCCITTFilter::DecodeBlockImpl( const char* pBuffer, pdf_long lLen )
+{
+    m_pDecoder->Append( pBuffer, lLen );
+    WriteDecodedRows( false );
+}
+
+void PdfCCITTFilter::EndDecodeImpl()
+{
+    WriteDecodedRows( true );
+
+    delete m_pDecoder;
+    m_pDecoder = NULL;
+}
+
+void PdfCCITTFilter::WriteDecodedRows( bool bFinal )
+{
+    while( m_pDecoder->DecodeRow( bFinal ) ) 
+        GetStream()->Write( reinterpret_cast<const char*>(m_pDecoder->GetRow()), m_pDecoder->GetRowLength() );
+}
+
+// -------------------------------------------------------
+// JBIG2
+// -------------------------------------------------------
+
+namespace {
+
+struct TMQState {
+    unsigned short nQe;
+    unsigned char  nNMPS;
+    unsigned char  nNLPS;
+    unsigned char  nSwitch;
+};
+
+// Probability estimation table of the MQ decoder (ITU-T T.88, table E.1)
+const TMQState s_mqStates[47] = {
+    { 0x5601,  1,  1, 1 }, { 0x3401,  2,  6, 0 }, { 0x1801,  3,  9, 0 }, { 0x0AC1,  4, 12, 0 },
+    { 0x0521,  5, 29, 0 }, { 0x0221, 38, 33, 0 }, { 0x5601,  7,  6, 1 }, { 0x5401,  8, 14, 0 },
+    { 0x4801,  9, 14, 0 }, { 0x3801, 10, 14, 0 }, { 0x3001, 11, 17, 0 }, { 0x2401, 12, 18, 0 },
+    { 0x1C01, 13, 20, 0 }, { 0x1601, 29, 21, 0 }, { 0x5601, 15, 14, 1 }, { 0x5401, 16, 14, 0 },
+    { 0x5101, 17, 15, 0 }, { 0x4801, 18, 16, 0 }, { 0x3801, 19, 17, 0 }, { 0x3401, 20, 18, 0 },
+    { 0x3001, 21, 19, 0 }, { 0x2801, 22, 19, 0 }, { 0x2401, 23, 20, 0 }, { 0x2201, 24, 21, 0 },
+    { 0x1C01, 25, 22, 0 }, { 0x1801, 26, 23, 0 }, { 0x1601, 27, 24, 0 }, { 0x1401, 28, 25, 0 },
+    { 0x1201, 29, 26, 0 }, { 0x1101, 30, 27, 0 }, { 0x0AC1, 31, 28, 0 }, { 0x09C1, 32, 29, 0 },
+    { 0x08A1, 33, 30, 0 }, { 0x0521, 34, 31, 0 }, { 0x0441, 35, 32, 0 }, { 0x02A1, 36, 33, 0 },
+    { 0x0221, 37, 34, 0 }, { 0x0141, 38, 35, 0 }, { 0x0111, 39, 36, 0 }, { 0x0085, 40, 37, 0 },
+    { 0x0049, 41, 38, 0 }, { 0x0025, 42, 39, 0 }, { 0x0015, 43, 40, 0 }, { 0x0009, 44, 41, 0 },
+    { 0x0005, 45, 42, 0 }, { 0x0001, 45, 43, 0 }, { 0x5601, 46, 46, 0 }
+};
+
+/** The arithmetic (MQ) decoder of ITU-T T.88, annex E.
+ *
+ *  A context is stored as one byte holding the state index
+ *  in the upper and the MPS value in the lowest bit.
+ */
+class PdfMQDecoder {
+ public:
+    PdfMQDecoder( const unsigned char* pData, size_t nLen )
+        : m_pData( pData ), m_nLen( nLen ), m_nPos( 0 )
+    {
+        m_nCHigh = GetByte( 0 );
+        m_nCLow  = 0;
+        ByteIn();
+        m_nCHigh = ((m_nCHigh << 7) & 0xFFFF) | ((m_nCLow >> 9) & 0x7F);
+        m_nCLow  = (m_nCLow << 7) & 0xFFFF;
+        m_nCT   -= 7;
+        m_nA     = 0x8000;
+    }
+
+    inline int DecodeBit( unsigned char & rContext ) 
+    {
+        unsigned int     nIndex = rContext >> 1;
+        int              nMPS   = rContext & 1;
+        const TMQState & state  = s_mqStates[nIndex];
+        unsigned int     nA     = m_nA - state.nQe;
+        int              nD;
+
+        if( m_nCHigh < state.nQe ) 
+        {
+            // LPS exchange
+            if( nA < state.nQe ) 
+            {
+                nD     = nMPS;
+                nIndex = state.nNMPS;
+            }
+            else
+            {
+                nD = 1 ^ nMPS;
+                if( state.nSwitch ) 
+                    nMPS = nD;
+                nIndex = state.nNLPS;
+            }
+            nA = state.nQe;
+        }
+        else
+        {
+            m_nCHigh -= state.nQe;
+            if( nA & 0x8000 ) 
+            {
+                m_nA = nA;
+                return nMPS;
+            }
+
+            // MPS exchange
+            if( nA < state.nQe ) 
+            {
+                nD = 1 ^ nMPS;
+                if( state.nSwitch ) 
+                    nMPS = nD;
+                nIndex = state.nNLPS;
+            }
+            else
+            {
+                nD     = nMPS;
+                nIndex = state.nNMPS;
+            }
+        }
+
+        // Renormalization
+        do {
+            if( !m_nCT ) 
+                ByteIn();
+
+            nA     <<= 1;
+            m_nCHigh = ((m_nCHigh << 1) & 0xFFFF) | ((m_nCLow >> 15) & 1);
+            m_nCLow  = (m_nCLow << 1) & 0xFFFF;
+            --m_nCT;
+        } while( !(nA & 0x8000) );
+
+        m_nA     = nA;
+        rContext = static_cast<unsigned char>((nIndex << 1) | nMPS);
+        return nD;
+    }
+
+ private:
+    inline unsigned int GetByte( size_t nPos ) const 
+    {
+        // The data is padded with 0xFF bytes
+        return nPos < m_nLen ? m_pData[nPos] : 0xFF;
+    }
+
+    void ByteIn() 
+    {
+        if( GetByte( m_nPos ) == 0xFF ) 
+        {
+            if( GetByte( m_nPos + 1 ) > 0x8F ) 
+            {
+                m_nCLow += 0xFF00;
+                m_nCT    = 8;
+            }
+            else
+            {
+                ++m_nPos;
+                m_nCLow += GetByte( m_nPos ) << 9;
+                m_nCT    = 7;
+            }
+        }
+        else
+        {
+            ++m_nPos;
+            m_nCLow += GetByte( m_nPos ) << 8;
+            m_nCT    = 8;
+        }
+
+        if( m_nCLow > 0xFFFF ) 
+        {
+            m_nCHigh += m_nCLow >> 16;
+            m_nCLow  &= 0xFFFF;
+        }
+    }
+
+ private:
+    const unsigned char* m_pData;
+    size_t               m_nLen;
+    size_t               m_nPos;
+
+    unsigned int m_nCHigh;
+    unsigned int m_nCLow;
+    unsigned int m_nA;
+    int          m_nCT;
+};
+
+struct TJBIG2Pixel {
+    int nX;
+    int nY;
+};
+
+// Fixed pixels of the generic region templates 0 to 3.
+// The adaptive pixels are read from the segment.
+const TJBIG2Pixel s_jbig2Template0[] = {
+    { -1, -2 }, {  0, -2 }, {  1, -2 }, { -2, -1 }, { -1, -1 }, {  0, -1 }, 
+    {  1, -1 }, {  2, -1 }, { -4,  0 }, { -3,  0 }, { -2,  0 }, { -1,  0 }
+};
+
+const TJBIG2Pixel s_jbig2Template1[] = {
+    { -1, -2 }, {  0, -2 }, {  1, -2 }, {  2, -2 }, { -2, -1 }, { -1, -1 }, 
+    {  0, -1 }, {  1, -1 }, {  2, -1 }, { -3,  0 }, { -2,  0 }, { -1,  0 }
+};
+
+const TJBIG2Pixel s_jbig2Template2[] = {
+    { -1, -2 }, {  0, -2 }, {  1, -2 }, { -2, -1 }, { -1, -1 }, {  0, -1 },
+    {  1, -1 }, { -2,  0 }, { -1,  0 }
+};
+
+const TJBIG2Pixel s_jbig2Template3[] = {
+    { -3, -1 }, { -2, -1 }, { -1, -1 }, {  0, -1 }, {  1, -1 }, { -4,  0 },
+    { -3,  0 }, { -2,  0 }, { -1,  0 }
+};
+
+// Context used for the typical prediction bit of each template
+const unsigned int s_jbig2TPGDContext[4] = { 0x9B25, 0x0795, 0x00E5, 0x0195 };
+
+enum EJBIG2Segment {
+    eJBIG2Segment_SymbolDictionary           = 0,
+    eJBIG2Segment_IntermediateTextRegion     = 4,
+    eJBIG2Segment_ImmediateTextRegion        = 6,
+    eJBIG2Segment_ImmediateLosslessTextRegion = 7,
+    eJBIG2Segment_PatternDictionary          = 16,
+    eJBIG2Segment_IntermediateHalftoneRegion = 20,
+    eJBIG2Segment_ImmediateHalftoneRegion    = 22,
+    eJBIG2Segment_ImmediateLosslessHalftoneRegion = 23,
+    eJBIG2Segment_IntermediateGenericRegion  = 36,
+    eJBIG2Segment_ImmediateGenericRegion     = 38,
+    eJBIG2Segment_ImmediateLosslessGenericRegion = 39,
+    eJBIG2Segment_IntermediateRefinementRegion = 40,
+    eJBIG2Segment_ImmediateRefinementRegion  = 42,
+    eJBIG2Segment_ImmediateLosslessRefinementRegion = 43,
+    eJBIG2Segment_PageInformation            = 48,
+    eJBIG2Segment_EndOfPage                  = 49,
+    eJBIG2Segment_EndOfStripe                = 50,
+    eJBIG2Segment_EndOfFile                  = 51
+};
+
+inline unsigned int ReadUInt32( const unsigned char* pData )
+{
+    return (static_cast<unsigned int>(pData[0]) << 24) | (pData[1] << 16) | (pData[2] << 8) | pData[3];
+}
+
+inline bool ComparePixels( const TJBIG2Pixel & rLhs, const TJBIG2Pixel & rRhs )
+{
+    return rLhs.nY < rRhs.nY || (rLhs.nY == rRhs.nY && rLhs.nX < rRhs.nX);
+}
+
+/** Decode an arithmetic coded generic region (ITU-T T.88, 6.2.5)
+ *  into pBitmap, which has one byte per pixel.
+ */
+void DecodeGenericRegion( const unsigned char* pData, size_t nLen, int nWidth, int nHeight, 
+                          int nTemplate, bool bTPGDON, const signed char* pAt, unsigned char* pBitmap )
+{
+    static const TJBIG2Pixel* s_templates[4]  = { s_jbig2Template0, s_jbig2Template1, s_jbig2Template2, s_jbig2Template3 };
+    static const int          s_nFixed[4]     = { 12, 12, 9, 9 };
+
+    std::vector<TJBIG2Pixel> pixels( s_templates[nTemplate], s_templates[nTemplate] + s_nFixed[nTemplate] );
+    const int nAt = nTemplate ? 1 : 4;
+    for( int i=0;i<nAt;i++ ) 
+    {
+        TJBIG2Pixel pixel = { pAt[2*i], pAt[2*i+1] };
+        if( pixel.nY > 0 || (pixel.nY == 0 && pixel.nX >= 0) ) 
+        {
+            PODOFO_RAISE_ERROR_INFO( ePdfError_InvalidStream, "Invalid adaptive template pixel in JBIG2 generic region" );
+        }
+        pixels.push_back( pixel );
+    }
+    std::sort( pixels.begin(), pixels.end(), ComparePixels );
+
+    // Decode into a bitmap with a border of white pixels,
+    // so that no bounds checks are needed for the context
+    int nPadX = 4;
+    int nPadY = 2;
+    for( size_t i=0;i<pixels.size();i++ ) 
+    {
+        nPadX = PDF_MAX( nPadX, pixels[i].nX < 0 ? -pixels[i].nX : pixels[i].nX );
+        nPadY = PDF_MAX( nPadY, -pixels[i].nY );
+    }
+
+    const size_t nStride = nWidth + 2 * nPadX;
+    std::vector<unsigned char> padded( nStride * (nHeight + nPadY), 0 );
+    std::vector<ptrdiff_t>     offsets( pixels.size() );
+    for( size_t i=0;i<pixels.size();i++ ) 
+        offsets[i] = static_cast<ptrdiff_t>(pixels[i].nY) * static_cast<ptrdiff_t>(nStride) + pixels[i].nX;
+
+    const size_t               nPixels = offsets.size();
+    const ptrdiff_t*           pOffsets = &(offsets[0]);
+    std::vector<unsigned char> contexts( static_cast<size_t>(1) << nPixels, 0 );
+    PdfMQDecoder               decoder( pData, nLen );
+    int                        nLTP = 0;
+
+    for( int y=0;y<nHeight;y++ ) 
+    {
+        unsigned char* pRow = &(padded[(y + nPadY) * nStride + nPadX]);
+
+        if( bTPGDON ) 
+        {
+            nLTP ^= decoder.DecodeBit( contexts[s_jbig2TPGDContext[nTemplate]] );
+            if( nLTP ) 
+            {
+                // Typical row: a copy of the row above
+                memcpy( pRow, pRow - nStride, nWidth );
+                continue;
+            }
+        }
+
+        for( int x=0;x<nWidth;x++ ) 
+        {
+            const unsigned char* pPixel = pRow + x;
+            unsigned int         nContext = 0;
+            for( size_t i=0;i<nPixels;i++ ) 
+                nContext = (nContext << 1) | pPixel[pOffsets[i]];
+
+            pRow[x] = static_cast<unsigned char>(decoder.DecodeBit( contexts[nContext] ));
+        }
+    }
+
+    for( int y=0;y<nHeight;y++ ) 
+        memcpy( pBitmap + static_cast<size_t>(y) * nWidth, &(padded[(y + nPadY) * nStride + nPadX]), nWidth );
+}
+
+} // end anonymous namespace
+
+/**
+ * Decoder for the embedded JBIG2 streams used by JBIG2Decode.
+ *
+ * Segments are decoded as soon as they have been received
+ * completely and composed into a page bitmap using one byte
+ * per pixel, where 1 is black.
+ */
+class PdfJBIG2Decoder {
+ public:
+    PdfJBIG2Decoder()
+        : m_nPos( 0 ), m_bPageInfo( false ), m_bStriped( false ), m_bEndOfPage( false ),
+          m_nPageWidth( 0 ), m_nPageHeight( 0 ), m_cDefaultPixel( 0 )
+    {
+    }
+
+    /** Append data and decode all completely received segments
+     */
+    void Append( const char* pBuffer, pdf_long lLen ) 
+    {
+        if( m_bEndOfPage ) 
+            return;
+
+        m_data.insert( m_data.end(), 
+                       reinterpret_cast<const unsigned char*>(pBuffer), 
+                       reinterpret_cast<const unsigned char*>(pBuffer) + lLen );
+
+        while( !m_bEndOfPage && ReadSegment() )
+            ;
+
+        if( m_nPos ) 
+        {
+            m_data.erase( m_data.begin(), m_data.begin() + m_nPos );
+            m_nPos = 0;
+        }
+    }
+
+    /** Write the page as rows of 1 bit pixels, 0 being black.
+     */
+    void WritePage( PdfOutputStream* pStream ) 
+    {
+        if( !m_bPageInfo ) 
+        {
+            PODOFO_RAISE_ERROR_INFO( ePdfError_InvalidStream, "JBIG2 stream has no page information segment" );
+        }
+
+        std::vector<unsigned char> row( (m_nPageWidth + 7) >> 3 );
+        for( unsigned int y=0;y<m_nPageHeight;y++ ) 
+        {
+            const unsigned char* pPixels = &(m_page[static_cast<size_t>(y) * m_nPageWidth]);
+
+            memset( &(row[0]), 0xFF, row.size() );
+            for( unsigned int x=0;x<m_nPageWidth;x++ ) 
+                if( pPixels[x] ) 
+                    row[x >> 3] &= ~(0x80 >> (x & 7));
+
+            pStream->Write( reinterpret_cast<const char*>(&(row[0])), static_cast<pdf_long>(row.size()) );
+        }
+    }
+
+ private:
+    /** Decode the next segment if it has been received completely
+     *  \returns true if a segment was decoded
+     */
+    bool ReadSegment() 
+    {
+        const unsigned char* pData  = &(m_data[0]) + m_nPos;
+        const size_t         nAvail = m_data.size() - m_nPos;
+
+        // Segment number, flags and the short form of the referred-to segment count
+        if( nAvail < 6 )
+            return false;
+
+        const unsigned int nNumber = ReadUInt32( pData );
+        const int          nType   = pData[4] & 0x3F;
+        const bool         bPage4  = (pData[4] & 0x40) != 0;
+        size_t             nRefs   = pData[5] >> 5;
+        size_t             n       = 6;
+
+        if( nRefs == 7 ) 
+        {
+            if( nAvail < 9 ) 
+                return false;
+
+            nRefs = ReadUInt32( pData + 5 ) & 0x1FFFFFFF;
+            n     = 9 + (nRefs + 8) / 8;
+        }
+
+        n += nRefs * (nNumber <= 256 ? 1 : (nNumber <= 65536 ? 2 : 4));
+        n += bPage4 ? 4 : 1;
+        if( nAvail < n + 4 ) 
+            return false;
+
+        const size_t nLen = ReadUInt32( pData + n );
+        n += 4;
+        if( nLen == 0xFFFFFFFF ) 
+        {
+            PODOFO_RAISE_ERROR_INFO( ePdfError_UnsupportedFilter, "JBIG2 segments of unknown length are not supported" );
+        }
+
+        if( nAvail - n < nLen ) 
+            return false;
+
+        DecodeSegment( nType, pData + n, nLen );
+        m_nPos += n + nLen;
+        return true;
+    }
+
+    void DecodeSegment( int nType, const unsigned char* pData, size_t nLen ) 
+    {
+        switch( nType ) 
+        {
+            case eJBIG2Segment_PageInformation:
+                ReadPageInformation( pData, nLen );
+                break;
+
+            case eJBIG2Segment_EndOfStripe:
+                if( nLen < 4 ) 
+                {
+                    PODOFO_RAISE_ERROR_INFO( ePdfError_InvalidStream, "Invalid JBIG2 end of stripe segment" );
+                }
+
+                if( m_bStriped ) 
+                    GrowPage( ReadUInt32( pData ) + 1 );
+                break;
+
+            case eJBIG2Segment_EndOfPage:
+            case eJBIG2Segment_EndOfFile:
+                m_bEndOfPage = true;
+                break;
+
+            case eJBIG2Segment_ImmediateGenericRegion:
+            case eJBIG2Segment_ImmediateLosslessGenericRegion:
+                ReadGenericRegion( pData, nLen );
+                break;
+
+            case eJBIG2Segment_IntermediateTextRegion:
+            case eJBIG2Segment_ImmediateTextRegion:
+            case eJBIG2Segment_ImmediateLosslessTextRegion:
+            case eJBIG2Segment_IntermediateHalftoneRegion:
+            case eJBIG2Segment_ImmediateHalftoneRegion:
+            case eJBIG2Segment_ImmediateLosslessHalftoneRegion:
+            case eJBIG2Segment_ImmediateRefinementRegion:
+            case eJBIG2Segment_ImmediateLosslessRefinementRegion:
+                PODOFO_RAISE_ERROR_INFO( ePdfError_UnsupportedFilter, 
+                                         "Only JBIG2 generic regions are supported" );
+                break;
+
+            default:
+                // Dictionaries, intermediate regions only used for refinement, 
+                // tables, profiles and extensions do not change the page
+                break;
+        }
+    }
+
+    void ReadPageInformation( const unsigned char* pData, size_t nLen ) 
+    {
+        if( nLen < 19 ) 
+        {
+            PODOFO_RAISE_ERROR_INFO( ePdfError_InvalidStream, "Invalid JBIG2 page information segment" );
+        }
+
+        if( m_bPageInfo ) 
+        {
+            // Only the first page is decoded
+            m_bEndOfPage = true;
+            return;
+        }
+
+        m_nPageWidth    = ReadUInt32( pData );
+        m_nPageHeight   = ReadUInt32( pData + 4 );
+        m_cDefaultPixel = (pData[16] >> 2) & 1;
+        m_bStriped      = (m_nPageHeight == 0xFFFFFFFF);
+        m_bPageInfo     = true;
+
+        if( m_bStriped ) 
+            m_nPageHeight = 0;
+
+        if( !m_nPageWidth || m_nPageWidth > 0x100000 || m_nPageHeight > 0x100000 ) 
+        {
+            PODOFO_RAISE_ERROR_INFO( ePdfError_ValueOutOfRange, "Unsupported JBIG2 page size" );
+        }
+
+        m_page.assign( static_cast<size_t>(m_nPageWidth) * m_nPageHeight, m_cDefaultPixel );
+    }
+
+    void GrowPage( unsigned int nHeight ) 
+    {
+        if( nHeight > 0x100000 ) 
+        {
+            PODOFO_RAISE_ERROR_INFO( ePdfError_ValueOutOfRange, "Unsupported JBIG2 page size" );
+        }
+
+        if( nHeight > m_nPageHeight ) 
+        {
+            m_nPageHeight = nHeight;
+            m_page.resize( static_cast<size_t>(m_nPageWidth) * m_nPageHeight, m_cDefaultPixel );
+        }
+    }
+
+    void ReadGenericRegion( const unsigned char* pData, size_t nLen ) 
+    {
+        if( !m_bPageInfo ) 
+        {
+            PODOFO_RAISE_ERROR_INFO( ePdfError_InvalidStream, "JBIG2 region segment before page information" );
+        }
+
+        // Region segment information field and generic region flags
+        if( nLen < 18 ) 
+        {
+            PODOFO_RAISE_ERROR_INFO( ePdfError_InvalidStream, "Invalid JBIG2 generic region segment" );
+        }
+
+        const unsigned int nWidth     = ReadUInt32( pData );
+        const unsigned int nHeight    = ReadUInt32( pData + 4 );
+        const unsigned int nX         = ReadUInt32( pData + 8 );
+        const unsigned int nY         = ReadUInt32( pData + 12 );
+        const int          nOperator  = pData[16] & 0x07;
+        const bool         bMMR       = (pData[17] & 0x01) != 0;
+        const int          nTemplate  = (pData[17] >> 1) & 0x03;
+        const bool         bTPGDON    = (pData[17] & 0x08) != 0;
+        size_t             nHeader    = 18;
+
+        if( nWidth > 0x100000 || nHeight > 0x100000 ) 
+        {
+            PODOFO_RAISE_ERROR_INFO( ePdfError_UnsupportedFilter, "Unsupported JBIG2 generic region size" );
+        }
+
+        const signed char* pAt = NULL;
+        if( !bMMR ) 
+        {
+            pAt      = reinterpret_cast<const signed char*>(pData + nHeader);
+            nHeader += nTemplate ? 2 : 8;
+            if( nLen < nHeader ) 
+            {
+                PODOFO_RAISE_ERROR_INFO( ePdfError_InvalidStream, "Invalid JBIG2 generic region segment" );
+            }
+        }
+
+        std::vector<unsigned char> region( static_cast<size_t>(nWidth) * nHeight, 0 );
+        if( region.empty() ) 
+            return;
+
+        if( bMMR ) 
+        {
+            PdfCCITTDecoder decoder( nWidth, nHeight, -1, false, false, true, true, 0 );
+            decoder.Append( reinterpret_cast<const char*>(pData + nHeader), static_cast<pdf_long>(nLen - nHeader) );
+
+            unsigned char* pPixels = &(region[0]);
+            while( decoder.DecodeRow( true ) ) 
+            {
+                const unsigned char* pRow = decoder.GetRow();
+                for( unsigned int x=0;x<nWidth;x++ ) 
+                    pPixels[x] = (pRow[x >> 3] >> (7 - (x & 7))) & 1;
+
+                pPixels += nWidth;
+            }
+        }
+        else
+        {
+            DecodeGenericRegion( pData + nHeader, nLen - nHeader, nWidth, nHeight, 
+                                 nTemplate, bTPGDON, pAt, &(region[0]) );
+        }
+
+        if( m_bStriped ) 
+            GrowPage( nY + nHeight );
+
+        ComposeRegion( region, nWidth, nHeight, nX, nY, nOperator );
+    }
+
+    void ComposeRegion( const std::vector<unsigned char> & rRegion, unsigned int nWidth, unsigned int nHeight,
+                        unsigned int nX, unsigned int nY, int nOperator ) 
+    {
+        if( nX >= m_nPageWidth || nY >= m_nPageHeight ) 
+            return;
+
+        const unsigned int nRight  = PDF_MIN( nX + nWidth, m_nPageWidth );
+        const unsigned int nBottom = PDF_MIN( nY + nHeight, m_nPageHeight );
+
+        for( unsigned int y=nY;y<nBottom;y++ ) 
+        {
+            const unsigned char* pSrc = &(rRegion[static_cast<size_t>(y - nY) * nWidth]);
+            unsigned char*       pDst = &(m_page[static_cast<size_t>(y) * m_nPageWidth + nX]);
+            const unsigned int   nCount = nRight - nX;
+
+            switch( nOperator ) 
+            {
+                case 0: // OR
+                    for( unsigned int i=0;i<nCount;i++ ) pDst[i] |= pSrc[i];
+                    break;
+                case 1: // AND
+                    for( unsigned int i=0;i<nCount;i++ ) pDst[i] &= pSrc[i];
+                    break;
+                case 2: // XOR
+                    for( unsigned int i=0;i<nCount;i++ ) pDst[i] ^= pSrc[i];
+                    break;
+                case 3: // XNOR
+                    for( unsigned int i=0;i<nCount;i++ ) pDst[i] = 1 ^ pDst[i] ^ pSrc[i];
+                    break;
+                default: // REPLACE
+                    memcpy( pDst, pSrc, nCount );
+                    break;
+            }
+        }
+    }
+
+ private:
+    std::vector<unsigned char> m_data;
+    size_t                     m_nPos;
+
+    bool                       m_bPageInfo;
+    bool                       m_bStriped;
+    bool                       m_bEndOfPage;
+    unsigned int               m_nPageWidth;
+    unsigned int               m_nPageHeight;
+    unsigned char              m_cDefaultPixel;
+    std::vector<unsigned char> m_page;
+};
+
+PdfJBIG2Filter::PdfJBIG2Filter()
+    : m_pDecoder( NULL )
+{
+}
+
+PdfJBIG2Filter::~PdfJBIG2Filter()
+{
+    delete m_pDecoder;
+}
+
+void PdfJBIG2Filter::BeginEncodeImpl()
+{
+    PODOFO_RAISE_ERROR( ePdfError_UnsupportedFilter );
+}
+
+void PdfJBIG2Filter::EncodeBlockImpl( const char*, pdf_long )
+{
+    PODOFO_RAISE_ERROR( ePdfError_UnsupportedFilter );
+}
+
+void PdfJBIG2Filter::EndEncodeImpl()
+{
+    PODOFO_RAISE_ERROR( ePdfError_UnsupportedFilter );
+}
+
+void PdfJBIG2Filter::BeginDecodeImpl( const PdfDictionary* )
+{
+    delete m_pDecoder;
+    m_pDecoder = new PdfJBIG2Decoder();
+}
+
+void PdfJBIG2Filter::DecodeBlockImpl( const char* pBuffer, pdf_long lLen )
+{
+    m_pDecoder->Append( pBuffer, lLen );
+}
+
+void PdfJBIG2Filter::EndDecodeImpl()
+{
+    m_pDecoder->WritePage( GetStream() );
+
+    delete m_pDecoder;
+    m_pDecoder = NULL;
+}
 
 
 };
@@ -48,16 +48,6 @@ extern "C" {
 }
 #endif // PODOFO_HAVE_JPEG_LIB
 
-#ifdef PODOFO_HAVE_TIFF_LIB
-extern "C" {
-#include "tiffio.h"
-#ifdef _WIN32		// Collision between tiff and jpeg-headers
-#define XMD_H
-#undef FAR
-#endif
-}
-#endif // PODOFO_HAVE_TIFF_LIB
-
 
 namespace PoDoFo {
 
@@ -823,11 +813,22 @@ EPdfFilter PdfDCTFilter::GetType() const
 }
 #endif // PODOFO_HAVE_JPEG_LIB
 
-#ifdef PODOFO_HAVE_TIFF_LIB
+class PdfCCITTDecoder;
+class PdfJBIG2Decoder;
 
-/** The CCITT filter can decoded CCITTFaxDecode compressed data.
- *  
- *  This filter requires TIFFlib to be available
+/** The CCITT filter can decode and encode CCITTFaxDecode compressed data.
+ *
+ *  Decoding supports pure one-dimensional Group 3 (K = 0), mixed Group 3
+ *  (K > 0) and pure two-dimensional Group 4 (K < 0) data. Decoding is done
+ *  row by row as data arrives, so only the current and the reference row
+ *  are kept in memory.
+ *
+ *  Encoding always produces Group 4 data (K = -1) with an EOFB marker.
+ *  The input has to consist of rows of 1 bit pixels where 0 is black,
+ *  which is what the decoder produces for /BlackIs1 false.
+ *  As the encoder needs to know the number of pixels per row, which a
+ *  PdfFilter cannot get from the stream, CanEncode() returns false and
+ *  encoding is only possible through PdfFilterFactory::CreateCCITTEncodeStream().
  */
 class PdfCCITTFilter : public PdfFilter {
  public:
@@ -835,6 +836,13 @@ class PdfCCITTFilter : public PdfFilter {
 
     virtual ~PdfCCITTFilter();
 
+    /** Set the number of pixels per row used for encoding.
+     *  This has to be called before BeginEncode().
+     *
+     *  \param lColumns number of pixels in each row
+     */
+    inline void SetEncodeColumns( pdf_long lColumns );
+
     /** Check wether the encoding is implemented for this filter.
      * 
      *  \returns true if the filter is able to encode data
@@ -887,8 +895,10 @@ class PdfCCITTFilter : public PdfFilter {
      *  PdfFilter ensures that a valid stream is available when this method is called, and
      *  that EndDecode() was called since the last BeginDecode()/DecodeBlock().
      *
+     *  \param pDecodeParms additional parameters for decoding data
+     *
      * \see BeginDecode */
-    virtual void BeginDecodeImpl( const PdfDictionary* );
+    virtual void BeginDecodeImpl( const PdfDictionary* pDecodeParms );
 
     /** Real implementation of `DecodeBlock()'. NEVER call this method directly.
      *
@@ -924,9 +934,44 @@ class PdfCCITTFilter : public PdfFilter {
     inline virtual EPdfFilter GetType() const;
 
  private:
-    TIFF* m_tiff;
+    /** Write all rows which can be decoded from the data
+     *  received so far to the output stream.
+     *
+     *  \param bFinal if true no more data will follow
+     */
+    void WriteDecodedRows( bool bFinal );
+
+    /** Encode one complete row of input data.
+     */
+    void EncodeRow( const unsigned char* pRow );
+
+    void PutBits( unsigned int nCode, int nBits );
+    void PutRun( int nRun, bool bBlack );
+    void FlushBits();
+
+ private:
+    PdfCCITTDecoder*           m_pDecoder;
+
+    pdf_long                   m_lColumns;
+    std::vector<unsigned char> m_row;       ///< incomplete input row while encoding
+    pdf_long                   m_lRowFill;
+    std::vector<int>           m_refLine;   ///< changing elements of the reference row
+    std::vector<int>           m_codingLine;///< changing elements of the current row
+
+    unsigned int               m_nBitBuffer;
+    int                        m_nBitCount;
+    unsigned char              m_buffer[PODOFO_FILTER_INTERNAL_BUFFER_SIZE];
+    int                        m_nBufferFill;
 };
 
+// -----------------------------------------------------
+// 
+// -----------------------------------------------------
+void PdfCCITTFilter::SetEncodeColumns( pdf_long lColumns )
+{
+    m_lColumns = lColumns;
+}
+
 // -----------------------------------------------------
 // 
 // -----------------------------------------------------
@@ -950,7 +995,102 @@ EPdfFilter PdfCCITTFilter::GetType() const
 {
     return ePdfFilter_CCITTFaxDecode;
 }
-#endif // PODOFO_HAVE_TIFF_LIB
+
+/** The JBIG2 filter can decode JBIG2Decode compressed data.
+ *
+ *  Only generic region segments (arithmetic and MMR coded) are
+ *  supported, which covers the output of most scanners and of
+ *  lossless JBIG2 encoders. Symbol dictionaries and the /JBIG2Globals
+ *  stream are only used by text regions and are therefore ignored.
+ *  Streams containing text, halftone or refinement regions raise
+ *  ePdfError_UnsupportedFilter.
+ *
+ *  The decoded page is written as rows of 1 bit pixels where 0 is black.
+ */
+class PdfJBIG2Filter : public PdfFilter {
+ public:
+    PdfJBIG2Filter();
+
+    virtual ~PdfJBIG2Filter();
+
+    /** Check wether the encoding is implemented for this filter.
+     * 
+     *  \returns true if the filter is able to encode data
+     */
+    inline virtual bool CanEncode() const; 
+
+    /** Encoding is not supported and raises ePdfError_UnsupportedFilter.
+     */
+    virtual void BeginEncodeImpl();
+
+    /** Encoding is not supported and raises ePdfError_UnsupportedFilter.
+     */
+    virtual void EncodeBlockImpl( const char* pBuffer, pdf_long lLen );
+
+    /** Encoding is not supported and raises ePdfError_UnsupportedFilter.
+     */
+    virtual void EndEncodeImpl();
+
+    /** Check wether the decoding is implemented for this filter.
+     * 
+     *  \returns true if the filter is able to decode data
+     */
+    inline virtual bool CanDecode() const; 
+
+    /** Real implementation of `BeginDecode()'. NEVER call this method directly.
+     *
+     *  PdfFilter ensures that a valid stream is available when this method is called, and
+     *  that EndDecode() was called since the last BeginDecode()/DecodeBlock().
+     *
+     * \see BeginDecode */
+    virtual void BeginDecodeImpl( const PdfDictionary* );
+
+    /** Real implementation of `DecodeBlock()'. NEVER call this method directly.
+     *
+     *  Complete segments are decoded as soon as they are available.
+     *
+     * \see DecodeBlock */
+    virtual void DecodeBlockImpl( const char* pBuffer, pdf_long lLen );
+
+    /** Real implementation of `EndDecode()'. NEVER call this method directly.
+     *
+     *  Writes the decoded page to the output stream.
+     *
+     * \see EndDecode */
+    virtual void EndDecodeImpl();
+
+    /** GetType of this filter.
+     *  \returns the GetType of this filter
+     */
+    inline virtual EPdfFilter GetType() const;
+
+ private:
+    PdfJBIG2Decoder* m_pDecoder;
+};
+
+// -----------------------------------------------------
+// 
+// -----------------------------------------------------
+bool PdfJBIG2Filter::CanEncode() const
+{
+    return false;
+}
+
+// -----------------------------------------------------
+// 
+// -----------------------------------------------------
+bool PdfJBIG2Filter::CanDecode() const
+{
+    return true;
+}
+
+// -----------------------------------------------------
+// 
+// -----------------------------------------------------
+EPdfFilter PdfJBIG2Filter::GetType() const
+{
+    return ePdfFilter_JBIG2Decode;
+}
 
 };
 
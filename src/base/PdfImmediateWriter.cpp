@@ -85,10 +85,53 @@ void PdfImmediateWriter::WriteObject( const PdfObject* pObject )
     // we simply overwrite this string with "stream\n" which 
     // has excatly the same length.
     m_pDevice->Seek( m_pDevice->Tell() - endObjLenght );
-    m_pDevice->Print( "stream\n" );
+    m_pDevice->Write( "stream\n", 7 );
     m_pLast = const_cast<PdfObject*>(pObject);
 }
 
+void PdfImmediateWriter::FlushObject( PdfObject* pObject )
+{
+    if( !m_pParent || !pObject || pObject->GetOwner() != m_pParent )
+    {
+        PODOFO_RAISE_ERROR( ePdfError_InvalidHandle );
+    }
+
+    if( pObject->HasStream() && pObject->GetStream()->IsAppending() )
+    {
+        PODOFO_RAISE_ERROR_INFO( ePdfError_InternalLogic, "Cannot flush an object whose stream is still open for appending." );
+    }
+
+    if( m_bOpenStream )
+    {
+        // The stream of another object is written to the device right now,
+        // the object is written when FinishLastObject() closes this stream.
+        m_vecDelayedFlush.push_back( pObject->Reference() );
+        return;
+    }
+
+    this->WriteFlushedObject( pObject );
+}
+
+void PdfImmediateWriter::WriteFlushedObject( PdfObject* pObject )
+{
+    if( pObject == m_pLast )
+    {
+        // The object has been written already, 
+        // only endstream and endobj are missing.
+        // FinishLastObject() writes the length of the stream, too.
+        this->FinishLastObject();
+    }
+    else
+    {
+        this->FinishLastObject();
+
+        m_pXRef->AddObject( pObject->Reference(), m_pDevice->Tell(), true );
+        pObject->WriteObject( m_pDevice, this->GetWriteMode(), m_pEncrypt );
+
+        delete m_pParent->RemoveObject( pObject->Reference(), false );
+    }
+}
+
 void PdfImmediateWriter::ParentDestructed()
 {
     m_pParent = NULL;
@@ -144,12 +187,44 @@ void PdfImmediateWriter::FinishLastObject()
 {
     if( m_pLast ) 
     {
-        m_pDevice->Print( "\nendstream\n" );
-        m_pDevice->Print( "endobj\n" );
+        m_pDevice->Write( "\nendstream\n", 11 );
+        m_pDevice->Write( "endobj\n", 7 );
+
+        // A PdfFileStream stores its length in an extra object,
+        // which is known now and can be written, too.
+        const PdfObject* pLength = m_pLast->GetDictionary().GetKey( PdfName::KeyLength );
+        PdfReference lengthRef;
+        if( pLength && pLength->IsReference() )
+            lengthRef = pLength->GetReference();
         
         delete m_pParent->RemoveObject( m_pLast->Reference(), false );
         m_pLast = NULL;
 
+        if( lengthRef.IsIndirect() )
+        {
+            PdfObject* pLengthObj = m_pParent->GetObject( lengthRef );
+            if( pLengthObj && pLengthObj->IsNumber() )
+                this->WriteFlushedObject( pLengthObj );
+        }
+    }
+
+    // No stream is written now, so the objects 
+    // which were flushed while it was open can follow.
+    if( !m_vecDelayedFlush.empty() ) 
+    {
+        std::vector<PdfReference> vecDelayed;
+        vecDelayed.swap( m_vecDelayedFlush );
+
+        std::vector<PdfReference>::const_iterator it = vecDelayed.begin();
+        while( it != vecDelayed.end() )
+        {
+            // The object may have been flushed twice
+            PdfObject* pObject = m_pParent->GetObject( *it );
+            if( pObject ) 
+                this->WriteFlushedObject( pObject );
+
+            ++it;
+        }
     }
 }
 
@@ -72,6 +72,26 @@ class PODOFO_API PdfImmediateWriter : private PdfWriter,
      */
     inline EPdfVersion GetPdfVersion() const;
 
+    /** Write a complete object to the output device immediately
+     *  and delete it from the PdfVecObjects.
+     *
+     *  Usually all objects without a stream are kept in memory
+     *  until the document is finished. Objects which will not
+     *  change anymore (e.g. finished pages) can be written
+     *  earlier using this method to save memory.
+     *  Other objects may still refer to the object,
+     *  but it must not be accessed or changed anymore.
+     *
+     *  While the stream of another object is open for appending,
+     *  the object cannot be written to the output device. In this
+     *  case it is written as soon as this stream has been finished.
+     *
+     *  \param pObject an object owned by the PdfVecObjects of this writer,
+     *                 whose stream (if any) must not be open for appending.
+     *                 pObject is deleted by this method.
+     */
+    void FlushObject( PdfObject* pObject );
+
  private:
     void WriteObject( const PdfObject* pObject );
 
@@ -110,6 +130,15 @@ class PODOFO_API PdfImmediateWriter : private PdfWriter,
      */
     void FinishLastObject();
 
+    /** Write an object to the output device and delete it.
+     *  No stream may be written to the output device currently.
+     *
+     *  \param pObject the object to write
+     *
+     *  \see FlushObject
+     */
+    void WriteFlushedObject( PdfObject* pObject );
+
  private:
     PdfVecObjects*   m_pParent;
     PdfOutputDevice* m_pDevice;
@@ -118,6 +147,8 @@ class PODOFO_API PdfImmediateWriter : private PdfWriter,
     PdfObject*       m_pLast;
 
     bool             m_bOpenStream;
+
+    std::vector<PdfReference> m_vecDelayedFlush; ///< objects flushed while a stream was open
 };
 
 // -----------------------------------------------------
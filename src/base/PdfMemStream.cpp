@@ -23,6 +23,7 @@
 #include "PdfArray.h"
 #include "PdfEncrypt.h"
 #include "PdfFilter.h"
+#include "PdfInputDevice.h"
 #include "PdfObject.h"
 #include "PdfOutputDevice.h"
 #include "PdfOutputStream.h"
@@ -34,33 +35,41 @@
 namespace PoDoFo {
 
 PdfMemStream::PdfMemStream( PdfObject* pParent )
-    : PdfStream( pParent ), m_pStream( NULL ), m_pBufferStream( NULL ), m_lLength( 0 )
+    : PdfStream( pParent ), m_pStream( NULL ), m_pChunks( NULL ), m_lLength( 0 ), m_lDeviceOffset( 0 )
 {
 }
 
 PdfMemStream::PdfMemStream( const PdfMemStream & rhs )
-    : PdfStream( NULL ), m_pStream( NULL ), m_pBufferStream( NULL ), m_lLength( 0 )
+    : PdfStream( NULL ), m_pStream( NULL ), m_pChunks( NULL ), m_lLength( 0 ), m_lDeviceOffset( 0 )
 {
     operator=(rhs);
 }
 
 PdfMemStream::~PdfMemStream()
 {
+    if( m_pStream != m_pChunks )
+        delete m_pStream;
+
+    delete m_pChunks;
 }
 
 void PdfMemStream::BeginAppendImpl( const TVecFilters & vecFilters )
 {
     m_buffer  = PdfRefCountedBuffer();
 	m_lLength = 0;
+    m_device  = PdfRefCountedInputDevice();
+
+    delete m_pChunks;
+    m_pChunks = new PdfChunkedOutputStream();
 
     if( vecFilters.size() )
     {
-        m_pBufferStream = new PdfBufferOutputStream( &m_buffer );
-        m_pStream       = PdfFilterFactory::CreateEncodeStream( vecFilters, m_pBufferStream );
+        // Many small appends, e.g. from PdfPainter, are collected
+        // before they are passed to the encoder
+        m_pStream = new PdfBatchingOutputStream( PdfFilterFactory::CreateEncodeStream( vecFilters, m_pChunks ), true );
     }
     else 
-        m_pStream = new PdfBufferOutputStream( &m_buffer );
-
+        m_pStream = m_pChunks;
 }
 
 void PdfMemStream::AppendImpl( const char* pszString, size_t lLen )
@@ -74,19 +83,20 @@ void PdfMemStream::EndAppendImpl()
     {
         m_pStream->Close();
 
-        if( !m_pBufferStream ) 
-            m_lLength = dynamic_cast<PdfBufferOutputStream*>(m_pStream)->GetLength();
+        if( m_pStream != m_pChunks ) 
+            delete m_pStream;
 
-        delete m_pStream;
         m_pStream = NULL;
     }
 
-    if( m_pBufferStream ) 
+    if( m_pChunks ) 
     {
-        m_pBufferStream->Close();
-        m_lLength = m_pBufferStream->GetLength();
-        delete m_pBufferStream;
-        m_pBufferStream = NULL;
+        m_lLength = m_pChunks->GetLength();
+
+        // Data which fits into a single block is taken over without 
+        // copying, larger data is kept in blocks until Get() is called
+        if( m_pChunks->GetChunkCount() <= 1 ) 
+            this->MergeChunks();
     }
 
     if( m_pParent )
@@ -100,6 +110,17 @@ void PdfMemStream::GetCopy( char** pBuffer, pdf_long* lLen ) const
         PODOFO_RAISE_ERROR( ePdfError_InvalidHandle );
     }
 
+    if( m_device.Device() ) 
+    {
+        // Read the data directly into the copy
+        PdfMemoryOutputStream stream( m_lLength ? m_lLength : 1 );
+        this->CopyRawDataRange( &stream );
+
+        *lLen    = stream.GetLength();
+        *pBuffer = stream.TakeBuffer();
+        return;
+    }
+
     *pBuffer = static_cast<char*>(malloc( sizeof( char ) * m_lLength ));
     *lLen    = m_lLength;
     
@@ -108,7 +129,10 @@ void PdfMemStream::GetCopy( char** pBuffer, pdf_long* lLen ) const
         PODOFO_RAISE_ERROR( ePdfError_OutOfMemory );
     }
     
-    memcpy( *pBuffer, m_buffer.GetBuffer(), m_lLength );
+    if( m_pChunks ) 
+        m_pChunks->CopyTo( *pBuffer );
+    else
+        memcpy( *pBuffer, m_buffer.GetBuffer(), m_lLength );
 }
 
 
@@ -118,7 +142,80 @@ void PdfMemStream::GetCopy(PdfOutputStream * pStream) const
 	{
 		PODOFO_RAISE_ERROR( ePdfError_InvalidHandle );
 	}
-	pStream->Write(m_buffer.GetBuffer(), m_lLength);
+
+    if( m_device.Device() ) 
+        this->CopyRawDataRange( pStream );
+    else if( m_pChunks ) 
+        m_pChunks->WriteTo( pStream );
+    else
+        pStream->Write(m_buffer.GetBuffer(), m_lLength);
+}
+
+void PdfMemStream::SetRawDataRange( const PdfRefCountedInputDevice & rDevice, pdf_long lOffset, pdf_long lLen )
+{
+    PODOFO_RAISE_LOGIC_IF( m_bAppend, "SetRawDataRange() failed because EndAppend() was not yet called!" );
+
+    if( !rDevice.Device() )
+    {
+        PODOFO_RAISE_ERROR( ePdfError_InvalidHandle );
+    }
+
+    delete m_pChunks;
+    m_pChunks       = NULL;
+    m_buffer        = PdfRefCountedBuffer();
+    m_device        = rDevice;
+    m_lDeviceOffset = lOffset;
+    m_lLength       = lLen;
+
+    if( m_pParent )
+        m_pParent->GetDictionary().AddKey( PdfName::KeyLength, PdfVariant( static_cast<pdf_int64>(m_lLength) ) );
+}
+
+void PdfMemStream::LoadRawDataRange()
+{
+    if( !m_device.Device() )
+        return;
+
+    // BeginAppend() clears the reference, so keep a copy of it
+    PdfRefCountedInputDevice device( m_device );
+    PdfStream::SetRawDataRange( device, m_lDeviceOffset, m_lLength );
+}
+
+void PdfMemStream::MergeChunks()
+{
+    // The blocks are still written to while appending
+    if( !m_pChunks || m_bAppend )
+        return;
+
+    const pdf_long lLength = m_pChunks->GetLength();
+    char*          pBuffer = m_pChunks->TakeBuffer();
+
+    delete m_pChunks;
+    m_pChunks = NULL;
+
+    m_buffer  = PdfRefCountedBuffer( pBuffer, lLength );
+}
+
+void PdfMemStream::CopyRawDataRange( PdfOutputStream* pStream ) const
+{
+    const pdf_long  BUFFER_SIZE = 4096;
+    char            buffer[BUFFER_SIZE];
+    pdf_long        lLen        = m_lLength;
+    pdf_long        lRead;
+    PdfInputDevice* pDevice     = m_device.Device();
+
+    pDevice->Seek( m_lDeviceOffset );
+    while( lLen > 0 ) 
+    {
+        lRead = static_cast<pdf_long>(pDevice->Read( buffer, PDF_MIN( BUFFER_SIZE, lLen ) ));
+        if( lRead <= 0 ) 
+        {
+            PODOFO_RAISE_ERROR_INFO( ePdfError_UnexpectedEOF, "Stream data in input device is shorter than its /Length." );
+        }
+
+        pStream->Write( buffer, lRead );
+        lLen -= lRead;
+    }
 }
 
 void PdfMemStream::FlateCompress()
@@ -228,6 +325,9 @@ void PdfMemStream::FlateCompressStreamData()
     if( !m_lLength )
         return;
 
+    LoadRawDataRange();
+    MergeChunks();
+
     std::auto_ptr<PdfFilter> pFilter = PdfFilterFactory::Create( ePdfFilter_FlateDecode );
     if( pFilter.get() )
     {
@@ -244,7 +344,16 @@ const PdfStream & PdfMemStream::operator=( const PdfStream & rhs )
 {
     const PdfMemStream* pStream = dynamic_cast<const PdfMemStream*>(&rhs);
     if( pStream )
-        m_buffer = pStream->m_buffer;
+    {
+        // Blocks are not shared, so share a single buffer instead
+        const_cast<PdfMemStream*>(pStream)->MergeChunks();
+
+        delete m_pChunks;
+        m_pChunks       = NULL;
+        m_buffer        = pStream->m_buffer;
+        m_device        = pStream->m_device;
+        m_lDeviceOffset = pStream->m_lDeviceOffset;
+    }
     else
         return PdfStream::operator=( rhs );
 
@@ -257,7 +366,7 @@ const PdfStream & PdfMemStream::operator=( const PdfStream & rhs )
 
 void PdfMemStream::Write( PdfOutputDevice* pDevice, PdfEncrypt* pEncrypt ) 
 {
-    pDevice->Print( "stream\n" );
+    pDevice->Write( "stream\n", 7 );
     if( pEncrypt ) 
     {
         char* pBuffer;
@@ -277,11 +386,33 @@ void PdfMemStream::Write( PdfOutputDevice* pDevice, PdfEncrypt* pEncrypt )
         delete[] pOutputBuffer;
         free( pBuffer );                               
     }
+    else if( m_device.Device() ) 
+    {
+        // Copy the still encoded data directly from the input device
+        PdfDeviceOutputStream stream( pDevice );
+        this->CopyRawDataRange( &stream );
+    }
+    else if( m_pChunks ) 
+    {
+        // Write block by block instead of merging the blocks first
+        PdfDeviceOutputStream stream( pDevice );
+        m_pChunks->WriteTo( &stream );
+    }
     else
     {
         pDevice->Write( this->Get(), this->GetLength() );
     }
-    pDevice->Print( "\nendstream\n" );
+    pDevice->Write( "\nendstream\n", 11 );
+}
+
+pdf_long PdfMemStream::GetWriteLength( PdfEncrypt* pEncrypt ) const
+{
+    pdf_long lLength = this->GetLength();
+    if( pEncrypt ) 
+        lLength = pEncrypt->CalculateStreamLength( lLength );
+
+    // "stream\n" and "\nendstream\n" as written by Write()
+    return 7 + lLength + 11;
 }
 
 pdf_long PdfMemStream::GetLength() const
@@ -26,10 +26,11 @@
 #include "PdfStream.h"
 #include "PdfDictionary.h"
 #include "PdfRefCountedBuffer.h"
+#include "PdfRefCountedInputDevice.h"
 
 namespace PoDoFo {
 
-class PdfBufferOutputStream;
+class PdfChunkedOutputStream;
 class PdfName;
 class PdfObject;
 
@@ -42,6 +43,15 @@ class PdfObject;
  *  to draw onto a page or binary data like a font or an image.
  *
  *  A PdfMemStream is implicitly shared and can therefore be copied very quickly.
+ *
+ *  Raw data set using SetRawDataRange() is not read into memory
+ *  until it is accessed, and is copied directly from the input
+ *  device when the stream is written.
+ *
+ *  Appended data is collected in a list of memory blocks, so that
+ *  large streams are never reallocated and copied while growing.
+ *  The blocks are written one after another and are only merged 
+ *  into a single buffer when the data is accessed using Get().
  */
 class PODOFO_API PdfMemStream : public PdfStream {
     friend class PdfVecObjects;
@@ -69,6 +79,15 @@ class PODOFO_API PdfMemStream : public PdfStream {
      */
     virtual void Write( PdfOutputDevice* pDevice, PdfEncrypt* pEncrypt = NULL );
 
+    /** Get the number of bytes Write() would write to an output device.
+     *  The length is calculated from the length of the stream data,
+     *  so raw data is not read from the input device.
+     *
+     *  \param pEncrypt encrypt stream data using this object
+     *  \returns the number of bytes written by Write()
+     */
+    virtual pdf_long GetWriteLength( PdfEncrypt* pEncrypt = NULL ) const;
+
     /** Get a malloced buffer of the current stream.
      *  No filters will be applied to the buffer, so
      *  if the stream is Flate compressed the compressed copy
@@ -88,6 +107,25 @@ class PODOFO_API PdfMemStream : public PdfStream {
      */
     virtual void GetCopy( PdfOutputStream* pStream ) const;
 
+    /** Sets raw data for this stream which is located in an input device.
+     *  Only a reference to the device is kept; the data is read when
+     *  it is accessed for the first time or copied directly to the
+     *  output device when the stream is written.
+     *
+     *  The device must not be modified as long as this stream
+     *  refers to it.
+     *
+     *  \param rDevice read data from this input device
+     *  \param lOffset position of the first byte of data in the device
+     *  \param lLen    number of bytes to read from the device
+     */
+    virtual void SetRawDataRange( const PdfRefCountedInputDevice & rDevice, pdf_long lOffset, pdf_long lLen );
+
+    /** \returns true if the data of this stream has not been read
+     *           from the input device given to SetRawDataRange() yet.
+     */
+    inline bool IsRawDataRange() const;
+
     /** Get a read-only handle to the current stream data.
      *  The data will not be filtered before being returned, so (eg) calling
      *  Get() on a Flate compressed stream will return a pointer to the
@@ -171,13 +209,31 @@ class PODOFO_API PdfMemStream : public PdfStream {
      */
     void FlateCompressStreamData();
 
+    /** Read the data referenced by SetRawDataRange() into memory.
+     *  Does nothing if there is no such reference.
+     */
+    void LoadRawDataRange();
+
+    /** Copy the data referenced by SetRawDataRange() to a stream
+     *  without keeping it in memory.
+     *  \param pStream data is written to this stream.
+     */
+    void CopyRawDataRange( PdfOutputStream* pStream ) const;
+
+    /** Merge the blocks of appended data into a single buffer.
+     *  Does nothing if the data is in a single buffer already.
+     */
+    void MergeChunks();
 
  private:
-    PdfRefCountedBuffer    m_buffer;
-    PdfOutputStream*       m_pStream;
-    PdfBufferOutputStream* m_pBufferStream;
+    PdfRefCountedBuffer     m_buffer;
+    PdfOutputStream*        m_pStream;
+    PdfChunkedOutputStream* m_pChunks;
 
-    pdf_long               m_lLength;
+    pdf_long                m_lLength;
+
+    PdfRefCountedInputDevice m_device;
+    pdf_long                 m_lDeviceOffset;
 };
 
 // -----------------------------------------------------
@@ -185,14 +241,28 @@ class PODOFO_API PdfMemStream : public PdfStream {
 // -----------------------------------------------------
 const char* PdfMemStream::Get() const
 {
+    const_cast<PdfMemStream*>(this)->LoadRawDataRange();
+    const_cast<PdfMemStream*>(this)->MergeChunks();
+
     return m_buffer.GetBuffer();
 }
 
+// -----------------------------------------------------
+// 
+// -----------------------------------------------------
+bool PdfMemStream::IsRawDataRange() const
+{
+    return m_device.Device() != NULL;
+}
+
 // -----------------------------------------------------
 // 
 // -----------------------------------------------------
 const char* PdfMemStream::GetInternalBuffer() const
 {
+    const_cast<PdfMemStream*>(this)->LoadRawDataRange();
+    const_cast<PdfMemStream*>(this)->MergeChunks();
+
     return m_buffer.GetBuffer();
 }
 
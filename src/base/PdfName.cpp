@@ -172,7 +172,7 @@ PdfName PdfName::FromEscaped( const char * pszName, pdf_long ilen )
 void PdfName::Write( PdfOutputDevice* pDevice, EPdfWriteMode, const PdfEncrypt* ) const
 {
     // Allow empty names, which are legal according to the PDF specification
-    pDevice->Print( "/" );
+    pDevice->Write( "/", 1 );
     if( m_Data.length() )
     {
         std::string escaped( EscapeName(m_Data.begin(), m_Data.length()) );
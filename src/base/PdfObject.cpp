@@ -156,7 +156,16 @@ void PdfObject::InitPdfObject()
 void PdfObject::WriteObject( PdfOutputDevice* pDevice, EPdfWriteMode eWriteMode,
                              PdfEncrypt* pEncrypt, const PdfName & keyStop ) const
 {
-    DelayedStreamLoad();
+    this->WriteObject( pDevice, eWriteMode, pEncrypt, keyStop, true );
+}
+
+void PdfObject::WriteObject( PdfOutputDevice* pDevice, EPdfWriteMode eWriteMode,
+                             PdfEncrypt* pEncrypt, const PdfName & keyStop, bool bWriteStream ) const
+{
+    if( bWriteStream )
+        DelayedStreamLoad();
+    else
+        DelayedLoad();
 
     if( !pDevice )
     {
@@ -165,13 +174,17 @@ void PdfObject::WriteObject( PdfOutputDevice* pDevice, EPdfWriteMode eWriteMode,
 
     if( m_reference.IsIndirect() )
     {
+        pDevice->WriteNumber( m_reference.ObjectNumber() );
+        pDevice->Write( " ", 1 );
+        pDevice->WriteNumber( m_reference.GenerationNumber() );
+
         if( (eWriteMode & ePdfWriteMode_Clean) == ePdfWriteMode_Clean ) 
         {
-            pDevice->Print( "%i %i obj\n", m_reference.ObjectNumber(), m_reference.GenerationNumber() );
+            pDevice->Write( " obj\n", 5 );
         }
         else 
         {
-            pDevice->Print( "%i %i obj", m_reference.ObjectNumber(), m_reference.GenerationNumber() );
+            pDevice->Write( " obj", 4 );
         }
     }
 
@@ -194,16 +207,16 @@ void PdfObject::WriteObject( PdfOutputDevice* pDevice, EPdfWriteMode eWriteMode,
     }
 
     this->Write( pDevice, eWriteMode, pEncrypt, keyStop );
-    pDevice->Print( "\n" );
+    pDevice->Write( "\n", 1 );
 
-    if( m_pStream )
+    if( m_pStream && bWriteStream )
     {
         m_pStream->Write( pDevice, pEncrypt );
     }
 
     if( m_reference.IsIndirect() )
     {
-        pDevice->Print( "endobj\n" );
+        pDevice->Write( "endobj\n", 7 );
     }
 }
 
@@ -233,11 +246,23 @@ PdfObject* PdfObject::GetIndirectKey( const PdfName & key ) const
 
 pdf_long PdfObject::GetObjectLength( EPdfWriteMode eWriteMode )
 {
+    // The stream is counted first, as loading it
+    // may change the /Length key of the dictionary.
+    pdf_long        lLength = this->GetStreamWriteLength();
     PdfOutputDevice device;
 
-    this->WriteObject( &device, eWriteMode, NULL  );
+    // Only count the bytes of everything but the stream,
+    // whose length is known without writing the data.
+    this->WriteObject( &device, eWriteMode, NULL, PdfName::KeyNull, false );
 
-    return device.GetLength();
+    return lLength + device.GetLength();
+}
+
+pdf_long PdfObject::GetStreamWriteLength()
+{
+    DelayedStreamLoad();
+
+    return m_pStream ? m_pStream->GetWriteLength( NULL ) : 0;
 }
 
 PdfStream* PdfObject::GetStream()
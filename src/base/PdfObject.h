@@ -176,6 +176,10 @@ class PODOFO_API PdfObject : public PdfVariant {
                       const PdfName & keyStop = PdfName::KeyNull ) const;
 
     /** Get the length of the object in bytes if it was written to disk now.
+     *
+     *  Stream data is not copied to calculate the length, 
+     *  see PdfStream::GetWriteLength().
+     *
      *  \param eWriteMode additional options for writing the object
      *  \returns  the length of the object
      */
@@ -305,6 +309,27 @@ class PODOFO_API PdfObject : public PdfVariant {
      */
     PdfStream* GetStream_NoDL();
 
+    /** Get the number of bytes WriteObject() writes for the stream
+     *  of this object without writing it. Called by GetObjectLength()
+     *  before the rest of the object is counted.
+     *
+     *  This implementation has to load the stream. Subclasses can override
+     *  it to avoid loading a stream which was not loaded yet.
+     *
+     *  
+eturns the length of the stream as written or 0 if there is no stream
+     */
+    virtual pdf_long GetStreamWriteLength();
+
+ private:
+    // No touchy. Only for manipulation by PdfObject private routines.
+    // Tracks whether deferred loading is still pending (in which case it'll be
+    // false). If true, deferred loading is not requried or has been completed.
+    //
+    // Declared before all other members, so that it is placed
+    // in the padding at the end of PdfVariant.
+    mutable bool m_bDelayedStreamLoadDone;
+
  protected:
     PdfReference   m_reference;
     
@@ -323,10 +348,13 @@ class PODOFO_API PdfObject : public PdfVariant {
     // Shared initialization between all the ctors
     void InitPdfObject();
 
-    // No touchy. Only for manipulation by PdfObject private routines.
-    // Tracks whether deferred loading is still pending (in which case it'll be
-    // false). If true, deferred loading is not requried or has been completed.
-    mutable bool m_bDelayedStreamLoadDone;
+    /** Implementation of WriteObject(). If bWriteStream is false,
+     *  the stream is left out so that GetObjectLength() can count 
+     *  its length without writing the stream data. A stream which
+     *  was not loaded yet is not loaded in this case.
+     */
+    void WriteObject( PdfOutputDevice* pDevice, EPdfWriteMode eWriteMode, PdfEncrypt* pEncrypt,
+                      const PdfName & keyStop, bool bWriteStream ) const;
 
 #if defined(PODOFO_EXTRA_CHECKS)
  protected:
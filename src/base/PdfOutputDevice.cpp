@@ -24,6 +24,7 @@
 
 #include <fstream>
 #include <sstream>
+#include <string.h>
 
 
 namespace PoDoFo {
@@ -333,6 +334,97 @@ void PdfOutputDevice::Write( const char* pBuffer, size_t lLen )
 	if(m_ulPosition>m_ulLength) m_ulLength = m_ulPosition;
 }
 
+/** Format nNumber in decimal notation, so that it ends before pszEnd.
+ *  \returns the first character written
+ */
+static char* FormatUnsigned( char* pszEnd, pdf_uint64 nNumber, int nMinDigits )
+{
+    char* pszCur = pszEnd;
+
+    do {
+        *--pszCur = static_cast<char>('0' + nNumber % 10);
+        nNumber  /= 10;
+        --nMinDigits;
+    } while( nNumber || nMinDigits > 0 );
+
+    return pszCur;
+}
+
+void PdfOutputDevice::WriteNumber( pdf_int64 nNumber )
+{
+    char  szBuffer[24];
+    char* pszEnd = szBuffer + sizeof(szBuffer);
+    // Negate as unsigned, which also works for the smallest pdf_int64
+    char* pszCur = FormatUnsigned( pszEnd, nNumber < 0 ? 0 - static_cast<pdf_uint64>(nNumber) 
+                                                      : static_cast<pdf_uint64>(nNumber), 1 );
+
+    if( nNumber < 0 )
+        *--pszCur = '-';
+
+    this->Write( pszCur, pszEnd - pszCur );
+}
+
+void PdfOutputDevice::WriteUnsigned( pdf_uint64 nNumber, int nMinDigits )
+{
+    char  szBuffer[64];
+    char* pszEnd = szBuffer + sizeof(szBuffer);
+
+    nMinDigits = PDF_MIN( nMinDigits, static_cast<int>(sizeof(szBuffer)) );
+    char* pszCur = FormatUnsigned( pszEnd, nNumber, nMinDigits );
+
+    this->Write( pszCur, pszEnd - pszCur );
+}
+
+void PdfOutputDevice::WriteReal( double dReal )
+{
+    pdf_uint64 nBits;
+    memcpy( &nBits, &dReal, sizeof(nBits) );
+
+    bool   bNegative = (nBits >> 63) != 0;
+    double dAbs      = bNegative ? -dReal : dReal;
+
+    // Scaling by 1e6 is exact to about 1e-4 for numbers below 1e6,
+    // so the result can only differ from the exact decimal rounding
+    // done by iostreams if the fraction is close to one half.
+    // Those numbers, huge numbers, -0, NaN and infinity are left to iostreams.
+    if( dAbs < 1e6 && dReal != 0.0 ) 
+    {
+        double     dScaled  = dAbs * 1e6;
+        pdf_uint64 nScaled  = static_cast<pdf_uint64>(dScaled);
+        double     dFrac    = dScaled - static_cast<double>(nScaled);
+
+        if( dFrac < 0.499 || dFrac > 0.501 ) 
+        {
+            char  szBuffer[32];
+            char* pszEnd = szBuffer + sizeof(szBuffer);
+
+            if( dFrac > 0.5 )
+                ++nScaled;
+
+            char* pszCur = FormatUnsigned( pszEnd, nScaled % 1000000, 6 );
+            *--pszCur = '.';
+            pszCur = FormatUnsigned( pszCur, nScaled / 1000000, 1 );
+            if( bNegative )
+                *--pszCur = '-';
+
+            this->Write( pszCur, pszEnd - pszCur );
+            return;
+        }
+    }
+    else if( dReal == 0.0 && !bNegative )
+    {
+        this->Write( "0.000000", 8 );
+        return;
+    }
+
+    // Use ostringstream, so that locale does not matter
+    std::ostringstream oss;
+    PdfLocaleImbue(oss);
+    oss << std::fixed << dReal;
+
+    this->Write( oss.str().c_str(), oss.str().size() );
+}
+
 void PdfOutputDevice::Seek( size_t offset )
 {
     if( m_hFile )
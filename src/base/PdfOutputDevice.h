@@ -155,6 +155,41 @@ class PODOFO_API PdfOutputDevice {
      */
     virtual void Write( const char* pBuffer, size_t lLen );
 
+    /** Write an integer in decimal notation to the PdfOutputDevice.
+     *
+     *  The output is the same as Print( "%lld", nNumber ), but this
+     *  is much faster as no format string has to be parsed.
+     *
+     *  \param nNumber the number to write
+     *
+     *  \see Write
+     */
+    void WriteNumber( pdf_int64 nNumber );
+
+    /** Write an unsigned integer in decimal notation to the PdfOutputDevice,
+     *  padded with leading zeros to at least nMinDigits digits.
+     *
+     *  For nMinDigits = 10 the output is the same as Print( "%0.10llu", nNumber ).
+     *  At least one digit is always written.
+     *
+     *  \param nNumber the number to write
+     *  \param nMinDigits the minimum number of digits to write
+     *
+     *  \see Write
+     */
+    void WriteUnsigned( pdf_uint64 nNumber, int nMinDigits = 1 );
+
+    /** Write a real number with six decimal places to the PdfOutputDevice.
+     *
+     *  The output is the same as writing dReal to a std::ostream
+     *  in the C locale with std::fixed, i.e. independent of the current locale.
+     *
+     *  \param dReal the number to write
+     *
+     *  \see Write
+     */
+    void WriteReal( double dReal );
+
 	/** Read data from the device
      *  \param pBuffer a pointer to the data buffer
      *  \param lLen length of the output buffer
@@ -130,4 +130,161 @@ pdf_long PdfBufferOutputStream::Write( const char* pBuffer, pdf_long lLen )
     return lLen;
 }
 
+PdfChunkedOutputStream::PdfChunkedOutputStream( pdf_long lInitial )
+    : m_lLength( 0 ), m_lNextSize( lInitial > 0 ? lInitial : INITIAL_SIZE )
+{
+}
+
+PdfChunkedOutputStream::~PdfChunkedOutputStream()
+{
+    this->Clear();
+}
+
+void PdfChunkedOutputStream::Clear()
+{
+    std::vector<TChunk>::iterator it = m_vecChunks.begin();
+    while( it != m_vecChunks.end() )
+    {
+        podofo_free( (*it).pData );
+        ++it;
+    }
+
+    m_vecChunks.clear();
+    m_lLength = 0;
+}
+
+pdf_long PdfChunkedOutputStream::Write( const char* pBuffer, pdf_long lLen )
+{
+    pdf_long lWritten = 0;
+
+    while( lWritten < lLen ) 
+    {
+        if( m_vecChunks.empty() || m_vecChunks.back().lUsed == m_vecChunks.back().lSize )
+        {
+            // Start a new block, the data written so far stays where it is
+            TChunk chunk;
+            chunk.lSize = m_lNextSize;
+            chunk.lUsed = 0;
+            chunk.pData = static_cast<char*>(podofo_malloc( chunk.lSize ));
+            if( !chunk.pData ) 
+            {
+                PODOFO_RAISE_ERROR( ePdfError_OutOfMemory );
+            }
+
+            m_vecChunks.push_back( chunk );
+            m_lNextSize = PDF_MIN( m_lNextSize << 1, static_cast<pdf_long>(PODOFO_CHUNK_MAX_SIZE) );
+        }
+
+        TChunk & rChunk = m_vecChunks.back();
+        pdf_long lCopy  = PDF_MIN( lLen - lWritten, rChunk.lSize - rChunk.lUsed );
+
+        memcpy( rChunk.pData + rChunk.lUsed, pBuffer + lWritten, lCopy );
+        rChunk.lUsed += lCopy;
+        lWritten     += lCopy;
+    }
+
+    m_lLength += lLen;
+    return lLen;
+}
+
+void PdfChunkedOutputStream::WriteTo( PdfOutputStream* pStream ) const
+{
+    std::vector<TChunk>::const_iterator it = m_vecChunks.begin();
+    while( it != m_vecChunks.end() )
+    {
+        pStream->Write( (*it).pData, (*it).lUsed );
+        ++it;
+    }
+}
+
+void PdfChunkedOutputStream::CopyTo( char* pBuffer ) const
+{
+    std::vector<TChunk>::const_iterator it = m_vecChunks.begin();
+    while( it != m_vecChunks.end() )
+    {
+        memcpy( pBuffer, (*it).pData, (*it).lUsed );
+        pBuffer += (*it).lUsed;
+        ++it;
+    }
+}
+
+char* PdfChunkedOutputStream::TakeBuffer()
+{
+    char* pBuffer = NULL;
+
+    if( m_vecChunks.size() == 1 ) 
+    {
+        // Release the unused end of the block, 
+        // which is usually possible without copying
+        pBuffer = m_vecChunks.front().pData;
+        if( m_vecChunks.front().lUsed < m_vecChunks.front().lSize ) 
+        {
+            char* pShrunk = static_cast<char*>(podofo_realloc( pBuffer, m_vecChunks.front().lUsed ));
+            if( pShrunk ) 
+                pBuffer = pShrunk;
+        }
+
+        m_vecChunks.clear();
+    }
+    else if( m_vecChunks.size() > 1 ) 
+    {
+        pBuffer = static_cast<char*>(podofo_malloc( m_lLength ));
+        if( !pBuffer ) 
+        {
+            PODOFO_RAISE_ERROR( ePdfError_OutOfMemory );
+        }
+
+        this->CopyTo( pBuffer );
+    }
+
+    this->Clear();
+    return pBuffer;
+}
+
+PdfBatchingOutputStream::PdfBatchingOutputStream( PdfOutputStream* pStream, bool bOwnStream )
+    : m_pStream( pStream ), m_bOwnStream( bOwnStream ), m_lUsed( 0 )
+{
+}
+
+PdfBatchingOutputStream::~PdfBatchingOutputStream()
+{
+    if( m_bOwnStream )
+        delete m_pStream;
+}
+
+pdf_long PdfBatchingOutputStream::Write( const char* pBuffer, pdf_long lLen )
+{
+    if( m_lUsed + lLen > PODOFO_BATCH_SIZE ) 
+    {
+        this->Flush();
+
+        if( lLen >= PODOFO_BATCH_SIZE ) 
+        {
+            // Large blocks are passed on without copying
+            m_pStream->Write( pBuffer, lLen );
+            return lLen;
+        }
+    }
+
+    memcpy( m_buffer + m_lUsed, pBuffer, lLen );
+    m_lUsed += lLen;
+
+    return lLen;
+}
+
+void PdfBatchingOutputStream::Flush()
+{
+    if( m_lUsed ) 
+    {
+        m_pStream->Write( m_buffer, m_lUsed );
+        m_lUsed = 0;
+    }
+}
+
+void PdfBatchingOutputStream::Close()
+{
+    this->Flush();
+    m_pStream->Close();
+}
+
 };
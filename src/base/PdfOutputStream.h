@@ -25,11 +25,21 @@
 #include "PdfRefCountedBuffer.h"
 
 #include <string>
+#include <vector>
 
 namespace PoDoFo {
 
 #define INITIAL_SIZE 4096
 
+/** The size of the largest block used by PdfChunkedOutputStream
+ */
+#define PODOFO_CHUNK_MAX_SIZE (256 * 1024)
+
+/** The number of bytes collected by PdfBatchingOutputStream
+ *  before they are passed on
+ */
+#define PODOFO_BATCH_SIZE 4096
+
 class PdfOutputDevice;
 
 /** An interface for writing blocks of data to 
@@ -264,6 +274,173 @@ class PODOFO_API PdfBufferOutputStream : public PdfOutputStream {
     pdf_long                 m_lLength;
 };
 
+/** An output stream that collects all data in a list of memory blocks.
+ *
+ *  Contrary to PdfBufferOutputStream data which has been written once
+ *  is never reallocated and copied again when more data is appended.
+ *  The first block is small, so that short streams do not waste memory.
+ *  Every further block is twice as large as the previous one
+ *  up to PODOFO_CHUNK_MAX_SIZE.
+ */
+class PODOFO_API PdfChunkedOutputStream : public PdfOutputStream {
+ public:
+    
+    /** 
+     *  Construct a new PdfChunkedOutputStream
+     * 
+     *  \param lInitial size of the first block
+     */
+    PdfChunkedOutputStream( pdf_long lInitial = INITIAL_SIZE );
+
+    ~PdfChunkedOutputStream();
+
+    /** Write data to the output stream
+     *  
+     *  \param pBuffer the data is read from this buffer
+     *  \param lLen    the size of the buffer 
+     *
+     *  \returns the number of bytes written, -1 if an error ocurred
+     */
+    virtual pdf_long Write( const char* pBuffer, pdf_long lLen );
+
+    virtual void Close() 
+    {
+    }
+
+    /** 
+     * \returns the length of the written data
+     */
+    inline pdf_long GetLength() const;
+
+    /** 
+     * \returns the number of memory blocks
+     */
+    inline size_t GetChunkCount() const;
+
+    /** Get a memory block. All blocks but the last one are filled completely.
+     *
+     *  \param nIndex index of the block, smaller than GetChunkCount()
+     *  \param plLen set to the number of bytes used in this block
+     *
+     *  \returns the data of the block
+     */
+    inline const char* GetChunk( size_t nIndex, pdf_long* plLen ) const;
+
+    /** Write all data block by block to another output stream.
+     *
+     *  \param pStream the data is written to this stream
+     */
+    void WriteTo( PdfOutputStream* pStream ) const;
+
+    /** Copy all data to a contiguous buffer.
+     *
+     *  \param pBuffer the data is copied to this buffer, which
+     *                 must be at least GetLength() bytes large
+     */
+    void CopyTo( char* pBuffer ) const;
+
+    /** Take the data as a single malloc'ed buffer.
+     *
+     *  No data is copied if only one block was used.
+     *  Further calls to write are not allowed.
+     *
+     *  \returns a buffer of GetLength() bytes which has to be freed
+     *           by the caller or NULL if no data was written
+     */
+    char* TakeBuffer();
+
+ private:
+    PdfChunkedOutputStream( const PdfChunkedOutputStream & rhs );
+    const PdfChunkedOutputStream & operator=( const PdfChunkedOutputStream & rhs );
+
+    void Clear();
+
+ private:
+    struct TChunk {
+        char*    pData;
+        pdf_long lSize;
+        pdf_long lUsed;
+    };
+
+    std::vector<TChunk> m_vecChunks;
+
+    pdf_long            m_lLength;
+    pdf_long            m_lNextSize;
+};
+
+// -----------------------------------------------------
+// 
+// -----------------------------------------------------
+inline pdf_long PdfChunkedOutputStream::GetLength() const
+{
+    return m_lLength;
+}
+
+// -----------------------------------------------------
+// 
+// -----------------------------------------------------
+inline size_t PdfChunkedOutputStream::GetChunkCount() const
+{
+    return m_vecChunks.size();
+}
+
+// -----------------------------------------------------
+// 
+// -----------------------------------------------------
+inline const char* PdfChunkedOutputStream::GetChunk( size_t nIndex, pdf_long* plLen ) const
+{
+    *plLen = m_vecChunks[nIndex].lUsed;
+    return m_vecChunks[nIndex].pData;
+}
+
+/** An output stream that collects many small writes 
+ *  and passes them on as larger blocks.
+ *
+ *  This is used in front of the encoders of PdfFilter, as every 
+ *  call to PdfFilter::EncodeBlock has a considerable overhead.
+ *  Writes larger than the internal buffer are passed on directly.
+ */
+class PODOFO_API PdfBatchingOutputStream : public PdfOutputStream {
+ public:
+    
+    /** 
+     *  Collect data for another output stream.
+     * 
+     *  \param pStream all data is written to this stream
+     *  \param bOwnStream if true pStream will be deleted along with this stream
+     */
+    PdfBatchingOutputStream( PdfOutputStream* pStream, bool bOwnStream );
+
+    virtual ~PdfBatchingOutputStream();
+
+    /** Write data to the output stream
+     *  
+     *  \param pBuffer the data is read from this buffer
+     *  \param lLen    the size of the buffer 
+     *
+     *  \returns the number of bytes written, -1 if an error ocurred
+     */
+    virtual pdf_long Write( const char* pBuffer, pdf_long lLen );
+
+    /** Write all collected data and close
+     *  the underlying output stream.
+     */
+    virtual void Close();
+
+ private:
+    PdfBatchingOutputStream( const PdfBatchingOutputStream & rhs );
+    const PdfBatchingOutputStream & operator=( const PdfBatchingOutputStream & rhs );
+
+    void Flush();
+
+ private:
+    PdfOutputStream* m_pStream;
+    bool             m_bOwnStream;
+
+    char             m_buffer[PODOFO_BATCH_SIZE];
+    pdf_long         m_lUsed;
+};
+
 };
 
 #endif // _PDF_OUTPUT_STREAM_H_
@@ -50,13 +50,13 @@ using std::flush;
 namespace PoDoFo {
 
 PdfParser::PdfParser( PdfVecObjects* pVecObjects )
-    : PdfTokenizer(), m_vecObjects( pVecObjects )
+    : PdfTokenizer(), m_vecObjects( pVecObjects ), m_pObjectTokenizer( NULL )
 {
     this->Init();
 }
 
 PdfParser::PdfParser( PdfVecObjects* pVecObjects, const char* pszFilename, bool bLoadOnDemand )
-    : PdfTokenizer(), m_vecObjects( pVecObjects )
+    : PdfTokenizer(), m_vecObjects( pVecObjects ), m_pObjectTokenizer( NULL )
 {
     this->Init();
     this->ParseFile( pszFilename, bLoadOnDemand );
@@ -66,7 +66,7 @@ PdfParser::PdfParser( PdfVecObjects* pVecObjects, const char* pszFilename, bool
 #if defined(_MSC_VER)  &&  _MSC_VER <= 1200			// nicht fr Visualstudio 6
 #else
 PdfParser::PdfParser( PdfVecObjects* pVecObjects, const wchar_t* pszFilename, bool bLoadOnDemand )
-    : PdfTokenizer(), m_vecObjects( pVecObjects )
+    : PdfTokenizer(), m_vecObjects( pVecObjects ), m_pObjectTokenizer( NULL )
 {
     this->Init();
     this->ParseFile( pszFilename, bLoadOnDemand );
@@ -75,7 +75,7 @@ PdfParser::PdfParser( PdfVecObjects* pVecObjects, const wchar_t* pszFilename, bo
 #endif // _WIN32
 
 PdfParser::PdfParser( PdfVecObjects* pVecObjects, const char* pBuffer, long lLen, bool bLoadOnDemand )
-    : PdfTokenizer(), m_vecObjects( pVecObjects )
+    : PdfTokenizer(), m_vecObjects( pVecObjects ), m_pObjectTokenizer( NULL )
 {
     this->Init();
     this->ParseFile( pBuffer, lLen, bLoadOnDemand );
@@ -83,7 +83,7 @@ PdfParser::PdfParser( PdfVecObjects* pVecObjects, const char* pBuffer, long lLen
 
 PdfParser::PdfParser( PdfVecObjects* pVecObjects, const PdfRefCountedInputDevice & rDevice, 
                       bool bLoadOnDemand )
-    : PdfTokenizer(), m_vecObjects( pVecObjects )
+    : PdfTokenizer(), m_vecObjects( pVecObjects ), m_pObjectTokenizer( NULL )
 {
     this->Init();
 
@@ -228,9 +228,25 @@ void PdfParser::Clear()
     delete m_pEncrypt;
     m_pEncrypt = NULL;
 
+    if( m_pObjectTokenizer )
+    {
+        m_pObjectTokenizer->Release();
+        m_pObjectTokenizer = NULL;
+    }
+
     this->Init();
 }
 
+PdfParserObjectTokenizer* PdfParser::GetObjectTokenizer()
+{
+    // Objects may still use the tokenizer after the parser
+    // was deleted, if they are loaded on demand
+    if( !m_pObjectTokenizer )
+        m_pObjectTokenizer = new PdfParserObjectTokenizer( m_device, m_buffer );
+
+    return m_pObjectTokenizer;
+}
+
 void PdfParser::ReadDocumentStructure()
 {
 // Ulrich Arnold 8.9.2009, deactivated because of problems during reading xref's
@@ -487,7 +503,7 @@ void PdfParser::ReadNextTrailer()
     if( this->IsNextToken( "trailer" ) )
     //if( strcmp( m_buffer.GetBuffer(), "railer" ) == 0 )
     {
-        PdfParserObject trailer( m_vecObjects, m_device, m_buffer );
+        PdfParserObject trailer( m_vecObjects, GetObjectTokenizer() );
         try {
             // Ignore the encryption in the trailer as the trailer may not be encrypted
             trailer.ParseFile( NULL, true );
@@ -538,14 +554,14 @@ void PdfParser::ReadTrailer()
             // and a trailer dictionary is not required
             m_device.Device()->Seek( m_nXRefOffset );
 
-            m_pTrailer = new PdfParserObject( m_vecObjects, m_device, m_buffer );
+            m_pTrailer = new PdfParserObject( m_vecObjects, GetObjectTokenizer() );
             static_cast<PdfParserObject*>(m_pTrailer)->ParseFile( NULL, false );
             return;
         }
     }
     else 
     {
-        m_pTrailer = new PdfParserObject( m_vecObjects, m_device, m_buffer );
+        m_pTrailer = new PdfParserObject( m_vecObjects, GetObjectTokenizer() );
         try {
             // Ignore the encryption in the trailer as the trailer may not be encrypted
             static_cast<PdfParserObject*>(m_pTrailer)->ParseFile( NULL, true );
@@ -754,11 +770,11 @@ void PdfParser::ReadXRefStreamContents( pdf_long lOffset, bool bReadOnlyTrailer
 {
     m_device.Device()->Seek( lOffset );
 
-    PdfXRefStreamParserObject xrefObject( m_vecObjects, m_device, m_buffer, &m_offsets );
+    PdfXRefStreamParserObject xrefObject( m_vecObjects, GetObjectTokenizer(), &m_offsets );
     xrefObject.Parse();
 
     if( !m_pTrailer )
-        m_pTrailer = new PdfParserObject( m_vecObjects, m_device, m_buffer );
+        m_pTrailer = new PdfParserObject( m_vecObjects, GetObjectTokenizer() );
 
     MergeTrailer( &xrefObject );
 
@@ -847,7 +863,7 @@ void PdfParser::ReadObjects()
         if( pEncrypt->IsReference() ) 
         {
             i = pEncrypt->GetReference().ObjectNumber();
-            pObject = new PdfParserObject( m_vecObjects, m_device, m_buffer, m_offsets[i].lOffset );
+            pObject = new PdfParserObject( m_vecObjects, GetObjectTokenizer(), m_offsets[i].lOffset );
             pObject->SetLoadOnDemand( false ); // Never load this on demand, as we will use it immediately
             try {
                 pObject->ParseFile( NULL ); // The encryption dictionary is not encrypted :)
@@ -919,7 +935,7 @@ void PdfParser::ReadObjectsInternal()
         {
             //printf("Reading object %i 0 R from %li\n", i, m_offsets[i].lOffset );
             
-            pObject = new PdfParserObject( m_vecObjects, m_device, m_buffer, m_offsets[i].lOffset );
+            pObject = new PdfParserObject( m_vecObjects, GetObjectTokenizer(), m_offsets[i].lOffset );
             pObject->SetLoadOnDemand( m_bLoadOnDemand );
             try {
                 pObject->ParseFile( m_pEncrypt );
@@ -35,6 +35,7 @@ typedef TMapObjects::iterator       TIMapObjects;
 typedef TMapObjects::const_iterator TCIMapObjects;
 
 class PdfEncrypt;
+class PdfParserObjectTokenizer;
 class PdfString;
 
 /**
@@ -528,6 +529,12 @@ class PODOFO_API PdfParser : public PdfTokenizer {
      */
     void         UpdateDocumentVersion();
 
+    /** \returns the tokenizer which is shared by all PdfParserObjects
+     *           read from the current input device, it is created
+     *           on first use.
+     */
+    PdfParserObjectTokenizer* GetObjectTokenizer();
+
  private:
     EPdfVersion   m_ePdfVersion;
 
@@ -547,6 +554,8 @@ class PODOFO_API PdfParser : public PdfTokenizer {
     PdfObject*    m_pLinearization;
     PdfEncrypt*   m_pEncrypt;
 
+    PdfParserObjectTokenizer* m_pObjectTokenizer;
+
     bool          m_xrefSizeUnknown;
 
     std::set<int> m_setObjectStreams;
@@ -41,27 +41,61 @@ static const int s_nLenEndObj    = 6; // strlen("endobj");
 static const int s_nLenStream    = 6; // strlen("stream");
 static const int s_nLenEndStream = 9; // strlen("endstream");
 
+PdfParserObjectTokenizer::PdfParserObjectTokenizer( const PdfRefCountedInputDevice & rDevice, 
+                                                    const PdfRefCountedBuffer & rBuffer )
+    : PdfTokenizer( rDevice, rBuffer ), m_lRefCount( 1 )
+{
+}
+
+PdfParserObjectTokenizer::~PdfParserObjectTokenizer()
+{
+}
+
+void PdfParserObjectTokenizer::Release()
+{
+    if( !--m_lRefCount )
+        delete this;
+}
+
+void PdfParserObjectTokenizer::Seek( pdf_long lOffset )
+{
+    this->ClearQueque();
+    m_device.Device()->Seek( lOffset );
+}
+
 PdfParserObject::PdfParserObject( PdfVecObjects* pCreator, const PdfRefCountedInputDevice & rDevice, 
                                   const PdfRefCountedBuffer & rBuffer, pdf_long lOffset )
-    : PdfObject( PdfVariant::NullValue ), PdfTokenizer( rDevice, rBuffer ), m_pEncrypt( NULL )
+    : PdfObject( PdfVariant::NullValue ), 
+      m_pTokenizer( new PdfParserObjectTokenizer( rDevice, rBuffer ) ), m_pEncrypt( NULL )
+{
+    m_pOwner = pCreator;
+
+    InitPdfParserObject();
+
+    m_lOffset = lOffset == -1 ? m_pTokenizer->GetDevice().Device()->Tell() : lOffset;
+}
+
+PdfParserObject::PdfParserObject( PdfVecObjects* pCreator, PdfParserObjectTokenizer* pTokenizer, pdf_long lOffset )
+    : PdfObject( PdfVariant::NullValue ), m_pTokenizer( pTokenizer ), m_pEncrypt( NULL )
 {
+    m_pTokenizer->AddRef();
     m_pOwner = pCreator;
 
     InitPdfParserObject();
 
-    m_lOffset = lOffset == -1 ? m_device.Device()->Tell() : lOffset;
+    m_lOffset = lOffset == -1 ? m_pTokenizer->GetDevice().Device()->Tell() : lOffset;
 }
 
 PdfParserObject::PdfParserObject( const PdfRefCountedBuffer & rBuffer )
-    : PdfObject( PdfVariant::NullValue ), PdfTokenizer( PdfRefCountedInputDevice(), rBuffer ), 
-      m_pEncrypt( NULL )
+    : PdfObject( PdfVariant::NullValue ), 
+      m_pTokenizer( new PdfParserObjectTokenizer( PdfRefCountedInputDevice(), rBuffer ) ), m_pEncrypt( NULL )
 {
     InitPdfParserObject();
 }
 
 PdfParserObject::~PdfParserObject()
 {
-
+    m_pTokenizer->Release();
 }
 
 void PdfParserObject::InitPdfParserObject()
@@ -88,8 +122,8 @@ void PdfParserObject::InitPdfParserObject()
 void PdfParserObject::ReadObjectNumber()
 {
     try {
-        pdf_long obj = this->GetNextNumber();
-        pdf_long gen = this->GetNextNumber();
+        pdf_long obj = m_pTokenizer->GetNextNumber();
+        pdf_long gen = m_pTokenizer->GetNextNumber();
 
         m_reference = PdfReference( static_cast<unsigned int>(obj), static_cast<pdf_uint16>(gen) );
     } catch( PdfError & e ) {
@@ -97,7 +131,7 @@ void PdfParserObject::ReadObjectNumber()
         throw e;
     }
     
-    if( !this->IsNextToken( "obj" ))
+    if( !m_pTokenizer->IsNextToken( "obj" ))
     {
         std::ostringstream oss;
         oss << "Error while reading object " << m_reference.ObjectNumber() << " " 
@@ -108,13 +142,17 @@ void PdfParserObject::ReadObjectNumber()
 
 void PdfParserObject::ParseFile( PdfEncrypt* pEncrypt, bool bIsTrailer )
 {
-    if( !m_device.Device() )
+    if( !m_pTokenizer->GetDevice().Device() )
     {
         PODOFO_RAISE_ERROR( ePdfError_InvalidHandle );
     }
 
     if( m_lOffset > -1 )
-        m_device.Device()->Seek( m_lOffset );
+        m_pTokenizer->Seek( m_lOffset );
+    else
+        // Parsing continues at the current position of the device,
+        // but tokens queued by another object sharing the tokenizer are stale
+        m_pTokenizer->ClearQueque();
 
     if( !bIsTrailer )
         ReadObjectNumber();
@@ -127,7 +165,7 @@ void PdfParserObject::ParseFile( PdfEncrypt* pEncrypt, bool bIsTrailer )
               << endl;
 #endif // PODOFO_VERBOSE_DEBUG
 
-    m_lOffset    = m_device.Device()->Tell();
+    m_lOffset    = m_pTokenizer->GetDevice().Device()->Tell();
     m_pEncrypt   = pEncrypt;
     m_bIsTrailer = bIsTrailer;
 
@@ -168,7 +206,7 @@ void PdfParserObject::ParseFileComplete( bool bIsTrailer )
 #endif
     const char* pszToken;
 
-    m_device.Device()->Seek( m_lOffset );
+    m_pTokenizer->Seek( m_lOffset );
     if( m_pEncrypt )
         m_pEncrypt->SetCurrentReference( m_reference );
 
@@ -178,7 +216,7 @@ void PdfParserObject::ParseFileComplete( bool bIsTrailer )
     // endobj
 
     EPdfTokenType eTokenType;
-    bool gotToken = this->GetNextToken( pszToken, &eTokenType );
+    bool gotToken = m_pTokenizer->GetNextToken( pszToken, &eTokenType );
     
     if (!gotToken)
     {
@@ -188,12 +226,12 @@ void PdfParserObject::ParseFileComplete( bool bIsTrailer )
     // Check if we have an empty object or data
     if( strncmp( pszToken, "endobj", s_nLenEndObj ) != 0 )
     {
-        this->GetNextVariant( pszToken, eTokenType, *this, m_pEncrypt );
+        m_pTokenizer->GetNextVariant( pszToken, eTokenType, *this, m_pEncrypt );
         this->SetDirty( false );
 
         if( !bIsTrailer )
         {
-            bool gotToken = this->GetNextToken( pszToken );
+            bool gotToken = m_pTokenizer->GetNextToken( pszToken );
             if (!gotToken)
             {
                 PODOFO_RAISE_ERROR_INFO( ePdfError_UnexpectedEOF, "Expected 'endobj' or (if dict) 'stream', got EOF." );
@@ -204,7 +242,7 @@ void PdfParserObject::ParseFileComplete( bool bIsTrailer )
             else if( this->IsDictionary() && strncmp( pszToken, "stream", s_nLenStream ) == 0 )
             {
                 m_bStream = true;
-                m_lStreamOffset = m_device.Device()->Tell(); // NOTE: whitespace after "stream" handle in stream parser!
+                m_lStreamOffset = m_pTokenizer->GetDevice().Device()->Tell(); // NOTE: whitespace after "stream" handle in stream parser!
                 
                 // Most of the code relies on PdfObjects that are dictionaries
                 // to have the datatype ePdfDataType_Dictionary and not Stream.
@@ -235,37 +273,64 @@ void PdfParserObject::ParseStream()
     assert(!DelayedStreamLoadDone());
 #endif
 
+    pdf_long lOffset;
+    pdf_long lLen;
+
+    this->ReadStreamRange( lOffset, lLen );
+
+    m_pTokenizer->GetDevice().Device()->Seek( lOffset );	// reset it before reading!
+    PdfDeviceInputStream reader( m_pTokenizer->GetDevice().Device() );
+    if( m_pEncrypt )
+    {
+        m_pEncrypt->SetCurrentReference( m_reference );
+        PdfInputStream* pInput = m_pEncrypt->CreateEncryptionInputStream( &reader, lLen );
+        this->GetStream_NoDL()->SetRawData( pInput, lLen );
+        delete pInput;
+    }
+    else
+        this->GetStream_NoDL()->SetRawData( &reader, lLen );
+
+    this->SetDirty( false );
+    /*
+    SAFE_OP( GetNextStringFromFile( ) );
+    if( strncmp( m_buffer.Buffer(), "endstream", s_nLenEndStream ) != 0 )
+        return ERROR_PDF_MISSING_ENDSTREAM;
+    */
+}
+
+void PdfParserObject::ReadStreamRange( pdf_long & rlOffset, pdf_long & rlLength )
+{
     long long         lLen  = -1;
     int          c;
 
-    if( !m_device.Device() || !m_pOwner )
+    if( !m_pTokenizer->GetDevice().Device() || !m_pOwner )
     {
         PODOFO_RAISE_ERROR( ePdfError_InvalidHandle );
     }
 
-    m_device.Device()->Seek( m_lStreamOffset );
+    m_pTokenizer->GetDevice().Device()->Seek( m_lStreamOffset );
 
     // From the PDF Reference manual
     // The keyword stream that follows
     // the stream dictionary should be followed by an end-of-line marker consisting of
     // either a carriage return and a line feed or just a line feed, and not by a carriage re-
     // turn alone.
-    c = m_device.Device()->Look();
+    c = m_pTokenizer->GetDevice().Device()->Look();
     if( PdfTokenizer::IsWhitespace( c ) )
     {
-        c = m_device.Device()->GetChar();
+        c = m_pTokenizer->GetDevice().Device()->GetChar();
 
         if( c == '\r' )
         {
-            c = m_device.Device()->Look();
+            c = m_pTokenizer->GetDevice().Device()->Look();
             if( c == '\n' )
             {
-                c = m_device.Device()->GetChar();
+                c = m_pTokenizer->GetDevice().Device()->GetChar();
             }
         }
     } 
     
-    pdf_long fLoc = m_device.Device()->Tell();	// we need to save this, since loading the Length key could disturb it!
+    pdf_long fLoc = m_pTokenizer->GetDevice().Device()->Tell();	// we need to save this, since loading the Length key could disturb it!
 
     PdfObject* pObj = this->GetDictionary_NoDL().GetKey( PdfName::KeyLength );  
     if( pObj && pObj->IsNumber() )
@@ -312,24 +377,122 @@ void PdfParserObject::ParseStream()
         PODOFO_RAISE_ERROR( ePdfError_InvalidStreamLength );
     }
 
-    m_device.Device()->Seek( fLoc );	// reset it before reading!
-    PdfDeviceInputStream reader( m_device.Device() );
-    if( m_pEncrypt )
+    rlOffset = fLoc;
+    rlLength = static_cast<pdf_long>(lLen);
+}
+
+void PdfParserObject::CopyRawStream( PdfStream* pStream )
+{
+    if( !pStream )
     {
-        m_pEncrypt->SetCurrentReference( m_reference );
-        PdfInputStream* pInput = m_pEncrypt->CreateEncryptionInputStream( &reader );
-        this->GetStream_NoDL()->SetRawData( pInput, static_cast<pdf_long>(lLen) );
-        delete pInput;
+        PODOFO_RAISE_ERROR( ePdfError_InvalidHandle );
+    }
+
+    DelayedLoad();
+
+    PODOFO_RAISE_LOGIC_IF( !CanCopyRawStream(), "CopyRawStream() on an object whose stream was loaded or is encrypted" );
+
+    pdf_long lOffset;
+    pdf_long lLen;
+
+    try {
+        this->ReadStreamRange( lOffset, lLen );
+    } catch( PdfError & e ) {
+        std::ostringstream s;
+        s << "Unable to locate the stream for object " << Reference().ObjectNumber() << ' '
+          << Reference().GenerationNumber() << " obj .";
+        e.AddToCallstack( __FILE__, __LINE__, s.str().c_str());
+        throw e;
+    }
+
+    pStream->SetRawDataRange( m_pTokenizer->GetDevice(), lOffset, lLen );
+}
+
+pdf_long PdfParserObject::GetStreamWriteLength()
+{
+    DelayedLoad();
+
+    if( !this->CanCopyRawStream() )
+        return PdfObject::GetStreamWriteLength();
+
+    pdf_long lOffset;
+    pdf_long lLen;
+    bool     bDirty = this->IsDirty();
+
+    try {
+        this->ReadStreamRange( lOffset, lLen );
+    } catch( PdfError & e ) {
+        std::ostringstream s;
+        s << "Unable to locate the stream for object " << Reference().ObjectNumber() << ' '
+          << Reference().GenerationNumber() << " obj .";
+        e.AddToCallstack( __FILE__, __LINE__, s.str().c_str());
+        throw e;
+    }
+
+    // Loading the stream replaces an indirect /Length 
+    // by a direct one, so the dictionary has to look
+    // the same whether the stream is loaded or not.
+    this->GetDictionary_NoDL().AddKey( PdfName::KeyLength, static_cast<pdf_int64>(lLen) );
+    if( !bDirty )
+        this->SetDirty( false );
+
+    // "stream\n" and "\nendstream\n" as written by PdfMemStream::Write()
+    return 7 + lLen + 11;
+}
+
+pdf_long PdfParserObject::ReadRawStream( PdfRefCountedBuffer & rBuffer )
+{
+    DelayedLoad();
+
+    PODOFO_RAISE_LOGIC_IF( !m_bStream || m_pStream, "ReadRawStream() on an object without stream or whose stream was loaded" );
+
+    pdf_long lOffset;
+    pdf_long lLen;
+    pdf_long lRead = 0;
+
+    try {
+        this->ReadStreamRange( lOffset, lLen );
+
+        if( lLen > 0 ) 
+        {
+            rBuffer.Resize( lLen );
+
+            // Like ParseStream() accept truncated streams
+            m_pTokenizer->GetDevice().Device()->Seek( lOffset );
+            PdfDeviceInputStream reader( m_pTokenizer->GetDevice().Device() );
+            pdf_long             lCur;
+            while( lRead < lLen && (lCur = reader.Read( rBuffer.GetBuffer() + lRead, lLen - lRead )) > 0 )
+                lRead += lCur;
+        }
+    } catch( PdfError & e ) {
+        std::ostringstream s;
+        s << "Unable to read the stream for object " << Reference().ObjectNumber() << ' '
+          << Reference().GenerationNumber() << " obj .";
+        e.AddToCallstack( __FILE__, __LINE__, s.str().c_str());
+        throw e;
     }
-    else
-        this->GetStream_NoDL()->SetRawData( &reader, static_cast<pdf_long>(lLen) );
+
+    return lRead;
+}
+
+void PdfParserObject::LoadStream( const char* pBuffer, pdf_long lLen )
+{
+    DelayedLoad();
+
+    PODOFO_RAISE_LOGIC_IF( !m_bStream || m_pStream, "LoadStream() on an object without stream or whose stream was loaded" );
+
+    // Keep the filters of the stream, like ParseStream() does
+    TVecFilters vecEmpty;
+    PdfStream*  pStream = this->GetStream_NoDL();
+    pStream->BeginAppend( vecEmpty, true, false );
+    pStream->Append( pBuffer, lLen );
+    pStream->EndAppend();
 
     this->SetDirty( false );
-    /*
-    SAFE_OP( GetNextStringFromFile( ) );
-    if( strncmp( m_buffer.Buffer(), "endstream", s_nLenEndStream ) != 0 )
-        return ERROR_PDF_MISSING_ENDSTREAM;
-    */
+
+    // Flag the stream as loaded, DelayedStreamLoadImpl() does
+    // not read anything as m_pStream is set now
+    DelayedStreamLoad();
 }
 
 
@@ -396,4 +559,15 @@ void PdfParserObject::FreeObjectMemory( bool bForce )
     }
 }
 
+void PdfParserObject::FreeStreamMemory( bool bForce )
+{
+    if( this->IsLoadOnDemand() && (bForce || !this->IsDirty()) )
+    {
+        delete m_pStream;
+        m_pStream = NULL;
+
+        EnableDelayedStreamLoading();
+    }
+}
+
 };
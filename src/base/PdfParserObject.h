@@ -30,11 +30,80 @@ namespace PoDoFo {
 class PdfEncrypt;
 class PdfParser;
 
+/**
+ * The tokenizer used by PdfParserObject to read its data.
+ *
+ * A PdfParser creates a single PdfParserObjectTokenizer for its
+ * input device, which is shared by all objects it reads from
+ * this device, so that a PdfParserObject does not need a tokenizer
+ * of its own. The tokenizer is reference counted and deleted
+ * together with the last object using it.
+ */
+class PODOFO_API PdfParserObjectTokenizer : public PdfTokenizer {
+ public:
+    /** Create a new tokenizer with a reference count of 1.
+     *
+     *  \param rDevice the input device from which objects are read
+     *  \param rBuffer buffer to use for parsing to avoid reallocations
+     */
+    PdfParserObjectTokenizer( const PdfRefCountedInputDevice & rDevice, const PdfRefCountedBuffer & rBuffer );
+
+    /** Increase the reference count of this tokenizer.
+     */
+    inline void AddRef();
+
+    /** Decrease the reference count of this tokenizer
+     *  and delete it if it is not referenced anymore.
+     */
+    void Release();
+
+    /** Seek the input device to the given position and discard
+     *  all tokens still queued from reading another object.
+     *
+     *  \param lOffset position in the input device
+     */
+    void Seek( pdf_long lOffset );
+
+    /** \returns the input device from which objects are read
+     */
+    inline const PdfRefCountedInputDevice & GetDevice() const;
+
+    using PdfTokenizer::GetNextVariant;
+    using PdfTokenizer::ClearQueque;
+
+ private:
+    /** Use Release() to delete a PdfParserObjectTokenizer.
+     */
+    ~PdfParserObjectTokenizer();
+
+    PdfParserObjectTokenizer( const PdfParserObjectTokenizer & rhs );
+    const PdfParserObjectTokenizer & operator=( const PdfParserObjectTokenizer & rhs );
+
+ private:
+    long m_lRefCount;
+};
+
+// -----------------------------------------------------
+// 
+// -----------------------------------------------------
+void PdfParserObjectTokenizer::AddRef()
+{
+    ++m_lRefCount;
+}
+
+// -----------------------------------------------------
+// 
+// -----------------------------------------------------
+const PdfRefCountedInputDevice & PdfParserObjectTokenizer::GetDevice() const
+{
+    return m_device;
+}
+
 /**
  * A PdfParserObject constructs a PdfObject from a PDF file.
  * Parsing starts always at the current file position.
  */
-class PODOFO_API PdfParserObject : public PdfObject, public PdfTokenizer {
+class PODOFO_API PdfParserObject : public PdfObject {
 
  public:
     /** Parse the object data from the given file handle starting at
@@ -49,6 +118,18 @@ class PODOFO_API PdfParserObject : public PdfObject, public PdfTokenizer {
      */
     PdfParserObject( PdfVecObjects* pCreator, const PdfRefCountedInputDevice & rDevice, const PdfRefCountedBuffer & rBuffer, pdf_long lOffset = -1 );
 
+    /** Parse the object data using a tokenizer shared with other objects
+     *  read from the same input device.
+     *  \param pCreator pointer to a PdfVecObjects to resolve object references
+     *  \param pTokenizer the tokenizer to read the object from, whose input device
+     *                    is positioned in front of the object which is going to be parsed.
+     *                    The object keeps a reference to it.
+     *  \param lOffset the position in the device from which the object shall be read
+     *                 if lOffset = -1, the object will be read from the current 
+     *                 position in the file.
+     */
+    PdfParserObject( PdfVecObjects* pCreator, PdfParserObjectTokenizer* pTokenizer, pdf_long lOffset = -1 );
+
     /** Parse the object data for an internal object.
      *  You have to call ParseDictionaryKeys as next function call.
      *
@@ -81,6 +162,56 @@ class PODOFO_API PdfParserObject : public PdfObject, public PdfTokenizer {
      */
     inline bool HasStreamToParse() const;
 
+    /** \returns true if this object has a stream which has not been
+     *           loaded yet and is not encrypted, so that its still
+     *           encoded data can be copied using CopyRawStream().
+     */
+    inline bool CanCopyRawStream() const;
+
+    /** Set the still encoded data of this objects stream as raw data of
+     *  another stream using PdfStream::SetRawDataRange() without loading
+     *  it into memory. A PdfMemStream will copy it directly from the
+     *  input device of this object when it is written.
+     *
+     *  CanCopyRawStream() must return true.
+     *
+     *  \param pStream the stream which receives the data
+     */
+    void CopyRawStream( PdfStream* pStream );
+
+    /** Read the data of this objects stream from the input device
+     *  without loading the stream. The data is still encrypted
+     *  if the document is encrypted.
+     *
+     *  Together with LoadStream() this allows to read the streams
+     *  of many objects first and to decrypt and decode them on 
+     *  several threads, see PdfMemDocument::PreloadStreams().
+     *
+     *  HasStreamToParse() must return true and IsStreamLoaded() false.
+     *
+     *  \param rBuffer the data is stored into this buffer,
+     *                 which is resized as needed
+     *  \returns the number of bytes read into rBuffer
+     */
+    pdf_long ReadRawStream( PdfRefCountedBuffer & rBuffer );
+
+    /** Load the stream of this object from a buffer
+     *  instead of reading it from the input device.
+     *
+     *  HasStreamToParse() must return true and IsStreamLoaded() false.
+     *
+     *  \param pBuffer the decrypted data of the stream
+     *  \param lLen the length of pBuffer
+     *
+     *  \see ReadRawStream
+     */
+    void LoadStream( const char* pBuffer, pdf_long lLen );
+
+    /** \returns the encryption object used to decrypt strings
+     *           and the stream of this object or NULL
+     */
+    inline const PdfEncrypt* GetEncrypt() const;
+
     /** \returns true if this PdfParser loads all objects at
      *                the time they are accessed for the first time.
      *                The default is to load all object immediately.
@@ -119,6 +250,31 @@ class PODOFO_API PdfParserObject : public PdfObject, public PdfTokenizer {
      */
     void FreeObjectMemory( bool bForce = false );
 
+    /** Tries to free the memory allocated by the stream
+     *  of this PdfObject and reads it from disk again
+     *  if it is requested another time.
+     *
+     *  The same restrictions as for FreeObjectMemory() apply.
+     *
+     *  \param bForce if true the stream will be free'd
+     *                even if IsDirty() returns true.
+     *
+     *  \see FreeObjectMemory
+     */
+    void FreeStreamMemory( bool bForce = false );
+
+    /** \returns true if the data of this object has been read
+     *           from the input device already.
+     *  \see IsLoadOnDemand
+     */
+    inline bool IsLoaded() const;
+
+    /** \returns true if the stream of this object (if any) has
+     *           been read from the input device already.
+     *  \see IsLoadOnDemand
+     */
+    inline bool IsStreamLoaded() const;
+
  protected:
     /** Load all data of the object if load object on demand is enabled.
      *  Reimplemented from PdfVariant. Do not call this directly, use
@@ -132,6 +288,17 @@ class PODOFO_API PdfParserObject : public PdfObject, public PdfTokenizer {
      */
     virtual void DelayedStreamLoadImpl();
 
+    /** Get the length of the stream as written without loading it,
+     *  if it was not loaded yet and is not encrypted. The /Length key
+     *  is set to the parsed length as a direct object, as loading 
+     *  the stream would do.
+     *  Reimplemented from PdfObject.
+     *
+     *  
+eturns the length of the stream as written or 0 if there is no stream
+     */
+    virtual pdf_long GetStreamWriteLength();
+
     /** Starts reading at the file position m_lStreamOffset and interprets all bytes
      *  as contents of the objects stream.
      *  It is assumed that the dictionary has a valid /Length key already.
@@ -140,6 +307,14 @@ class PODOFO_API PdfParserObject : public PdfObject, public PdfTokenizer {
      */
     void ParseStream();
 
+    /** Starts reading at the file position m_lStreamOffset and finds the
+     *  position and length of the stream data, resolving an indirect /Length key.
+     *
+     *  \param rlOffset set to the position of the first byte of stream data
+     *  \param rlLength set to the length of the stream data
+     */
+    void ReadStreamRange( pdf_long & rlOffset, pdf_long & rlLength );
+
  private:
     /** Initialize private members in this object with their default values
      */
@@ -153,9 +328,13 @@ class PODOFO_API PdfParserObject : public PdfObject, public PdfTokenizer {
 
     void ReadObjectNumber();
 
+    PdfParserObject( const PdfParserObject & rhs );
+    const PdfParserObject & operator=( const PdfParserObject & rhs );
+
  private:
-    PdfEncrypt* m_pEncrypt;
-    bool        m_bIsTrailer;
+    PdfParserObjectTokenizer* m_pTokenizer;
+    PdfEncrypt*               m_pEncrypt;
+    bool                      m_bIsTrailer;
 
     // Should the object try to defer loading of its contents until needed?
     // If false, object contents will be loaded during ParseFile(...). Note that
@@ -166,9 +345,9 @@ class PODOFO_API PdfParserObject : public PdfObject, public PdfTokenizer {
     // of operation.
     bool m_bLoadOnDemand;
 
-    pdf_long m_lOffset;
-
     bool m_bStream;
+
+    pdf_long m_lOffset;
     pdf_long m_lStreamOffset;
 };
 
@@ -196,6 +375,22 @@ void PdfParserObject::SetLoadOnDemand( bool bDelayed )
     m_bLoadOnDemand = bDelayed;
 }
 
+// -----------------------------------------------------
+// 
+// -----------------------------------------------------
+bool PdfParserObject::IsLoaded() const
+{
+    return DelayedLoadDone();
+}
+
+// -----------------------------------------------------
+// 
+// -----------------------------------------------------
+bool PdfParserObject::IsStreamLoaded() const
+{
+    return DelayedStreamLoadDone();
+}
+
 // -----------------------------------------------------
 // 
 // -----------------------------------------------------
@@ -204,6 +399,26 @@ bool PdfParserObject::HasStreamToParse() const
     return m_bStream;
 }
 
+// -----------------------------------------------------
+// 
+// -----------------------------------------------------
+const PdfEncrypt* PdfParserObject::GetEncrypt() const
+{
+    return m_pEncrypt;
+}
+
+// -----------------------------------------------------
+// 
+// -----------------------------------------------------
+bool PdfParserObject::CanCopyRawStream() const
+{
+    // m_bStream is only known after the object was parsed
+    DelayedLoad();
+
+    // Note: test m_pStream directly as HasStream() would load the stream
+    return m_bStream && !m_pStream && !m_pEncrypt && m_pTokenizer->GetDevice().Device() != NULL;
+}
+
 };
 
 #endif // _PDF_PARSER_OBJECT_H_
@@ -21,6 +21,7 @@
 #include "PdfRefCountedBuffer.h"
 #include "PdfDefinesPrivate.h"
 
+#include <stddef.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -31,16 +32,34 @@ PdfRefCountedBuffer::PdfRefCountedBuffer( char* pBuffer, size_t lSize )
 {
     if( pBuffer && lSize ) 
     {
-        m_pBuffer = new TRefCountedBuffer();
-        m_pBuffer->m_lRefCount     = 1;
+        m_pBuffer = AllocateControlBlock( 0 );
         m_pBuffer->m_pHeapBuffer   = pBuffer;
         m_pBuffer->m_bOnHeap       = true;
         m_pBuffer->m_lBufferSize   = lSize;
         m_pBuffer->m_lVisibleSize  = lSize;
-        m_pBuffer->m_bPossesion    = true;
     }
 }
 
+PdfRefCountedBuffer::TRefCountedBuffer* PdfRefCountedBuffer::AllocateControlBlock( size_t lSize )
+{
+    const size_t lAllocSize = PDF_MAX( offsetof( TRefCountedBuffer, m_sInternalBuffer ) + lSize, 
+                                       sizeof(TRefCountedBuffer) );
+    TRefCountedBuffer* pBuffer = static_cast<TRefCountedBuffer*>(malloc( lAllocSize ));
+    if( !pBuffer ) 
+    {
+        PODOFO_RAISE_ERROR( ePdfError_OutOfMemory );
+    }
+
+    pBuffer->m_lBufferSize  = lSize;
+    pBuffer->m_lVisibleSize = lSize;
+    pBuffer->m_lRefCount    = 1;
+    pBuffer->m_pHeapBuffer  = NULL;
+    pBuffer->m_bPossesion   = true;
+    pBuffer->m_bOnHeap      = false;
+
+    return pBuffer;
+}
+
 void PdfRefCountedBuffer::FreeBuffer()
 {
     PODOFO_RAISE_LOGIC_IF( !m_pBuffer || m_pBuffer->m_lRefCount, "Tried to free in-use buffer" );
@@ -48,32 +67,15 @@ void PdfRefCountedBuffer::FreeBuffer()
     // last owner of the file!
     if( m_pBuffer->m_bOnHeap && m_pBuffer->m_bPossesion )
         free( m_pBuffer->m_pHeapBuffer );
-    delete m_pBuffer;
+    free( m_pBuffer );
 }
 
 void PdfRefCountedBuffer::ReallyDetach( size_t lExtraLen )
 {
     PODOFO_RAISE_LOGIC_IF( m_pBuffer && m_pBuffer->m_lRefCount == 1, "Use Detach() rather than calling ReallyDetach() directly." )
 
-    size_t lSize                 = m_pBuffer->m_lBufferSize + lExtraLen; 
-    TRefCountedBuffer* pBuffer = new TRefCountedBuffer();
-    pBuffer->m_lRefCount       = 1;
-
-    pBuffer->m_bOnHeap = (lSize > TRefCountedBuffer::INTERNAL_BUFSIZE);
-    if ( pBuffer->m_bOnHeap )
-        pBuffer->m_pHeapBuffer  = static_cast<char*>(malloc( sizeof(char)*lSize ));
-    else
-        pBuffer->m_pHeapBuffer = 0;
-    pBuffer->m_lBufferSize     = PDF_MAX( lSize, static_cast<size_t>(+TRefCountedBuffer::INTERNAL_BUFSIZE) );
-    pBuffer->m_bPossesion      = true;
-
-    if( pBuffer->m_bOnHeap && !pBuffer->m_pHeapBuffer ) 
-    {
-        delete pBuffer;
-        pBuffer = NULL;
-
-        PODOFO_RAISE_ERROR( ePdfError_OutOfMemory );
-    }
+    size_t             lSize   = m_pBuffer->m_lBufferSize + lExtraLen; 
+    TRefCountedBuffer* pBuffer = AllocateControlBlock( lSize );
 
     memcpy( pBuffer->GetRealBuffer(), this->GetBuffer(), this->GetSize() );
     // Detaching the buffer should have NO visible effect to clients, so the
@@ -113,22 +115,27 @@ void PdfRefCountedBuffer::ReallyResize( const size_t lSize )
                 m_pBuffer->m_pHeapBuffer = static_cast<char*>(temp);
                 m_pBuffer->m_lBufferSize = lAllocSize;
             }
-            else
+            else if( !m_pBuffer->m_bOnHeap ) 
             {
-                // Either we don't own the buffer or it's a local static buffer that's no longer big enough.
-                // Either way, it's time to move to a heap-allocated buffer we own.
-                char* pBuffer = static_cast<char*>(malloc( sizeof(char) * lAllocSize ));
-                if( !pBuffer ) 
+                // The buffer is part of the control block, which is
+                // solely owned by us after Detach(). Realloc() the whole block.
+                void* temp = realloc( m_pBuffer, offsetof( TRefCountedBuffer, m_sInternalBuffer ) + lAllocSize );
+                if (!temp)
                 {
                     PODOFO_RAISE_ERROR_INFO( ePdfError_OutOfMemory, "PdfRefCountedBuffer::Resize failed!" );
                 }
+                m_pBuffer = static_cast<TRefCountedBuffer*>(temp);
+                m_pBuffer->m_lBufferSize = lAllocSize;
+            }
+            else
+            {
+                // We don't own the buffer, so it's time to move to a buffer we own.
+                TRefCountedBuffer* pBuffer = AllocateControlBlock( lAllocSize );
                 // Only bother copying the visible portion of the buffer. It's completely incorrect
                 // to rely on anything more than that, and not copying it will help catch those errors.
-                memcpy( pBuffer, m_pBuffer->GetRealBuffer(), m_pBuffer->m_lVisibleSize );
-                // Record the newly allocated buffer's details. The visible size gets updated later.
-                m_pBuffer->m_lBufferSize = lAllocSize;
-                m_pBuffer->m_pHeapBuffer = pBuffer;
-                m_pBuffer->m_bOnHeap = true;
+                memcpy( pBuffer->GetRealBuffer(), m_pBuffer->GetRealBuffer(), m_pBuffer->m_lVisibleSize );
+                free( m_pBuffer );
+                m_pBuffer = pBuffer;
             }
         }
         else
@@ -139,28 +146,7 @@ void PdfRefCountedBuffer::ReallyResize( const size_t lSize )
     else
     {
         // No buffer was allocated at all, so we need to make one.
-        m_pBuffer = new TRefCountedBuffer();
-        m_pBuffer->m_lRefCount       = 1;
-        m_pBuffer->m_bOnHeap   = (lSize > TRefCountedBuffer::INTERNAL_BUFSIZE);
-        if ( m_pBuffer->m_bOnHeap )
-        {
-            m_pBuffer->m_pHeapBuffer = static_cast<char*>(malloc( sizeof(char)*lSize ));
-        }
-        else
-        {
-            m_pBuffer->m_pHeapBuffer = 0;
-        }
-
-        m_pBuffer->m_lBufferSize     = PDF_MAX( lSize, static_cast<size_t>(+TRefCountedBuffer::INTERNAL_BUFSIZE) );
-        m_pBuffer->m_bPossesion      = true;
-
-        if( m_pBuffer->m_bOnHeap && !m_pBuffer->m_pHeapBuffer ) 
-        {
-            delete m_pBuffer;
-            m_pBuffer = NULL;
-
-            PODOFO_RAISE_ERROR( ePdfError_OutOfMemory );
-        }
+        m_pBuffer = AllocateControlBlock( lSize );
     }
     m_pBuffer->m_lVisibleSize = lSize;
 
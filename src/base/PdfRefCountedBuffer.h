@@ -172,28 +172,42 @@ class PODOFO_API PdfRefCountedBuffer {
     void ReallyResize( size_t lSize );
 
  private:
+    /** The control block of a buffer. Buffers allocated
+     *  by PdfRefCountedBuffer itself are stored directly
+     *  behind the control block, so that a buffer takes
+     *  only a single allocation. Only buffers passed to the
+     *  constructor are kept in a separate heap buffer.
+     */
     struct TRefCountedBuffer {
-        enum { INTERNAL_BUFSIZE = 32 };
         // Convenience inline for buffer switching
         PODOFO_NOTHROW inline char * GetRealBuffer() { 
             return m_bOnHeap? m_pHeapBuffer : &(m_sInternalBuffer[0]);
         }
-        // size in bytes of the buffer. If and only if this is strictly >INTERNAL_BUFSIZE,
-        // this buffer is on the heap in memory pointed to by m_pHeapBuffer . If it is <=INTERNAL_BUFSIZE,
-        // the buffer is in the in-object buffer m_sInternalBuffer.
+        // size in bytes of the buffer, which is either m_sInternalBuffer
+        // or - if m_bOnHeap is set - the memory pointed to by m_pHeapBuffer.
         size_t  m_lBufferSize;
         // Size in bytes of m_pBuffer that should be reported to clients. We
-        // over-allocate on the heap for efficiency and have a minimum 32 byte
-        // size, but this extra should NEVER be visible to a client.
+        // over-allocate for efficiency, but this extra should NEVER be visible to a client.
         size_t  m_lVisibleSize;
         long  m_lRefCount;
         char* m_pHeapBuffer;
-        char  m_sInternalBuffer[INTERNAL_BUFSIZE];
         bool  m_bPossesion;
-        // Are we using the heap-allocated buffer in place of our small internal one?
+        // Are we using the heap-allocated buffer in place of our internal one?
         bool  m_bOnHeap;
+        // The internal buffer, which is allocated along with the
+        // control block and extends beyond the end of the struct
+        char  m_sInternalBuffer[1];
     };
 
+    /** Allocate a new control block with a reference count of 1
+     *  and an internal buffer of lSize bytes.
+     *
+     *  \param lSize size of the internal buffer
+     *  \returns a new control block, which has to be freed using free()
+     */
+    static TRefCountedBuffer* AllocateControlBlock( size_t lSize );
+
+ private:
     TRefCountedBuffer* m_pBuffer;
 };
 
@@ -52,7 +52,7 @@ class PODOFO_API PdfReference : public PdfDataType {
      * initialized to 0.
      */
     PdfReference()
-        : m_nObjectNo( 0 ), m_nGenerationNo( 0 )
+        : m_nGenerationNo( 0 ), m_nObjectNo( 0 )
     {
     }
 
@@ -63,7 +63,7 @@ class PODOFO_API PdfReference : public PdfDataType {
      * \param nGenerationNo the generation number
      */
     PdfReference( const pdf_objnum nObjectNo, const pdf_gennum nGenerationNo )
-        : m_nObjectNo( nObjectNo ), m_nGenerationNo( nGenerationNo ) 
+        : m_nGenerationNo( nGenerationNo ), m_nObjectNo( nObjectNo ) 
     {
     }
 
@@ -153,8 +153,10 @@ class PODOFO_API PdfReference : public PdfDataType {
     PODOFO_NOTHROW inline bool IsIndirect() const;
 
  private:
-    pdf_objnum    m_nObjectNo;
+    // The generation number is declared first, so that both
+    // numbers fit into the padding at the end of PdfDataType
     pdf_gennum    m_nGenerationNo;
+    pdf_objnum    m_nObjectNo;
 };
 
 // -----------------------------------------------------
@@ -25,6 +25,8 @@
 #include "PdfInputStream.h"
 #include "PdfOutputStream.h"
 #include "PdfOutputDevice.h"
+#include "PdfInputDevice.h"
+#include "PdfRefCountedInputDevice.h"
 #include "PdfDefinesPrivate.h"
 
 #include <iostream>
@@ -44,6 +46,14 @@ PdfStream::~PdfStream()
 {
 }
 
+pdf_long PdfStream::GetWriteLength( PdfEncrypt* pEncrypt ) const
+{
+    PdfOutputDevice device;
+
+    const_cast<PdfStream*>(this)->Write( &device, pEncrypt );
+    return device.GetLength();
+}
+
 void PdfStream::GetFilteredCopy( PdfOutputStream* pStream ) const
 {
     TVecFilters      vecFilters    = PdfFilterFactory::CreateFilterList( m_pParent );
@@ -175,6 +185,18 @@ void PdfStream::SetRawData( PdfInputStream* pStream, pdf_long lLen )
     this->EndAppend();
 }
 
+void PdfStream::SetRawDataRange( const PdfRefCountedInputDevice & rDevice, pdf_long lOffset, pdf_long lLen )
+{
+    if( !rDevice.Device() )
+    {
+        PODOFO_RAISE_ERROR( ePdfError_InvalidHandle );
+    }
+
+    rDevice.Device()->Seek( lOffset );
+    PdfDeviceInputStream reader( rDevice.Device() );
+    this->SetRawData( &reader, lLen );
+}
+
 void PdfStream::BeginAppend( bool bClearExisting )
 {
     TVecFilters vecFilters;
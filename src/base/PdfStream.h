@@ -35,6 +35,7 @@ class PdfInputStream;
 class PdfName;
 class PdfObject;
 class PdfOutputStream;
+class PdfRefCountedInputDevice;
 
 /** A PDF stream can be appended to any PdfObject
  *  and can contain arbitrary data.
@@ -66,6 +67,17 @@ class PODOFO_API PdfStream {
      */
     virtual void Write( PdfOutputDevice* pDevice, PdfEncrypt* pEncrypt = NULL ) = 0;
 
+    /** Get the number of bytes Write() would write to an output device.
+     *
+     *  The default implementation writes the stream to a PdfOutputDevice
+     *  which only counts bytes. Subclasses which know the length of their 
+     *  data should override this, so that no data has to be copied.
+     *
+     *  \param pEncrypt encrypt stream data using this object
+     *  \returns the number of bytes written by Write()
+     */
+    virtual pdf_long GetWriteLength( PdfEncrypt* pEncrypt = NULL ) const;
+
     /** Set a binary buffer as stream data.
      *
      * Use PdfFilterFactory::CreateFilterList if you want to use the contents
@@ -120,6 +132,20 @@ class PODOFO_API PdfStream {
      */
     void SetRawData( PdfInputStream* pStream, pdf_long lLen = -1 );
 
+    /** Sets raw data for this stream which is located in an input device.
+     *  Like SetRawData() the data is neither encoded nor decoded and
+     *  has to be encoded as stated by the /Filters key in the streams object.
+     *
+     *  The default implementation copies the data immediately.
+     *  A PdfMemStream only keeps a reference to the device and
+     *  copies the data directly to the output device when it is written.
+     *
+     *  \param rDevice read data from this input device
+     *  \param lOffset position of the first byte of data in the device
+     *  \param lLen    number of bytes to read from the device
+     */
+    virtual void SetRawDataRange( const PdfRefCountedInputDevice & rDevice, pdf_long lOffset, pdf_long lLen );
+
     /** Start appending data to this stream.
      *
      *  This method has to be called before any of the append methods.
@@ -40,6 +40,21 @@
 #include <string.h>
 #include <wchar.h>
 
+// Vector kernels for the ASCII fast paths of the UTF-8/UTF-16 conversion.
+// SSE2 is part of every x86-64 CPU, AVX2 is only used if the CPU reports it.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  define PODOFO_UTF_SSE2
+#  include <emmintrin.h>
+#  if (defined(__x86_64__) || defined(__i386__)) && \
+      (defined(__clang__) || (defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))))
+#    define PODOFO_UTF_AVX2
+#    include <immintrin.h>
+#  endif
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#  define PODOFO_UTF_NEON
+#  include <arm_neon.h>
+#endif
+
 namespace PoDoFo {
 
 namespace PdfStringNameSpace {
@@ -79,18 +94,18 @@ const char* PdfString::s_pszUnicodeMarkerHex = "FEFF";
 
 
 PdfString::PdfString()
-    : m_bHex( false ), m_bUnicode( false ), m_pEncoding( NULL )
+    : m_bHex( false ), m_bUnicode( false ), m_nSmallSize( 0 ), m_pUtf8( NULL ), m_pEncoding( NULL )
 {
 }
 
 PdfString::PdfString( const std::string& sString, const PdfEncoding * const pEncoding )
-    : m_bHex( false ), m_bUnicode( false ), m_pEncoding( pEncoding )
+    : m_bHex( false ), m_bUnicode( false ), m_nSmallSize( 0 ), m_pUtf8( NULL ), m_pEncoding( pEncoding )
 {
     Init( sString.c_str(), sString.length() );
 }
 
 PdfString::PdfString( const char* pszString, const PdfEncoding * const pEncoding )
-    : m_bHex( false ), m_bUnicode( false ), m_pEncoding( pEncoding )
+    : m_bHex( false ), m_bUnicode( false ), m_nSmallSize( 0 ), m_pUtf8( NULL ), m_pEncoding( pEncoding )
 {
     if( pszString )
         Init( pszString, strlen( pszString ) );
@@ -99,7 +114,7 @@ PdfString::PdfString( const char* pszString, const PdfEncoding * const pEncoding
 #if defined(_MSC_VER)  &&  _MSC_VER <= 1200			// nicht fr Visualstudio 6
 #else
 PdfString::PdfString( const wchar_t* pszString )
-    : m_bHex( false ), m_bUnicode( true ), m_pEncoding( NULL )
+    : m_bHex( false ), m_bUnicode( true ), m_nSmallSize( 0 ), m_pUtf8( NULL ), m_pEncoding( NULL )
 {
     if( pszString )
     {
@@ -108,15 +123,15 @@ PdfString::PdfString( const wchar_t* pszString )
         {
             // We have UTF16
             lLen *= sizeof(wchar_t);
-            m_buffer = PdfRefCountedBuffer( lLen + 2 );
-            memcpy( m_buffer.GetBuffer(), pszString, lLen );
-            m_buffer.GetBuffer()[lLen] = '\0';
-            m_buffer.GetBuffer()[lLen+1] = '\0';
+            char* pBuffer = this->AllocateBuffer( lLen + 2 );
+            memcpy( pBuffer, pszString, lLen );
+            pBuffer[lLen] = '\0';
+            pBuffer[lLen+1] = '\0';
             
             // if the buffer is a UTF-16LE string
             // convert it to UTF-16BE
 #ifdef PODOFO_IS_LITTLE_ENDIAN
-            SwapBytes( m_buffer.GetBuffer(), lLen );
+            SwapBytes( pBuffer, lLen );
 #endif // PODOFO_IS_LITTLE_ENDIA
         }
         else
@@ -144,30 +159,30 @@ PdfString::PdfString( const wchar_t* pszString )
 #endif
 
 PdfString::PdfString( const char* pszString, pdf_long lLen, bool bHex, const PdfEncoding * const pEncoding )
-    : m_bHex( bHex ), m_bUnicode( false ), m_pEncoding( pEncoding )
+    : m_bHex( bHex ), m_bUnicode( false ), m_nSmallSize( 0 ), m_pUtf8( NULL ), m_pEncoding( pEncoding )
 {
     if( pszString )
         Init( pszString, lLen );
 }
 
 PdfString::PdfString( const pdf_utf8* pszStringUtf8 )
-    : m_bHex( false ), m_bUnicode( true ), m_pEncoding( NULL )
+    : m_bHex( false ), m_bUnicode( true ), m_nSmallSize( 0 ), m_pUtf8( NULL ), m_pEncoding( NULL )
 {
     InitFromUtf8( pszStringUtf8, strlen( reinterpret_cast<const char*>(pszStringUtf8) ) );
 
-    m_sUtf8 = reinterpret_cast<const char*>(pszStringUtf8);
+    m_pUtf8 = new std::string( reinterpret_cast<const char*>(pszStringUtf8) );
 }
 
 PdfString::PdfString( const pdf_utf8* pszStringUtf8, pdf_long lLen )
-    : m_bHex( false ), m_bUnicode( true ), m_pEncoding( NULL )
+    : m_bHex( false ), m_bUnicode( true ), m_nSmallSize( 0 ), m_pUtf8( NULL ), m_pEncoding( NULL )
 {
     InitFromUtf8( pszStringUtf8, lLen );
 
-    m_sUtf8.assign( reinterpret_cast<const char*>(pszStringUtf8), lLen );
+    m_pUtf8 = new std::string( reinterpret_cast<const char*>(pszStringUtf8), lLen );
 }
 
 PdfString::PdfString( const pdf_utf16be* pszStringUtf16 )
-    : m_bHex( false ), m_bUnicode( true ), m_pEncoding( NULL )
+    : m_bHex( false ), m_bUnicode( true ), m_nSmallSize( 0 ), m_pUtf8( NULL ), m_pEncoding( NULL )
 {
     pdf_long               lBufLen = 0;
     const pdf_utf16be* pszCnt  = pszStringUtf16;
@@ -180,14 +195,14 @@ PdfString::PdfString( const pdf_utf16be* pszStringUtf16 )
 
     lBufLen *= sizeof(pdf_utf16be);
 
-    m_buffer = PdfRefCountedBuffer( lBufLen + sizeof(pdf_utf16be) );
-    memcpy( m_buffer.GetBuffer(), reinterpret_cast<const char*>(pszStringUtf16), lBufLen );
-    m_buffer.GetBuffer()[lBufLen] = '\0';
-    m_buffer.GetBuffer()[lBufLen+1] = '\0';
+    char* pBuffer = this->AllocateBuffer( lBufLen + sizeof(pdf_utf16be) );
+    memcpy( pBuffer, reinterpret_cast<const char*>(pszStringUtf16), lBufLen );
+    pBuffer[lBufLen] = '\0';
+    pBuffer[lBufLen+1] = '\0';
 }
 
 PdfString::PdfString( const pdf_utf16be* pszStringUtf16, pdf_long lLen )
-    : m_bHex( false ), m_bUnicode( true ), m_pEncoding( NULL )
+    : m_bHex( false ), m_bUnicode( true ), m_nSmallSize( 0 ), m_pUtf8( NULL ), m_pEncoding( NULL )
 {
     pdf_long               lBufLen = 0;
     const pdf_utf16be* pszCnt  = pszStringUtf16;
@@ -200,20 +215,21 @@ PdfString::PdfString( const pdf_utf16be* pszStringUtf16, pdf_long lLen )
 
     lBufLen *= sizeof(pdf_utf16be);
 
-    m_buffer = PdfRefCountedBuffer( lBufLen + sizeof(pdf_utf16be) );
-    memcpy( m_buffer.GetBuffer(), reinterpret_cast<const char*>(pszStringUtf16), lBufLen );
-    m_buffer.GetBuffer()[lBufLen] = '\0';
-    m_buffer.GetBuffer()[lBufLen+1] = '\0';
+    char* pBuffer = this->AllocateBuffer( lBufLen + sizeof(pdf_utf16be) );
+    memcpy( pBuffer, reinterpret_cast<const char*>(pszStringUtf16), lBufLen );
+    pBuffer[lBufLen] = '\0';
+    pBuffer[lBufLen+1] = '\0';
 }
 
 PdfString::PdfString( const PdfString & rhs )
-    : PdfDataType(), m_bHex( false ), m_bUnicode( false ), m_pEncoding( NULL )
+    : PdfDataType(), m_bHex( false ), m_bUnicode( false ), m_nSmallSize( 0 ), m_pUtf8( NULL ), m_pEncoding( NULL )
 {
     this->operator=( rhs );
 }
 
 PdfString::~PdfString()
 {
+    delete m_pUtf8;
 }
 
 void PdfString::SetHexData( const char* pszHex, pdf_long lLen, PdfEncrypt* pEncrypt )
@@ -230,9 +246,9 @@ void PdfString::SetHexData( const char* pszHex, pdf_long lLen, PdfEncrypt* pEncr
 
     // Allocate a buffer large enough for the hex decoded data
     // and the 2 terminating zeros
-    m_buffer = PdfRefCountedBuffer( lLen % 2 ? ((lLen + 1) >> 1) + 2 : (lLen >> 1) + 2 );
-    m_bHex   = true;
-    char* pBuffer = m_buffer.GetBuffer();
+    char* pBuffer = this->AllocateBuffer( lLen % 2 ? ((lLen + 1) >> 1) + 2 : (lLen >> 1) + 2 );
+    char* pStart  = pBuffer;
+    m_bHex        = true;
     char val;
     char cDecodedByte = 0;
     bool bLow = true;
@@ -276,30 +292,31 @@ void PdfString::SetHexData( const char* pszHex, pdf_long lLen, PdfEncrypt* pEncr
 
     // If the allocated internal buffer is too big (e.g. because of whitespaces in the data)
     // copy to a smaller buffer so that PdfString::GetLength() will be correct
-    lLen = pBuffer - m_buffer.GetBuffer();
-    if( static_cast<size_t>(lLen) != m_buffer.GetSize() )
-    {
-        PdfRefCountedBuffer temp( lLen );
-        memcpy( temp.GetBuffer(), m_buffer.GetBuffer(), lLen );
-        m_buffer = temp;
-    }
+    lLen = pBuffer - pStart;
+    if( lLen != this->GetBufferSize() )
+        this->SetBuffer( pStart, lLen );
 
-    // P.Zent: Encrypt function needs to know the length of the buffer not counting the offset
     if( pEncrypt )
-        pEncrypt->Encrypt( reinterpret_cast<unsigned char*>(m_buffer.GetBuffer()), 
-                           static_cast<unsigned int>(m_buffer.GetSize()-2) - pEncrypt->CalculateStreamOffset() );
+    {
+        // The decrypted data is shorter for AES, as the initial vector and padding are removed
+        pdf_long            lDecrypted = 0;
+        PdfRefCountedBuffer temp( this->GetBufferSize() );
+
+        pEncrypt->Decrypt( reinterpret_cast<const unsigned char*>(this->GetBuffer()), this->GetBufferSize() - 2, 
+                           reinterpret_cast<unsigned char*>(temp.GetBuffer()), lDecrypted );
+
+        temp.GetBuffer()[lDecrypted]   = '\0';
+        temp.GetBuffer()[lDecrypted+1] = '\0';
+        this->SetBuffer( temp.GetBuffer(), lDecrypted + 2 );
+    }
 
     // Now check for the first two bytes, to see if we got a unicode string
-    if( m_buffer.GetSize()-2 > 2 ) 
+    if( this->GetBufferSize()-2 > 2 ) 
     {
-		m_bUnicode = (m_buffer.GetBuffer()[0] == static_cast<char>(0xFE) && m_buffer.GetBuffer()[1] == static_cast<char>(0xFF));
+		m_bUnicode = (this->GetBuffer()[0] == static_cast<char>(0xFE) && this->GetBuffer()[1] == static_cast<char>(0xFF));
 		
 		if( m_bUnicode ) 
-        {
-            PdfRefCountedBuffer temp( m_buffer.GetSize() - 2 );
-            memcpy( temp.GetBuffer(), m_buffer.GetBuffer() + 2, m_buffer.GetSize() - 2 );
-            m_buffer = temp;           
-        }
+            this->SetBuffer( this->GetBuffer() + 2, this->GetBufferSize() - 2 );
     }
 }
 
@@ -309,9 +326,9 @@ void PdfString::Write ( PdfOutputDevice* pDevice, EPdfWriteMode eWriteMode, cons
     // this case has to be handled!
 
     // Peter Petrov: 17 May 2008
-    // Added check - m_buffer.GetSize()
+    // Added check - GetBufferSize()
     // Now we are not encrypting the empty strings (was access violation)!
-    if( pEncrypt && m_buffer.GetSize()) 
+    if( pEncrypt && this->GetBufferSize()) 
     {
         pdf_long nOffset = pEncrypt->CalculateStreamOffset();
         pdf_long nLen = this->GetLength();
@@ -345,11 +362,11 @@ void PdfString::Write ( PdfOutputDevice* pDevice, EPdfWriteMode eWriteMode, cons
         return;
     }
 
-    pDevice->Print( m_bHex ? "<" : "(" );
-    if( m_buffer.GetSize() )
+    pDevice->Write( m_bHex ? "<" : "(", 1 );
+    if( this->GetBufferSize() )
     {
-        char* pBuf = m_buffer.GetBuffer();
-        pdf_long  lLen = m_buffer.GetSize() - 2;
+        const char* pBuf = this->GetBuffer();
+        pdf_long    lLen = this->GetBufferSize() - 2;
 
         if( m_bHex ) 
         {
@@ -395,16 +412,28 @@ void PdfString::Write ( PdfOutputDevice* pDevice, EPdfWriteMode eWriteMode, cons
         }
     }
 
-    pDevice->Print( m_bHex ? ">" : ")" );
+    pDevice->Write( m_bHex ? ">" : ")", 1 );
 }
 
 const PdfString & PdfString::operator=( const PdfString & rhs )
 {
-    this->m_bHex      = rhs.m_bHex;
-    this->m_bUnicode  = rhs.m_bUnicode;
-    this->m_buffer    = rhs.m_buffer;
-    this->m_sUtf8     = rhs.m_sUtf8;
-    this->m_pEncoding = rhs.m_pEncoding;
+    if( this == &rhs )
+        return *this;
+
+    this->m_bHex       = rhs.m_bHex;
+    this->m_bUnicode   = rhs.m_bUnicode;
+    this->m_nSmallSize = rhs.m_nSmallSize;
+    if( m_nSmallSize ) 
+    {
+        memcpy( m_sSmallBuffer, rhs.m_sSmallBuffer, m_nSmallSize );
+        this->m_buffer = PdfRefCountedBuffer();
+    }
+    else
+        this->m_buffer = rhs.m_buffer;
+
+    delete m_pUtf8;
+    this->m_pUtf8      = rhs.m_pUtf8 ? new std::string( *rhs.m_pUtf8 ) : NULL;
+    this->m_pEncoding  = rhs.m_pEncoding;
 
     return *this;
 }
@@ -469,7 +498,8 @@ bool PdfString::operator==( const PdfString & rhs ) const
         str2 = str2.ToUnicode();
     }
 
-    return str1.m_buffer == str2.m_buffer;
+    return str1.GetBufferSize() == str2.GetBufferSize() &&
+        (!str1.GetBufferSize() || memcmp( str1.GetBuffer(), str2.GetBuffer(), str1.GetBufferSize() ) == 0);
 }
 
 void PdfString::Init( const char* pszString, pdf_long lLen )
@@ -503,16 +533,16 @@ void PdfString::Init( const char* pszString, pdf_long lLen )
     }
 
     
-    m_buffer = PdfRefCountedBuffer( lLen + 2 );
-    memcpy( m_buffer.GetBuffer(), pszString, lLen );
-    m_buffer.GetBuffer()[lLen] = '\0';
-    m_buffer.GetBuffer()[lLen+1] = '\0';
+    char* pBuffer = this->AllocateBuffer( lLen + 2 );
+    memcpy( pBuffer, pszString, lLen );
+    pBuffer[lLen] = '\0';
+    pBuffer[lLen+1] = '\0';
 
     // if the buffer is a UTF-16LE string
     // convert it to UTF-16BE
     if( bUft16LE ) 
     {
-        SwapBytes( m_buffer.GetBuffer(), lLen );
+        SwapBytes( pBuffer, lLen );
     }
 }
 
@@ -530,15 +560,21 @@ void PdfString::InitFromUtf8( const pdf_utf8* pszStringUtf8, pdf_long lLen )
     lBufLen = PdfString::ConvertUTF8toUTF16( pszStringUtf8, lLen, pBuffer, lBufLen );
 
     lBufLen = (lBufLen-1) << 1; // lBufLen is the number of characters, we need the number of bytes now!
-    m_buffer = PdfRefCountedBuffer( lBufLen + sizeof(pdf_utf16be) );
-    memcpy( m_buffer.GetBuffer(), reinterpret_cast<const char*>(pBuffer), lBufLen );
-    m_buffer.GetBuffer()[lBufLen] = '\0';
-    m_buffer.GetBuffer()[lBufLen+1] = '\0';
+    char* pData = this->AllocateBuffer( lBufLen + sizeof(pdf_utf16be) );
+    memcpy( pData, reinterpret_cast<const char*>(pBuffer), lBufLen );
+    pData[lBufLen] = '\0';
+    pData[lBufLen+1] = '\0';
 }
 
 void PdfString::InitUtf8()
 {
-    if( this->IsUnicode() )
+    std::string sUtf8;
+
+    if( !this->IsValid() || !(this->GetBufferSize() - 2) )
+    {
+        // Invalid and empty strings have an empty UTF8 version
+    }
+    else if( this->IsUnicode() )
     {
         // we can convert UTF16 to UTF8
         // UTF8 is at maximum 5 * characterlenght.
@@ -550,20 +586,60 @@ void PdfString::InitUtf8()
             PODOFO_RAISE_ERROR( ePdfError_OutOfMemory );
         }
 
-        pdf_long lUtf8 = PdfString::ConvertUTF16toUTF8( reinterpret_cast<const pdf_utf16be*>(m_buffer.GetBuffer()), 
+        pdf_long lUtf8 = PdfString::ConvertUTF16toUTF8( reinterpret_cast<const pdf_utf16be*>(this->GetBuffer()), 
                                                     this->GetUnicodeLength(), 
                                                     reinterpret_cast<pdf_utf8*>(pBuffer), lBufferLen, ePdfStringConversion_Lenient );
 
         pBuffer[lUtf8-1] = '\0';
         pBuffer[lUtf8] = '\0';
-        m_sUtf8 = pBuffer;
+        sUtf8 = pBuffer;
         free( pBuffer );
     }
     else
     {
         PdfString sTmp = this->ToUnicode();
-        m_sUtf8 = sTmp.GetStringUtf8();
+        sUtf8 = sTmp.GetStringUtf8();
     }
+
+    m_pUtf8 = new std::string( sUtf8 );
+}
+
+char* PdfString::AllocateBuffer( pdf_long lSize )
+{
+    delete m_pUtf8;
+    m_pUtf8 = NULL;
+
+    if( lSize <= PDF_STRING_BUFFER_SIZE ) 
+    {
+        m_buffer     = PdfRefCountedBuffer();
+        m_nSmallSize = static_cast<unsigned char>(lSize);
+        return m_sSmallBuffer;
+    }
+
+    m_buffer     = PdfRefCountedBuffer( lSize );
+    m_nSmallSize = 0;
+    return m_buffer.GetBuffer();
+}
+
+void PdfString::SetBuffer( const char* pBuffer, pdf_long lSize )
+{
+    if( lSize <= PDF_STRING_BUFFER_SIZE ) 
+    {
+        // pBuffer may point into m_sSmallBuffer or m_buffer
+        memmove( m_sSmallBuffer, pBuffer, lSize );
+        m_buffer     = PdfRefCountedBuffer();
+        m_nSmallSize = static_cast<unsigned char>(lSize);
+    }
+    else
+    {
+        PdfRefCountedBuffer buffer( lSize );
+        memcpy( buffer.GetBuffer(), pBuffer, lSize );
+        m_buffer     = buffer;
+        m_nSmallSize = 0;
+    }
+
+    delete m_pUtf8;
+    m_pUtf8 = NULL;
 }
 
 #ifdef _WIN32
@@ -574,8 +650,8 @@ const std::wstring PdfString::GetStringW() const
         return this->ToUnicode().GetStringW();
     }
 
-    PdfRefCountedBuffer buffer( m_buffer.GetSize() );
-    memcpy( buffer.GetBuffer(), m_buffer.GetBuffer(), m_buffer.GetSize() );
+    PdfRefCountedBuffer buffer( this->GetBufferSize() );
+    memcpy( buffer.GetBuffer(), this->GetBuffer(), this->GetBufferSize() );
 #ifdef PODOFO_IS_LITTLE_ENDIAN
     SwapBytes( buffer.GetBuffer(), buffer.GetSize() );
 #endif // PODOFO_IS_LITTLE_ENDIA
@@ -823,6 +899,198 @@ bool isLegalUTF8Sequence(const pdf_utf8 *source, const pdf_utf8 *sourceEnd) {
 }
 
 
+/* --------------------------------------------------------------------- */
+/*
+ * Fast paths for runs of ASCII characters, which make up most of the
+ * text in PDF files. Each kernel converts characters from the start
+ * of the buffers as long as they are ASCII and returns how many
+ * characters it converted. Everything else is left to the conversion
+ * loops below. UTF-16 is always read and written in big endian byte order.
+ *
+ * The widest kernel supported by the CPU is selected on first use.
+ */
+
+typedef pdf_long (*TAsciiToUtf16Kernel)( const pdf_utf8* pszSrc, pdf_long lLen, pdf_utf16be* pszDst );
+typedef pdf_long (*TUtf16ToAsciiKernel)( const pdf_utf16be* pszSrc, pdf_long lLen, pdf_utf8* pszDst );
+
+static pdf_long AsciiToUtf16Scalar( const pdf_utf8* pszSrc, pdf_long lLen, pdf_utf16be* pszDst, pdf_long i )
+{
+    pdf_utf8* pDst = reinterpret_cast<pdf_utf8*>(pszDst);
+
+    // Test 8 bytes at once for a byte with the high bit set
+    while( i + 8 <= lLen )
+    {
+        pdf_uint64 lWord;
+        memcpy( &lWord, pszSrc + i, sizeof(lWord) );
+        if( lWord & static_cast<pdf_uint64>(0x8080808080808080ULL) )
+            break;
+
+        for( pdf_long lEnd = i + 8; i < lEnd; i++ )
+        {
+            pDst[i << 1]       = 0;
+            pDst[(i << 1) + 1] = pszSrc[i];
+        }
+    }
+
+    for( ; i < lLen && pszSrc[i] < 0x80; i++ )
+    {
+        pDst[i << 1]       = 0;
+        pDst[(i << 1) + 1] = pszSrc[i];
+    }
+
+    return i;
+}
+
+static pdf_long Utf16ToAsciiScalar( const pdf_utf16be* pszSrc, pdf_long lLen, pdf_utf8* pszDst, pdf_long i )
+{
+    const pdf_utf8* pSrc = reinterpret_cast<const pdf_utf8*>(pszSrc);
+
+    for( ; i < lLen && !pSrc[i << 1] && pSrc[(i << 1) + 1] < 0x80; i++ )
+        pszDst[i] = pSrc[(i << 1) + 1];
+
+    return i;
+}
+
+static pdf_long AsciiToUtf16Generic( const pdf_utf8* pszSrc, pdf_long lLen, pdf_utf16be* pszDst )
+{
+    pdf_long i = 0;
+
+#if defined(PODOFO_UTF_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    for( ; i + 16 <= lLen; i += 16 )
+    {
+        __m128i chars = _mm_loadu_si128( reinterpret_cast<const __m128i*>(pszSrc + i) );
+        if( _mm_movemask_epi8( chars ) )
+            break;
+
+        // Interleaving with zero bytes in front yields big endian UTF-16
+        _mm_storeu_si128( reinterpret_cast<__m128i*>(pszDst + i),     _mm_unpacklo_epi8( zero, chars ) );
+        _mm_storeu_si128( reinterpret_cast<__m128i*>(pszDst + i + 8), _mm_unpackhi_epi8( zero, chars ) );
+    }
+#elif defined(PODOFO_UTF_NEON)
+    uint8x16x2_t pair;
+    pair.val[0] = vdupq_n_u8( 0 );
+    for( ; i + 16 <= lLen; i += 16 )
+    {
+        pair.val[1] = vld1q_u8( pszSrc + i );
+        if( vmaxvq_u8( pair.val[1] ) >= 0x80 )
+            break;
+
+        vst2q_u8( reinterpret_cast<pdf_utf8*>(pszDst + i), pair );
+    }
+#endif
+
+    return AsciiToUtf16Scalar( pszSrc, lLen, pszDst, i );
+}
+
+static pdf_long Utf16ToAsciiGeneric( const pdf_utf16be* pszSrc, pdf_long lLen, pdf_utf8* pszDst )
+{
+    pdf_long i = 0;
+
+#if defined(PODOFO_UTF_SSE2)
+    // Loaded as little endian words, an ASCII character has
+    // neither the low byte nor the high bit of the high byte set.
+    const __m128i mask = _mm_set1_epi16( static_cast<short>(0x80FF) );
+    const __m128i zero = _mm_setzero_si128();
+    for( ; i + 16 <= lLen; i += 16 )
+    {
+        __m128i lo = _mm_loadu_si128( reinterpret_cast<const __m128i*>(pszSrc + i) );
+        __m128i hi = _mm_loadu_si128( reinterpret_cast<const __m128i*>(pszSrc + i + 8) );
+        __m128i test = _mm_and_si128( _mm_or_si128( lo, hi ), mask );
+        if( _mm_movemask_epi8( _mm_cmpeq_epi8( test, zero ) ) != 0xFFFF )
+            break;
+
+        _mm_storeu_si128( reinterpret_cast<__m128i*>(pszDst + i),
+                          _mm_packus_epi16( _mm_srli_epi16( lo, 8 ), _mm_srli_epi16( hi, 8 ) ) );
+    }
+#elif defined(PODOFO_UTF_NEON)
+    const uint8x16_t highBit = vdupq_n_u8( 0x80 );
+    for( ; i + 16 <= lLen; i += 16 )
+    {
+        // val[0] are the high bytes, val[1] the low bytes
+        uint8x16x2_t pair = vld2q_u8( reinterpret_cast<const pdf_utf8*>(pszSrc + i) );
+        if( vmaxvq_u8( vorrq_u8( pair.val[0], vandq_u8( pair.val[1], highBit ) ) ) )
+            break;
+
+        vst1q_u8( pszDst + i, pair.val[1] );
+    }
+#endif
+
+    return Utf16ToAsciiScalar( pszSrc, lLen, pszDst, i );
+}
+
+#if defined(PODOFO_UTF_AVX2)
+__attribute__((target("avx2")))
+static pdf_long AsciiToUtf16Avx2( const pdf_utf8* pszSrc, pdf_long lLen, pdf_utf16be* pszDst )
+{
+    pdf_long      i    = 0;
+    const __m256i zero = _mm256_setzero_si256();
+    for( ; i + 32 <= lLen; i += 32 )
+    {
+        __m256i chars = _mm256_loadu_si256( reinterpret_cast<const __m256i*>(pszSrc + i) );
+        if( _mm256_movemask_epi8( chars ) )
+            break;
+
+        // Unpacking works per 128 bit lane, so bring the quadwords into order first
+        chars = _mm256_permute4x64_epi64( chars, 0xD8 );
+        _mm256_storeu_si256( reinterpret_cast<__m256i*>(pszDst + i),      _mm256_unpacklo_epi8( zero, chars ) );
+        _mm256_storeu_si256( reinterpret_cast<__m256i*>(pszDst + i + 16), _mm256_unpackhi_epi8( zero, chars ) );
+    }
+
+    // Avoid the penalty for switching to SSE with dirty upper halves
+    _mm256_zeroupper();
+    return i + AsciiToUtf16Generic( pszSrc + i, lLen - i, pszDst + i );
+}
+
+__attribute__((target("avx2")))
+static pdf_long Utf16ToAsciiAvx2( const pdf_utf16be* pszSrc, pdf_long lLen, pdf_utf8* pszDst )
+{
+    pdf_long      i    = 0;
+    const __m256i mask = _mm256_set1_epi16( static_cast<short>(0x80FF) );
+    for( ; i + 32 <= lLen; i += 32 )
+    {
+        __m256i lo = _mm256_loadu_si256( reinterpret_cast<const __m256i*>(pszSrc + i) );
+        __m256i hi = _mm256_loadu_si256( reinterpret_cast<const __m256i*>(pszSrc + i + 16) );
+        if( !_mm256_testz_si256( _mm256_or_si256( lo, hi ), mask ) )
+            break;
+
+        __m256i chars = _mm256_packus_epi16( _mm256_srli_epi16( lo, 8 ), _mm256_srli_epi16( hi, 8 ) );
+        _mm256_storeu_si256( reinterpret_cast<__m256i*>(pszDst + i), _mm256_permute4x64_epi64( chars, 0xD8 ) );
+    }
+
+    _mm256_zeroupper();
+    return i + Utf16ToAsciiGeneric( pszSrc + i, lLen - i, pszDst + i );
+}
+#endif // PODOFO_UTF_AVX2
+
+struct TUtfKernels {
+    TAsciiToUtf16Kernel pAsciiToUtf16;
+    TUtf16ToAsciiKernel pUtf16ToAscii;
+};
+
+static TUtfKernels SelectUtfKernels()
+{
+    TUtfKernels kernels = { AsciiToUtf16Generic, Utf16ToAsciiGeneric };
+
+#if defined(PODOFO_UTF_AVX2)
+    __builtin_cpu_init();
+    if( __builtin_cpu_supports( "avx2" ) )
+    {
+        kernels.pAsciiToUtf16 = AsciiToUtf16Avx2;
+        kernels.pUtf16ToAscii = Utf16ToAsciiAvx2;
+    }
+#endif // PODOFO_UTF_AVX2
+
+    return kernels;
+}
+
+// Selecting the kernels twice from different threads is harmless
+static const TUtfKernels & GetUtfKernels()
+{
+    static const TUtfKernels s_kernels = SelectUtfKernels();
+    return s_kernels;
+}
+
 pdf_long PdfString::ConvertUTF8toUTF16( const pdf_utf8* pszUtf8, pdf_utf16be* pszUtf16, pdf_long lLenUtf16 )
 {
     return pszUtf8 ? 
@@ -838,8 +1106,57 @@ pdf_long PdfString::ConvertUTF8toUTF16( const pdf_utf8* pszUtf8, pdf_long lLenUt
     pdf_utf16be*    target    = pszUtf16;
     pdf_utf16be*    targetEnd = pszUtf16 + lLenUtf16;
 
+    TAsciiToUtf16Kernel pAsciiToUtf16 = GetUtfKernels().pAsciiToUtf16;
+
     while (source < sourceEnd) 
     {
+        if( *source < 0x80 ) 
+        {
+            // Runs of at least 8 ASCII characters are handed to the vector kernels,
+            // the terminating character is always left to this loop.
+            if( sourceEnd - source > 8 && target < targetEnd ) 
+            {
+                pdf_uint64 lWord;
+                memcpy( &lWord, source, sizeof(lWord) );
+                if( !(lWord & static_cast<pdf_uint64>(0x8080808080808080ULL)) )
+                {
+                    pdf_long lAscii = PDF_MIN( static_cast<pdf_long>(sourceEnd - source) - 1, 
+                                               static_cast<pdf_long>(targetEnd - target) );
+                    lAscii  = pAsciiToUtf16( source, lAscii, target );
+                    source += lAscii;
+                    target += lAscii;
+                    continue;
+                }
+            }
+
+            if (target >= targetEnd) {
+                PODOFO_RAISE_ERROR( ePdfError_OutOfMemory );
+            }
+
+            *target++ = compat::podofo_htons( *source++ );
+            continue;
+        }
+
+        // Legal three byte sequences outside of the surrogate range, 
+        // i.e. most CJK characters, need none of the checks below
+        if( (*source & 0xF0) == 0xE0 && source + 3 < sourceEnd && 
+            (source[1] & 0xC0) == 0x80 && (source[2] & 0xC0) == 0x80 )
+        {
+            unsigned long ch = (static_cast<unsigned long>(source[0] & 0x0F) << 12) | 
+                (static_cast<unsigned long>(source[1] & 0x3F) << 6) | (source[2] & 0x3F);
+
+            if( ch >= 0x800 && (ch < UNI_SUR_HIGH_START || ch > UNI_SUR_LOW_END) ) 
+            {
+                if (target >= targetEnd) {
+                    PODOFO_RAISE_ERROR( ePdfError_OutOfMemory );
+                }
+
+                *target++ = compat::podofo_htons( static_cast<pdf_utf16be>(ch) );
+                source   += 3;
+                continue;
+            }
+        }
+
 	unsigned long ch = 0;
 	unsigned short extraBytesToRead = trailingBytesForUTF8[*source];
 	if (source + extraBytesToRead >= sourceEnd) {
@@ -877,10 +1194,10 @@ pdf_long PdfString::ConvertUTF8toUTF16( const pdf_utf8* pszUtf8, pdf_long lLenUt
                     PODOFO_RAISE_ERROR( ePdfError_InvalidDataType );
 		    break;
 		} else {
-		    *target++ = UNI_REPLACEMENT_CHAR;
+		    *target++ = compat::podofo_htons( static_cast<pdf_utf16be>(UNI_REPLACEMENT_CHAR) );
 		}
 	    } else {
-		*target++ = static_cast<pdf_utf16be>(ch); /* normal case */
+		*target++ = compat::podofo_htons( static_cast<pdf_utf16be>(ch) ); /* normal case */
 	    }
 	} else if (ch > UNI_MAX_UTF16) {
 	    if (eConversion == ePdfStringConversion_Strict) {
@@ -891,7 +1208,7 @@ pdf_long PdfString::ConvertUTF8toUTF16( const pdf_utf8* pszUtf8, pdf_long lLenUt
 		source -= (extraBytesToRead+1); /* return to the start */
 		break; /* Bail out; shouldn't continue */
 	    } else {
-		*target++ = UNI_REPLACEMENT_CHAR;
+		*target++ = compat::podofo_htons( static_cast<pdf_utf16be>(UNI_REPLACEMENT_CHAR) );
 	    }
 	} else {
 	    /* target is a character in range 0xFFFF - 0x10FFFF. */
@@ -901,16 +1218,11 @@ pdf_long PdfString::ConvertUTF8toUTF16( const pdf_utf8* pszUtf8, pdf_long lLenUt
 	    }
             
 	    ch -= halfBase;
-	    *target++ = static_cast<pdf_utf16be>((ch >> halfShift) + UNI_SUR_HIGH_START);
-	    *target++ = static_cast<pdf_utf16be>((ch & halfMask) + UNI_SUR_LOW_START);
+	    *target++ = compat::podofo_htons( static_cast<pdf_utf16be>((ch >> halfShift) + UNI_SUR_HIGH_START) );
+	    *target++ = compat::podofo_htons( static_cast<pdf_utf16be>((ch & halfMask) + UNI_SUR_LOW_START) );
 	}
     }
 
-    // swap to UTF-16be on LE systems
-#ifdef PODOFO_IS_LITTLE_ENDIAN
-    PdfString::SwapBytes( reinterpret_cast<char*>(pszUtf16), static_cast<pdf_long>(target - pszUtf16) << 1 );
-#endif // PODOFO_IS_LITTLE_ENDIAN
-
     // return characters written
     return target - pszUtf16;
 }
@@ -920,7 +1232,7 @@ pdf_long PdfString::ConvertUTF16toUTF8( const pdf_utf16be* pszUtf16, pdf_utf8* p
     pdf_long               lLen      = 0;
     const pdf_utf16be* pszStart = pszUtf16;
 
-    while( *pszStart )
+    while( *pszStart++ )
         ++lLen;
 
     return ConvertUTF16toUTF8( pszUtf16, lLen, pszUtf8, lLenUtf8 );
@@ -930,109 +1242,97 @@ pdf_long PdfString::ConvertUTF16toUTF8( const pdf_utf16be* pszUtf16, pdf_long lL
                                     pdf_utf8* pszUtf8, pdf_long lLenUtf8, 
                                     EPdfStringConversion eConversion  )
 {
-    bool               bOwnBuf   = false;
     const pdf_utf16be* source    = pszUtf16;
-    const pdf_utf16be* sourceEnd = pszUtf16 + lLenUtf16 + 1; // point after the last element
+    const pdf_utf16be* sourceEnd = pszUtf16 + lLenUtf16; // points to the terminating character
     
     pdf_utf8* target    = pszUtf8;
     pdf_utf8* targetEnd = pszUtf8 + lLenUtf8;
 
-    // swap to UTF-16be on LE systems
-#ifdef PODOFO_IS_LITTLE_ENDIAN
-    bOwnBuf = true;
-    source  = new pdf_utf16be[lLenUtf16+1];
-    if( !source )
-    {
-        PODOFO_RAISE_ERROR( ePdfError_OutOfMemory );
-    }
-    
-    memcpy( const_cast<pdf_utf16be*>(source), pszUtf16, lLenUtf16 * sizeof(pdf_utf16be) );
-    
-    PdfString::SwapBytes( reinterpret_cast<char*>(const_cast<pdf_utf16be*>(source)), lLenUtf16 * sizeof(pdf_utf16be) );
-    pszUtf16  = source;
-    const_cast<pdf_utf16be*>(source)[lLenUtf16] = 0;
-    sourceEnd = pszUtf16 + lLenUtf16 + 1; // point after the last element
-#endif // PODOFO_IS_LITTLE_ENDIAN
-
-    try {
-        while (source < sourceEnd) {
-            unsigned long  ch;
-            unsigned short bytesToWrite = 0;
-            const unsigned long byteMask = 0xBF;
-            const unsigned long byteMark = 0x80; 
-            const pdf_utf16be* oldSource = source; /* In case we have to back up because of target overflow. */
-            ch = *source++;
-
-            /* If we have a surrogate pair, convert to UTF32 first. */
-            if (ch >= UNI_SUR_HIGH_START && ch <= UNI_SUR_HIGH_END) {
-                /* If the 16 bits following the high surrogate are in the source buffer... */
-                if (source < sourceEnd) {
-                    unsigned long ch2 = *source;
-                    /* If it's a low surrogate, convert to UTF32. */
-                    if (ch2 >= UNI_SUR_LOW_START && ch2 <= UNI_SUR_LOW_END) {
-                        ch = ((ch - UNI_SUR_HIGH_START) << halfShift)
-                            + (ch2 - UNI_SUR_LOW_START) + halfBase;
-                        ++source;
-                    } else if (eConversion == ePdfStringConversion_Strict) { /* it's an unpaired high surrogate */
-                        --source; /* return to the illegal value itself */
-                        PODOFO_RAISE_ERROR( ePdfError_InvalidDataType );
-                        break;
-                    }
-                } else { /* We don't have the 16 bits following the high surrogate. */
-                    --source; /* return to the high surrogate */
-                    PODOFO_RAISE_ERROR( ePdfError_OutOfMemory );
-                    break;
-                }
-            } else if (eConversion == ePdfStringConversion_Strict) {
-                /* UTF-16 surrogate values are illegal in UTF-32 */
-                if (ch >= UNI_SUR_LOW_START && ch <= UNI_SUR_LOW_END) {
-                    --source; /* return to the illegal value itself */
-                    PODOFO_RAISE_ERROR( ePdfError_InvalidDataType );
-                    break;
-                }
-            }
-            /* Figure out how many bytes the result will require */
-            if (ch < static_cast<unsigned long>(0x80)) {	     
-                bytesToWrite = 1;
-            } else if (ch < static_cast<unsigned long>(0x800)) {     
-                bytesToWrite = 2;
-            } else if (ch < static_cast<unsigned long>(0x10000)) {   
-                bytesToWrite = 3;
-            } else if (ch < static_cast<unsigned long>(0x110000)) {  
-                bytesToWrite = 4;
-            } else {			    
-                bytesToWrite = 3;
-                ch = UNI_REPLACEMENT_CHAR;
-            }
+    TUtf16ToAsciiKernel pUtf16ToAscii = GetUtfKernels().pUtf16ToAscii;
 
-            target += bytesToWrite;
-            if (target > targetEnd) {
-                source = oldSource; /* Back up source pointer! */
-                target -= bytesToWrite; 
+    // The source is read in big endian byte order and 
+    // a terminating zero is converted after lLenUtf16 characters.
+    while (source <= sourceEnd) {
+        // Runs of at least 4 ASCII characters are handed to the vector kernels
+        if( sourceEnd - source >= 4 && 
+            !((source[0] | source[1] | source[2] | source[3]) & compat::podofo_htons( 0xFF80 )) ) 
+        {
+            pdf_long lAscii = PDF_MIN( static_cast<pdf_long>(sourceEnd - source), 
+                                       static_cast<pdf_long>(targetEnd - target) );
+            lAscii  = pUtf16ToAscii( source, lAscii, target );
+            source += lAscii;
+            target += lAscii;
+        }
+
+        unsigned long  ch;
+        unsigned short bytesToWrite = 0;
+        const unsigned long byteMask = 0xBF;
+        const unsigned long byteMark = 0x80; 
+        ch = source < sourceEnd ? compat::podofo_ntohs( *source ) : 0;
+        ++source;
+
+        // Characters of the basic multilingual plane beyond U+07FF that
+        // are no surrogates, i.e. most CJK characters, are written directly
+        if( ch >= 0x800 && (ch < UNI_SUR_HIGH_START || ch > UNI_SUR_LOW_END) ) 
+        {
+            if (target + 3 > targetEnd) {
                 PODOFO_RAISE_ERROR( ePdfError_OutOfMemory );
-                break;
             }
-        
-            switch (bytesToWrite) { /* note: everything falls through. */
-                case 4: *--target = static_cast<pdf_utf8>((ch | byteMark) & byteMask); ch >>= 6;
-                case 3: *--target = static_cast<pdf_utf8>((ch | byteMark) & byteMask); ch >>= 6;
-                case 2: *--target = static_cast<pdf_utf8>((ch | byteMark) & byteMask); ch >>= 6;
-                case 1: *--target = static_cast<pdf_utf8>(ch | firstByteMark[bytesToWrite]);
+
+            target[0] = static_cast<pdf_utf8>(0xE0 | (ch >> 12));
+            target[1] = static_cast<pdf_utf8>(0x80 | ((ch >> 6) & 0x3F));
+            target[2] = static_cast<pdf_utf8>(0x80 | (ch & 0x3F));
+            target   += 3;
+            continue;
+        }
+
+        /* If we have a surrogate pair, convert to UTF32 first. */
+        if (ch >= UNI_SUR_HIGH_START && ch <= UNI_SUR_HIGH_END) {
+            /* The 16 bits following the high surrogate are always in the source buffer,
+               as the terminating character follows at the end. */
+            unsigned long ch2 = source < sourceEnd ? compat::podofo_ntohs( *source ) : 0;
+            /* If it's a low surrogate, convert to UTF32. */
+            if (ch2 >= UNI_SUR_LOW_START && ch2 <= UNI_SUR_LOW_END) {
+                ch = ((ch - UNI_SUR_HIGH_START) << halfShift)
+                    + (ch2 - UNI_SUR_LOW_START) + halfBase;
+                ++source;
+            } else if (eConversion == ePdfStringConversion_Strict) { /* it's an unpaired high surrogate */
+                PODOFO_RAISE_ERROR( ePdfError_InvalidDataType );
+            }
+        } else if (eConversion == ePdfStringConversion_Strict) {
+            /* UTF-16 surrogate values are illegal in UTF-32 */
+            if (ch >= UNI_SUR_LOW_START && ch <= UNI_SUR_LOW_END) {
+                PODOFO_RAISE_ERROR( ePdfError_InvalidDataType );
             }
-            target += bytesToWrite;
         }
-    }
-    catch( const PdfError & e ) 
-    {
-        if( bOwnBuf )
-            delete[] const_cast<pdf_utf16be *>(pszUtf16);
+        /* Figure out how many bytes the result will require */
+        if (ch < static_cast<unsigned long>(0x80)) {	     
+            bytesToWrite = 1;
+        } else if (ch < static_cast<unsigned long>(0x800)) {     
+            bytesToWrite = 2;
+        } else if (ch < static_cast<unsigned long>(0x10000)) {   
+            bytesToWrite = 3;
+        } else if (ch < static_cast<unsigned long>(0x110000)) {  
+            bytesToWrite = 4;
+        } else {			    
+            bytesToWrite = 3;
+            ch = UNI_REPLACEMENT_CHAR;
+        }
 
-        throw e;
+        target += bytesToWrite;
+        if (target > targetEnd) {
+            PODOFO_RAISE_ERROR( ePdfError_OutOfMemory );
+        }
+    
+        switch (bytesToWrite) { /* note: everything falls through. */
+            case 4: *--target = static_cast<pdf_utf8>((ch | byteMark) & byteMask); ch >>= 6;
+            case 3: *--target = static_cast<pdf_utf8>((ch | byteMark) & byteMask); ch >>= 6;
+            case 2: *--target = static_cast<pdf_utf8>((ch | byteMark) & byteMask); ch >>= 6;
+            case 1: *--target = static_cast<pdf_utf8>(ch | firstByteMark[bytesToWrite]);
+        }
+        target += bytesToWrite;
     }
 
-    if( bOwnBuf )
-        delete[] const_cast<pdf_utf16be *>(pszUtf16);
-
     // return bytes written
     return target - pszUtf8;
 }
@@ -27,7 +27,11 @@
 
 namespace PoDoFo {
 
-#define PDF_STRING_BUFFER_SIZE 24
+/** Size of the buffer inside of PdfString, which holds
+ *  short strings including their 2 terminating zeros.
+ *  Longer strings are stored in a PdfRefCountedBuffer.
+ */
+#define PDF_STRING_BUFFER_SIZE 28
 
 class PdfEncoding;
 class PdfOutputDevice;
@@ -57,7 +61,10 @@ enum EPdfStringConversion {
  *
  *
  *  PdfStrings is an implicitly shared class. As a reason
- *  it is very fast to copy PdfString objects.
+ *  it is very fast to copy PdfString objects. Short strings
+ *  are stored inside of the PdfString object itself, so
+ *  the pointer returned by GetString() is only valid as long
+ *  as the PdfString object it was retrieved from.
  *
  *  The internal string buffer is guaranteed to be always terminated 
  *  by 2 zeros.
@@ -188,6 +195,13 @@ class PODOFO_API PdfString : public PdfDataType{
      */
     inline bool IsUnicode () const;
 
+    /** The encoding of a string which is not unicode.
+     *
+     * \returns the encoding which was passed to the constructor
+     *          or NULL for unicode strings and strings in PdfDocEncoding.
+     */
+    inline const PdfEncoding* GetEncoding() const;
+
     /** The contents of the strings can be read
      *  by this function.
      *
@@ -409,6 +423,33 @@ class PODOFO_API PdfString : public PdfDataType{
      */
     void InitUtf8();
 
+    /** Allocate the buffer for the string data
+     *  and drop the UTF8 version of the old contents.
+     *
+     *  \param lSize size of the buffer including the 2 terminating zeros
+     *  \returns the buffer, which is either inside of this object
+     *            or a PdfRefCountedBuffer
+     */
+    char* AllocateBuffer( pdf_long lSize );
+
+    /** Replace the string data by a copy of a buffer
+     *  \param pBuffer the new string data, which may be
+     *                 a part of the current string data
+     *  \param lSize size of the buffer including the 2 terminating zeros
+     */
+    void SetBuffer( const char* pBuffer, pdf_long lSize );
+
+    /** 
+     *  \returns the string data or NULL for invalid strings
+     */
+    inline char* GetBuffer() const;
+
+    /** 
+     *  \returns the size of the string data including
+     *            the 2 terminating zeros or 0 for invalid strings
+     */
+    inline pdf_long GetBufferSize() const;
+
  private:
     static const char        s_pszUnicodeMarker[];   ///< The unicode marker used to indicate unicode strings in PDF
     static const char*       s_pszUnicodeMarkerHex;  ///< The unicode marker converted to HEX
@@ -416,12 +457,14 @@ class PODOFO_API PdfString : public PdfDataType{
     static const char * const m_escMap;              ///< Mapping of escape sequences to there value
 
  private:
-    PdfRefCountedBuffer m_buffer;                    ///< String data (always binary), may contain 0 bytes
-
     bool                m_bHex;                      ///< This string is converted to hex during write out
     bool                m_bUnicode;                  ///< This string contains unicode data
+    unsigned char       m_nSmallSize;                ///< Size of the data in m_sSmallBuffer, 0 if m_buffer is used
+    char                m_sSmallBuffer[PDF_STRING_BUFFER_SIZE]; ///< String data of short strings
+
+    PdfRefCountedBuffer m_buffer;                    ///< String data of long strings (always binary), may contain 0 bytes
 
-    std::string         m_sUtf8;                     ///< The UTF8 version of the strings contents.
+    std::string*        m_pUtf8;                     ///< The UTF8 version of the strings contents, created on first use.
     const PdfEncoding*  m_pEncoding;                 ///< Encoding for non Unicode strings. NULL for unicode strings.
 };
 
@@ -430,7 +473,7 @@ class PODOFO_API PdfString : public PdfDataType{
 // -----------------------------------------------------
 bool PdfString::IsValid() const
 {
-    return (m_buffer.GetBuffer() != NULL);
+    return (this->GetBuffer() != NULL);
 }
 
 // -----------------------------------------------------
@@ -449,12 +492,20 @@ bool PdfString::IsUnicode () const
     return m_bUnicode;
 }
 
+// -----------------------------------------------------
+// 
+// -----------------------------------------------------
+const PdfEncoding* PdfString::GetEncoding() const
+{
+    return m_pEncoding;
+}
+
 // -----------------------------------------------------
 // 
 // -----------------------------------------------------
 const char* PdfString::GetString() const
 {
-    return m_buffer.GetBuffer();
+    return this->GetBuffer();
 }
 
 // -----------------------------------------------------
@@ -462,7 +513,7 @@ const char* PdfString::GetString() const
 // -----------------------------------------------------
 const pdf_utf16be* PdfString::GetUnicode() const
 {
-    return reinterpret_cast<pdf_utf16be*>(m_buffer.GetBuffer());
+    return reinterpret_cast<pdf_utf16be*>(this->GetBuffer());
 }
 
 // -----------------------------------------------------
@@ -470,10 +521,10 @@ const pdf_utf16be* PdfString::GetUnicode() const
 // -----------------------------------------------------
 const std::string & PdfString::GetStringUtf8() const
 {
-    if( this->IsValid() && !m_sUtf8.length() && m_buffer.GetSize() - 2) 
+    if( !m_pUtf8 ) 
         const_cast<PdfString*>(this)->InitUtf8();
 
-    return m_sUtf8;
+    return *m_pUtf8;
 }
 
 // -----------------------------------------------------
@@ -481,7 +532,7 @@ const std::string & PdfString::GetStringUtf8() const
 // -----------------------------------------------------
 pdf_long PdfString::GetLength() const
 {
-    return m_buffer.GetSize() - 2;
+    return this->GetBufferSize() - 2;
 }
 
 // -----------------------------------------------------
@@ -497,7 +548,23 @@ pdf_long PdfString::GetCharacterLength() const
 // -----------------------------------------------------
 pdf_long PdfString::GetUnicodeLength() const
 {
-    return (m_buffer.GetSize() / sizeof(pdf_utf16be)) - 1;
+    return (this->GetBufferSize() / sizeof(pdf_utf16be)) - 1;
+}
+
+// -----------------------------------------------------
+// 
+// -----------------------------------------------------
+char* PdfString::GetBuffer() const
+{
+    return m_nSmallSize ? const_cast<char*>(m_sSmallBuffer) : m_buffer.GetBuffer();
+}
+
+// -----------------------------------------------------
+// 
+// -----------------------------------------------------
+pdf_long PdfString::GetBufferSize() const
+{
+    return m_nSmallSize ? m_nSmallSize : static_cast<pdf_long>(m_buffer.GetSize());
 }
 
 };
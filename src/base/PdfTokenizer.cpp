@@ -711,12 +711,21 @@ void PdfTokenizer::ReadString( PdfVariant& rVariant, PdfEncrypt* pEncrypt )
     if( bOctEscape )
         m_vecBuffer.push_back ( cOctValue );
 
-    // P.Zent: Encrypt function needs to know the length of the buffer not counting the offset
     if( pEncrypt && m_vecBuffer.size() )
-        pEncrypt->Encrypt( reinterpret_cast<unsigned char*>(&(m_vecBuffer[0])), 
-                           static_cast<unsigned int>(m_vecBuffer.size()) - pEncrypt->CalculateStreamOffset() );
+    {
+        // The decrypted string is shorter for AES, as the initial vector and padding are removed
+        std::vector<char> vecDecrypted( m_vecBuffer.size() );
+        pdf_long          lLen = 0;
+
+        pEncrypt->Decrypt( reinterpret_cast<const unsigned char*>(&(m_vecBuffer[0])), m_vecBuffer.size(), 
+                           reinterpret_cast<unsigned char*>(&(vecDecrypted[0])), lLen );
 
-    if( m_vecBuffer.size() )
+        if( lLen )
+            rVariant = PdfString( &(vecDecrypted[0]), lLen );
+        else
+            rVariant = PdfString("");
+    }
+    else if( m_vecBuffer.size() )
         rVariant = PdfString( &(m_vecBuffer[0]), m_vecBuffer.size() );
     else
         rVariant = PdfString("");
@@ -789,4 +798,9 @@ void PdfTokenizer::QuequeToken( const char* pszToken, EPdfTokenType eType )
     m_deqQueque.push_back( TTokenizerPair( std::string( pszToken ), eType ) );
 }
 
+void PdfTokenizer::ClearQueque()
+{
+    m_deqQueque.clear();
+}
+
 };
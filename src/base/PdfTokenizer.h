@@ -232,6 +232,14 @@ class PODOFO_API PdfTokenizer {
      */
     void QuequeToken( const char* pszToken, EPdfTokenType eType );
 
+    /** Discard all tokens in the queque of tokens,
+     *  so that GetNextToken() reads the next token
+     *  from the input device again.
+     *
+     *  \see QuequeToken
+     */
+    void ClearQueque();
+
  protected:
     PdfRefCountedInputDevice m_device;
     PdfRefCountedBuffer      m_buffer;
@@ -242,11 +242,7 @@ void PdfVariant::Write( PdfOutputDevice* pDevice, EPdfWriteMode eWriteMode, cons
                 pDevice->Write( " ", 1 ); // Write space before numbers
             }
 
-#ifdef _WIN64
-            pDevice->Print( "%I64i", m_Data.nNumber );
-#else
-            pDevice->Print( "%lld", m_Data.nNumber );
-#endif
+            pDevice->WriteNumber( m_Data.nNumber );
             break;
         }
         case ePdfDataType_Real:
@@ -263,12 +259,8 @@ void PdfVariant::Write( PdfOutputDevice* pDevice, EPdfWriteMode eWriteMode, cons
                 pDevice->Write( " ", 1 ); // Write space before numbers
             }
 
-            // Use ostringstream, so that locale does not matter
-            std::ostringstream oss;
-            PdfLocaleImbue(oss);
-            oss << std::fixed << m_Data.dNumber;
-
-            pDevice->Write( oss.str().c_str(), oss.str().size() );
+            // Same output as std::fixed, independent of the locale
+            pDevice->WriteReal( m_Data.dNumber );
             break;
         }
         case ePdfDataType_HexString:
@@ -289,7 +281,7 @@ void PdfVariant::Write( PdfOutputDevice* pDevice, EPdfWriteMode eWriteMode, cons
                 pDevice->Write( " ", 1 ); // Write space before null
             }
 
-            pDevice->Print( "null" );
+            pDevice->Write( "null", 4 );
             break;
         }
         case ePdfDataType_Unknown:
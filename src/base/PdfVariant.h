@@ -490,16 +490,18 @@ class PODOFO_API PdfVariant {
 
     UVariant     m_Data;
 
-    bool         m_bDirty; ///< Indicates if this object was modified after construction
-    bool         m_bImmutable; ///< Indicates if this object maybe modified
-
-
     /** Datatype of the variant.
      *  required to access the correct member of 
      *  the union UVariant.
      */
     EPdfDataType m_eDataType;
 
+    // The flags follow the data type, so that they share a
+    // single word with it and leave room at the end of the
+    // object for the flags of PdfObject.
+    bool         m_bDirty; ///< Indicates if this object was modified after construction
+    bool         m_bImmutable; ///< Indicates if this object maybe modified
+
     // No touchy. Only for use by PdfVariant's internal tracking of the delayed
     // loading state. Use DelayedLoadDone() to test this if you need to.
     mutable bool m_bDelayedLoadDone;
@@ -26,6 +26,7 @@
 //#include "PdfHintStream.h"
 #include "PdfObject.h"
 #include "PdfParser.h"
+#include "PdfParserObject.h"
 #include "PdfStream.h"
 #include "PdfVariant.h"
 #include "PdfXRef.h"
@@ -46,7 +47,7 @@ PdfWriter::PdfWriter( PdfParser* pParser )
     : m_bXRefStream( false ), m_pEncrypt( NULL ), 
       m_pEncryptObj( NULL ), 
       m_eWriteMode( ePdfWriteMode_Compact ),
-      m_bLinearized( false ), m_lFirstInXRef( 0 )
+      m_bLinearized( false ), m_bFreeObjectMemory( false ), m_lFirstInXRef( 0 )
 {
     if( !(pParser && pParser->GetTrailer()) )
     {
@@ -62,7 +63,7 @@ PdfWriter::PdfWriter( PdfVecObjects* pVecObjects, const PdfObject* pTrailer )
     : m_bXRefStream( false ), m_pEncrypt( NULL ), 
       m_pEncryptObj( NULL ), 
       m_eWriteMode( ePdfWriteMode_Compact ),
-      m_bLinearized( false ), m_lFirstInXRef( 0 )
+      m_bLinearized( false ), m_bFreeObjectMemory( false ), m_lFirstInXRef( 0 )
 {
     if( !pVecObjects || !pTrailer )
     {
@@ -78,7 +79,7 @@ PdfWriter::PdfWriter( PdfVecObjects* pVecObjects )
     : m_bXRefStream( false ), m_pEncrypt( NULL ), 
       m_pEncryptObj( NULL ), 
       m_eWriteMode( ePdfWriteMode_Compact ), 
-      m_bLinearized( false ), m_lFirstInXRef( 0 )
+      m_bLinearized( false ), m_bFreeObjectMemory( false ), m_lFirstInXRef( 0 )
 {
     m_eVersion     = ePdfVersion_Default;
     m_pTrailer     = new PdfObject();
@@ -268,11 +269,22 @@ void PdfWriter::WritePdfObjects( PdfOutputDevice* pDevice, const PdfVecObjects&
 
     while( itObjects != vecObjects.end() )
     {
+        // Remember what was loaded before writing, as only data
+        // which was loaded just for writing may be free'd again
+        PdfParserObject* pParserObject = m_bFreeObjectMemory ? dynamic_cast<PdfParserObject*>(*itObjects) : NULL;
+        bool             bLoaded       = pParserObject && pParserObject->IsLoaded();
+        bool             bStreamLoaded = pParserObject && pParserObject->IsStreamLoaded();
+
         pXref->AddObject( (*itObjects)->Reference(), pDevice->Tell(), true );
         // Make sure that we do not encrypt the encryption dictionary!
         (*itObjects)->WriteObject( pDevice, m_eWriteMode, 
                                    ((*itObjects) == m_pEncryptObj ? NULL : m_pEncrypt) );
 
+        if( pParserObject && !bLoaded )
+            pParserObject->FreeObjectMemory();
+        else if( pParserObject && !bStreamLoaded )
+            pParserObject->FreeStreamMemory();
+
         ++itObjects;
     }
 
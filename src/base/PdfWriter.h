@@ -133,6 +133,25 @@ class PODOFO_API PdfWriter {
      */
     inline bool GetUseXRefStream() const;
 
+    /** Free the memory of unmodified objects read from a PDF file
+     *  after they have been written, so that the memory required
+     *  for writing depends on the largest object instead of the
+     *  size of the document. Default is false.
+     *
+     *  Only objects and streams which have not been loaded before
+     *  Write() was called are free'd, so pointers to them stay valid.
+     *  They will be read again from the file if they are accessed.
+     *
+     *  \param bFree if true free objects after writing them
+     *  \see PdfParserObject::FreeObjectMemory
+     */
+    inline void SetFreeObjectMemory( bool bFree );
+
+    /** 
+     *  \returns wether objects are free'd after writing them
+     */
+    inline bool GetFreeObjectMemory() const;
+
     /** Get the file format version of the pdf
      *  \returns the file format version as string
      */
@@ -268,6 +287,7 @@ class PODOFO_API PdfWriter {
     EPdfVersion     m_eVersion;
 
     bool            m_bLinearized;
+    bool            m_bFreeObjectMemory;
  
     /**
      * This value is required when writing
@@ -317,6 +337,22 @@ bool PdfWriter::GetUseXRefStream() const
     return m_bXRefStream;
 }
 
+// -----------------------------------------------------
+// 
+// -----------------------------------------------------
+void PdfWriter::SetFreeObjectMemory( bool bFree )
+{
+    m_bFreeObjectMemory = bFree;
+}
+
+// -----------------------------------------------------
+// 
+// -----------------------------------------------------
+bool PdfWriter::GetFreeObjectMemory() const
+{
+    return m_bFreeObjectMemory;
+}
+
 
 };
 
@@ -315,7 +315,7 @@ void PdfXRef::MergeBlocks()
 
 void PdfXRef::BeginWrite( PdfOutputDevice* pDevice ) 
 {
-    pDevice->Print( "xref\n" );
+    pDevice->Write( "xref\n", 5 );
 }
 
 void PdfXRef::WriteSubSection( PdfOutputDevice* pDevice, pdf_objnum nFirst, pdf_uint32 nCount )
@@ -323,13 +323,21 @@ void PdfXRef::WriteSubSection( PdfOutputDevice* pDevice, pdf_objnum nFirst, pdf_
 #ifdef DEBUG
     PdfError::DebugMessage("Writing XRef section: %u %u\n", nFirst, nCount );
 #endif // DEBUG
-    pDevice->Print( "%u %u\n", nFirst, nCount );
+    pDevice->WriteNumber( nFirst );
+    pDevice->Write( " ", 1 );
+    pDevice->WriteNumber( nCount );
+    pDevice->Write( "\n", 1 );
 }
 
 void PdfXRef::WriteXRefEntry( PdfOutputDevice* pDevice, pdf_uint64 offset, 
                               pdf_gennum generation, char cMode, pdf_objnum ) 
 {
-    pDevice->Print( "%0.10" PDF_FORMAT_UINT64 " %0.5hu %c \n", offset, generation, cMode );
+    char szMode[4] = { ' ', cMode, ' ', '\n' };
+
+    pDevice->WriteUnsigned( offset, 10 );
+    pDevice->Write( " ", 1 );
+    pDevice->WriteUnsigned( generation, 5 );
+    pDevice->Write( szMode, sizeof(szMode) );
 }
 
 void PdfXRef::EndWrite( PdfOutputDevice* ) 
@@ -29,9 +29,9 @@
 
 namespace PoDoFo {
 
-PdfXRefStreamParserObject::PdfXRefStreamParserObject(PdfVecObjects* pCreator, const PdfRefCountedInputDevice & rDevice, 
-                                                     const PdfRefCountedBuffer & rBuffer, PdfParser::TVecOffsets* pOffsets )
-    : PdfParserObject( pCreator, rDevice, rBuffer ), m_lNextOffset(-1L), m_pOffsets( pOffsets )
+PdfXRefStreamParserObject::PdfXRefStreamParserObject(PdfVecObjects* pCreator, PdfParserObjectTokenizer* pTokenizer, 
+                                                     PdfParser::TVecOffsets* pOffsets )
+    : PdfParserObject( pCreator, pTokenizer ), m_lNextOffset(-1L), m_pOffsets( pOffsets )
 {
 
 }
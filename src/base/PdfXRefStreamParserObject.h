@@ -41,13 +41,12 @@ public:
     /** Parse the object data from the given file handle starting at
      *  the current position.
      *  \param pCreator pointer to a PdfVecObjects to resolve object references
-     *  \param rDevice an open reference counted input device which is positioned in
-     *                 front of the object which is going to be parsed.
-     *  \param rBuffer buffer to use for parsing to avoid reallocations
+     *  \param pTokenizer the tokenizer of the PdfParser, whose input device is
+     *                    positioned in front of the object which is going to be parsed.
      *  \param pOffsets XRef entries are stored into this array
      */
-    PdfXRefStreamParserObject(PdfVecObjects* pCreator, const PdfRefCountedInputDevice & rDevice, 
-                              const PdfRefCountedBuffer & rBuffer, PdfParser::TVecOffsets* pOffsets );
+    PdfXRefStreamParserObject(PdfVecObjects* pCreator, PdfParserObjectTokenizer* pTokenizer, 
+                              PdfParser::TVecOffsets* pOffsets );
 
     ~PdfXRefStreamParserObject();
 
@@ -21,7 +21,7 @@
 #ifndef PDF_PDFMUTEX_H
 #define PDF_PDFMUTEX_H
 
-#if defined(BUILDING_PODOFO)
+#include "../PdfDefines.h"
 
 /* Import the platform-specific implementation of PdfMutex */
 #if defined(PODOFO_MULTI_THREAD)
@@ -51,6 +51,8 @@ namespace PoDoFo { namespace Util {
  * then exactly one thread attempting to acquire it will succeed. If there is more than one
  * thread trying to acquire a PdfMutex, which thread will succeed is undefined.
  *
+ * PdfMutex is public API, but is not included by podofo.h.
+ * Include <podofo/base/util/PdfMutex.h> explicitly.
  */
 class PdfMutex : public PdfMutexImpl
 {
@@ -63,10 +65,5 @@ class PdfMutex : public PdfMutexImpl
 
 };};
 
-#else // BUILDING_PODOFO
-// Only a forward-declaration is available for PdfMutex for sources outside the
-// PoDoFo library build its self. PdfMutex is not public API.
-namespace PoDoFo { namespace Util { class PdfMutex; }; };
-#endif
 
 #endif
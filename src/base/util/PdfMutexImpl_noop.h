@@ -19,7 +19,9 @@
  ***************************************************************************/
 
 #include "../PdfDefines.h"
-#include "../PdfDefinesPrivate.h"
+#if defined(BUILDING_PODOFO)
+#  include "../PdfDefinesPrivate.h"
+#endif
 
 #if defined(PODOFO_MULTI_THREAD)
 #error "Multi-thread build, a real PdfMutex implementation should be used instead"
@@ -32,7 +34,7 @@ namespace Util {
  * A platform independent non-reentrant mutex, no-op implementation.
  * This version is used if PoDoFo is built without threading support.
  *  
- * PdfMutex is *NOT* part of PoDoFo's public API.
+ * Use PdfMutex instead of this class.
  */
 class PdfMutexImpl {
   public:
@@ -19,7 +19,9 @@
  ***************************************************************************/
 
 #include "../PdfDefines.h"
-#include "../PdfDefinesPrivate.h"
+#if defined(BUILDING_PODOFO)
+#  include "../PdfDefinesPrivate.h"
+#endif
 
 #if ! defined(PODOFO_MULTI_THREAD)
 #error "Not a multi-thread build. PdfMutex_null.h should be used instead"
@@ -38,7 +40,7 @@ namespace Util {
 /**
  * A platform independent reentrant mutex, pthread implementation.
  *  
- * PdfMutex is *NOT* part of PoDoFo's public API.
+ * Use PdfMutex instead of this class.
  *
  * This is the pthread implementation, which is
  * entirely inline.
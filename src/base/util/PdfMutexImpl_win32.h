@@ -19,7 +19,20 @@
  ***************************************************************************/
 
 #include "../PdfDefines.h"
-#include "../PdfDefinesPrivate.h"
+#if defined(BUILDING_PODOFO)
+#  include "../PdfDefinesPrivate.h"
+#else
+#  ifndef _WIN32_WINNT
+#    define _WIN32_WINNT 0x0400 // Make the TryEnterCriticalSection method available
+#    include <windows.h>
+#    undef _WIN32_WINNT 
+#  else
+#    include <windows.h>
+#  endif // _WIN32_WINNT
+#  if defined(GetObject)
+#    undef GetObject // Horrible windows.h macro definition that breaks things
+#  endif
+#endif
 
 #if ! defined(PODOFO_MULTI_THREAD)
 #error "Not a multi-thread build. PdfMutex_null.h should be used instead"
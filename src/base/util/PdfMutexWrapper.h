@@ -35,7 +35,8 @@ namespace Util {
  * In debug builds all exceptions thrown by the mutex implementation
  * are caught and logged before being rethrown.
  *  
- * Note that PdfMutexWrapper is *not* part of PoDoFo's public API.
+ * PdfMutexWrapper is public API like PdfMutex, but is not
+ * included by podofo.h.
  */
 class PdfMutexWrapper {
   public:
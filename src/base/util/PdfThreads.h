@@ -0,0 +1,180 @@
+/***************************************************************************
+ *   Copyright (C) 2007 by Dominik Seichter                                *
+ *   domseichter@web.de                                                    *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Library General Public License as       *
+ *   published by the Free Software Foundation; either version 2 of the    *
+ *   License, or (at your option) any later version.                       *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this program; if not, write to the                 *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#ifndef PDF_PDFTHREADS_H
+#define PDF_PDFTHREADS_H
+
+/**
+ * \file PdfThreads.h
+ *
+ * Helpers to run a function on several threads, used together with
+ * PdfMutex and PdfMutexWrapper. They are public API for applications
+ * and the PoDoFo tools, but are not included by podofo.h:
+ * include <podofo/base/util/PdfThreads.h> explicitly.
+ *
+ * All functions are inline. On Windows this header includes windows.h
+ * if PoDoFo is built with PODOFO_MULTI_THREAD.
+ */
+
+#include "../PdfDefines.h"
+
+#include <vector>
+
+#if defined(PODOFO_MULTI_THREAD)
+#  if defined(_WIN32)
+#    include <windows.h>
+#  else
+#    include <pthread.h>
+#    include <unistd.h>
+#  endif
+#endif
+
+namespace PoDoFo { namespace Util {
+
+/** A function which is run on several threads by RunOnThreads().
+ */
+typedef void (*PdfThreadFunction)( void* pData );
+
+/** Passed to each thread started by RunOnThreads().
+ */
+struct TPdfThreadData {
+    PdfThreadFunction pFunction;
+    void*             pData;
+};
+
+#if defined(PODOFO_MULTI_THREAD)
+#  if defined(_WIN32)
+inline DWORD WINAPI PdfThreadMain( LPVOID pData )
+{
+    TPdfThreadData* pThreadData = static_cast<TPdfThreadData*>(pData);
+    pThreadData->pFunction( pThreadData->pData );
+    return 0;
+}
+#  else
+inline void* PdfThreadMain( void* pData )
+{
+    TPdfThreadData* pThreadData = static_cast<TPdfThreadData*>(pData);
+    pThreadData->pFunction( pThreadData->pData );
+    return NULL;
+}
+#  endif
+#endif
+
+/**
+ * A full memory barrier. Use it for double-checked initialization:
+ * fill an object completely, call PdfMemoryBarrier() and only then
+ * store the pointer to it, which other threads read without locking.
+ *
+ * Does nothing if PODOFO_MULTI_THREAD is not set.
+ */
+inline void PdfMemoryBarrier()
+{
+#if defined(PODOFO_MULTI_THREAD)
+#  if defined(_WIN32)
+    MemoryBarrier();
+#  elif defined(__GNUC__)
+    __sync_synchronize();
+#  endif
+#endif
+}
+
+/**
+ * \returns the number of CPUs of this machine or 1 if it is unknown
+ *          or if PODOFO_MULTI_THREAD is not set
+ */
+inline int GetCPUCount()
+{
+#if defined(PODOFO_MULTI_THREAD)
+#  if defined(_WIN32)
+    SYSTEM_INFO info;
+    GetSystemInfo( &info );
+    return static_cast<int>(info.dwNumberOfProcessors);
+#  elif defined(_SC_NPROCESSORS_ONLN)
+    long lCount = sysconf( _SC_NPROCESSORS_ONLN );
+    return lCount > 0 ? static_cast<int>(lCount) : 1;
+#  else
+    return 1;
+#  endif
+#else
+    return 1;
+#endif
+}
+
+/**
+ * Run a function on several threads at once and wait until
+ * all of them have returned. The calling thread runs the function, too,
+ * so nThreads - 1 threads are started. If no thread can be started,
+ * or if PODOFO_MULTI_THREAD is not set, the function only runs once
+ * on the calling thread.
+ *
+ * The function usually takes jobs from a queue shared by all threads
+ * until the queue is empty. It must not throw exceptions.
+ *
+ * \param pFunction the function to run
+ * \param pData passed to every call of pFunction
+ * \param nThreads the number of threads including the calling one
+ */
+inline void RunOnThreads( PdfThreadFunction pFunction, void* pData, int nThreads )
+{
+#if defined(PODOFO_MULTI_THREAD)
+    TPdfThreadData threadData;
+    threadData.pFunction = pFunction;
+    threadData.pData     = pData;
+
+#  if defined(_WIN32)
+    std::vector<HANDLE> vecThreads;
+    for( int i = 1; i < nThreads; i++ )
+    {
+        HANDLE hThread = CreateThread( NULL, 0, PdfThreadMain, &threadData, 0, NULL );
+        if( hThread )
+            vecThreads.push_back( hThread );
+    }
+#  else
+    std::vector<pthread_t> vecThreads;
+    for( int i = 1; i < nThreads; i++ )
+    {
+        pthread_t thread;
+        if( pthread_create( &thread, NULL, PdfThreadMain, &threadData ) == 0 )
+            vecThreads.push_back( thread );
+    }
+#  endif
+#else
+    (void)nThreads;
+#endif
+
+    pFunction( pData );
+
+#if defined(PODOFO_MULTI_THREAD)
+#  if defined(_WIN32)
+    for( size_t i = 0; i < vecThreads.size(); i++ )
+    {
+        WaitForSingleObject( vecThreads[i], INFINITE );
+        CloseHandle( vecThreads[i] );
+    }
+#  else
+    for( size_t i = 0; i < vecThreads.size(); i++ )
+        pthread_join( vecThreads[i], NULL );
+#  endif
+#endif
+}
+
+};};
+
+#endif // PDF_PDFTHREADS_H
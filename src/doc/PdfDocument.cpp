@@ -35,6 +35,7 @@
 #include "base/PdfDictionary.h"
 #include "base/PdfImmediateWriter.h"
 #include "base/PdfObject.h"
+#include "base/PdfParserObject.h"
 #include "base/PdfStream.h"
 #include "base/PdfVecObjects.h"
 
@@ -58,7 +59,7 @@ namespace PoDoFo {
 PdfDocument::PdfDocument()
     : m_fontCache( &m_vecObjects ), m_pOutlines( NULL ), 
       m_pNamesTree( NULL ), m_pPagesTree( NULL ), 
-      m_pAcroForms( NULL )
+      m_pAcroForms( NULL ), m_bStreamPassthrough( false )
 {
     m_vecObjects.SetParentDocument( this );
 
@@ -263,7 +264,10 @@ const PdfDocument & PdfDocument::Append( const PdfMemDocument & rDoc, bool bAppe
                                              static_cast<unsigned int>((*it)->Reference().ObjectNumber() + difference), (*it)->Reference().GenerationNumber() ), *(*it) );
         m_vecObjects.push_back( pObj );
 
-        if( (*it)->IsDictionary() && (*it)->HasStream() )
+        PdfParserObject* pParserObj = m_bStreamPassthrough ? dynamic_cast<PdfParserObject*>(*it) : NULL;
+        if( pParserObj && pParserObj->IsDictionary() && pParserObj->CanCopyRawStream() )
+            pParserObj->CopyRawStream( pObj->GetStream() );
+        else if( (*it)->IsDictionary() && (*it)->HasStream() )
             *(pObj->GetStream()) = *((*it)->GetStream());
 
         PdfError::LogMessage( eLogSeverity_Information,
@@ -338,6 +338,33 @@ class PODOFO_DOC_API PdfDocument {
      */
     PdfRect FillXObjectFromPage( PdfXObject * pXObj, const PdfPage * pPage, bool bUseTrimBox, unsigned int difference );
 
+    /** Enable or disable stream passthrough for Append() and
+     *  FillXObjectFromDocumentPage().
+     *
+     *  If enabled, streams of objects parsed from another document
+     *  which have not been loaded yet are not read while appending.
+     *  Only a reference to their still encoded data in the input device
+     *  of the other document is kept, and the data is copied directly to
+     *  the output device when this document is written. Merging large
+     *  documents therefore neither keeps their streams in memory nor
+     *  re-encodes them.
+     *
+     *  The input device of the other document is kept open as long as
+     *  it is referenced and the file it reads from must not be modified
+     *  before this document is written. Streams of encrypted documents
+     *  are always copied into memory.
+     *
+     *  Stream passthrough is disabled by default.
+     *
+     *  \param bPassthrough if true enable stream passthrough
+     */
+    inline void SetStreamPassthrough( bool bPassthrough );
+
+    /** \returns true if stream passthrough is enabled
+     *  \see SetStreamPassthrough
+     */
+    inline bool IsStreamPassthrough() const;
+
     /** Attach a file to the document.
      *  \param rFileSpec a file specification
      */
@@ -638,6 +665,8 @@ class PODOFO_DOC_API PdfDocument {
     PdfAcroForm*    m_pAcroForms;
 
     EPdfVersion     m_eVersion;
+
+    bool            m_bStreamPassthrough;
 };
 
 // -----------------------------------------------------
@@ -723,6 +752,22 @@ inline void PdfDocument::SetFontConfigWrapper(const PdfFontConfigWrapper & rFont
     m_fontCache.SetFontConfigWrapper(rFontConfig);
 }
 
+// -----------------------------------------------------
+// 
+// -----------------------------------------------------
+inline void PdfDocument::SetStreamPassthrough( bool bPassthrough )
+{
+    m_bStreamPassthrough = bPassthrough;
+}
+
+// -----------------------------------------------------
+// 
+// -----------------------------------------------------
+inline bool PdfDocument::IsStreamPassthrough() const
+{
+    return m_bStreamPassthrough;
+}
+
 };
 
 
@@ -38,11 +38,115 @@
 
 using namespace std;
 
+/** Size of the buffers on the stack, which are used
+ *  by PdfFont::WriteStringToStream().
+ */
+#define PODOFO_FONT_STRING_BUFFER 256
+
 namespace PoDoFo {
 
+namespace PdfFontNameSpace {
+
+static const char s_cHexDigits[] = "0123456789ABCDEF";
+
+static char g_LiteralLen[256] = { 0 };
+
+// Generate a map with the number of bytes each character
+// takes in a literal string, escapes included
+static const char* genLiteralLen()
+{
+    char* map = static_cast<char*>(g_LiteralLen);
+    for( int i=0;i<256;i++ ) 
+        map[i] = (i < 0x20 || i > 0x7e ? 4 : 1); // \ddd or the character itself
+
+    map[static_cast<unsigned char>('\n')]  = 2;
+    map[static_cast<unsigned char>('\r')]  = 2;
+    map[static_cast<unsigned char>('\t')]  = 2;
+    map[static_cast<unsigned char>('\b')]  = 2;
+    map[static_cast<unsigned char>('\f')]  = 2;
+    map[static_cast<unsigned char>('(')]   = 2;
+    map[static_cast<unsigned char>(')')]   = 2;
+    map[static_cast<unsigned char>('\\')] = 2;
+
+    return map;
+}
+
+static const char* const s_pLiteralLen = genLiteralLen();
+
+/** Write an encoded string either as literal or as hex string
+ *  to a stream, whichever is shorter. The output is collected
+ *  in a buffer on the stack, so that no memory is allocated.
+ */
+static void WriteEncodedString( const char* pEncoded, pdf_long lLen, PdfStream* pStream )
+{
+    const unsigned char* pCur = reinterpret_cast<const unsigned char*>(pEncoded);
+    const unsigned char* pEnd = pCur + lLen;
+    pdf_long             lLiteralLen = 0;
+    char                 szOut[PODOFO_FONT_STRING_BUFFER];
+    int                  nOut = 0;
+
+    for( ; pCur != pEnd; ++pCur )
+        lLiteralLen += s_pLiteralLen[*pCur];
+
+    const bool bHex = (lLiteralLen > 2 * lLen);
+
+    szOut[nOut++] = bHex ? '<' : '(';
+    for( pCur = reinterpret_cast<const unsigned char*>(pEncoded); pCur != pEnd; ++pCur )
+    {
+        // Make sure an escape sequence always fits into the buffer
+        if( nOut > PODOFO_FONT_STRING_BUFFER - 4 ) 
+        {
+            pStream->Append( szOut, nOut );
+            nOut = 0;
+        }
+
+        if( bHex ) 
+        {
+            szOut[nOut++] = s_cHexDigits[*pCur >> 4];
+            szOut[nOut++] = s_cHexDigits[*pCur & 0x0f];
+        }
+        else if( s_pLiteralLen[*pCur] == 1 ) 
+            szOut[nOut++] = static_cast<char>(*pCur);
+        else
+        {
+            szOut[nOut++] = '\\';
+            switch( *pCur ) 
+            {
+                case '\n': szOut[nOut++] = 'n'; break;
+                case '\r': szOut[nOut++] = 'r'; break;
+                case '\t': szOut[nOut++] = 't'; break;
+                case '\b': szOut[nOut++] = 'b'; break;
+                case '\f': szOut[nOut++] = 'f'; break;
+                case '(':
+                case ')':
+                case '\\':
+                    szOut[nOut++] = static_cast<char>(*pCur); 
+                    break;
+                default:
+                    szOut[nOut++] = static_cast<char>('0' + ((*pCur >> 6) & 0x07));
+                    szOut[nOut++] = static_cast<char>('0' + ((*pCur >> 3) & 0x07));
+                    szOut[nOut++] = static_cast<char>('0' + (*pCur & 0x07));
+                    break;
+            }
+        }
+    }
+
+    if( nOut > PODOFO_FONT_STRING_BUFFER - 1 ) 
+    {
+        pStream->Append( szOut, nOut );
+        nOut = 0;
+    }
+
+    szOut[nOut++] = bHex ? '>' : ')';
+    pStream->Append( szOut, nOut );
+}
+
+};
+
 PdfFont::PdfFont( PdfFontMetrics* pMetrics, const PdfEncoding* const pEncoding, PdfVecObjects* pParent )
     : PdfElement( "Font", pParent ), m_pEncoding( pEncoding ), 
-      m_pMetrics( pMetrics ), m_bBold( false ), m_bItalic( false ), m_isBase14( false ), m_bIsSubsetting( false )
+      m_pMetrics( pMetrics ), m_bBold( false ), m_bItalic( false ), m_isBase14( false ), m_bIsSubsetting( false ),
+      m_pMutex( new Util::PdfMutex() )
 
 {
     this->InitVars();
@@ -51,7 +155,8 @@ PdfFont::PdfFont( PdfFontMetrics* pMetrics, const PdfEncoding* const pEncoding,
 PdfFont::PdfFont( PdfFontMetrics* pMetrics, const PdfEncoding* const pEncoding, PdfObject* pObject )
     : PdfElement( "Font", pObject ),
       m_pEncoding( pEncoding ), m_pMetrics( pMetrics ),
-      m_bBold( false ), m_bItalic( false ), m_isBase14( false ), m_bIsSubsetting( false )
+      m_bBold( false ), m_bItalic( false ), m_isBase14( false ), m_bIsSubsetting( false ),
+      m_pMutex( new Util::PdfMutex() )
 
 {
     // Implementation note: the identifier is always
@@ -67,6 +172,8 @@ PdfFont::~PdfFont()
     delete m_pMetrics;
     if( m_pEncoding && m_pEncoding->IsAutoDelete() )
         delete m_pEncoding;
+
+    delete m_pMutex;
 }
 
 void PdfFont::InitVars()
@@ -125,18 +232,35 @@ void PdfFont::WriteStringToStream( const PdfString & rsString, PdfStream* pStrea
         PODOFO_RAISE_ERROR( ePdfError_InvalidHandle );
     }
 
-    PdfRefCountedBuffer buffer = m_pEncoding->ConvertToEncoding( rsString, this );
-    pdf_long  lLen    = 0;
-    char* pBuffer = NULL;
+    if( m_bIsSubsetting )
+        this->AddUsedSubsettingGlyphs( rsString, static_cast<long>(rsString.GetCharacterLength()) );
 
-    std::auto_ptr<PdfFilter> pFilter = PdfFilterFactory::Create( ePdfFilter_ASCIIHexDecode );    
-    pFilter->Encode( buffer.GetBuffer(), buffer.GetSize(), &pBuffer, &lLen );
+    // Encode into a buffer on the stack,
+    // only very long strings need a buffer on the heap
+    char     szEncoded[PODOFO_FONT_STRING_BUFFER];
+    char*    pEncoded = szEncoded;
+    pdf_long lLen     = m_pEncoding->ConvertToEncodingBuffer( rsString, this, szEncoded, PODOFO_FONT_STRING_BUFFER );
 
-    pStream->Append( "<", 1 );
-    pStream->Append( pBuffer, lLen );
-    pStream->Append( ">", 1 );
-
-    free( pBuffer );
+    if( lLen > PODOFO_FONT_STRING_BUFFER ) 
+    {
+        pEncoded = static_cast<char*>(podofo_malloc( lLen ));
+        if( !pEncoded ) 
+        {
+            PODOFO_RAISE_ERROR( ePdfError_OutOfMemory );
+        }
+
+        try {
+            m_pEncoding->ConvertToEncodingBuffer( rsString, this, pEncoded, lLen );
+            PdfFontNameSpace::WriteEncodedString( pEncoded, lLen, pStream );
+        } catch( PdfError & rError ) {
+            podofo_free( pEncoded );
+            throw rError;
+        }
+
+        podofo_free( pEncoded );
+    }
+    else
+        PdfFontNameSpace::WriteEncodedString( pEncoded, lLen, pStream );
 }
 
 // Peter Petrov 5 January 2009
@@ -24,6 +24,7 @@
 #include "podofo/base/PdfDefines.h"
 #include "podofo/base/PdfName.h"
 #include "podofo/base/PdfEncodingFactory.h"
+#include "podofo/base/util/PdfMutex.h"
 #include "PdfElement.h"
 #include "PdfFontMetrics.h"
 
@@ -185,6 +186,9 @@ class PODOFO_DOC_API PdfFont : public PdfElement {
      *  This is used by PdfPainter::DrawText to display a text string.
      *  The following PDF operator will be Tj
      *
+     *  If the font is subsetting, the glyphs of the string are
+     *  remembered using AddUsedSubsettingGlyphs().
+     *
      *  \param rsString a unicode or ansi string which will be displayed
      *  \param pStream the string will be appended to pStream without any leading
      *                 or following whitespaces.
@@ -249,6 +253,8 @@ class PODOFO_DOC_API PdfFont : public PdfElement {
     bool m_bIsSubsetting;
     PdfName m_Identifier;
 
+    Util::PdfMutex* m_pMutex; ///< Protects the glyphs used for subsetting, as several PdfPainters may add them at once
+
  private:
     /** default constructor, not implemented
      */
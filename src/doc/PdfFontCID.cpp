@@ -28,6 +28,7 @@
 #include "base/PdfLocale.h"
 #include "base/PdfName.h"
 #include "base/PdfStream.h"
+#include "base/util/PdfMutexWrapper.h"
 
 #include "PdfFontMetricsFreetype.h"
 
@@ -43,15 +44,23 @@ struct TBFRange {
     std::vector<int> vecDest;
 };
 
+struct TGlyphWidth {
+    long   lGlyph;
+    double dWidth;
+};
+
 PdfFontCID::PdfFontCID( PdfFontMetrics* pMetrics, const PdfEncoding* const pEncoding, 
-                        PdfVecObjects* pParent, bool bEmbed )
-    : PdfFont( pMetrics, pEncoding, pParent )
+                        PdfVecObjects* pParent, bool bEmbed, bool bSubsetting )
+    : PdfFont( pMetrics, pEncoding, pParent ), 
+      m_pDescendantFonts( NULL ), m_pUnicode( NULL ), m_bSubsetDirty( true )
 {
+    m_bIsSubsetting = bSubsetting;
     this->Init( bEmbed );
 }
 
 PdfFontCID::PdfFontCID( PdfFontMetrics* pMetrics, const PdfEncoding* const pEncoding, PdfObject* pObject, bool )
-    : PdfFont( pMetrics, pEncoding, pObject )
+    : PdfFont( pMetrics, pEncoding, pObject ),
+      m_pDescendantFonts( NULL ), m_pUnicode( NULL ), m_bSubsetDirty( true )
 {
     /* this->Init( bEmbed ); */
 }
@@ -98,11 +107,18 @@ void PdfFontCID::Init( bool bEmbed )
     pDescendantFonts->GetDictionary().AddKey( "FontDescriptor", pDescriptor->Reference() );
     pDescendantFonts->GetDictionary().AddKey( "CIDToGIDMap", PdfName("Identity") );
 
-    // Add the width keys
-    this->CreateWidth( pDescendantFonts );
-
-    // Create the ToUnicode CMap
-    this->CreateCMap( pUnicode );
+    // Add the width keys and create the ToUnicode CMap.
+    // A subsetting font does this in EmbedSubsetFont(),
+    // when all used glyphs are known.
+    m_pDescendantFonts = pDescendantFonts;
+    m_pUnicode         = pUnicode;
+    if( !m_bIsSubsetting )
+    {
+        TMapGlyphs mapGlyphs;
+        this->FillAllGlyphs( mapGlyphs );
+        this->CreateWidth( pDescendantFonts, mapGlyphs );
+        this->CreateCMap( pUnicode, mapGlyphs );
+    }
 
     // Setting the CIDSystemInfo paras:
     pCIDSystemInfo->GetDictionary().AddKey( "Registry", PdfString("Adobe") );
@@ -184,156 +200,191 @@ void PdfFontCID::EmbedFont( PdfObject* pDescriptor )
     }
 }
 
-void PdfFontCID::CreateWidth( PdfObject* pFontDict ) const
+void PdfFontCID::AddUsedSubsettingGlyphs( const PdfString & sText, long lStringLen )
 {
-    const int cAbsoluteMax = 0xffff;
-    int nFirstChar = m_pEncoding->GetFirstChar();
-    int nLastChar  = m_pEncoding->GetLastChar();
+    if( !m_bIsSubsetting )
+        return;
 
-    int  i;
+    // Find the glyphs in the same way as PdfIdentityEncoding::ConvertToEncoding
+    PdfString          sStr = sText.ToUnicode();
+    const pdf_utf16be* pStr = sStr.GetUnicode();
+    pdf_utf16be        cChar;
+    long               lGlyph;
 
-    // Allocate an initialize an array, large enough to 
-    // hold a width value for every possible glyph index
-    double* pdWidth = static_cast<double*>(malloc( sizeof(double) * cAbsoluteMax ) );
-    if( !pdWidth )
+    for( long i=0;i<lStringLen && pStr[i];i++ )
     {
-        PODOFO_RAISE_ERROR( ePdfError_OutOfMemory );
+#ifdef PODOFO_IS_LITTLE_ENDIAN
+        cChar = static_cast<pdf_utf16be>(((pStr[i] & 0xff) << 8) | ((pStr[i] & 0xff00) >> 8));
+#else
+        cChar = pStr[i];
+#endif // PODOFO_IS_LITTLE_ENDIAN
+
+        // PdfPainter draws tabs as spaces
+        if( cChar == static_cast<pdf_utf16be>('\t') )
+            cChar = static_cast<pdf_utf16be>(' ');
+
+        lGlyph = m_pMetrics->GetGlyphId( cChar );
+        if( lGlyph )
+        {
+            Util::PdfMutexWrapper wrapper( *m_pMutex );
+            if( m_mapUsedGlyphs.insert( TMapGlyphs::value_type( lGlyph, cChar ) ).second )
+                m_bSubsetDirty = true;
+        }
     }
+}
 
-    for( i=0;i<cAbsoluteMax;i++ )
-        pdWidth[i] = 0.0;
+void PdfFontCID::EmbedSubsetFont()
+{
+    if( !m_bIsSubsetting )
+        return;
+
+    Util::PdfMutexWrapper wrapper( *m_pMutex );
+    if( !m_bSubsetDirty )
+        return;
 
-    // Load the width of all requested glyph indeces
-    int nMin       = 0xffff;
-    int nMax       = 0;
+    m_bSubsetDirty = false;
 
-    long    lGlyph = 0;
+    this->CreateWidth( m_pDescendantFonts, m_mapUsedGlyphs );
+    this->CreateCMap( m_pUnicode, m_mapUsedGlyphs );
+}
 
-    for( i=nFirstChar;i<=nLastChar;i++ )
+void PdfFontCID::FillAllGlyphs( TMapGlyphs & rMapGlyphs ) const
+{
+    long lFirstChar = m_pEncoding->GetFirstChar();
+    long lLastChar  = PDF_MIN( static_cast<long>(m_pEncoding->GetLastChar()), 0xffffL );
+    long lGlyph;
+
+    PdfFontMetricsFreetype* pFreetype = dynamic_cast<PdfFontMetricsFreetype*>(m_pMetrics);
+    if( pFreetype ) 
     {
-        lGlyph = m_pMetrics->GetGlyphId( i );
-        if( lGlyph )
+        // Walk through the characters of the font
+        // instead of asking for every possible character
+        FT_Face   face = pFreetype->GetFace();
+        FT_ULong  charcode;
+        FT_UInt   gindex;
+
+        charcode = FT_Get_First_Char( face, &gindex );
+        while( gindex != 0 && static_cast<long>(charcode) <= lLastChar )
         {
-            nMin = PDF_MIN( static_cast<long>(nMin), lGlyph );
-            nMax = PDF_MAX( static_cast<long>(nMax), lGlyph );
-            nMax = PDF_MIN( nMax, cAbsoluteMax );
-
-            if( lGlyph < cAbsoluteMax )
-                pdWidth[lGlyph] = m_pMetrics->GetGlyphWidth( lGlyph );
+            if( static_cast<long>(charcode) >= lFirstChar )
+                rMapGlyphs.insert( TMapGlyphs::value_type( gindex, static_cast<pdf_utf16be>(charcode) ) );
 
+            charcode = FT_Get_Next_Char( face, charcode, &gindex );
+        }
+    }
+    else
+    {
+        for( long i=lFirstChar;i<=lLastChar;i++ )
+        {
+            lGlyph = m_pMetrics->GetGlyphId( i );
+            if( lGlyph )
+                rMapGlyphs.insert( TMapGlyphs::value_type( lGlyph, static_cast<pdf_utf16be>(i) ) );
         }
     }
+}
+
+void PdfFontCID::CreateWidth( PdfObject* pFontDict, const TMapGlyphs & rMapGlyphs ) const
+{
+    if( rMapGlyphs.empty() )
+        return;
 
-	if (nMax >= nMin) {
-        // Now compact the array
-        std::ostringstream oss;
-        PdfArray array;
-        array.reserve( nMax - nMin + 1 );
+    // Load the width of all glyphs, sorted by glyph id
+    std::vector<TGlyphWidth> vecWidths;
+    vecWidths.reserve( rMapGlyphs.size() );
 
-        i = nMin;
-        double    dCurWidth  = pdWidth[i];
-        pdf_int64 lCurIndex  = i++;
-        pdf_int64 lCurLength = 1L;
-        
-        for( ;i<=nMax;i++ )
+    TCIMapGlyphs itGlyph = rMapGlyphs.begin();
+    while( itGlyph != rMapGlyphs.end() )
+    {
+        TGlyphWidth width;
+        width.lGlyph = (*itGlyph).first;
+        width.dWidth = m_pMetrics->GetGlyphWidth( width.lGlyph );
+        vecWidths.push_back( width );
+
+        ++itGlyph;
+    }
+
+    // Now compact the widths: Consecutive glyphs with the same width
+    // become a range "first last width", all other glyphs are 
+    // collected in arrays "first [width width ...]"
+    PdfArray  array;
+    pdf_int64 lArrayNext = -1; // the glyph which may be appended to the last array
+    size_t    i          = 0;
+
+    while( i < vecWidths.size() ) 
+    {
+        const TGlyphWidth & rCur = vecWidths[i];
+
+        size_t j = i + 1;
+        while( j < vecWidths.size() && 
+               vecWidths[j].lGlyph == vecWidths[j-1].lGlyph + 1 &&
+               static_cast<int>(vecWidths[j].dWidth - rCur.dWidth) == 0 )
+            ++j;
+
+        if( j - i > 1 ) 
+        {
+            array.push_back( static_cast<pdf_int64>(rCur.lGlyph) );
+            array.push_back( static_cast<pdf_int64>(vecWidths[j-1].lGlyph) );
+            array.push_back( rCur.dWidth );
+
+            lArrayNext = -1;
+        }
+        else
         {
-            if( static_cast<int>(pdWidth[i] - dCurWidth) == 0 )
-                ++lCurLength;
+            if( rCur.lGlyph == lArrayNext && array.back().IsArray() ) 
+            {
+                array.back().GetArray().push_back( rCur.dWidth );
+            }
             else
             {
-                if( lCurLength > 1 ) 
-                {
-                    array.push_back( lCurIndex );
-                    pdf_int64 temp = lCurIndex + lCurLength - 1;
-                    array.push_back( temp ); 
-                    array.push_back( dCurWidth ); 
-                }
-                else
-                {
-                    if( array.size() && array.back().IsArray() ) 
-                    {
-                        array.back().GetArray().push_back( dCurWidth );
-                    }
-                    else
-                    {
-                        PdfArray tmp;
-                        tmp.push_back( dCurWidth );
-                        
-                        array.push_back( lCurIndex );
-                        array.push_back( tmp );
-                    }
-                }
-                
-                lCurIndex  = i;
-                lCurLength = 1L;
-                dCurWidth  = pdWidth[i];
+                PdfArray tmp;
+                tmp.push_back( rCur.dWidth );
+
+                array.push_back( static_cast<pdf_int64>(rCur.lGlyph) );
+                array.push_back( tmp );
             }
-        }
 
-        if (array.size() == 0) 
-        {
-            array.push_back( lCurIndex = nMin );
-            array.push_back( lCurIndex = nMax );
-            array.push_back( dCurWidth ); 
+            lArrayNext = rCur.lGlyph + 1;
         }
-        
-        pFontDict->GetDictionary().AddKey( PdfName("W"), array ); 
+
+        i = j;
     }
 
-    free( pdWidth );
+    pFontDict->GetDictionary().AddKey( PdfName("W"), array ); 
 }
 
-void PdfFontCID::CreateCMap( PdfObject* pUnicode ) const
+void PdfFontCID::CreateCMap( PdfObject* pUnicode, const TMapGlyphs & rMapGlyphs ) const
 {
-    PdfFontMetricsFreetype* pFreetype = dynamic_cast<PdfFontMetricsFreetype*>(m_pMetrics);
-	if (!pFreetype) return;
-
-    int  nFirstChar = m_pEncoding->GetFirstChar();
-    int  nLastChar  = m_pEncoding->GetLastChar();
-
     std::ostringstream oss;
 
-    FT_Face   face = pFreetype->GetFace();
-    FT_ULong  charcode;                                              
-    FT_UInt   gindex;                                                
-
     TBFRange curRange;
     curRange.srcCode = -1;
     std::vector<TBFRange> vecRanges;
-    // Only 255 sequent characters are allowed to be in one range!
-    const unsigned int MAX_CHARS_IN_RANGE = 255;
 
-    charcode = FT_Get_First_Char( face, &gindex );                   
-    while ( gindex != 0 )                                            
-    {        
-        if( static_cast<int>(charcode) > nLastChar )
+    // Glyphs of one bfrange may only differ in the last byte
+    TCIMapGlyphs itGlyph = rMapGlyphs.begin();
+    while( itGlyph != rMapGlyphs.end() )
+    {
+        const int nGlyph = static_cast<int>((*itGlyph).first);
+
+        if( curRange.vecDest.size() && 
+            curRange.srcCode + static_cast<int>(curRange.vecDest.size()) == nGlyph && 
+            (curRange.srcCode & 0xff00) == (nGlyph & 0xff00) )
         {
-            break;
+            curRange.vecDest.push_back( (*itGlyph).second );
         }
-        else if( static_cast<int>(charcode) >= nFirstChar )
+        else
         {
-            if( curRange.vecDest.size() == 0 ) 
-            {
-                curRange.srcCode  = gindex;
-                curRange.vecDest.push_back( charcode );
-            }
-            else if( (curRange.srcCode + curRange.vecDest.size() == gindex) && 
-                     ((gindex - curRange.srcCode + curRange.vecDest.size()) < MAX_CHARS_IN_RANGE) )
-            {
-                curRange.vecDest.push_back( charcode );
-            } 
-            else
-            {
-                // Create a new bfrange
+            // Create a new bfrange
+            if( curRange.vecDest.size() ) 
                 vecRanges.push_back( curRange );
-                curRange.srcCode = gindex;
-                curRange.vecDest.clear();
-                curRange.vecDest.push_back( charcode );
-            }
+
+            curRange.srcCode = nGlyph;
+            curRange.vecDest.clear();
+            curRange.vecDest.push_back( (*itGlyph).second );
         }
 
-        charcode = FT_Get_Next_Char( face, charcode, &gindex );        
-    }   
+        ++itGlyph;
+    }
 
     if( curRange.vecDest.size() ) 
         vecRanges.push_back( curRange );
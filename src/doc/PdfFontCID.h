@@ -24,11 +24,19 @@
 #include "podofo/base/PdfDefines.h"
 #include "PdfFont.h"
 
+#include <map>
+
 namespace PoDoFo {
 
 class PdfFontMetricsFreetype;
 
 /** A PdfFont that represents a CID font.
+ *
+ *  The /W array and the ToUnicode CMap of a new CID font normally
+ *  contain all glyphs of the font which are reachable from a unicode
+ *  character. A subsetting CID font records the glyphs that are
+ *  actually drawn instead and writes both only for those glyphs
+ *  in EmbedSubsetFont().
  */
 class PdfFontCID : public PdfFont {
  public:
@@ -42,10 +50,15 @@ class PdfFontCID : public PdfFont {
      *                   depending on pEncoding->IsAutoDelete()
      *  \param pParent parent of the font object
      *  \param bEmbed specifies the embedding of font
+     *  \param bSubsetting if true /W and ToUnicode contain only the glyphs
+     *                     passed to AddUsedSubsettingGlyphs(). They are written
+     *                     by EmbedSubsetFont(). The embedded font file itself is
+     *                     not subsetted, as the glyph ids in the content streams
+     *                     are the glyph ids of the complete font.
      *  
      */
     PdfFontCID( PdfFontMetrics* pMetrics, const PdfEncoding* const pEncoding, 
-                PdfVecObjects* pParent, bool bEmbed = true );
+                PdfVecObjects* pParent, bool bEmbed = true, bool bSubsetting = false );
 
     // Peter Petrov 30 April 2008
     /** Create a PdfFont based on an existing PdfObject
@@ -65,20 +78,53 @@ class PdfFontCID : public PdfFont {
      */
     virtual void EmbedFont();
 
+    /** Remember the glyphs used in the string in case of subsetting
+     *
+     *  \param sText the text string which should be printed
+     *  \param lStringLen only the first lStringLen characters of sText are used
+     *
+     *  \see IsSubsetting
+     */
+    virtual void AddUsedSubsettingGlyphs( const PdfString & sText, long lStringLen );
+
+    /** Write the /W array and the ToUnicode CMap
+     *  for all glyphs used so far. Does nothing if the font
+     *  is not subsetting or if no glyphs were added since
+     *  the last call, so that a document can be written again
+     *  after more text was drawn.
+     *
+     *  \see IsSubsetting
+     */
+    virtual void EmbedSubsetFont();
+
  private:
-    /** Create the DW and W entries which contain
-     *  all glyph width in the given font dictionary.
+    /** Maps glyph ids to the unicode character they were created from, sorted by glyph id
+     */
+    typedef std::map<long,pdf_utf16be>     TMapGlyphs;
+    typedef TMapGlyphs::const_iterator     TCIMapGlyphs;
+
+    /** Add all glyphs of the font which are reachable from a character
+     *  between the first and the last character of the encoding.
+     *
+     *  \param rMapGlyphs the glyphs are added to this map
+     */
+    void FillAllGlyphs( TMapGlyphs & rMapGlyphs ) const;
+
+    /** Create the W entry which contains
+     *  the widths of the given glyphs in the given font dictionary.
      *
      *  \param pFontDict a CID font dictionary
+     *  \param rMapGlyphs the glyphs which are written
      */
-    void CreateWidth( PdfObject* pFontDict ) const;
+    void CreateWidth( PdfObject* pFontDict, const TMapGlyphs & rMapGlyphs ) const;
 
-    /** Create a ToUnicode CMap and write it to the stream
+    /** Create a ToUnicode CMap for the given glyphs and write it to the stream
      *  of the given object.
      *
      *  \param pUnicode the object which will contain the CMap
+     *  \param rMapGlyphs the glyphs which are written
      */
-    void CreateCMap( PdfObject* pUnicode ) const;
+    void CreateCMap( PdfObject* pUnicode, const TMapGlyphs & rMapGlyphs ) const;
 
  protected:
 
@@ -98,6 +144,13 @@ class PdfFontCID : public PdfFont {
  protected:
     // Peter Petrov 24 September 2008
     PdfObject* m_pDescriptor;
+
+ private:
+    PdfObject* m_pDescendantFonts;
+    PdfObject* m_pUnicode;
+
+    TMapGlyphs m_mapUsedGlyphs;      ///< Glyphs used so far in case of subsetting
+    bool       m_bSubsetDirty;       ///< true if glyphs were added since EmbedSubsetFont() wrote /W and ToUnicode
 };
 
 };
@@ -35,8 +35,10 @@
 #include "PdfFontMetricsBase14.h"
 #include "PdfFontTTFSubset.h"
 #include "PdfFontType1.h"
+#include "PdfSharedFontCache.h"
 
 #include <algorithm>
+#include <sstream>
 
 #ifdef _WIN32
 
@@ -450,10 +452,11 @@ PdfFont* PdfFontCache::GetFont( const char* pszFontName, bool bBold, bool bItali
 			}
 			else
 			{
-				bool bSubsetting = (eFontCreationFlags & eFontCreationFlags_Type1Subsetting) != 0;
-				pMetrics = new PdfFontMetricsFreetype( &m_ftLibrary, sPath.c_str() );
+				bool bSubsetting    = (eFontCreationFlags & eFontCreationFlags_Type1Subsetting) != 0;
+				bool bCIDSubsetting = (eFontCreationFlags & eFontCreationFlags_CIDSubsetting) != 0;
+				pMetrics = this->CreateFontMetrics( sPath.c_str() );
 				pFont    = this->CreateFontObject( it.first, m_vecFonts, pMetrics, 
-						   bEmbedd, bBold, bItalic, pszFontName, pEncoding, bSubsetting );
+						   bEmbedd, bBold, bItalic, pszFontName, pEncoding, bSubsetting, bCIDSubsetting );
 			}
 
 		}
@@ -547,7 +550,7 @@ PdfFont* PdfFontCache::GetDuplicateFontType1( PdfFont * pFont, const char* pszSu
 
     // Create a copy of the font
 	PODOFO_ASSERT( pFont->GetFontMetrics()->GetFontType() == ePdfFontType_Type1Pfb );
-	PdfFontMetrics* pMetrics = new PdfFontMetricsFreetype( &m_ftLibrary, pFont->GetFontMetrics()->GetFilename() );
+	PdfFontMetrics* pMetrics = this->CreateFontMetrics( pFont->GetFontMetrics()->GetFilename() );
 	PdfFont* newFont = new PdfFontType1( static_cast<PdfFontType1 *>(pFont), pMetrics, pszSuffix, m_pParent );
     if( newFont ) 
     {
@@ -600,7 +603,7 @@ PdfFont* PdfFontCache::GetFontSubset( const char* pszFontName, bool bBold, bool
         else
             sPath = pszFileName;
         
-        pMetrics = new PdfFontMetricsFreetype( &m_ftLibrary, sPath.c_str() );
+        pMetrics = this->CreateFontMetrics( sPath.c_str() );
         if( !(pMetrics && pMetrics->GetFontType() == ePdfFontType_TrueType ) )
         {
             PODOFO_RAISE_ERROR_INFO( ePdfError_InvalidFontFile, "Subsetting is only supported for TrueType fonts." );
@@ -610,7 +613,13 @@ PdfFont* PdfFontCache::GetFontSubset( const char* pszFontName, bool bBold, bool
         PdfRefCountedBuffer     buffer;
         PdfOutputDevice         output( &buffer );
         
-        PdfFontTTFSubset        subset( &input, pMetrics, PdfFontTTFSubset::eFontFileType_TTF );
+        const unsigned short    nFaceIndex = 0;
+        PdfFontTTFSubset        subset( &input, pMetrics, PdfFontTTFSubset::eFontFileType_TTF, nFaceIndex );
+        // Documents subsetting the same characters of this font share the subset,
+        // the key is built like the one of the filename constructor
+        std::ostringstream      oss;
+        oss << sPath << '#' << nFaceIndex;
+        subset.SetCacheKey( oss.str() );
         PdfEncoding::const_iterator itChar
             = pEncoding->begin();
         while( itChar != pEncoding->end() )
@@ -807,20 +816,37 @@ std::string PdfFontCache::GetFontConfigFontPath( FcConfig* pConfig, const char*
 
 std::string PdfFontCache::GetFontPath( const char* pszFontName, bool bBold, bool bItalic )
 {
+    std::string sPath;
+    if( PdfSharedFontCache::GetFontPath( pszFontName, bBold, bItalic, sPath ) )
+        return sPath;
+
 #if defined(PODOFO_HAVE_FONTCONFIG)
-    Util::PdfMutexWrapper mutex(m_fontConfig.GetFontConfigMutex());
-    FcConfig* pFcConfig = static_cast<FcConfig*>(m_fontConfig.GetFontConfig());
-    std::string sPath   = this->GetFontConfigFontPath( pFcConfig,
-                                                       pszFontName, bBold, bItalic );
-#else
-    std::string sPath = "";
+    {
+        Util::PdfMutexWrapper mutex(m_fontConfig.GetFontConfigMutex());
+        FcConfig* pFcConfig = static_cast<FcConfig*>(m_fontConfig.GetFontConfig());
+        sPath = this->GetFontConfigFontPath( pFcConfig, pszFontName, bBold, bItalic );
+    }
 #endif
+
+    if( !sPath.empty() )
+        PdfSharedFontCache::AddFontPath( pszFontName, bBold, bItalic, sPath );
+
     return sPath;
 }
 
+PdfFontMetrics* PdfFontCache::CreateFontMetrics( const char* pszFilename )
+{
+    PdfSharedFont* pSharedFont = PdfSharedFontCache::Acquire( pszFilename );
+    if( pSharedFont )
+        return new PdfFontMetricsFreetype( &m_ftLibrary, pSharedFont );
+
+    return new PdfFontMetricsFreetype( &m_ftLibrary, pszFilename );
+}
+
 PdfFont* PdfFontCache::CreateFontObject( TISortedFontList itSorted, TSortedFontList & rvecContainer, 
 					 PdfFontMetrics* pMetrics, bool bEmbedd, bool bBold, bool bItalic, 
-					 const char* pszFontName, const PdfEncoding * const pEncoding, bool bSubsetting ) 
+					 const char* pszFontName, const PdfEncoding * const pEncoding, bool bSubsetting,
+					 bool bCIDSubsetting ) 
 {
     PdfFont* pFont;
 
@@ -830,6 +856,9 @@ PdfFont* PdfFontCache::CreateFontObject( TISortedFontList itSorted, TSortedFontL
 		if ( bSubsetting )
 			nFlags |= ePdfFont_Subsetting;
 
+		if ( bCIDSubsetting )
+			nFlags |= ePdfFont_CIDSubsetting;
+
 		if( bEmbedd )
             nFlags |= ePdfFont_Embedded;
 
@@ -138,7 +138,8 @@ class PODOFO_DOC_API PdfFontCache {
     enum EFontCreationFlags {
         eFontCreationFlags_None = 0,				///< No special settings
         eFontCreationFlags_AutoSelectBase14 = 1,	///< Create automatically a base14 font if the fontname matches one of them
-        eFontCreationFlags_Type1Subsetting = 2		///< Create subsetted type1-font, which includes only used characters
+        eFontCreationFlags_Type1Subsetting = 2,		///< Create subsetted type1-font, which includes only used characters
+        eFontCreationFlags_CIDSubsetting = 4		///< Create CID fonts which write /W and ToUnicode only for the used characters
     };
 
     /** Create an empty font cache 
@@ -312,6 +313,15 @@ class PODOFO_DOC_API PdfFontCache {
      */
     std::string GetFontPath( const char* pszFontName, bool bBold, bool bItalic );
 
+    /** Create the metrics of a font file. The file is taken 
+     *  from PdfSharedFontCache if the shared cache is enabled.
+     *
+     *  \param pszFilename path of a font file
+     *
+     *  \returns a new metrics object owned by the caller
+     */
+    PdfFontMetrics* CreateFontMetrics( const char* pszFilename );
+
     /** Create a font and put it into the fontcache
      *
      *  \param itSorted iterator pointing to a location in vecContainer
@@ -324,13 +334,14 @@ class PODOFO_DOC_API PdfFontCache {
      *  \param pszFontName a font name for debug output
      *  \param pEncoding the encoding of the font. The font will not take ownership of this object.     
      *  \param bSubsetting if true the font will be subsetted in the pdf file
+     *  \param bCIDSubsetting if true a CID font writes /W and ToUnicode only for the used characters
      *
      *  \returns a font handle or NULL in case of error
      */
     PdfFont* CreateFontObject( TISortedFontList itSorted, TSortedFontList & vecContainer,
                                PdfFontMetrics* pMetrics, bool bEmbedd, bool bBold, 
                                bool bItalic, const char* pszFontName, const PdfEncoding * const pEncoding,
-							   bool bSubsetting = false );
+							   bool bSubsetting = false, bool bCIDSubsetting = false );
 
     /** Create a font subset.
      *  \param pMetrics a font metrics
@@ -48,10 +48,12 @@ PdfFont* PdfFontFactory::CreateFontObject( PdfFontMetrics* pMetrics, int nFlags,
     EPdfFontType eType  = pMetrics->GetFontType();
     bool         bEmbed = nFlags & ePdfFont_Embedded;
     bool         bSubsetting = (nFlags & ePdfFont_Subsetting) != 0;
+    bool         bCIDSubsetting = (nFlags & ePdfFont_CIDSubsetting) != 0;
 
     try
     { 
-        pFont = PdfFontFactory::CreateFontForType( eType, pMetrics, pEncoding, bEmbed, bSubsetting, pParent );
+        pFont = PdfFontFactory::CreateFontForType( eType, pMetrics, pEncoding, bEmbed, bSubsetting, 
+                                                     bCIDSubsetting, pParent );
         
         if( pFont ) 
         {
@@ -100,7 +102,8 @@ PdfFont* PdfFontFactory::CreateFontObject( PdfFontMetrics* pMetrics, int nFlags,
 
 PdfFont* PdfFontFactory::CreateFontForType( EPdfFontType eType, PdfFontMetrics* pMetrics, 
                                             const PdfEncoding* const pEncoding, 
-                                            bool bEmbed, bool bSubsetting, PdfVecObjects* pParent )
+                                            bool bEmbed, bool bSubsetting, bool bCIDSubsetting, 
+                                            PdfVecObjects* pParent )
 {
     PdfFont* pFont = NULL;
 
@@ -138,7 +141,7 @@ PdfFont* PdfFontFactory::CreateFontForType( EPdfFontType eType, PdfFontMetrics*
         {
             case ePdfFontType_TrueType:
                 // Peter Petrov 30 April 2008 - added bEmbed parameter
-                pFont = new PdfFontCID( pMetrics, pEncoding, pParent, bEmbed );
+                pFont = new PdfFontCID( pMetrics, pEncoding, pParent, bEmbed, bCIDSubsetting );
                 break;
             case ePdfFontType_Type1Pfa:
             case ePdfFontType_Type1Pfb:
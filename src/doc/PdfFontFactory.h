@@ -35,7 +35,8 @@ enum EPdfFontFlags {
     ePdfFont_Bold       = 0x02,
     ePdfFont_Italic     = 0x04,
     ePdfFont_BoldItalic = ePdfFont_Bold | ePdfFont_Italic,
-    ePdfFont_Subsetting = 0x08
+    ePdfFont_Subsetting = 0x08,
+    ePdfFont_CIDSubsetting = 0x10 ///< Write /W and ToUnicode of a CID font only for the used glyphs
 };
 
 /** This is a factory class which knows
@@ -86,7 +87,8 @@ class PODOFO_DOC_API PdfFontFactory {
      */
     static PdfFont* CreateFontForType( EPdfFontType eType, PdfFontMetrics* pMetrics, 
                                        const PdfEncoding* const pEncoding, 
-                                       bool bEmbed, bool bSubsetting, PdfVecObjects* pParent );
+                                       bool bEmbed, bool bSubsetting, bool bCIDSubsetting, 
+                                       PdfVecObjects* pParent );
 
 };
 
@@ -25,6 +25,8 @@
 
 #include "PdfFontFactoryBase14Data.h"
 
+#if defined(PODOFO_HAVE_FREETYPE)
+
 namespace PoDoFo {
 
 
@@ -259,3 +261,5 @@ pdf_long PdfFontMetricsBase14::GetFontDataLen() const
 }
 
 };
+
+#endif // PODOFO_HAVE_FREETYPE
@@ -222,7 +222,12 @@ public:
 
     inline double GetCapHeight() const;
 
-private:
+    /** Get the glyph id of a unicode character, which can be
+     *  passed to GetGlyphWidth( int ) to get the unscaled width.
+     *
+     *  \param lUnicode a unicode character
+     *  \returns the glyph id or 0 if the font has no glyph for the character
+     */
     long GetGlyphIdUnicode( long lUnicode ) const;
 
 private :
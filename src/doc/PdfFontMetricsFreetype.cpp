@@ -25,8 +25,10 @@
 #include "base/PdfArray.h"
 #include "base/PdfDictionary.h"
 #include "base/PdfVariant.h"
+#include "base/util/PdfMutexWrapper.h"
 
 #include "PdfFontFactory.h"
+#include "PdfSharedFontCache.h"
 
 #include <sstream>
 
@@ -50,7 +52,9 @@ PdfFontMetricsFreetype::PdfFontMetricsFreetype( FT_Library* pLibrary, const char
                       pszFilename, pszSubsetPrefix ),
       m_pLibrary( pLibrary ),
       m_pFace( NULL ),
-      m_bSymbol( false )
+      m_bSymbol( false ),
+      m_pSharedFont( NULL ),
+      m_pMutex( new Util::PdfMutex() )
 {
     FT_Error err = FT_New_Face( *pLibrary, pszFilename, 0, &m_pFace );
     if ( err )
@@ -58,6 +62,7 @@ PdfFontMetricsFreetype::PdfFontMetricsFreetype( FT_Library* pLibrary, const char
         // throw an exception
         PdfError::LogMessage( eLogSeverity_Critical, "FreeType returned the error %i when calling FT_New_Face for font %s.", 
                               err, pszFilename );
+        delete m_pMutex;
         PODOFO_RAISE_ERROR( ePdfError_FreeType );
     }
     
@@ -70,7 +75,9 @@ PdfFontMetricsFreetype::PdfFontMetricsFreetype( FT_Library* pLibrary,
     : PdfFontMetrics( ePdfFontType_Unknown, "", pszSubsetPrefix ),
       m_pLibrary( pLibrary ),
       m_pFace( NULL ),
-      m_bSymbol( false )
+      m_bSymbol( false ),
+      m_pSharedFont( NULL ),
+      m_pMutex( new Util::PdfMutex() )
 {
     m_bufFontData = PdfRefCountedBuffer( nBufLen ); // const_cast is ok, because we SetTakePossension to false!
     memcpy( m_bufFontData.GetBuffer(), pBuffer, nBufLen );
@@ -85,11 +92,49 @@ PdfFontMetricsFreetype::PdfFontMetricsFreetype( FT_Library* pLibrary,
       m_pLibrary( pLibrary ),
       m_pFace( NULL ),
       m_bSymbol( false ),
-      m_bufFontData( rBuffer )
+      m_bufFontData( rBuffer ),
+      m_pSharedFont( NULL ),
+      m_pMutex( new Util::PdfMutex() )
 {
     InitFromBuffer();
 }
 
+PdfFontMetricsFreetype::PdfFontMetricsFreetype( FT_Library* pLibrary, 
+                                                PdfSharedFont* pSharedFont,
+                                                const char* pszSubsetPrefix ) 
+    : PdfFontMetrics( PdfFontMetrics::FontTypeFromFilename( pSharedFont->GetFilename().c_str() ),
+                      pSharedFont->GetFilename().c_str(), pszSubsetPrefix ),
+      m_pLibrary( pLibrary ),
+      m_pFace( NULL ),
+      m_bSymbol( false ),
+      m_pSharedFont( pSharedFont ),
+      m_pMutex( new Util::PdfMutex() )
+{
+    try {
+        // The face reads directly from the shared memory
+        FT_Error err = FT_New_Memory_Face( *pLibrary, 
+                                           reinterpret_cast<const unsigned char*>(pSharedFont->GetData()), 
+                                           static_cast<long>(pSharedFont->GetDataLen()), 0, &m_pFace );
+        if( err )
+        {
+            PdfError::LogMessage( eLogSeverity_Critical, "FreeType returned the error %i when calling FT_New_Memory_Face for font %s.", 
+                                  err, pSharedFont->GetFilename().c_str() );
+            PODOFO_RAISE_ERROR( ePdfError_FreeType );
+        }
+
+        InitFromFace();
+    } catch( PdfError & e ) {
+        if( m_pFace )
+            FT_Done_Face( m_pFace );
+
+        PdfSharedFontCache::Release( m_pSharedFont );
+        delete m_pMutex;
+
+        e.AddToCallstack( __FILE__, __LINE__ );
+        throw e;
+    }
+}
+
 PdfFontMetricsFreetype::PdfFontMetricsFreetype( FT_Library* pLibrary, 
                                                 FT_Face face, 
                                                 const char* pszSubsetPrefix  )
@@ -101,7 +146,9 @@ PdfFontMetricsFreetype::PdfFontMetricsFreetype( FT_Library* pLibrary,
                       pszSubsetPrefix ),
       m_pLibrary( pLibrary ),
       m_pFace( face ),
-      m_bSymbol( false )
+      m_bSymbol( false ),
+      m_pSharedFont( NULL ),
+      m_pMutex( new Util::PdfMutex() )
 {
     // asume true type
     // m_eFontType = ePdfFontType_TrueType;
@@ -115,6 +162,11 @@ PdfFontMetricsFreetype::~PdfFontMetricsFreetype()
     {
         FT_Done_Face( m_pFace );
     }
+
+    // Release the shared font after the face, which uses its data
+    PdfSharedFontCache::Release( m_pSharedFont );
+
+    delete m_pMutex;
 }
 
 void PdfFontMetricsFreetype::InitFromBuffer() 
@@ -177,29 +229,36 @@ void PdfFontMetricsFreetype::InitFromFace()
     }
     
     // we cache the 256 first width entries as they 
-    // are most likely needed quite often
-    m_vecWidth.clear();
-    m_vecWidth.reserve( PODOFO_WIDTH_CACHE_SIZE );
-    for( unsigned int i=0;i<PODOFO_WIDTH_CACHE_SIZE;i++ )
+    // are most likely needed quite often.
+    // A shared font calculates them only once for all documents.
+    if( !m_pSharedFont || !m_pSharedFont->GetWidths( m_vecWidth ) )
     {
-        if( i < PODOFO_FIRST_READABLE || !m_pFace )
-            m_vecWidth.push_back( 0.0  );
-        else
+        m_vecWidth.clear();
+        m_vecWidth.reserve( PODOFO_WIDTH_CACHE_SIZE );
+        for( unsigned int i=0;i<PODOFO_WIDTH_CACHE_SIZE;i++ )
         {
-            int index = i;
-            // Handle symbol fonts
-            if( m_bSymbol ) 
+            if( i < PODOFO_FIRST_READABLE || !m_pFace )
+                m_vecWidth.push_back( 0.0  );
+            else
             {
-                index = index | 0xf000;
+                int index = i;
+                // Handle symbol fonts
+                if( m_bSymbol ) 
+                {
+                    index = index | 0xf000;
+                }
+
+                if( !FT_Load_Char( m_pFace, index, FT_LOAD_NO_SCALE | FT_LOAD_NO_BITMAP ) )  // | FT_LOAD_NO_RENDER
+                {
+                    //m_vecWidth.push_back( 0.0  );
+                    //continue;
+                }
+                m_vecWidth.push_back( static_cast<double>(m_pFace->glyph->metrics.horiAdvance) * 1000.0 / m_pFace->units_per_EM );
             }
-
-            if( !FT_Load_Char( m_pFace, index, FT_LOAD_NO_SCALE | FT_LOAD_NO_BITMAP ) )  // | FT_LOAD_NO_RENDER
-            {
-                //m_vecWidth.push_back( 0.0  );
-                //continue;
-            }
-            m_vecWidth.push_back( static_cast<double>(m_pFace->glyph->metrics.horiAdvance) * 1000.0 / m_pFace->units_per_EM );
         }
+
+        if( m_pSharedFont )
+            m_pSharedFont->SetWidths( m_vecWidth );
     }
 
     InitFontSizes();
@@ -252,6 +311,7 @@ void PdfFontMetricsFreetype::GetWidthArray( PdfVariant & var, unsigned int nFirs
         PODOFO_RAISE_ERROR( ePdfError_InvalidHandle );
     }
 
+    Util::PdfMutexWrapper wrapper( *m_pMutex );
     for( i=nFirst;i<=nLast;i++ )
     {
         if( i < PODOFO_WIDTH_CACHE_SIZE )
@@ -279,6 +339,7 @@ double PdfFontMetricsFreetype::GetGlyphWidth( int nGlyphId ) const
         PODOFO_RAISE_ERROR( ePdfError_InvalidHandle );
     }
 
+    Util::PdfMutexWrapper wrapper( *m_pMutex );
     if( !FT_Load_Glyph( m_pFace, nGlyphId, FT_LOAD_NO_SCALE | FT_LOAD_NO_BITMAP ) )  // | FT_LOAD_NO_RENDER
     {
         // zero return code is success!
@@ -290,6 +351,7 @@ double PdfFontMetricsFreetype::GetGlyphWidth( int nGlyphId ) const
 
 double PdfFontMetricsFreetype::GetGlyphWidth( const char* pszGlyphname ) const
 {
+    Util::PdfMutexWrapper wrapper( *m_pMutex );
 	return GetGlyphWidth( FT_Get_Name_Index( m_pFace, const_cast<char *>(pszGlyphname) ) );
 }
 
@@ -327,6 +389,7 @@ double PdfFontMetricsFreetype::UnicodeCharWidth( unsigned short c ) const
     }
     else
     {
+        Util::PdfMutexWrapper wrapper( *m_pMutex );
         ftErr = FT_Load_Char( m_pFace, static_cast<FT_UInt>(c), FT_LOAD_NO_SCALE | FT_LOAD_NO_BITMAP );
         if( ftErr )
             return dWidth;
@@ -347,6 +410,7 @@ long PdfFontMetricsFreetype::GetGlyphId( long lUnicode ) const
     {
         lUnicode = lUnicode | 0xf000;
     }
+    Util::PdfMutexWrapper wrapper( *m_pMutex );
     lGlyph = FT_Get_Char_Index( m_pFace, lUnicode );
 
     return lGlyph;
@@ -398,6 +462,9 @@ double PdfFontMetricsFreetype::GetStrikeoutThickness() const
 // -----------------------------------------------------
 const char* PdfFontMetricsFreetype::GetFontData() const
 {
+    if( m_pSharedFont )
+        return m_pSharedFont->GetData();
+
     return m_bufFontData.GetBuffer();
 }
 
@@ -406,6 +473,9 @@ const char* PdfFontMetricsFreetype::GetFontData() const
 // -----------------------------------------------------
 pdf_long PdfFontMetricsFreetype::GetFontDataLen() const
 {
+    if( m_pSharedFont )
+        return m_pSharedFont->GetDataLen();
+
     return m_bufFontData.GetSize();
 }  
 
@@ -24,12 +24,14 @@
 #include "podofo/base/PdfDefines.h"
 #include "podofo/base/Pdf3rdPtyForwardDecl.h"
 #include "podofo/base/PdfString.h"
+#include "podofo/base/util/PdfMutex.h"
 #include "PdfFontMetrics.h"
 
 namespace PoDoFo {
 
 class PdfArray;
 class PdfObject;
+class PdfSharedFont;
 class PdfVariant;
 
 class PODOFO_DOC_API PdfFontMetricsFreetype : public PdfFontMetrics {
@@ -59,6 +61,16 @@ class PODOFO_DOC_API PdfFontMetricsFreetype : public PdfFontMetrics {
     PdfFontMetricsFreetype( FT_Library* pLibrary, const PdfRefCountedBuffer & rBuffer,
 		    const char* pszSubsetPrefix = NULL);
 
+    /** Create a font metrics object for a font shared by several documents
+     *  \param pLibrary handle to an initialized FreeType2 library handle
+     *  \param pSharedFont a font returned by PdfSharedFontCache::Acquire. The metrics object
+     *                     takes over this reference and releases it when it is deleted
+     *                     or if the constructor throws an exception.
+     *  \param pszSubsetPrefix unique prefix for font subsets (see GetFontSubsetPrefix)
+     */
+    PdfFontMetricsFreetype( FT_Library* pLibrary, PdfSharedFont* pSharedFont,
+		    const char* pszSubsetPrefix = NULL);
+
     /** Create a font metrics object for a given freetype font.
      *  \param pLibrary handle to an initialized FreeType2 library handle
      *  \param face a valid freetype font face
@@ -268,6 +280,10 @@ class PODOFO_DOC_API PdfFontMetricsFreetype : public PdfFontMetrics {
 
     PdfRefCountedBuffer m_bufFontData;
     std::vector<double> m_vecWidth;
+
+    PdfSharedFont*      m_pSharedFont; ///< The font data if it is shared with other documents
+
+    Util::PdfMutex*     m_pMutex;      ///< FreeType does not allow using m_pFace on several threads at once
 };
 
 // -----------------------------------------------------
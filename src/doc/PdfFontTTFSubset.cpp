@@ -24,10 +24,12 @@
 
 #include "base/PdfInputDevice.h"
 #include "base/PdfOutputDevice.h"
+#include "base/util/PdfMutexWrapper.h"
 
 #include <cstring>
-#include <iostream>
 #include <algorithm>
+#include <map>
+#include <sstream>
 
 namespace PoDoFo {
 
@@ -63,9 +65,51 @@ inline short Big2Little(short big)
 //Get the number of bytes to pad the ul, because of 4-byte-alignment.
 unsigned int GetPadding(unsigned long ul);	
 
+static const char s_szPadding[__LENGTH_DWORD] = { 0, 0, 0, 0 };
+
+/** A subset in the process wide subset cache.
+ */
+struct TSubsetCacheEntry {
+    std::string   sFont;
+    unsigned long ulLastUse;
+};
+
+typedef std::map<std::string,TSubsetCacheEntry> TSubsetCache;
+
+/** Subsets built before by any document, which are shared
+ *  by all threads. All access is protected by s_cacheMutex.
+ */
+static TSubsetCache   s_subsetCache;
+static size_t         s_nCacheSize  = 0;
+static size_t         s_nCacheLimit = 8 * 1024 * 1024;
+static unsigned long  s_ulCacheUse  = 0;
+static Util::PdfMutex s_cacheMutex;
+
+/** Remove the least recently used subsets until all
+ *  subsets fit into the cache limit.
+ *  s_cacheMutex has to be locked.
+ */
+static void ShrinkSubsetCache()
+{
+    while( s_nCacheSize > s_nCacheLimit && !s_subsetCache.empty() )
+    {
+        TSubsetCache::iterator itOldest = s_subsetCache.begin();
+        TSubsetCache::iterator it       = s_subsetCache.begin();
+        for( ; it != s_subsetCache.end(); ++it )
+        {
+            if( (*it).second.ulLastUse < (*itOldest).second.ulLastUse )
+                itOldest = it;
+        }
+
+        s_nCacheSize -= (*itOldest).second.sFont.size();
+        s_subsetCache.erase( itOldest );
+    }
+}
+
 
 PdfFontTTFSubset::PdfFontTTFSubset( const char* pszFontFileName, PdfFontMetrics* pMetrics, unsigned short nFaceIndex )
-    : m_pMetrics( pMetrics ), m_faceIndex( nFaceIndex ), m_bOwnDevice( true )
+    : m_pMetrics( pMetrics ), m_faceIndex( nFaceIndex ), m_sFileName( pszFontFileName ), m_pDevice( NULL ),
+      m_pFontData( NULL ), m_lFontLen( 0 )
 {
     //File type is now distinguished by ext, which might cause problems.
     const char* pname = pszFontFileName;
@@ -88,7 +132,9 @@ PdfFontTTFSubset::PdfFontTTFSubset( const char* pszFontFileName, PdfFontMetrics*
         m_eFontFileType = eFontFileType_Unknown;
     }
 
-    m_pDevice = new PdfInputDevice( pszFontFileName );
+    std::ostringstream oss;
+    oss << pszFontFileName << '#' << nFaceIndex;
+    m_sCacheKey = oss.str();
 
     // For any fonts, assume that glyph 0 is needed.
     m_vGlyphIndice.push_back(0);	
@@ -96,7 +142,15 @@ PdfFontTTFSubset::PdfFontTTFSubset( const char* pszFontFileName, PdfFontMetrics*
 
 PdfFontTTFSubset::PdfFontTTFSubset( PdfInputDevice* pDevice, PdfFontMetrics* pMetrics, EFontFileType eType, unsigned short nFaceIndex )
     : m_pMetrics( pMetrics ), m_eFontFileType( eType ), m_faceIndex(nFaceIndex),
-      m_pDevice( pDevice ), m_bOwnDevice( false )
+      m_pDevice( pDevice ), m_pFontData( NULL ), m_lFontLen( 0 )
+{
+    // For any fonts, assume that glyph 0 is needed.
+    m_vGlyphIndice.push_back(0);	
+}
+
+PdfFontTTFSubset::PdfFontTTFSubset( const char* pBuffer, pdf_long lLen, PdfFontMetrics* pMetrics, EFontFileType eType, unsigned short nFaceIndex )
+    : m_pMetrics( pMetrics ), m_eFontFileType( eType ), m_faceIndex(nFaceIndex),
+      m_pDevice( NULL ), m_pFontData( pBuffer ), m_lFontLen( lLen )
 {
     // For any fonts, assume that glyph 0 is needed.
     m_vGlyphIndice.push_back(0);	
@@ -104,10 +158,61 @@ PdfFontTTFSubset::PdfFontTTFSubset( PdfInputDevice* pDevice, PdfFontMetrics* pMe
 
 PdfFontTTFSubset::~PdfFontTTFSubset()
 {
-    if( m_bOwnDevice ) {
-        delete m_pDevice;
-        m_pDevice = NULL;
+}
+
+void PdfFontTTFSubset::LoadFontData()
+{
+    const std::streamsize lChunk = 65536;
+    std::streamoff        lRead;
+
+    if( m_pFontData )
+        return;
+
+    PdfInputDevice* pDevice = m_pDevice;
+    PdfInputDevice* pFile   = NULL;
+    if( !pDevice && !m_sFileName.empty() )
+        pDevice = pFile = new PdfInputDevice( m_sFileName.c_str() );
+
+    if( !pDevice )
+    {
+        PODOFO_RAISE_ERROR( ePdfError_InvalidHandle );
     }
+
+    // Read the whole font at once, all tables are taken from memory
+    try {
+        do {
+            size_t nOldSize = m_vecFontData.size();
+            m_vecFontData.resize( nOldSize + lChunk );
+
+            lRead = pDevice->Read( &m_vecFontData[nOldSize], lChunk );
+            m_vecFontData.resize( nOldSize + static_cast<size_t>(lRead > 0 ? lRead : 0) );
+        } while( lRead == lChunk );
+    } catch( PdfError & e ) {
+        delete pFile;
+        e.AddToCallstack( __FILE__, __LINE__ );
+        throw e;
+    }
+
+    delete pFile;
+
+    m_pFontData = m_vecFontData.empty() ? NULL : &m_vecFontData[0];
+    m_lFontLen  = static_cast<pdf_long>(m_vecFontData.size());
+}
+
+void PdfFontTTFSubset::SetCacheLimit( size_t nBytes )
+{
+    Util::PdfMutexWrapper wrapper( s_cacheMutex );
+
+    s_nCacheLimit = nBytes;
+    ShrinkSubsetCache();
+}
+
+void PdfFontTTFSubset::ClearCache()
+{
+    Util::PdfMutexWrapper wrapper( s_cacheMutex );
+
+    s_subsetCache.clear();
+    s_nCacheSize = 0;
 }
 
 void PdfFontTTFSubset::AddGlyph( unsigned short nGlyphIndex )
@@ -152,8 +257,6 @@ void PdfFontTTFSubset::GetNumberOfGlyphs()
 
     GetData( ulMaxpOffset+__LENGTH_DWORD*1,&m_numGlyphs,__LENGTH_DWORD);
     m_numGlyphs = Big2Little(m_numGlyphs);
-
-    std::cout << "Number of Glyphs:	"<< m_numGlyphs << std::endl;
 }
 
 void PdfFontTTFSubset::InitTables()
@@ -236,6 +339,49 @@ void PdfFontTTFSubset::SeeIfLongLocaOrNot()
 
 void PdfFontTTFSubset::BuildFont( PdfOutputDevice* pOutputDevice )
 {
+    if( m_sCacheKey.empty() )
+    {
+        this->BuildFontData( pOutputDevice );
+        return;
+    }
+
+    // The subset depends only on the font and the requested glyphs
+    std::ostringstream oss;
+    oss << m_sCacheKey << '#';
+    oss.write( reinterpret_cast<const char*>(&m_vGlyphIndice[0]), m_vGlyphIndice.size() * sizeof(unsigned short) );
+
+    std::string sKey = oss.str();
+    {
+        Util::PdfMutexWrapper  wrapper( s_cacheMutex );
+        TSubsetCache::iterator it = s_subsetCache.find( sKey );
+        if( it != s_subsetCache.end() )
+        {
+            (*it).second.ulLastUse = ++s_ulCacheUse;
+            pOutputDevice->Write( (*it).second.sFont.data(), (*it).second.sFont.size() );
+            return;
+        }
+    }
+
+    PdfRefCountedBuffer buffer;
+    PdfOutputDevice     device( &buffer );
+    this->BuildFontData( &device );
+    pOutputDevice->Write( buffer.GetBuffer(), device.GetLength() );
+
+    Util::PdfMutexWrapper wrapper( s_cacheMutex );
+    if( device.GetLength() <= s_nCacheLimit && s_subsetCache.find( sKey ) == s_subsetCache.end() )
+    {
+        TSubsetCacheEntry & rEntry = s_subsetCache[sKey];
+        rEntry.sFont.assign( buffer.GetBuffer(), device.GetLength() );
+        rEntry.ulLastUse = ++s_ulCacheUse;
+
+        s_nCacheSize += rEntry.sFont.size();
+        ShrinkSubsetCache();
+    }
+}
+
+void PdfFontTTFSubset::BuildFontData( PdfOutputDevice* pOutputDevice )
+{
+    LoadFontData();
     Init();
 	
     // Not necessary as we do a sorted insert
@@ -281,14 +427,6 @@ void PdfFontTTFSubset::BuildFont( PdfOutputDevice* pOutputDevice )
 
     std::vector<TTrueTypeTable> vOldTable = m_vTable;	//vOldTable will be used later.
 
-    //Print the old table information:
-    for ( i = 0; i < m_numTables; i++)
-    {
-        std::cout << "OldTable:\t" << m_vTable[i].m_strTableName << std::endl;
-        std::cout << "\tOffSet:\t" << m_vTable[i].m_offset << std::endl;
-        std::cout << "\t\tLength:\t"<<m_vTable[i].m_length << std::endl;
-    }
-	
     //Change the offsets:
     m_vTable[0].m_offset = __LENGTH_HEADER12+__LENGTH_OFFSETTABLE16*m_numTables;
     for ( i = 1; i < m_numTables; i++)
@@ -297,14 +435,6 @@ void PdfFontTTFSubset::BuildFont( PdfOutputDevice* pOutputDevice )
         unsigned pad = GetPadding(m_vTable[i-1].m_length);
         m_vTable[i].m_offset += pad;
     }
-	
-    //Print the new table information:
-    for ( i = 0; i < m_numTables; i++)
-    {
-        std::cout << "NewTable:\t" << m_vTable[i].m_strTableName <<std::endl;
-        std::cout << "\tOffSet:\t" << m_vTable[i].m_offset <<std::endl;
-        std::cout << "\t\tLength:\t"<<m_vTable[i].m_length <<std::endl;
-    }
 
     //The glyph data:
     if (m_bIsLongLoca)
@@ -397,11 +527,8 @@ void PdfFontTTFSubset::BuildFont( PdfOutputDevice* pOutputDevice )
         m_vTable.back().m_length = ulNewGlyfTableLength;
 	
         //Writing the header:
-        unsigned char* buf = new unsigned char[3*__LENGTH_DWORD];
-        GetData( ulStartOfTTFOffsets,buf,3*__LENGTH_DWORD);
-        pOutputDevice->Write( reinterpret_cast<char*>(buf), 3*__LENGTH_DWORD );
-        delete[]  buf;
-        buf = new unsigned char[m_numTables*__LENGTH_DWORD*4];
+        pOutputDevice->Write( GetData( ulStartOfTTFOffsets,3*__LENGTH_DWORD), 3*__LENGTH_DWORD );
+        unsigned char* buf = new unsigned char[m_numTables*__LENGTH_DWORD*4];
 	
         for ( i = 0; i < m_numTables; i++)
         {
@@ -444,17 +571,7 @@ void PdfFontTTFSubset::BuildFont( PdfOutputDevice* pOutputDevice )
         {
             if (m_vTable[i].m_strTableName != "loca")
             {
-                //string str = m_vTable[i].m_strTableName;
-                //unsigned long length = m_vTable[i].m_length;
-                //unsigned long offset = m_vTable[i].m_offset;
-                //unsigned long x = m_vTable[i].m_length;
-                char *buf = new  char[m_vTable[i].m_length];
-                //unsigned long olength = vOldTable[i].m_length;
-                //unsigned long ooffset = vOldTable[i].m_offset;
-                GetData( vOldTable[i].m_offset,buf,vOldTable[i].m_length);
-                pOutputDevice->Write( reinterpret_cast<char*>(buf), vOldTable[i].m_length );
-                delete[] buf;
-                buf = 0;
+                pOutputDevice->Write( GetData( vOldTable[i].m_offset,vOldTable[i].m_length), vOldTable[i].m_length );
             }
             else
             {
@@ -503,19 +620,14 @@ void PdfFontTTFSubset::BuildFont( PdfOutputDevice* pOutputDevice )
             unsigned pad = GetPadding(m_vTable[i].m_length);
             if (pad != 0)
             {
-                buf = new unsigned char[pad];
-                pOutputDevice->Write( reinterpret_cast<char*>(buf), pad );
-                delete[] buf;
+                pOutputDevice->Write( s_szPadding, pad );
             }
 	    
         }
         //Writing the last table, glyf:
         for ( i = 0; i < static_cast<long>(vGD.size()); i++)
         {
-            buf = new unsigned char[vGD[i].glyphLength];
-            GetData( ulGlyfTableOffset+vGD[i].glyphOldAddress,buf,vGD[i].glyphLength);
-            pOutputDevice->Write( reinterpret_cast<char*>(buf), vGD[i].glyphLength );
-            delete[] buf;
+            pOutputDevice->Write( GetData( ulGlyfTableOffset+vGD[i].glyphOldAddress,vGD[i].glyphLength), vGD[i].glyphLength );
         }
     }
     else
@@ -584,11 +696,8 @@ void PdfFontTTFSubset::BuildFont( PdfOutputDevice* pOutputDevice )
         unsigned long usNewGlyfTableLength = vsGD.back().glyphNewAddressLong+vsGD.back().glyphLength;
         m_vTable.back().m_length = usNewGlyfTableLength;
         //Writing the header:
-        unsigned char* buf = new unsigned char[3*__LENGTH_DWORD];
-        GetData( ulStartOfTTFOffsets,buf,3*__LENGTH_DWORD);
-        pOutputDevice->Write( reinterpret_cast<char*>(buf), 3*__LENGTH_DWORD );
-        delete[]  buf;
-        buf = new unsigned char[m_numTables*__LENGTH_DWORD*4];
+        pOutputDevice->Write( GetData( ulStartOfTTFOffsets,3*__LENGTH_DWORD), 3*__LENGTH_DWORD );
+        unsigned char* buf = new unsigned char[m_numTables*__LENGTH_DWORD*4];
         for ( i = 0; i < m_numTables; i++)
         {
             //The table name:
@@ -629,16 +738,7 @@ void PdfFontTTFSubset::BuildFont( PdfOutputDevice* pOutputDevice )
         {
             if (m_vTable[i].m_strTableName != "loca")
             {
-                //string str = m_vTable[i].m_strTableName;
-                //unsigned long length = m_vTable[i].m_length;
-                //unsigned long offset = m_vTable[i].m_offset;
-                char *buf = new  char[m_vTable[i].m_length];
-                //unsigned long olength = vOldTable[i].m_length;
-                //unsigned long ooffset = vOldTable[i].m_offset;
-                GetData( vOldTable[i].m_offset,buf,vOldTable[i].m_length);
-                pOutputDevice->Write( reinterpret_cast<char*>(buf), vOldTable[i].m_length );
-                delete[] buf;
-                buf = 0;
+                pOutputDevice->Write( GetData( vOldTable[i].m_offset,vOldTable[i].m_length), vOldTable[i].m_length );
             }
             else
             {
@@ -689,27 +789,31 @@ void PdfFontTTFSubset::BuildFont( PdfOutputDevice* pOutputDevice )
             unsigned pad = GetPadding(m_vTable[i].m_length);
             if (pad != 0)
             {
-                buf = new unsigned char[pad];
-                pOutputDevice->Write( reinterpret_cast<char*>(buf), pad );
-                delete[] buf;
+                pOutputDevice->Write( s_szPadding, pad );
             }
 	    
         }
         //Writing the last table, glyf:
         for ( i = 0; i < static_cast<long>(vsGD.size()); i++)
         {
-            buf = new unsigned char[vsGD[i].glyphLength];
-            GetData( ulGlyfTableOffset+vsGD[i].glyphOldAddressLong,buf,vsGD[i].glyphLength);
-            pOutputDevice->Write( reinterpret_cast<char*>(buf), vsGD[i].glyphLength );
-            delete[] buf;
+            pOutputDevice->Write( GetData( ulGlyfTableOffset+vsGD[i].glyphOldAddressLong,vsGD[i].glyphLength), vsGD[i].glyphLength );
         }
     }
 }
 
 void PdfFontTTFSubset::GetData(unsigned long offset, void* address, unsigned long sz)
 {
-    m_pDevice->Seek( offset );
-    m_pDevice->Read( static_cast<char*>(address), sz );
+    memcpy( address, GetData( offset, sz ), sz );
+}
+
+const char* PdfFontTTFSubset::GetData(unsigned long offset, unsigned long sz)
+{
+    if( offset > static_cast<unsigned long>(m_lFontLen) || sz > static_cast<unsigned long>(m_lFontLen) - offset )
+    {
+        PODOFO_RAISE_ERROR_INFO( ePdfError_InvalidFontFile, "Tried to read data outside of the font." );
+    }
+
+    return m_pFontData + offset;
 }
 
 
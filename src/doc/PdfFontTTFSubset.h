@@ -68,6 +68,9 @@ class PODOFO_DOC_API PdfFontTTFSubset {
     /** Create a new PdfFontTTFSubset from an existing 
      *  TTF font file using an input device.
      *
+     *  The whole font is read from the device into memory at once
+     *  when the subset is built. The device has to exist until then.
+     *
      *  @param pDevice a PdfInputDevice
      *  @param pMetrics font metrics object for this font
      *  @param eType the type of the font
@@ -75,15 +78,58 @@ class PODOFO_DOC_API PdfFontTTFSubset {
      */
     PdfFontTTFSubset( PdfInputDevice* pDevice, PdfFontMetrics* pMetrics, EFontFileType eType, unsigned short nFaceIndex = 0 );
 
+    /** Create a new PdfFontTTFSubset from an existing 
+     *  TTF font in memory.
+     *
+     *  @param pBuffer the font data, which is not copied and has to
+     *                 exist as long as this object
+     *  @param lLen length of pBuffer in bytes
+     *  @param pMetrics font metrics object for this font
+     *  @param eType the type of the font
+     *  @param nFaceIndex index of the face inside of the font
+     */
+    PdfFontTTFSubset( const char* pBuffer, pdf_long lLen, PdfFontMetrics* pMetrics, EFontFileType eType, unsigned short nFaceIndex = 0 );
+
     ~PdfFontTTFSubset();
 
     /**
      * Actually generate the subsetted font
      *
+     * If a cache key is set, the subset is taken from the process wide
+     * subset cache, if the same glyphs of the same font were subsetted
+     * before by any document. Otherwise the new subset is added to the cache.
+     *
      * @param pOutputDevice write the font to this device
+     *
+     * @see SetCacheKey
      */
     void BuildFont( PdfOutputDevice* pOutputDevice ); 
 
+    /** Set the key which identifies the font in the subset cache.
+     *  Subsets are cached by this key and the glyphs of the subset,
+     *  the font itself is not read if the subset is found in the cache.
+     *
+     *  The constructor taking a file name uses the file name
+     *  and the face index as key, the other constructors set no key.
+     *
+     *  @param rsKey a key which is unique for the font data, 
+     *               e.g. its path. An empty key disables the cache.
+     */
+    inline void SetCacheKey( const std::string & rsKey );
+
+    /** Set the maximum size of the process wide subset cache.
+     *  The least recently used subsets are removed from the cache
+     *  if it grows larger.
+     *
+     *  @param nBytes maximum size of all cached subsets in bytes,
+     *                0 disables the cache. The default is 8 MB.
+     */
+    static void SetCacheLimit( size_t nBytes );
+
+    /** Remove all subsets from the process wide subset cache.
+     */
+    static void ClearCache();
+
     /** Add a new glyph index to the subset.
      *
      *  @param nGlyphIndex include this glyph in the final font
@@ -108,7 +154,7 @@ class PODOFO_DOC_API PdfFontTTFSubset {
  private:
     /** Hide default constructor
      */
-    PdfFontTTFSubset() : m_bOwnDevice( false ) {} 
+    PdfFontTTFSubset() : m_pDevice( NULL ), m_pFontData( NULL ), m_lFontLen( 0 ) {} 
 
     /** copy constructor, not implemented
      */
@@ -118,6 +164,15 @@ class PODOFO_DOC_API PdfFontTTFSubset {
     PdfFontTTFSubset& operator=(const PdfFontTTFSubset& rhs);
 
     void Init();
+
+    /** Read the whole font from the device or the file
+     *  into m_vecFontData, if it is not in memory yet.
+     */
+    void LoadFontData();
+
+    /** Generate the subsetted font without using the subset cache.
+     */
+    void BuildFontData( PdfOutputDevice* pOutputDevice );
     
     /** Get the offset of a specified table. 
      *  @param pszTableName name of the table
@@ -135,6 +190,12 @@ class PODOFO_DOC_API PdfFontTTFSubset {
      */
     void GetData(unsigned long offset, void* address, unsigned long sz);
 
+    /** Get a pointer to sz bytes from the offset'th bytes of the input file
+     *
+     *  Raises ePdfError_InvalidFontFile if the range is not part of the font.
+     */
+    const char* GetData(unsigned long offset, unsigned long sz);
+
 
     /** Information of TrueType tables.
      */
@@ -179,8 +240,13 @@ class PODOFO_DOC_API PdfFontTTFSubset {
 
     unsigned long   m_ulStartOfTTFOffsets;	///< Start address of the truetype offset tables, differs from ttf to ttc.
 
-    PdfInputDevice* m_pDevice;                  ///< Read data from this input device
-    const bool      m_bOwnDevice;               ///< If the input device is owned by this object
+    std::string       m_sFileName;              ///< Read the font from this file if it is not empty
+    PdfInputDevice*   m_pDevice;                ///< Read the font from this input device if it is not NULL
+    std::vector<char> m_vecFontData;            ///< The font, if it was read from a file or device
+    const char*       m_pFontData;              ///< The complete font in memory
+    pdf_long          m_lFontLen;               ///< Length of m_pFontData in bytes
+
+    std::string       m_sCacheKey;              ///< Identifies the font in the subset cache
 };
 
 // -----------------------------------------------------
@@ -191,6 +257,14 @@ inline size_t PdfFontTTFSubset::GetSize() const
     return m_vGlyphIndice.size();
 }
 
+// -----------------------------------------------------
+// 
+// -----------------------------------------------------
+inline void PdfFontTTFSubset::SetCacheKey( const std::string & rsKey )
+{
+    m_sCacheKey = rsKey;
+}
+
 // -----------------------------------------------------
 // 
 // -----------------------------------------------------
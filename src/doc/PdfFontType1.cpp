@@ -26,6 +26,7 @@
 #include "base/PdfDictionary.h"
 #include "base/PdfName.h"
 #include "base/PdfStream.h"
+#include "base/util/PdfMutexWrapper.h"
 
 #include "PdfDifferenceEncoding.h"
 
@@ -80,6 +81,7 @@ void PdfFontType1::AddUsedSubsettingGlyphs( const PdfString & sText, long lStrin
 		PODOFO_ASSERT( sText.IsUnicode() == false );
 		PODOFO_ASSERT( sText.IsHex() == false );
 		const unsigned char* strp = reinterpret_cast<const unsigned char *>(sText.GetString());	// must be unsigned for access to m_bUsed-array
+		Util::PdfMutexWrapper wrapper( *m_pMutex );
 		for ( int i = 0; i < lStringLen; i++ )
 		{
 			m_bUsed[strp[i] / 32] |= 1 << (strp[i] % 32 ); 
@@ -91,6 +93,7 @@ void PdfFontType1::AddUsedGlyphname( const char * sGlyphName )
 {
 	if ( m_bIsSubsetting )
     {
+		Util::PdfMutexWrapper wrapper( *m_pMutex );
 		m_sUsedGlyph.insert( sGlyphName ); 
     }
 }
@@ -0,0 +1,1419 @@
+/***************************************************************************
+ *   Copyright (C) 2007 by Dominik Seichter                                *
+ *   domseichter@web.de                                                    *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Library General Public License as       *
+ *   published by the Free Software Foundation; either version 2 of the    *
+ *   License, or (at your option) any later version.                       *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this program; if not, write to the                 *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#include "PdfFunctionEvaluator.h"
+
+#include "base/PdfDefinesPrivate.h"
+
+#include "base/PdfArray.h"
+#include "base/PdfDictionary.h"
+#include "base/PdfLocale.h"
+#include "base/PdfObject.h"
+#include "base/PdfOutputStream.h"
+#include "base/PdfStream.h"
+#include "base/PdfTokenizer.h"
+#include "base/PdfVecObjects.h"
+
+#include "PdfFunction.h"
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <stdlib.h>
+#include <string.h>
+
+namespace PoDoFo {
+
+/** Stitching functions referencing each other deeper than this are rejected,
+ *  which also protects against functions which contain themselves.
+ */
+#define PODOFO_FUNCTION_MAX_DEPTH 32
+
+/** The operand stack limit of PostScript calculator functions
+ *  as given in the PDF reference.
+ */
+#define PODOFO_FUNCTION_MAX_STACK 100
+
+/** The maximum number of samples (times outputs) of a sampled function.
+ */
+#define PODOFO_FUNCTION_MAX_SAMPLES 0x4000000
+
+// -----------------------------------------------------
+// Helpers for reading function dictionaries
+// -----------------------------------------------------
+
+static const PdfObject* ResolveObject( const PdfObject* pObject, PdfVecObjects* pOwner )
+{
+    if( pObject && pObject->IsReference() ) 
+    {
+        if( !pOwner ) 
+        {
+            PODOFO_RAISE_ERROR_INFO( ePdfError_InvalidHandle, "Object is a reference but does not have an owner!" );
+        }
+
+        pObject = pOwner->GetObject( pObject->GetReference() );
+        if( !pObject ) 
+        {
+            PODOFO_RAISE_ERROR( ePdfError_NoObject );
+        }
+    }
+
+    return pObject;
+}
+
+/** Read an array of numbers from the function dictionary.
+ *  \returns false if the key does not exist and bRequired is false
+ */
+static bool GetNumbers( const PdfObject* pFunction, const char* pszKey, std::vector<double> & rvecNumbers, bool bRequired )
+{
+    const PdfObject* pArray = pFunction->GetIndirectKey( PdfName( pszKey ) );
+    if( !pArray ) 
+    {
+        if( bRequired ) 
+        {
+            PODOFO_RAISE_ERROR_INFO( ePdfError_InvalidKey, pszKey );
+        }
+
+        return false;
+    }
+
+    if( !pArray->IsArray() ) 
+    {
+        PODOFO_RAISE_ERROR_INFO( ePdfError_InvalidDataType, pszKey );
+    }
+
+    const PdfArray & rArray = pArray->GetArray();
+    rvecNumbers.resize( rArray.GetSize() );
+    for( unsigned int i = 0; i < rArray.GetSize(); i++ ) 
+        rvecNumbers[i] = ResolveObject( &rArray[i], pFunction->GetOwner() )->GetReal();
+
+    return true;
+}
+
+inline static double ClipValue( double dValue, double dMin, double dMax )
+{
+    return dValue < dMin ? dMin : (dValue > dMax ? dMax : dValue);
+}
+
+/** Map dValue from the interval [dMin, dMax] linearly to [dNewMin, dNewMax]
+ */
+inline static double Interpolate( double dValue, double dMin, double dMax, double dNewMin, double dNewMax )
+{
+    if( dMax == dMin ) 
+        return dNewMin;
+
+    return dNewMin + (dValue - dMin) * (dNewMax - dNewMin) / (dMax - dMin);
+}
+
+// -----------------------------------------------------
+// PdfCompiledFunction
+// -----------------------------------------------------
+
+/** Base class of all compiled functions.
+ */
+class PdfCompiledFunction {
+public:
+    virtual ~PdfCompiledFunction() {}
+
+    /** Evaluate the function. Input values are not clipped yet.
+     */
+    virtual void Evaluate( const double* pdInput, double* pdOutput ) const = 0;
+
+    inline unsigned int GetInputCount() const { return m_nInputs; }
+    inline unsigned int GetOutputCount() const { return m_nOutputs; }
+
+    /** Compile a function object.
+     *  \param pFunction a function dictionary or stream or an array of functions
+     *  \param nDepth nesting depth of pFunction in stitching functions
+     */
+    static PdfCompiledFunction* Compile( const PdfObject* pFunction, int nDepth );
+
+protected:
+    PdfCompiledFunction()
+        : m_nInputs( 0 ), m_nOutputs( 0 )
+    {
+    }
+
+    /** Read Domain and Range and set the number of inputs and outputs.
+     */
+    void ReadDomainAndRange( const PdfObject* pFunction, bool bRangeRequired )
+    {
+        GetNumbers( pFunction, "Domain", m_vecDomain, true );
+        if( m_vecDomain.size() < 2 || m_vecDomain.size() % 2 ) 
+        {
+            PODOFO_RAISE_ERROR_INFO( ePdfError_InvalidDataType, "Invalid function domain" );
+        }
+
+        m_nInputs = static_cast<unsigned int>(m_vecDomain.size() / 2);
+
+        if( GetNumbers( pFunction, "Range", m_vecRange, bRangeRequired ) ) 
+        {
+            if( m_vecRange.size() < 2 || m_vecRange.size() % 2 ) 
+            {
+                PODOFO_RAISE_ERROR_INFO( ePdfError_InvalidDataType, "Invalid function range" );
+            }
+
+            m_nOutputs = static_cast<unsigned int>(m_vecRange.size() / 2);
+        }
+    }
+
+    inline double ClipInput( const double* pdInput, unsigned int i ) const
+    {
+        return ClipValue( pdInput[i], m_vecDomain[2*i], m_vecDomain[2*i+1] );
+    }
+
+    inline void ClipOutput( double* pdOutput ) const
+    {
+        if( m_vecRange.empty() ) 
+            return;
+
+        for( unsigned int i = 0; i < m_nOutputs; i++ ) 
+            pdOutput[i] = ClipValue( pdOutput[i], m_vecRange[2*i], m_vecRange[2*i+1] );
+    }
+
+protected:
+    unsigned int        m_nInputs;
+    unsigned int        m_nOutputs;
+
+    std::vector<double> m_vecDomain;
+    std::vector<double> m_vecRange;  ///< empty if the function has no range
+};
+
+// -----------------------------------------------------
+// Sampled functions (Type 0)
+// -----------------------------------------------------
+
+/** A sampled function. All samples are decoded into a table
+ *  when compiling, so that evaluating only has to interpolate.
+ *
+ *  Cubic spline interpolation (Order 3) is not supported,
+ *  multilinear interpolation is used for all functions.
+ */
+class PdfCompiledSampledFunction : public PdfCompiledFunction {
+public:
+    PdfCompiledSampledFunction( const PdfObject* pFunction )
+    {
+        ReadDomainAndRange( pFunction, true );
+
+        std::vector<double> vecSize;
+        GetNumbers( pFunction, "Size", vecSize, true );
+        if( vecSize.size() != m_nInputs ) 
+        {
+            PODOFO_RAISE_ERROR_INFO( ePdfError_InvalidDataType, "Size of sampled function does not match its domain" );
+        }
+
+        const PdfObject* pBits = pFunction->GetIndirectKey( PdfName("BitsPerSample") );
+        int nBits = pBits ? static_cast<int>(pBits->GetNumber()) : 0;
+        if( nBits != 1 && nBits != 2 && nBits != 4 && nBits != 8 && 
+            nBits != 12 && nBits != 16 && nBits != 24 && nBits != 32 ) 
+        {
+            PODOFO_RAISE_ERROR_INFO( ePdfError_InvalidDataType, "Invalid BitsPerSample in sampled function" );
+        }
+
+        if( !GetNumbers( pFunction, "Encode", m_vecEncode, false ) ) 
+        {
+            m_vecEncode.resize( 2 * m_nInputs );
+            for( unsigned int i = 0; i < m_nInputs; i++ ) 
+            {
+                m_vecEncode[2*i]   = 0.0;
+                m_vecEncode[2*i+1] = vecSize[i] - 1.0;
+            }
+        }
+
+        std::vector<double> vecDecode;
+        if( !GetNumbers( pFunction, "Decode", vecDecode, false ) ) 
+            vecDecode = m_vecRange;
+
+        if( m_vecEncode.size() < 2 * m_nInputs || vecDecode.size() < 2 * m_nOutputs ) 
+        {
+            PODOFO_RAISE_ERROR_INFO( ePdfError_InvalidDataType, "Invalid Encode or Decode array in sampled function" );
+        }
+
+        // The first input varies fastest in the sample table
+        size_t lSamples = m_nOutputs;
+        m_vecSize   .resize( m_nInputs );
+        m_vecStrides.resize( m_nInputs );
+        for( unsigned int i = 0; i < m_nInputs; i++ ) 
+        {
+            if( vecSize[i] < 1.0 || lSamples * vecSize[i] > PODOFO_FUNCTION_MAX_SAMPLES ) 
+            {
+                PODOFO_RAISE_ERROR_INFO( ePdfError_ValueOutOfRange, "Invalid Size of sampled function" );
+            }
+
+            m_vecSize[i]    = static_cast<unsigned int>(vecSize[i]);
+            m_vecStrides[i] = lSamples;
+            lSamples       *= m_vecSize[i];
+        }
+
+        const PdfStream* pStream = pFunction->GetStream();
+        if( !pStream ) 
+        {
+            PODOFO_RAISE_ERROR_INFO( ePdfError_InvalidStream, "Sampled function without samples" );
+        }
+
+        PdfRefCountedBuffer   buffer;
+        PdfBufferOutputStream stream( &buffer );
+        pStream->GetFilteredCopy( &stream );
+        stream.Close();
+
+        DecodeSamples( reinterpret_cast<const unsigned char*>(buffer.GetBuffer()), 
+                       static_cast<size_t>(stream.GetLength()), nBits, lSamples, vecDecode );
+    }
+
+    virtual void Evaluate( const double* pdInput, double* pdOutput ) const
+    {
+        // Inputs which fall between two samples, i.e. have to be interpolated
+        unsigned int anInterpolated[32];
+        double       adFraction[32];
+        unsigned int nInterpolated = 0;
+        size_t       lBase         = 0;
+
+        for( unsigned int i = 0; i < m_nInputs; i++ ) 
+        {
+            double dEncoded = Interpolate( ClipInput( pdInput, i ), m_vecDomain[2*i], m_vecDomain[2*i+1],
+                                           m_vecEncode[2*i], m_vecEncode[2*i+1] );
+            dEncoded = ClipValue( dEncoded, 0.0, static_cast<double>(m_vecSize[i] - 1) );
+
+            // ClipValue does not catch NaN
+            unsigned int nIndex = dEncoded >= 0.0 ? static_cast<unsigned int>(dEncoded) : 0;
+            if( nIndex + 1 < m_vecSize[i] && dEncoded > nIndex && nInterpolated < 32 ) 
+            {
+                anInterpolated[nInterpolated] = i;
+                adFraction    [nInterpolated] = dEncoded - nIndex;
+                ++nInterpolated;
+            }
+
+            lBase += nIndex * m_vecStrides[i];
+        }
+
+        const double* pdSamples = &m_vecSamples[lBase];
+        if( !nInterpolated ) 
+        {
+            memcpy( pdOutput, pdSamples, m_nOutputs * sizeof(double) );
+        }
+        else if( nInterpolated == 1 ) 
+        {
+            const double* pdNext = pdSamples + m_vecStrides[anInterpolated[0]];
+            for( unsigned int j = 0; j < m_nOutputs; j++ ) 
+                pdOutput[j] = pdSamples[j] + adFraction[0] * (pdNext[j] - pdSamples[j]);
+        }
+        else
+        {
+            // Multilinear interpolation between the 2^n surrounding samples
+            for( unsigned int j = 0; j < m_nOutputs; j++ ) 
+                pdOutput[j] = 0.0;
+
+            for( pdf_uint64 nCorner = 0; nCorner < (static_cast<pdf_uint64>(1) << nInterpolated); nCorner++ ) 
+            {
+                double dWeight = 1.0;
+                size_t lOffset = 0;
+                for( unsigned int k = 0; k < nInterpolated; k++ ) 
+                {
+                    if( nCorner & (static_cast<pdf_uint64>(1) << k) ) 
+                    {
+                        dWeight *= adFraction[k];
+                        lOffset += m_vecStrides[anInterpolated[k]];
+                    }
+                    else
+                        dWeight *= 1.0 - adFraction[k];
+                }
+
+                for( unsigned int j = 0; j < m_nOutputs; j++ ) 
+                    pdOutput[j] += dWeight * pdSamples[lOffset + j];
+            }
+        }
+
+        ClipOutput( pdOutput );
+    }
+
+private:
+    /** Decode lSamples samples of nBits bits each, using the Decode array.
+     *  Missing samples at the end of short streams are treated as zero.
+     */
+    void DecodeSamples( const unsigned char* pData, size_t lLen, int nBits, size_t lSamples, 
+                        const std::vector<double> & rvecDecode )
+    {
+        const double dMax = static_cast<double>((static_cast<pdf_uint64>(1) << nBits) - 1);
+
+        m_vecSamples.resize( lSamples );
+
+        pdf_uint64 nBuffer    = 0;
+        int        nAvailable = 0;
+        size_t     lPos       = 0;
+        for( size_t i = 0; i < lSamples; i++ ) 
+        {
+            while( nAvailable < nBits ) 
+            {
+                nBuffer     = (nBuffer << 8) | (lPos < lLen ? pData[lPos] : 0);
+                nAvailable += 8;
+                ++lPos;
+            }
+
+            nAvailable -= nBits;
+            pdf_uint64 nSample = (nBuffer >> nAvailable) & ((static_cast<pdf_uint64>(1) << nBits) - 1);
+
+            size_t j = i % m_nOutputs;
+            m_vecSamples[i] = Interpolate( static_cast<double>(nSample), 0.0, dMax, rvecDecode[2*j], rvecDecode[2*j+1] );
+        }
+    }
+
+private:
+    std::vector<unsigned int> m_vecSize;
+    std::vector<size_t>       m_vecStrides;  ///< distance in m_vecSamples between neighbouring samples of an input
+    std::vector<double>       m_vecEncode;
+    std::vector<double>       m_vecSamples;  ///< decoded samples, m_nOutputs for each sample point
+};
+
+// -----------------------------------------------------
+// Exponential interpolation functions (Type 2)
+// -----------------------------------------------------
+
+class PdfCompiledExponentialFunction : public PdfCompiledFunction {
+public:
+    PdfCompiledExponentialFunction( const PdfObject* pFunction )
+    {
+        ReadDomainAndRange( pFunction, false );
+        if( m_nInputs != 1 ) 
+        {
+            PODOFO_RAISE_ERROR_INFO( ePdfError_InvalidDataType, "Exponential function with more than one input" );
+        }
+
+        if( !GetNumbers( pFunction, "C0", m_vecC0, false ) ) 
+            m_vecC0.assign( 1, 0.0 );
+
+        std::vector<double> vecC1;
+        if( !GetNumbers( pFunction, "C1", vecC1, false ) ) 
+            vecC1.assign( 1, 1.0 );
+
+        if( m_vecC0.size() != vecC1.size() || (!m_vecRange.empty() && m_vecRange.size() != 2 * m_vecC0.size()) ) 
+        {
+            PODOFO_RAISE_ERROR_INFO( ePdfError_InvalidDataType, "C0, C1 and Range of exponential function do not match" );
+        }
+
+        m_nOutputs = static_cast<unsigned int>(m_vecC0.size());
+        m_vecDelta.resize( m_nOutputs );
+        for( unsigned int j = 0; j < m_nOutputs; j++ ) 
+            m_vecDelta[j] = vecC1[j] - m_vecC0[j];
+
+        const PdfObject* pExponent = pFunction->GetIndirectKey( PdfName("N") );
+        if( !pExponent ) 
+        {
+            PODOFO_RAISE_ERROR_INFO( ePdfError_InvalidKey, "N" );
+        }
+
+        m_dExponent = pExponent->GetReal();
+    }
+
+    virtual void Evaluate( const double* pdInput, double* pdOutput ) const
+    {
+        double dValue = ClipInput( pdInput, 0 );
+        if( m_dExponent != 1.0 ) 
+            dValue = pow( dValue, m_dExponent );
+
+        for( unsigned int j = 0; j < m_nOutputs; j++ ) 
+            pdOutput[j] = m_vecC0[j] + dValue * m_vecDelta[j];
+
+        ClipOutput( pdOutput );
+    }
+
+private:
+    std::vector<double> m_vecC0;
+    std::vector<double> m_vecDelta;  ///< C1 - C0
+    double              m_dExponent;
+};
+
+// -----------------------------------------------------
+// Stitching functions (Type 3)
+// -----------------------------------------------------
+
+class PdfCompiledStitchingFunction : public PdfCompiledFunction {
+public:
+    PdfCompiledStitchingFunction( const PdfObject* pFunction, int nDepth )
+    {
+        ReadDomainAndRange( pFunction, false );
+        if( m_nInputs != 1 ) 
+        {
+            PODOFO_RAISE_ERROR_INFO( ePdfError_InvalidDataType, "Stitching function with more than one input" );
+        }
+
+        const PdfObject* pFunctions = pFunction->GetIndirectKey( PdfName("Functions") );
+        if( !pFunctions || !pFunctions->IsArray() || pFunctions->GetArray().empty() ) 
+        {
+            PODOFO_RAISE_ERROR_INFO( ePdfError_InvalidKey, "Functions" );
+        }
+
+        GetNumbers( pFunction, "Bounds", m_vecBounds, true );
+        GetNumbers( pFunction, "Encode", m_vecEncode, true );
+
+        const PdfArray & rFunctions = pFunctions->GetArray();
+        if( m_vecBounds.size() + 1 != rFunctions.GetSize() || m_vecEncode.size() != 2 * rFunctions.GetSize() ) 
+        {
+            PODOFO_RAISE_ERROR_INFO( ePdfError_InvalidDataType, "Bounds and Encode of stitching function do not match its functions" );
+        }
+
+        try {
+            for( unsigned int i = 0; i < rFunctions.GetSize(); i++ ) 
+            {
+                const PdfObject* pSub = ResolveObject( &rFunctions[i], pFunction->GetOwner() );
+                m_vecFunctions.push_back( NULL );
+                m_vecFunctions.back() = PdfCompiledFunction::Compile( pSub, nDepth + 1 );
+
+                if( m_vecFunctions.back()->GetInputCount() != 1 ||
+                    (i && m_vecFunctions.back()->GetOutputCount() != m_vecFunctions.front()->GetOutputCount()) ) 
+                {
+                    PODOFO_RAISE_ERROR_INFO( ePdfError_InvalidDataType, "Functions of stitching function do not match" );
+                }
+            }
+        } catch( PdfError & ) {
+            DeleteFunctions();
+            throw;
+        }
+
+        if( m_vecRange.empty() ) 
+            m_nOutputs = m_vecFunctions.front()->GetOutputCount();
+        else if( m_nOutputs != m_vecFunctions.front()->GetOutputCount() ) 
+        {
+            DeleteFunctions();
+            PODOFO_RAISE_ERROR_INFO( ePdfError_InvalidDataType, "Range of stitching function does not match its functions" );
+        }
+    }
+
+    virtual ~PdfCompiledStitchingFunction()
+    {
+        DeleteFunctions();
+    }
+
+    virtual void Evaluate( const double* pdInput, double* pdOutput ) const
+    {
+        double dValue = ClipInput( pdInput, 0 );
+
+        // Subdomain i is [Bounds[i-1], Bounds[i]), the last one includes its upper end
+        size_t i = std::upper_bound( m_vecBounds.begin(), m_vecBounds.end(), dValue ) - m_vecBounds.begin();
+        double dMin = i ? m_vecBounds[i-1] : m_vecDomain[0];
+        double dMax = i < m_vecBounds.size() ? m_vecBounds[i] : m_vecDomain[1];
+
+        dValue = Interpolate( dValue, dMin, dMax, m_vecEncode[2*i], m_vecEncode[2*i+1] );
+        m_vecFunctions[i]->Evaluate( &dValue, pdOutput );
+
+        ClipOutput( pdOutput );
+    }
+
+private:
+    void DeleteFunctions()
+    {
+        for( size_t i = 0; i < m_vecFunctions.size(); i++ ) 
+            delete m_vecFunctions[i];
+
+        m_vecFunctions.clear();
+    }
+
+private:
+    std::vector<PdfCompiledFunction*> m_vecFunctions;
+    std::vector<double>               m_vecBounds;
+    std::vector<double>               m_vecEncode;
+};
+
+// -----------------------------------------------------
+// Arrays of functions with one output each
+// -----------------------------------------------------
+
+class PdfCompiledFunctionArray : public PdfCompiledFunction {
+public:
+    PdfCompiledFunctionArray( const PdfObject* pFunctions, int nDepth )
+    {
+        const PdfArray & rFunctions = pFunctions->GetArray();
+        if( rFunctions.empty() ) 
+        {
+            PODOFO_RAISE_ERROR_INFO( ePdfError_InvalidDataType, "Empty array of functions" );
+        }
+
+        try {
+            for( unsigned int i = 0; i < rFunctions.GetSize(); i++ ) 
+            {
+                const PdfObject* pSub = ResolveObject( &rFunctions[i], pFunctions->GetOwner() );
+                m_vecFunctions.push_back( NULL );
+                m_vecFunctions.back() = PdfCompiledFunction::Compile( pSub, nDepth + 1 );
+
+                if( m_vecFunctions.back()->GetInputCount() != m_vecFunctions.front()->GetInputCount() ||
+                    m_vecFunctions.back()->GetOutputCount() != 1 ) 
+                {
+                    PODOFO_RAISE_ERROR_INFO( ePdfError_InvalidDataType, "Functions in an array of functions must have one output" );
+                }
+            }
+        } catch( PdfError & ) {
+            for( size_t i = 0; i < m_vecFunctions.size(); i++ ) 
+                delete m_vecFunctions[i];
+            throw;
+        }
+
+        m_nInputs  = m_vecFunctions.front()->GetInputCount();
+        m_nOutputs = static_cast<unsigned int>(m_vecFunctions.size());
+    }
+
+    virtual ~PdfCompiledFunctionArray()
+    {
+        for( size_t i = 0; i < m_vecFunctions.size(); i++ ) 
+            delete m_vecFunctions[i];
+    }
+
+    virtual void Evaluate( const double* pdInput, double* pdOutput ) const
+    {
+        for( size_t i = 0; i < m_vecFunctions.size(); i++ ) 
+            m_vecFunctions[i]->Evaluate( pdInput, pdOutput + i );
+    }
+
+private:
+    std::vector<PdfCompiledFunction*> m_vecFunctions;
+};
+
+// -----------------------------------------------------
+// PostScript calculator functions (Type 4)
+// -----------------------------------------------------
+
+/** Opcodes of the bytecode PostScript calculator programs are compiled to.
+ */
+enum EPdfPsOp {
+    ePdfPsOp_Push,          ///< push the operand of the instruction
+    ePdfPsOp_Jump,          ///< continue at the jump target
+    ePdfPsOp_JumpIfFalse,   ///< pop a boolean and continue at the jump target if it is false
+
+    // Operators taking the value of the previous push instruction as second operand
+    ePdfPsOp_AddImmediate,
+    ePdfPsOp_SubImmediate,
+    ePdfPsOp_MulImmediate,
+    ePdfPsOp_DivImmediate,
+
+    // Arithmetic operators
+    ePdfPsOp_Abs, ePdfPsOp_Add, ePdfPsOp_Atan, ePdfPsOp_Ceiling, ePdfPsOp_Cos, ePdfPsOp_Cvi, ePdfPsOp_Cvr, 
+    ePdfPsOp_Div, ePdfPsOp_Exp, ePdfPsOp_Floor, ePdfPsOp_Idiv, ePdfPsOp_Ln, ePdfPsOp_Log, ePdfPsOp_Mod, 
+    ePdfPsOp_Mul, ePdfPsOp_Neg, ePdfPsOp_Round, ePdfPsOp_Sin, ePdfPsOp_Sqrt, ePdfPsOp_Sub, ePdfPsOp_Truncate,
+
+    // Relational, boolean and bitwise operators
+    ePdfPsOp_And, ePdfPsOp_Bitshift, ePdfPsOp_Eq, ePdfPsOp_False, ePdfPsOp_Ge, ePdfPsOp_Gt, ePdfPsOp_Le, 
+    ePdfPsOp_Lt, ePdfPsOp_Ne, ePdfPsOp_Not, ePdfPsOp_Or, ePdfPsOp_True, ePdfPsOp_Xor,
+
+    // Stack operators
+    ePdfPsOp_Copy, ePdfPsOp_Dup, ePdfPsOp_Exch, ePdfPsOp_Index, ePdfPsOp_Pop, ePdfPsOp_Roll
+};
+
+enum EPdfPsType {
+    ePdfPsType_Real,
+    ePdfPsType_Int,
+    ePdfPsType_Bool
+};
+
+/** A value on the stack of a PostScript calculator function.
+ *  Integers and booleans (0 or 1) are stored as double, too.
+ */
+struct TPdfPsValue {
+    double     dValue;
+    EPdfPsType eType;
+};
+
+struct TPdfPsInstruction {
+    EPdfPsOp    eOp;
+    TPdfPsValue operand;   ///< value for ePdfPsOp_Push and the immediate operators
+    size_t      lTarget;   ///< jump target for ePdfPsOp_Jump and ePdfPsOp_JumpIfFalse
+};
+
+struct TPdfPsOperator {
+    const char* pszName;
+    EPdfPsOp    eOp;
+};
+
+static const TPdfPsOperator s_psOperators[] = {
+    { "abs",      ePdfPsOp_Abs      }, { "add",      ePdfPsOp_Add      }, { "atan",     ePdfPsOp_Atan     },
+    { "ceiling",  ePdfPsOp_Ceiling  }, { "cos",      ePdfPsOp_Cos      }, { "cvi",      ePdfPsOp_Cvi      },
+    { "cvr",      ePdfPsOp_Cvr      }, { "div",      ePdfPsOp_Div      }, { "exp",      ePdfPsOp_Exp      },
+    { "floor",    ePdfPsOp_Floor    }, { "idiv",     ePdfPsOp_Idiv     }, { "ln",       ePdfPsOp_Ln       },
+    { "log",      ePdfPsOp_Log      }, { "mod",      ePdfPsOp_Mod      }, { "mul",      ePdfPsOp_Mul      },
+    { "neg",      ePdfPsOp_Neg      }, { "round",    ePdfPsOp_Round    }, { "sin",      ePdfPsOp_Sin      },
+    { "sqrt",     ePdfPsOp_Sqrt     }, { "sub",      ePdfPsOp_Sub      }, { "truncate", ePdfPsOp_Truncate },
+    { "and",      ePdfPsOp_And      }, { "bitshift", ePdfPsOp_Bitshift }, { "eq",       ePdfPsOp_Eq       },
+    { "false",    ePdfPsOp_False    }, { "ge",       ePdfPsOp_Ge       }, { "gt",       ePdfPsOp_Gt       },
+    { "le",       ePdfPsOp_Le       }, { "lt",       ePdfPsOp_Lt       }, { "ne",       ePdfPsOp_Ne       },
+    { "not",      ePdfPsOp_Not      }, { "or",       ePdfPsOp_Or       }, { "true",     ePdfPsOp_True     },
+    { "xor",      ePdfPsOp_Xor      }, { "copy",     ePdfPsOp_Copy     }, { "dup",      ePdfPsOp_Dup      },
+    { "exch",     ePdfPsOp_Exch     }, { "index",    ePdfPsOp_Index    }, { "pop",      ePdfPsOp_Pop      },
+    { "roll",     ePdfPsOp_Roll     }, 
+    { NULL,       ePdfPsOp_Push     }
+};
+
+#define PODOFO_PS_PI 3.14159265358979323846
+
+/** A PostScript calculator function. The program is compiled into 
+ *  bytecode for a stack machine once, "if" and "ifelse" become jumps.
+ *  Pushing a constant followed by add, sub, mul or div is combined
+ *  into one instruction, as this is very common in tint transforms.
+ */
+class PdfCompiledPostScriptFunction : public PdfCompiledFunction {
+public:
+    PdfCompiledPostScriptFunction( const PdfObject* pFunction )
+    {
+        ReadDomainAndRange( pFunction, true );
+
+        const PdfStream* pStream = pFunction->GetStream();
+        if( !pStream ) 
+        {
+            PODOFO_RAISE_ERROR_INFO( ePdfError_InvalidStream, "PostScript calculator function without program" );
+        }
+
+        PdfRefCountedBuffer   buffer;
+        PdfBufferOutputStream stream( &buffer );
+        pStream->GetFilteredCopy( &stream );
+        stream.Close();
+
+        std::vector<std::string> vecTokens;
+        Tokenize( buffer.GetBuffer(), static_cast<size_t>(stream.GetLength()), vecTokens );
+
+        size_t lPos = 0;
+        if( vecTokens.empty() || vecTokens[0] != "{" ) 
+        {
+            PODOFO_RAISE_ERROR_INFO( ePdfError_InvalidDataType, "PostScript calculator function does not start with {" );
+        }
+
+        CompileProcedure( vecTokens, lPos, m_vecCode, 0 );
+        if( lPos != vecTokens.size() ) 
+        {
+            PODOFO_RAISE_ERROR_INFO( ePdfError_InvalidDataType, "Unexpected data after PostScript calculator function" );
+        }
+    }
+
+    virtual void Evaluate( const double* pdInput, double* pdOutput ) const
+    {
+        // The first element is never used, so that a pointer to 
+        // the top of the stack is valid for an empty stack, too
+        TPdfPsValue  stack[PODOFO_FUNCTION_MAX_STACK + 1];
+        TPdfPsValue* pStack = stack + 1;
+        unsigned int nTop   = 0; // number of values on the stack
+
+        if( m_nInputs > PODOFO_FUNCTION_MAX_STACK ) 
+        {
+            PODOFO_RAISE_ERROR_INFO( ePdfError_ValueOutOfRange, "Stack overflow in PostScript calculator function" );
+        }
+
+        for( unsigned int i = 0; i < m_nInputs; i++ ) 
+        {
+            pStack[i].dValue = ClipInput( pdInput, i );
+            pStack[i].eType  = ePdfPsType_Real;
+        }
+        nTop = m_nInputs;
+
+        Execute( pStack, nTop );
+
+        if( nTop < m_nOutputs ) 
+        {
+            PODOFO_RAISE_ERROR_INFO( ePdfError_ValueOutOfRange, "Stack underflow in PostScript calculator function" );
+        }
+
+        const TPdfPsValue* pResult = pStack + nTop - m_nOutputs;
+        for( unsigned int j = 0; j < m_nOutputs; j++ ) 
+        {
+            if( pResult[j].eType == ePdfPsType_Bool ) 
+            {
+                PODOFO_RAISE_ERROR_INFO( ePdfError_InvalidDataType, "PostScript calculator function returned a boolean" );
+            }
+
+            pdOutput[j] = pResult[j].dValue;
+        }
+
+        ClipOutput( pdOutput );
+    }
+
+private:
+    static void Tokenize( const char* pszProgram, size_t lLen, std::vector<std::string> & rvecTokens )
+    {
+        size_t i = 0;
+        while( i < lLen ) 
+        {
+            char c = pszProgram[i];
+            if( PdfTokenizer::IsWhitespace( c ) ) 
+                ++i;
+            else if( c == '%' ) 
+            {
+                // Skip comments
+                while( i < lLen && pszProgram[i] != '\n' && pszProgram[i] != '\r' ) 
+                    ++i;
+            }
+            else if( c == '{' || c == '}' ) 
+            {
+                rvecTokens.push_back( std::string( 1, c ) );
+                ++i;
+            }
+            else
+            {
+                size_t lStart = i;
+                while( i < lLen && !PdfTokenizer::IsWhitespace( pszProgram[i] ) && 
+                       pszProgram[i] != '{' && pszProgram[i] != '}' && pszProgram[i] != '%' ) 
+                    ++i;
+
+                rvecTokens.push_back( std::string( pszProgram + lStart, i - lStart ) );
+            }
+        }
+    }
+
+    /** Parse a number token.
+     *  \returns false if the token is not a number
+     */
+    static bool ParseNumber( const std::string & rsToken, TPdfPsValue & rValue )
+    {
+        bool bInteger = true;
+        bool bDigits  = false;
+        for( size_t i = 0; i < rsToken.size(); i++ ) 
+        {
+            char c = rsToken[i];
+            if( c >= '0' && c <= '9' ) 
+                bDigits = true;
+            else if( c == '.' || c == 'e' || c == 'E' ) 
+                bInteger = false;
+            else if( (c != '-' && c != '+') ) 
+                return false;
+        }
+
+        if( !bDigits ) 
+            return false;
+
+        if( bInteger ) 
+        {
+            rValue.dValue = static_cast<double>(strtol( rsToken.c_str(), NULL, 10 ));
+            rValue.eType  = ePdfPsType_Int;
+            return true;
+        }
+
+        // strtod is locale dependent
+        std::istringstream iss( rsToken );
+        PdfLocaleImbue( iss );
+        if( !(iss >> rValue.dValue) ) 
+            return false;
+
+        rValue.eType = ePdfPsType_Real;
+        return true;
+    }
+
+    static void AddInstruction( std::vector<TPdfPsInstruction> & rvecCode, EPdfPsOp eOp, size_t lTarget = 0 )
+    {
+        TPdfPsInstruction instruction;
+        instruction.eOp            = eOp;
+        instruction.operand.dValue = 0.0;
+        instruction.operand.eType  = ePdfPsType_Real;
+        instruction.lTarget        = lTarget;
+        rvecCode.push_back( instruction );
+    }
+
+    /** Append the code of a procedure, moving its jump targets.
+     */
+    static void AppendCode( std::vector<TPdfPsInstruction> & rvecCode, const std::vector<TPdfPsInstruction> & rvecProc )
+    {
+        size_t lOffset = rvecCode.size();
+        rvecCode.insert( rvecCode.end(), rvecProc.begin(), rvecProc.end() );
+        for( size_t i = lOffset; i < rvecCode.size(); i++ ) 
+        {
+            if( rvecCode[i].eOp == ePdfPsOp_Jump || rvecCode[i].eOp == ePdfPsOp_JumpIfFalse ) 
+                rvecCode[i].lTarget += lOffset;
+        }
+    }
+
+    /** Compile the procedure starting with the "{" at rlPos.
+     *  Afterwards rlPos is behind the closing "}".
+     */
+    static void CompileProcedure( const std::vector<std::string> & rvecTokens, size_t & rlPos, 
+                                  std::vector<TPdfPsInstruction> & rvecCode, int nDepth )
+    {
+        if( nDepth > PODOFO_FUNCTION_MAX_DEPTH ) 
+        {
+            PODOFO_RAISE_ERROR_INFO( ePdfError_ValueOutOfRange, "PostScript calculator function nested too deeply" );
+        }
+
+        // Procedures which are operands of a following if or ifelse
+        std::vector<TPdfPsInstruction> vecProcs[2];
+        int                            nProcs = 0;
+        // No instruction before this position may be combined with the next one, 
+        // as the next one is a jump target
+        size_t                         lLabel = 0;
+
+        ++rlPos; // skip {
+        while( rlPos < rvecTokens.size() ) 
+        {
+            const std::string & rsToken = rvecTokens[rlPos];
+            if( rsToken == "}" ) 
+            {
+                if( nProcs ) 
+                {
+                    PODOFO_RAISE_ERROR_INFO( ePdfError_InvalidDataType, "Procedure without if or ifelse in PostScript calculator function" );
+                }
+
+                ++rlPos;
+                return;
+            }
+            else if( rsToken == "{" ) 
+            {
+                if( nProcs == 2 ) 
+                {
+                    PODOFO_RAISE_ERROR_INFO( ePdfError_InvalidDataType, "Procedure without if or ifelse in PostScript calculator function" );
+                }
+
+                vecProcs[nProcs].clear();
+                CompileProcedure( rvecTokens, rlPos, vecProcs[nProcs], nDepth + 1 );
+                ++nProcs;
+                continue;
+            }
+            else if( rsToken == "if" ) 
+            {
+                if( nProcs != 1 ) 
+                {
+                    PODOFO_RAISE_ERROR_INFO( ePdfError_InvalidDataType, "if without procedure in PostScript calculator function" );
+                }
+
+                AddInstruction( rvecCode, ePdfPsOp_JumpIfFalse, rvecCode.size() + 1 + vecProcs[0].size() );
+                AppendCode( rvecCode, vecProcs[0] );
+                lLabel = rvecCode.size();
+                nProcs = 0;
+            }
+            else if( rsToken == "ifelse" ) 
+            {
+                if( nProcs != 2 ) 
+                {
+                    PODOFO_RAISE_ERROR_INFO( ePdfError_InvalidDataType, "ifelse without two procedures in PostScript calculator function" );
+                }
+
+                AddInstruction( rvecCode, ePdfPsOp_JumpIfFalse, rvecCode.size() + 2 + vecProcs[0].size() );
+                AppendCode( rvecCode, vecProcs[0] );
+                AddInstruction( rvecCode, ePdfPsOp_Jump, rvecCode.size() + 1 + vecProcs[1].size() );
+                AppendCode( rvecCode, vecProcs[1] );
+                lLabel = rvecCode.size();
+                nProcs = 0;
+            }
+            else 
+            {
+                if( nProcs ) 
+                {
+                    PODOFO_RAISE_ERROR_INFO( ePdfError_InvalidDataType, "Procedure without if or ifelse in PostScript calculator function" );
+                }
+
+                TPdfPsValue value;
+                if( ParseNumber( rsToken, value ) ) 
+                {
+                    AddInstruction( rvecCode, ePdfPsOp_Push );
+                    rvecCode.back().operand = value;
+                }
+                else
+                {
+                    const TPdfPsOperator* pOperator = s_psOperators;
+                    while( pOperator->pszName && rsToken != pOperator->pszName ) 
+                        ++pOperator;
+
+                    if( !pOperator->pszName ) 
+                    {
+                        std::string sError = "Unknown operator in PostScript calculator function: " + rsToken;
+                        PODOFO_RAISE_ERROR_INFO( ePdfError_InvalidDataType, sError.c_str() );
+                    }
+
+                    EPdfPsOp eImmediate = ImmediateOperator( pOperator->eOp );
+                    if( eImmediate != ePdfPsOp_Push && rvecCode.size() > lLabel && rvecCode.back().eOp == ePdfPsOp_Push ) 
+                        rvecCode.back().eOp = eImmediate;
+                    else
+                        AddInstruction( rvecCode, pOperator->eOp );
+                }
+            }
+
+            ++rlPos;
+        }
+
+        PODOFO_RAISE_ERROR_INFO( ePdfError_InvalidDataType, "Missing } in PostScript calculator function" );
+    }
+
+    /** \returns the operator with immediate operand for eOp or ePdfPsOp_Push if there is none
+     */
+    static EPdfPsOp ImmediateOperator( EPdfPsOp eOp )
+    {
+        if( eOp == ePdfPsOp_Add ) 
+            return ePdfPsOp_AddImmediate;
+        else if( eOp == ePdfPsOp_Sub ) 
+            return ePdfPsOp_SubImmediate;
+        else if( eOp == ePdfPsOp_Mul ) 
+            return ePdfPsOp_MulImmediate;
+        else if( eOp == ePdfPsOp_Div ) 
+            return ePdfPsOp_DivImmediate;
+
+        return ePdfPsOp_Push;
+    }
+
+    static void StackUnderflow()
+    {
+        PODOFO_RAISE_ERROR_INFO( ePdfError_ValueOutOfRange, "Stack underflow in PostScript calculator function" );
+    }
+
+    static void StackOverflow()
+    {
+        PODOFO_RAISE_ERROR_INFO( ePdfError_ValueOutOfRange, "Stack overflow in PostScript calculator function" );
+    }
+
+    static void TypeCheck()
+    {
+        PODOFO_RAISE_ERROR_INFO( ePdfError_InvalidDataType, "Wrong operand type in PostScript calculator function" );
+    }
+
+    static void UndefinedResult()
+    {
+        PODOFO_RAISE_ERROR_INFO( ePdfError_ValueOutOfRange, "Undefined result in PostScript calculator function" );
+    }
+
+    static inline void SetResult( TPdfPsValue & rValue, double dValue, EPdfPsType eType )
+    {
+        rValue.dValue = dValue;
+        rValue.eType  = eType;
+    }
+
+    /** Apply an arithmetic operator which keeps integers integers to a and b
+     */
+    static inline void Arithmetic( EPdfPsOp eOp, TPdfPsValue & a, const TPdfPsValue & b )
+    {
+        if( a.eType == ePdfPsType_Bool || b.eType == ePdfPsType_Bool ) 
+            TypeCheck();
+
+        EPdfPsType eType = (a.eType == ePdfPsType_Int && b.eType == ePdfPsType_Int) ? ePdfPsType_Int : ePdfPsType_Real;
+        if( eOp == ePdfPsOp_Add ) 
+            SetResult( a, a.dValue + b.dValue, eType );
+        else if( eOp == ePdfPsOp_Sub ) 
+            SetResult( a, a.dValue - b.dValue, eType );
+        else if( eOp == ePdfPsOp_Mul ) 
+            SetResult( a, a.dValue * b.dValue, eType );
+        else // ePdfPsOp_Div
+        {
+            if( b.dValue == 0.0 ) 
+                UndefinedResult();
+            SetResult( a, a.dValue / b.dValue, ePdfPsType_Real ); 
+        }
+    }
+
+    static inline pdf_int64 ToInteger( const TPdfPsValue & rValue )
+    {
+        if( rValue.eType != ePdfPsType_Int ) 
+            TypeCheck();
+
+        return static_cast<pdf_int64>(rValue.dValue);
+    }
+
+    static inline double ToNumber( const TPdfPsValue & rValue )
+    {
+        if( rValue.eType == ePdfPsType_Bool ) 
+            TypeCheck();
+
+        return rValue.dValue;
+    }
+
+    void Execute( TPdfPsValue* pStack, unsigned int & rnTop ) const
+    {
+        const TPdfPsInstruction* pCode  = &m_vecCode[0];
+        const size_t             lCode  = m_vecCode.size();
+        unsigned int             nTop   = rnTop;
+
+// Make sure that at least x values are on the stack
+#define PODOFO_PS_NEED( x ) if( nTop < (x) ) StackUnderflow();
+// Make sure that at least x more values fit onto the stack
+#define PODOFO_PS_ROOM( x ) if( nTop + (x) > PODOFO_FUNCTION_MAX_STACK ) StackOverflow();
+
+        size_t lPc = 0;
+        while( lPc < lCode ) 
+        {
+            const TPdfPsInstruction & rInstr = pCode[lPc++];
+            TPdfPsValue* pTop = pStack + nTop - 1; // only valid if nTop > 0, but never out of bounds
+
+            switch( rInstr.eOp ) 
+            {
+                case ePdfPsOp_Push:
+                    PODOFO_PS_ROOM( 1 );
+                    pStack[nTop++] = rInstr.operand;
+                    break;
+                case ePdfPsOp_Jump:
+                    lPc = rInstr.lTarget;
+                    break;
+                case ePdfPsOp_JumpIfFalse:
+                    PODOFO_PS_NEED( 1 );
+                    if( pTop->eType != ePdfPsType_Bool ) 
+                        TypeCheck();
+                    if( pTop->dValue == 0.0 ) 
+                        lPc = rInstr.lTarget;
+                    --nTop;
+                    break;
+
+                case ePdfPsOp_AddImmediate:
+                    PODOFO_PS_NEED( 1 );
+                    Arithmetic( ePdfPsOp_Add, *pTop, rInstr.operand );
+                    break;
+                case ePdfPsOp_SubImmediate:
+                    PODOFO_PS_NEED( 1 );
+                    Arithmetic( ePdfPsOp_Sub, *pTop, rInstr.operand );
+                    break;
+                case ePdfPsOp_MulImmediate:
+                    PODOFO_PS_NEED( 1 );
+                    Arithmetic( ePdfPsOp_Mul, *pTop, rInstr.operand );
+                    break;
+                case ePdfPsOp_DivImmediate:
+                    PODOFO_PS_NEED( 1 );
+                    Arithmetic( ePdfPsOp_Div, *pTop, rInstr.operand );
+                    break;
+
+                case ePdfPsOp_Add:
+                case ePdfPsOp_Sub:
+                case ePdfPsOp_Mul:
+                case ePdfPsOp_Div:
+                    PODOFO_PS_NEED( 2 );
+                    Arithmetic( rInstr.eOp, pTop[-1], pTop[0] );
+                    --nTop;
+                    break;
+                case ePdfPsOp_Abs:
+                    PODOFO_PS_NEED( 1 );
+                    pTop->dValue = fabs( ToNumber( *pTop ) );
+                    break;
+                case ePdfPsOp_Neg:
+                    PODOFO_PS_NEED( 1 );
+                    pTop->dValue = -ToNumber( *pTop );
+                    break;
+                case ePdfPsOp_Ceiling:
+                    PODOFO_PS_NEED( 1 );
+                    pTop->dValue = ceil( ToNumber( *pTop ) );
+                    break;
+                case ePdfPsOp_Floor:
+                    PODOFO_PS_NEED( 1 );
+                    pTop->dValue = floor( ToNumber( *pTop ) );
+                    break;
+                case ePdfPsOp_Round:
+                    PODOFO_PS_NEED( 1 );
+                    pTop->dValue = floor( ToNumber( *pTop ) + 0.5 );
+                    break;
+                case ePdfPsOp_Truncate:
+                    PODOFO_PS_NEED( 1 );
+                    pTop->dValue = ToNumber( *pTop ) < 0.0 ? ceil( pTop->dValue ) : floor( pTop->dValue );
+                    break;
+                case ePdfPsOp_Cvi:
+                    PODOFO_PS_NEED( 1 );
+                    SetResult( *pTop, ToNumber( *pTop ) < 0.0 ? ceil( pTop->dValue ) : floor( pTop->dValue ), ePdfPsType_Int );
+                    break;
+                case ePdfPsOp_Cvr:
+                    PODOFO_PS_NEED( 1 );
+                    SetResult( *pTop, ToNumber( *pTop ), ePdfPsType_Real );
+                    break;
+                case ePdfPsOp_Sqrt:
+                    PODOFO_PS_NEED( 1 );
+                    if( ToNumber( *pTop ) < 0.0 ) 
+                        UndefinedResult();
+                    SetResult( *pTop, sqrt( pTop->dValue ), ePdfPsType_Real );
+                    break;
+                case ePdfPsOp_Sin:
+                    PODOFO_PS_NEED( 1 );
+                    SetResult( *pTop, sin( ToNumber( *pTop ) * PODOFO_PS_PI / 180.0 ), ePdfPsType_Real );
+                    break;
+                case ePdfPsOp_Cos:
+                    PODOFO_PS_NEED( 1 );
+                    SetResult( *pTop, cos( ToNumber( *pTop ) * PODOFO_PS_PI / 180.0 ), ePdfPsType_Real );
+                    break;
+                case ePdfPsOp_Ln:
+                case ePdfPsOp_Log:
+                    PODOFO_PS_NEED( 1 );
+                    if( ToNumber( *pTop ) <= 0.0 ) 
+                        UndefinedResult();
+                    SetResult( *pTop, rInstr.eOp == ePdfPsOp_Ln ? log( pTop->dValue ) : log10( pTop->dValue ), ePdfPsType_Real );
+                    break;
+                case ePdfPsOp_Atan:
+                {
+                    PODOFO_PS_NEED( 2 );
+                    double dNum = ToNumber( pTop[-1] );
+                    double dDen = ToNumber( pTop[0] );
+                    if( dNum == 0.0 && dDen == 0.0 ) 
+                        UndefinedResult();
+
+                    double dAngle = atan2( dNum, dDen ) * 180.0 / PODOFO_PS_PI;
+                    SetResult( pTop[-1], dAngle < 0.0 ? dAngle + 360.0 : dAngle, ePdfPsType_Real );
+                    --nTop;
+                    break;
+                }
+                case ePdfPsOp_Exp:
+                    PODOFO_PS_NEED( 2 );
+                    SetResult( pTop[-1], pow( ToNumber( pTop[-1] ), ToNumber( pTop[0] ) ), ePdfPsType_Real );
+                    --nTop;
+                    break;
+                case ePdfPsOp_Idiv:
+                case ePdfPsOp_Mod:
+                {
+                    PODOFO_PS_NEED( 2 );
+                    pdf_int64 a = ToInteger( pTop[-1] );
+                    pdf_int64 b = ToInteger( pTop[0] );
+                    if( !b ) 
+                        UndefinedResult();
+                    pTop[-1].dValue = static_cast<double>(rInstr.eOp == ePdfPsOp_Idiv ? a / b : a % b);
+                    --nTop;
+                    break;
+                }
+
+                case ePdfPsOp_And:
+                case ePdfPsOp_Or:
+                case ePdfPsOp_Xor:
+                {
+                    PODOFO_PS_NEED( 2 );
+                    TPdfPsValue & a = pTop[-1];
+                    const TPdfPsValue & b = pTop[0];
+                    if( a.eType != b.eType || a.eType == ePdfPsType_Real ) 
+                        TypeCheck();
+
+                    pdf_int64 nA = static_cast<pdf_int64>(a.dValue);
+                    pdf_int64 nB = static_cast<pdf_int64>(b.dValue);
+                    if( rInstr.eOp == ePdfPsOp_And ) 
+                        a.dValue = static_cast<double>(nA & nB);
+                    else if( rInstr.eOp == ePdfPsOp_Or ) 
+                        a.dValue = static_cast<double>(nA | nB);
+                    else
+                        a.dValue = static_cast<double>(nA ^ nB);
+                    --nTop;
+                    break;
+                }
+                case ePdfPsOp_Not:
+                    PODOFO_PS_NEED( 1 );
+                    if( pTop->eType == ePdfPsType_Bool ) 
+                        pTop->dValue = pTop->dValue == 0.0 ? 1.0 : 0.0;
+                    else
+                        pTop->dValue = static_cast<double>(~ToInteger( *pTop ));
+                    break;
+                case ePdfPsOp_Bitshift:
+                {
+                    PODOFO_PS_NEED( 2 );
+                    pdf_int64 nValue = ToInteger( pTop[-1] );
+                    pdf_int64 nShift = ToInteger( pTop[0] );
+                    // Integers of PostScript calculator functions have 32 bits
+                    pdf_uint32 nBits = static_cast<pdf_uint32>(nValue);
+                    if( nShift >= 32 || nShift <= -32 ) 
+                        nBits = 0;
+                    else if( nShift >= 0 ) 
+                        nBits <<= nShift;
+                    else
+                        nBits >>= -nShift;
+                    pTop[-1].dValue = static_cast<double>(static_cast<pdf_int32>(nBits));
+                    --nTop;
+                    break;
+                }
+                case ePdfPsOp_Eq:
+                case ePdfPsOp_Ne:
+                {
+                    PODOFO_PS_NEED( 2 );
+                    bool bSameKind = (pTop[-1].eType == ePdfPsType_Bool) == (pTop[0].eType == ePdfPsType_Bool);
+                    bool bEqual    = bSameKind && pTop[-1].dValue == pTop[0].dValue;
+                    SetResult( pTop[-1], (rInstr.eOp == ePdfPsOp_Eq) == bEqual ? 1.0 : 0.0, ePdfPsType_Bool );
+                    --nTop;
+                    break;
+                }
+                case ePdfPsOp_Ge:
+                case ePdfPsOp_Gt:
+                case ePdfPsOp_Le:
+                case ePdfPsOp_Lt:
+                {
+                    PODOFO_PS_NEED( 2 );
+                    double a = ToNumber( pTop[-1] );
+                    double b = ToNumber( pTop[0] );
+                    bool   bResult;
+                    if( rInstr.eOp == ePdfPsOp_Ge ) 
+                        bResult = a >= b;
+                    else if( rInstr.eOp == ePdfPsOp_Gt ) 
+                        bResult = a > b;
+                    else if( rInstr.eOp == ePdfPsOp_Le ) 
+                        bResult = a <= b;
+                    else
+                        bResult = a < b;
+                    SetResult( pTop[-1], bResult ? 1.0 : 0.0, ePdfPsType_Bool );
+                    --nTop;
+                    break;
+                }
+                case ePdfPsOp_True:
+                case ePdfPsOp_False:
+                    PODOFO_PS_ROOM( 1 );
+                    SetResult( pStack[nTop++], rInstr.eOp == ePdfPsOp_True ? 1.0 : 0.0, ePdfPsType_Bool );
+                    break;
+
+                case ePdfPsOp_Dup:
+                    PODOFO_PS_NEED( 1 );
+                    PODOFO_PS_ROOM( 1 );
+                    pStack[nTop] = *pTop;
+                    ++nTop;
+                    break;
+                case ePdfPsOp_Exch:
+                {
+                    PODOFO_PS_NEED( 2 );
+                    TPdfPsValue tmp = pTop[0];
+                    pTop[0]  = pTop[-1];
+                    pTop[-1] = tmp;
+                    break;
+                }
+                case ePdfPsOp_Pop:
+                    PODOFO_PS_NEED( 1 );
+                    --nTop;
+                    break;
+                case ePdfPsOp_Copy:
+                {
+                    PODOFO_PS_NEED( 1 );
+                    pdf_int64 n = ToInteger( *pTop );
+                    --nTop;
+                    if( n < 0 ) 
+                        UndefinedResult();
+                    PODOFO_PS_NEED( n );
+                    PODOFO_PS_ROOM( n );
+                    for( pdf_int64 i = 0; i < n; i++ ) 
+                        pStack[nTop + i] = pStack[nTop - n + i];
+                    nTop += static_cast<unsigned int>(n);
+                    break;
+                }
+                case ePdfPsOp_Index:
+                {
+                    PODOFO_PS_NEED( 1 );
+                    pdf_int64 n = ToInteger( *pTop );
+                    if( n < 0 ) 
+                        UndefinedResult();
+                    PODOFO_PS_NEED( n + 2 );
+                    *pTop = pStack[nTop - 2 - n];
+                    break;
+                }
+                case ePdfPsOp_Roll:
+                {
+                    PODOFO_PS_NEED( 2 );
+                    pdf_int64 n = ToInteger( pTop[-1] );
+                    pdf_int64 j = ToInteger( pTop[0] );
+                    nTop -= 2;
+                    if( n < 0 ) 
+                        UndefinedResult();
+                    PODOFO_PS_NEED( n );
+                    if( n > 1 ) 
+                    {
+                        // Rolling by j is rotating the top n values to the right by j
+                        j %= n;
+                        if( j < 0 ) 
+                            j += n;
+                        TPdfPsValue* pFirst = pStack + nTop - n;
+                        std::rotate( pFirst, pFirst + (n - j), pStack + nTop );
+                    }
+                    break;
+                }
+            }
+        }
+
+#undef PODOFO_PS_NEED
+#undef PODOFO_PS_ROOM
+
+        rnTop = nTop;
+    }
+
+private:
+    std::vector<TPdfPsInstruction> m_vecCode;
+};
+
+// -----------------------------------------------------
+// 
+// -----------------------------------------------------
+
+PdfCompiledFunction* PdfCompiledFunction::Compile( const PdfObject* pFunction, int nDepth )
+{
+    if( !pFunction ) 
+    {
+        PODOFO_RAISE_ERROR( ePdfError_InvalidHandle );
+    }
+
+    if( nDepth > PODOFO_FUNCTION_MAX_DEPTH ) 
+    {
+        PODOFO_RAISE_ERROR_INFO( ePdfError_ValueOutOfRange, "Functions are nested too deeply" );
+    }
+
+    if( pFunction->IsArray() ) 
+        return new PdfCompiledFunctionArray( pFunction, nDepth );
+
+    if( !pFunction->IsDictionary() ) 
+    {
+        PODOFO_RAISE_ERROR_INFO( ePdfError_InvalidDataType, "A function has to be a dictionary or stream" );
+    }
+
+    const PdfObject* pType = pFunction->GetIndirectKey( PdfName("FunctionType") );
+    if( !pType || !pType->IsNumber() ) 
+    {
+        PODOFO_RAISE_ERROR_INFO( ePdfError_InvalidKey, "FunctionType" );
+    }
+
+    switch( pType->GetNumber() ) 
+    {
+        case ePdfFunctionType_Sampled:
+            return new PdfCompiledSampledFunction( pFunction );
+        case ePdfFunctionType_Exponential:
+            return new PdfCompiledExponentialFunction( pFunction );
+        case ePdfFunctionType_Stitching:
+            return new PdfCompiledStitchingFunction( pFunction, nDepth );
+        case ePdfFunctionType_PostScript:
+            return new PdfCompiledPostScriptFunction( pFunction );
+        default:
+            PODOFO_RAISE_ERROR_INFO( ePdfError_InvalidEnumValue, "Unknown FunctionType" );
+    }
+
+    return NULL;
+}
+
+// -----------------------------------------------------
+// PdfFunctionEvaluator
+// -----------------------------------------------------
+
+PdfFunctionEvaluator::PdfFunctionEvaluator( const PdfObject* pFunction )
+    : m_pFunction( PdfCompiledFunction::Compile( pFunction, 0 ) )
+{
+    m_nInputs  = m_pFunction->GetInputCount();
+    m_nOutputs = m_pFunction->GetOutputCount();
+}
+
+PdfFunctionEvaluator::PdfFunctionEvaluator( const PdfFunction & rFunction )
+    : m_pFunction( PdfCompiledFunction::Compile( rFunction.GetObject(), 0 ) )
+{
+    m_nInputs  = m_pFunction->GetInputCount();
+    m_nOutputs = m_pFunction->GetOutputCount();
+}
+
+PdfFunctionEvaluator::~PdfFunctionEvaluator()
+{
+    delete m_pFunction;
+}
+
+void PdfFunctionEvaluator::Evaluate( const double* pdInput, double* pdOutput ) const
+{
+    m_pFunction->Evaluate( pdInput, pdOutput );
+}
+
+void PdfFunctionEvaluator::Evaluate( const double* pdInputs, double* pdOutputs, size_t nCount ) const
+{
+    const size_t lInputSize = m_nInputs * sizeof(double);
+
+    for( size_t i = 0; i < nCount; i++ ) 
+    {
+        // Colors and image samples often repeat, so 
+        // reuse the result of the previous input
+        if( i && memcmp( pdInputs, pdInputs - m_nInputs, lInputSize ) == 0 ) 
+            memcpy( pdOutputs, pdOutputs - m_nOutputs, m_nOutputs * sizeof(double) );
+        else
+            m_pFunction->Evaluate( pdInputs, pdOutputs );
+
+        pdInputs  += m_nInputs;
+        pdOutputs += m_nOutputs;
+    }
+}
+
+};
@@ -0,0 +1,141 @@
+/***************************************************************************
+ *   Copyright (C) 2007 by Dominik Seichter                                *
+ *   domseichter@web.de                                                    *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Library General Public License as       *
+ *   published by the Free Software Foundation; either version 2 of the    *
+ *   License, or (at your option) any later version.                       *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this program; if not, write to the                 *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#ifndef _PDF_FUNCTION_EVALUATOR_H_
+#define _PDF_FUNCTION_EVALUATOR_H_
+
+#include "podofo/base/PdfDefines.h"
+
+namespace PoDoFo {
+
+class PdfCompiledFunction;
+class PdfFunction;
+class PdfObject;
+
+/** 
+ * This class evaluates PDF functions, e.g. the tint transform
+ * of a Separation or DeviceN colorspace or the function of a shading.
+ *
+ * Sampled (Type 0), exponential (Type 2), stitching (Type 3) and 
+ * PostScript calculator (Type 4) functions are supported. An array 
+ * of functions with one output each, as allowed for shadings, is
+ * evaluated as one function with all outputs.
+ *
+ * The function is read from the PDF object and compiled once when 
+ * the evaluator is created: The samples of a sampled function are 
+ * decoded into a table and PostScript calculator programs are compiled
+ * into bytecode for a small stack machine. Evaluating the function
+ * does not allocate any memory, so that an evaluator can be used
+ * for converting large numbers of colors or image samples.
+ *
+ * An evaluator can be used from several threads at once, 
+ * as evaluating does not change it.
+ *
+ * \see PdfFunction
+ */
+class PODOFO_DOC_API PdfFunctionEvaluator {
+public:
+    /** Create an evaluator for a function object.
+     *
+     *  \param pFunction a function dictionary or stream or an array of
+     *                   functions with one output each. References to other
+     *                   objects are resolved using the owner of pFunction.
+     *
+     *  \throws PdfError if the function is invalid or of an unknown type
+     */
+    PdfFunctionEvaluator( const PdfObject* pFunction );
+
+    /** Create an evaluator for a function object.
+     *
+     *  \param rFunction the function to evaluate
+     *
+     *  \throws PdfError if the function is invalid or of an unknown type
+     */
+    PdfFunctionEvaluator( const PdfFunction & rFunction );
+
+    ~PdfFunctionEvaluator();
+
+    /** 
+     *  \returns the number of input values of the function
+     */
+    inline unsigned int GetInputCount() const;
+
+    /** 
+     *  \returns the number of output values of the function
+     */
+    inline unsigned int GetOutputCount() const;
+
+    /** Evaluate the function for one set of input values.
+     *
+     *  Input values are clipped to the domain and output values
+     *  to the range of the function.
+     *
+     *  \param pdInput GetInputCount() input values
+     *  \param pdOutput GetOutputCount() output values are written here
+     *
+     *  \throws PdfError if a PostScript calculator program fails,
+     *          e.g. because of a stack underflow
+     */
+    void Evaluate( const double* pdInput, double* pdOutput ) const;
+
+    /** Evaluate the function for many sets of input values at once.
+     *
+     *  This is faster than calling Evaluate() for each set of input
+     *  values, e.g. runs of equal input values are only evaluated once.
+     *
+     *  \param pdInputs nCount * GetInputCount() input values,
+     *                  the values of one set following each other
+     *  \param pdOutputs nCount * GetOutputCount() output values are written here
+     *  \param nCount the number of sets of input values
+     *
+     *  \see Evaluate
+     */
+    void Evaluate( const double* pdInputs, double* pdOutputs, size_t nCount ) const;
+
+private:
+    PdfFunctionEvaluator( const PdfFunctionEvaluator & rhs );
+    const PdfFunctionEvaluator & operator=( const PdfFunctionEvaluator & rhs );
+
+private:
+    PdfCompiledFunction* m_pFunction;
+
+    unsigned int         m_nInputs;
+    unsigned int         m_nOutputs;
+};
+
+// -----------------------------------------------------
+// 
+// -----------------------------------------------------
+unsigned int PdfFunctionEvaluator::GetInputCount() const
+{
+    return m_nInputs;
+}
+
+// -----------------------------------------------------
+// 
+// -----------------------------------------------------
+unsigned int PdfFunctionEvaluator::GetOutputCount() const
+{
+    return m_nOutputs;
+}
+
+};
+
+#endif // _PDF_FUNCTION_EVALUATOR_H_
@@ -90,37 +90,52 @@ PdfString PdfIdentityEncoding::ConvertToUnicode( const PdfString & rEncodedStrin
 }
 
 PdfRefCountedBuffer PdfIdentityEncoding::ConvertToEncoding( const PdfString & rString, const PdfFont* pFont ) const
+{
+    // Two bytes are written for every character
+    pdf_long lLen = (rString.IsUnicode() ? rString.GetCharacterLength() : rString.GetLength()) * 2;
+    if( !lLen )
+        return PdfRefCountedBuffer();
+
+    PdfRefCountedBuffer buffer( lLen );
+    lLen = this->ConvertToEncodingBuffer( rString, pFont, buffer.GetBuffer(), lLen );
+    buffer.Resize( lLen );
+
+    return buffer;
+}
+
+pdf_long PdfIdentityEncoding::ConvertToEncodingBuffer( const PdfString & rString, const PdfFont* pFont, 
+                                                       char* pBuffer, pdf_long lBufferLen ) const
 {
     if( !pFont ) 
     {
         PODOFO_RAISE_ERROR( ePdfError_InvalidHandle );
     }
 
-    // Get the string in UTF-16be format
-    PdfString          sStr = rString.ToUnicode();
-    const pdf_utf16be* pStr = sStr.GetUnicode();
+    // Only strings in other encodings have to be converted to unicode first
+    PdfString          sUnicode;
+    const pdf_utf16be* pTable;
+    const PdfString &  rSrc    = (GetStringUnicodeTable( rString, &pTable ) ? rString : (sUnicode = rString.ToUnicode()));
+    pdf_long           lLen    = rSrc.GetCharacterLength();
+    pdf_long           lNewLen = 0L;
     long               lGlyphId;
 
-    std::ostringstream out;
-    PdfLocaleImbue(out);
-
-    while( *pStr ) 
+    for( pdf_long i=0;i<lLen;i++ ) 
     {
-#ifdef PODOFO_IS_LITTLE_ENDIAN
-        lGlyphId = pFont->GetFontMetrics()->GetGlyphId( (((*pStr & 0xff) << 8) | ((*pStr & 0xff00) >> 8)) );
-#else
-        lGlyphId = pFont->GetFontMetrics()->GetGlyphId( *pStr );
-#endif // PODOFO_IS_LITTLE_ENDIAN
-
-        out << static_cast<unsigned char>((lGlyphId & 0xff00) >> 8);
-        out << static_cast<unsigned char>(lGlyphId & 0x00ff);
-
-        ++pStr;
+        const pdf_utf16be val = GetUnicodeCharAt( rSrc, pTable, i );
+        if( !val )
+            break;
+
+        lGlyphId = pFont->GetFontMetrics()->GetGlyphId( val );
+        if( lNewLen + 2 <= lBufferLen )
+        {
+            pBuffer[lNewLen]     = static_cast<char>((lGlyphId & 0xff00) >> 8);
+            pBuffer[lNewLen + 1] = static_cast<char>(lGlyphId & 0x00ff);
+        }
+
+        lNewLen += 2;
     }
 
-    PdfRefCountedBuffer buffer( out.str().length() );
-    memcpy( buffer.GetBuffer(), out.str().c_str(), out.str().length() );
-    return buffer;
+    return lNewLen;
 }
 
 pdf_utf16be PdfIdentityEncoding::GetUnicodeValue( long ) const
@@ -72,6 +72,14 @@ class PODOFO_DOC_API PdfIdentityEncoding : public PdfEncoding {
      */
     virtual PdfRefCountedBuffer ConvertToEncoding( const PdfString & rString, const PdfFont* pFont ) const;
 
+    /** Convert a unicode PdfString to a string encoded with this encoding
+     *  and write the result to a buffer supplied by the caller.
+     *
+     *  \see PdfEncoding::ConvertToEncodingBuffer
+     */
+    virtual pdf_long ConvertToEncodingBuffer( const PdfString & rString, const PdfFont* pFont, 
+                                              char* pBuffer, pdf_long lBufferLen ) const;
+
     /** 
      * PdfIdentityEncoding is usually delete along with the font.
      *
@@ -25,18 +25,25 @@
 #include <algorithm>
 #include <deque>
 #include <iostream>
+#include <memory>
+#include <sstream>
 
 #include "PdfMemDocument.h"
 
 #include "base/PdfDefinesPrivate.h"
 
 #include "base/PdfArray.h"
+#include "base/PdfBufferedOutputDevice.h"
 #include "base/PdfDictionary.h"
+#include "base/PdfEncrypt.h"
+#include "base/PdfFilter.h"
 #include "base/PdfImmediateWriter.h"
 #include "base/PdfObject.h"
 #include "base/PdfParserObject.h"
 #include "base/PdfStream.h"
 #include "base/PdfVecObjects.h"
+#include "base/util/PdfMutexWrapper.h"
+#include "base/util/PdfThreads.h"
 
 #include "PdfAcroForm.h"
 #include "PdfDestination.h"
@@ -54,7 +61,7 @@ using namespace std;
 namespace PoDoFo {
 
 PdfMemDocument::PdfMemDocument()
-    : PdfDocument(), m_pEncrypt( NULL ), m_pParser( NULL )
+    : PdfDocument(), m_pEncrypt( NULL ), m_pParser( NULL ), m_bFreeObjectMemoryOnWrite( false )
 {
     m_eVersion    = ePdfVersion_Default;
     m_eWriteMode  = ePdfWriteMode_Default;
@@ -62,7 +69,7 @@ PdfMemDocument::PdfMemDocument()
 }
 
 PdfMemDocument::PdfMemDocument( const char* pszFilename )
-    : PdfDocument(), m_pEncrypt( NULL ), m_pParser( NULL )
+    : PdfDocument(), m_pEncrypt( NULL ), m_pParser( NULL ), m_bFreeObjectMemoryOnWrite( false )
 {
     this->Load( pszFilename );
 }
@@ -71,7 +78,7 @@ PdfMemDocument::PdfMemDocument( const char* pszFilename )
 #if defined(_MSC_VER)  &&  _MSC_VER <= 1200			// nicht fr Visualstudio 6
 #else
 PdfMemDocument::PdfMemDocument( const wchar_t* pszFilename )
-    : PdfDocument(), m_pEncrypt( NULL ), m_pParser( NULL )
+    : PdfDocument(), m_pEncrypt( NULL ), m_pParser( NULL ), m_bFreeObjectMemoryOnWrite( false )
 {
     this->Load( pszFilename );
 }
@@ -252,9 +259,11 @@ void PdfMemDocument::Write( const char* pszFilename )
 	// makes sure pending subset-fonts are embedded
 	m_fontCache.EmbedSubsetFonts();
 
-    PdfOutputDevice device( pszFilename );
+    PdfBufferedOutputDevice device( pszFilename );
 
     this->Write( &device );
+    // Flush explicitly, so that write errors are not lost in the destructor
+    device.Flush();
 }
 
 #ifdef _WIN32
@@ -270,9 +279,11 @@ void PdfMemDocument::Write( const wchar_t* pszFilename )
      *  as we truncated the file already to zero length by opening
      *  it writeable.
      */
-    PdfOutputDevice device( pszFilename );
+    PdfBufferedOutputDevice device( pszFilename );
 
     this->Write( &device );
+    // Flush explicitly, so that write errors are not lost in the destructor
+    device.Flush();
 }
 #endif // _WIN32
 
@@ -292,6 +303,7 @@ void PdfMemDocument::Write( PdfOutputDevice* pDevice )
     PdfWriter writer( &(this->GetObjects()), this->GetTrailer() );
     writer.SetPdfVersion( this->GetPdfVersion() );
     writer.SetWriteMode( m_eWriteMode );
+    writer.SetFreeObjectMemory( m_bFreeObjectMemoryOnWrite );
 
     if( m_pEncrypt ) 
         writer.SetEncrypted( *m_pEncrypt );
@@ -395,5 +407,245 @@ void PdfMemDocument::FreeObjectMemory( PdfObject* pObj, bool bForce )
     pParserObject->FreeObjectMemory( bForce );
 }
 
+/** Amount of raw stream data which PreloadStreams() reads
+ *  before decrypting and decoding it, so that not the data
+ *  of all streams of a large document is in memory at once.
+ */
+static const pdf_long s_lPreloadBatchSize = 64 * 1024 * 1024;
+
+/** A stream which is decrypted and decoded by PreloadStreams().
+ */
+struct TStreamJob {
+    PdfParserObject*    pObject;
+    PdfReference        reference;
+    PdfRefCountedBuffer raw;          ///< The data as read from the file
+    pdf_long            lRawLen;
+    TVecFilters         vecFilters;   ///< Filters to decode, empty if the stream is not decoded
+    PdfDictionary       dict;         ///< Copy of the stream dictionary for the DecodeParms
+
+    char*               pData;        ///< Decrypted or decoded data, allocated with podofo_malloc
+    pdf_long            lLen;
+    bool                bDecoded;
+    EPdfError           eError;       ///< Decryption error
+};
+
+/** The jobs shared by all threads, each thread
+ *  takes the next job until all jobs are done.
+ */
+struct TStreamJobQueue {
+    std::vector<TStreamJob*>* pJobs;
+    size_t                    nNext;
+    const PdfEncrypt*         pEncrypt;
+    Util::PdfMutex            mutex;
+};
+
+static TStreamJob* NextStreamJob( TStreamJobQueue* pQueue )
+{
+    Util::PdfMutexWrapper wrapper( pQueue->mutex );
+
+    if( pQueue->nNext < pQueue->pJobs->size() )
+        return (*pQueue->pJobs)[pQueue->nNext++];
+
+    return NULL;
+}
+
+static void RunStreamJob( TStreamJob* pJob, PdfEncrypt* pEncrypt )
+{
+    const char* pData = pJob->raw.GetBuffer();
+    pdf_long    lLen  = pJob->lRawLen;
+
+    if( pEncrypt && lLen )
+    {
+        try {
+            pJob->pData = static_cast<char*>(podofo_malloc( lLen ));
+            if( !pJob->pData )
+            {
+                PODOFO_RAISE_ERROR( ePdfError_OutOfMemory );
+            }
+
+            pEncrypt->SetCurrentReference( pJob->reference );
+            pEncrypt->Decrypt( reinterpret_cast<const unsigned char*>(pData), lLen,
+                               reinterpret_cast<unsigned char*>(pJob->pData), pJob->lLen );
+        } catch( const PdfError & e ) {
+            pJob->eError = e.GetError();
+            return;
+        }
+
+        pData = pJob->pData;
+        lLen  = pJob->lLen;
+    }
+
+    if( pJob->vecFilters.empty() || !lLen )
+        return;
+
+    // Like PdfMemStream::Uncompress() a stream which cannot
+    // be decoded is kept encoded
+    try {
+        PdfMemoryOutputStream          stream;
+        std::auto_ptr<PdfOutputStream> pDecodeStream( PdfFilterFactory::CreateDecodeStream( pJob->vecFilters, &stream, &(pJob->dict) ) );
+
+        pDecodeStream->Write( pData, lLen );
+        pDecodeStream->Close();
+
+        if( pJob->pData )
+            podofo_free( pJob->pData );
+
+        pJob->lLen     = stream.GetLength();
+        pJob->pData    = stream.TakeBuffer();
+        pJob->bDecoded = true;
+    } catch( const PdfError & ) {
+    }
+}
+
+static void RunStreamQueue( TStreamJobQueue* pQueue )
+{
+    // Each thread needs its own encryption object, 
+    // as the object key is calculated from the current reference
+    std::auto_ptr<PdfEncrypt> pEncrypt( pQueue->pEncrypt ? PdfEncrypt::CreatePdfEncrypt( *(pQueue->pEncrypt) ) : NULL );
+    TStreamJob*               pJob;
+
+    while( (pJob = NextStreamJob( pQueue )) )
+        RunStreamJob( pJob, pEncrypt.get() );
+}
+
+static void StreamWorker( void* pData )
+{
+    RunStreamQueue( static_cast<TStreamJobQueue*>(pData) );
+}
+
+static void RunStreamJobs( std::vector<TStreamJob*> & rJobs, const PdfEncrypt* pEncrypt, int nThreads )
+{
+    TStreamJobQueue queue;
+
+    if( rJobs.empty() )
+        return;
+
+    queue.pJobs    = &rJobs;
+    queue.nNext    = 0;
+    queue.pEncrypt = pEncrypt;
+
+    nThreads = static_cast<int>(PDF_MIN( static_cast<size_t>(nThreads), rJobs.size() ));
+    Util::RunOnThreads( StreamWorker, &queue, nThreads );
+}
+
+static void FreeStreamJobs( std::vector<TStreamJob*> & rJobs )
+{
+    for( size_t i = 0; i < rJobs.size(); i++ )
+    {
+        if( rJobs[i]->pData )
+            podofo_free( rJobs[i]->pData );
+
+        delete rJobs[i];
+    }
+
+    rJobs.clear();
+}
+
+/** Store the results of all jobs in their objects.
+ *  \returns the number of loaded streams
+ */
+static int StoreStreamJobs( std::vector<TStreamJob*> & rJobs )
+{
+    int nLoaded = 0;
+
+    for( size_t i = 0; i < rJobs.size(); i++ )
+    {
+        TStreamJob* pJob = rJobs[i];
+
+        if( pJob->eError != ePdfError_ErrOk )
+        {
+            std::ostringstream oss;
+            oss << "Unable to decrypt the stream of object " << pJob->reference.ObjectNumber() << ' '
+                << pJob->reference.GenerationNumber() << " R";
+            PODOFO_RAISE_ERROR_INFO( pJob->eError, oss.str().c_str() );
+        }
+
+        if( pJob->pData )
+            pJob->pObject->LoadStream( pJob->pData, pJob->lLen );
+        else
+            pJob->pObject->LoadStream( pJob->raw.GetBuffer(), pJob->lRawLen );
+
+        if( pJob->bDecoded )
+        {
+            PdfDictionary & rDict = pJob->pObject->GetDictionary();
+            rDict.RemoveKey( PdfName::KeyFilter );
+            if( rDict.HasKey( "DecodeParms" ) )
+                rDict.RemoveKey( "DecodeParms" );
+        }
+
+        ++nLoaded;
+    }
+
+    return nLoaded;
+}
+
+int PdfMemDocument::PreloadStreams( bool bUncompress, int nThreads )
+{
+    std::vector<TStreamJob*> vecJobs;
+    const PdfEncrypt*        pEncrypt  = NULL;
+    pdf_long                 lBatchLen = 0;
+    int                      nLoaded   = 0;
+
+    if( nThreads <= 0 )
+        nThreads = Util::GetCPUCount();
+
+    try {
+        TIVecObjects it = this->GetObjects().begin();
+        while( it != this->GetObjects().end() )
+        {
+            PdfParserObject* pObject = dynamic_cast<PdfParserObject*>(*it);
+            ++it;
+
+            // IsDictionary() loads the object, so that HasStreamToParse() is known
+            if( !pObject || !pObject->IsDictionary() || !pObject->HasStreamToParse() || pObject->IsStreamLoaded() )
+                continue;
+
+            TStreamJob* pJob = new TStreamJob();
+            pJob->pObject   = pObject;
+            pJob->reference = pObject->Reference();
+            pJob->pData     = NULL;
+            pJob->lLen      = 0;
+            pJob->bDecoded  = false;
+            pJob->eError    = ePdfError_ErrOk;
+            vecJobs.push_back( pJob );
+
+            pJob->lRawLen = pObject->ReadRawStream( pJob->raw );
+            if( pObject->GetEncrypt() )
+                pEncrypt = pObject->GetEncrypt();
+
+            if( bUncompress && pObject->GetDictionary().HasKey( PdfName::KeyFilter ) && pJob->lRawLen )
+            {
+                try {
+                    pJob->vecFilters = PdfFilterFactory::CreateFilterList( pObject );
+                    pJob->dict       = pObject->GetDictionary();
+                } catch( const PdfError & ) {
+                    // Unsupported filters, load the stream without decoding it
+                    pJob->vecFilters.clear();
+                }
+            }
+
+            lBatchLen += pJob->lRawLen;
+            if( lBatchLen >= s_lPreloadBatchSize )
+            {
+                RunStreamJobs( vecJobs, pEncrypt, nThreads );
+                nLoaded += StoreStreamJobs( vecJobs );
+                FreeStreamJobs( vecJobs );
+                lBatchLen = 0;
+            }
+        }
+
+        RunStreamJobs( vecJobs, pEncrypt, nThreads );
+        nLoaded += StoreStreamJobs( vecJobs );
+    } catch( PdfError & e ) {
+        FreeStreamJobs( vecJobs );
+        e.AddToCallstack( __FILE__, __LINE__ );
+        throw e;
+    }
+
+    FreeStreamJobs( vecJobs );
+
+    return nLoaded;
+}
+
 };
 
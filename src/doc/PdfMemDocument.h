@@ -170,6 +170,7 @@ class PODOFO_DOC_API PdfMemDocument : public PdfDocument {
      *  \see Write
      *
      *  This is an overloaded member function for your convinience.
+     *  The file is written through a PdfBufferedOutputDevice.
      */
     void Write( const char* pszFilename );
 
@@ -205,6 +206,22 @@ class PODOFO_DOC_API PdfMemDocument : public PdfDocument {
      */
     virtual EPdfWriteMode GetWriteMode() const { return m_eWriteMode; }
 
+    /** Free the memory of unmodified objects after they have
+     *  been written by Write(), so that writing a loaded document
+     *  requires memory for its largest object only and not for the
+     *  complete document. Objects which were accessed before Write()
+     *  stay in memory. Default is false.
+     *
+     *  \param bFree if true free objects after writing them
+     *  \see PdfWriter::SetFreeObjectMemory
+     */
+    void SetFreeObjectMemoryOnWrite( bool bFree ) { m_bFreeObjectMemoryOnWrite = bFree; }
+
+    /** 
+     *  \returns wether objects are free'd after writing them
+     */
+    bool GetFreeObjectMemoryOnWrite() const { return m_bFreeObjectMemoryOnWrite; }
+
     /** Set the PDF Version of the document. Has to be called before Write() to
      *  have an effect.
      *  \param eVersion  version of the pdf document
@@ -472,6 +489,31 @@ class PODOFO_DOC_API PdfMemDocument : public PdfDocument {
      */
     inline const PdfEncrypt* GetEncrypt() const;
 
+    /** Load the streams of all objects which were not loaded yet.
+     *
+     *  Usually streams are read on demand, one after another on
+     *  the thread which accesses them. For batch jobs which touch
+     *  all streams of a document, this method reads the stream data
+     *  on the calling thread and decrypts and optionally decodes
+     *  it on several threads. This is most useful for encrypted
+     *  documents.
+     *
+     *  Streams of objects which were already loaded or changed
+     *  are not touched.
+     *
+     *  \param bUncompress if true, the streams are decoded, too,
+     *                     as if PdfStream::Uncompress was called.
+     *                     Streams with filters PoDoFo cannot decode
+     *                     are loaded, but stay encoded.
+     *  \param nThreads number of threads used for decryption and
+     *                  decoding, 0 uses one thread per CPU. Without
+     *                  PODOFO_MULTI_THREAD all work is done on the
+     *                  calling thread.
+     *
+     *  \returns the number of loaded streams
+     */
+    int PreloadStreams( bool bUncompress = false, int nThreads = 0 );
+
  private:
     /** Get a dictioary from the catalog dictionary by its name.
      *  \param pszName will be converted into a PdfName
@@ -511,6 +553,7 @@ class PODOFO_DOC_API PdfMemDocument : public PdfDocument {
 
     PdfParser*      m_pParser; ///< This will be temporarily initialized to a PdfParser object so that SetPassword can work
     EPdfWriteMode   m_eWriteMode;
+    bool            m_bFreeObjectMemoryOnWrite;
 };
 
 // -----------------------------------------------------
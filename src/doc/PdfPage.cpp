@@ -506,7 +506,11 @@ unsigned int PdfPage::GetPageNumber() const
         {
             PdfObject* pNode = this->GetObject()->GetOwner()->GetObject( (*it).GetReference() );
 
-            if( pNode->GetDictionary().GetKey( PdfName::KeyType )->GetName() == PdfName( "Pages" ) )
+            if( !pNode )
+                // a page which was written to disk and freed
+                // already by a PdfStreamedDocument
+                ++nPageNumber;
+            else if( pNode->GetDictionary().GetKey( PdfName::KeyType )->GetName() == PdfName( "Pages" ) )
                 nPageNumber += static_cast<int>(pNode->GetDictionary().GetKey( "Count" )->GetNumber());
             else 
                 // if we do not have a page tree node, 
@@ -0,0 +1,43 @@
+/***************************************************************************
+ *   Copyright (C) 2007 by Dominik Seichter                                *
+ *   domseichter@web.de                                                    *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Library General Public License as       *
+ *   published by the Free Software Foundation; either version 2 of the    *
+ *   License, or (at your option) any later version.                       *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this program; if not, write to the                 *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#include "PdfPageBuffer.h"
+
+#include "base/PdfDefinesPrivate.h"
+#include "base/PdfDictionary.h"
+#include "base/PdfObject.h"
+
+namespace PoDoFo {
+
+PdfPageBuffer::PdfPageBuffer( const PdfRect & rSize )
+    : m_pContents( NULL ), m_pResources( NULL ), m_rSize( rSize )
+{
+    m_vecObjects.SetAutoDelete( true );
+
+    m_pContents  = m_vecObjects.CreateObject();
+    m_pResources = m_vecObjects.CreateObject();
+}
+
+PdfPageBuffer::~PdfPageBuffer()
+{
+    // m_pContents and m_pResources are deleted by m_vecObjects
+}
+
+};
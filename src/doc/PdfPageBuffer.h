@@ -0,0 +1,148 @@
+/***************************************************************************
+ *   Copyright (C) 2007 by Dominik Seichter                                *
+ *   domseichter@web.de                                                    *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Library General Public License as       *
+ *   published by the Free Software Foundation; either version 2 of the    *
+ *   License, or (at your option) any later version.                       *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this program; if not, write to the                 *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#ifndef _PDF_PAGE_BUFFER_H_
+#define _PDF_PAGE_BUFFER_H_
+
+#include "podofo/base/PdfDefines.h"
+#include "podofo/base/PdfCanvas.h"
+#include "podofo/base/PdfRect.h"
+#include "podofo/base/PdfVecObjects.h"
+
+namespace PoDoFo {
+
+class PdfObject;
+
+/** The contents and resources of a page, which does not belong to any document yet.
+ *
+ *  You can draw on a PdfPageBuffer using a PdfPainter like you would draw
+ *  onto a page. As a PdfPageBuffer does not share any objects with a document,
+ *  several PdfPageBuffers can be painted on several threads at once and 
+ *  appended to a document afterwards using PdfStreamedDocument::AppendPage.
+ *
+ *  Fonts, images and XObjects of the document may be used on a PdfPageBuffer,
+ *  as only their references are added to the resources. Drawing operations
+ *  which have to create new objects (e.g. separation or CIE Lab colors)
+ *  are not supported.
+ *
+ *  \see PdfStreamedDocument::GeneratePages
+ */
+class PODOFO_DOC_API PdfPageBuffer : public PdfCanvas {
+ public:
+    /** Create a new empty page buffer.
+     *
+     *  \param rSize the size of the page (i.e the /MediaBox key) in PDF units
+     */
+    PdfPageBuffer( const PdfRect & rSize );
+
+    virtual ~PdfPageBuffer();
+
+    /** Get access to the contents object of this page.
+     *  \returns a contents object
+     */
+    inline virtual PdfObject* GetContents() const;
+
+    /** Get access to the contents object of this page.
+     *  \returns a contents object
+     */
+    inline virtual PdfObject* GetContentsForAppending() const;
+
+    /** Get access to the resources object of this page.
+     *  \returns a resources object
+     */
+    inline virtual PdfObject* GetResources() const;
+
+    /** Get the current page size in PDF Units
+     *  \returns a PdfRect containing the page size available for drawing
+     */
+    inline virtual const PdfRect GetPageSize() const;
+
+    /** Set the size of the page
+     *  \param rSize the size of the page in PDF units
+     */
+    inline void SetPageSize( const PdfRect & rSize );
+
+    /** \returns true if objects besides the contents and the resources
+     *           have been created in this page buffer, which cannot
+     *           be appended to a document.
+     */
+    inline bool HasExtraObjects() const;
+
+ private:
+    PdfPageBuffer( const PdfPageBuffer & rhs );
+    const PdfPageBuffer & operator=( const PdfPageBuffer & rhs );
+
+    PdfVecObjects m_vecObjects; ///< Owns the contents and the resources, so that the contents can have a stream
+    PdfObject*    m_pContents;
+    PdfObject*    m_pResources;
+    PdfRect       m_rSize;
+};
+
+// -----------------------------------------------------
+//
+// -----------------------------------------------------
+inline PdfObject* PdfPageBuffer::GetContents() const
+{
+    return m_pContents;
+}
+
+// -----------------------------------------------------
+//
+// -----------------------------------------------------
+inline PdfObject* PdfPageBuffer::GetContentsForAppending() const
+{
+    return m_pContents;
+}
+
+// -----------------------------------------------------
+//
+// -----------------------------------------------------
+inline PdfObject* PdfPageBuffer::GetResources() const
+{
+    return m_pResources;
+}
+
+// -----------------------------------------------------
+//
+// -----------------------------------------------------
+inline const PdfRect PdfPageBuffer::GetPageSize() const
+{
+    return m_rSize;
+}
+
+// -----------------------------------------------------
+//
+// -----------------------------------------------------
+inline void PdfPageBuffer::SetPageSize( const PdfRect & rSize )
+{
+    m_rSize = rSize;
+}
+
+// -----------------------------------------------------
+//
+// -----------------------------------------------------
+inline bool PdfPageBuffer::HasExtraObjects() const
+{
+    return m_vecObjects.GetSize() > 2;
+}
+
+};
+
+#endif // _PDF_PAGE_BUFFER_H_
@@ -126,6 +126,20 @@ void PdfPagesTree::InsertPage( int nAfterPageIndex, PdfObject* pPage )
         return;
     }
 
+    if( !bInsertBefore && IsFlatAppend( nAfterPageIndex ) )
+    {
+        // Appending to a pages tree whose root contains only pages
+        // (as created by CreatePage): there is no need to look at
+        // the last page, which might have been written to disk 
+        // and freed already by a PdfStreamedDocument.
+        PdfObjectList lstParents;
+        lstParents.push_back( this->GetRoot() );
+        InsertPageIntoNode( this->GetRoot(), lstParents, nAfterPageIndex, pPage );
+
+        m_cache.InsertPage( nAfterPageIndex );
+        return;
+    }
+
     //printf("Fetching page node: %i\n", nAfterPageIndex);
     PdfObjectList lstParents;
     //printf("Searching page=%i\n", nAfterPageIndex );
@@ -216,8 +230,10 @@ PdfPage* PdfPagesTree::CreatePage( const PdfRect & rSize )
 {
     PdfPage* pPage = new PdfPage( rSize, GetRoot()->GetOwner() );
 
-    InsertPage( this->GetTotalNumberOfPages() - 1, pPage );
-    m_cache.AddPageObject( this->GetTotalNumberOfPages(), pPage );
+    // The index of the new page is the number of pages before inserting it
+    const int nIndex = this->GetTotalNumberOfPages();
+    InsertPage( nIndex - 1, pPage );
+    m_cache.AddPageObject( nIndex, pPage );
     
     return pPage;
 }
@@ -233,8 +249,9 @@ void PdfPagesTree::CreatePages( const std::vector<PdfRect>& vecSizes )
         vecObjects.push_back( pPage->GetObject() );
     }
 
-    InsertPages( this->GetTotalNumberOfPages() - 1, vecObjects );
-    m_cache.AddPageObjects( this->GetTotalNumberOfPages(), vecPages );
+    const int nIndex = this->GetTotalNumberOfPages();
+    InsertPages( nIndex - 1, vecObjects );
+    m_cache.AddPageObjects( nIndex, vecPages );
 }
 
 void PdfPagesTree::DeletePage( int nPageNumber )
@@ -428,6 +445,12 @@ PdfObject* PdfPagesTree::GetPageNodeFromArray( int nPageNum, const PdfArray & rK
             rLstParents.push_back( pgObject );
             rVar = *(pgObject->GetDictionary().GetKey( "Kids" ));
         }
+        else
+        {
+            // Neither a /Page nor a /Pages or the object does not exist
+            // anymore, e.g. because a PdfStreamedDocument has flushed it
+            return NULL;
+        }
     }
 
     return NULL;
@@ -463,6 +486,16 @@ int PdfPagesTree::GetChildCount( const PdfObject* pNode ) const
     return static_cast<int>(pNode->GetDictionary().GetKeyAsLong("Count", 0L));
 }
 
+bool PdfPagesTree::IsFlatAppend( int nAfterPageIndex ) const
+{
+    const int nTotal = this->GetTotalNumberOfPages();
+    if( nTotal <= 0 || nAfterPageIndex != nTotal - 1 )
+        return false;
+
+    const PdfObject* pKids = this->GetRoot()->GetDictionary().GetKey( PdfName("Kids") );
+    return pKids && pKids->IsArray() && pKids->GetArray().GetSize() == static_cast<size_t>(nTotal);
+}
+
 int PdfPagesTree::GetPosInKids( PdfObject* pPageObj, PdfObject* pPageParent )
 {
     if( !pPageParent )
@@ -505,37 +538,38 @@ void PdfPagesTree::InsertPageIntoNode( PdfObject* pParent, const PdfObjectList &
     // 3. Add Parent key to the page
 
     // 1. Add reference
-    const PdfArray oldKids = pParent->GetDictionary().GetKey( PdfName("Kids") )->GetArray();
-    PdfArray::const_iterator it = oldKids.begin();
-    PdfArray newKids;
-
-    newKids.reserve( oldKids.GetSize() + 1 );
-
-    if( nIndex < 0 ) 
+    PdfArray & rKids = pParent->GetDictionary().GetKey( PdfName("Kids") )->GetArray();
+    if( nIndex >= 0 && static_cast<size_t>(nIndex) + 1 == rKids.GetSize() )
     {
-        newKids.push_back( pPage->Reference() );
+        // Appending to the end does not require a copy of the array
+        rKids.push_back( pPage->Reference() );
     }
-
-    int i = 0;
-    while( it != oldKids.end() ) 
+    else
     {
-        newKids.push_back( *it );
+        PdfArray::const_iterator it = rKids.begin();
+        PdfArray newKids;
 
-        if( i == nIndex ) 
+        newKids.reserve( rKids.GetSize() + 1 );
+
+        if( nIndex < 0 ) 
+        {
             newKids.push_back( pPage->Reference() );
+        }
 
-        ++i;
-        ++it;
-    }
+        int i = 0;
+        while( it != rKids.end() ) 
+        {
+            newKids.push_back( *it );
 
-    /*
-    PdfVariant var2( newKids );
-    std::string str2;
-    var2.ToString(str2);
-    printf("newKids= %s\n", str2.c_str() );
-    */
+            if( i == nIndex ) 
+                newKids.push_back( pPage->Reference() );
 
-    pParent->GetDictionary().AddKey( PdfName("Kids"), newKids );
+            ++i;
+            ++it;
+        }
+
+        pParent->GetDictionary().AddKey( PdfName("Kids"), newKids );
+    }
  
     // 2. increase count
     PdfObjectList::const_reverse_iterator itParents = rlstParents.rbegin();
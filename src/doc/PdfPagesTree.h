@@ -163,6 +163,18 @@ class PODOFO_DOC_API PdfPagesTree : public PdfElement
      */
     inline void ClearCache();
 
+    /**
+     * Delete the cached PdfPage object of a single page.
+     * The page stays in the pages tree, only the PdfPage 
+     * object is deleted and becomes invalid.
+     *
+     * \param pPage a PdfPage owned by this pages tree
+     * \returns true if pPage was found in the cache and deleted
+     *
+     * \see PdfStreamedDocument::FlushPage
+     */
+    inline bool ClearCache( PdfPage* pPage );
+
  private:
     PdfPagesTree();	// don't allow construction from nothing!
 
@@ -171,6 +183,14 @@ class PODOFO_DOC_API PdfPagesTree : public PdfElement
 
     int GetChildCount( const PdfObject* pNode ) const;
 
+    /**
+     * Test if a page inserted after nAfterPageIndex is appended
+     * to the kids array of the root node, which contains only pages.
+     * @return true if the new page can be appended to the root node
+     *         without looking at any other page
+     */
+    bool IsFlatAppend( int nAfterPageIndex ) const;
+
     /**
      * Test if a PdfObject is a page node
      * @return true if PdfObject is a page node
@@ -286,6 +306,14 @@ inline void PdfPagesTree::ClearCache()
     m_cache.ClearCache();
 }
 
+// -----------------------------------------------------
+// 
+// -----------------------------------------------------
+inline bool PdfPagesTree::ClearCache( PdfPage* pPage ) 
+{
+    return m_cache.ClearPage( pPage );
+}
+
 };
 
 #endif // _PDF_PAGES_TREE_H_
@@ -117,6 +117,24 @@ void PdfPagesTreeCache::DeletePage( int nIndex )
     m_deqPageObjs.erase( m_deqPageObjs.begin() + nIndex );
 }
 
+bool PdfPagesTreeCache::ClearPage( PdfPage* pPage )
+{
+    PdfPageList::reverse_iterator it = m_deqPageObjs.rbegin();
+    while( it != m_deqPageObjs.rend() )
+    {
+        if( *it == pPage )
+        {
+            delete pPage;
+            *it = NULL;
+            return true;
+        }
+
+        ++it;
+    }
+
+    return false;
+}
+
 void PdfPagesTreeCache::ClearCache() 
 {
     PdfPageList::iterator it = m_deqPageObjs.begin();
@@ -95,6 +95,16 @@ class PODOFO_DOC_API PdfPagesTreeCache
      */
     virtual void DeletePage( int nIndex );
 
+    /**
+     * Delete a PdfPage from the cache, but keep its position,
+     * so that the indices of all following pages do not change.
+     * The cache is searched from the end, so that recently 
+     * created pages are found quickly.
+     * @param pPage page object
+     * @returns true if the page was found and deleted
+     */
+    virtual bool ClearPage( PdfPage* pPage );
+
     /**
      * Clear cache, i.e. remove all elements from the 
      * cache.
@@ -662,10 +662,6 @@ void PdfPainter::DrawText( double dX, double dY, const PdfString & sText, long l
 
     PdfString sString = this->ExpandTabs( sText, lStringLen );
     this->AddToPageResources( m_pFont->GetIdentifier(), m_pFont->GetObject()->Reference(), PdfName("Font") );
-    if( m_pFont->IsSubsetting() )
-    {
-        m_pFont->AddUsedSubsettingGlyphs( sText, lStringLen );
-    }
 
     if( m_pFont->IsUnderlined() || m_pFont->IsStrikeOut())
     {
@@ -797,10 +793,6 @@ void PdfPainter::AddText( const PdfString & sText, pdf_long lStringLen )
     }
 
     PdfString sString = this->ExpandTabs( sText, lStringLen );
-    if( m_pFont->IsSubsetting() )
-    {
-        m_pFont->AddUsedSubsettingGlyphs( sText, lStringLen );
-    }
 
 	// TODO: Underline and Strikeout not yet supported
     
@@ -0,0 +1,253 @@
+/***************************************************************************
+ *   Copyright (C) 2007 by Dominik Seichter                                *
+ *   domseichter@web.de                                                    *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Library General Public License as       *
+ *   published by the Free Software Foundation; either version 2 of the    *
+ *   License, or (at your option) any later version.                       *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this program; if not, write to the                 *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#include "PdfSharedFontCache.h"
+
+#include "base/PdfDefinesPrivate.h"
+
+#include "base/PdfInputStream.h"
+#include "base/util/PdfMutexWrapper.h"
+
+#include <map>
+
+namespace PoDoFo {
+
+typedef std::map<std::string,PdfSharedFont*> TSharedFontMap;
+typedef std::map<std::string,std::string>    TFontPathMap;
+
+/** The shared fonts and the paths, which are used by all threads. 
+ *  All access is protected by s_sharedFontMutex.
+ */
+static TSharedFontMap s_mapSharedFonts;
+static TFontPathMap   s_mapFontPaths;
+static bool           s_bSharedFontsEnabled = false;
+static size_t         s_nUnusedSize         = 0;     ///< Size of all fonts with a reference count of 0
+static size_t         s_nUnusedLimit        = 32 * 1024 * 1024;
+static unsigned long  s_ulSharedFontUse     = 0;
+static Util::PdfMutex s_sharedFontMutex;
+
+/** \returns the key of a font in s_mapFontPaths
+ */
+static std::string GetFontPathKey( const char* pszFontName, bool bBold, bool bItalic )
+{
+    std::string sKey = pszFontName ? pszFontName : "";
+    sKey += '\0';
+    sKey += bBold   ? 'B' : '-';
+    sKey += bItalic ? 'I' : '-';
+    return sKey;
+}
+
+PdfSharedFont::PdfSharedFont( const std::string & rsFilename, char* pData, pdf_long lLen )
+    : m_sFilename( rsFilename ), m_pData( pData ), m_lLen( lLen ), 
+      m_bHasWidths( false ), m_lRefCount( 0 ), m_ulLastUse( 0 )
+{
+}
+
+PdfSharedFont::~PdfSharedFont()
+{
+    podofo_free( m_pData );
+}
+
+bool PdfSharedFont::GetWidths( std::vector<double> & rvecWidth ) const
+{
+    Util::PdfMutexWrapper wrapper( s_sharedFontMutex );
+
+    if( !m_bHasWidths )
+        return false;
+
+    rvecWidth = m_vecWidth;
+    return true;
+}
+
+void PdfSharedFont::SetWidths( const std::vector<double> & rvecWidth )
+{
+    Util::PdfMutexWrapper wrapper( s_sharedFontMutex );
+
+    if( !m_bHasWidths )
+    {
+        m_vecWidth   = rvecWidth;
+        m_bHasWidths = true;
+    }
+}
+
+void PdfSharedFontCache::ShrinkCache()
+{
+    while( s_nUnusedSize > s_nUnusedLimit )
+    {
+        TSharedFontMap::iterator itOldest = s_mapSharedFonts.end();
+        TSharedFontMap::iterator it       = s_mapSharedFonts.begin();
+        for( ; it != s_mapSharedFonts.end(); ++it )
+        {
+            if( (*it).second->m_lRefCount == 0 && 
+                (itOldest == s_mapSharedFonts.end() || (*it).second->m_ulLastUse < (*itOldest).second->m_ulLastUse) )
+                itOldest = it;
+        }
+
+        if( itOldest == s_mapSharedFonts.end() )
+            break;
+
+        s_nUnusedSize -= static_cast<size_t>((*itOldest).second->GetDataLen());
+        delete (*itOldest).second;
+        s_mapSharedFonts.erase( itOldest );
+    }
+}
+
+void PdfSharedFontCache::SetEnabled( bool bEnabled )
+{
+    Util::PdfMutexWrapper wrapper( s_sharedFontMutex );
+
+    s_bSharedFontsEnabled = bEnabled;
+}
+
+bool PdfSharedFontCache::IsEnabled()
+{
+    Util::PdfMutexWrapper wrapper( s_sharedFontMutex );
+
+    return s_bSharedFontsEnabled;
+}
+
+void PdfSharedFontCache::SetCacheLimit( size_t nBytes )
+{
+    Util::PdfMutexWrapper wrapper( s_sharedFontMutex );
+
+    s_nUnusedLimit = nBytes;
+    ShrinkCache();
+}
+
+void PdfSharedFontCache::ClearCache()
+{
+    Util::PdfMutexWrapper wrapper( s_sharedFontMutex );
+
+    // Fonts in use stay in the cache until they are released
+    TSharedFontMap::iterator it = s_mapSharedFonts.begin();
+    while( it != s_mapSharedFonts.end() )
+    {
+        if( (*it).second->m_lRefCount == 0 )
+        {
+            s_nUnusedSize -= static_cast<size_t>((*it).second->GetDataLen());
+            delete (*it).second;
+            s_mapSharedFonts.erase( it++ );
+        }
+        else
+            ++it;
+    }
+
+    s_mapFontPaths.clear();
+}
+
+bool PdfSharedFontCache::GetFontPath( const char* pszFontName, bool bBold, bool bItalic, std::string & rsPath )
+{
+    Util::PdfMutexWrapper wrapper( s_sharedFontMutex );
+
+    if( !s_bSharedFontsEnabled )
+        return false;
+
+    TFontPathMap::const_iterator it = s_mapFontPaths.find( GetFontPathKey( pszFontName, bBold, bItalic ) );
+    if( it == s_mapFontPaths.end() )
+        return false;
+
+    rsPath = (*it).second;
+    return true;
+}
+
+void PdfSharedFontCache::AddFontPath( const char* pszFontName, bool bBold, bool bItalic, const std::string & rsPath )
+{
+    Util::PdfMutexWrapper wrapper( s_sharedFontMutex );
+
+    if( s_bSharedFontsEnabled )
+        s_mapFontPaths[GetFontPathKey( pszFontName, bBold, bItalic )] = rsPath;
+}
+
+PdfSharedFont* PdfSharedFontCache::Acquire( const char* pszFilename )
+{
+    if( !pszFilename )
+    {
+        PODOFO_RAISE_ERROR( ePdfError_InvalidHandle );
+    }
+
+    {
+        Util::PdfMutexWrapper wrapper( s_sharedFontMutex );
+
+        if( !s_bSharedFontsEnabled )
+            return NULL;
+
+        TSharedFontMap::iterator it = s_mapSharedFonts.find( pszFilename );
+        if( it != s_mapSharedFonts.end() )
+        {
+            PdfSharedFont* pFont = (*it).second;
+            if( pFont->m_lRefCount++ == 0 )
+                s_nUnusedSize -= static_cast<size_t>(pFont->GetDataLen());
+
+            pFont->m_ulLastUse = ++s_ulSharedFontUse;
+            return pFont;
+        }
+    }
+
+    // Read the file without locking the cache, so that
+    // other threads can use the cached fonts in the meantime
+    PdfFileInputStream stream( pszFilename );
+    pdf_long           lLen  = stream.GetFileLength();
+    char*              pData = static_cast<char*>(podofo_malloc( lLen ? lLen : 1 ));
+    if( !pData )
+    {
+        PODOFO_RAISE_ERROR( ePdfError_OutOfMemory );
+    }
+
+    if( stream.Read( pData, lLen ) != lLen )
+    {
+        podofo_free( pData );
+        PODOFO_RAISE_ERROR_INFO( ePdfError_UnexpectedEOF, pszFilename );
+    }
+
+    Util::PdfMutexWrapper wrapper( s_sharedFontMutex );
+
+    PdfSharedFont* & rpFont = s_mapSharedFonts[pszFilename];
+    if( rpFont )
+    {
+        // Another thread has read the same font meanwhile
+        podofo_free( pData );
+
+        if( rpFont->m_lRefCount == 0 )
+            s_nUnusedSize -= static_cast<size_t>(rpFont->GetDataLen());
+    }
+    else
+        rpFont = new PdfSharedFont( pszFilename, pData, lLen );
+
+    ++rpFont->m_lRefCount;
+    rpFont->m_ulLastUse = ++s_ulSharedFontUse;
+    return rpFont;
+}
+
+void PdfSharedFontCache::Release( PdfSharedFont* pFont )
+{
+    if( !pFont )
+        return;
+
+    Util::PdfMutexWrapper wrapper( s_sharedFontMutex );
+
+    if( --pFont->m_lRefCount == 0 )
+    {
+        pFont->m_ulLastUse = ++s_ulSharedFontUse;
+        s_nUnusedSize += static_cast<size_t>(pFont->GetDataLen());
+        ShrinkCache();
+    }
+}
+
+};
@@ -0,0 +1,212 @@
+/***************************************************************************
+ *   Copyright (C) 2007 by Dominik Seichter                                *
+ *   domseichter@web.de                                                    *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Library General Public License as       *
+ *   published by the Free Software Foundation; either version 2 of the    *
+ *   License, or (at your option) any later version.                       *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this program; if not, write to the                 *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#ifndef _PDF_SHARED_FONT_CACHE_H_
+#define _PDF_SHARED_FONT_CACHE_H_
+
+#include "podofo/base/PdfDefines.h"
+
+#include <string>
+#include <vector>
+
+namespace PoDoFo {
+
+class PdfSharedFontCache;
+
+/**
+ * The contents of a font file, which are shared by all 
+ * PdfFontMetricsFreetype objects of the process using this file.
+ *
+ * The font data is never changed after the font was loaded,
+ * so it can be read by several threads at once. 
+ * The widths of the first 256 characters are calculated 
+ * by the first metrics object which uses the font and are
+ * reused by all other metrics objects.
+ *
+ * Shared fonts are created and reference counted by PdfSharedFontCache.
+ */
+class PODOFO_DOC_API PdfSharedFont {
+    friend class PdfSharedFontCache;
+
+ public:
+    /** \returns the path of the font file
+     */
+    inline const std::string & GetFilename() const;
+
+    /** \returns the contents of the font file
+     */
+    inline const char* GetData() const;
+
+    /** \returns the length of the font file
+     */
+    inline pdf_long GetDataLen() const;
+
+    /** Get the widths calculated by a metrics object.
+     *
+     *  \param rvecWidth the widths are copied into this vector
+     *  \returns false if no widths have been stored yet
+     */
+    bool GetWidths( std::vector<double> & rvecWidth ) const;
+
+    /** Store the widths calculated by a metrics object,
+     *  unless another one stored them already.
+     *
+     *  \param rvecWidth the widths of the first characters
+     */
+    void SetWidths( const std::vector<double> & rvecWidth );
+
+ private:
+    PdfSharedFont( const std::string & rsFilename, char* pData, pdf_long lLen );
+    ~PdfSharedFont();
+
+    PdfSharedFont( const PdfSharedFont & rhs );
+    const PdfSharedFont & operator=( const PdfSharedFont & rhs );
+
+ private:
+    std::string         m_sFilename;
+    char*               m_pData;
+    pdf_long            m_lLen;
+
+    // The following members are protected by the mutex of PdfSharedFontCache
+    bool                m_bHasWidths;
+    std::vector<double> m_vecWidth;
+
+    long                m_lRefCount;
+    unsigned long       m_ulLastUse;   ///< Used to find the least recently used font
+};
+
+/**
+ * A process-wide cache of font files and of the results
+ * of fontconfig lookups, which is shared by all documents.
+ *
+ * Applications creating many documents with the same fonts
+ * may enable the cache so that a font is found by fontconfig and
+ * read from disk only once. PdfFontCache uses the cache for all fonts
+ * loaded from a file if it is enabled. Each document still opens 
+ * its own FreeType face, but from the shared memory instead of the file.
+ *
+ * Fonts are reference counted: A font is kept as long as a
+ * metrics object uses it. Fonts which are not used any more stay
+ * in the cache until the total size of unused fonts exceeds
+ * the cache limit, then the least recently used ones are freed.
+ *
+ * The cache is disabled by default. All methods are thread safe
+ * if PoDoFo was built with PODOFO_MULTI_THREAD.
+ *
+ * The names of fonts are resolved once for the whole process,
+ * so do not enable the cache if documents use different 
+ * fontconfig configurations.
+ *
+ * \see PdfFontCache
+ */
+class PODOFO_DOC_API PdfSharedFontCache {
+ public:
+    /** Enable or disable the cache. 
+     *  Disabling the cache does not free any fonts, call ClearCache() for that.
+     *
+     *  \param bEnabled if true PdfFontCache shares fonts between documents
+     */
+    static void SetEnabled( bool bEnabled );
+
+    /** \returns true if the cache is enabled
+     */
+    static bool IsEnabled();
+
+    /** Set the maximum size of all fonts, which are cached
+     *  but not used by any document. The default is 32MB.
+     *
+     *  \param nBytes the new limit, 0 frees fonts as soon as they are not used anymore
+     */
+    static void SetCacheLimit( size_t nBytes );
+
+    /** Free all fonts which are not in use and
+     *  forget all paths found by fontconfig.
+     */
+    static void ClearCache();
+
+    /** Find the path of a font resolved before.
+     *
+     *  \param pszFontName name of the font
+     *  \param bBold true for a bold font
+     *  \param bItalic true for an italic font
+     *  \param rsPath the path is stored here
+     *  \returns true if the path is known
+     */
+    static bool GetFontPath( const char* pszFontName, bool bBold, bool bItalic, std::string & rsPath );
+
+    /** Remember the path of a font.
+     *
+     *  \param pszFontName name of the font
+     *  \param bBold true for a bold font
+     *  \param bItalic true for an italic font
+     *  \param rsPath path of the font file
+     */
+    static void AddFontPath( const char* pszFontName, bool bBold, bool bItalic, const std::string & rsPath );
+
+    /** Get a shared font, the file is read if it is not yet cached.
+     *  Every font returned by this method has to be passed to Release() again.
+     *
+     *  \param pszFilename path of a font file
+     *  \returns the font or NULL if the cache is disabled
+     */
+    static PdfSharedFont* Acquire( const char* pszFilename );
+
+    /** Release a font returned by Acquire().
+     *
+     *  \param pFont a shared font
+     */
+    static void Release( PdfSharedFont* pFont );
+
+ private:
+    PdfSharedFontCache();
+
+    /** Free the least recently used fonts, which are not in use,
+     *  until the cache limit is reached. The cache has to be locked.
+     */
+    static void ShrinkCache();
+};
+
+// -----------------------------------------------------
+// 
+// -----------------------------------------------------
+inline const std::string & PdfSharedFont::GetFilename() const
+{
+    return m_sFilename;
+}
+
+// -----------------------------------------------------
+// 
+// -----------------------------------------------------
+inline const char* PdfSharedFont::GetData() const
+{
+    return m_pData;
+}
+
+// -----------------------------------------------------
+// 
+// -----------------------------------------------------
+inline pdf_long PdfSharedFont::GetDataLen() const
+{
+    return m_lLen;
+}
+
+};
+
+#endif // _PDF_SHARED_FONT_CACHE_H_
@@ -21,9 +21,73 @@
 #include "PdfStreamedDocument.h"
 
 #include "base/PdfDefinesPrivate.h"
+#include "base/PdfBufferedOutputDevice.h"
+#include "base/PdfDictionary.h"
+#include "base/PdfStream.h"
+
+#include "base/util/PdfMutexWrapper.h"
+#include "base/util/PdfThreads.h"
+
+#include "PdfPage.h"
+#include "PdfPageBuffer.h"
+#include "PdfPagesTree.h"
+
+#include <stdlib.h>
 
 namespace PoDoFo {
 
+/** The pages painted by GeneratePages() at once, shared by all threads.
+ */
+struct TPageGeneration {
+    PdfPageGenerator            pGenerator;
+    void*                       pData;
+
+    int                         nFirst;    ///< Index of the first page of the current window
+    int                         nNext;     ///< Index of the next page to paint
+    int                         nEnd;      ///< Index after the last page of the current window
+    std::vector<PdfPageBuffer*> vecBuffers;
+
+    Util::PdfMutex              mutex;     ///< Protects nNext, bError and error
+    bool                        bError;
+    PdfError                    error;     ///< The first error of any thread
+};
+
+static void GeneratePagesThread( void* pData )
+{
+    TPageGeneration* pGeneration = static_cast<TPageGeneration*>(pData);
+
+    while( true )
+    {
+        int nPage;
+        {
+            Util::PdfMutexWrapper wrapper( pGeneration->mutex );
+            if( pGeneration->bError || pGeneration->nNext >= pGeneration->nEnd )
+                return;
+
+            nPage = pGeneration->nNext++;
+        }
+
+        try {
+            pGeneration->pGenerator( nPage, *pGeneration->vecBuffers[nPage - pGeneration->nFirst], pGeneration->pData );
+        } catch( const PdfError & rError ) {
+            Util::PdfMutexWrapper wrapper( pGeneration->mutex );
+            if( !pGeneration->bError )
+            {
+                pGeneration->bError = true;
+                pGeneration->error  = rError;
+            }
+        } catch( ... ) {
+            Util::PdfMutexWrapper wrapper( pGeneration->mutex );
+            if( !pGeneration->bError )
+            {
+                pGeneration->bError = true;
+                pGeneration->error  = PdfError( ePdfError_Unknown, __FILE__, __LINE__, 
+                                                "Unknown exception in page generator." );
+            }
+        }
+    }
+}
+
 PdfStreamedDocument::PdfStreamedDocument( PdfOutputDevice* pDevice, EPdfVersion eVersion, PdfEncrypt* pEncrypt, EPdfWriteMode eWriteMode )
     : m_pWriter( NULL ), m_pDevice( NULL ), m_pEncrypt( pEncrypt ), m_bOwnDevice( false )
 {
@@ -33,7 +97,7 @@ PdfStreamedDocument::PdfStreamedDocument( PdfOutputDevice* pDevice, EPdfVersion
 PdfStreamedDocument::PdfStreamedDocument( const char* pszFilename, EPdfVersion eVersion, PdfEncrypt* pEncrypt, EPdfWriteMode eWriteMode )
     : m_pWriter( NULL ), m_pEncrypt( pEncrypt ), m_bOwnDevice( true )
 {
-    m_pDevice = new PdfOutputDevice( pszFilename );
+    m_pDevice = new PdfBufferedOutputDevice( pszFilename );
     Init( m_pDevice, eVersion, pEncrypt, eWriteMode );
 }
 
@@ -41,7 +105,7 @@ PdfStreamedDocument::PdfStreamedDocument( const char* pszFilename, EPdfVersion e
 PdfStreamedDocument::PdfStreamedDocument( const wchar_t* pszFilename, EPdfVersion eVersion, PdfEncrypt* pEncrypt, EPdfWriteMode eWriteMode )
     : m_pWriter( NULL ), m_pEncrypt( pEncrypt ), m_bOwnDevice( true )
 {
-    m_pDevice = new PdfOutputDevice( pszFilename );
+    m_pDevice = new PdfBufferedOutputDevice( pszFilename );
     Init( m_pDevice, eVersion, pEncrypt, eWriteMode );
 }
 #endif // _WIN32
@@ -68,6 +132,178 @@ void PdfStreamedDocument::Close()
     this->GetObjects()->Finish();
 }
 
+void PdfStreamedDocument::FlushObject( PdfObject* pObject )
+{
+    m_pWriter->FlushObject( pObject );
+}
+
+void PdfStreamedDocument::FlushPage( PdfPage* pPage )
+{
+    if( !pPage ) 
+    {
+        PODOFO_RAISE_ERROR( ePdfError_InvalidHandle );
+    }
+
+    // Collect the references of all objects of the page first,
+    // as the PdfPage is deleted before its objects are written.
+    std::vector<PdfReference> vecRefs;
+    PdfObject*                pPageObj = pPage->GetObject();
+
+    const PdfObject* pContents = pPageObj->GetDictionary().GetKey( PdfName("Contents") );
+    if( pContents && pContents->IsReference() )
+        vecRefs.push_back( pContents->GetReference() );
+    else if( pContents && pContents->IsArray() )
+    {
+        PdfArray::const_iterator it = pContents->GetArray().begin();
+        for( ; it != pContents->GetArray().end(); ++it )
+            if( (*it).IsReference() )
+                vecRefs.push_back( (*it).GetReference() );
+    }
+
+    const PdfObject* pAnnots = pPageObj->GetDictionary().GetKey( PdfName("Annots") );
+    if( pAnnots && pAnnots->IsReference() )
+    {
+        vecRefs.push_back( pAnnots->GetReference() );
+        pAnnots = this->GetObjects()->GetObject( pAnnots->GetReference() );
+    }
+
+    if( pAnnots && pAnnots->IsArray() )
+    {
+        PdfArray::const_iterator it = pAnnots->GetArray().begin();
+        for( ; it != pAnnots->GetArray().end(); ++it )
+            if( (*it).IsReference() )
+                vecRefs.push_back( (*it).GetReference() );
+    }
+
+    vecRefs.push_back( pPageObj->Reference() );
+
+    if( !this->GetPagesTree()->ClearCache( pPage ) )
+    {
+        PODOFO_RAISE_ERROR_INFO( ePdfError_InvalidHandle, "The page does not belong to this document." );
+    }
+
+    std::vector<PdfReference>::const_iterator it = vecRefs.begin();
+    for( ; it != vecRefs.end(); ++it )
+    {
+        // Objects shared with other pages might have been flushed already
+        PdfObject* pObject = this->GetObjects()->GetObject( *it );
+        if( pObject )
+            m_pWriter->FlushObject( pObject );
+    }
+}
+
+
+
+PdfPage* PdfStreamedDocument::AppendPage( const PdfPageBuffer & rBuffer )
+{
+    const PdfObject* pSrcContents = rBuffer.GetContents();
+    if( pSrcContents->HasStream() && pSrcContents->GetStream()->IsAppending() )
+    {
+        PODOFO_RAISE_ERROR_INFO( ePdfError_InternalLogic, "PdfPainter::FinishPage() has to be called before appending a page buffer." );
+    }
+
+    if( rBuffer.HasExtraObjects() ) 
+    {
+        PODOFO_RAISE_ERROR_INFO( ePdfError_NotImplemented, "Objects created in a page buffer cannot be appended to a document." );
+    }
+
+    PdfPage* pPage = this->CreatePage( rBuffer.GetPageSize() );
+
+    // Add all resources, e.g. /Font /Ft0 12 0 R
+    const TKeyMap & rResources = rBuffer.GetResources()->GetDictionary().GetKeys();
+    TCIKeyMap       itCategory = rResources.begin();
+    for( ; itCategory != rResources.end(); ++itCategory )
+    {
+        if( !(*itCategory).second->IsDictionary() )
+            continue;
 
+        const TKeyMap & rKeys = (*itCategory).second->GetDictionary().GetKeys();
+        TCIKeyMap       it    = rKeys.begin();
+        for( ; it != rKeys.end(); ++it )
+            if( (*it).second->IsReference() )
+                pPage->AddResource( (*it).first, (*it).second->GetReference(), (*itCategory).first );
+    }
+
+    if( !pSrcContents->HasStream() )
+        return pPage;
+
+    // Copy the encoded contents along with their filters
+    PdfObject*       pContents = pPage->GetContents();
+    const PdfObject* pFilter   = pSrcContents->GetDictionary().GetKey( PdfName::KeyFilter );
+    const PdfObject* pParms    = pSrcContents->GetDictionary().GetKey( "DecodeParms" );
+    if( pFilter )
+        pContents->GetDictionary().AddKey( PdfName::KeyFilter, *pFilter );
+    if( pParms )
+        pContents->GetDictionary().AddKey( "DecodeParms", *pParms );
+
+    char*    pBuffer;
+    pdf_long lLen;
+    pSrcContents->GetStream()->GetCopy( &pBuffer, &lLen );
+
+    try {
+        TVecFilters vecNoFilters;
+        pContents->GetStream()->BeginAppend( vecNoFilters, true, false );
+        pContents->GetStream()->Append( pBuffer, lLen );
+        pContents->GetStream()->EndAppend();
+    } catch( PdfError & e ) {
+        free( pBuffer );
+        throw e;
+    }
+
+    free( pBuffer );
+    return pPage;
+}
+
+void PdfStreamedDocument::GeneratePages( int nCount, const PdfRect & rSize, PdfPageGenerator pGenerator, 
+                                         void* pData, int nThreads, int nWindow )
+{
+    if( !pGenerator ) 
+    {
+        PODOFO_RAISE_ERROR( ePdfError_InvalidHandle );
+    }
+
+    if( nThreads <= 0 )
+        nThreads = Util::GetCPUCount();
+    if( nWindow <= 0 )
+        nWindow = 4 * nThreads;
+
+    TPageGeneration generation;
+    generation.pGenerator = pGenerator;
+    generation.pData      = pData;
+    generation.bError     = false;
+
+    for( int nFirst = 0; nFirst < nCount; nFirst += nWindow )
+    {
+        generation.nFirst = nFirst;
+        generation.nNext  = nFirst;
+        generation.nEnd   = PDF_MIN( nFirst + nWindow, nCount );
+
+        for( int i = nFirst; i < generation.nEnd; i++ )
+            generation.vecBuffers.push_back( new PdfPageBuffer( rSize ) );
+
+        Util::RunOnThreads( GeneratePagesThread, &generation, PDF_MIN( nThreads, generation.nEnd - nFirst ) );
+
+        try {
+            for( size_t i = 0; !generation.bError && i < generation.vecBuffers.size(); i++ )
+            {
+                PdfPage* pPage = this->AppendPage( *generation.vecBuffers[i] );
+                this->FlushPage( pPage );
+
+                delete generation.vecBuffers[i];
+                generation.vecBuffers[i] = NULL;
+            }
+        } catch( PdfError & e ) {
+            generation.bError = true;
+            generation.error  = e;
+        }
+
+        for( size_t i = 0; i < generation.vecBuffers.size(); i++ )
+            delete generation.vecBuffers[i];
+        generation.vecBuffers.clear();
+
+        if( generation.bError )
+            throw generation.error;
+    }
+}
 
 };
@@ -29,6 +29,15 @@
 namespace PoDoFo {
 
 class PdfOutputDevice;
+class PdfPageBuffer;
+
+/** A function which paints a single page for PdfStreamedDocument::GeneratePages().
+ *
+ *  \param nPage the 0-based index of the page among the generated pages
+ *  \param rBuffer paint the page onto this buffer and call PdfPainter::FinishPage()
+ *  \param pData the user data passed to GeneratePages()
+ */
+typedef void (*PdfPageGenerator)( int nPage, PdfPageBuffer & rBuffer, void* pData );
 
 /** PdfStreamedDocument is the preferred class for 
  *  creating new PDF documents.
@@ -83,7 +92,8 @@ class PODOFO_DOC_API PdfStreamedDocument : public PdfDocument {
     PdfStreamedDocument( PdfOutputDevice* pDevice, EPdfVersion eVersion = ePdfVersion_Default, PdfEncrypt* pEncrypt = NULL, EPdfWriteMode eWriteMode = ePdfWriteMode_Default );
 
     /** Create a new PdfStreamedDocument.
-     *  All data is written to a file immediately.
+     *  All data is written to a file immediately,
+     *  using a PdfBufferedOutputDevice.
      *
      *  \param pszFilename resulting PDF file
      *  \param eVersion the PDF version of the document to write.
@@ -98,7 +108,8 @@ class PODOFO_DOC_API PdfStreamedDocument : public PdfDocument {
 
 #ifdef _WIN32
     /** Create a new PdfStreamedDocument.
-     *  All data is written to a file immediately.
+     *  All data is written to a file immediately,
+     *  using a PdfBufferedOutputDevice.
      *
      *  \param pszFilename resulting PDF file
      *  \param eVersion the PDF version of the document to write.
@@ -124,6 +135,93 @@ class PODOFO_DOC_API PdfStreamedDocument : public PdfDocument {
      */
     void Close();
 
+    /** Write an object to disk immediately and free its memory.
+     *
+     *  Objects with a stream are written while they are created,
+     *  all other objects are usually kept in memory until Close()
+     *  is called. Use this method for objects which are complete
+     *  and will not change anymore. Other objects may still refer
+     *  to a flushed object, as only its reference is needed for that.
+     *  Objects like the /Pages tree, which are only known
+     *  when the document is closed, must not be flushed.
+     *
+     *  If a painter draws on another page currently, the object
+     *  is written after this page has been finished.
+     *
+     *  \param pObject an object of this document, which is deleted
+     *                 and must not be accessed anymore
+     *
+     *  \see FlushPage
+     */
+    void FlushObject( PdfObject* pObject );
+
+    /** Write a finished page to disk immediately and free its memory.
+     *
+     *  The page object, its contents and its annotations are written
+     *  and deleted. The page stays in the pages tree of the document
+     *  and the index of all other pages does not change, but the page
+     *  cannot be accessed anymore: GetPage() returns NULL for it.
+     *  Resources like fonts and images may be shared by several pages
+     *  and are not written by this method.
+     *
+     *  Flushing finished pages keeps the memory usage of 
+     *  documents with many pages constant:
+     *
+     *  \code
+     *  PdfPage* pPage = document.CreatePage( rSize );
+     *  painter.SetPage( pPage );
+     *  // draw ...
+     *  painter.FinishPage();
+     *  document.FlushPage( pPage );
+     *  \endcode
+     *
+     *  \param pPage a page of this document, whose painter must be 
+     *               finished already. Other pages may still be drawn on.
+     *               The PdfPage is deleted, too.
+     */
+    void FlushPage( PdfPage* pPage );
+
+    /** Create a new page from a page buffer and append it to the document.
+     *
+     *  The page gets the size, the resources and the contents
+     *  of the buffer. The contents are copied as they are,
+     *  i.e. they are not compressed again.
+     *
+     *  \param rBuffer a page buffer, whose painter must be finished already
+     *  \returns the new page, which is owned by the pages tree
+     *
+     *  \see GeneratePages
+     */
+    PdfPage* AppendPage( const PdfPageBuffer & rBuffer );
+
+    /** Paint several pages on several threads and append them to the document.
+     *
+     *  The pages are painted by pGenerator onto PdfPageBuffers, several
+     *  pages at once on nThreads threads. The calling thread appends the
+     *  finished pages in order using AppendPage() and flushes them 
+     *  using FlushPage(), so that at most nWindow pages are kept 
+     *  in memory at a time.
+     *
+     *  pGenerator must not access the document except for using fonts, images
+     *  and other objects created before on its PdfPageBuffer. The font size
+     *  and all other settings of fonts shared by the threads must not be changed
+     *  by pGenerator, use one PdfFont object for every setting instead.
+     *
+     *  If pGenerator throws a PdfError on any thread, no further pages are
+     *  appended and the error is thrown again on the calling thread.
+     *
+     *  \param nCount the number of pages to create
+     *  \param rSize the initial size of every page, pGenerator may change it
+     *                using PdfPageBuffer::SetPageSize()
+     *  \param pGenerator paints a single page, called on several threads at once
+     *  \param pData passed to every call of pGenerator
+     *  \param nThreads number of threads, 0 uses one thread per CPU
+     *  \param nWindow number of pages painted before they are appended,
+     *                 0 uses 4 pages per thread
+     */
+    void GeneratePages( int nCount, const PdfRect & rSize, PdfPageGenerator pGenerator, 
+                        void* pData, int nThreads = 0, int nWindow = 0 );
+
     /** Get the write mode used for wirting the PDF
      *  \returns the write mode
      */
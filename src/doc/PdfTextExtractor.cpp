@@ -0,0 +1,958 @@
+/***************************************************************************
+ *   Copyright (C) 2007 by Dominik Seichter                                *
+ *   domseichter@web.de                                                    *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Library General Public License as       *
+ *   published by the Free Software Foundation; either version 2 of the    *
+ *   License, or (at your option) any later version.                       *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this program; if not, write to the                 *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#include "PdfTextExtractor.h"
+
+#include "base/PdfDefinesPrivate.h"
+
+#include "base/PdfArray.h"
+#include "base/PdfContentsParser.h"
+#include "base/PdfDictionary.h"
+#include "base/PdfFilter.h"
+#include "base/PdfName.h"
+#include "base/PdfObject.h"
+#include "base/PdfOutputStream.h"
+#include "base/PdfStream.h"
+#include "base/PdfVecObjects.h"
+#include "base/util/PdfMutexWrapper.h"
+#include "base/util/PdfThreads.h"
+
+#include "PdfDocument.h"
+#include "PdfPage.h"
+#include "PdfTextFont.h"
+
+#include <math.h>
+
+namespace PoDoFo {
+
+/** Forms invoking forms are followed up to this depth
+ */
+static const int s_nMaxFormDepth = 16;
+
+/** The font of a graphics state parameter dictionary
+ */
+struct TTextGState {
+    const PdfTextFont* pFont;
+    double             dFontSize;
+};
+
+/** Everything of a resource dictionary that is needed for text extraction
+ */
+struct TTextResources {
+    std::map<PdfName, const PdfTextFont*> mapFonts;
+    std::map<PdfName, TTextForm*>         mapForms;
+    std::map<PdfName, TTextGState>        mapGStates;
+};
+
+/** A decoded form XObject
+ */
+struct TTextForm {
+    double          adMatrix[6];
+    char*           pData;        ///< The decoded content stream, allocated with podofo_malloc
+    pdf_long        lLen;
+    TTextResources* pResources;   ///< NULL if the form uses the resources of the page
+};
+
+/** A content stream of a page, which is decoded by a worker thread
+ */
+struct TTextContents {
+    PdfRefCountedBuffer raw;
+    pdf_long            lLen;
+    TVecFilters         vecFilters;
+    PdfDictionary       dict;         ///< Copy of the stream dictionary for the DecodeParms
+};
+
+/** A page whose text is extracted by a worker thread
+ */
+struct TTextPageJob {
+    std::vector<TTextContents> vecContents;
+    TTextResources*            pResources;
+    PdfTextPage*               pText;
+    bool                       bFailed;
+    PdfError                   error;
+};
+
+/** The jobs shared by all threads, each thread
+ *  takes the next job until all jobs are done.
+ */
+struct TTextJobQueue {
+    std::vector<TTextPageJob*>* pJobs;
+    size_t                      nNext;
+    Util::PdfMutex              mutex;
+};
+
+/** Multiply two matrices [a b c d e f], pdResult = pdLeft x pdRight.
+ *  pdResult may be the same as pdLeft or pdRight.
+ */
+static void MultiplyMatrix( const double* pdLeft, const double* pdRight, double* pdResult )
+{
+    double a = pdLeft[0] * pdRight[0] + pdLeft[1] * pdRight[2];
+    double b = pdLeft[0] * pdRight[1] + pdLeft[1] * pdRight[3];
+    double c = pdLeft[2] * pdRight[0] + pdLeft[3] * pdRight[2];
+    double d = pdLeft[2] * pdRight[1] + pdLeft[3] * pdRight[3];
+    double e = pdLeft[4] * pdRight[0] + pdLeft[5] * pdRight[2] + pdRight[4];
+    double f = pdLeft[4] * pdRight[1] + pdLeft[5] * pdRight[3] + pdRight[5];
+
+    pdResult[0] = a;
+    pdResult[1] = b;
+    pdResult[2] = c;
+    pdResult[3] = d;
+    pdResult[4] = e;
+    pdResult[5] = f;
+}
+
+static void SetIdentity( double* pdMatrix )
+{
+    pdMatrix[0] = 1.0;
+    pdMatrix[1] = 0.0;
+    pdMatrix[2] = 0.0;
+    pdMatrix[3] = 1.0;
+    pdMatrix[4] = 0.0;
+    pdMatrix[5] = 0.0;
+}
+
+/** Get the last nCount operands of an operator as numbers.
+ *
+ *  \returns false if there are not enough operands or if one is not a number
+ */
+static bool GetNumbers( const PdfContentsOperand* pOperands, int nOperands, int nCount, double* pdValues )
+{
+    if( nOperands < nCount )
+        return false;
+
+    pOperands += nOperands - nCount;
+    for( int i = 0; i < nCount; i++ )
+    {
+        if( !pOperands[i].IsNumber() )
+            return false;
+
+        pdValues[i] = pOperands[i].GetReal();
+    }
+
+    return true;
+}
+
+// -----------------------------------------------------
+// PdfTextHandler
+// -----------------------------------------------------
+
+/** Follows the text state of a content stream
+ *  and adds all glyphs to a PdfTextPage.
+ */
+class PdfTextHandler : public PdfContentsHandler {
+ public:
+    PdfTextHandler( PdfTextPage* pText, TTextResources* pResources );
+
+    virtual void HandleOperator( EPdfContentsOperator eOperator,
+                                 const PdfContentsOperand* pOperands, int nOperands );
+
+ private:
+    /** The parts of the graphics state that are needed for text
+     */
+    struct TState {
+        double             adCTM[6];
+        const PdfTextFont* pFont;
+        double             dFontSize;
+        double             dCharSpace;
+        double             dWordSpace;
+        double             dScale;        ///< Tz / 100
+        double             dLeading;
+        double             dRise;
+        int                nRenderMode;
+    };
+
+    void MoveText( double dX, double dY );
+    void ShowString( const PdfContentsOperand & rString, double dAdjustment );
+    void ShowArray( const PdfContentsOperand & rArray );
+    void InvokeForm( const PdfContentsOperand & rName );
+
+ private:
+    PdfTextPage*        m_pText;
+    TTextResources*     m_pResources;
+    int                 m_nFormDepth;
+
+    TState              m_state;
+    std::vector<TState> m_vecStates;      ///< States saved by q
+    double              m_adTm[6];        ///< Text matrix
+    double              m_adTlm[6];       ///< Text line matrix
+
+    std::vector<char>   m_vecString;      ///< Buffer for decoded strings
+};
+
+PdfTextHandler::PdfTextHandler( PdfTextPage* pText, TTextResources* pResources )
+    : m_pText( pText ), m_pResources( pResources ), m_nFormDepth( 0 )
+{
+    SetIdentity( m_state.adCTM );
+    m_state.pFont       = NULL;
+    m_state.dFontSize   = 0.0;
+    m_state.dCharSpace  = 0.0;
+    m_state.dWordSpace  = 0.0;
+    m_state.dScale      = 1.0;
+    m_state.dLeading    = 0.0;
+    m_state.dRise       = 0.0;
+    m_state.nRenderMode = 0;
+
+    SetIdentity( m_adTm );
+    SetIdentity( m_adTlm );
+}
+
+void PdfTextHandler::HandleOperator( EPdfContentsOperator eOperator,
+                                     const PdfContentsOperand* pOperands, int nOperands )
+{
+    double ad[6];
+
+    switch( eOperator )
+    {
+        case ePdfContentsOperator_q:
+            m_vecStates.push_back( m_state );
+            break;
+        case ePdfContentsOperator_Q:
+            if( !m_vecStates.empty() )
+            {
+                m_state = m_vecStates.back();
+                m_vecStates.pop_back();
+            }
+            break;
+        case ePdfContentsOperator_cm:
+            if( GetNumbers( pOperands, nOperands, 6, ad ) )
+                MultiplyMatrix( ad, m_state.adCTM, m_state.adCTM );
+            break;
+
+        case ePdfContentsOperator_BT:
+            SetIdentity( m_adTm );
+            SetIdentity( m_adTlm );
+            break;
+        case ePdfContentsOperator_Tc:
+            if( GetNumbers( pOperands, nOperands, 1, ad ) )
+                m_state.dCharSpace = ad[0];
+            break;
+        case ePdfContentsOperator_Tw:
+            if( GetNumbers( pOperands, nOperands, 1, ad ) )
+                m_state.dWordSpace = ad[0];
+            break;
+        case ePdfContentsOperator_Tz:
+            if( GetNumbers( pOperands, nOperands, 1, ad ) )
+                m_state.dScale = ad[0] / 100.0;
+            break;
+        case ePdfContentsOperator_TL:
+            if( GetNumbers( pOperands, nOperands, 1, ad ) )
+                m_state.dLeading = ad[0];
+            break;
+        case ePdfContentsOperator_Ts:
+            if( GetNumbers( pOperands, nOperands, 1, ad ) )
+                m_state.dRise = ad[0];
+            break;
+        case ePdfContentsOperator_Tr:
+            if( GetNumbers( pOperands, nOperands, 1, ad ) )
+                m_state.nRenderMode = static_cast<int>(ad[0]);
+            break;
+        case ePdfContentsOperator_Tf:
+            if( nOperands >= 2 && pOperands[nOperands - 2].GetType() == ePdfContentsOperandType_Name
+                && pOperands[nOperands - 1].IsNumber() )
+            {
+                std::map<PdfName, const PdfTextFont*>::const_iterator it =
+                    m_pResources->mapFonts.find( pOperands[nOperands - 2].ToName() );
+
+                m_state.pFont     = it != m_pResources->mapFonts.end() ? (*it).second : NULL;
+                m_state.dFontSize = pOperands[nOperands - 1].GetReal();
+            }
+            break;
+        case ePdfContentsOperator_gs:
+            if( nOperands >= 1 && pOperands[nOperands - 1].GetType() == ePdfContentsOperandType_Name )
+            {
+                std::map<PdfName, TTextGState>::const_iterator it =
+                    m_pResources->mapGStates.find( pOperands[nOperands - 1].ToName() );
+
+                if( it != m_pResources->mapGStates.end() )
+                {
+                    m_state.pFont     = (*it).second.pFont;
+                    m_state.dFontSize = (*it).second.dFontSize;
+                }
+            }
+            break;
+
+        case ePdfContentsOperator_Td:
+            if( GetNumbers( pOperands, nOperands, 2, ad ) )
+                this->MoveText( ad[0], ad[1] );
+            break;
+        case ePdfContentsOperator_TD:
+            if( GetNumbers( pOperands, nOperands, 2, ad ) )
+            {
+                m_state.dLeading = -ad[1];
+                this->MoveText( ad[0], ad[1] );
+            }
+            break;
+        case ePdfContentsOperator_Tm:
+            if( GetNumbers( pOperands, nOperands, 6, ad ) )
+            {
+                memcpy( m_adTm, ad, sizeof(m_adTm) );
+                memcpy( m_adTlm, ad, sizeof(m_adTlm) );
+            }
+            break;
+        case ePdfContentsOperator_TStar:
+            this->MoveText( 0.0, -m_state.dLeading );
+            break;
+
+        case ePdfContentsOperator_Tj:
+            if( nOperands >= 1 )
+                this->ShowString( pOperands[nOperands - 1], 0.0 );
+            break;
+        case ePdfContentsOperator_TJ:
+            if( nOperands >= 1 && pOperands[nOperands - 1].GetType() == ePdfContentsOperandType_Array )
+                this->ShowArray( pOperands[nOperands - 1] );
+            break;
+        case ePdfContentsOperator_Quote:
+            this->MoveText( 0.0, -m_state.dLeading );
+            if( nOperands >= 1 )
+                this->ShowString( pOperands[nOperands - 1], 0.0 );
+            break;
+        case ePdfContentsOperator_DoubleQuote:
+            if( nOperands >= 3 && GetNumbers( pOperands, nOperands - 1, 2, ad ) )
+            {
+                m_state.dWordSpace = ad[0];
+                m_state.dCharSpace = ad[1];
+                this->MoveText( 0.0, -m_state.dLeading );
+                this->ShowString( pOperands[nOperands - 1], 0.0 );
+            }
+            break;
+
+        case ePdfContentsOperator_Do:
+            if( nOperands >= 1 && pOperands[nOperands - 1].GetType() == ePdfContentsOperandType_Name )
+                this->InvokeForm( pOperands[nOperands - 1] );
+            break;
+
+        // Operators which neither change the text state nor show text
+        // Path construction and painting, clipping
+        case ePdfContentsOperator_m: case ePdfContentsOperator_l: case ePdfContentsOperator_c:
+        case ePdfContentsOperator_v: case ePdfContentsOperator_y: case ePdfContentsOperator_h:
+        case ePdfContentsOperator_re: case ePdfContentsOperator_s: case ePdfContentsOperator_S:
+        case ePdfContentsOperator_f: case ePdfContentsOperator_F: case ePdfContentsOperator_fStar:
+        case ePdfContentsOperator_B: case ePdfContentsOperator_BStar: case ePdfContentsOperator_b:
+        case ePdfContentsOperator_bStar: case ePdfContentsOperator_n: case ePdfContentsOperator_W:
+        case ePdfContentsOperator_WStar: case ePdfContentsOperator_sh:
+        // Graphics state and colors
+        case ePdfContentsOperator_w: case ePdfContentsOperator_J: case ePdfContentsOperator_j:
+        case ePdfContentsOperator_M: case ePdfContentsOperator_d: case ePdfContentsOperator_ri:
+        case ePdfContentsOperator_i: case ePdfContentsOperator_CS: case ePdfContentsOperator_cs:
+        case ePdfContentsOperator_SC: case ePdfContentsOperator_SCN: case ePdfContentsOperator_sc:
+        case ePdfContentsOperator_scn: case ePdfContentsOperator_G: case ePdfContentsOperator_g:
+        case ePdfContentsOperator_RG: case ePdfContentsOperator_rg: case ePdfContentsOperator_K:
+        case ePdfContentsOperator_k:
+        // Text objects, inline images, marked content and Type 3 glyphs
+        case ePdfContentsOperator_ET: case ePdfContentsOperator_BI: case ePdfContentsOperator_ID:
+        case ePdfContentsOperator_EI: case ePdfContentsOperator_BMC: case ePdfContentsOperator_BDC:
+        case ePdfContentsOperator_EMC: case ePdfContentsOperator_MP: case ePdfContentsOperator_DP:
+        case ePdfContentsOperator_BX: case ePdfContentsOperator_EX: case ePdfContentsOperator_d0:
+        case ePdfContentsOperator_d1: case ePdfContentsOperator_Unknown:
+            break;
+    }
+}
+
+void PdfTextHandler::MoveText( double dX, double dY )
+{
+    // Tlm = [1 0 0 1 dX dY] x Tlm
+    m_adTlm[4] += dX * m_adTlm[0] + dY * m_adTlm[2];
+    m_adTlm[5] += dX * m_adTlm[1] + dY * m_adTlm[3];
+    memcpy( m_adTm, m_adTlm, sizeof(m_adTm) );
+}
+
+void PdfTextHandler::ShowArray( const PdfContentsOperand & rArray )
+{
+    PdfContentsOperand element;
+    pdf_long           lPos        = 0;
+    double             dAdjustment = 0.0;
+
+    // Numbers move the next string, see PDF Reference 1.7, 5.3.2
+    while( rArray.GetNextElement( lPos, element ) )
+    {
+        if( element.IsNumber() )
+            dAdjustment += element.GetReal();
+        else if( element.GetType() == ePdfContentsOperandType_String ||
+                 element.GetType() == ePdfContentsOperandType_HexString )
+        {
+            this->ShowString( element, dAdjustment );
+            dAdjustment = 0.0;
+        }
+    }
+
+    if( dAdjustment != 0.0 )
+        this->ShowString( PdfContentsOperand(), dAdjustment );
+}
+
+void PdfTextHandler::ShowString( const PdfContentsOperand & rString, double dAdjustment )
+{
+    const PdfTextFont* pFont     = m_state.pFont;
+    double             dSize     = m_state.dFontSize;
+    double             dScale    = m_state.dScale;
+    bool               bVertical = pFont && pFont->IsVertical();
+    double             dPos      = 0.0;   // Position along the writing direction in text space
+    double             adM[6];
+
+    if( dAdjustment != 0.0 )
+        dPos -= bVertical ? dAdjustment / 1000.0 * dSize : dAdjustment / 1000.0 * dSize * dScale;
+
+    pdf_long lLen = 0;
+    if( rString.GetType() == ePdfContentsOperandType_String ||
+        rString.GetType() == ePdfContentsOperandType_HexString )
+    {
+        if( static_cast<pdf_long>(m_vecString.size()) < rString.GetLength() + 1 )
+            m_vecString.resize( rString.GetLength() + 1 );
+
+        lLen = rString.DecodeString( &m_vecString[0] );
+    }
+
+    if( pFont && lLen )
+    {
+        // Text space to user space: M = Tm x CTM
+        MultiplyMatrix( m_adTm, m_state.adCTM, adM );
+
+        PdfTextPage::TRun run;
+        run.pFont       = pFont;
+        run.dFontSize   = fabs( dSize ) * sqrt( adM[2] * adM[2] + adM[3] * adM[3] );
+        run.nRenderMode = m_state.nRenderMode;
+        run.nFirstGlyph = m_pText->m_vecGlyphs.size();
+        run.nTextOffset = static_cast<pdf_uint32>(m_pText->m_sText.size());
+
+        double dFirstX = bVertical ? 0.0 : dPos;
+        double dFirstY = bVertical ? dPos + m_state.dRise : m_state.dRise;
+        run.dX = dFirstX * adM[0] + dFirstY * adM[2] + adM[4];
+        run.dY = dFirstX * adM[1] + dFirstY * adM[3] + adM[5];
+
+        double dLeft   = 0.0;
+        double dBottom = 0.0;
+        double dRight  = 0.0;
+        double dTop    = 0.0;
+
+        const char* pszCur = &m_vecString[0];
+        const char* pszEnd = pszCur + lLen;
+        while( pszCur < pszEnd )
+        {
+            pdf_uint32 nCode;
+            int        nBytes = pFont->ReadCode( pszCur, pszEnd - pszCur, nCode );
+            double     dWidth = pFont->GetWidth( nCode );
+
+            // The box of the glyph in text space
+            double dX0, dX1, dY0, dY1, dAdvance;
+            if( bVertical )
+            {
+                dX0      = -dWidth / 2.0 * dSize * dScale;
+                dX1      = -dX0;
+                dY0      = dPos + m_state.dRise + (pFont->GetDescent() - pFont->GetVerticalOrigin()) * dSize;
+                dY1      = dPos + m_state.dRise + (pFont->GetAscent() - pFont->GetVerticalOrigin()) * dSize;
+                dAdvance = pFont->GetVerticalAdvance() * dSize + m_state.dCharSpace;
+            }
+            else
+            {
+                dX0      = dPos;
+                dX1      = dPos + dWidth * dSize * dScale;
+                dY0      = m_state.dRise + pFont->GetDescent() * dSize;
+                dY1      = m_state.dRise + pFont->GetAscent() * dSize;
+                dAdvance = (dWidth * dSize + m_state.dCharSpace) * dScale;
+            }
+
+            // Word spacing applies to the single byte code 32 only
+            if( nBytes == 1 && nCode == 32 )
+                dAdvance += bVertical ? m_state.dWordSpace : m_state.dWordSpace * dScale;
+
+            // Transform all four corners into user space
+            double adX[4];
+            double adY[4];
+            adX[0] = dX0 * adM[0] + dY0 * adM[2];
+            adY[0] = dX0 * adM[1] + dY0 * adM[3];
+            adX[1] = dX1 * adM[0] + dY0 * adM[2];
+            adY[1] = dX1 * adM[1] + dY0 * adM[3];
+            adX[2] = dX0 * adM[0] + dY1 * adM[2];
+            adY[2] = dX0 * adM[1] + dY1 * adM[3];
+            adX[3] = dX1 * adM[0] + dY1 * adM[2];
+            adY[3] = dX1 * adM[1] + dY1 * adM[3];
+
+            double dGlyphLeft   = PDF_MIN( PDF_MIN( adX[0], adX[1] ), PDF_MIN( adX[2], adX[3] ) ) + adM[4];
+            double dGlyphRight  = PDF_MAX( PDF_MAX( adX[0], adX[1] ), PDF_MAX( adX[2], adX[3] ) ) + adM[4];
+            double dGlyphBottom = PDF_MIN( PDF_MIN( adY[0], adY[1] ), PDF_MIN( adY[2], adY[3] ) ) + adM[5];
+            double dGlyphTop    = PDF_MAX( PDF_MAX( adY[0], adY[1] ), PDF_MAX( adY[2], adY[3] ) ) + adM[5];
+
+            if( pszCur == &m_vecString[0] )
+            {
+                dLeft   = dGlyphLeft;
+                dBottom = dGlyphBottom;
+                dRight  = dGlyphRight;
+                dTop    = dGlyphTop;
+            }
+            else
+            {
+                dLeft   = PDF_MIN( dLeft, dGlyphLeft );
+                dBottom = PDF_MIN( dBottom, dGlyphBottom );
+                dRight  = PDF_MAX( dRight, dGlyphRight );
+                dTop    = PDF_MAX( dTop, dGlyphTop );
+            }
+
+            PdfTextPage::TGlyph glyph;
+            glyph.nCode       = nCode;
+            glyph.nTextOffset = static_cast<pdf_uint32>(m_pText->m_sText.size());
+            pFont->AppendText( nCode, m_pText->m_sText );
+            glyph.nTextLength = static_cast<pdf_uint32>(m_pText->m_sText.size()) - glyph.nTextOffset;
+            glyph.bbox        = PdfRect( dGlyphLeft, dGlyphBottom, dGlyphRight - dGlyphLeft, dGlyphTop - dGlyphBottom );
+            m_pText->m_vecGlyphs.push_back( glyph );
+
+            dPos   += dAdvance;
+            pszCur += nBytes;
+        }
+
+        double dEndX = bVertical ? 0.0 : dPos;
+        double dEndY = bVertical ? dPos + m_state.dRise : m_state.dRise;
+        run.dEndX       = dEndX * adM[0] + dEndY * adM[2] + adM[4];
+        run.dEndY       = dEndX * adM[1] + dEndY * adM[3] + adM[5];
+        run.bbox        = PdfRect( dLeft, dBottom, dRight - dLeft, dTop - dBottom );
+        run.nGlyphCount = m_pText->m_vecGlyphs.size() - run.nFirstGlyph;
+        run.nTextLength = static_cast<pdf_uint32>(m_pText->m_sText.size()) - run.nTextOffset;
+        m_pText->m_vecRuns.push_back( run );
+    }
+
+    // Tm = [1 0 0 1 tx ty] x Tm
+    if( bVertical )
+    {
+        m_adTm[4] += dPos * m_adTm[2];
+        m_adTm[5] += dPos * m_adTm[3];
+    }
+    else
+    {
+        m_adTm[4] += dPos * m_adTm[0];
+        m_adTm[5] += dPos * m_adTm[1];
+    }
+}
+
+void PdfTextHandler::InvokeForm( const PdfContentsOperand & rName )
+{
+    std::map<PdfName, TTextForm*>::const_iterator it = m_pResources->mapForms.find( rName.ToName() );
+    if( it == m_pResources->mapForms.end() || m_nFormDepth >= s_nMaxFormDepth )
+        return;
+
+    TTextForm*      pForm      = (*it).second;
+    TTextResources* pResources = m_pResources;
+    TState          state      = m_state;
+    size_t          nStates    = m_vecStates.size();
+    double          adTm[6];
+    double          adTlm[6];
+
+    memcpy( adTm, m_adTm, sizeof(adTm) );
+    memcpy( adTlm, m_adTlm, sizeof(adTlm) );
+
+    MultiplyMatrix( pForm->adMatrix, m_state.adCTM, m_state.adCTM );
+    if( pForm->pResources )
+        m_pResources = pForm->pResources;
+    ++m_nFormDepth;
+
+    try {
+        PdfContentsParser parser( pForm->pData, pForm->lLen );
+        parser.Parse( *this );
+    } catch( PdfError & e ) {
+        m_pResources = pResources;
+        --m_nFormDepth;
+
+        e.AddToCallstack( __FILE__, __LINE__ );
+        throw e;
+    }
+
+    // A form always leaves the graphics state as it was
+    m_pResources = pResources;
+    m_state      = state;
+    m_vecStates.resize( nStates );
+    memcpy( m_adTm, adTm, sizeof(adTm) );
+    memcpy( m_adTlm, adTlm, sizeof(adTlm) );
+    --m_nFormDepth;
+}
+
+// -----------------------------------------------------
+// PdfTextPage
+// -----------------------------------------------------
+PdfTextPage::PdfTextPage()
+{
+}
+
+void PdfTextPage::Clear()
+{
+    m_vecRuns.clear();
+    m_vecGlyphs.clear();
+    m_sText.clear();
+}
+
+// -----------------------------------------------------
+// Worker threads
+// -----------------------------------------------------
+static TTextPageJob* NextTextJob( TTextJobQueue* pQueue )
+{
+    Util::PdfMutexWrapper wrapper( pQueue->mutex );
+
+    if( pQueue->nNext < pQueue->pJobs->size() )
+        return (*pQueue->pJobs)[pQueue->nNext++];
+
+    return NULL;
+}
+
+static void RunTextJob( TTextPageJob* pJob )
+{
+    // Decode all streams into one buffer, separated by whitespace,
+    // like PdfContentsParser does for a PdfCanvas
+    PdfRefCountedBuffer   buffer;
+    PdfBufferOutputStream stream( &buffer );
+
+    for( size_t i = 0; i < pJob->vecContents.size(); i++ )
+    {
+        TTextContents & rContents = pJob->vecContents[i];
+
+        if( i )
+            stream.Write( "\n", 1 );
+
+        if( rContents.vecFilters.empty() )
+            stream.Write( rContents.raw.GetBuffer(), rContents.lLen );
+        else
+        {
+            std::auto_ptr<PdfOutputStream> pDecodeStream( PdfFilterFactory::CreateDecodeStream( rContents.vecFilters, &stream, &(rContents.dict) ) );
+
+            pDecodeStream->Write( rContents.raw.GetBuffer(), rContents.lLen );
+            pDecodeStream->Close();
+        }
+
+        // The raw data is not needed anymore
+        rContents.raw = PdfRefCountedBuffer();
+    }
+    stream.Close();
+
+    PdfTextHandler    handler( pJob->pText, pJob->pResources );
+    PdfContentsParser parser( buffer.GetBuffer(), stream.GetLength() );
+
+    parser.Parse( handler );
+}
+
+static void TextWorker( void* pData )
+{
+    TTextJobQueue* pQueue = static_cast<TTextJobQueue*>(pData);
+    TTextPageJob*  pJob;
+
+    while( (pJob = NextTextJob( pQueue )) )
+    {
+        try {
+            RunTextJob( pJob );
+        } catch( const PdfError & e ) {
+            pJob->bFailed = true;
+            pJob->error   = e;
+        }
+    }
+}
+
+static void FreeTextJobs( std::vector<TTextPageJob*> & rJobs )
+{
+    for( size_t i = 0; i < rJobs.size(); i++ )
+        delete rJobs[i];
+
+    rJobs.clear();
+}
+
+// -----------------------------------------------------
+// PdfTextExtractor
+// -----------------------------------------------------
+PdfTextExtractor::PdfTextExtractor( PdfDocument* pDocument )
+    : m_pDocument( pDocument )
+{
+    if( !pDocument )
+    {
+        PODOFO_RAISE_ERROR( ePdfError_InvalidHandle );
+    }
+}
+
+PdfTextExtractor::~PdfTextExtractor()
+{
+    this->ClearCache();
+}
+
+void PdfTextExtractor::ClearCache()
+{
+    std::map<const PdfObject*, PdfTextFont*>::iterator itFonts = m_mapFonts.begin();
+    while( itFonts != m_mapFonts.end() )
+    {
+        delete (*itFonts).second;
+        ++itFonts;
+    }
+
+    std::map<const PdfObject*, TTextForm*>::iterator itForms = m_mapForms.begin();
+    while( itForms != m_mapForms.end() )
+    {
+        if( (*itForms).second )
+        {
+            podofo_free( (*itForms).second->pData );
+            delete (*itForms).second;
+        }
+
+        ++itForms;
+    }
+
+    std::map<const PdfObject*, TTextResources*>::iterator itResources = m_mapResources.begin();
+    while( itResources != m_mapResources.end() )
+    {
+        delete (*itResources).second;
+        ++itResources;
+    }
+
+    m_mapFonts.clear();
+    m_mapForms.clear();
+    m_mapResources.clear();
+}
+
+void PdfTextExtractor::ExtractText( PdfPage* pPage, PdfTextPage & rText )
+{
+    TTextPageJob job;
+
+    if( !pPage )
+    {
+        PODOFO_RAISE_ERROR( ePdfError_InvalidHandle );
+    }
+
+    rText.Clear();
+    job.pText   = &rText;
+    job.bFailed = false;
+
+    this->PrepareJob( pPage, &job );
+    RunTextJob( &job );
+}
+
+void PdfTextExtractor::ExtractText( int nFirst, int nCount, std::vector<PdfTextPage> & rvecText, int nThreads )
+{
+    std::vector<TTextPageJob*> vecJobs;
+    TTextJobQueue              queue;
+
+    if( nFirst < 0 || nCount < 0 || nFirst + nCount > m_pDocument->GetPageCount() )
+    {
+        PODOFO_RAISE_ERROR( ePdfError_ValueOutOfRange );
+    }
+
+    if( nThreads <= 0 )
+        nThreads = Util::GetCPUCount();
+
+    rvecText.clear();
+    rvecText.resize( nCount );
+
+    try {
+        for( int i = 0; i < nCount; i++ )
+        {
+            TTextPageJob* pJob = new TTextPageJob();
+            pJob->pText   = &rvecText[i];
+            pJob->bFailed = false;
+            vecJobs.push_back( pJob );
+
+            PdfPage* pPage = m_pDocument->GetPage( nFirst + i );
+            if( !pPage )
+            {
+                PODOFO_RAISE_ERROR( ePdfError_PageNotFound );
+            }
+
+            this->PrepareJob( pPage, pJob );
+        }
+
+        queue.pJobs = &vecJobs;
+        queue.nNext = 0;
+        Util::RunOnThreads( TextWorker, &queue, static_cast<int>(PDF_MIN( static_cast<size_t>(nThreads), vecJobs.size() )) );
+
+        for( size_t i = 0; i < vecJobs.size(); i++ )
+        {
+            if( vecJobs[i]->bFailed )
+                throw vecJobs[i]->error;
+        }
+    } catch( PdfError & e ) {
+        FreeTextJobs( vecJobs );
+        e.AddToCallstack( __FILE__, __LINE__ );
+        throw e;
+    }
+
+    FreeTextJobs( vecJobs );
+}
+
+void PdfTextExtractor::PrepareJob( PdfPage* pPage, TTextPageJob* pJob )
+{
+    // Collect the content streams like PdfContentsParser does
+    std::vector<PdfObject*> vecContents;
+    PdfObject*              pContents = pPage->GetContents();
+    if( pContents && pContents->IsArray() )
+    {
+        PdfArray & rArray = pContents->GetArray();
+        for( PdfArray::iterator it = rArray.begin(); it != rArray.end(); ++it )
+        {
+            PdfObject* pObject = (*it).IsReference() ? pContents->GetOwner()->GetObject( (*it).GetReference() ) : NULL;
+            if( pObject && pObject->HasStream() )
+                vecContents.push_back( pObject );
+        }
+    }
+    else if( pContents && pContents->HasStream() )
+        vecContents.push_back( pContents );
+
+    pJob->vecContents.resize( vecContents.size() );
+    for( size_t i = 0; i < vecContents.size(); i++ )
+    {
+        TTextContents &       rContents = pJob->vecContents[i];
+        PdfBufferOutputStream stream( &rContents.raw );
+
+        vecContents[i]->GetStream()->GetCopy( &stream );
+        stream.Close();
+
+        rContents.lLen       = stream.GetLength();
+        rContents.vecFilters = PdfFilterFactory::CreateFilterList( vecContents[i] );
+        if( !rContents.vecFilters.empty() )
+            rContents.dict = vecContents[i]->GetDictionary();
+    }
+
+    pJob->pResources = this->GetResources( pPage->GetResources() );
+}
+
+TTextResources* PdfTextExtractor::GetResources( PdfObject* pResources )
+{
+    std::map<const PdfObject*, TTextResources*>::iterator itCached = m_mapResources.find( pResources );
+    if( itCached != m_mapResources.end() )
+        return (*itCached).second;
+
+    TTextResources* pTextResources = new TTextResources();
+    m_mapResources[pResources] = pTextResources;
+
+    if( !pResources || !pResources->IsDictionary() )
+        return pTextResources;
+
+    PdfObject* pFonts = pResources->GetIndirectKey( "Font" );
+    if( pFonts && pFonts->IsDictionary() )
+    {
+        TCIKeyMap it = pFonts->GetDictionary().GetKeys().begin();
+        while( it != pFonts->GetDictionary().GetKeys().end() )
+        {
+            pTextResources->mapFonts[(*it).first] = this->GetFont( pFonts->GetIndirectKey( (*it).first ) );
+            ++it;
+        }
+    }
+
+    PdfObject* pGStates = pResources->GetIndirectKey( "ExtGState" );
+    if( pGStates && pGStates->IsDictionary() )
+    {
+        TCIKeyMap it = pGStates->GetDictionary().GetKeys().begin();
+        while( it != pGStates->GetDictionary().GetKeys().end() )
+        {
+            // The font entry is an array of a font and a size
+            PdfObject* pGState = pGStates->GetIndirectKey( (*it).first );
+            PdfObject* pFont   = pGState && pGState->IsDictionary() ? pGState->GetIndirectKey( "Font" ) : NULL;
+
+            if( pFont && pFont->IsArray() && pFont->GetArray().GetSize() == 2
+                && pFont->GetArray()[0].IsReference() && pFont->GetArray()[1].IsNumber() )
+            {
+                TTextGState gstate;
+                gstate.pFont     = this->GetFont( pResources->GetOwner()->GetObject( pFont->GetArray()[0].GetReference() ) );
+                gstate.dFontSize = pFont->GetArray()[1].GetReal();
+                pTextResources->mapGStates[(*it).first] = gstate;
+            }
+
+            ++it;
+        }
+    }
+
+    PdfObject* pXObjects = pResources->GetIndirectKey( "XObject" );
+    if( pXObjects && pXObjects->IsDictionary() )
+    {
+        TCIKeyMap it = pXObjects->GetDictionary().GetKeys().begin();
+        while( it != pXObjects->GetDictionary().GetKeys().end() )
+        {
+            TTextForm* pForm = this->GetForm( pXObjects->GetIndirectKey( (*it).first ) );
+            if( pForm )
+                pTextResources->mapForms[(*it).first] = pForm;
+
+            ++it;
+        }
+    }
+
+    return pTextResources;
+}
+
+const PdfTextFont* PdfTextExtractor::GetFont( PdfObject* pFont )
+{
+    if( !pFont )
+        return NULL;
+
+    std::map<const PdfObject*, PdfTextFont*>::iterator it = m_mapFonts.find( pFont );
+    if( it != m_mapFonts.end() )
+        return (*it).second;
+
+    PdfTextFont* pTextFont = NULL;
+    try {
+        pTextFont = new PdfTextFont( pFont );
+    } catch( const PdfError & ) {
+        // Text in this font is skipped
+        PdfError::LogMessage( eLogSeverity_Warning, "Cannot decode the font in object %i %i R for text extraction\n",
+                              pFont->Reference().ObjectNumber(), pFont->Reference().GenerationNumber() );
+    }
+
+    m_mapFonts[pFont] = pTextFont;
+    return pTextFont;
+}
+
+TTextForm* PdfTextExtractor::GetForm( PdfObject* pXObject )
+{
+    if( !pXObject )
+        return NULL;
+
+    std::map<const PdfObject*, TTextForm*>::iterator it = m_mapForms.find( pXObject );
+    if( it != m_mapForms.end() )
+        return (*it).second;
+
+    // Insert the form before reading its resources, so that forms
+    // which invoke themselves are not read again
+    m_mapForms[pXObject] = NULL;
+
+    PdfObject* pSubtype = pXObject->IsDictionary() ? pXObject->GetIndirectKey( PdfName::KeySubtype ) : NULL;
+    if( !pSubtype || !pSubtype->IsName() || pSubtype->GetName() != PdfName( "Form" ) || !pXObject->HasStream() )
+        return NULL;
+
+    TTextForm* pForm = new TTextForm();
+    pForm->pData      = NULL;
+    pForm->lLen       = 0;
+    pForm->pResources = NULL;
+    SetIdentity( pForm->adMatrix );
+
+    try {
+        pXObject->GetStream()->GetFilteredCopy( &pForm->pData, &pForm->lLen );
+    } catch( const PdfError & ) {
+        PdfError::LogMessage( eLogSeverity_Warning, "Cannot decode the form XObject in object %i %i R for text extraction\n",
+                              pXObject->Reference().ObjectNumber(), pXObject->Reference().GenerationNumber() );
+        delete pForm;
+        return NULL;
+    }
+
+    m_mapForms[pXObject] = pForm;
+
+    PdfObject* pMatrix = pXObject->GetIndirectKey( "Matrix" );
+    if( pMatrix && pMatrix->IsArray() && pMatrix->GetArray().GetSize() == 6 )
+    {
+        for( int i = 0; i < 6; i++ )
+        {
+            if( pMatrix->GetArray()[i].IsReal() || pMatrix->GetArray()[i].IsNumber() )
+                pForm->adMatrix[i] = pMatrix->GetArray()[i].GetReal();
+        }
+    }
+
+    PdfObject* pResources = pXObject->GetIndirectKey( "Resources" );
+    if( pResources )
+        pForm->pResources = this->GetResources( pResources );
+
+    return pForm;
+}
+
+};
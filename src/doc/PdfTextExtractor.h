@@ -0,0 +1,229 @@
+/***************************************************************************
+ *   Copyright (C) 2007 by Dominik Seichter                                *
+ *   domseichter@web.de                                                    *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Library General Public License as       *
+ *   published by the Free Software Foundation; either version 2 of the    *
+ *   License, or (at your option) any later version.                       *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this program; if not, write to the                 *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#ifndef _PDF_TEXT_EXTRACTOR_H_
+#define _PDF_TEXT_EXTRACTOR_H_
+
+#include "podofo/base/PdfDefines.h"
+#include "podofo/base/PdfRect.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace PoDoFo {
+
+class PdfDocument;
+class PdfObject;
+class PdfPage;
+class PdfTextFont;
+
+struct TTextForm;
+struct TTextPageJob;
+struct TTextResources;
+
+/**
+ * The text of a single page as found by PdfTextExtractor.
+ *
+ * Every string operand of the text showing operators Tj, TJ, ' and "
+ * becomes a run of glyphs. Runs and glyphs are stored in the order in
+ * which they appear in the content streams, they are not sorted by
+ * their position on the page. All coordinates are in the default user
+ * space of the page, i.e. after applying the text matrix and the
+ * current transformation matrix, but without the /Rotate of the page.
+ *
+ * The text of all runs is stored as UTF-8 in one string, runs and glyphs
+ * refer to it by offsets, so that a page needs only a few allocations.
+ */
+class PODOFO_DOC_API PdfTextPage {
+    friend class PdfTextHandler;
+
+ public:
+    /** A single glyph.
+     */
+    struct TGlyph {
+        pdf_uint32 nCode;         ///< The character code in the string
+        pdf_uint32 nTextOffset;   ///< Offset of the UTF-8 text of the glyph in GetText()
+        pdf_uint32 nTextLength;   ///< Length of the text, 0 if it is unknown
+        PdfRect    bbox;          ///< The area of the glyph between descent and ascent of the font
+    };
+
+    /** A run of glyphs shown by one string operand.
+     */
+    struct TRun {
+        const PdfTextFont* pFont;         ///< The font, owned by the PdfTextExtractor
+        double             dFontSize;     ///< The font size in user space, i.e. scaled by the text matrix and the CTM
+        double             dX;            ///< The origin of the first glyph on the baseline
+        double             dY;
+        double             dEndX;         ///< The position after the last glyph on the baseline
+        double             dEndY;
+        int                nRenderMode;   ///< The text rendering mode (Tr), 3 is invisible text
+        PdfRect            bbox;          ///< The union of the bounding boxes of all glyphs
+        size_t             nFirstGlyph;   ///< Index of the first glyph in GetGlyphs()
+        size_t             nGlyphCount;
+        pdf_uint32         nTextOffset;   ///< Offset of the UTF-8 text of the run in GetText()
+        pdf_uint32         nTextLength;
+    };
+
+    PdfTextPage();
+
+    /** \returns all runs of glyphs of the page
+     */
+    inline const std::vector<TRun> & GetRuns() const;
+
+    /** \returns all glyphs of all runs
+     */
+    inline const std::vector<TGlyph> & GetGlyphs() const;
+
+    /** \returns the UTF-8 text of all runs, without any separators between runs
+     */
+    inline const std::string & GetText() const;
+
+    /** \param rRun a run of this page
+     *  \returns the UTF-8 text of a run
+     */
+    inline std::string GetText( const TRun & rRun ) const;
+
+    /** Remove all runs, glyphs and text.
+     */
+    void Clear();
+
+ private:
+    std::vector<TRun>   m_vecRuns;
+    std::vector<TGlyph> m_vecGlyphs;
+    std::string         m_sText;
+};
+
+/**
+ * Extracts positioned text from the pages of a document.
+ *
+ * The extractor follows the text state of the content streams:
+ * the text matrix and the text line matrix, the CTM (cm, q and Q),
+ * Tc, Tw, Tz, TL, Ts, Tr and fonts set by Tf or by a graphics state
+ * dictionary (gs). Form XObjects are executed with their own resources.
+ * Fonts are decoded by PdfTextFont and cached by the extractor
+ * for all following pages, as are form XObjects and resource dictionaries.
+ *
+ * Several pages can be extracted at once on several threads:
+ * The calling thread reads the content streams and decodes fonts and
+ * forms, all other work (decoding and parsing the content streams,
+ * positioning the glyphs) is done on one thread per CPU.
+ *
+ * Content streams are parsed with PdfContentsParser.
+ *
+ * \see PdfTextFont
+ */
+class PODOFO_DOC_API PdfTextExtractor {
+ public:
+    /** Create a text extractor for a document.
+     *
+     *  \param pDocument the document, whose objects must
+     *                   not be changed while the extractor is used
+     */
+    PdfTextExtractor( PdfDocument* pDocument );
+
+    ~PdfTextExtractor();
+
+    /** Extract the text of a single page on the calling thread.
+     *
+     *  \param pPage a page of the document
+     *  \param rText the text of the page is stored here
+     */
+    void ExtractText( PdfPage* pPage, PdfTextPage & rText );
+
+    /** Extract the text of several pages on several threads.
+     *
+     *  \param nFirst index of the first page (0-based)
+     *  \param nCount number of pages
+     *  \param rvecText the text of all pages is stored here,
+     *                  the vector is resized to nCount pages
+     *  \param nThreads number of threads, 0 uses one thread per CPU
+     */
+    void ExtractText( int nFirst, int nCount, std::vector<PdfTextPage> & rvecText, int nThreads = 0 );
+
+    /** Free all cached fonts, forms and resources.
+     *  All PdfTextFont pointers in the results become invalid.
+     */
+    void ClearCache();
+
+ private:
+    /** Read the content streams of a page and everything
+     *  that is needed to extract its text.
+     */
+    void PrepareJob( PdfPage* pPage, TTextPageJob* pJob );
+
+    /** \returns the cached resources of a resource dictionary, which are created if necessary
+     */
+    TTextResources* GetResources( PdfObject* pResources );
+
+    /** \returns the cached decoded font of a font dictionary or NULL if the font cannot be decoded
+     */
+    const PdfTextFont* GetFont( PdfObject* pFont );
+
+    /** \returns the cached form XObject or NULL if the XObject is not a form
+     */
+    TTextForm* GetForm( PdfObject* pXObject );
+
+ private:
+    PdfTextExtractor( const PdfTextExtractor & rhs );
+    const PdfTextExtractor & operator=( const PdfTextExtractor & rhs );
+
+    PdfDocument*                                 m_pDocument;
+
+    std::map<const PdfObject*, PdfTextFont*>     m_mapFonts;
+    std::map<const PdfObject*, TTextForm*>       m_mapForms;
+    std::map<const PdfObject*, TTextResources*>  m_mapResources;
+};
+
+// -----------------------------------------------------
+//
+// -----------------------------------------------------
+inline const std::vector<PdfTextPage::TRun> & PdfTextPage::GetRuns() const
+{
+    return m_vecRuns;
+}
+
+// -----------------------------------------------------
+//
+// -----------------------------------------------------
+inline const std::vector<PdfTextPage::TGlyph> & PdfTextPage::GetGlyphs() const
+{
+    return m_vecGlyphs;
+}
+
+// -----------------------------------------------------
+//
+// -----------------------------------------------------
+inline const std::string & PdfTextPage::GetText() const
+{
+    return m_sText;
+}
+
+// -----------------------------------------------------
+//
+// -----------------------------------------------------
+inline std::string PdfTextPage::GetText( const TRun & rRun ) const
+{
+    return m_sText.substr( rRun.nTextOffset, rRun.nTextLength );
+}
+
+};
+
+#endif // _PDF_TEXT_EXTRACTOR_H_
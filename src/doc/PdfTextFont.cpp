@@ -0,0 +1,945 @@
+/***************************************************************************
+ *   Copyright (C) 2007 by Dominik Seichter                                *
+ *   domseichter@web.de                                                    *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Library General Public License as       *
+ *   published by the Free Software Foundation; either version 2 of the    *
+ *   License, or (at your option) any later version.                       *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this program; if not, write to the                 *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#include "PdfTextFont.h"
+
+#include "base/PdfDefinesPrivate.h"
+
+#include "base/PdfArray.h"
+#include "base/PdfContentsTokenizer.h"
+#include "base/PdfDictionary.h"
+#include "base/PdfEncoding.h"
+#include "base/PdfEncodingFactory.h"
+#include "base/PdfObject.h"
+#include "base/PdfStream.h"
+#include "base/PdfVariant.h"
+#include "base/PdfVecObjects.h"
+
+#include "PdfDifferenceEncoding.h"
+#include "PdfFontFactoryBase14Data.h"
+#include "PdfFontMetricsBase14.h"
+
+#include <string.h>
+
+namespace PoDoFo {
+
+#if defined(PODOFO_HAVE_FREETYPE)
+/** Common names of the standard 14 fonts, which are used
+ *  without /Widths by some producers.
+ */
+static const char* s_aStandardFontAliases[][2] = {
+    { "Arial",                          "Helvetica" },
+    { "Arial,Bold",                     "Helvetica-Bold" },
+    { "Arial,Italic",                   "Helvetica-Oblique" },
+    { "Arial,BoldItalic",               "Helvetica-BoldOblique" },
+    { "ArialMT",                        "Helvetica" },
+    { "Arial-BoldMT",                   "Helvetica-Bold" },
+    { "Arial-ItalicMT",                 "Helvetica-Oblique" },
+    { "Arial-BoldItalicMT",             "Helvetica-BoldOblique" },
+    { "TimesNewRoman",                  "Times-Roman" },
+    { "TimesNewRoman,Bold",             "Times-Bold" },
+    { "TimesNewRoman,Italic",           "Times-Italic" },
+    { "TimesNewRoman,BoldItalic",       "Times-BoldItalic" },
+    { "TimesNewRomanPSMT",              "Times-Roman" },
+    { "TimesNewRomanPS-BoldMT",         "Times-Bold" },
+    { "TimesNewRomanPS-ItalicMT",       "Times-Italic" },
+    { "TimesNewRomanPS-BoldItalicMT",   "Times-BoldItalic" },
+    { "CourierNew",                     "Courier" },
+    { "CourierNew,Bold",                "Courier-Bold" },
+    { "CourierNew,Italic",              "Courier-Oblique" },
+    { "CourierNew,BoldItalic",          "Courier-BoldOblique" },
+    { "CourierNewPSMT",                 "Courier" },
+    { "CourierNewPS-BoldMT",            "Courier-Bold" },
+    { "CourierNewPS-ItalicMT",          "Courier-Oblique" },
+    { "CourierNewPS-BoldItalicMT",      "Courier-BoldOblique" },
+    { "Symbol,Bold",                    "Symbol" },
+    { NULL,                             NULL }
+};
+
+/** Find the metrics of a standard 14 font.
+ *
+ *  \param rBaseFont the /BaseFont of a font, optionally with a subset prefix
+ *  \returns the metrics or NULL if this is not a standard 14 font
+ */
+static PdfFontMetricsBase14* FindStandardFont( const PdfName & rBaseFont )
+{
+    const char* pszName = rBaseFont.GetName().c_str();
+
+    // Remove a subset prefix like ABCDEF+
+    if( strlen( pszName ) > 7 && pszName[6] == '+' )
+        pszName += 7;
+
+    for( int i = 0; s_aStandardFontAliases[i][0]; i++ )
+    {
+        if( strcmp( s_aStandardFontAliases[i][0], pszName ) == 0 )
+        {
+            pszName = s_aStandardFontAliases[i][1];
+            break;
+        }
+    }
+
+    // PODOFO_Base14FontDef_FindBuiltinData() is disabled,
+    // so that PdfFontCache does not create base 14 fonts
+    for( int i = 0; PODOFO_BUILTIN_FONTS[i].GetFontname(); i++ )
+    {
+        if( strcmp( PODOFO_BUILTIN_FONTS[i].GetFontname(), pszName ) == 0 )
+            return &PODOFO_BUILTIN_FONTS[i];
+    }
+
+    return NULL;
+}
+#endif // PODOFO_HAVE_FREETYPE
+
+/** Resolve an object which might be a reference.
+ */
+static const PdfObject* Resolve( const PdfObject* pObject, PdfVecObjects* pOwner )
+{
+    if( pObject && pObject->IsReference() && pOwner )
+        return pOwner->GetObject( pObject->GetReference() );
+
+    return pObject;
+}
+
+/** \returns the value of a number, which might be a reference, or dDefault
+ */
+static double GetNumber( const PdfObject* pObject, PdfVecObjects* pOwner, double dDefault )
+{
+    pObject = Resolve( pObject, pOwner );
+    if( pObject && (pObject->IsReal() || pObject->IsNumber()) )
+        return pObject->GetReal();
+
+    return dDefault;
+}
+
+/** Convert a value returned as pdf_utf16be by PdfEncoding::GetCharCode()
+ *  or PdfDifferenceEncoding::NameToUnicodeID() into a Unicode value.
+ */
+static pdf_uint32 FromUtf16BE( pdf_utf16be nValue )
+{
+#ifdef PODOFO_IS_LITTLE_ENDIAN
+    return ((nValue & 0xff00) >> 8) | ((nValue & 0xff) << 8);
+#else
+    return nValue;
+#endif // PODOFO_IS_LITTLE_ENDIAN
+}
+
+/** CMaps use hex strings as well as literal strings.
+ */
+static inline bool IsAnyString( const PdfVariant & rVariant )
+{
+    return rVariant.IsString() || rVariant.IsHexString();
+}
+
+/** Read a character code from the bytes of a string of a CMap.
+ *
+ *  \param rString a hex string
+ *  \returns the code
+ */
+static pdf_uint32 ReadCMapCode( const PdfString & rString )
+{
+    const unsigned char* pszData = reinterpret_cast<const unsigned char*>(rString.GetString());
+    pdf_long             lLen    = PDF_MIN( static_cast<pdf_long>(rString.GetLength()), static_cast<pdf_long>(4) );
+    pdf_uint32           nCode   = 0;
+
+    for( pdf_long i = 0; i < lLen; i++ )
+        nCode = (nCode << 8) | pszData[i];
+
+    return nCode;
+}
+
+/** Everything that is read from a CMap stream.
+ */
+struct TCMapData {
+    TCMapData()
+        : bVertical( false )
+    {
+    }
+
+    /** A bfchar or bfrange entry of a ToUnicode CMap.
+     */
+    struct TUnicodeRange {
+        pdf_uint32 nLow;
+        pdf_uint32 nHigh;
+        PdfVariant destination;   ///< A string, an array of strings or a name
+    };
+
+    std::vector<PdfVariant>    vecCodeSpace;   ///< Low and high bounds alternately
+    std::vector<pdf_uint32>    vecCIDs;        ///< Low code, high code and CID of all cidranges and cidchars
+    std::vector<TUnicodeRange> vecUnicode;
+    PdfName                    useCMap;
+    bool                       bVertical;
+};
+
+/** Read the code space ranges, CID mappings and Unicode mappings of a CMap.
+ *  Broken CMaps are read up to the first error.
+ */
+static void ReadCMap( PdfObject* pCMap, TCMapData & rData )
+{
+    char*    pBuffer = NULL;
+    pdf_long lLen    = 0;
+
+    if( !pCMap || !pCMap->HasStream() )
+        return;
+
+    try {
+        pCMap->GetStream()->GetFilteredCopy( &pBuffer, &lLen );
+
+        PdfContentsTokenizer    tokenizer( pBuffer, lLen );
+        std::vector<PdfVariant> vecOperands;
+        EPdfContentsType        eType;
+        const char*             pszKeyword;
+        PdfVariant              var;
+
+        while( tokenizer.ReadNext( eType, pszKeyword, var ) )
+        {
+            if( eType == ePdfContentsType_Variant )
+            {
+                vecOperands.push_back( var );
+                continue;
+            }
+
+            size_t n = vecOperands.size();
+            if( strcmp( pszKeyword, "endcodespacerange" ) == 0 )
+            {
+                rData.vecCodeSpace.insert( rData.vecCodeSpace.end(), vecOperands.begin(), vecOperands.end() );
+            }
+            else if( strcmp( pszKeyword, "endcidrange" ) == 0 || strcmp( pszKeyword, "endcidchar" ) == 0 )
+            {
+                bool bRange = pszKeyword[6] == 'r';
+                int  nStep  = bRange ? 3 : 2;
+
+                for( size_t i = 0; i + nStep <= n; i += nStep )
+                {
+                    const PdfVariant & rLow  = vecOperands[i];
+                    const PdfVariant & rHigh = vecOperands[bRange ? i + 1 : i];
+                    const PdfVariant & rCID  = vecOperands[i + nStep - 1];
+
+                    if( !IsAnyString( rLow ) || !IsAnyString( rHigh ) || !rCID.IsNumber() )
+                        continue;
+
+                    rData.vecCIDs.push_back( ReadCMapCode( rLow.GetString() ) );
+                    rData.vecCIDs.push_back( ReadCMapCode( rHigh.GetString() ) );
+                    rData.vecCIDs.push_back( static_cast<pdf_uint32>(rCID.GetNumber()) );
+                }
+            }
+            else if( strcmp( pszKeyword, "endbfrange" ) == 0 || strcmp( pszKeyword, "endbfchar" ) == 0 )
+            {
+                bool bRange = pszKeyword[5] == 'r';
+                int  nStep  = bRange ? 3 : 2;
+
+                for( size_t i = 0; i + nStep <= n; i += nStep )
+                {
+                    if( !IsAnyString( vecOperands[i] ) || (bRange && !IsAnyString( vecOperands[i + 1] )) )
+                        continue;
+
+                    TCMapData::TUnicodeRange range;
+                    range.nLow        = ReadCMapCode( vecOperands[i].GetString() );
+                    range.nHigh       = bRange ? ReadCMapCode( vecOperands[i + 1].GetString() ) : range.nLow;
+                    range.destination = vecOperands[i + nStep - 1];
+                    rData.vecUnicode.push_back( range );
+                }
+            }
+            else if( strcmp( pszKeyword, "usecmap" ) == 0 )
+            {
+                if( n && vecOperands[n - 1].IsName() )
+                    rData.useCMap = vecOperands[n - 1].GetName();
+            }
+            else if( strcmp( pszKeyword, "def" ) == 0 )
+            {
+                if( n == 2 && vecOperands[0].IsName() && vecOperands[0].GetName() == PdfName( "WMode" )
+                    && vecOperands[1].IsNumber() )
+                    rData.bVertical = vecOperands[1].GetNumber() == 1;
+            }
+
+            vecOperands.clear();
+        }
+    } catch( const PdfError & ) {
+        PdfError::LogMessage( eLogSeverity_Warning, "Cannot read all of the CMap in object %i %i R\n",
+                              pCMap->Reference().ObjectNumber(), pCMap->Reference().GenerationNumber() );
+    }
+
+    if( pBuffer )
+        podofo_free( pBuffer );
+}
+
+PdfTextFont::PdfTextFont( PdfObject* pFont )
+    : m_bComposite( false ), m_bVertical( false ), m_bUnicodeCodes( false ), m_nCodeLength( 1 ),
+      m_dAscent( 0.8 ), m_dDescent( -0.2 ), m_dVerticalOrigin( 0.88 ), m_dVerticalAdvance( -1.0 ),
+      m_vecPages( 256, static_cast<TGlyph*>(NULL) )
+{
+    if( !pFont || !pFont->IsDictionary() )
+    {
+        PODOFO_RAISE_ERROR( ePdfError_InvalidHandle );
+    }
+
+    m_defaultGlyph.dWidth      = 0.0;
+    m_defaultGlyph.nTextOffset = 0;
+    m_defaultGlyph.nTextLength = 0;
+
+    PdfObject* pSubtype = pFont->GetIndirectKey( PdfName::KeySubtype );
+    if( pSubtype && pSubtype->IsName() )
+        m_sSubtype = pSubtype->GetName();
+
+    PdfObject* pBaseFont = pFont->GetIndirectKey( "BaseFont" );
+    if( pBaseFont && pBaseFont->IsName() )
+        m_sBaseFont = pBaseFont->GetName();
+
+    try {
+        if( m_sSubtype == PdfName( "Type0" ) )
+            this->LoadCompositeFont( pFont );
+        else
+            this->LoadSimpleFont( pFont );
+
+        this->LoadToUnicode( pFont->GetIndirectKey( "ToUnicode" ) );
+    } catch( PdfError & e ) {
+        for( size_t i = 0; i < m_vecPages.size(); i++ )
+            delete [] m_vecPages[i];
+
+        e.AddToCallstack( __FILE__, __LINE__ );
+        throw e;
+    }
+}
+
+PdfTextFont::~PdfTextFont()
+{
+    for( size_t i = 0; i < m_vecPages.size(); i++ )
+        delete [] m_vecPages[i];
+}
+
+void PdfTextFont::LoadSimpleFont( PdfObject* pFont )
+{
+    PdfVecObjects*        pOwner      = pFont->GetOwner();
+    PdfObject*            pDescriptor = pFont->GetIndirectKey( "FontDescriptor" );
+    bool                  bType3      = m_sSubtype == PdfName( "Type3" );
+    bool                  bSymbolic   = false;
+    double                dScaleX     = 0.001;
+    double                dScaleY     = 0.001;
+    const char*           pszStandard = NULL;
+    pdf_uint32            anUnicode[256];
+
+    m_nCodeLength = 1;
+
+#if defined(PODOFO_HAVE_FREETYPE)
+    // The metrics of the standard 14 fonts are only
+    // available if PdfFontFactoryBase14Data.h is compiled in
+    PdfFontMetricsBase14* pStandard   = bType3 ? NULL : FindStandardFont( m_sBaseFont );
+    if( pStandard )
+        pszStandard = pStandard->GetFontname();
+#endif // PODOFO_HAVE_FREETYPE
+
+    if( bType3 )
+    {
+        // Glyph space of Type3 fonts is defined by the font matrix
+        PdfObject* pMatrix = pFont->GetIndirectKey( "FontMatrix" );
+        if( pMatrix && pMatrix->IsArray() && pMatrix->GetArray().GetSize() == 6 )
+        {
+            dScaleX = GetNumber( &pMatrix->GetArray()[0], pOwner, dScaleX );
+            dScaleY = GetNumber( &pMatrix->GetArray()[3], pOwner, dScaleY );
+        }
+    }
+
+    if( pDescriptor && pDescriptor->IsDictionary() )
+    {
+        bSymbolic             = (static_cast<long>(GetNumber( pDescriptor->GetIndirectKey( "Flags" ), pOwner, 0.0 )) & 4) != 0;
+        m_defaultGlyph.dWidth = GetNumber( pDescriptor->GetIndirectKey( "MissingWidth" ), pOwner, 0.0 ) * dScaleX;
+    }
+
+    // Unicode values from the encoding
+    this->LoadSimpleEncoding( pFont, pszStandard, bSymbolic, anUnicode );
+    for( int i = 0; i < 256; i++ )
+    {
+        this->CreateGlyph( i );
+        if( anUnicode[i] )
+            this->SetText( i, anUnicode[i] );
+    }
+
+    // Widths
+    PdfObject* pWidths = pFont->GetIndirectKey( "Widths" );
+    if( pWidths && pWidths->IsArray() )
+    {
+        const PdfArray & rWidths = pWidths->GetArray();
+        long             lFirst  = static_cast<long>(GetNumber( pFont->GetIndirectKey( "FirstChar" ), pOwner, 0.0 ));
+
+        for( long i = 0; i < static_cast<long>(rWidths.GetSize()); i++ )
+        {
+            if( lFirst + i >= 0 && lFirst + i < 256 )
+                this->CreateGlyph( lFirst + i ).dWidth = GetNumber( &rWidths[i], pOwner, 0.0 ) * dScaleX;
+        }
+    }
+#if defined(PODOFO_HAVE_FREETYPE)
+    else if( pStandard )
+    {
+        // The standard 14 fonts may be used without /Widths
+        for( int i = 0; i < 256; i++ )
+        {
+            if( !anUnicode[i] )
+                continue;
+
+            long lGlyph = pStandard->GetGlyphIdUnicode( anUnicode[i] );
+            if( lGlyph || anUnicode[i] == 0x20 )
+                this->CreateGlyph( i ).dWidth = pStandard->GetGlyphWidth( static_cast<int>(lGlyph) ) * dScaleX;
+        }
+    }
+#endif // PODOFO_HAVE_FREETYPE
+
+    // Ascent and descent for the bounding boxes of glyphs
+    double     dAscent  = 0.0;
+    double     dDescent = 0.0;
+    PdfObject* pBBox    = bType3 ? pFont->GetIndirectKey( "FontBBox" ) : NULL;
+
+    if( pDescriptor && pDescriptor->IsDictionary() )
+    {
+        dAscent  = GetNumber( pDescriptor->GetIndirectKey( "Ascent" ), pOwner, 0.0 );
+        dDescent = GetNumber( pDescriptor->GetIndirectKey( "Descent" ), pOwner, 0.0 );
+        if( !pBBox )
+            pBBox = pDescriptor->GetIndirectKey( "FontBBox" );
+    }
+
+#if defined(PODOFO_HAVE_FREETYPE)
+    if( dAscent == 0.0 && dDescent == 0.0 && pStandard )
+    {
+        dAscent  = pStandard->GetPdfAscent();
+        dDescent = pStandard->GetPdfDescent();
+    }
+#endif // PODOFO_HAVE_FREETYPE
+
+    if( dAscent == 0.0 && dDescent == 0.0 && pBBox && pBBox->IsArray() && pBBox->GetArray().GetSize() == 4 )
+    {
+        dAscent  = GetNumber( &pBBox->GetArray()[3], pOwner, 0.0 );
+        dDescent = GetNumber( &pBBox->GetArray()[1], pOwner, 0.0 );
+    }
+
+    if( dAscent != 0.0 || dDescent != 0.0 )
+    {
+        m_dAscent  = dAscent * dScaleY;
+        m_dDescent = dDescent * dScaleY;
+    }
+}
+
+void PdfTextFont::LoadSimpleEncoding( PdfObject* pFont, const char* pszStandardFont, bool bSymbolic, pdf_uint32* pnUnicode )
+{
+    const PdfEncoding* pBase       = NULL;
+    PdfObject*         pEncoding   = pFont->GetIndirectKey( "Encoding" );
+    PdfObject*         pDifferences = NULL;
+    PdfName            baseEncoding;
+
+    if( pEncoding && pEncoding->IsName() )
+        baseEncoding = pEncoding->GetName();
+    else if( pEncoding && pEncoding->IsDictionary() )
+    {
+        PdfObject* pBaseEncoding = pEncoding->GetIndirectKey( "BaseEncoding" );
+        if( pBaseEncoding && pBaseEncoding->IsName() )
+            baseEncoding = pBaseEncoding->GetName();
+
+        pDifferences = pEncoding->GetIndirectKey( "Differences" );
+    }
+
+    if( baseEncoding == PdfName( "WinAnsiEncoding" ) )
+        pBase = PdfEncodingFactory::GlobalWinAnsiEncodingInstance();
+    else if( baseEncoding == PdfName( "MacRomanEncoding" ) )
+        pBase = PdfEncodingFactory::GlobalMacRomanEncodingInstance();
+    else if( baseEncoding == PdfName( "MacExpertEncoding" ) )
+        pBase = PdfEncodingFactory::GlobalMacExpertEncodingInstance();
+    else if( baseEncoding == PdfName( "StandardEncoding" ) )
+        pBase = PdfEncodingFactory::GlobalStandardEncodingInstance();
+    else if( pszStandardFont && strcmp( pszStandardFont, "Symbol" ) == 0 )
+        pBase = PdfEncodingFactory::GlobalSymbolEncodingInstance();
+    else if( pszStandardFont && strcmp( pszStandardFont, "ZapfDingbats" ) == 0 )
+        pBase = PdfEncodingFactory::GlobalZapfDingbatsEncodingInstance();
+    else if( m_sSubtype == PdfName( "TrueType" ) || bSymbolic )
+        // The built-in encoding of the font program is unknown,
+        // most symbolic and TrueType fonts use codes similar to WinAnsiEncoding
+        pBase = PdfEncodingFactory::GlobalWinAnsiEncodingInstance();
+    else
+        pBase = PdfEncodingFactory::GlobalStandardEncodingInstance();
+
+    for( int i = 0; i < 256; i++ )
+    {
+        pnUnicode[i] = 0;
+        if( i >= pBase->GetFirstChar() && i <= pBase->GetLastChar() )
+            pnUnicode[i] = FromUtf16BE( pBase->GetCharCode( i ) );
+    }
+
+    if( pDifferences && pDifferences->IsArray() )
+    {
+        const PdfArray & rDifferences = pDifferences->GetArray();
+        long             lCode        = 0;
+
+        for( size_t i = 0; i < rDifferences.GetSize(); i++ )
+        {
+            if( rDifferences[i].IsNumber() )
+                lCode = static_cast<long>(rDifferences[i].GetNumber());
+            else if( rDifferences[i].IsName() )
+            {
+                if( lCode >= 0 && lCode < 256 )
+                    pnUnicode[lCode] = FromUtf16BE( PdfDifferenceEncoding::NameToUnicodeID( rDifferences[i].GetName() ) );
+
+                ++lCode;
+            }
+        }
+    }
+}
+
+void PdfTextFont::LoadCompositeFont( PdfObject* pFont )
+{
+    PdfVecObjects* pOwner    = pFont->GetOwner();
+    PdfObject*     pEncoding = pFont->GetIndirectKey( "Encoding" );
+    PdfObject*     pCIDFont  = pFont->GetIndirectKey( "DescendantFonts" );
+    TVecCIDRanges  vecCIDs;
+    bool           bIdentity = false;
+
+    m_bComposite = true;
+
+    if( pEncoding && pEncoding->IsName() )
+        bIdentity = this->LoadPredefinedCMap( pEncoding->GetName() );
+    else if( pEncoding && pEncoding->HasStream() )
+        bIdentity = this->LoadEmbeddedCMap( pEncoding, vecCIDs );
+    else
+        bIdentity = this->LoadPredefinedCMap( PdfName( "Identity-H" ) );
+
+    if( pCIDFont && pCIDFont->IsArray() && pCIDFont->GetArray().GetSize() )
+        pCIDFont = const_cast<PdfObject*>(Resolve( &pCIDFont->GetArray()[0], pOwner ));
+
+    if( !pCIDFont || !pCIDFont->IsDictionary() )
+    {
+        PODOFO_RAISE_ERROR_INFO( ePdfError_InvalidDataType, "Type0 font without a descendant font" );
+    }
+
+    m_defaultGlyph.dWidth = GetNumber( pCIDFont->GetIndirectKey( "DW" ), pOwner, 1000.0 ) / 1000.0;
+
+    PdfObject* pDW2 = pCIDFont->GetIndirectKey( "DW2" );
+    if( pDW2 && pDW2->IsArray() && pDW2->GetArray().GetSize() == 2 )
+    {
+        m_dVerticalOrigin  = GetNumber( &pDW2->GetArray()[0], pOwner, 880.0 ) / 1000.0;
+        m_dVerticalAdvance = GetNumber( &pDW2->GetArray()[1], pOwner, -1000.0 ) / 1000.0;
+    }
+
+    // Widths are given for CIDs, but looked up for codes
+    TMapWidths mapWidths;
+    ReadWidths( pCIDFont->GetIndirectKey( "W" ), mapWidths );
+
+    if( bIdentity )
+    {
+        TMapWidths::const_iterator it = mapWidths.begin();
+        while( it != mapWidths.end() && (*it).first <= 0xFFFF )
+        {
+            this->CreateGlyph( (*it).first ).dWidth = (*it).second;
+            ++it;
+        }
+    }
+    else if( !mapWidths.empty() )
+    {
+        for( size_t i = 0; i < vecCIDs.size(); i++ )
+        {
+            const TCIDRange & rRange = vecCIDs[i];
+            if( rRange.nHigh < rRange.nLow || rRange.nHigh - rRange.nLow > 0xFFFF )
+                continue;
+
+            for( pdf_uint32 nCode = rRange.nLow; nCode <= rRange.nHigh; nCode++ )
+            {
+                TMapWidths::const_iterator it = mapWidths.find( rRange.nCID + nCode - rRange.nLow );
+                if( it != mapWidths.end() )
+                    this->CreateGlyph( nCode ).dWidth = (*it).second;
+            }
+        }
+    }
+
+    PdfObject* pDescriptor = pCIDFont->GetIndirectKey( "FontDescriptor" );
+    if( pDescriptor && pDescriptor->IsDictionary() )
+    {
+        double dAscent  = GetNumber( pDescriptor->GetIndirectKey( "Ascent" ), pOwner, 0.0 );
+        double dDescent = GetNumber( pDescriptor->GetIndirectKey( "Descent" ), pOwner, 0.0 );
+
+        if( dAscent != 0.0 || dDescent != 0.0 )
+        {
+            m_dAscent  = dAscent / 1000.0;
+            m_dDescent = dDescent / 1000.0;
+        }
+    }
+
+    // All ranges have the same length in most CMaps
+    m_nCodeLength = m_vecCodeSpace.empty() ? 2 : m_vecCodeSpace[0].nBytes;
+    for( size_t i = 1; i < m_vecCodeSpace.size(); i++ )
+    {
+        if( m_vecCodeSpace[i].nBytes != m_nCodeLength )
+        {
+            m_nCodeLength = 0;
+            break;
+        }
+    }
+}
+
+/** The code space ranges of the predefined CMaps,
+ *  see PDF Reference 1.7, 5.6.4 and the CMap files of Adobe.
+ */
+struct TPredefinedCodeSpace {
+    const char* pszName;          ///< Part of the CMap name
+    const char* pszRanges;        ///< Pairs of low and high bounds as hex digits
+    bool        bUnicode;         ///< Codes are UCS-2 or UTF-16 values
+};
+
+static const TPredefinedCodeSpace s_aPredefinedCodeSpaces[] = {
+    { "UCS2",   "0000FFFF", true },
+    { "UTF16",  "0000D7FF E000FFFF D800DC00DBFFDFFF", true },
+    { "RKSJ",   "0080 A0DF 81409FFC E040FCFC", false },
+    { "EUC",    "0080 8EA08EFE A1A1FEFE", false },
+    { "GBK",    "0080 8140FEFE", false },
+    { "GBpc",   "0080 8140FEFE", false },
+    { "GBT",    "0080 8140FEFE", false },
+    { "B5",     "0080 8140FEFE", false },
+    { "ETen",   "0080 8140FEFE", false },
+    { "HKscs",  "0080 8140FEFE", false },
+    { "KSCms",  "0080 8141FEFE", false },
+    { "KSCpc",  "0080 8141FEFE", false },
+    { "UHC",    "0080 8141FEFE", false },
+    { NULL, NULL, false }
+};
+
+bool PdfTextFont::LoadPredefinedCMap( const PdfName & rName )
+{
+    const std::string & sName = rName.GetName();
+
+    m_bVertical = sName == "V" || (sName.size() > 2 && sName.compare( sName.size() - 2, 2, "-V" ) == 0);
+    m_vecCodeSpace.clear();
+
+    if( sName == "Identity-H" || sName == "Identity-V" )
+        return true;
+
+    const char* pszRanges = "21217E7E";
+    for( int i = 0; s_aPredefinedCodeSpaces[i].pszName; i++ )
+    {
+        if( sName.find( s_aPredefinedCodeSpaces[i].pszName ) != std::string::npos )
+        {
+            pszRanges       = s_aPredefinedCodeSpaces[i].pszRanges;
+            m_bUnicodeCodes = s_aPredefinedCodeSpaces[i].bUnicode;
+            break;
+        }
+    }
+
+    // Each range is written as the bytes of the low bound
+    // followed by the bytes of the high bound
+    while( *pszRanges )
+    {
+        size_t          lLen = strcspn( pszRanges, " " );
+        TCodeSpaceRange range;
+
+        range.nBytes = static_cast<int>(lLen / 4);
+        for( int i = 0; i < range.nBytes; i++ )
+        {
+            unsigned int nLow;
+            unsigned int nHigh;
+
+            sscanf( pszRanges + i * 2, "%2x", &nLow );
+            sscanf( pszRanges + (range.nBytes + i) * 2, "%2x", &nHigh );
+            range.cLow[i]  = static_cast<unsigned char>(nLow);
+            range.cHigh[i] = static_cast<unsigned char>(nHigh);
+        }
+
+        m_vecCodeSpace.push_back( range );
+        pszRanges += lLen;
+        while( *pszRanges == ' ' )
+            ++pszRanges;
+    }
+
+    return false;
+}
+
+bool PdfTextFont::LoadEmbeddedCMap( PdfObject* pCMap, TVecCIDRanges & rvecCIDs )
+{
+    TCMapData data;
+    bool      bIdentity = false;
+
+    ReadCMap( pCMap, data );
+
+    if( data.useCMap.GetLength() )
+        bIdentity = this->LoadPredefinedCMap( data.useCMap );
+
+    for( size_t i = 0; i + 1 < data.vecCodeSpace.size(); i += 2 )
+    {
+        if( !IsAnyString( data.vecCodeSpace[i] ) || !IsAnyString( data.vecCodeSpace[i + 1] ) )
+            continue;
+
+        const PdfString & rLow  = data.vecCodeSpace[i].GetString();
+        const PdfString & rHigh = data.vecCodeSpace[i + 1].GetString();
+        TCodeSpaceRange   range;
+
+        range.nBytes = static_cast<int>(rLow.GetLength());
+        if( range.nBytes < 1 || range.nBytes > 4 || rHigh.GetLength() != rLow.GetLength() )
+            continue;
+
+        memcpy( range.cLow, rLow.GetString(), range.nBytes );
+        memcpy( range.cHigh, rHigh.GetString(), range.nBytes );
+        m_vecCodeSpace.push_back( range );
+    }
+
+    for( size_t i = 0; i + 2 < data.vecCIDs.size(); i += 3 )
+    {
+        TCIDRange range;
+        range.nLow  = data.vecCIDs[i];
+        range.nHigh = data.vecCIDs[i + 1];
+        range.nCID  = data.vecCIDs[i + 2];
+        rvecCIDs.push_back( range );
+    }
+
+    m_bVertical = m_bVertical || data.bVertical;
+
+    // Without any cidrange the codes are the CIDs of the used CMap
+    return bIdentity && rvecCIDs.empty();
+}
+
+void PdfTextFont::LoadToUnicode( PdfObject* pCMap )
+{
+    TCMapData data;
+
+    if( !pCMap )
+        return;
+
+    ReadCMap( pCMap, data );
+
+    for( size_t i = 0; i < data.vecUnicode.size(); i++ )
+    {
+        const TCMapData::TUnicodeRange & rRange = data.vecUnicode[i];
+        if( rRange.nHigh < rRange.nLow || rRange.nHigh - rRange.nLow > 0xFFFF )
+            continue;
+
+        if( IsAnyString( rRange.destination ) )
+        {
+            // The last byte of the destination is incremented for each code of a range
+            const PdfString & rString = rRange.destination.GetString();
+            std::string       sUtf16( rString.GetString(), rString.GetLength() );
+
+            if( sUtf16.empty() )
+                continue;
+
+            for( pdf_uint32 nCode = rRange.nLow; nCode <= rRange.nHigh; nCode++ )
+            {
+                this->SetText( nCode, reinterpret_cast<const unsigned char*>(sUtf16.data()), static_cast<pdf_long>(sUtf16.size()) );
+
+                unsigned char* pLast = reinterpret_cast<unsigned char*>(&sUtf16[sUtf16.size() - 1]);
+                if( ++(*pLast) == 0 && sUtf16.size() > 1 )
+                    ++sUtf16[sUtf16.size() - 2];
+            }
+        }
+        else if( rRange.destination.IsArray() )
+        {
+            const PdfArray & rArray = rRange.destination.GetArray();
+            for( size_t j = 0; j < rArray.GetSize() && rRange.nLow + j <= rRange.nHigh; j++ )
+            {
+                if( IsAnyString( rArray[j] ) )
+                {
+                    const PdfString & rString = rArray[j].GetString();
+                    this->SetText( static_cast<pdf_uint32>(rRange.nLow + j),
+                                   reinterpret_cast<const unsigned char*>(rString.GetString()),
+                                   static_cast<pdf_long>(rString.GetLength()) );
+                }
+            }
+        }
+        else if( rRange.destination.IsName() )
+        {
+            pdf_uint32 nUnicode = FromUtf16BE( PdfDifferenceEncoding::NameToUnicodeID( rRange.destination.GetName() ) );
+            if( nUnicode )
+                this->SetText( rRange.nLow, nUnicode );
+        }
+    }
+}
+
+void PdfTextFont::ReadWidths( PdfObject* pW, TMapWidths & rMapWidths )
+{
+    if( !pW || !pW->IsArray() )
+        return;
+
+    PdfVecObjects*   pOwner = pW->GetOwner();
+    const PdfArray & rW     = pW->GetArray();
+    size_t           i      = 0;
+
+    // Either c [w1 w2 ... wn] or cfirst clast w
+    while( i + 1 < rW.GetSize() )
+    {
+        const PdfObject* pFirst  = Resolve( &rW[i], pOwner );
+        const PdfObject* pSecond = Resolve( &rW[i + 1], pOwner );
+
+        if( !pFirst || !pFirst->IsNumber() || !pSecond )
+            break;
+
+        pdf_uint32 nFirst = static_cast<pdf_uint32>(pFirst->GetNumber());
+        if( pSecond->IsArray() )
+        {
+            const PdfArray & rWidths = pSecond->GetArray();
+            for( size_t j = 0; j < rWidths.GetSize(); j++ )
+                rMapWidths[nFirst + static_cast<pdf_uint32>(j)] = GetNumber( &rWidths[j], pOwner, 0.0 ) / 1000.0;
+
+            i += 2;
+        }
+        else if( i + 2 < rW.GetSize() && pSecond->IsNumber() )
+        {
+            pdf_uint32 nLast  = static_cast<pdf_uint32>(pSecond->GetNumber());
+            double     dWidth = GetNumber( &rW[i + 2], pOwner, 0.0 ) / 1000.0;
+
+            for( pdf_uint32 nCID = nFirst; nCID <= nLast && nCID - nFirst <= 0xFFFF; nCID++ )
+                rMapWidths[nCID] = dWidth;
+
+            i += 3;
+        }
+        else
+            break;
+    }
+}
+
+PdfTextFont::TGlyph & PdfTextFont::CreateGlyph( pdf_uint32 nCode )
+{
+    if( nCode > 0xFFFF )
+    {
+        std::map<pdf_uint32,TGlyph>::iterator it = m_mapLargeCodes.find( nCode );
+        if( it == m_mapLargeCodes.end() )
+            it = m_mapLargeCodes.insert( std::pair<pdf_uint32,TGlyph>( nCode, m_defaultGlyph ) ).first;
+
+        return (*it).second;
+    }
+
+    TGlyph* & rpPage = m_vecPages[nCode >> 8];
+    if( !rpPage )
+    {
+        rpPage = new TGlyph[256];
+        for( int i = 0; i < 256; i++ )
+            rpPage[i] = m_defaultGlyph;
+    }
+
+    return rpPage[nCode & 0xFF];
+}
+
+void PdfTextFont::SetText( pdf_uint32 nCode, pdf_uint32 nUnicode )
+{
+    TGlyph & rGlyph = this->CreateGlyph( nCode );
+
+    rGlyph.nTextOffset = static_cast<pdf_uint32>(m_sText.size());
+    AppendUtf8( nUnicode, m_sText );
+    rGlyph.nTextLength = static_cast<pdf_uint32>(m_sText.size()) - rGlyph.nTextOffset;
+}
+
+void PdfTextFont::SetText( pdf_uint32 nCode, const unsigned char* pszUtf16, pdf_long lLen )
+{
+    TGlyph & rGlyph = this->CreateGlyph( nCode );
+
+    rGlyph.nTextOffset = static_cast<pdf_uint32>(m_sText.size());
+    for( pdf_long i = 0; i + 1 < lLen; i += 2 )
+    {
+        pdf_uint32 nUnicode = (static_cast<pdf_uint32>(pszUtf16[i]) << 8) | pszUtf16[i + 1];
+
+        // Combine surrogate pairs
+        if( nUnicode >= 0xD800 && nUnicode <= 0xDBFF && i + 3 < lLen )
+        {
+            pdf_uint32 nLow = (static_cast<pdf_uint32>(pszUtf16[i + 2]) << 8) | pszUtf16[i + 3];
+            if( nLow >= 0xDC00 && nLow <= 0xDFFF )
+            {
+                nUnicode = 0x10000 + ((nUnicode - 0xD800) << 10) + (nLow - 0xDC00);
+                i += 2;
+            }
+        }
+
+        AppendUtf8( nUnicode, m_sText );
+    }
+    rGlyph.nTextLength = static_cast<pdf_uint32>(m_sText.size()) - rGlyph.nTextOffset;
+}
+
+int PdfTextFont::ReadMultiByteCode( const char* pszData, pdf_long lLen, pdf_uint32 & rnCode ) const
+{
+    const unsigned char* pszBytes  = reinterpret_cast<const unsigned char*>(pszData);
+    int                  nShortest = 4;
+
+    for( int nBytes = 1; nBytes <= 4 && nBytes <= lLen; nBytes++ )
+    {
+        for( size_t i = 0; i < m_vecCodeSpace.size(); i++ )
+        {
+            const TCodeSpaceRange & rRange = m_vecCodeSpace[i];
+            if( rRange.nBytes != nBytes )
+                continue;
+
+            int j = 0;
+            while( j < nBytes && pszBytes[j] >= rRange.cLow[j] && pszBytes[j] <= rRange.cHigh[j] )
+                ++j;
+
+            if( j == nBytes )
+            {
+                rnCode = 0;
+                for( j = 0; j < nBytes; j++ )
+                    rnCode = (rnCode << 8) | pszBytes[j];
+
+                return nBytes;
+            }
+        }
+    }
+
+    // Codes which are in no code space range
+    // are read with the length of the shortest range
+    for( size_t i = 0; i < m_vecCodeSpace.size(); i++ )
+        nShortest = PDF_MIN( nShortest, m_vecCodeSpace[i].nBytes );
+
+    if( m_vecCodeSpace.empty() )
+        nShortest = m_nCodeLength ? m_nCodeLength : 1;
+
+    nShortest = static_cast<int>(PDF_MIN( static_cast<pdf_long>(nShortest), lLen ));
+
+    rnCode = 0;
+    for( int j = 0; j < nShortest; j++ )
+        rnCode = (rnCode << 8) | pszBytes[j];
+
+    return nShortest;
+}
+
+void PdfTextFont::AppendUtf8( pdf_uint32 nUnicode, std::string & rsText )
+{
+    if( nUnicode < 0x80 )
+        rsText += static_cast<char>(nUnicode);
+    else if( nUnicode < 0x800 )
+    {
+        rsText += static_cast<char>(0xC0 | (nUnicode >> 6));
+        rsText += static_cast<char>(0x80 | (nUnicode & 0x3F));
+    }
+    else if( nUnicode < 0x10000 )
+    {
+        rsText += static_cast<char>(0xE0 | (nUnicode >> 12));
+        rsText += static_cast<char>(0x80 | ((nUnicode >> 6) & 0x3F));
+        rsText += static_cast<char>(0x80 | (nUnicode & 0x3F));
+    }
+    else if( nUnicode < 0x110000 )
+    {
+        rsText += static_cast<char>(0xF0 | (nUnicode >> 18));
+        rsText += static_cast<char>(0x80 | ((nUnicode >> 12) & 0x3F));
+        rsText += static_cast<char>(0x80 | ((nUnicode >> 6) & 0x3F));
+        rsText += static_cast<char>(0x80 | (nUnicode & 0x3F));
+    }
+}
+
+void PdfTextFont::AppendUnicodeCode( pdf_uint32 nCode, std::string & rsText )
+{
+    // 4 byte codes of UTF-16 CMaps are surrogate pairs
+    if( nCode > 0xFFFF )
+    {
+        pdf_uint32 nHigh = nCode >> 16;
+        pdf_uint32 nLow  = nCode & 0xFFFF;
+
+        if( nHigh >= 0xD800 && nHigh <= 0xDBFF && nLow >= 0xDC00 && nLow <= 0xDFFF )
+            AppendUtf8( 0x10000 + ((nHigh - 0xD800) << 10) + (nLow - 0xDC00), rsText );
+    }
+    else if( nCode < 0xD800 || nCode > 0xDFFF )
+        AppendUtf8( nCode, rsText );
+}
+
+};
@@ -0,0 +1,369 @@
+/***************************************************************************
+ *   Copyright (C) 2007 by Dominik Seichter                                *
+ *   domseichter@web.de                                                    *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Library General Public License as       *
+ *   published by the Free Software Foundation; either version 2 of the    *
+ *   License, or (at your option) any later version.                       *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this program; if not, write to the                 *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#ifndef _PDF_TEXT_FONT_H_
+#define _PDF_TEXT_FONT_H_
+
+#include "podofo/base/PdfDefines.h"
+#include "podofo/base/PdfName.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace PoDoFo {
+
+class PdfEncoding;
+class PdfObject;
+
+/**
+ * A font of an existing PDF file, decoded for text extraction.
+ *
+ * PdfTextFont reads everything that is needed to turn the strings
+ * of the text showing operators into positioned Unicode text:
+ * the character codes (single byte codes for simple fonts, the code space
+ * ranges of the CMap for Type0 fonts), the glyph widths (/Widths,
+ * /W and /DW or the metrics of the standard 14 fonts), the Unicode
+ * values (/ToUnicode, otherwise the /Encoding with its /Differences
+ * or a Unicode CMap like UniGB-UCS2-H) and for Type3 fonts the
+ * /FontMatrix.
+ *
+ * The font program itself is never read. Everything is decoded in the
+ * constructor, afterwards a PdfTextFont is immutable and can be used
+ * by several threads at once.
+ *
+ * \see PdfTextExtractor
+ */
+class PODOFO_DOC_API PdfTextFont {
+ public:
+    /** Decode a font dictionary.
+     *
+     *  \param pFont a font dictionary of the type Type0, Type1,
+     *               MMType1, TrueType or Type3
+     */
+    PdfTextFont( PdfObject* pFont );
+
+    ~PdfTextFont();
+
+    /** Read the next character code of a string shown with this font.
+     *
+     *  \param pszData the remaining bytes of the string
+     *  \param lLen the number of remaining bytes, at least 1
+     *  \param rnCode the character code is stored here
+     *  \returns the number of bytes of the code
+     */
+    inline int ReadCode( const char* pszData, pdf_long lLen, pdf_uint32 & rnCode ) const;
+
+    /** \param nCode a character code
+     *  \returns the horizontal displacement of the glyph in text space
+     *           for a font size of 1, i.e. the glyph width divided by
+     *           1000 or for Type3 fonts scaled by the /FontMatrix
+     */
+    inline double GetWidth( pdf_uint32 nCode ) const;
+
+    /** Append the Unicode text of a character code to a string.
+     *
+     *  \param nCode a character code
+     *  \param rsText the text is appended as UTF-8 to this string.
+     *                Nothing is appended if the Unicode value of the code is unknown.
+     */
+    inline void AppendText( pdf_uint32 nCode, std::string & rsText ) const;
+
+    /** \returns the /BaseFont of the font
+     */
+    inline const PdfName & GetBaseFont() const;
+
+    /** \returns the /Subtype of the font, e.g. Type1 or Type0
+     */
+    inline const PdfName & GetSubtype() const;
+
+    /** \returns true for Type0 fonts, which may use multi byte codes
+     */
+    inline bool IsComposite() const;
+
+    /** \returns true if the font is written vertically (e.g. Identity-V)
+     */
+    inline bool IsVertical() const;
+
+    /** \returns the ascent above the baseline in text space for a font size of 1
+     */
+    inline double GetAscent() const;
+
+    /** \returns the descent below the baseline in text space for a font size of 1,
+     *           usually a negative number
+     */
+    inline double GetDescent() const;
+
+    /** \returns the vertical displacement of all glyphs of a vertical font
+     *           in text space for a font size of 1 (from /DW2)
+     */
+    inline double GetVerticalAdvance() const;
+
+    /** \returns the vertical distance between the horizontal and the vertical
+     *           origin of the glyphs of a vertical font (from /DW2)
+     */
+    inline double GetVerticalOrigin() const;
+
+ private:
+    /** The width and the Unicode text of a character code.
+     */
+    struct TGlyph {
+        double     dWidth;
+        pdf_uint32 nTextOffset;   ///< Offset of the UTF-8 text in m_sText
+        pdf_uint32 nTextLength;   ///< Length of the text, 0 if the text is unknown
+    };
+
+    /** A code space range of a CMap, see PDF Reference 1.7, 5.9.2.
+     */
+    struct TCodeSpaceRange {
+        int           nBytes;
+        unsigned char cLow[4];
+        unsigned char cHigh[4];
+    };
+
+    /** Map of CIDs to widths from /W
+     */
+    typedef std::map<pdf_uint32, double> TMapWidths;
+
+    /** A range of character codes with consecutive CIDs,
+     *  from the cidrange and cidchar operators of a CMap.
+     */
+    struct TCIDRange {
+        pdf_uint32 nLow;
+        pdf_uint32 nHigh;
+        pdf_uint32 nCID;          ///< CID of nLow
+    };
+
+    typedef std::vector<TCIDRange> TVecCIDRanges;
+
+    void LoadSimpleFont( PdfObject* pFont );
+    void LoadCompositeFont( PdfObject* pFont );
+
+    /** Read the Unicode values of a simple font from its /Encoding.
+     *
+     *  \param pFont the font dictionary
+     *  \param pszStandardFont name of a standard 14 font or NULL
+     *  \param bSymbolic if the font descriptor marks the font as symbolic
+     *  \param pnUnicode the Unicode values of all 256 codes are stored here, 0 if unknown
+     */
+    void LoadSimpleEncoding( PdfObject* pFont, const char* pszStandardFont, bool bSymbolic, pdf_uint32* pnUnicode );
+
+    /** Set up the code space and the code to CID mapping of a predefined CMap.
+     *
+     *  \param rName the name of the CMap, e.g. Identity-H
+     *  \returns true if the CID of a code is the code itself
+     */
+    bool LoadPredefinedCMap( const PdfName & rName );
+
+    /** Read the code space ranges and the code to CID mapping of an embedded CMap.
+     *
+     *  \param pCMap a CMap stream
+     *  \param rvecCIDs all cidchar and cidrange mappings are added here
+     *  \returns true if the CMap uses Identity-H or Identity-V
+     */
+    bool LoadEmbeddedCMap( PdfObject* pCMap, TVecCIDRanges & rvecCIDs );
+
+    /** Read a /ToUnicode CMap and set the Unicode text of all codes it contains.
+     *
+     *  \param pCMap a ToUnicode CMap stream
+     */
+    void LoadToUnicode( PdfObject* pCMap );
+
+    /** Read the /W array of a CIDFont.
+     */
+    static void ReadWidths( PdfObject* pW, TMapWidths & rMapWidths );
+
+    /** \returns the glyph of a code, which is created if necessary
+     */
+    TGlyph & CreateGlyph( pdf_uint32 nCode );
+
+    /** \returns the glyph of a code or the default glyph
+     */
+    inline const TGlyph & GetGlyph( pdf_uint32 nCode ) const;
+
+    /** Set the text of a code to a single Unicode character.
+     */
+    void SetText( pdf_uint32 nCode, pdf_uint32 nUnicode );
+
+    /** Set the text of a code to UTF-16BE text.
+     */
+    void SetText( pdf_uint32 nCode, const unsigned char* pszUtf16, pdf_long lLen );
+
+    /** Read a code which is not a single byte code,
+     *  using the code space ranges.
+     */
+    int ReadMultiByteCode( const char* pszData, pdf_long lLen, pdf_uint32 & rnCode ) const;
+
+    /** Append a single Unicode character to a string as UTF-8.
+     */
+    static void AppendUtf8( pdf_uint32 nUnicode, std::string & rsText );
+
+    /** Append a code of a UCS-2 or UTF-16 CMap to a string as UTF-8.
+     */
+    static void AppendUnicodeCode( pdf_uint32 nCode, std::string & rsText );
+
+ private:
+    PdfTextFont( const PdfTextFont & rhs );
+    const PdfTextFont & operator=( const PdfTextFont & rhs );
+
+    PdfName                      m_sBaseFont;
+    PdfName                      m_sSubtype;
+
+    bool                         m_bComposite;
+    bool                         m_bVertical;
+    bool                         m_bUnicodeCodes;   ///< Codes are UCS-2 or UTF-16 values (Uni...-UCS2-H CMaps)
+    int                          m_nCodeLength;     ///< Length of all codes in bytes, 0 if m_vecCodeSpace has to be used
+    std::vector<TCodeSpaceRange> m_vecCodeSpace;
+
+    double                       m_dAscent;
+    double                       m_dDescent;
+    double                       m_dVerticalOrigin;
+    double                       m_dVerticalAdvance;
+
+    TGlyph                       m_defaultGlyph;    ///< Used for all codes without an own glyph
+    std::vector<TGlyph*>         m_vecPages;        ///< Glyphs of the codes 0 to 0xFFFF in pages of 256 codes
+    std::map<pdf_uint32,TGlyph>  m_mapLargeCodes;   ///< Glyphs of codes above 0xFFFF
+    std::string                  m_sText;           ///< The UTF-8 text of all glyphs
+};
+
+// -----------------------------------------------------
+//
+// -----------------------------------------------------
+inline int PdfTextFont::ReadCode( const char* pszData, pdf_long lLen, pdf_uint32 & rnCode ) const
+{
+    const unsigned char* pszBytes = reinterpret_cast<const unsigned char*>(pszData);
+
+    if( m_nCodeLength == 1 )
+    {
+        rnCode = pszBytes[0];
+        return 1;
+    }
+    else if( m_nCodeLength == 2 && lLen >= 2 )
+    {
+        rnCode = (static_cast<pdf_uint32>(pszBytes[0]) << 8) | pszBytes[1];
+        return 2;
+    }
+
+    return ReadMultiByteCode( pszData, lLen, rnCode );
+}
+
+// -----------------------------------------------------
+//
+// -----------------------------------------------------
+inline const PdfTextFont::TGlyph & PdfTextFont::GetGlyph( pdf_uint32 nCode ) const
+{
+    if( nCode <= 0xFFFF )
+    {
+        const TGlyph* pPage = m_vecPages[nCode >> 8];
+        return pPage ? pPage[nCode & 0xFF] : m_defaultGlyph;
+    }
+
+    std::map<pdf_uint32,TGlyph>::const_iterator it = m_mapLargeCodes.find( nCode );
+    return it != m_mapLargeCodes.end() ? (*it).second : m_defaultGlyph;
+}
+
+// -----------------------------------------------------
+//
+// -----------------------------------------------------
+inline double PdfTextFont::GetWidth( pdf_uint32 nCode ) const
+{
+    return this->GetGlyph( nCode ).dWidth;
+}
+
+// -----------------------------------------------------
+//
+// -----------------------------------------------------
+inline void PdfTextFont::AppendText( pdf_uint32 nCode, std::string & rsText ) const
+{
+    const TGlyph & rGlyph = this->GetGlyph( nCode );
+
+    if( rGlyph.nTextLength )
+        rsText.append( m_sText, rGlyph.nTextOffset, rGlyph.nTextLength );
+    else if( m_bUnicodeCodes )
+        AppendUnicodeCode( nCode, rsText );
+}
+
+// -----------------------------------------------------
+//
+// -----------------------------------------------------
+inline const PdfName & PdfTextFont::GetBaseFont() const
+{
+    return m_sBaseFont;
+}
+
+// -----------------------------------------------------
+//
+// -----------------------------------------------------
+inline const PdfName & PdfTextFont::GetSubtype() const
+{
+    return m_sSubtype;
+}
+
+// -----------------------------------------------------
+//
+// -----------------------------------------------------
+inline bool PdfTextFont::IsComposite() const
+{
+    return m_bComposite;
+}
+
+// -----------------------------------------------------
+//
+// -----------------------------------------------------
+inline bool PdfTextFont::IsVertical() const
+{
+    return m_bVertical;
+}
+
+// -----------------------------------------------------
+//
+// -----------------------------------------------------
+inline double PdfTextFont::GetAscent() const
+{
+    return m_dAscent;
+}
+
+// -----------------------------------------------------
+//
+// -----------------------------------------------------
+inline double PdfTextFont::GetDescent() const
+{
+    return m_dDescent;
+}
+
+// -----------------------------------------------------
+//
+// -----------------------------------------------------
+inline double PdfTextFont::GetVerticalAdvance() const
+{
+    return m_dVerticalAdvance;
+}
+
+// -----------------------------------------------------
+//
+// -----------------------------------------------------
+inline double PdfTextFont::GetVerticalOrigin() const
+{
+    return m_dVerticalOrigin;
+}
+
+};
+
+#endif // _PDF_TEXT_FONT_H_
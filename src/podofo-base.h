@@ -27,8 +27,10 @@
 #include "base/PdfDefines.h"
 #include "base/Pdf3rdPtyForwardDecl.h"
 #include "base/PdfArray.h"
+#include "base/PdfBufferedOutputDevice.h"
 #include "base/PdfCanvas.h"
 #include "base/PdfColor.h"
+#include "base/PdfContentsParser.h"
 #include "base/PdfContentsTokenizer.h"
 #include "base/PdfData.h"
 #include "base/PdfDataType.h"
@@ -63,6 +63,7 @@
 #include "doc/PdfFontType1Base14.h"
 #include "doc/PdfFontType1.h"
 #include "doc/PdfFunction.h"
+#include "doc/PdfFunctionEvaluator.h"
 #include "doc/PdfHintStream.h"
 #include "doc/PdfIdentityEncoding.h"
 #include "doc/PdfImage.h"
@@ -71,15 +72,19 @@
 #include "doc/PdfNamesTree.h"
 #include "doc/PdfOutlines.h"
 #include "doc/PdfPage.h"
+#include "doc/PdfPageBuffer.h"
 #include "doc/PdfPagesTreeCache.h"
 #include "doc/PdfPagesTree.h"
 #include "doc/PdfPainter.h"
 #include "doc/PdfPainterMM.h"
 #include "doc/PdfShadingPattern.h"
+#include "doc/PdfSharedFontCache.h"
 #include "doc/PdfSignatureField.h"
 #include "doc/PdfSignOutputDevice.h"
 #include "doc/PdfStreamedDocument.h"
 #include "doc/PdfTable.h"
+#include "doc/PdfTextExtractor.h"
+#include "doc/PdfTextFont.h"
 #include "doc/PdfXObject.h"
 
 #ifdef _PODOFO_NO_NAMESPACE_
@@ -0,0 +1,1248 @@
+/***************************************************************************
+ *   Copyright (C) 2013 by Dominik Seichter                                *
+ *   domseichter@web.de                                                    *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#include "../PdfTest.h"
+#include "../../tools/podofocolor/imageconverter.h"
+
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/time.h>
+#endif // _WIN32
+
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+#include <intrin.h>
+#define BENCHMARK_HAVE_RDTSC
+#elif defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#include <x86intrin.h>
+#define BENCHMARK_HAVE_RDTSC
+#endif
+
+using namespace PoDoFo;
+
+/*
+ * Measures the throughput of the tokenizer, the parser, loading,
+ * decoding and writing of documents, of serializing objects, of
+ * the UTF-8/UTF-16 conversion of strings, of reading content streams
+ * and of the conversion of images by podofocolor.
+ *
+ * All corpora are generated byte by byte from a fixed seed, so that they
+ * are identical for every run and every version of PoDoFo and results
+ * can be compared over time. Results are printed as CSV.
+ */
+
+// -----------------------------------------------------
+// Timing and random numbers
+// -----------------------------------------------------
+
+static double GetTime()
+{
+#ifdef _WIN32
+    LARGE_INTEGER freq;
+    LARGE_INTEGER count;
+    QueryPerformanceFrequency( &freq );
+    QueryPerformanceCounter( &count );
+    return static_cast<double>(count.QuadPart) / static_cast<double>(freq.QuadPart);
+#else
+    struct timeval tv;
+    gettimeofday( &tv, NULL );
+    return static_cast<double>(tv.tv_sec) + static_cast<double>(tv.tv_usec) / 1000000.0;
+#endif // _WIN32
+}
+
+/** \returns the time stamp counter of the CPU or 0 if it cannot be read
+ */
+static double GetCycles()
+{
+#ifdef BENCHMARK_HAVE_RDTSC
+    return static_cast<double>(__rdtsc());
+#else
+    return 0.0;
+#endif // BENCHMARK_HAVE_RDTSC
+}
+
+static unsigned int s_nSeed;
+
+// Our own generator, as rand() differs between platforms
+static int Random( int nMax )
+{
+    s_nSeed = s_nSeed * 1103515245 + 12345;
+    return static_cast<int>((s_nSeed >> 8) % static_cast<unsigned int>(nMax));
+}
+
+static std::string Format( const char* pszFormat, ... )
+{
+    char    buffer[512];
+    va_list args;
+
+    va_start( args, pszFormat );
+    vsnprintf( buffer, sizeof(buffer), pszFormat, args );
+    va_end( args );
+
+    return std::string( buffer );
+}
+
+// -----------------------------------------------------
+// Corpus generation
+// -----------------------------------------------------
+
+/** Writes a PDF file object by object without using PdfWriter,
+ *  so that the corpora do not change when PdfWriter changes.
+ */
+class CorpusBuilder {
+ public:
+    CorpusBuilder()
+        : m_sData( "%PDF-1.5\n%\xe2\xe3\xcf\xd3\n" )
+    {
+    }
+
+    /** \returns the number of a new object, which has to be added later
+     */
+    int Reserve()
+    {
+        TEntry entry = { 1, 0, 0 };
+        m_vecEntries.push_back( entry );
+        return static_cast<int>(m_vecEntries.size());
+    }
+
+    void AddObject( int nObj, const std::string & sBody )
+    {
+        SetEntry( nObj, 1, static_cast<long>(m_sData.size()), 0 );
+
+        m_sData += Format( "%i 0 obj\n", nObj );
+        m_sData += sBody;
+        m_sData += "\nendobj\n";
+    }
+
+    /** \param sDict the keys of the stream dictionary without Filter and Length
+     */
+    void AddStream( int nObj, const std::string & sDict, const std::string & sData, bool bFlate )
+    {
+        std::string sEncoded = bFlate ? Flate( sData ) : sData;
+        std::string sBody    = "<<" + sDict;
+
+        if( bFlate )
+            sBody += "/Filter/FlateDecode";
+
+        sBody += Format( "/Length %li>>\nstream\n", static_cast<long>(sEncoded.size()) );
+        sBody += sEncoded;
+        sBody += "\nendstream";
+
+        AddObject( nObj, sBody );
+    }
+
+    /** Add objects which are stored in a single object stream
+     */
+    void AddObjectStream( const std::vector<int> & vecObj, const std::vector<std::string> & vecBodies )
+    {
+        std::string sOffsets;
+        std::string sObjects;
+        int         nStream = Reserve();
+
+        for( size_t i = 0; i < vecObj.size(); i++ )
+        {
+            SetEntry( vecObj[i], 2, nStream, static_cast<int>(i) );
+
+            sOffsets += Format( "%i %li ", vecObj[i], static_cast<long>(sObjects.size()) );
+            sObjects += vecBodies[i];
+            sObjects += "\n";
+        }
+
+        AddStream( nStream, Format( "/Type/ObjStm/N %i/First %li", static_cast<int>(vecObj.size()),
+                                    static_cast<long>(sOffsets.size()) ),
+                   sOffsets + sObjects, true );
+    }
+
+    std::string Finish( int nRoot, bool bXRefStream )
+    {
+        long lXRef = static_cast<long>(m_sData.size());
+
+        if( bXRefStream )
+        {
+            int         nXRef = Reserve();
+            std::string sXRef;
+
+            SetEntry( nXRef, 1, lXRef, 0 );
+
+            AppendXRefStreamEntry( sXRef, 0, 0, 0xffff );
+            for( size_t i = 0; i < m_vecEntries.size(); i++ )
+                AppendXRefStreamEntry( sXRef, m_vecEntries[i].cType, m_vecEntries[i].lField2, m_vecEntries[i].nField3 );
+
+            AddStream( nXRef, Format( "/Type/XRef/Size %i/W[1 4 2]/Root %i 0 R",
+                                      static_cast<int>(m_vecEntries.size() + 1), nRoot ),
+                       sXRef, false );
+        }
+        else
+        {
+            m_sData += Format( "xref\n0 %i\n", static_cast<int>(m_vecEntries.size() + 1) );
+            m_sData += "0000000000 65535 f \n";
+            for( size_t i = 0; i < m_vecEntries.size(); i++ )
+                m_sData += Format( "%010li 00000 n \n", m_vecEntries[i].lField2 );
+
+            m_sData += Format( "trailer\n<</Size %i/Root %i 0 R>>\n", static_cast<int>(m_vecEntries.size() + 1), nRoot );
+        }
+
+        m_sData += Format( "startxref\n%li\n%%%%EOF\n", lXRef );
+
+        return m_sData;
+    }
+
+ private:
+    struct TEntry {
+        char cType;
+        long lField2; ///< offset or number of the object stream
+        int  nField3; ///< index in the object stream
+    };
+
+    void SetEntry( int nObj, char cType, long lField2, int nField3 )
+    {
+        m_vecEntries[nObj-1].cType   = cType;
+        m_vecEntries[nObj-1].lField2 = lField2;
+        m_vecEntries[nObj-1].nField3 = nField3;
+    }
+
+    static void AppendXRefStreamEntry( std::string & rsXRef, char cType, long lField2, int nField3 )
+    {
+        rsXRef += cType;
+        rsXRef += static_cast<char>((lField2 >> 24) & 0xff);
+        rsXRef += static_cast<char>((lField2 >> 16) & 0xff);
+        rsXRef += static_cast<char>((lField2 >> 8) & 0xff);
+        rsXRef += static_cast<char>(lField2 & 0xff);
+        rsXRef += static_cast<char>((nField3 >> 8) & 0xff);
+        rsXRef += static_cast<char>(nField3 & 0xff);
+    }
+
+    static std::string Flate( const std::string & sData )
+    {
+        char*    pBuffer;
+        pdf_long lLen;
+
+        std::auto_ptr<PdfFilter> pFilter = PdfFilterFactory::Create( ePdfFilter_FlateDecode );
+        pFilter->Encode( sData.data(), sData.size(), &pBuffer, &lLen );
+
+        std::string sEncoded( pBuffer, lLen );
+        free( pBuffer );
+        return sEncoded;
+    }
+
+ private:
+    std::string         m_sData;
+    std::vector<TEntry> m_vecEntries;
+};
+
+static std::string CreateSmallObject( int nIndex, int nRef )
+{
+    return Format( "<</Type/Bench/Index %i/Name/N%i/Value %i.%03i/Flag true"
+                   "/Str(small object %i)/Hex<%08X>/Arr[%i %i %i/A/B null]/Ref %i 0 R>>",
+                   nIndex, Random( 1000 ), Random( 100000 ), Random( 1000 ),
+                   nIndex, Random( 0x7fffffff ), Random( 100 ), Random( 100 ), Random( 100 ), nRef );
+}
+
+static std::string CreateContents( long lSize )
+{
+    std::string sContents;
+
+    while( static_cast<long>(sContents.size()) < lSize )
+    {
+        switch( Random( 4 ) )
+        {
+            case 0:
+                sContents += Format( "q 1 0 0 1 %i %i cm 0 0 %i %i re f Q\n",
+                                     Random( 600 ), Random( 800 ), Random( 100 ), Random( 100 ) );
+                break;
+            case 1:
+                sContents += Format( "BT /F1 %i Tf %i %i Td (Benchmark text %i) Tj ET\n",
+                                     8 + Random( 12 ), Random( 600 ), Random( 800 ), Random( 10000 ) );
+                break;
+            case 2:
+                sContents += Format( "%.3f %.3f %.3f rg %i %i m %i %i l S\n",
+                                     Random( 1000 ) / 1000.0, Random( 1000 ) / 1000.0, Random( 1000 ) / 1000.0,
+                                     Random( 600 ), Random( 800 ), Random( 600 ), Random( 800 ) );
+                break;
+            default:
+                sContents += Format( "[(Kerned) %i (text)] TJ\n", -Random( 500 ) );
+                break;
+        }
+    }
+
+    return sContents;
+}
+
+/** Add a catalog and a flat page tree with nPages pages
+ *  \returns the object number of the catalog
+ */
+static int AddPages( CorpusBuilder & rBuilder, int nPages, long lContentsSize )
+{
+    int              nCatalog   = rBuilder.Reserve();
+    int              nPagesNode = rBuilder.Reserve();
+    std::string      sKids;
+
+    for( int i = 0; i < nPages; i++ )
+    {
+        int nPage     = rBuilder.Reserve();
+        int nContents = rBuilder.Reserve();
+
+        rBuilder.AddStream( nContents, "", CreateContents( lContentsSize ), true );
+        rBuilder.AddObject( nPage, Format( "<</Type/Page/Parent %i 0 R/MediaBox[0 0 612 792]/Contents %i 0 R>>",
+                                           nPagesNode, nContents ) );
+        sKids += Format( "%i 0 R ", nPage );
+    }
+
+    rBuilder.AddObject( nPagesNode, Format( "<</Type/Pages/Count %i/Kids[%s]>>", nPages, sKids.c_str() ) );
+    rBuilder.AddObject( nCatalog, Format( "<</Type/Catalog/Pages %i 0 R>>", nPagesNode ) );
+
+    return nCatalog;
+}
+
+static std::string CreateSmallObjects( int nScale, bool bXRefStream )
+{
+    CorpusBuilder builder;
+    int           nCount = 20000 * nScale;
+    int           nFirst = 0;
+
+    for( int i = 0; i < nCount; i++ )
+    {
+        int nObj = builder.Reserve();
+        if( !nFirst )
+            nFirst = nObj;
+
+        builder.AddObject( nObj, CreateSmallObject( i, nFirst + Random( i + 1 ) ) );
+    }
+
+    return builder.Finish( AddPages( builder, 1, 1024 ), bXRefStream );
+}
+
+static std::string CreateBigStreams( int nScale )
+{
+    CorpusBuilder builder;
+
+    return builder.Finish( AddPages( builder, 16, 1024 * 1024 * nScale ), false );
+}
+
+/** Add a balanced page tree node with nDepth levels of nodes below it
+ *  \returns the object number of the node
+ */
+static int AddPagesNode( CorpusBuilder & rBuilder, int nParent, int nDepth, int nFanOut, int nContents, int* pnPages )
+{
+    int nNode = rBuilder.Reserve();
+
+    if( !nDepth )
+    {
+        rBuilder.AddObject( nNode, Format( "<</Type/Page/Parent %i 0 R/Contents %i 0 R>>", nParent, nContents ) );
+        ++(*pnPages);
+        return nNode;
+    }
+
+    std::string sKids;
+    int         nPages = *pnPages;
+
+    for( int i = 0; i < nFanOut; i++ )
+        sKids += Format( "%i 0 R ", AddPagesNode( rBuilder, nNode, nDepth - 1, nFanOut, nContents, pnPages ) );
+
+    std::string sBody = Format( "<</Type/Pages/Count %i/Kids[%s]", *pnPages - nPages, sKids.c_str() );
+    if( nParent )
+        sBody += Format( "/Parent %i 0 R>>", nParent );
+    else
+        sBody += "/MediaBox[0 0 612 792]/Resources<<>>>>";
+
+    rBuilder.AddObject( nNode, sBody );
+    return nNode;
+}
+
+static std::string CreateDeepPageTree( int nScale )
+{
+    CorpusBuilder builder;
+    int           nCatalog  = builder.Reserve();
+    int           nContents = builder.Reserve();
+    int           nPages    = 0;
+
+    builder.AddStream( nContents, "", CreateContents( 512 ), true );
+
+    // 2^12 pages for scale 1
+    int nRoot = AddPagesNode( builder, 0, 11 + nScale, 2, nContents, &nPages );
+    builder.AddObject( nCatalog, Format( "<</Type/Catalog/Pages %i 0 R>>", nRoot ) );
+
+    return builder.Finish( nCatalog, false );
+}
+
+static std::string CreateObjectStreams( int nScale )
+{
+    CorpusBuilder builder;
+    int           nCount = 20000 * nScale;
+    int           nFirst = 0;
+
+    std::vector<int>         vecObj;
+    std::vector<std::string> vecBodies;
+
+    for( int i = 0; i < nCount; i++ )
+    {
+        int nObj = builder.Reserve();
+        if( !nFirst )
+            nFirst = nObj;
+
+        vecObj.push_back( nObj );
+        vecBodies.push_back( CreateSmallObject( i, nFirst + Random( i + 1 ) ) );
+
+        if( vecObj.size() == 100 || i == nCount - 1 )
+        {
+            builder.AddObjectStream( vecObj, vecBodies );
+            vecObj.clear();
+            vecBodies.clear();
+        }
+    }
+
+    return builder.Finish( AddPages( builder, 1, 1024 ), true );
+}
+
+/** A smooth gradient with some noise, which compresses about as badly as a photo
+ */
+static std::string CreatePhoto( int nWidth, int nHeight, int nComponents, int nBits )
+{
+    std::string sData;
+
+    sData.reserve( nWidth * nHeight * nComponents * nBits / 8 );
+    for( int y = 0; y < nHeight; y++ )
+    {
+        for( int x = 0; x < nWidth; x++ )
+        {
+            for( int c = 0; c < nComponents; c++ )
+            {
+                int nValue = (x * (c + 1) * 255 / nWidth + y * 255 / nHeight) / 2 + Random( 24 );
+
+                sData += static_cast<char>(PDF_MIN( nValue, 255 ));
+                if( nBits == 16 )
+                    sData += static_cast<char>(Random( 256 ));
+            }
+        }
+    }
+
+    return sData;
+}
+
+/** Pages with 3 images each, mostly DeviceRGB, but also DeviceCMYK,
+ *  DeviceGray, 16 bits per component, a soft mask and an Indexed palette
+ */
+static std::string CreatePhotoImages( int nScale )
+{
+    const int     nWidth  = 640;
+    const int     nHeight = 480;
+    const int     nImages = 12 * nScale;
+
+    CorpusBuilder builder;
+    int           nCatalog   = builder.Reserve();
+    int           nPagesNode = builder.Reserve();
+    std::string   sKids;
+    std::string   sXObjects;
+    std::string   sContents;
+
+    for( int i = 0; i < nImages; i++ )
+    {
+        int         nImage = builder.Reserve();
+        std::string sDict  = Format( "/Type/XObject/Subtype/Image/Width %i/Height %i", nWidth, nHeight );
+
+        switch( i % 6 )
+        {
+            case 0:
+                builder.AddStream( nImage, sDict + "/ColorSpace/DeviceRGB/BitsPerComponent 8",
+                                   CreatePhoto( nWidth, nHeight, 3, 8 ), true );
+                break;
+            case 1:
+            {
+                int nMask = builder.Reserve();
+                builder.AddStream( nMask, sDict + "/ColorSpace/DeviceGray/BitsPerComponent 8",
+                                   CreatePhoto( nWidth, nHeight, 1, 8 ), true );
+                builder.AddStream( nImage, sDict + Format( "/ColorSpace/DeviceRGB/BitsPerComponent 8/SMask %i 0 R", nMask ),
+                                   CreatePhoto( nWidth, nHeight, 3, 8 ), true );
+                break;
+            }
+            case 2:
+                builder.AddStream( nImage, sDict + "/ColorSpace/DeviceCMYK/BitsPerComponent 8",
+                                   CreatePhoto( nWidth, nHeight, 4, 8 ), true );
+                break;
+            case 3:
+                builder.AddStream( nImage, sDict + "/ColorSpace/DeviceGray/BitsPerComponent 8",
+                                   CreatePhoto( nWidth, nHeight, 1, 8 ), true );
+                break;
+            case 4:
+                builder.AddStream( nImage, sDict + "/ColorSpace/DeviceRGB/BitsPerComponent 16",
+                                   CreatePhoto( nWidth, nHeight, 3, 16 ), true );
+                break;
+            default:
+            {
+                std::string sPalette;
+                for( int j = 0; j < 256 * 3; j++ )
+                    sPalette += Format( "%02X", Random( 256 ) );
+
+                // Too long for Format
+                builder.AddStream( nImage, sDict + "/ColorSpace[/Indexed/DeviceRGB 255<" + sPalette + ">]/BitsPerComponent 8",
+                                   CreatePhoto( nWidth, nHeight, 1, 8 ), true );
+                break;
+            }
+        }
+
+        sXObjects += Format( "/Im%i %i 0 R", i, nImage );
+        sContents += Format( "q 200 0 0 150 %i %i cm /Im%i Do Q\n", 100 + (i % 3) * 20, 100 + (i % 3) * 200, i );
+
+        if( i % 3 == 2 || i == nImages - 1 )
+        {
+            int nPage     = builder.Reserve();
+            int nContents = builder.Reserve();
+
+            builder.AddStream( nContents, "", sContents, true );
+            builder.AddObject( nPage, Format( "<</Type/Page/Parent %i 0 R/MediaBox[0 0 612 792]"
+                                              "/Resources<</XObject<<%s>>>>/Contents %i 0 R>>",
+                                              nPagesNode, sXObjects.c_str(), nContents ) );
+            sKids += Format( "%i 0 R ", nPage );
+            sXObjects.clear();
+            sContents.clear();
+        }
+    }
+
+    builder.AddObject( nPagesNode, Format( "<</Type/Pages/Count %i/Kids[", (nImages + 2) / 3 ) + sKids + "]>>" );
+    builder.AddObject( nCatalog, Format( "<</Type/Catalog/Pages %i 0 R>>", nPagesNode ) );
+
+    return builder.Finish( nCatalog, false );
+}
+
+/** Appends the UTF-8 encoding of a character of the basic multilingual plane
+ */
+static void AppendUtf8( std::string & rsText, int nChar )
+{
+    if( nChar < 0x80 )
+        rsText += static_cast<char>(nChar);
+    else if( nChar < 0x800 )
+    {
+        rsText += static_cast<char>(0xC0 | (nChar >> 6));
+        rsText += static_cast<char>(0x80 | (nChar & 0x3F));
+    }
+    else
+    {
+        rsText += static_cast<char>(0xE0 | (nChar >> 12));
+        rsText += static_cast<char>(0x80 | ((nChar >> 6) & 0x3F));
+        rsText += static_cast<char>(0x80 | (nChar & 0x3F));
+    }
+}
+
+/** Creates strings as found in the text and form fields of documents.
+ *  nCJK is the percentage of words made of CJK ideographs,
+ *  all other words are Latin with some accented characters.
+ */
+static std::vector<std::string> CreateText( int nScale, int nCJK )
+{
+    std::vector<std::string> vecText;
+
+    for( int i = 0; i < 20000 * nScale; i++ )
+    {
+        std::string sText;
+        int         nWords = 1 + Random( 30 );
+
+        for( int w = 0; w < nWords; w++ )
+        {
+            int nLen = 1 + Random( 8 );
+
+            if( w )
+                sText += ' ';
+
+            if( Random( 100 ) < nCJK )
+            {
+                for( int c = 0; c < nLen; c++ )
+                    AppendUtf8( sText, 0x4E00 + Random( 0x5200 ) );
+            }
+            else
+            {
+                for( int c = 0; c < nLen; c++ )
+                    AppendUtf8( sText, Random( 20 ) ? 'a' + Random( 26 ) : 0xE0 + Random( 0x20 ) );
+            }
+        }
+
+        vecText.push_back( sText );
+    }
+
+    return vecText;
+}
+
+// -----------------------------------------------------
+// Benchmarks
+// -----------------------------------------------------
+
+struct TResult {
+    double dSeconds;
+    double dCycles;
+    double dBytes;
+    double dObjects;
+};
+
+static void Report( const char* pszCorpus, const char* pszPhase, const TResult & rResult )
+{
+    double dSeconds = rResult.dSeconds > 0.0 ? rResult.dSeconds : 1e-9;
+
+    printf( "%s,%s,%.0f,%.0f,%.6f,%.2f,%.0f,%.4f\n", pszCorpus, pszPhase,
+            rResult.dBytes, rResult.dObjects, rResult.dSeconds,
+            rResult.dBytes / dSeconds / (1024.0 * 1024.0), rResult.dObjects / dSeconds,
+            rResult.dCycles > 0.0 ? rResult.dBytes / rResult.dCycles : 0.0 );
+    fflush( stdout );
+}
+
+static void Keep( TResult & rBest, const TResult & rResult )
+{
+    if( rBest.dSeconds < 0.0 || rResult.dSeconds < rBest.dSeconds )
+        rBest = rResult;
+}
+
+static TResult BenchTokenize( const std::string & sData )
+{
+    TResult      result;
+    PdfTokenizer tokenizer( sData.data(), sData.size() );
+    const char*  pszToken;
+    long         lTokens = 0;
+
+    double dStart  = GetTime();
+    double dCycles = GetCycles();
+    while( tokenizer.GetNextToken( pszToken ) )
+        ++lTokens;
+
+    result.dCycles  = GetCycles() - dCycles;
+    result.dSeconds = GetTime() - dStart;
+    result.dBytes   = static_cast<double>(sData.size());
+    result.dObjects = static_cast<double>(lTokens);
+    return result;
+}
+
+static TResult BenchParse( const std::string & sData )
+{
+    TResult       result;
+    PdfVecObjects objects;
+    PdfParser     parser( &objects );
+
+    double dStart  = GetTime();
+    double dCycles = GetCycles();
+    parser.ParseFile( sData.data(), static_cast<long>(sData.size()), true );
+
+    result.dCycles  = GetCycles() - dCycles;
+    result.dSeconds = GetTime() - dStart;
+    result.dBytes   = static_cast<double>(sData.size());
+    result.dObjects = static_cast<double>(objects.GetSize());
+    return result;
+}
+
+/** Load a document completely, decode all its streams and write it
+ */
+static void BenchDocument( const std::string & sData, TResult* pLoad, TResult* pDecode, TResult* pWrite )
+{
+    PdfMemDocument doc;
+    TCIVecObjects  it;
+    double         dStart;
+    double         dCycles;
+    double         dDecoded = 0.0;
+
+    dStart  = GetTime();
+    dCycles = GetCycles();
+    doc.Load( sData.data(), static_cast<long>(sData.size()) );
+    for( it = doc.GetObjects().begin(); it != doc.GetObjects().end(); ++it )
+    {
+        // Force loading of the object and its stream
+        (*it)->GetDataType();
+        (*it)->HasStream();
+    }
+
+    pLoad->dCycles  = GetCycles() - dCycles;
+    pLoad->dSeconds = GetTime() - dStart;
+    pLoad->dBytes   = static_cast<double>(sData.size());
+    pLoad->dObjects = static_cast<double>(doc.GetObjects().GetSize());
+
+    pDecode->dObjects = 0.0;
+    dStart  = GetTime();
+    dCycles = GetCycles();
+    for( it = doc.GetObjects().begin(); it != doc.GetObjects().end(); ++it )
+    {
+        if( (*it)->HasStream() )
+        {
+            char*    pBuffer;
+            pdf_long lLen;
+
+            (*it)->GetStream()->GetFilteredCopy( &pBuffer, &lLen );
+            free( pBuffer );
+
+            dDecoded += static_cast<double>(lLen);
+            pDecode->dObjects += 1.0;
+        }
+    }
+
+    pDecode->dCycles  = GetCycles() - dCycles;
+    pDecode->dSeconds = GetTime() - dStart;
+    pDecode->dBytes   = dDecoded;
+
+    PdfRefCountedBuffer buffer;
+    PdfOutputDevice     device( &buffer );
+
+    dStart  = GetTime();
+    dCycles = GetCycles();
+    doc.Write( &device );
+
+    pWrite->dCycles  = GetCycles() - dCycles;
+    pWrite->dSeconds = GetTime() - dStart;
+    pWrite->dBytes   = static_cast<double>(device.GetLength());
+    pWrite->dObjects = static_cast<double>(doc.GetObjects().GetSize());
+}
+
+/** Serializes a variant in compact write mode the way PoDoFo did before
+ *  PdfOutputDevice::WriteNumber, i.e. with one printf call per number,
+ *  reference and keyword. Used as the baseline for the serialize phase.
+ */
+static void WriteWithPrint( const PdfVariant & rVariant, PdfOutputDevice* pDevice )
+{
+    switch( rVariant.GetDataType() )
+    {
+        case ePdfDataType_Number:
+            pDevice->Print( " %lld", static_cast<long long>(rVariant.GetNumber()) );
+            break;
+        case ePdfDataType_Real:
+        {
+            std::ostringstream oss;
+            PdfLocaleImbue( oss );
+            oss << " " << std::fixed << rVariant.GetReal();
+            pDevice->Write( oss.str().c_str(), oss.str().size() );
+            break;
+        }
+        case ePdfDataType_Reference:
+            pDevice->Print( " %i %hi R", rVariant.GetReference().ObjectNumber(), 
+                            rVariant.GetReference().GenerationNumber() );
+            break;
+        case ePdfDataType_Null:
+            pDevice->Print( " null" );
+            break;
+        case ePdfDataType_Name:
+            pDevice->Print( "/" );
+            pDevice->Write( rVariant.GetName().GetEscapedName().c_str(), 
+                            rVariant.GetName().GetEscapedName().length() );
+            break;
+        case ePdfDataType_Array:
+        {
+            const PdfArray &         rArray = rVariant.GetArray();
+            PdfArray::const_iterator it;
+
+            pDevice->Print( "[" );
+            for( it = rArray.begin(); it != rArray.end(); ++it )
+                WriteWithPrint( *it, pDevice );
+            pDevice->Print( "]" );
+            break;
+        }
+        case ePdfDataType_Dictionary:
+        {
+            const PdfDictionary & rDict = rVariant.GetDictionary();
+            TCIKeyMap             it;
+
+            pDevice->Print( "<<" );
+            if( rDict.HasKey( PdfName::KeyType ) )
+            {
+                pDevice->Print( "/Type" );
+                WriteWithPrint( *rDict.GetKey( PdfName::KeyType ), pDevice );
+            }
+
+            for( it = rDict.GetKeys().begin(); it != rDict.GetKeys().end(); ++it )
+            {
+                if( (*it).first != PdfName::KeyType )
+                {
+                    WriteWithPrint( (*it).first, pDevice );
+                    WriteWithPrint( *(*it).second, pDevice );
+                }
+            }
+            pDevice->Print( ">>" );
+            break;
+        }
+        // Written without numbers, so printf does not matter
+        case ePdfDataType_Bool:
+        case ePdfDataType_String:
+        case ePdfDataType_HexString:
+        case ePdfDataType_RawData:
+        case ePdfDataType_Unknown:
+            rVariant.Write( pDevice, ePdfWriteMode_Compact, NULL );
+            break;
+    }
+}
+
+/** Serialize all objects of a document without their streams,
+ *  followed by an xref table, either with printf or with PoDoFo.
+ */
+static TResult BenchSerialize( const std::string & sData, bool bPrint, size_t* plLength )
+{
+    TResult        result;
+    PdfMemDocument doc;
+    TCIVecObjects  it;
+
+    doc.Load( sData.data(), static_cast<long>(sData.size()) );
+    for( it = doc.GetObjects().begin(); it != doc.GetObjects().end(); ++it )
+        (*it)->GetDataType();
+
+    PdfRefCountedBuffer buffer;
+    PdfOutputDevice     device( &buffer );
+
+    double dStart  = GetTime();
+    double dCycles = GetCycles();
+    for( it = doc.GetObjects().begin(); it != doc.GetObjects().end(); ++it )
+    {
+        const PdfReference & rRef = (*it)->Reference();
+
+        if( bPrint )
+        {
+            device.Print( "%i %i obj", rRef.ObjectNumber(), rRef.GenerationNumber() );
+            WriteWithPrint( **it, &device );
+            device.Print( "\n" );
+            device.Print( "endobj\n" );
+        }
+        else
+        {
+            device.WriteNumber( rRef.ObjectNumber() );
+            device.Write( " ", 1 );
+            device.WriteNumber( rRef.GenerationNumber() );
+            device.Write( " obj", 4 );
+            (*it)->Write( &device, ePdfWriteMode_Compact, NULL );
+            device.Write( "\nendobj\n", 8 );
+        }
+    }
+
+    for( it = doc.GetObjects().begin(); it != doc.GetObjects().end(); ++it )
+    {
+        pdf_uint64 nOffset = static_cast<pdf_uint64>((*it)->Reference().ObjectNumber()) * 100;
+
+        if( bPrint )
+            device.Print( "%0.10" PDF_FORMAT_UINT64 " %0.5hu %c \n", nOffset, (*it)->Reference().GenerationNumber(), 'n' );
+        else
+        {
+            device.WriteUnsigned( nOffset, 10 );
+            device.Write( " ", 1 );
+            device.WriteUnsigned( (*it)->Reference().GenerationNumber(), 5 );
+            device.Write( " n \n", 4 );
+        }
+    }
+
+    result.dCycles  = GetCycles() - dCycles;
+    result.dSeconds = GetTime() - dStart;
+    result.dBytes   = static_cast<double>(device.GetLength());
+    result.dObjects = static_cast<double>(doc.GetObjects().GetSize());
+
+    *plLength = device.GetLength();
+    return result;
+}
+
+static void RunCorpus( const char* pszCorpus, const std::string & sData, int nRepeat )
+{
+    TResult tokenize = { -1.0, 0.0, 0.0, 0.0 };
+    TResult parse    = { -1.0, 0.0, 0.0, 0.0 };
+    TResult load     = { -1.0, 0.0, 0.0, 0.0 };
+    TResult decode   = { -1.0, 0.0, 0.0, 0.0 };
+    TResult write    = { -1.0, 0.0, 0.0, 0.0 };
+    TResult print    = { -1.0, 0.0, 0.0, 0.0 };
+    TResult serial   = { -1.0, 0.0, 0.0, 0.0 };
+
+    for( int i = 0; i < nRepeat; i++ )
+    {
+        TResult l, d, w;
+        size_t  lPrint;
+        size_t  lSerial;
+
+        Keep( tokenize, BenchTokenize( sData ) );
+        Keep( parse, BenchParse( sData ) );
+
+        BenchDocument( sData, &l, &d, &w );
+        Keep( load, l );
+        Keep( decode, d );
+        Keep( write, w );
+
+        Keep( print, BenchSerialize( sData, true, &lPrint ) );
+        Keep( serial, BenchSerialize( sData, false, &lSerial ) );
+        if( lPrint != lSerial )
+        {
+            PODOFO_RAISE_ERROR_INFO( ePdfError_InternalLogic, "Serializing with printf gave a different result" );
+        }
+    }
+
+    Report( pszCorpus, "tokenize", tokenize );
+    Report( pszCorpus, "parse", parse );
+    Report( pszCorpus, "load", load );
+    Report( pszCorpus, "decode", decode );
+    Report( pszCorpus, "write", write );
+    Report( pszCorpus, "serialize-printf", print );
+    Report( pszCorpus, "serialize", serial );
+}
+
+/** Load a document and convert all its images with the ImageConverter of podofocolor.
+ *  Bytes are counted on the decoded images before the conversion.
+ */
+static TResult BenchConvertImages( const std::string & sData, EPdfColorSpace eColorSpace, int nThreads )
+{
+    TResult        result;
+    PdfMemDocument doc;
+    TCIVecObjects  it;
+    double         dDecoded = 0.0;
+
+    doc.Load( sData.data(), static_cast<long>(sData.size()) );
+    for( it = doc.GetObjects().begin(); it != doc.GetObjects().end(); ++it )
+    {
+        // Force loading of all streams, so that only the conversion is measured
+        if( (*it)->HasStream() && (*it)->GetDictionary().HasKey( "Width" ) )
+        {
+            char*    pBuffer;
+            pdf_long lLen;
+
+            (*it)->GetStream()->GetFilteredCopy( &pBuffer, &lLen );
+            free( pBuffer );
+
+            dDecoded += static_cast<double>(lLen);
+        }
+    }
+
+    ImageConverter converter( eColorSpace, nThreads );
+
+    double dStart  = GetTime();
+    double dCycles = GetCycles();
+    int    nImages = converter.ConvertImages( doc.GetObjects() );
+
+    result.dCycles  = GetCycles() - dCycles;
+    result.dSeconds = GetTime() - dStart;
+    result.dBytes   = dDecoded;
+    result.dObjects = static_cast<double>(nImages);
+    return result;
+}
+
+static void RunImages( const char* pszCorpus, const std::string & sData, int nRepeat )
+{
+    TResult serial = { -1.0, 0.0, 0.0, 0.0 };
+    TResult gray   = { -1.0, 0.0, 0.0, 0.0 };
+    TResult cmyk   = { -1.0, 0.0, 0.0, 0.0 };
+
+    for( int i = 0; i < nRepeat; i++ )
+    {
+        Keep( serial, BenchConvertImages( sData, ePdfColorSpace_DeviceGray, 1 ) );
+        Keep( gray, BenchConvertImages( sData, ePdfColorSpace_DeviceGray, 0 ) );
+        Keep( cmyk, BenchConvertImages( sData, ePdfColorSpace_DeviceCMYK, 0 ) );
+    }
+
+    Report( pszCorpus, "convert-gray-1-thread", serial );
+    Report( pszCorpus, "convert-gray", gray );
+    Report( pszCorpus, "convert-cmyk", cmyk );
+}
+
+/** Counts the operators reported by PdfContentsParser
+ */
+class CountingHandler : public PdfContentsHandler {
+public:
+    CountingHandler()
+        : m_lOperators( 0 )
+    {
+    }
+
+    virtual void HandleOperator( EPdfContentsOperator, const PdfContentsOperand*, int )
+    {
+        ++m_lOperators;
+    }
+
+    virtual void HandleUnknownOperator( const char*, pdf_long, const PdfContentsOperand*, int )
+    {
+        ++m_lOperators;
+    }
+
+    long m_lOperators;
+};
+
+/** Read all operators of the decoded content streams of a document,
+ *  either with PdfContentsTokenizer or with PdfContentsParser.
+ *  Objects are counted as operators.
+ */
+static TResult BenchContents( const std::vector<std::string> & vecContents, bool bParser )
+{
+    TResult result;
+    long    lOperators = 0;
+    double  dBytes     = 0.0;
+
+    double dStart  = GetTime();
+    double dCycles = GetCycles();
+    for( size_t i = 0; i < vecContents.size(); i++ )
+    {
+        const std::string & sContents = vecContents[i];
+
+        if( bParser )
+        {
+            PdfContentsParser parser( sContents.data(), static_cast<pdf_long>(sContents.size()) );
+            CountingHandler   handler;
+
+            parser.Parse( handler );
+            lOperators += handler.m_lOperators;
+        }
+        else
+        {
+            PdfContentsTokenizer tokenizer( sContents.data(), static_cast<long>(sContents.size()) );
+            EPdfContentsType     eType;
+            const char*          pszKeyword;
+            PdfVariant           var;
+
+            while( tokenizer.ReadNext( eType, pszKeyword, var ) )
+            {
+                if( eType == ePdfContentsType_Keyword )
+                    ++lOperators;
+            }
+        }
+
+        dBytes += static_cast<double>(sContents.size());
+    }
+
+    result.dCycles  = GetCycles() - dCycles;
+    result.dSeconds = GetTime() - dStart;
+    result.dBytes   = dBytes;
+    result.dObjects = static_cast<double>(lOperators);
+    return result;
+}
+
+static void RunContents( const char* pszCorpus, const std::string & sData, int nRepeat )
+{
+    TResult                  tokenizer = { -1.0, 0.0, 0.0, 0.0 };
+    TResult                  parser    = { -1.0, 0.0, 0.0, 0.0 };
+    std::vector<std::string> vecContents;
+    PdfMemDocument           doc;
+
+    // Decode all content streams up front, so that only reading the operators is measured
+    doc.Load( sData.data(), static_cast<long>(sData.size()) );
+    for( int i = 0; i < doc.GetPageCount(); i++ )
+    {
+        PdfObject* pContents = doc.GetPage( i )->GetContents();
+        if( pContents && pContents->HasStream() )
+        {
+            char*    pBuffer;
+            pdf_long lLen;
+
+            pContents->GetStream()->GetFilteredCopy( &pBuffer, &lLen );
+            vecContents.push_back( std::string( pBuffer, lLen ) );
+            free( pBuffer );
+        }
+    }
+
+    for( int i = 0; i < nRepeat; i++ )
+    {
+        Keep( tokenizer, BenchContents( vecContents, false ) );
+        Keep( parser, BenchContents( vecContents, true ) );
+    }
+
+    Report( pszCorpus, "contents-tokenizer", tokenizer );
+    Report( pszCorpus, "contents-parser", parser );
+}
+
+/** Convert all strings from UTF-8 to UTF-16BE and back.
+ *  Bytes are counted on the UTF-8 side in both directions.
+ */
+static void BenchTranscode( const std::vector<std::string> & vecText, TResult* pToUtf16, TResult* pToUtf8 )
+{
+    std::vector<std::vector<pdf_utf16be> > vecUtf16( vecText.size() );
+    std::vector<pdf_utf8>                  vecUtf8;
+    double                                 dStart;
+    double                                 dCycles;
+    double                                 dBytes = 0.0;
+    size_t                                 nMax   = 0;
+    size_t                                 i;
+
+    for( i = 0; i < vecText.size(); i++ )
+    {
+        // Neither conversion needs more characters than UTF-8 bytes, plus the terminating zero
+        vecUtf16[i].resize( vecText[i].size() + 1 );
+        nMax    = PDF_MAX( nMax, vecText[i].size() );
+        dBytes += static_cast<double>(vecText[i].size());
+    }
+
+    dStart  = GetTime();
+    dCycles = GetCycles();
+    for( i = 0; i < vecText.size(); i++ )
+    {
+        pdf_long lLen = PdfString::ConvertUTF8toUTF16( reinterpret_cast<const pdf_utf8*>(vecText[i].c_str()),
+                                                       static_cast<pdf_long>(vecText[i].size()),
+                                                       &vecUtf16[i][0], static_cast<pdf_long>(vecUtf16[i].size()) );
+        // Drop the terminating zero
+        vecUtf16[i].resize( lLen - 1 );
+    }
+
+    pToUtf16->dCycles  = GetCycles() - dCycles;
+    pToUtf16->dSeconds = GetTime() - dStart;
+    pToUtf16->dBytes   = dBytes;
+    pToUtf16->dObjects = static_cast<double>(vecText.size());
+
+    vecUtf8.resize( nMax + 1 );
+
+    dStart  = GetTime();
+    dCycles = GetCycles();
+    for( i = 0; i < vecText.size(); i++ )
+    {
+        PdfString::ConvertUTF16toUTF8( vecUtf16[i].empty() ? NULL : &vecUtf16[i][0], 
+                                       static_cast<pdf_long>(vecUtf16[i].size()),
+                                       &vecUtf8[0], static_cast<pdf_long>(vecUtf8.size()) );
+    }
+
+    pToUtf8->dCycles  = GetCycles() - dCycles;
+    pToUtf8->dSeconds = GetTime() - dStart;
+    pToUtf8->dBytes   = dBytes;
+    pToUtf8->dObjects = static_cast<double>(vecText.size());
+}
+
+static void RunText( const char* pszCorpus, const std::vector<std::string> & vecText, int nRepeat )
+{
+    TResult toUtf16 = { -1.0, 0.0, 0.0, 0.0 };
+    TResult toUtf8  = { -1.0, 0.0, 0.0, 0.0 };
+
+    for( int i = 0; i < nRepeat; i++ )
+    {
+        TResult u16, u8;
+
+        BenchTranscode( vecText, &u16, &u8 );
+        Keep( toUtf16, u16 );
+        Keep( toUtf8, u8 );
+    }
+
+    Report( pszCorpus, "utf8-to-utf16", toUtf16 );
+    Report( pszCorpus, "utf16-to-utf8", toUtf8 );
+}
+
+static void print_help()
+{
+    printf("Usage: Benchmark [-r repeat] [-s scale] [-c corpus] [-w prefix]\n\n");
+    printf("       -r repeat  run each benchmark this often and report the fastest run (default 3)\n");
+    printf("       -s scale   multiply the size of all corpora (default 1)\n");
+    printf("       -c corpus  run only this corpus: small-objects, xref-stream,\n");
+    printf("                  big-streams, deep-page-tree, object-streams,\n");
+    printf("                  photo-images, latin-text, mixed-text or cjk-text\n");
+    printf("       -w prefix  also write the corpora to files starting with prefix\n\n");
+    printf("Results are written as CSV to stdout, best run of each phase.\n");
+    printf("MB/s is computed on the input for tokenize, parse and load,\n");
+    printf("on the decoded data for decode and on the output for write and serialize.\n");
+    printf("serialize-printf writes the same objects and xref entries as serialize,\n");
+    printf("but formats numbers with printf as PoDoFo used to.\n");
+    printf("The text corpora measure UTF-8/UTF-16BE conversion, counted on the UTF-8 side.\n");
+    printf("photo-images also measures converting all images to DeviceGray and DeviceCMYK\n");
+    printf("on one thread and on one thread per CPU, counted on the decoded images.\n");
+    printf("big-streams also measures reading all operators of the decoded content streams\n");
+    printf("with PdfContentsTokenizer and with PdfContentsParser.\n");
+    printf("Bytes per cycle are only measured on x86, elsewhere they are reported as 0.\n");
+}
+
+int main( int argc, char* argv[] )
+{
+    int         nRepeat   = 3;
+    int         nScale    = 1;
+    const char* pszCorpus = NULL;
+    const char* pszPrefix = NULL;
+
+    for( int i = 1; i < argc; i++ )
+    {
+        if( i + 1 < argc && strcmp( argv[i], "-r" ) == 0 )
+            nRepeat = atoi( argv[++i] );
+        else if( i + 1 < argc && strcmp( argv[i], "-s" ) == 0 )
+            nScale = atoi( argv[++i] );
+        else if( i + 1 < argc && strcmp( argv[i], "-c" ) == 0 )
+            pszCorpus = argv[++i];
+        else if( i + 1 < argc && strcmp( argv[i], "-w" ) == 0 )
+            pszPrefix = argv[++i];
+        else
+        {
+            print_help();
+            return -1;
+        }
+    }
+
+    if( nRepeat < 1 || nScale < 1 )
+    {
+        print_help();
+        return -1;
+    }
+
+    // Logging goes to stderr and would disturb the timing
+    PdfError::EnableLogging( false );
+    PdfError::EnableDebug( false );
+
+    const char* ppszCorpora[] = {
+        "small-objects", "xref-stream", "big-streams", "deep-page-tree", "object-streams", "photo-images", NULL
+    };
+
+    const char* ppszText[] = {
+        "latin-text", "mixed-text", "cjk-text", NULL
+    };
+
+    // Percentage of CJK words in each of the text corpora
+    const int pnCJK[] = { 0, 30, 90 };
+
+    printf("corpus,phase,bytes,objects,seconds,mb_per_s,objects_per_s,bytes_per_cycle\n");
+
+    try {
+        for( int i = 0; ppszCorpora[i]; i++ )
+        {
+            if( pszCorpus && strcmp( pszCorpus, ppszCorpora[i] ) != 0 )
+                continue;
+
+            std::string sData;
+
+            s_nSeed = 42;
+            switch( i )
+            {
+                case 0: sData = CreateSmallObjects( nScale, false ); break;
+                case 1: sData = CreateSmallObjects( nScale, true ); break;
+                case 2: sData = CreateBigStreams( nScale ); break;
+                case 3: sData = CreateDeepPageTree( nScale ); break;
+                case 4: sData = CreateObjectStreams( nScale ); break;
+                default: sData = CreatePhotoImages( nScale ); break;
+            }
+
+            if( pszPrefix )
+            {
+                std::string sFilename = std::string( pszPrefix ) + ppszCorpora[i] + ".pdf";
+                FILE*       hFile     = fopen( sFilename.c_str(), "wb" );
+                if( !hFile )
+                {
+                    PODOFO_RAISE_ERROR_INFO( ePdfError_FileNotFound, sFilename.c_str() );
+                }
+
+                fwrite( sData.data(), 1, sData.size(), hFile );
+                fclose( hFile );
+            }
+
+            RunCorpus( ppszCorpora[i], sData, nRepeat );
+            if( strcmp( ppszCorpora[i], "big-streams" ) == 0 )
+                RunContents( ppszCorpora[i], sData, nRepeat );
+            if( strcmp( ppszCorpora[i], "photo-images" ) == 0 )
+                RunImages( ppszCorpora[i], sData, nRepeat );
+        }
+
+        for( int i = 0; ppszText[i]; i++ )
+        {
+            if( pszCorpus && strcmp( pszCorpus, ppszText[i] ) != 0 )
+                continue;
+
+            s_nSeed = 42;
+            RunText( ppszText[i], CreateText( nScale, pnCJK[i] ), nRepeat );
+        }
+    } catch( const PdfError & e ) {
+        e.PrintErrorMsg();
+        return e.GetError();
+    }
+
+    return 0;
+}
@@ -203,7 +203,8 @@ void CreateSimpleForm( PdfPage* pPage, PdfStreamedDocument* pDoc )
 
 void FillTextField( PdfTextField & rField ) 
 {
-    const char* pszCur = rField.GetText().GetString();
+    PdfString   sCur   = rField.GetText();
+    const char* pszCur = sCur.GetString();
     std::cout << "  Current value:" << (pszCur ? pszCur : "") << std::endl;
 
     std::string value;
@@ -218,14 +219,16 @@ void FillTextField( PdfTextField & rField )
 
 void FillListField( PdfListField & rField ) 
 {
-    const char* pszCur = ( rField.GetSelectedItem() == -1 ? NULL : 
-                           rField.GetItemDisplayText( rField.GetSelectedItem() ).GetString() );
+    PdfString   sCur   = ( rField.GetSelectedItem() == -1 ? PdfString() : 
+                           rField.GetItemDisplayText( rField.GetSelectedItem() ) );
+    const char* pszCur = sCur.GetString();
     std::cout << "  Current value:" << (pszCur ? pszCur : "") << std::endl;
     std::cout << "  Values:" << std::endl;
     
     for( int i=0;i<static_cast<int>(rField.GetItemCount());i++ )
     {
-        pszCur = rField.GetItemDisplayText( i ).GetString();
+        sCur   = rField.GetItemDisplayText( i );
+        pszCur = sCur.GetString();
         std::cout << "     " << i << " " << (pszCur ? pszCur : "") << std::endl;
     }
 
@@ -0,0 +1,363 @@
+/***************************************************************************
+ *   Copyright (C) 2013 by Dominik Seichter                                *
+ *   domseichter@web.de                                                    *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Library General Public License as       *
+ *   published by the Free Software Foundation; either version 2 of the    *
+ *   License, or (at your option) any later version.                       *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this program; if not, write to the                 *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#include "ContentsParserTest.h"
+
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+using namespace PoDoFo;
+
+// Registers the fixture into the 'registry'
+CPPUNIT_TEST_SUITE_REGISTRATION( ContentsParserTest );
+
+/** An operator or inline image with all its operands
+ *  written as strings
+ */
+struct TContentsEvent {
+    std::string              sOperator;
+    std::vector<std::string> vecOperands;
+    std::string              sImageData;
+};
+
+static std::string OperandToString( const PdfContentsOperand & rOperand )
+{
+    PdfVariant  variant;
+    std::string sResult;
+
+    rOperand.ToVariant( variant );
+    variant.ToString( sResult, ePdfWriteMode_Compact );
+    return sResult;
+}
+
+/** Records all events of a PdfContentsParser
+ */
+class RecordingHandler : public PdfContentsHandler {
+ public:
+    RecordingHandler( std::vector<TContentsEvent> & rEvents )
+        : m_rEvents( rEvents ), m_nMaxOperands( 0 )
+    {
+    }
+
+    virtual void HandleOperator( EPdfContentsOperator eOperator, const PdfContentsOperand* pOperands, int nOperands )
+    {
+        Add( PdfContentsParser::GetOperatorName( eOperator ), pOperands, nOperands );
+    }
+
+    virtual void HandleUnknownOperator( const char* pszOperator, pdf_long lLen, const PdfContentsOperand* pOperands, int nOperands )
+    {
+        Add( std::string( pszOperator, lLen ), pOperands, nOperands );
+    }
+
+    virtual void HandleInlineImage( const PdfContentsOperand* pOperands, int nOperands, const char* pData, pdf_long lLen )
+    {
+        // Record it the way PdfContentsTokenizer returns it
+        Add( "BI", NULL, 0 );
+        Add( "ID", pOperands, nOperands );
+        m_rEvents.back().sImageData = std::string( pData, lLen );
+        Add( "EI", NULL, 0 );
+    }
+
+    int GetMaxOperands() const { return m_nMaxOperands; }
+
+ private:
+    void Add( const std::string & sOperator, const PdfContentsOperand* pOperands, int nOperands )
+    {
+        TContentsEvent event;
+        event.sOperator = sOperator;
+        for( int i = 0; i < nOperands; i++ )
+            event.vecOperands.push_back( OperandToString( pOperands[i] ) );
+
+        m_rEvents.push_back( event );
+        m_nMaxOperands = PDF_MAX( m_nMaxOperands, nOperands );
+    }
+
+    std::vector<TContentsEvent> & m_rEvents;
+    int                           m_nMaxOperands;
+};
+
+/** Keeps the operands of the last operator
+ */
+class LastOperatorHandler : public PdfContentsHandler {
+ public:
+    LastOperatorHandler()
+        : m_eOperator( ePdfContentsOperator_Unknown ), m_nOperands( 0 )
+    {
+    }
+
+    virtual void HandleOperator( EPdfContentsOperator eOperator, const PdfContentsOperand* pOperands, int nOperands )
+    {
+        m_eOperator = eOperator;
+        m_nOperands = nOperands;
+        for( int i = 0; i < nOperands && i < 16; i++ )
+            m_aOperands[i] = pOperands[i];
+    }
+
+    EPdfContentsOperator m_eOperator;
+    PdfContentsOperand   m_aOperands[16];
+    int                  m_nOperands;
+};
+
+void ContentsParserTest::setUp()
+{
+}
+
+void ContentsParserTest::tearDown()
+{
+}
+
+void ContentsParserTest::testOperators()
+{
+    for( int i = ePdfContentsOperator_b; i < ePdfContentsOperator_Unknown; i++ )
+    {
+        EPdfContentsOperator eOperator = static_cast<EPdfContentsOperator>(i);
+        const char*          pszName   = PdfContentsParser::GetOperatorName( eOperator );
+
+        CPPUNIT_ASSERT( pszName != NULL );
+        CPPUNIT_ASSERT_EQUAL_MESSAGE( pszName, eOperator, 
+                                      PdfContentsParser::FindOperator( pszName, strlen( pszName ) ) );
+    }
+
+    const char* ppszUnknown[] = { "R", "obj", "Tjx", "BDCX", "T", "E", "b**", "sC", "true", NULL };
+    for( int i = 0; ppszUnknown[i]; i++ )
+    {
+        CPPUNIT_ASSERT_EQUAL_MESSAGE( ppszUnknown[i], ePdfContentsOperator_Unknown, 
+                                      PdfContentsParser::FindOperator( ppszUnknown[i], strlen( ppszUnknown[i] ) ) );
+    }
+
+    // Operators do not need to be terminated by a zero byte
+    CPPUNIT_ASSERT_EQUAL( ePdfContentsOperator_Tf, PdfContentsParser::FindOperator( "Tfx", 2 ) );
+    CPPUNIT_ASSERT_EQUAL( ePdfContentsOperator_Unknown, PdfContentsParser::FindOperator( "", 0 ) );
+    CPPUNIT_ASSERT( PdfContentsParser::GetOperatorName( ePdfContentsOperator_Unknown ) == NULL );
+}
+
+void ContentsParserTest::testOperands()
+{
+    const char*         pszContents = "1 -2.5 +.5 4. 007 /Name#20x true false null 12345678901234567890 re";
+    PdfContentsParser   parser( pszContents, strlen( pszContents ) );
+    LastOperatorHandler handler;
+
+    parser.Parse( handler );
+
+    CPPUNIT_ASSERT_EQUAL( ePdfContentsOperator_re, handler.m_eOperator );
+    CPPUNIT_ASSERT_EQUAL( 10, handler.m_nOperands );
+
+    const PdfContentsOperand* pOperands = handler.m_aOperands;
+    CPPUNIT_ASSERT_EQUAL( ePdfContentsOperandType_Number, pOperands[0].GetType() );
+    CPPUNIT_ASSERT_EQUAL( static_cast<pdf_int64>(1), pOperands[0].GetNumber() );
+    CPPUNIT_ASSERT_EQUAL( ePdfContentsOperandType_Real, pOperands[1].GetType() );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( -2.5, pOperands[1].GetReal(), 0.0 );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 0.5, pOperands[2].GetReal(), 0.0 );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 4.0, pOperands[3].GetReal(), 0.0 );
+    CPPUNIT_ASSERT_EQUAL( ePdfContentsOperandType_Number, pOperands[4].GetType() );
+    CPPUNIT_ASSERT_EQUAL( static_cast<pdf_int64>(7), pOperands[4].GetNumber() );
+
+    CPPUNIT_ASSERT_EQUAL( ePdfContentsOperandType_Name, pOperands[5].GetType() );
+    CPPUNIT_ASSERT_EQUAL( std::string( "Name#20x" ), std::string( pOperands[5].GetData(), pOperands[5].GetLength() ) );
+    CPPUNIT_ASSERT( pOperands[5].IsName( "Name x" ) );
+    CPPUNIT_ASSERT( !pOperands[5].IsName( "Name" ) );
+    CPPUNIT_ASSERT( !pOperands[5].IsName( "Name xy" ) );
+    CPPUNIT_ASSERT_EQUAL( PdfName( "Name x" ), pOperands[5].ToName() );
+
+    CPPUNIT_ASSERT_EQUAL( true, pOperands[6].GetBool() );
+    CPPUNIT_ASSERT_EQUAL( false, pOperands[7].GetBool() );
+    CPPUNIT_ASSERT_EQUAL( ePdfContentsOperandType_Null, pOperands[8].GetType() );
+
+    // Too large for an integer
+    CPPUNIT_ASSERT_EQUAL( ePdfContentsOperandType_Real, pOperands[9].GetType() );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 12345678901234567890.0, pOperands[9].GetReal(), 1e5 );
+
+    CPPUNIT_ASSERT_THROW( pOperands[5].GetReal(), PdfError );
+    CPPUNIT_ASSERT_THROW( pOperands[0].GetBool(), PdfError );
+    CPPUNIT_ASSERT_THROW( pOperands[0].ToName(), PdfError );
+}
+
+void ContentsParserTest::testStrings()
+{
+    const char*         pszContents = "(a\\(b\\)c\\n\\101\\0612\\\nd(e)) <48 65 6C6C 6F7> (unterminated";
+    PdfContentsParser   parser( pszContents, strlen( pszContents ) );
+    LastOperatorHandler handler;
+    char                szBuffer[64];
+    pdf_long            lLen;
+
+    // Without an operator at the end nothing is reported
+    parser.Parse( handler );
+    CPPUNIT_ASSERT_EQUAL( ePdfContentsOperator_Unknown, handler.m_eOperator );
+
+    const char*       pszShow = "(a\\(b\\)c\\n\\101\\0612\\\nd(e)) <48 65 6C6C 6F7> Tj";
+    PdfContentsParser parser2( pszShow, strlen( pszShow ) );
+    parser2.Parse( handler );
+
+    CPPUNIT_ASSERT_EQUAL( ePdfContentsOperator_Tj, handler.m_eOperator );
+    CPPUNIT_ASSERT_EQUAL( 2, handler.m_nOperands );
+
+    CPPUNIT_ASSERT_EQUAL( ePdfContentsOperandType_String, handler.m_aOperands[0].GetType() );
+    lLen = handler.m_aOperands[0].DecodeString( szBuffer );
+    CPPUNIT_ASSERT_EQUAL( std::string( "a(b)c\nA12d(e)" ), std::string( szBuffer, lLen ) );
+    CPPUNIT_ASSERT_EQUAL( std::string( "a(b)c\nA12d(e)" ), handler.m_aOperands[0].ToString().GetStringUtf8() );
+
+    CPPUNIT_ASSERT_EQUAL( ePdfContentsOperandType_HexString, handler.m_aOperands[1].GetType() );
+    lLen = handler.m_aOperands[1].DecodeString( szBuffer );
+    CPPUNIT_ASSERT_EQUAL( std::string( "Hellop" ), std::string( szBuffer, lLen ) );
+    CPPUNIT_ASSERT( handler.m_aOperands[1].ToString().IsHex() );
+}
+
+void ContentsParserTest::testArrays()
+{
+    const char*         pszContents = "[(A) -120 <42> [1 2] << /K [3] >> /N] TJ";
+    PdfContentsParser   parser( pszContents, strlen( pszContents ) );
+    LastOperatorHandler handler;
+    PdfContentsOperand  element;
+    pdf_long            lPos = 0;
+
+    parser.Parse( handler );
+    CPPUNIT_ASSERT_EQUAL( ePdfContentsOperator_TJ, handler.m_eOperator );
+    CPPUNIT_ASSERT_EQUAL( 1, handler.m_nOperands );
+
+    const PdfContentsOperand & rArray = handler.m_aOperands[0];
+    CPPUNIT_ASSERT_EQUAL( ePdfContentsOperandType_Array, rArray.GetType() );
+    CPPUNIT_ASSERT_EQUAL( std::string( "[(A) -120 <42> [1 2] << /K [3] >> /N]" ), 
+                          std::string( rArray.GetData(), rArray.GetLength() ) );
+
+    const EPdfContentsOperandType aeTypes[] = {
+        ePdfContentsOperandType_String, ePdfContentsOperandType_Number, ePdfContentsOperandType_HexString,
+        ePdfContentsOperandType_Array, ePdfContentsOperandType_Dictionary, ePdfContentsOperandType_Name
+    };
+
+    for( int i = 0; i < 6; i++ )
+    {
+        CPPUNIT_ASSERT( rArray.GetNextElement( lPos, element ) );
+        CPPUNIT_ASSERT_EQUAL( aeTypes[i], element.GetType() );
+    }
+
+    CPPUNIT_ASSERT( !rArray.GetNextElement( lPos, element ) );
+    CPPUNIT_ASSERT( !rArray.GetNextElement( lPos, element ) );
+
+    PdfVariant variant;
+    rArray.ToVariant( variant );
+    CPPUNIT_ASSERT( variant.IsArray() );
+    CPPUNIT_ASSERT_EQUAL( static_cast<size_t>(6), variant.GetArray().GetSize() );
+    CPPUNIT_ASSERT_EQUAL( static_cast<pdf_int64>(-120), variant.GetArray()[1].GetNumber() );
+}
+
+void ContentsParserTest::testInlineImage()
+{
+    const char                  pszContents[] = "q BI /W 4 /H 1 /CS /G /BPC 8 ID \001EI\002E\n\003 EI Q";
+    std::vector<TContentsEvent> vecEvents;
+    RecordingHandler            handler( vecEvents );
+    PdfContentsParser           parser( pszContents, sizeof(pszContents) - 1 );
+
+    parser.Parse( handler );
+
+    CPPUNIT_ASSERT_EQUAL( static_cast<size_t>(5), vecEvents.size() );
+    CPPUNIT_ASSERT_EQUAL( std::string( "q" ), vecEvents[0].sOperator );
+    CPPUNIT_ASSERT_EQUAL( std::string( "BI" ), vecEvents[1].sOperator );
+    CPPUNIT_ASSERT_EQUAL( std::string( "ID" ), vecEvents[2].sOperator );
+    CPPUNIT_ASSERT_EQUAL( static_cast<size_t>(8), vecEvents[2].vecOperands.size() );
+    CPPUNIT_ASSERT_EQUAL( std::string( "\001EI\002E\n\003 " ), vecEvents[2].sImageData );
+    CPPUNIT_ASSERT_EQUAL( std::string( "EI" ), vecEvents[3].sOperator );
+    CPPUNIT_ASSERT_EQUAL( std::string( "Q" ), vecEvents[4].sOperator );
+}
+
+void ContentsParserTest::testStackOverflow()
+{
+    std::string sContents;
+    char        szNumber[16];
+    
+    for( int i = 0; i < PdfContentsParser::MAX_OPERANDS + 10; i++ )
+    {
+        sprintf( szNumber, "%i ", i );
+        sContents += szNumber;
+    }
+
+    sContents += "m 1 2 l";
+
+    PdfContentsParser   parser( sContents.c_str(), sContents.length() );
+    LastOperatorHandler handler;
+    parser.Parse( handler );
+
+    // The last operator gets only its own operands
+    CPPUNIT_ASSERT_EQUAL( ePdfContentsOperator_l, handler.m_eOperator );
+    CPPUNIT_ASSERT_EQUAL( 2, handler.m_nOperands );
+
+    std::vector<TContentsEvent> vecEvents;
+    RecordingHandler            recorder( vecEvents );
+    parser.Parse( recorder );
+
+    // The oldest operands are dropped
+    CPPUNIT_ASSERT_EQUAL( static_cast<int>(PdfContentsParser::MAX_OPERANDS), recorder.GetMaxOperands() );
+    CPPUNIT_ASSERT_EQUAL( std::string( " 10" ), vecEvents[0].vecOperands.front() );
+    CPPUNIT_ASSERT_EQUAL( std::string( " 137" ), vecEvents[0].vecOperands.back() );
+}
+
+void ContentsParserTest::testCompareWithTokenizer()
+{
+    const char pszContents[] = 
+        "q 1 0 0 1 72.5 -3 cm BT /F1 12 Tf (Hello \\(World\\)\\n) Tj\n"
+        "[(A) -120 <4142> 5.5 (B)] TJ 0.5 0 Td T* 2 Tz 1 Tc ET /GS0 gs [3 2] 0 d\n"
+        "0.1 0.2 0.3 rg /P0 scn /Span <</MCID 3 /Lang (en)>> BDC EMC\n"
+        "1 2 3 4 re W* n % a comment\n"
+        "BI /W 2 /H 1 /BPC 8 /CS /G ID \001\002\nEI Q /Im1 Do\n"
+        "BX /Tag true false null foo EX";
+
+    std::vector<TContentsEvent> vecParser;
+    RecordingHandler            handler( vecParser );
+    PdfContentsParser           parser( pszContents, sizeof(pszContents) - 1 );
+    parser.Parse( handler );
+
+    std::vector<TContentsEvent> vecTokenizer;
+    std::vector<std::string>    vecOperands;
+    PdfContentsTokenizer        tokenizer( pszContents, sizeof(pszContents) - 1 );
+    EPdfContentsType            eType;
+    const char*                 pszKeyword;
+    PdfVariant                  variant;
+
+    while( tokenizer.ReadNext( eType, pszKeyword, variant ) )
+    {
+        if( eType == ePdfContentsType_Keyword )
+        {
+            TContentsEvent event;
+            event.sOperator   = pszKeyword;
+            event.vecOperands = vecOperands;
+            vecTokenizer.push_back( event );
+            vecOperands.clear();
+        }
+        else if( eType == ePdfContentsType_ImageData )
+            vecTokenizer.back().sImageData = std::string( variant.GetRawData().data() );
+        else
+        {
+            std::string sOperand;
+            variant.ToString( sOperand, ePdfWriteMode_Compact );
+            vecOperands.push_back( sOperand );
+        }
+    }
+
+    CPPUNIT_ASSERT_EQUAL( vecTokenizer.size(), vecParser.size() );
+    for( size_t i = 0; i < vecParser.size(); i++ )
+    {
+        CPPUNIT_ASSERT_EQUAL( vecTokenizer[i].sOperator, vecParser[i].sOperator );
+        CPPUNIT_ASSERT_EQUAL( vecTokenizer[i].sImageData, vecParser[i].sImageData );
+        CPPUNIT_ASSERT_EQUAL( vecTokenizer[i].vecOperands.size(), vecParser[i].vecOperands.size() );
+        for( size_t j = 0; j < vecParser[i].vecOperands.size(); j++ )
+            CPPUNIT_ASSERT_EQUAL( vecTokenizer[i].vecOperands[j], vecParser[i].vecOperands[j] );
+    }
+}
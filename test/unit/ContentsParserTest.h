@@ -0,0 +1,55 @@
+/***************************************************************************
+ *   Copyright (C) 2013 by Dominik Seichter                                *
+ *   domseichter@web.de                                                    *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Library General Public License as       *
+ *   published by the Free Software Foundation; either version 2 of the    *
+ *   License, or (at your option) any later version.                       *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this program; if not, write to the                 *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#ifndef _CONTENTS_PARSER_TEST_H_
+#define _CONTENTS_PARSER_TEST_H_
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <podofo.h>
+
+/** This test tests the class PdfContentsParser
+ */
+class ContentsParserTest : public CppUnit::TestFixture
+{
+  CPPUNIT_TEST_SUITE( ContentsParserTest );
+  CPPUNIT_TEST( testOperators );
+  CPPUNIT_TEST( testOperands );
+  CPPUNIT_TEST( testStrings );
+  CPPUNIT_TEST( testArrays );
+  CPPUNIT_TEST( testInlineImage );
+  CPPUNIT_TEST( testStackOverflow );
+  CPPUNIT_TEST( testCompareWithTokenizer );
+  CPPUNIT_TEST_SUITE_END();
+
+ public:
+  void setUp();
+  void tearDown();
+
+  void testOperators();
+  void testOperands();
+  void testStrings();
+  void testArrays();
+  void testInlineImage();
+  void testStackOverflow();
+  void testCompareWithTokenizer();
+};
+
+#endif // _CONTENTS_PARSER_TEST_H_
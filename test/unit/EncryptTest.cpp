@@ -22,6 +22,8 @@
 #include "TestUtils.h"
 
 #include <stdlib.h>
+#include <string.h>
+#include <vector>
 
 using namespace PoDoFo;
 
@@ -146,9 +148,7 @@ void EncryptTest::testAESV2()
                                                          PdfEncrypt::ePdfKeyLength_128 );
 
     TestAuthenticate( pEncrypt, 128, 4 );
-    // AES decryption is not yet implemented.
-    // Therefore we have to disable this test.
-    // TestEncrypt( pEncrypt );
+    TestEncrypt( pEncrypt );
 
     delete pEncrypt;
 }
@@ -161,9 +161,7 @@ void EncryptTest::testAESV3()
                                                         PdfEncrypt::ePdfKeyLength_256 );
     
     TestAuthenticate( pEncrypt, 256, 5 );
-    // AES decryption is not yet implemented.
-    // Therefore we have to disable this test.
-    // TestEncrypt( pEncrypt );
+    TestEncrypt( pEncrypt );
     
     delete pEncrypt;
 }
@@ -204,14 +202,225 @@ void EncryptTest::TestEncrypt( PdfEncrypt* pEncrypt )
     // Encrypt buffer
     pEncrypt->Encrypt( pOutputBuffer, m_lLen );
     // Decrypt buffer
-    pEncrypt->Encrypt( pOutputBuffer, m_lLen );
+    unsigned char *pDecryptedBuffer = new unsigned char[nOutputLen];
+    pdf_long lDecryptedLen = 0;
+    pEncrypt->Decrypt( pOutputBuffer, nOutputLen, pDecryptedBuffer, lDecryptedLen );
 
+    CPPUNIT_ASSERT_EQUAL_MESSAGE( "compare encrypted and decrypted length",
+                                  static_cast<pdf_long>(m_lLen), lDecryptedLen );
     CPPUNIT_ASSERT_EQUAL_MESSAGE( "compare encrypted and decrypted buffer",
-                                  0, memcmp( m_pEncBuffer, pOutputBuffer+nOffset, m_lLen ) );
+                                  0, memcmp( m_pEncBuffer, pDecryptedBuffer, m_lLen ) );
 
+    delete[] pDecryptedBuffer;
     delete[] pOutputBuffer;
 }
 
+void EncryptTest::TestEncryptStreams( PdfEncrypt* pEncrypt, pdf_long lLen, pdf_long lChunk )
+{
+    std::vector<char> data( lLen + 1 );
+    for( pdf_long i = 0; i < lLen; i++ )
+        data[i] = static_cast<char>((i * 7 + i / 251) & 0xff);
+
+    // Encrypt using the output stream
+    PdfMemoryOutputStream encrypted;
+    PdfOutputStream*      pOutput = pEncrypt->CreateEncryptionOutputStream( &encrypted );
+    for( pdf_long lPos = 0; lPos < lLen; lPos += lChunk )
+        pOutput->Write( &data[lPos], PDF_MIN( lChunk, lLen - lPos ) );
+
+    pOutput->Close();
+    delete pOutput;
+
+    const pdf_long lEncryptedLen = encrypted.GetLength();
+    CPPUNIT_ASSERT_EQUAL( pEncrypt->CalculateStreamLength( lLen ), lEncryptedLen );
+
+    // Additional data after the encrypted data, like endstream in a PDF,
+    // must not be read by the input stream
+    encrypted.Write( "endstream", 9 );
+    char* pEncrypted = encrypted.TakeBuffer();
+
+    // The buffer based decryption must give the same result
+    std::vector<unsigned char> decrypted( lEncryptedLen + 1 );
+    pdf_long                   lDecryptedLen = 0;
+    pEncrypt->Decrypt( reinterpret_cast<unsigned char*>(pEncrypted), lEncryptedLen, &decrypted[0], lDecryptedLen );
+    CPPUNIT_ASSERT_EQUAL( lLen, lDecryptedLen );
+    CPPUNIT_ASSERT( memcmp( &data[0], &decrypted[0], lLen ) == 0 );
+
+    // Decrypt using the input stream with large reads
+    PdfMemoryInputStream input( pEncrypted, lEncryptedLen + 9 );
+    PdfInputStream*      pInput = pEncrypt->CreateEncryptionInputStream( &input, lEncryptedLen );
+    std::vector<char>    result( lLen + 1 );
+    pdf_long             lRead  = 0;
+    pdf_long             lCur;
+    while( (lCur = pInput->Read( &result[lRead], PDF_MIN( static_cast<pdf_long>(100000), lLen + 1 - lRead ) )) > 0 )
+        lRead += lCur;
+
+    delete pInput;
+    CPPUNIT_ASSERT_EQUAL( lLen, lRead );
+    CPPUNIT_ASSERT( memcmp( &data[0], &result[0], lLen ) == 0 );
+
+    char cRest[9];
+    CPPUNIT_ASSERT_EQUAL( static_cast<pdf_long>(9), input.Read( cRest, 9 ) );
+    CPPUNIT_ASSERT( memcmp( cRest, "endstream", 9 ) == 0 );
+
+    // Decrypt using the input stream with 1 byte reads
+    // and read until the end of the underlying stream
+    PdfMemoryInputStream input2( pEncrypted, lEncryptedLen );
+    pInput = pEncrypt->CreateEncryptionInputStream( &input2 );
+    for( lRead = 0; lRead < lLen; lRead++ )
+    {
+        char c;
+        CPPUNIT_ASSERT_EQUAL( static_cast<pdf_long>(1), pInput->Read( &c, 1 ) );
+        CPPUNIT_ASSERT_EQUAL( data[lRead], c );
+    }
+
+    char c;
+    CPPUNIT_ASSERT_EQUAL( static_cast<pdf_long>(0), pInput->Read( &c, 1 ) );
+    delete pInput;
+
+    podofo_free( pEncrypted );
+}
+
+void EncryptTest::testAESStreams()
+{
+    // Lengths around the AES block size and the 256 KB blocks of the input stream
+    const pdf_long lLengths[] = { 0, 1, 15, 16, 17, 31, 32, 1000, 
+                                  256 * 1024 - 1, 256 * 1024, 256 * 1024 + 1, 256 * 1024 + 16,
+                                  600 * 1024 + 5 };
+    const pdf_long lChunks[]  = { 1, 16, 4097 };
+
+    std::vector<PdfEncrypt*> vecEncrypt;
+    vecEncrypt.push_back( PdfEncrypt::CreatePdfEncrypt( "user", "podofo", m_protection, 
+                                                        PdfEncrypt::ePdfEncryptAlgorithm_AESV2, 
+                                                        PdfEncrypt::ePdfKeyLength_128 ) );
+#ifdef PODOFO_HAVE_CRYPTO_LIBS
+    vecEncrypt.push_back( PdfEncrypt::CreatePdfEncrypt( "user", "podofo", m_protection, 
+                                                        PdfEncrypt::ePdfEncryptAlgorithm_AESV3, 
+                                                        PdfEncrypt::ePdfKeyLength_256 ) );
+#endif // PODOFO_HAVE_CRYPTO_LIBS
+
+    PdfString documentId;
+    documentId.SetHexData( "BF37541A9083A51619AD5924ECF156DF", 32 );
+
+    for( size_t e = 0; e < vecEncrypt.size(); e++ ) 
+    {
+        vecEncrypt[e]->GenerateEncryptionKey( documentId );
+        vecEncrypt[e]->SetCurrentReference( PdfReference( 7, 0 ) );
+
+        for( size_t i = 0; i < sizeof(lLengths) / sizeof(pdf_long); i++ )
+        {
+            for( size_t j = 0; j < sizeof(lChunks) / sizeof(pdf_long); j++ )
+            {
+                // 1 byte writes of large data take too long
+                if( lChunks[j] == 1 && lLengths[i] > 1000 )
+                    continue;
+
+                TestEncryptStreams( vecEncrypt[e], lLengths[i], lChunks[j] );
+            }
+        }
+
+        delete vecEncrypt[e];
+    }
+}
+
+void EncryptTest::testAESFileStream()
+{
+    // More than one block of the input stream and not a multiple of 16
+    const pdf_long lLen = 300 * 1024 + 3;
+    std::vector<char> data( lLen );
+    for( pdf_long i = 0; i < lLen; i++ )
+        data[i] = static_cast<char>((i * 13 + i / 509) & 0xff);
+
+    PdfEncrypt* pEncrypt = PdfEncrypt::CreatePdfEncrypt( "user", "podofo", m_protection, 
+                                                         PdfEncrypt::ePdfEncryptAlgorithm_AESV2, 
+                                                         PdfEncrypt::ePdfKeyLength_128 );
+
+    TVecFilters vecFlate;
+    vecFlate.push_back( ePdfFilter_FlateDecode );
+
+    // The Flate encoded data as written without encryption
+    PdfVecObjects vecObjects;
+    PdfObject*    pEncoded = vecObjects.CreateObject();
+    pEncoded->GetStream()->Set( &data[0], lLen, vecFlate );
+
+    char*    pEncodedBuffer;
+    pdf_long lEncodedLen;
+    pEncoded->GetStream()->GetCopy( &pEncodedBuffer, &lEncodedLen );
+
+    PdfRefCountedBuffer buffer;
+    PdfOutputDevice     device( &buffer );
+    PdfReference        plainRef;
+    PdfReference        flateRef;
+
+    {
+        PdfStreamedDocument writer( &device, ePdfVersion_1_6, pEncrypt );
+        writer.CreatePage( PdfPage::CreateStandardPageSize( ePdfPageSize_A4 ) );
+
+        // Without filters the data is written to the encryption stream directly
+        PdfObject* pPlain = writer.GetObjects()->CreateObject();
+        plainRef = pPlain->Reference();
+        pPlain->GetStream()->BeginAppend( TVecFilters() );
+        pPlain->GetStream()->Append( &data[0], 10 );
+        pPlain->GetStream()->Append( &data[10], lLen - 10 );
+        pPlain->GetStream()->EndAppend();
+
+        // The /Length written by PdfFileStream includes the initial vector and padding
+        const PdfObject* pLength = pPlain->GetIndirectKey( PdfName::KeyLength );
+        CPPUNIT_ASSERT( pLength && pLength->IsNumber() );
+        CPPUNIT_ASSERT_EQUAL( static_cast<pdf_int64>(16 + (lLen / 16 + 1) * 16), pLength->GetNumber() );
+
+        PdfObject* pFlate = writer.GetObjects()->CreateObject();
+        flateRef = pFlate->Reference();
+        pFlate->GetStream()->BeginAppend( vecFlate );
+        pFlate->GetStream()->Append( &data[0], lLen );
+        pFlate->GetStream()->EndAppend();
+
+        // The filter closes the encryption stream, too,
+        // which must not write the padding twice
+        pLength = pFlate->GetIndirectKey( PdfName::KeyLength );
+        CPPUNIT_ASSERT( pLength && pLength->IsNumber() );
+        CPPUNIT_ASSERT_EQUAL( static_cast<pdf_int64>(16 + (lEncodedLen / 16 + 1) * 16), pLength->GetNumber() );
+
+        writer.Close();
+    }
+
+    delete pEncrypt;
+
+    PdfMemDocument reader;
+    try {
+        reader.Load( buffer.GetBuffer(), static_cast<long>(buffer.GetSize()) );
+        CPPUNIT_FAIL("Encrypted file not recognized!");
+    } catch( const PdfError & e ) {
+        CPPUNIT_ASSERT_EQUAL( ePdfError_InvalidPassword, e.GetError() );
+    }
+
+    reader.SetPassword( "user" );
+
+    const PdfReference* pRefs[] = { &plainRef, &flateRef };
+    for( int i = 0; i < 2; i++ ) 
+    {
+        PdfObject* pObject = reader.GetObjects().GetObject( *pRefs[i] );
+        CPPUNIT_ASSERT( pObject && pObject->HasStream() );
+
+        // Decrypting the stream fails if its /Length is wrong
+        char*    pBuffer;
+        pdf_long lBufferLen;
+        if( i == 1 ) 
+        {
+            pObject->GetStream()->GetCopy( &pBuffer, &lBufferLen );
+            CPPUNIT_ASSERT_EQUAL( lEncodedLen, lBufferLen );
+            CPPUNIT_ASSERT( memcmp( pEncodedBuffer, pBuffer, lEncodedLen ) == 0 );
+            podofo_free( pBuffer );
+        }
+
+        pObject->GetStream()->GetFilteredCopy( &pBuffer, &lBufferLen );
+        CPPUNIT_ASSERT_EQUAL( lLen, lBufferLen );
+        CPPUNIT_ASSERT( memcmp( &data[0], pBuffer, lLen ) == 0 );
+        podofo_free( pBuffer );
+    }
+
+    podofo_free( pEncodedBuffer );
+}
+
 void EncryptTest::testLoadEncrypedFilePdfParser()
 {
     std::string sFilename = TestUtils::getTempFilename();
@@ -47,6 +47,8 @@ class EncryptTest : public CppUnit::TestFixture
   CPPUNIT_TEST( testLoadEncrypedFilePdfParser );
   CPPUNIT_TEST( testLoadEncrypedFilePdfMemDocument );
   CPPUNIT_TEST( testEnableAlgorithms );
+  CPPUNIT_TEST( testAESStreams );
+  CPPUNIT_TEST( testAESFileStream );
   CPPUNIT_TEST_SUITE_END();
 
  public:
@@ -69,11 +71,27 @@ class EncryptTest : public CppUnit::TestFixture
   void testLoadEncrypedFilePdfMemDocument();
 
   void testEnableAlgorithms();
+
+  /** Encrypt and decrypt data using CreateEncryptionOutputStream
+   *  and CreateEncryptionInputStream
+   */
+  void testAESStreams();
+
+  /** Write AES encrypted streams using a PdfFileStream 
+   *  and read them back
+   */
+  void testAESFileStream();
     
  private:
   void TestAuthenticate( PoDoFo::PdfEncrypt* pEncrypt, int keyLength, int rValue );
   void TestEncrypt( PoDoFo::PdfEncrypt* pEncrypt );
 
+  /** Round trip lLen bytes through the encryption streams of pEncrypt
+   *
+   *  @param lChunk write the data in chunks of this size
+   */
+  void TestEncryptStreams( PoDoFo::PdfEncrypt* pEncrypt, PoDoFo::pdf_long lLen, PoDoFo::pdf_long lChunk );
+
   /**
    * Create an encrypted PDF.
    *
@@ -44,6 +44,81 @@ const char s_pTestBuffer2[]  = {
 
 const long s_lTestLength2 = 6*13;
 
+// The bitmap of CCITTTestPixel() encoded by libtiff as 
+// Group 4, Group 3 one-dimensional and Group 3 mixed data
+static const unsigned char s_pCCITTGroup4[] = {
+    0x93, 0x58, 0xCE, 0x33, 0x8C, 0xE3, 0x3B, 0x08, 0x20, 0x82, 0x08, 0x20,
+    0x82, 0x0B, 0xFF, 0xC4, 0x20, 0x82, 0x08, 0x20, 0x82, 0x0B, 0xD1, 0x1C,
+    0x52, 0x3F, 0xC2, 0x08, 0x24, 0x82, 0x10, 0x82, 0xFF, 0xC2, 0x08, 0x20,
+    0xA1, 0x18, 0xC2, 0x09, 0x7F, 0xFC, 0x20, 0x82, 0x0A, 0x10, 0x50, 0x82,
+    0x0B, 0xFF, 0xE8, 0x20, 0x82, 0x6C, 0x42, 0x08, 0x20, 0xB1, 0x11, 0x10,
+    0xCC, 0xE3, 0x38, 0xCE, 0x33, 0xBF, 0xF0, 0x01, 0x00, 0x10
+};
+static const unsigned char s_pCCITTGroup3[] = {
+    0x00, 0x10, 0xB0, 0x01, 0x35, 0xA7, 0x4E, 0x9D, 0x38, 0x70, 0x01, 0x35,
+    0x53, 0xA7, 0x4E, 0x9D, 0x00, 0x02, 0x6A, 0xA7, 0x4E, 0x9D, 0x3A, 0x00,
+    0x07, 0xE9, 0xD3, 0xA7, 0x60, 0x00, 0xFD, 0x3C, 0x71, 0x47, 0xE7, 0x60,
+    0x00, 0xE5, 0x38, 0x71, 0xA2, 0xF0, 0x01, 0xCA, 0x70, 0xE3, 0x45, 0xE0,
+    0x03, 0x14, 0xE8, 0x38, 0xFA, 0x9A, 0x00, 0x18, 0xA7, 0x41, 0xC7, 0xD4,
+    0xD0, 0x00, 0x8F, 0x4E, 0xCA, 0x1D, 0xD3, 0x80, 0x04, 0x7A, 0x76, 0x50,
+    0xEE, 0x9C, 0x00, 0x26, 0xBC, 0xE9, 0xD3, 0xA7, 0x38, 0x00, 0x9A, 0x83,
+    0x20, 0x00, 0xCE, 0x9D, 0x3A, 0x75, 0x80, 0x0C, 0xE9, 0xD3, 0xA7, 0x58
+};
+static const unsigned char s_pCCITTGroup3TwoDim[] = {
+    0x00, 0x18, 0x58, 0x00, 0x89, 0xAC, 0x67, 0x19, 0xC6, 0x71, 0x9D, 0x00,
+    0x19, 0xAA, 0x9D, 0x3A, 0x74, 0xE8, 0x00, 0x17, 0xFF, 0x00, 0x1F, 0xD3,
+    0xA7, 0x4E, 0xC0, 0x01, 0x74, 0x47, 0x14, 0x8F, 0xF0, 0x01, 0xE5, 0x38,
+    0x71, 0xA2, 0xF0, 0x01, 0x7F, 0xC0, 0x07, 0x14, 0xE8, 0x38, 0xFA, 0x9A,
+    0x00, 0x17, 0xFF, 0x80, 0x0C, 0x7A, 0x76, 0x50, 0xEE, 0x9C, 0x00, 0x2F,
+    0xFF, 0x00, 0x19, 0xAF, 0x3A, 0x74, 0xE9, 0xCE, 0x00, 0x28, 0x88, 0x88,
+    0x60, 0x03, 0x9D, 0x3A, 0x74, 0xEB, 0x00, 0x17, 0xFC
+};
+
+// The same bitmap as JBIG2 generic region, coded arithmetically
+// using template 0 and TPGDON and coded as MMR using the above Group 4 data.
+// The arithmetic encoder reproduces the test sequence of ITU-T T.88, annex H.2.
+static const unsigned char s_pJBIG2Generic[] = {
+    0x00, 0x00, 0x00, 0x00, 0x30, 0x00, 0x01, 0x00, 0x00, 0x00, 0x13, 0x00,
+    0x00, 0x00, 0x30, 0x00, 0x00, 0x00, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x26, 0x00,
+    0x01, 0x00, 0x00, 0x00, 0x42, 0x00, 0x00, 0x00, 0x30, 0x00, 0x00, 0x00,
+    0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x08, 0x03,
+    0xFF, 0xFD, 0xFF, 0x02, 0xFE, 0xFE, 0xFE, 0xCB, 0x15, 0xA6, 0x98, 0x63,
+    0xE1, 0x65, 0x00, 0x70, 0xC0, 0xCC, 0x39, 0xB9, 0x98, 0x63, 0xFC, 0x07,
+    0x52, 0x1C, 0xDD, 0x6A, 0xAD, 0x82, 0x2C, 0xE3, 0x85, 0xCA, 0x20, 0xA6,
+    0xE9, 0x4F, 0xB5, 0x3E, 0x19, 0x9C, 0x9B, 0x3B, 0xFE, 0xFF, 0xAC, 0x00,
+    0x00, 0x00, 0x02, 0x31, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00
+};
+static const unsigned char s_pJBIG2GenericMMR[] = {
+    0x00, 0x00, 0x00, 0x00, 0x30, 0x00, 0x01, 0x00, 0x00, 0x00, 0x13, 0x00,
+    0x00, 0x00, 0x30, 0x00, 0x00, 0x00, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x26, 0x00,
+    0x01, 0x00, 0x00, 0x00, 0x58, 0x00, 0x00, 0x00, 0x30, 0x00, 0x00, 0x00,
+    0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x93,
+    0x58, 0xCE, 0x33, 0x8C, 0xE3, 0x3B, 0x08, 0x20, 0x82, 0x08, 0x20, 0x82,
+    0x0B, 0xFF, 0xC4, 0x20, 0x82, 0x08, 0x20, 0x82, 0x0B, 0xD1, 0x1C, 0x52,
+    0x3F, 0xC2, 0x08, 0x24, 0x82, 0x10, 0x82, 0xFF, 0xC2, 0x08, 0x20, 0xA1,
+    0x18, 0xC2, 0x09, 0x7F, 0xFC, 0x20, 0x82, 0x0A, 0x10, 0x50, 0x82, 0x0B,
+    0xFF, 0xE8, 0x20, 0x82, 0x6C, 0x42, 0x08, 0x20, 0xB1, 0x11, 0x10, 0xCC,
+    0xE3, 0x38, 0xCE, 0x33, 0xBF, 0xF0, 0x01, 0x00, 0x10, 0x00, 0x00, 0x00,
+    0x02, 0x31, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00
+};
+
+static const int s_nTestBitmapWidth  = 48;
+static const int s_nTestBitmapHeight = 16;
+
+/** \returns true if the pixel of the test bitmap is black
+ */
+static bool CCITTTestPixel( int x, int y )
+{
+    if( y == 0 )
+        return false;
+    else if( y == 13 )
+        return true;
+
+    return ((x + 2 * (y / 2)) % 11 < 3) != (x >= 20 && x < 30 && y >= 5 && y < 12);
+}
+
 void FilterTest::setUp()
 {
 }
@@ -116,6 +191,11 @@ void FilterTest::testFilters()
 {
     for( int i =0; i<=ePdfFilter_Crypt; i++ )
     {
+        // CCITT works on rows of bitmap data and needs /DecodeParms
+        // to decode what it encoded, see testCCITT
+        if( i == ePdfFilter_CCITTFaxDecode )
+            continue;
+
         TestFilter( static_cast<EPdfFilter>(i), s_pTestBuffer1, s_lTestLength1 );
         TestFilter( static_cast<EPdfFilter>(i), s_pTestBuffer2, s_lTestLength2 );
     }
@@ -130,5 +210,187 @@ void FilterTest::testCCITT()
         return;
     }
 
+    // Encoding needs the number of columns, which
+    // a filter created by the factory does not know
+    CPPUNIT_ASSERT( !pFilter->CanEncode() );
+
+    // A 1000 pixel wide bitmap with a few black bars 
+    // and random noise, 0 bits are black
+    const int    nColumns = 1000;
+    const int    nRows    = 64;
+    const long   lRowLen  = nColumns / 8;
+    const long   lLength  = lRowLen * nRows;
+    char*        pBitmap  = static_cast<char*>(malloc( lLength ));
+
+    srand( 1 );
+    for( int y = 0; y < nRows; y++ )
+    {
+        for( long x = 0; x < lRowLen; x++ )
+        {
+            char c = static_cast<char>(0xFF);
+            if( x % 27 < y % 7 )
+                c = 0x00;
+            else if( rand() % 5 == 0 )
+                c = static_cast<char>(rand());
+
+            pBitmap[y * lRowLen + x] = c;
+        }
+    }
+
+    char*      pEncoded;
+    char*      pDecoded;
+    pdf_long   lEncoded;
+    pdf_long   lDecoded;
+
+    try {
+        pFilter->Encode( pBitmap, lLength, &pEncoded, &lEncoded );
+        CPPUNIT_FAIL( "Encoding CCITT data without columns has to fail" );
+    } catch( PdfError & e ) {
+        CPPUNIT_ASSERT_EQUAL( ePdfError_UnsupportedFilter, e.GetError() );
+    }
+
+    PdfMemoryOutputStream stream;
+    PdfOutputStream*      pEncodeStream = PdfFilterFactory::CreateCCITTEncodeStream( &stream, nColumns );
+    pEncodeStream->Write( pBitmap, lLength );
+    pEncodeStream->Close();
+    delete pEncodeStream;
+
+    lEncoded = stream.GetLength();
+    pEncoded = stream.TakeBuffer();
+
+    // The encoder writes Group 4 data
+    PdfDictionary decodeParms;
+    decodeParms.AddKey( PdfName("K"), static_cast<pdf_int64>(-1) );
+    decodeParms.AddKey( PdfName("Columns"), static_cast<pdf_int64>(nColumns) );
+
+    pFilter->Decode( pEncoded, lEncoded, &pDecoded, &lDecoded, &decodeParms );
+
+    printf("\t-> Original Data Length: %li\n", lLength );
+    printf("\t-> Encoded  Data Length: %li\n", lEncoded );
+    printf("\t-> Decoded  Data Length: %li\n", lDecoded );
+
+    CPPUNIT_ASSERT_EQUAL( static_cast<long>(lLength), static_cast<long>(lDecoded) );
+    CPPUNIT_ASSERT_EQUAL( memcmp( pBitmap, pDecoded, lLength ), 0 );
+
+    free( pBitmap );
+    free( pEncoded );
+    free( pDecoded );
+}
+
+void FilterTest::TestDecodeBitmap( EPdfFilter eFilter, const unsigned char* pData, long lLength,
+                                   const PdfDictionary* pDecodeParms, bool bBlackIs1 )
+{
+    std::auto_ptr<PdfFilter> pFilter = PdfFilterFactory::Create( eFilter );
+    char*                    pDecoded;
+    pdf_long                 lDecoded;
+
+    pFilter->Decode( reinterpret_cast<const char*>(pData), lLength, &pDecoded, &lDecoded, pDecodeParms );
+
+    const long lRowLen = s_nTestBitmapWidth / 8;
+    CPPUNIT_ASSERT_EQUAL( lRowLen * s_nTestBitmapHeight, static_cast<long>(lDecoded) );
+
+    for( int y = 0; y < s_nTestBitmapHeight; y++ )
+    {
+        for( int x = 0; x < s_nTestBitmapWidth; x++ )
+        {
+            const bool bBit = (pDecoded[y * lRowLen + x / 8] & (0x80 >> (x % 8))) != 0;
+            CPPUNIT_ASSERT_EQUAL( CCITTTestPixel( x, y ), bBit == bBlackIs1 );
+        }
+    }
+
+    free( pDecoded );
+}
+
+void FilterTest::testCCITTDecode()
+{
+    PdfDictionary decodeParms;
+    decodeParms.AddKey( PdfName("Columns"), static_cast<pdf_int64>(s_nTestBitmapWidth) );
+    decodeParms.AddKey( PdfName("Rows"), static_cast<pdf_int64>(s_nTestBitmapHeight) );
+
+    // Group 4
+    decodeParms.AddKey( PdfName("K"), static_cast<pdf_int64>(-1) );
+    TestDecodeBitmap( ePdfFilter_CCITTFaxDecode, s_pCCITTGroup4, sizeof(s_pCCITTGroup4), &decodeParms, false );
+
+    decodeParms.AddKey( PdfName("BlackIs1"), PdfVariant( true ) );
+    TestDecodeBitmap( ePdfFilter_CCITTFaxDecode, s_pCCITTGroup4, sizeof(s_pCCITTGroup4), &decodeParms, true );
+
+    // Group 3 one-dimensional, each row starts with EOL
+    decodeParms.AddKey( PdfName("K"), PdfVariant( static_cast<pdf_int64>(0) ) );
+    TestDecodeBitmap( ePdfFilter_CCITTFaxDecode, s_pCCITTGroup3, sizeof(s_pCCITTGroup3), &decodeParms, true );
+
+    decodeParms.AddKey( PdfName("EndOfLine"), PdfVariant( true ) );
+    TestDecodeBitmap( ePdfFilter_CCITTFaxDecode, s_pCCITTGroup3, sizeof(s_pCCITTGroup3), &decodeParms, true );
+
+    // Group 3 mixed one- and two-dimensional
+    decodeParms.AddKey( PdfName("K"), static_cast<pdf_int64>(2) );
+    TestDecodeBitmap( ePdfFilter_CCITTFaxDecode, s_pCCITTGroup3TwoDim, sizeof(s_pCCITTGroup3TwoDim), &decodeParms, true );
+}
+
+void FilterTest::testJBIG2Decode()
+{
+    // JBIG2 uses 1 for black, PDF expects 0
+    TestDecodeBitmap( ePdfFilter_JBIG2Decode, s_pJBIG2Generic, sizeof(s_pJBIG2Generic), NULL, false );
+    TestDecodeBitmap( ePdfFilter_JBIG2Decode, s_pJBIG2GenericMMR, sizeof(s_pJBIG2GenericMMR), NULL, false );
+}
+
+void FilterTest::testStreamAppend()
+{
+    // Many small appends and a few large ones, so that
+    // several blocks are used and the batches are flushed
+    std::string sExpected;
+    for( int i = 0; i < 3000; i++ ) 
+    {
+        if( i % 500 == 0 )
+            sExpected += std::string( 10000, static_cast<char>('a' + i % 26) );
+        else
+            sExpected.append( s_pTestBuffer1, i % s_lTestLength1 );
+    }
+
+    PdfChunkedOutputStream chunks;
+    chunks.Write( sExpected.c_str(), sExpected.length() );
+    CPPUNIT_ASSERT( chunks.GetChunkCount() > 1 );
+    CPPUNIT_ASSERT_EQUAL( static_cast<pdf_long>(sExpected.length()), chunks.GetLength() );
+
+    char* pTaken = chunks.TakeBuffer();
+    CPPUNIT_ASSERT( sExpected == std::string( pTaken, sExpected.length() ) );
+    podofo_free( pTaken );
+
+    PdfMemDocument doc;
+    TVecFilters    vecNoFilters;
+    PdfObject*     pRaw     = doc.GetObjects().CreateObject();
+    PdfObject*     pFlate   = doc.GetObjects().CreateObject();
+    size_t         lPos     = 0;
+
+    pRaw->GetStream()->BeginAppend( vecNoFilters );
+    pFlate->GetStream()->BeginAppend();
+    while( lPos < sExpected.length() ) 
+    {
+        size_t lLen = PDF_MIN( sExpected.length() - lPos, static_cast<size_t>(lPos % 97 ? lPos % 97 : 5000) );
+        pRaw->GetStream()->Append( sExpected.c_str() + lPos, lLen );
+        pFlate->GetStream()->Append( sExpected.c_str() + lPos, lLen );
+        lPos += lLen;
+    }
+    pRaw->GetStream()->EndAppend();
+    pFlate->GetStream()->EndAppend();
+
+    // Blocks are written without being merged first
+    PdfRefCountedBuffer buffer;
+    PdfOutputDevice     device( &buffer );
+    pRaw->GetStream()->Write( &device );
+    CPPUNIT_ASSERT_EQUAL( static_cast<size_t>(7 + sExpected.length() + 11), device.GetLength() );
+    CPPUNIT_ASSERT( std::string( buffer.GetBuffer() + 7, sExpected.length() ) == sExpected );
+
+    char*    pBuffer;
+    pdf_long lLen;
+    pRaw->GetStream()->GetCopy( &pBuffer, &lLen );
+    CPPUNIT_ASSERT( sExpected == std::string( pBuffer, lLen ) );
+    free( pBuffer );
+
+    CPPUNIT_ASSERT_EQUAL( static_cast<pdf_long>(sExpected.length()), pRaw->GetStream()->GetLength() );
+    CPPUNIT_ASSERT( sExpected == std::string( dynamic_cast<PdfMemStream*>(pRaw->GetStream())->Get(), 
+                                              sExpected.length() ) );
 
+    pFlate->GetStream()->GetFilteredCopy( &pBuffer, &lLen );
+    CPPUNIT_ASSERT( sExpected == std::string( pBuffer, lLen ) );
+    podofo_free( pBuffer );
 }
@@ -32,6 +32,9 @@ class FilterTest : public CppUnit::TestFixture
   CPPUNIT_TEST_SUITE( FilterTest );
   CPPUNIT_TEST( testFilters );
   CPPUNIT_TEST( testCCITT );
+  CPPUNIT_TEST( testCCITTDecode );
+  CPPUNIT_TEST( testJBIG2Decode );
+  CPPUNIT_TEST( testStreamAppend );
   CPPUNIT_TEST_SUITE_END();
 
  public:
@@ -41,9 +44,16 @@ class FilterTest : public CppUnit::TestFixture
   void testFilters();
 
   void testCCITT();
+  void testCCITTDecode();
+  void testJBIG2Decode();
+
+  void testStreamAppend();
 
  private:
   void TestFilter( PoDoFo::EPdfFilter eFilter, const char * pTestBuffer, const long lTestLength );
+
+  void TestDecodeBitmap( PoDoFo::EPdfFilter eFilter, const unsigned char* pData, long lLength,
+                         const PoDoFo::PdfDictionary* pDecodeParms, bool bBlackIs1 );
 };
 
 #endif // _FILTER_TEST_H_
@@ -25,6 +25,8 @@
 #include <ft2build.h>
 #include FT_FREETYPE_H
 
+#include <set>
+
 using namespace PoDoFo;
 
 CPPUNIT_TEST_SUITE_REGISTRATION( FontTest );
@@ -130,6 +132,349 @@ void FontTest::testCreateFontFtFace()
     }
 }
 
+std::string FontTest::BuildSubset( PdfFontTTFSubset & rSubset, const char* pszText )
+{
+    PdfRefCountedBuffer buffer;
+    PdfOutputDevice     device( &buffer );
+
+    while( *pszText )
+    {
+        // AddCharacter expects big endian UTF-16
+        PdfString sChar( std::string( pszText, 1 ).c_str() );
+        rSubset.AddCharacter( sChar.ToUnicode().GetUnicode()[0] );
+        ++pszText;
+    }
+
+    rSubset.BuildFont( &device );
+    return std::string( buffer.GetBuffer(), device.GetLength() );
+}
+
+std::string FontTest::FindTrueTypeFont()
+{
+    FcObjectSet* objectSet = NULL;
+    FcFontSet*   fontSet   = NULL;
+    FcPattern*   pattern   = NULL;
+    std::string  sPath;
+
+    CPPUNIT_ASSERT_EQUAL( !FcInit(), false );
+
+    pattern   = FcPatternCreate();
+    objectSet = FcObjectSetBuild( FC_FILE, NULL );
+    fontSet   = FcFontList( NULL, pattern, objectSet );
+
+    FcObjectSetDestroy( objectSet );
+    FcPatternDestroy( pattern );
+
+    for( int i = 0; fontSet && i < fontSet->nfont && sPath.empty(); i++ )
+    {
+        FcChar8* file = NULL;
+        if( FcPatternGetString( fontSet->fonts[i], FC_FILE, 0, &file ) == FcResultMatch 
+            && PdfFontFactory::GetFontType( reinterpret_cast<char*>(file) ) == ePdfFontType_TrueType )
+            sPath = reinterpret_cast<char*>(file);
+    }
+
+    if( fontSet )
+        FcFontSetDestroy( fontSet );
+
+    return sPath;
+}
+
+void FontTest::testSubsetCache()
+{
+    std::string sPath = FindTrueTypeFont();
+    if( sPath.empty() )
+    {
+        printf("No TrueType font found, skipping subset cache test.\n");
+        return;
+    }
+
+    const char*            pszText = "Hello World";
+    FT_Library             library = m_pDoc->GetFontLibrary();
+    PdfFontMetricsFreetype metrics( &library, sPath.c_str() );
+
+    PdfFontTTFSubset::ClearCache();
+
+    // Without a key the cache is not used
+    PdfInputDevice   input( sPath.c_str() );
+    PdfFontTTFSubset subset( &input, &metrics, PdfFontTTFSubset::eFontFileType_TTF );
+    std::string      sSubset = BuildSubset( subset, pszText );
+    CPPUNIT_ASSERT( !sSubset.empty() );
+
+    PdfInputDevice   inputCached( sPath.c_str() );
+    PdfFontTTFSubset subsetCached( &inputCached, &metrics, PdfFontTTFSubset::eFontFileType_TTF );
+    subsetCached.SetCacheKey( sPath );
+    CPPUNIT_ASSERT( sSubset == BuildSubset( subsetCached, pszText ) );
+
+    // The same glyphs are taken from the cache without reading the font
+    PdfFontTTFSubset subsetEmpty( "", 0, &metrics, PdfFontTTFSubset::eFontFileType_TTF );
+    subsetEmpty.SetCacheKey( sPath );
+    CPPUNIT_ASSERT( sSubset == BuildSubset( subsetEmpty, pszText ) );
+
+    // Other glyphs are not in the cache
+    PdfFontTTFSubset subsetOther( "", 0, &metrics, PdfFontTTFSubset::eFontFileType_TTF );
+    subsetOther.SetCacheKey( sPath );
+    CPPUNIT_ASSERT_THROW( BuildSubset( subsetOther, "Other" ), PdfError );
+
+    PdfFontTTFSubset::ClearCache();
+    PdfFontTTFSubset subsetCleared( "", 0, &metrics, PdfFontTTFSubset::eFontFileType_TTF );
+    subsetCleared.SetCacheKey( sPath );
+    CPPUNIT_ASSERT_THROW( BuildSubset( subsetCleared, pszText ), PdfError );
+}
+
+/** \returns the glyphs listed in the /W array of a CID font
+ */
+static std::set<pdf_int64> GetWidthGlyphs( const PdfObject* pDescendant )
+{
+    std::set<pdf_int64> setWidths;
+    const PdfArray & widths = pDescendant->GetDictionary().GetKey( "W" )->GetArray();
+    for( size_t i = 0; i < widths.size(); )
+    {
+        pdf_int64 lFirst = widths[i].GetNumber();
+        if( widths[i+1].IsArray() ) 
+        {
+            for( size_t j = 0; j < widths[i+1].GetArray().size(); j++ )
+                setWidths.insert( lFirst + j );
+
+            i += 2;
+        }
+        else
+        {
+            for( pdf_int64 l = lFirst; l <= widths[i+1].GetNumber(); l++ )
+                setWidths.insert( l );
+
+            i += 3;
+        }
+    }
+
+    return setWidths;
+}
+
+void FontTest::testCIDSubsetting()
+{
+    std::string sPath = FindTrueTypeFont();
+    if( sPath.empty() )
+    {
+        printf("No TrueType font found, skipping CID subsetting test.\n");
+        return;
+    }
+
+    // Type1 subsetting does not change CID fonts
+    PdfFont* pType1Flag = m_pDoc->CreateFont( "CIDType1Subsetting", false, false, new PdfIdentityEncoding(),
+                                              PdfFontCache::eFontCreationFlags_Type1Subsetting, 
+                                              true, sPath.c_str() );
+    CPPUNIT_ASSERT( pType1Flag != NULL );
+    CPPUNIT_ASSERT( !pType1Flag->IsSubsetting() );
+
+    const char* pszText = "Hello World";
+    PdfFont*    pFont   = m_pDoc->CreateFont( "CIDSubsetting", false, false, new PdfIdentityEncoding(),
+                                              PdfFontCache::eFontCreationFlags_CIDSubsetting, 
+                                              true, sPath.c_str() );
+    CPPUNIT_ASSERT( pFont != NULL );
+    CPPUNIT_ASSERT( pFont->IsSubsetting() );
+
+    PdfPage*   pPage = m_pDoc->CreatePage( PdfPage::CreateStandardPageSize( ePdfPageSize_A4 ) );
+    PdfPainter painter;
+    painter.SetPage( pPage );
+    painter.SetFont( pFont );
+    painter.DrawText( 100.0, 100.0, pszText );
+    painter.FinishPage();
+
+    std::set<pdf_int64> setExpected;
+    for( const char* pszChar = pszText; *pszChar; ++pszChar )
+        setExpected.insert( pFont->GetFontMetrics()->GetGlyphId( *pszChar ) );
+
+    PdfObject* pDescendant = m_pDoc->GetObjects().GetObject( 
+        pFont->GetObject()->GetIndirectKey( "DescendantFonts" )->GetArray()[0].GetReference() );
+    PdfObject* pUnicode    = pFont->GetObject()->GetIndirectKey( "ToUnicode" );
+    CPPUNIT_ASSERT( pDescendant != NULL );
+    CPPUNIT_ASSERT( pUnicode != NULL );
+
+    // Nothing is written before the subset fonts are embedded
+    CPPUNIT_ASSERT( !pDescendant->GetDictionary().HasKey( "W" ) );
+    CPPUNIT_ASSERT( !pUnicode->HasStream() );
+
+    m_pDoc->EmbedSubsetFonts();
+
+    // /W contains exactly the used glyphs
+    CPPUNIT_ASSERT( setExpected == GetWidthGlyphs( pDescendant ) );
+
+    // ToUnicode maps all used glyphs and only those
+    char*    pBuffer = NULL;
+    pdf_long lLen    = 0;
+    pUnicode->GetStream()->GetFilteredCopy( &pBuffer, &lLen );
+    std::string sCMap( pBuffer, lLen );
+    free( pBuffer );
+
+    size_t nRanges = 0;
+    size_t nPos    = 0;
+    while( (nPos = sCMap.find( "beginbfrange", nPos )) != std::string::npos )
+    {
+        nRanges += atoi( sCMap.c_str() + sCMap.rfind( '\n', nPos ) + 1 );
+        ++nPos;
+    }
+    CPPUNIT_ASSERT( nRanges > 0 );
+    CPPUNIT_ASSERT( nRanges <= setExpected.size() );
+
+    std::set<pdf_int64>::const_iterator it = setExpected.begin();
+    while( it != setExpected.end() )
+    {
+        char szGlyph[7];
+        snprintf( szGlyph, 7, "<%04X>", static_cast<unsigned int>(*it) );
+        CPPUNIT_ASSERT( sCMap.find( szGlyph ) != std::string::npos );
+        ++it;
+    }
+
+    // Glyphs added later, also without PdfPainter, 
+    // are written when the subset fonts are embedded again
+    const char* pszMore = "Quiz";
+    PdfObject*  pXObject = m_pDoc->GetObjects().CreateObject();
+    pXObject->GetStream()->BeginAppend();
+    pFont->WriteStringToStream( PdfString( pszMore ), pXObject->GetStream() );
+    pXObject->GetStream()->EndAppend();
+
+    for( const char* pszChar = pszMore; *pszChar; ++pszChar )
+        setExpected.insert( pFont->GetFontMetrics()->GetGlyphId( *pszChar ) );
+
+    m_pDoc->EmbedSubsetFonts();
+    CPPUNIT_ASSERT( setExpected == GetWidthGlyphs( pDescendant ) );
+
+    pUnicode->GetStream()->GetFilteredCopy( &pBuffer, &lLen );
+    sCMap = std::string( pBuffer, lLen );
+    free( pBuffer );
+
+    for( it = setExpected.begin(); it != setExpected.end(); ++it )
+    {
+        char szGlyph[7];
+        snprintf( szGlyph, 7, "<%04X>", static_cast<unsigned int>(*it) );
+        CPPUNIT_ASSERT( sCMap.find( szGlyph ) != std::string::npos );
+    }
+}
+
+void FontTest::testSharedFontCache()
+{
+    std::string sPath = FindTrueTypeFont();
+    if( sPath.empty() )
+    {
+        printf("No TrueType font found, skipping shared font cache test.\n");
+        return;
+    }
+
+    PdfSharedFontCache::ClearCache();
+    CPPUNIT_ASSERT( PdfSharedFontCache::Acquire( sPath.c_str() ) == NULL );
+
+    PdfSharedFontCache::SetEnabled( true );
+    {
+        PdfMemDocument doc1;
+        PdfMemDocument doc2;
+        PdfFont* pFont1 = doc1.CreateFont( "Shared", false, false, PdfEncodingFactory::GlobalWinAnsiEncodingInstance(),
+                                           PdfFontCache::eFontCreationFlags_None, true, sPath.c_str() );
+        PdfFont* pFont2 = doc2.CreateFont( "Shared", false, false, PdfEncodingFactory::GlobalWinAnsiEncodingInstance(),
+                                           PdfFontCache::eFontCreationFlags_None, true, sPath.c_str() );
+        CPPUNIT_ASSERT( pFont1 != NULL );
+        CPPUNIT_ASSERT( pFont2 != NULL );
+
+        // Both documents use the same font data
+        CPPUNIT_ASSERT( pFont1->GetFontMetrics()->GetFontData() != NULL );
+        CPPUNIT_ASSERT( pFont1->GetFontMetrics()->GetFontData() == pFont2->GetFontMetrics()->GetFontData() );
+
+        // and the same metrics as without the cache
+        FT_Library             library = doc1.GetFontLibrary();
+        PdfFontMetricsFreetype metrics( &library, sPath.c_str() );
+        metrics.SetFontSize( pFont1->GetFontMetrics()->GetFontSize() );
+        metrics.SetFontScale( pFont1->GetFontMetrics()->GetFontScale() );
+        metrics.SetFontCharSpace( pFont1->GetFontMetrics()->GetFontCharSpace() );
+        for( char c = 'A'; c <= 'Z'; c++ )
+        {
+            CPPUNIT_ASSERT_EQUAL( metrics.CharWidth( c ), pFont1->GetFontMetrics()->CharWidth( c ) );
+            CPPUNIT_ASSERT_EQUAL( metrics.CharWidth( c ), pFont2->GetFontMetrics()->CharWidth( c ) );
+        }
+
+        // Fonts in use are not freed
+        PdfSharedFont* pShared = PdfSharedFontCache::Acquire( sPath.c_str() );
+        CPPUNIT_ASSERT( pShared->GetData() == pFont1->GetFontMetrics()->GetFontData() );
+        PdfSharedFontCache::SetCacheLimit( 0 );
+        PdfSharedFontCache::ClearCache();
+
+        PdfSharedFont* pSharedAgain = PdfSharedFontCache::Acquire( sPath.c_str() );
+        CPPUNIT_ASSERT( pShared == pSharedAgain );
+        PdfSharedFontCache::Release( pSharedAgain );
+        PdfSharedFontCache::Release( pShared );
+    }
+
+    // Paths are resolved once for all documents
+    PdfSharedFontCache::AddFontPath( "PoDoFo Unknown Family", true, false, sPath );
+
+    std::string sFound;
+    CPPUNIT_ASSERT( PdfSharedFontCache::GetFontPath( "PoDoFo Unknown Family", true, false, sFound ) );
+    CPPUNIT_ASSERT( sFound == sPath );
+    CPPUNIT_ASSERT( !PdfSharedFontCache::GetFontPath( "PoDoFo Unknown Family", false, false, sFound ) );
+
+    {
+        PdfMemDocument doc;
+        PdfFont*       pFont = doc.CreateFont( "PoDoFo Unknown Family", true, false );
+        CPPUNIT_ASSERT( pFont != NULL );
+        CPPUNIT_ASSERT( sPath == pFont->GetFontMetrics()->GetFilename() );
+    }
+
+    PdfSharedFontCache::SetCacheLimit( 32 * 1024 * 1024 );
+    PdfSharedFontCache::SetEnabled( false );
+    PdfSharedFontCache::ClearCache();
+    CPPUNIT_ASSERT( !PdfSharedFontCache::GetFontPath( "PoDoFo Unknown Family", true, false, sFound ) );
+}
+
+static std::string WriteString( PdfMemDocument* pDoc, PdfFont* pFont, const PdfString & rsString )
+{
+    PdfObject* pObject = pDoc->GetObjects().CreateObject();
+    char*      pBuffer;
+    pdf_long   lLen;
+
+    pObject->GetStream()->BeginAppend();
+    pFont->WriteStringToStream( rsString, pObject->GetStream() );
+    pObject->GetStream()->EndAppend();
+
+    pObject->GetStream()->GetFilteredCopy( &pBuffer, &lLen );
+    std::string sResult( pBuffer, lLen );
+    podofo_free( pBuffer );
+
+    return sResult;
+}
+
+void FontTest::testWriteStringToStream()
+{
+    std::string sPath = FindTrueTypeFont();
+    if( sPath.empty() )
+    {
+        printf("No TrueType font found, skipping WriteStringToStream test.\n");
+        return;
+    }
+
+    PdfFont* pFont = m_pDoc->CreateFont( "WriteString", false, false, PdfEncodingFactory::GlobalWinAnsiEncodingInstance(),
+                                         PdfFontCache::eFontCreationFlags_None, false, sPath.c_str() );
+    CPPUNIT_ASSERT( pFont != NULL );
+
+    // Single byte encodings are written as literal strings with escapes
+    CPPUNIT_ASSERT_EQUAL( std::string( "(Hello \\(World\\)\\\\)" ), 
+                          WriteString( m_pDoc, pFont, PdfString( "Hello (World)\\" ) ) );
+    CPPUNIT_ASSERT_EQUAL( std::string( "()" ), WriteString( m_pDoc, pFont, PdfString( "" ) ) );
+
+    // Strings longer than the internal buffers
+    std::string sLong( 1000, 'a' );
+    sLong += "\n";
+    CPPUNIT_ASSERT_EQUAL( "(" + std::string( 1000, 'a' ) + "\\n)", 
+                          WriteString( m_pDoc, pFont, PdfString( sLong ) ) );
+
+    // Two byte glyph ids are written as hex strings, as most bytes would need an escape
+    PdfFont* pCIDFont = m_pDoc->CreateFont( "WriteStringCID", false, false, new PdfIdentityEncoding(),
+                                            PdfFontCache::eFontCreationFlags_None, false, sPath.c_str() );
+    CPPUNIT_ASSERT( pCIDFont != NULL );
+
+    char szExpected[16];
+    snprintf( szExpected, sizeof(szExpected), "<%04X%04X>", 
+              static_cast<unsigned int>(pCIDFont->GetFontMetrics()->GetGlyphId( 'A' )),
+              static_cast<unsigned int>(pCIDFont->GetFontMetrics()->GetGlyphId( 'B' )) );
+    CPPUNIT_ASSERT_EQUAL( std::string( szExpected ), WriteString( m_pDoc, pCIDFont, PdfString( "AB" ) ) );
+}
+
 bool FontTest::GetFontInfo( FcPattern* pFont, std::string & rsFamily, std::string & rsPath, 
                             bool & rbBold, bool & rbItalic )
 {
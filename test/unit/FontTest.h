@@ -37,6 +37,10 @@ class FontTest : public CppUnit::TestFixture
 #if defined(PODOFO_HAVE_FONTCONFIG)
   CPPUNIT_TEST( testFonts );
   CPPUNIT_TEST( testCreateFontFtFace );
+  CPPUNIT_TEST( testSubsetCache );
+  CPPUNIT_TEST( testCIDSubsetting );
+  CPPUNIT_TEST( testSharedFontCache );
+  CPPUNIT_TEST( testWriteStringToStream );
 #endif
   CPPUNIT_TEST_SUITE_END();
 
@@ -47,6 +51,10 @@ class FontTest : public CppUnit::TestFixture
 #if defined(PODOFO_HAVE_FONTCONFIG)
   void testFonts();
   void testCreateFontFtFace();
+  void testSubsetCache();
+  void testCIDSubsetting();
+  void testSharedFontCache();
+  void testWriteStringToStream();
 #endif
 
 private:
@@ -55,6 +63,14 @@ private:
 
     bool GetFontInfo( FcPattern* pFont, std::string & rsFamily, std::string & rsPath, 
                       bool & rbBold, bool & rbItalic );
+
+    /** \returns the path of any TrueType font known to fontconfig or an empty string
+     */
+    std::string FindTrueTypeFont();
+
+    /** Subset the characters of pszText from a TrueType font.
+     */
+    std::string BuildSubset( PoDoFo::PdfFontTTFSubset & rSubset, const char* pszText );
 #endif
 
 private:
@@ -0,0 +1,249 @@
+/***************************************************************************
+ *   Copyright (C) 2013 by Dominik Seichter                                *
+ *   domseichter@web.de                                                    *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Library General Public License as       *
+ *   published by the Free Software Foundation; either version 2 of the    *
+ *   License, or (at your option) any later version.                       *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this program; if not, write to the                 *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#include "FunctionTest.h"
+
+#include <string.h>
+
+using namespace PoDoFo;
+
+// Registers the fixture into the 'registry'
+CPPUNIT_TEST_SUITE_REGISTRATION( FunctionTest );
+
+static PdfArray CreateArray( double d1, double d2 )
+{
+    PdfArray array;
+    array.push_back( d1 );
+    array.push_back( d2 );
+    return array;
+}
+
+void FunctionTest::setUp()
+{
+    m_pVecObjects = new PdfVecObjects();
+}
+
+void FunctionTest::tearDown()
+{
+    delete m_pVecObjects;
+}
+
+PdfObject* FunctionTest::CreatePostScriptFunction( const char* pszProgram, int nOutputs )
+{
+    PdfArray range;
+    for( int i = 0; i < nOutputs; i++ ) 
+    {
+        range.push_back( -1000.0 );
+        range.push_back( 1000.0 );
+    }
+
+    PdfObject* pFunction = m_pVecObjects->CreateObject();
+    pFunction->GetDictionary().AddKey( PdfName("FunctionType"), static_cast<pdf_int64>(ePdfFunctionType_PostScript) );
+    pFunction->GetDictionary().AddKey( PdfName("Domain"), CreateArray( -1000.0, 1000.0 ) );
+    pFunction->GetDictionary().AddKey( PdfName("Range"), range );
+    pFunction->GetStream()->Set( pszProgram, strlen( pszProgram ) );
+    return pFunction;
+}
+
+double FunctionTest::EvaluatePostScript( const char* pszProgram, double dInput )
+{
+    PdfFunctionEvaluator evaluator( CreatePostScriptFunction( pszProgram ) );
+    double dOutput;
+    evaluator.Evaluate( &dInput, &dOutput );
+    return dOutput;
+}
+
+void FunctionTest::testSampledFunction()
+{
+    // Two inputs with 3 x 2 samples of 8 bits and two outputs each
+    const unsigned char samples[] = { 0, 255,   51, 204,   102, 153,
+                                      255, 0,   204, 51,   153, 102 };
+
+    PdfArray domain = CreateArray( 0.0, 1.0 );
+    domain.push_back( 0.0 );
+    domain.push_back( 1.0 );
+    PdfArray size;
+    size.push_back( static_cast<pdf_int64>(3) );
+    size.push_back( static_cast<pdf_int64>(2) );
+
+    PdfObject* pFunction = m_pVecObjects->CreateObject();
+    pFunction->GetDictionary().AddKey( PdfName("FunctionType"), static_cast<pdf_int64>(ePdfFunctionType_Sampled) );
+    pFunction->GetDictionary().AddKey( PdfName("Domain"), domain );
+    pFunction->GetDictionary().AddKey( PdfName("Range"), domain );
+    pFunction->GetDictionary().AddKey( PdfName("Size"), size );
+    pFunction->GetDictionary().AddKey( PdfName("BitsPerSample"), static_cast<pdf_int64>(8) );
+    pFunction->GetStream()->Set( reinterpret_cast<const char*>(samples), sizeof(samples) );
+
+    PdfFunctionEvaluator evaluator( pFunction );
+    CPPUNIT_ASSERT_EQUAL( 2U, evaluator.GetInputCount() );
+    CPPUNIT_ASSERT_EQUAL( 2U, evaluator.GetOutputCount() );
+
+    double adOutput[2];
+    const double adCorner[] = { 0.0, 1.0 };
+    evaluator.Evaluate( adCorner, adOutput );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 1.0, adOutput[0], 1e-9 );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 0.0, adOutput[1], 1e-9 );
+
+    // Linear along the first input
+    const double adFirst[] = { 0.25, 0.0 };
+    evaluator.Evaluate( adFirst, adOutput );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 0.1, adOutput[0], 1e-9 );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 0.9, adOutput[1], 1e-9 );
+
+    // Bilinear between 4 samples; inputs outside of the domain are clipped
+    const double adBoth[] = { 0.75, 0.5 };
+    evaluator.Evaluate( adBoth, adOutput );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 0.5, adOutput[0], 1e-9 );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 0.5, adOutput[1], 1e-9 );
+
+    const double adClipped[] = { 7.0, -3.0 };
+    evaluator.Evaluate( adClipped, adOutput );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 0.4, adOutput[0], 1e-9 );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 0.6, adOutput[1], 1e-9 );
+}
+
+void FunctionTest::testExponentialFunction()
+{
+    PdfArray c0;
+    c0.push_back( 0.0 );
+    c0.push_back( 1.0 );
+    PdfArray c1;
+    c1.push_back( 1.0 );
+    c1.push_back( 0.5 );
+
+    PdfExponentialFunction function( CreateArray( 0.0, 1.0 ), c0, c1, 2.0, m_pVecObjects );
+    PdfFunctionEvaluator   evaluator( function );
+    CPPUNIT_ASSERT_EQUAL( 1U, evaluator.GetInputCount() );
+    CPPUNIT_ASSERT_EQUAL( 2U, evaluator.GetOutputCount() );
+
+    double dInput = 0.5;
+    double adOutput[2];
+    evaluator.Evaluate( &dInput, adOutput );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 0.25, adOutput[0], 1e-9 );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 0.875, adOutput[1], 1e-9 );
+}
+
+void FunctionTest::testStitchingFunction()
+{
+    PdfArray c0;
+    c0.push_back( 0.0 );
+    PdfArray c1;
+    c1.push_back( 1.0 );
+
+    PdfFunction::List functions;
+    functions.push_back( PdfExponentialFunction( CreateArray( 0.0, 1.0 ), c0, c1, 1.0, m_pVecObjects ) );
+    functions.push_back( PdfExponentialFunction( CreateArray( 0.0, 1.0 ), c1, c0, 1.0, m_pVecObjects ) );
+
+    PdfArray bounds;
+    bounds.push_back( 0.5 );
+    PdfArray encode = CreateArray( 0.0, 1.0 );
+    encode.push_back( 0.0 );
+    encode.push_back( 1.0 );
+
+    PdfStitchingFunction function( functions, CreateArray( 0.0, 1.0 ), bounds, encode, m_pVecObjects );
+    PdfFunctionEvaluator evaluator( function );
+
+    // A triangle rising from 0 to 1 and falling to 0 again
+    double adInput[] = { 0.0, 0.25, 0.5, 0.75, 1.0 };
+    double adExpected[] = { 0.0, 0.5, 1.0, 0.5, 0.0 };
+    for( int i = 0; i < 5; i++ ) 
+    {
+        double dOutput;
+        evaluator.Evaluate( &adInput[i], &dOutput );
+        CPPUNIT_ASSERT_DOUBLES_EQUAL( adExpected[i], dOutput, 1e-9 );
+    }
+}
+
+void FunctionTest::testPostScriptFunction()
+{
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 7.0,   EvaluatePostScript( "{ 2 mul 1 add }", 3.0 ), 1e-9 );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 1.5,   EvaluatePostScript( "{2 div}", 3.0 ), 1e-9 );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( -3.0,  EvaluatePostScript( "{ neg }", 3.0 ), 1e-9 );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 9.0,   EvaluatePostScript( "{ dup mul } % comment", 3.0 ), 1e-9 );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 1.0,   EvaluatePostScript( "{ 3 sub 0 exch sub }", 2.0 ), 1e-9 );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 3.0,   EvaluatePostScript( "{ sqrt }", 9.0 ), 1e-9 );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 1.0,   EvaluatePostScript( "{ 90 add sin }", 0.0 ), 1e-9 );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 135.0, EvaluatePostScript( "{ -1 atan }", 1.0 ), 1e-9 );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 8.0,   EvaluatePostScript( "{ 3 exp }", 2.0 ), 1e-9 );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 2.0,   EvaluatePostScript( "{ log }", 100.0 ), 1e-9 );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( -3.0,  EvaluatePostScript( "{ round }", -3.5 ), 1e-9 );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( -3.0,  EvaluatePostScript( "{ truncate }", -3.7 ), 1e-9 );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 3.0,   EvaluatePostScript( "{ cvi 4 idiv }", 14.9 ), 1e-9 );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 2.0,   EvaluatePostScript( "{ cvi 4 mod }", 14.9 ), 1e-9 );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 12.0,  EvaluatePostScript( "{ cvi 2 bitshift }", 3.0 ), 1e-9 );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( -4.0,  EvaluatePostScript( "{ cvi not }", 3.0 ), 1e-9 );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 6.0,   EvaluatePostScript( "{ cvi 5 xor }", 3.0 ), 1e-9 );
+
+    // Conditionals
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 1.0,   EvaluatePostScript( "{ 0.5 gt { 1 } { 0 } ifelse }", 0.7 ), 1e-9 );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 0.0,   EvaluatePostScript( "{ 0.5 gt { 1 } { 0 } ifelse }", 0.3 ), 1e-9 );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 5.0,   EvaluatePostScript( "{ dup 0 lt { neg } if }", -5.0 ), 1e-9 );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 5.0,   EvaluatePostScript( "{ dup 0 lt { neg } if }", 5.0 ), 1e-9 );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 2.0,   EvaluatePostScript( "{ dup 1 eq exch 2 eq or { 2 } { 3 } ifelse }", 1.0 ), 1e-9 );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 4.0,   EvaluatePostScript( "{ 1 ge { true { 4 } { 5 } ifelse } { 6 } ifelse }", 1.0 ), 1e-9 );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 12.0,  EvaluatePostScript( "{ 2 exch 0 gt { 3 mul } if 2 mul }", 1.0 ), 1e-9 );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 4.0,   EvaluatePostScript( "{ 2 exch 0 gt { 3 mul } if 2 mul }", -1.0 ), 1e-9 );
+    // A constant at the end of a procedure must not be combined with the operator after the conditional
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 6.0,   EvaluatePostScript( "{ 2 exch 0 gt { 3 } { 5 } ifelse mul }", 1.0 ), 1e-9 );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 10.0,  EvaluatePostScript( "{ 2 exch 0 gt { 3 } { 5 } ifelse mul }", -1.0 ), 1e-9 );
+
+    // Stack operators with several outputs
+    PdfFunctionEvaluator evaluator( CreatePostScriptFunction( "{ 1 2 3 3 1 roll 2 copy pop 3 index }", 5 ) );
+    double dInput = 7.0;
+    double adOutput[5];
+    evaluator.Evaluate( &dInput, adOutput );
+    const double adExpected[] = { 3.0, 1.0, 2.0, 1.0, 3.0 };
+    for( int i = 0; i < 5; i++ ) 
+        CPPUNIT_ASSERT_DOUBLES_EQUAL( adExpected[i], adOutput[i], 1e-9 );
+}
+
+void FunctionTest::testPostScriptErrors()
+{
+    CPPUNIT_ASSERT_THROW( EvaluatePostScript( "{ pop pop }", 1.0 ), PdfError );
+    CPPUNIT_ASSERT_THROW( EvaluatePostScript( "{ 0 div }", 1.0 ), PdfError );
+    CPPUNIT_ASSERT_THROW( EvaluatePostScript( "{ 1 { 2 } }", 1.0 ), PdfError );
+    CPPUNIT_ASSERT_THROW( EvaluatePostScript( "{ 1 add", 1.0 ), PdfError );
+    CPPUNIT_ASSERT_THROW( EvaluatePostScript( "{ foo }", 1.0 ), PdfError );
+    CPPUNIT_ASSERT_THROW( EvaluatePostScript( "{ 2 mod }", 1.5 ), PdfError );
+    CPPUNIT_ASSERT_THROW( EvaluatePostScript( "{ 0 gt }", 1.0 ), PdfError );
+}
+
+void FunctionTest::testEvaluateMany()
+{
+    // A typical tint transform from a Separation colorspace to DeviceCMYK
+    PdfFunctionEvaluator evaluator( CreatePostScriptFunction( "{ dup 0.84 mul exch 0 exch dup 0.44 mul exch 0.21 mul }", 4 ) );
+
+    const double adInputs[] = { 0.0, 0.5, 0.5, 1.0 };
+    double adOutputs[16];
+    evaluator.Evaluate( adInputs, adOutputs, 4 );
+
+    for( int i = 0; i < 4; i++ ) 
+    {
+        double adSingle[4];
+        evaluator.Evaluate( &adInputs[i], adSingle );
+        for( int j = 0; j < 4; j++ ) 
+            CPPUNIT_ASSERT_DOUBLES_EQUAL( adSingle[j], adOutputs[4*i+j], 1e-12 );
+    }
+
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 0.84, adOutputs[12], 1e-9 );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 0.0,  adOutputs[13], 1e-9 );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 0.44, adOutputs[14], 1e-9 );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 0.21, adOutputs[15], 1e-9 );
+}
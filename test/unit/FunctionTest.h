@@ -0,0 +1,64 @@
+/***************************************************************************
+ *   Copyright (C) 2013 by Dominik Seichter                                *
+ *   domseichter@web.de                                                    *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Library General Public License as       *
+ *   published by the Free Software Foundation; either version 2 of the    *
+ *   License, or (at your option) any later version.                       *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this program; if not, write to the                 *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#ifndef _FUNCTION_TEST_H_
+#define _FUNCTION_TEST_H_
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <podofo.h>
+
+/** This test tests the class PdfFunctionEvaluator
+ */
+class FunctionTest : public CppUnit::TestFixture
+{
+  CPPUNIT_TEST_SUITE( FunctionTest );
+  CPPUNIT_TEST( testSampledFunction );
+  CPPUNIT_TEST( testExponentialFunction );
+  CPPUNIT_TEST( testStitchingFunction );
+  CPPUNIT_TEST( testPostScriptFunction );
+  CPPUNIT_TEST( testPostScriptErrors );
+  CPPUNIT_TEST( testEvaluateMany );
+  CPPUNIT_TEST_SUITE_END();
+
+ public:
+  void setUp();
+  void tearDown();
+
+  void testSampledFunction();
+  void testExponentialFunction();
+  void testStitchingFunction();
+  void testPostScriptFunction();
+  void testPostScriptErrors();
+  void testEvaluateMany();
+
+ private:
+  /** Create a PostScript calculator function with one input and nOutputs outputs
+   */
+  PoDoFo::PdfObject* CreatePostScriptFunction( const char* pszProgram, int nOutputs = 1 );
+
+  /** Evaluate a PostScript calculator function with one input and output
+   */
+  double EvaluatePostScript( const char* pszProgram, double dInput );
+
+  PoDoFo::PdfVecObjects* m_pVecObjects;
+};
+
+#endif // _FUNCTION_TEST_H_
@@ -0,0 +1,186 @@
+/***************************************************************************
+ *   Copyright (C) 2013 by Dominik Seichter                                *
+ *   domseichter@web.de                                                    *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Library General Public License as       *
+ *   published by the Free Software Foundation; either version 2 of the    *
+ *   License, or (at your option) any later version.                       *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this program; if not, write to the                 *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#include "ImageConverterTest.h"
+
+#include "imageconverter.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+using namespace PoDoFo;
+
+// Registers the fixture into the 'registry'
+CPPUNIT_TEST_SUITE_REGISTRATION( ImageConverterTest );
+
+static const int s_nImageWidth  = 4;
+static const int s_nImageHeight = 2;
+
+void ImageConverterTest::setUp()
+{
+    m_pVecObjects = new PdfVecObjects();
+}
+
+void ImageConverterTest::tearDown()
+{
+    delete m_pVecObjects;
+}
+
+PdfObject* ImageConverterTest::CreateImage( const PdfObject & rColorSpace, int nComponents, unsigned char cValue )
+{
+    const size_t lLen  = s_nImageWidth * s_nImageHeight * nComponents;
+    char*        pData = static_cast<char*>(malloc( lLen ));
+    memset( pData, cValue, lLen );
+
+    PdfObject* pImage = m_pVecObjects->CreateObject( "XObject" );
+    pImage->GetDictionary().AddKey( PdfName::KeySubtype, PdfName("Image") );
+    pImage->GetDictionary().AddKey( PdfName("Width"), PdfVariant( static_cast<pdf_int64>(s_nImageWidth) ) );
+    pImage->GetDictionary().AddKey( PdfName("Height"), PdfVariant( static_cast<pdf_int64>(s_nImageHeight) ) );
+    pImage->GetDictionary().AddKey( PdfName("BitsPerComponent"), PdfVariant( static_cast<pdf_int64>(8) ) );
+    pImage->GetDictionary().AddKey( PdfName("ColorSpace"), rColorSpace );
+    pImage->GetStream()->Set( pData, lLen, TVecFilters() );
+
+    free( pData );
+    return pImage;
+}
+
+void ImageConverterTest::TestKernel( EPdfColorSpace eSource, EPdfColorSpace eTarget, int nComponents )
+{
+    // Large enough for the main loops of the vector kernels,
+    // with an odd size so that the remainder is converted, too
+    const size_t   lMaxPixels = 1031;
+    unsigned char* pSrc       = static_cast<unsigned char*>(malloc( lMaxPixels * nComponents + 1 ));
+    unsigned char* pVector    = static_cast<unsigned char*>(malloc( lMaxPixels + 1 ));
+    unsigned char* pScalar    = static_cast<unsigned char*>(malloc( lMaxPixels + 1 ));
+
+    srand( 42 );
+    for( size_t i = 0; i < lMaxPixels * nComponents + 1; i++ )
+        pSrc[i] = static_cast<unsigned char>(rand() & 0xff);
+
+    // Include the extreme values, which are most likely to overflow
+    memset( pSrc, 0xff, 4 * nComponents );
+    memset( pSrc + 4 * nComponents, 0x00, 4 * nComponents );
+
+    // Every length up to more than one vector and unaligned buffers
+    for( size_t lOffset = 0; lOffset <= 1; lOffset++ )
+    {
+        for( size_t lPixels = 0; lPixels <= lMaxPixels; lPixels += (lPixels < 70 ? 1 : 137) )
+        {
+            memset( pVector, 0xaa, lMaxPixels + 1 );
+            memset( pScalar, 0xaa, lMaxPixels + 1 );
+
+            CPPUNIT_ASSERT( ImageConverter::ConvertPixels( eSource, eTarget, 8, pSrc + lOffset,
+                                                           pVector + lOffset, lPixels, false ) );
+            CPPUNIT_ASSERT( ImageConverter::ConvertPixels( eSource, eTarget, 8, pSrc + lOffset,
+                                                           pScalar + lOffset, lPixels, true ) );
+            CPPUNIT_ASSERT_EQUAL( 0, memcmp( pVector, pScalar, lMaxPixels + 1 ) );
+        }
+    }
+
+    free( pSrc );
+    free( pVector );
+    free( pScalar );
+}
+
+void ImageConverterTest::testKernels()
+{
+    TestKernel( ePdfColorSpace_DeviceRGB, ePdfColorSpace_DeviceGray, 3 );
+    TestKernel( ePdfColorSpace_DeviceCMYK, ePdfColorSpace_DeviceGray, 4 );
+
+    unsigned char cPixel = 0;
+    CPPUNIT_ASSERT( !ImageConverter::ConvertPixels( ePdfColorSpace_CieLab, ePdfColorSpace_DeviceGray, 8,
+                                                    &cPixel, &cPixel, 1 ) );
+}
+
+void ImageConverterTest::testICCBased()
+{
+    const unsigned char cValue = 0x80;
+    unsigned char       pRGB[3] = { cValue, cValue, cValue };
+    unsigned char       cGray;
+    CPPUNIT_ASSERT( ImageConverter::ConvertPixels( ePdfColorSpace_DeviceRGB, ePdfColorSpace_DeviceGray, 8,
+                                                   pRGB, &cGray, 1 ) );
+
+    // An ICC profile with three components and without /Alternate
+    PdfObject* pProfile = m_pVecObjects->CreateObject();
+    pProfile->GetDictionary().AddKey( PdfName("N"), PdfVariant( static_cast<pdf_int64>(3) ) );
+    pProfile->GetStream()->Set( "ICC" );
+
+    PdfArray iccBased;
+    iccBased.push_back( PdfName("ICCBased") );
+    iccBased.push_back( pProfile->Reference() );
+
+    PdfObject* pImage = CreateImage( iccBased, 3, cValue );
+
+    // An ICC profile with four components and a gray /Alternate is already gray
+    PdfObject* pGrayProfile = m_pVecObjects->CreateObject();
+    pGrayProfile->GetDictionary().AddKey( PdfName("N"), PdfVariant( static_cast<pdf_int64>(4) ) );
+    pGrayProfile->GetDictionary().AddKey( PdfName("Alternate"), PdfName("DeviceGray") );
+    pGrayProfile->GetStream()->Set( "ICC" );
+
+    PdfArray grayBased;
+    grayBased.push_back( PdfName("ICCBased") );
+    grayBased.push_back( pGrayProfile->Reference() );
+
+    PdfObject* pGrayImage = CreateImage( grayBased, 1, cValue );
+
+    ImageConverter converter( ePdfColorSpace_DeviceGray, 1 );
+    CPPUNIT_ASSERT_EQUAL( 1, converter.ConvertImages( *m_pVecObjects ) );
+
+    const PdfObject* pColorSpace = pImage->GetDictionary().GetKey( "ColorSpace" );
+    CPPUNIT_ASSERT( pColorSpace && pColorSpace->IsName() );
+    CPPUNIT_ASSERT_EQUAL( PdfName("DeviceGray"), pColorSpace->GetName() );
+
+    char*    pBuffer;
+    pdf_long lLen;
+    pImage->GetStream()->GetFilteredCopy( &pBuffer, &lLen );
+    CPPUNIT_ASSERT_EQUAL( static_cast<pdf_long>(s_nImageWidth * s_nImageHeight), lLen );
+    for( pdf_long i = 0; i < lLen; i++ )
+        CPPUNIT_ASSERT_EQUAL( static_cast<int>(cGray), static_cast<int>(static_cast<unsigned char>(pBuffer[i])) );
+
+    podofo_free( pBuffer );
+
+    pColorSpace = pGrayImage->GetDictionary().GetKey( "ColorSpace" );
+    CPPUNIT_ASSERT( pColorSpace && pColorSpace->IsArray() );
+}
+
+void ImageConverterTest::testUnsupportedColorSpace()
+{
+    PdfDictionary calRGBDict;
+    PdfArray      whitePoint;
+    whitePoint.push_back( 0.9505 );
+    whitePoint.push_back( 1.0 );
+    whitePoint.push_back( 1.089 );
+    calRGBDict.AddKey( PdfName("WhitePoint"), whitePoint );
+
+    PdfArray calRGB;
+    calRGB.push_back( PdfName("CalRGB") );
+    calRGB.push_back( calRGBDict );
+
+    PdfObject* pImage = CreateImage( calRGB, 3, 0x80 );
+
+    // The image is skipped with a warning and left unchanged
+    ImageConverter converter( ePdfColorSpace_DeviceGray, 1 );
+    CPPUNIT_ASSERT_EQUAL( 0, converter.ConvertImages( *m_pVecObjects ) );
+
+    const PdfObject* pColorSpace = pImage->GetDictionary().GetKey( "ColorSpace" );
+    CPPUNIT_ASSERT( pColorSpace && pColorSpace->IsArray() );
+    CPPUNIT_ASSERT_EQUAL( static_cast<pdf_long>(s_nImageWidth * s_nImageHeight * 3),
+                          pImage->GetStream()->GetLength() );
+}
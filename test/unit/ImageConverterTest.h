@@ -0,0 +1,62 @@
+/***************************************************************************
+ *   Copyright (C) 2013 by Dominik Seichter                                *
+ *   domseichter@web.de                                                    *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Library General Public License as       *
+ *   published by the Free Software Foundation; either version 2 of the    *
+ *   License, or (at your option) any later version.                       *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this program; if not, write to the                 *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#ifndef _IMAGE_CONVERTER_TEST_H_
+#define _IMAGE_CONVERTER_TEST_H_
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <podofo.h>
+
+/** This test tests the class ImageConverter of podofocolor
+ */
+class ImageConverterTest : public CppUnit::TestFixture
+{
+  CPPUNIT_TEST_SUITE( ImageConverterTest );
+  CPPUNIT_TEST( testKernels );
+  CPPUNIT_TEST( testICCBased );
+  CPPUNIT_TEST( testUnsupportedColorSpace );
+  CPPUNIT_TEST_SUITE_END();
+
+ public:
+  void setUp();
+  void tearDown();
+
+  /** Compare the SSE2 and NEON kernels with the scalar ones
+   */
+  void testKernels();
+  void testICCBased();
+  void testUnsupportedColorSpace();
+
+ private:
+  /** Create a 8 bit image with 4x2 pixels in the colorspace pColorSpace.
+   *  All components of all pixels are set to cValue.
+   */
+  PoDoFo::PdfObject* CreateImage( const PoDoFo::PdfObject & rColorSpace, int nComponents, unsigned char cValue );
+
+  /** Compare the vector kernel with the scalar kernel for random pixels
+   */
+  void TestKernel( PoDoFo::EPdfColorSpace eSource, PoDoFo::EPdfColorSpace eTarget, int nComponents );
+
+ private:
+  PoDoFo::PdfVecObjects* m_pVecObjects;
+};
+
+#endif // _IMAGE_CONVERTER_TEST_H_
@@ -0,0 +1,554 @@
+/***************************************************************************
+ *   Copyright (C) 2013 by Dominik Seichter                                *
+ *   domseichter@web.de                                                    *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Library General Public License as       *
+ *   published by the Free Software Foundation; either version 2 of the    *
+ *   License, or (at your option) any later version.                       *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this program; if not, write to the                 *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#include "MemDocumentTest.h"
+#include "TestUtils.h"
+
+#include <stdio.h>
+#include <sstream>
+
+using namespace PoDoFo;
+
+// Registers the fixture into the 'registry'
+CPPUNIT_TEST_SUITE_REGISTRATION( MemDocumentTest );
+
+void MemDocumentTest::setUp()
+{
+    std::ostringstream oss;
+    for( int i = 0; i < 3000; i++ )
+        oss << "Line " << i << " of the test data " << (i * 7919) % 1000 << "\n";
+
+    m_sData = oss.str();
+}
+
+void MemDocumentTest::tearDown()
+{
+}
+
+void MemDocumentTest::CreateDocument( PdfRefCountedBuffer & rBuffer, std::vector<PdfReference> & rvecStreams )
+{
+    PdfMemDocument document;
+    PdfPage*       pPage = document.CreatePage( PdfPage::CreateStandardPageSize( ePdfPageSize_A4 ) );
+    PdfPainter     painter;
+
+    painter.SetPage( pPage );
+    painter.FillRect( 10.0, 10.0, 100.0, 100.0 );
+    painter.FinishPage();
+    rvecStreams.push_back( pPage->GetContents()->Reference() );
+
+    TVecFilters vecFilters;
+    PdfObject*  pObject = document.GetObjects().CreateObject();
+    pObject->GetStream()->Set( m_sData.c_str(), m_sData.length(), vecFilters );
+    rvecStreams.push_back( pObject->Reference() );
+
+    vecFilters.push_back( ePdfFilter_FlateDecode );
+    pObject = document.GetObjects().CreateObject();
+    pObject->GetStream()->Set( m_sData.c_str(), m_sData.length(), vecFilters );
+    rvecStreams.push_back( pObject->Reference() );
+
+    vecFilters.push_back( ePdfFilter_ASCIIHexDecode );
+    pObject = document.GetObjects().CreateObject();
+    pObject->GetStream()->Set( m_sData.c_str(), m_sData.length(), vecFilters );
+    rvecStreams.push_back( pObject->Reference() );
+
+    PdfOutputDevice device( &rBuffer );
+    document.Write( &device );
+}
+
+std::string MemDocumentTest::GetRawData( PdfObject* pObject )
+{
+    CPPUNIT_ASSERT( pObject && pObject->HasStream() );
+
+    char*    pBuffer;
+    pdf_long lLen;
+    pObject->GetStream()->GetCopy( &pBuffer, &lLen );
+
+    std::string sData( pBuffer, lLen );
+    podofo_free( pBuffer );
+    return sData;
+}
+
+std::string MemDocumentTest::GetDecodedData( PdfObject* pObject )
+{
+    CPPUNIT_ASSERT( pObject && pObject->HasStream() );
+
+    char*    pBuffer;
+    pdf_long lLen;
+    pObject->GetStream()->GetFilteredCopy( &pBuffer, &lLen );
+
+    std::string sData( pBuffer, lLen );
+    podofo_free( pBuffer );
+    return sData;
+}
+
+void MemDocumentTest::CreateFlateObjects( std::string & rsObjects, std::string & rsEncoded )
+{
+    PdfVecObjects vecObjects;
+    TVecFilters   vecFilters;
+    vecFilters.push_back( ePdfFilter_FlateDecode );
+
+    PdfObject* pObject = vecObjects.CreateObject();
+    pObject->GetStream()->Set( m_sData.c_str(), m_sData.length(), vecFilters );
+    rsEncoded = GetRawData( pObject );
+
+    std::ostringstream oss;
+    oss << "10 0 obj\n<</Filter/FlateDecode/Length 11 0 R>>\nstream\r\n" << rsEncoded
+        << "\nendstream\nendobj\n11 0 obj\n" << rsEncoded.length() << "\nendobj\n";
+    rsObjects = oss.str();
+}
+
+void MemDocumentTest::testCopyRawStream()
+{
+    std::string sObjects;
+    std::string sEncoded;
+    CreateFlateObjects( sObjects, sEncoded );
+    CPPUNIT_ASSERT( sEncoded.length() > 4096 );
+
+    PdfRefCountedInputDevice device( sObjects.c_str(), sObjects.length() );
+    PdfRefCountedBuffer buffer( 1024 );
+    PdfVecObjects vecObjects;
+
+    PdfParserObject* pLength = new PdfParserObject( &vecObjects, device, buffer, sObjects.find( "11 0 obj" ) );
+    pLength->ParseFile( NULL );
+    vecObjects.push_back( pLength );
+
+    PdfParserObject object( &vecObjects, device, buffer, 0 );
+    object.SetLoadOnDemand( true );
+    object.ParseFile( NULL );
+    CPPUNIT_ASSERT( object.CanCopyRawStream() );
+
+    // The data is only referenced and copied byte for byte
+    PdfVecObjects vecTarget;
+    PdfObject*    pTarget = vecTarget.CreateObject();
+    pTarget->GetDictionary().AddKey( PdfName::KeyFilter, PdfName("FlateDecode") );
+    object.CopyRawStream( pTarget->GetStream() );
+
+    PdfMemStream* pStream = dynamic_cast<PdfMemStream*>(pTarget->GetStream());
+    CPPUNIT_ASSERT( pStream );
+    CPPUNIT_ASSERT( pStream->IsRawDataRange() );
+    CPPUNIT_ASSERT( !object.IsStreamLoaded() );
+    CPPUNIT_ASSERT_EQUAL( static_cast<pdf_long>(sEncoded.length()), pStream->GetLength() );
+
+    // Writing the target copies the data from the device
+    PdfRefCountedBuffer output;
+    PdfOutputDevice     outputDevice( &output );
+    pTarget->WriteObject( &outputDevice, ePdfWriteMode_Compact, NULL );
+    CPPUNIT_ASSERT( pStream->IsRawDataRange() );
+
+    std::string sOutput( output.GetBuffer(), outputDevice.GetLength() );
+    CPPUNIT_ASSERT( sOutput.find( "stream\n" + sEncoded + "\nendstream" ) != std::string::npos );
+
+    // Raw copies are made from the device, too
+    CPPUNIT_ASSERT( GetRawData( pTarget ) == sEncoded );
+    CPPUNIT_ASSERT( pStream->IsRawDataRange() );
+
+    // Accessing the internal buffer reads the data into memory
+    CPPUNIT_ASSERT( std::string( pStream->Get(), pStream->GetLength() ) == sEncoded );
+    CPPUNIT_ASSERT( !pStream->IsRawDataRange() );
+    CPPUNIT_ASSERT( GetDecodedData( pTarget ) == m_sData );
+
+    // A loaded stream cannot be copied
+    CPPUNIT_ASSERT( GetDecodedData( &object ) == m_sData );
+    CPPUNIT_ASSERT( !object.CanCopyRawStream() );
+}
+
+void MemDocumentTest::testCopyRawStreamToFileStream()
+{
+    std::string sObjects;
+    std::string sEncoded;
+    CreateFlateObjects( sObjects, sEncoded );
+
+    PdfRefCountedInputDevice device( sObjects.c_str(), sObjects.length() );
+    PdfRefCountedBuffer buffer( 1024 );
+    PdfVecObjects vecObjects;
+
+    PdfParserObject* pLength = new PdfParserObject( &vecObjects, device, buffer, sObjects.find( "11 0 obj" ) );
+    pLength->ParseFile( NULL );
+    vecObjects.push_back( pLength );
+
+    PdfParserObject object( &vecObjects, device, buffer, 0 );
+    object.SetLoadOnDemand( true );
+    object.ParseFile( NULL );
+
+    // A PdfFileStream copies the data in blocks using PdfStream::SetRawDataRange()
+    PdfRefCountedBuffer output;
+    PdfOutputDevice     outputDevice( &output );
+    PdfReference        ref;
+    {
+        PdfStreamedDocument writer( &outputDevice );
+        writer.CreatePage( PdfPage::CreateStandardPageSize( ePdfPageSize_A4 ) );
+
+        PdfObject* pTarget = writer.GetObjects()->CreateObject();
+        ref = pTarget->Reference();
+        pTarget->GetDictionary().AddKey( PdfName::KeyFilter, PdfName("FlateDecode") );
+        object.CopyRawStream( pTarget->GetStream() );
+        CPPUNIT_ASSERT( !object.IsStreamLoaded() );
+
+        writer.Close();
+    }
+
+    PdfMemDocument document;
+    document.Load( output.GetBuffer(), static_cast<long>(outputDevice.GetLength()) );
+
+    PdfObject* pCopy = document.GetObjects().GetObject( ref );
+    CPPUNIT_ASSERT( GetRawData( pCopy ) == sEncoded );
+    CPPUNIT_ASSERT( GetDecodedData( pCopy ) == m_sData );
+}
+
+void MemDocumentTest::testStreamPassthrough()
+{
+    PdfRefCountedBuffer       input;
+    std::vector<PdfReference> vecStreams;
+    CreateDocument( input, vecStreams );
+
+    PdfMemDocument source;
+    source.Load( input.GetBuffer(), static_cast<long>(input.GetSize()) );
+
+    PdfMemDocument target;
+    target.SetStreamPassthrough( true );
+    CPPUNIT_ASSERT( target.IsStreamPassthrough() );
+
+    const unsigned int nDifference = static_cast<unsigned int>(target.GetObjects().GetSize() +
+                                                               target.GetObjects().GetFreeObjects().size());
+    target.Append( source );
+    CPPUNIT_ASSERT_EQUAL( 1, target.GetPageCount() );
+
+    // Neither the source streams nor the appended streams are read
+    std::vector<PdfReference> vecAppended;
+    for( size_t i = 0; i < vecStreams.size(); i++ )
+    {
+        PdfParserObject* pSource = dynamic_cast<PdfParserObject*>(source.GetObjects().GetObject( vecStreams[i] ));
+        CPPUNIT_ASSERT( pSource );
+        CPPUNIT_ASSERT( !pSource->IsStreamLoaded() );
+
+        vecAppended.push_back( PdfReference( vecStreams[i].ObjectNumber() + nDifference,
+                                             vecStreams[i].GenerationNumber() ) );
+
+        PdfObject*    pAppended = target.GetObjects().GetObject( vecAppended[i] );
+        PdfMemStream* pStream   = dynamic_cast<PdfMemStream*>(pAppended->GetStream());
+        CPPUNIT_ASSERT( pStream );
+        CPPUNIT_ASSERT( pStream->IsRawDataRange() );
+    }
+
+    PdfRefCountedBuffer output;
+    PdfOutputDevice     device( &output );
+    target.Write( &device );
+
+    for( size_t i = 0; i < vecStreams.size(); i++ )
+        CPPUNIT_ASSERT( !dynamic_cast<PdfParserObject*>(source.GetObjects().GetObject( vecStreams[i] ))->IsStreamLoaded() );
+
+    // The written document contains the same encoded and decoded data
+    PdfMemDocument result;
+    result.Load( output.GetBuffer(), static_cast<long>(device.GetLength()) );
+    CPPUNIT_ASSERT_EQUAL( 1, result.GetPageCount() );
+
+    for( size_t i = 0; i < vecStreams.size(); i++ )
+    {
+        PdfObject* pSource = source.GetObjects().GetObject( vecStreams[i] );
+        PdfObject* pResult = result.GetObjects().GetObject( vecAppended[i] );
+
+        CPPUNIT_ASSERT( GetRawData( pSource ) == GetRawData( pResult ) );
+        CPPUNIT_ASSERT( GetDecodedData( pSource ) == GetDecodedData( pResult ) );
+        if( i > 0 )
+            CPPUNIT_ASSERT( GetDecodedData( pResult ) == m_sData );
+    }
+}
+
+void MemDocumentTest::testFreeObjectMemoryOnWrite()
+{
+    PdfRefCountedBuffer       input;
+    std::vector<PdfReference> vecStreams;
+    CreateDocument( input, vecStreams );
+
+    PdfMemDocument document;
+    document.Load( input.GetBuffer(), static_cast<long>(input.GetSize()) );
+    document.SetFreeObjectMemoryOnWrite( true );
+    CPPUNIT_ASSERT( document.GetFreeObjectMemoryOnWrite() );
+
+    // Stream 1 is loaded completely, only the dictionary
+    // of stream 2 is loaded and stream 3 is not loaded at all
+    PdfParserObject* pLoaded     = dynamic_cast<PdfParserObject*>(document.GetObjects().GetObject( vecStreams[1] ));
+    PdfParserObject* pDictionary = dynamic_cast<PdfParserObject*>(document.GetObjects().GetObject( vecStreams[2] ));
+    PdfParserObject* pUnloaded   = dynamic_cast<PdfParserObject*>(document.GetObjects().GetObject( vecStreams[3] ));
+    CPPUNIT_ASSERT( pLoaded && pDictionary && pUnloaded );
+
+    PdfStream*     pStream = pLoaded->GetStream();
+    PdfDictionary* pDict   = &pDictionary->GetDictionary();
+    CPPUNIT_ASSERT( pDict->HasKey( PdfName::KeyFilter ) );
+    CPPUNIT_ASSERT( !pDictionary->IsStreamLoaded() );
+    CPPUNIT_ASSERT( !pUnloaded->IsLoaded() );
+
+    // A modified object is never free'd
+    PdfObject* pInfo = document.GetInfo()->GetObject();
+    document.GetInfo()->SetTitle( PdfString("Free object memory") );
+
+    for( int i = 0; i < 2; i++ ) 
+    {
+        PdfRefCountedBuffer output;
+        PdfOutputDevice     device( &output );
+        document.Write( &device );
+
+        // Data loaded before writing stays valid, everything else was free'd
+        CPPUNIT_ASSERT( pLoaded->IsStreamLoaded() );
+        CPPUNIT_ASSERT_EQUAL( pStream, pLoaded->GetStream() );
+        CPPUNIT_ASSERT( pDictionary->IsLoaded() );
+        CPPUNIT_ASSERT_EQUAL( pDict, &pDictionary->GetDictionary() );
+        CPPUNIT_ASSERT( !pDictionary->IsStreamLoaded() );
+        CPPUNIT_ASSERT( !pUnloaded->IsLoaded() );
+        CPPUNIT_ASSERT( pInfo->IsDictionary() );
+        CPPUNIT_ASSERT( document.GetInfo()->GetTitle() == PdfString("Free object memory") );
+
+        // The written document contains all data
+        PdfMemDocument result;
+        result.Load( output.GetBuffer(), static_cast<long>(device.GetLength()) );
+        CPPUNIT_ASSERT_EQUAL( 1, result.GetPageCount() );
+        CPPUNIT_ASSERT( result.GetInfo()->GetTitle() == PdfString("Free object memory") );
+        for( size_t j = 1; j < vecStreams.size(); j++ )
+            CPPUNIT_ASSERT( GetDecodedData( result.GetObjects().GetObject( vecStreams[j] ) ) == m_sData );
+    }
+
+    // Free'd objects are read again when they are accessed
+    CPPUNIT_ASSERT( GetDecodedData( pDictionary ) == m_sData );
+    CPPUNIT_ASSERT( GetDecodedData( pUnloaded ) == m_sData );
+    CPPUNIT_ASSERT( GetDecodedData( pLoaded ) == m_sData );
+}
+
+void MemDocumentTest::testFreeObjectMemoryModifiedFile()
+{
+    PdfRefCountedBuffer       input;
+    std::vector<PdfReference> vecStreams;
+    CreateDocument( input, vecStreams );
+
+    std::string sFilename = TestUtils::getTempFilename();
+    FILE*       hFile     = fopen( sFilename.c_str(), "wb" );
+    CPPUNIT_ASSERT( hFile );
+    CPPUNIT_ASSERT_EQUAL( input.GetSize(), fwrite( input.GetBuffer(), 1, input.GetSize(), hFile ) );
+    fclose( hFile );
+
+    try {
+        PdfMemDocument document;
+        document.Load( sFilename.c_str() );
+        document.SetFreeObjectMemoryOnWrite( true );
+
+        PdfRefCountedBuffer output;
+        PdfOutputDevice     device( &output );
+        document.Write( &device );
+
+        PdfParserObject* pUnloaded = dynamic_cast<PdfParserObject*>(document.GetObjects().GetObject( vecStreams[3] ));
+        CPPUNIT_ASSERT( pUnloaded && !pUnloaded->IsLoaded() );
+
+        // Overwrite the file while it is still used by the document
+        std::string sGarbage( input.GetSize(), '%' );
+        hFile = fopen( sFilename.c_str(), "r+b" );
+        CPPUNIT_ASSERT( hFile );
+        CPPUNIT_ASSERT_EQUAL( sGarbage.length(), fwrite( sGarbage.c_str(), 1, sGarbage.length(), hFile ) );
+        fclose( hFile );
+
+        try {
+            GetDecodedData( pUnloaded );
+            CPPUNIT_FAIL( "Object read from a modified file" );
+        } catch( const PdfError & ) {
+            // An error is expected, as the object cannot be found anymore
+        }
+    } catch( PdfError & e ) {
+        TestUtils::deleteFile( sFilename.c_str() );
+        throw e;
+    }
+
+    TestUtils::deleteFile( sFilename.c_str() );
+}
+
+void MemDocumentTest::CreateEncryptedDocument( const char* pszFilename, PdfEncrypt* pEncrypt, 
+                                               int nLarge, pdf_long lLargeLen )
+{
+    PdfStreamedDocument document( pszFilename, ePdfVersion_1_6, pEncrypt );
+    PdfPage*            pPage = document.CreatePage( PdfPage::CreateStandardPageSize( ePdfPageSize_A4 ) );
+    PdfPainter          painter;
+
+    painter.SetPage( pPage );
+    painter.FillRect( 10.0, 10.0, 100.0, 100.0 );
+    painter.FinishPage();
+
+    for( int i = 0; i < 20; i++ )
+    {
+        TVecFilters vecFilters;
+        switch( i % 5 )
+        {
+            case 0:
+                vecFilters.push_back( ePdfFilter_FlateDecode );
+                break;
+            case 1:
+                vecFilters.push_back( ePdfFilter_ASCIIHexDecode );
+                break;
+            case 2:
+                vecFilters.push_back( ePdfFilter_ASCII85Decode );
+                break;
+            case 3:
+                vecFilters.push_back( ePdfFilter_FlateDecode );
+                vecFilters.push_back( ePdfFilter_ASCII85Decode );
+                break;
+            default:
+                break;
+        }
+
+        // Streams of different lengths, including empty ones
+        PdfObject* pObject = document.GetObjects()->CreateObject();
+        pObject->GetStream()->Set( m_sData.c_str(), (m_sData.length() * i) / 19, vecFilters );
+    }
+
+    // A filter which cannot be decoded
+    PdfObject* pObject = document.GetObjects()->CreateObject();
+    pObject->GetDictionary().AddKey( PdfName::KeyFilter, PdfName("JPXDecode") );
+    pObject->GetStream()->BeginAppend( TVecFilters(), true, false );
+    pObject->GetStream()->Append( m_sData.c_str(), 1000 );
+    pObject->GetStream()->EndAppend();
+
+    std::string  sLarge( static_cast<size_t>(lLargeLen), ' ' );
+    unsigned int nRandom = 1;
+    for( int i = 0; i < nLarge; i++ )
+    {
+        for( size_t j = 0; j < sLarge.length(); j++ )
+        {
+            nRandom   = nRandom * 1103515245 + 12345;
+            sLarge[j] = static_cast<char>(nRandom >> 24);
+        }
+
+        pObject = document.GetObjects()->CreateObject();
+        pObject->GetStream()->Set( sLarge.c_str(), sLarge.length(), TVecFilters() );
+    }
+
+    document.Close();
+}
+
+void MemDocumentTest::TestPreloadStreams( const char* pszFilename, bool bUncompress, int nThreads )
+{
+    PdfMemDocument preloaded;
+    PdfMemDocument serial;
+
+    PdfMemDocument* pDocuments[] = { &preloaded, &serial };
+    for( int i = 0; i < 2; i++ ) 
+    {
+        try {
+            pDocuments[i]->Load( pszFilename );
+            CPPUNIT_FAIL( "Encrypted file not recognized!" );
+        } catch( const PdfError & e ) {
+            CPPUNIT_ASSERT_EQUAL( ePdfError_InvalidPassword, e.GetError() );
+        }
+
+        pDocuments[i]->SetPassword( "user" );
+        CPPUNIT_ASSERT( pDocuments[i]->GetEncrypt() );
+    }
+
+    const int nLoaded  = preloaded.PreloadStreams( bUncompress, nThreads );
+    int       nStreams = 0;
+
+    // Loaded streams are not loaded again
+    CPPUNIT_ASSERT_EQUAL( 0, preloaded.PreloadStreams( bUncompress, nThreads ) );
+
+    TIVecObjects it = serial.GetObjects().begin();
+    while( it != serial.GetObjects().end() )
+    {
+        PdfParserObject* pSerial = dynamic_cast<PdfParserObject*>(*it);
+        ++it;
+
+        if( !pSerial || !pSerial->IsDictionary() || !pSerial->HasStreamToParse() )
+            continue;
+
+        PdfParserObject* pPreloaded = dynamic_cast<PdfParserObject*>(preloaded.GetObjects().GetObject( pSerial->Reference() ));
+        CPPUNIT_ASSERT( pPreloaded );
+        CPPUNIT_ASSERT( pPreloaded->IsStreamLoaded() );
+        ++nStreams;
+
+        const bool bJPX = pSerial->GetDictionary().GetKey( PdfName::KeyFilter ) &&
+            pSerial->GetDictionary().GetKey( PdfName::KeyFilter )->IsName() &&
+            pSerial->GetDictionary().GetKey( PdfName::KeyFilter )->GetName() == PdfName("JPXDecode");
+
+        // The serial path loads the stream using GetStream()
+        std::string sRaw = GetRawData( pSerial );
+        if( bUncompress && !bJPX && pSerial->GetDictionary().HasKey( PdfName::KeyFilter ) )
+        {
+            CPPUNIT_ASSERT( !pPreloaded->GetDictionary().HasKey( PdfName::KeyFilter ) );
+            CPPUNIT_ASSERT( GetDecodedData( pSerial ) == GetRawData( pPreloaded ) );
+        }
+        else
+        {
+            CPPUNIT_ASSERT( pSerial->GetDictionary().HasKey( PdfName::KeyFilter ) ==
+                            pPreloaded->GetDictionary().HasKey( PdfName::KeyFilter ) );
+            CPPUNIT_ASSERT( sRaw == GetRawData( pPreloaded ) );
+        }
+
+        // Keep the memory usage low for large documents
+        pSerial->FreeObjectMemory( true );
+        pPreloaded->FreeObjectMemory( true );
+    }
+
+    CPPUNIT_ASSERT_EQUAL( nStreams, nLoaded );
+}
+
+void MemDocumentTest::testPreloadStreams()
+{
+    std::string sFilename = TestUtils::getTempFilename();
+
+    try {
+        PdfEncrypt* pEncrypt[] = {
+            PdfEncrypt::CreatePdfEncrypt( "user", "owner", PdfEncrypt::ePdfPermissions_Print,
+                                          PdfEncrypt::ePdfEncryptAlgorithm_AESV2, PdfEncrypt::ePdfKeyLength_128 ),
+            PdfEncrypt::CreatePdfEncrypt( "user", "owner", PdfEncrypt::ePdfPermissions_Print,
+                                          PdfEncrypt::ePdfEncryptAlgorithm_RC4V2, PdfEncrypt::ePdfKeyLength_128 )
+        };
+
+        for( int i = 0; i < 2; i++ )
+        {
+            CreateEncryptedDocument( sFilename.c_str(), pEncrypt[i], 3, 100 * 1024 );
+            delete pEncrypt[i];
+
+            TestPreloadStreams( sFilename.c_str(), false, 4 );
+            TestPreloadStreams( sFilename.c_str(), true, 4 );
+            TestPreloadStreams( sFilename.c_str(), true, 1 );
+        }
+    } catch( PdfError & e ) {
+        TestUtils::deleteFile( sFilename.c_str() );
+        throw e;
+    }
+
+    TestUtils::deleteFile( sFilename.c_str() );
+}
+
+void MemDocumentTest::testPreloadStreamsBatches()
+{
+    std::string sFilename = TestUtils::getTempFilename();
+
+    try {
+        PdfEncrypt* pEncrypt = PdfEncrypt::CreatePdfEncrypt( "user", "owner", PdfEncrypt::ePdfPermissions_Print,
+                                                             PdfEncrypt::ePdfEncryptAlgorithm_AESV2, 
+                                                             PdfEncrypt::ePdfKeyLength_128 );
+
+        // More raw data than the 64 MB read by PreloadStreams() at once
+        CreateEncryptedDocument( sFilename.c_str(), pEncrypt, 3, 23 * 1024 * 1024 );
+        delete pEncrypt;
+
+        TestPreloadStreams( sFilename.c_str(), true, 0 );
+    } catch( PdfError & e ) {
+        TestUtils::deleteFile( sFilename.c_str() );
+        throw e;
+    }
+
+    TestUtils::deleteFile( sFilename.c_str() );
+}
@@ -0,0 +1,112 @@
+/***************************************************************************
+ *   Copyright (C) 2013 by Dominik Seichter                                *
+ *   domseichter@web.de                                                    *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Library General Public License as       *
+ *   published by the Free Software Foundation; either version 2 of the    *
+ *   License, or (at your option) any later version.                       *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this program; if not, write to the                 *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#ifndef _MEM_DOCUMENT_TEST_H_
+#define _MEM_DOCUMENT_TEST_H_
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <podofo.h>
+
+#include <string>
+#include <vector>
+
+/** This test tests how PdfMemDocument handles the streams
+ *  of parsed documents.
+ */
+class MemDocumentTest : public CppUnit::TestFixture
+{
+  CPPUNIT_TEST_SUITE( MemDocumentTest );
+  CPPUNIT_TEST( testCopyRawStream );
+  CPPUNIT_TEST( testCopyRawStreamToFileStream );
+  CPPUNIT_TEST( testStreamPassthrough );
+  CPPUNIT_TEST( testFreeObjectMemoryOnWrite );
+  CPPUNIT_TEST( testFreeObjectMemoryModifiedFile );
+  CPPUNIT_TEST( testPreloadStreams );
+  CPPUNIT_TEST( testPreloadStreamsBatches );
+  CPPUNIT_TEST_SUITE_END();
+
+ public:
+  void setUp();
+  void tearDown();
+
+  void testCopyRawStream();
+  void testCopyRawStreamToFileStream();
+  void testStreamPassthrough();
+  void testFreeObjectMemoryOnWrite();
+
+  /** Objects which are read again after the file was modified
+   *  must raise an error.
+   */
+  void testFreeObjectMemoryModifiedFile();
+
+  /** Preload small encrypted streams on several threads
+   */
+  void testPreloadStreams();
+
+  /** Preload encrypted streams which are larger than one batch
+   */
+  void testPreloadStreamsBatches();
+
+ private:
+  /** Write a document with a page and several streams using different filters.
+   *
+   *  @param rBuffer the document is written to this buffer
+   *  @param rvecStreams the references of all streams are added
+   */
+  void CreateDocument( PoDoFo::PdfRefCountedBuffer & rBuffer, std::vector<PoDoFo::PdfReference> & rvecStreams );
+
+  /** \returns the raw stream data of pObject
+   */
+  std::string GetRawData( PoDoFo::PdfObject* pObject );
+
+  /** \returns the decoded stream data of pObject
+   */
+  std::string GetDecodedData( PoDoFo::PdfObject* pObject );
+
+  /** Flate encode m_sData into a stream object, which
+   *  has an indirect /Length, and parse it.
+   *
+   *  @param rsObjects the PDF data of the objects is stored here
+   *  @param rsEncoded the encoded data is stored here
+   */
+  void CreateFlateObjects( std::string & rsObjects, std::string & rsEncoded );
+
+  /** Write an encrypted document with the user password "user"
+   *  and streams using different filters.
+   *
+   *  @param pszFilename write the document to this file
+   *  @param pEncrypt encryption settings
+   *  @param nLarge number of additional unfiltered streams
+   *  @param lLargeLen size of each additional stream
+   */
+  void CreateEncryptedDocument( const char* pszFilename, PoDoFo::PdfEncrypt* pEncrypt,
+                                int nLarge, PoDoFo::pdf_long lLargeLen );
+
+  /** Compare the streams loaded by PdfMemDocument::PreloadStreams()
+   *  with the streams loaded one by one by PdfObject::GetStream().
+   */
+  void TestPreloadStreams( const char* pszFilename, bool bUncompress, int nThreads );
+
+ private:
+  std::string m_sData;  ///< Test data larger than the 4 KB blocks used to copy streams
+};
+
+#endif // _MEM_DOCUMENT_TEST_H_
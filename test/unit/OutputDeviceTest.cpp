@@ -0,0 +1,128 @@
+/***************************************************************************
+ *   Copyright (C) 2013 by Dominik Seichter                                *
+ *   domseichter@web.de                                                    *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Library General Public License as       *
+ *   published by the Free Software Foundation; either version 2 of the    *
+ *   License, or (at your option) any later version.                       *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this program; if not, write to the                 *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#include "OutputDeviceTest.h"
+#include "TestUtils.h"
+
+#include <podofo.h>
+
+#include <fstream>
+#include <sstream>
+
+using namespace PoDoFo;
+
+// Registers the fixture into the 'registry'
+CPPUNIT_TEST_SUITE_REGISTRATION( OutputDeviceTest );
+
+// Use a small buffer, so that all tests have to flush it
+static const size_t s_lBufferSize = 4096;
+
+void OutputDeviceTest::setUp()
+{
+    m_sFilename = TestUtils::getTempFilename();
+}
+
+void OutputDeviceTest::tearDown()
+{
+    TestUtils::deleteFile( m_sFilename.c_str() );
+}
+
+std::string OutputDeviceTest::ReadFile() const
+{
+    std::ifstream file( m_sFilename.c_str(), std::ios_base::binary );
+    std::ostringstream oss;
+    oss << file.rdbuf();
+    return oss.str();
+}
+
+void OutputDeviceTest::testBufferedWrite()
+{
+    std::string sExpected;
+    {
+        PdfBufferedOutputDevice device( m_sFilename.c_str(), s_lBufferSize );
+
+        for( int i = 0; i < 2000; i++ )
+        {
+            std::ostringstream oss;
+            oss << i << " 0 obj\n";
+            sExpected += oss.str();
+
+            device.WriteNumber( i );
+            device.Print( " %i obj\n", 0 );
+            CPPUNIT_ASSERT_EQUAL( sExpected.size(), device.Tell() );
+        }
+
+        // Larger than the buffer, written without copying
+        std::string sLarge( 3 * s_lBufferSize, 'x' );
+        device.Write( sLarge.c_str(), sLarge.size() );
+        sExpected += sLarge;
+
+        device.Write( "endobj\n", 7 );
+        sExpected += "endobj\n";
+
+        CPPUNIT_ASSERT_EQUAL( sExpected.size(), device.GetLength() );
+        CPPUNIT_ASSERT_EQUAL( sExpected.size(), device.Tell() );
+        device.Flush();
+    }
+
+    CPPUNIT_ASSERT_EQUAL( sExpected, ReadFile() );
+}
+
+void OutputDeviceTest::testBufferedSeekAndRead()
+{
+    std::string sExpected( 10000, 'a' );
+    for( size_t i = 0; i < sExpected.size(); i++ ) 
+        sExpected[i] = static_cast<char>('a' + i % 26);
+
+    {
+        PdfBufferedOutputDevice device( m_sFilename.c_str(), s_lBufferSize );
+        device.Write( sExpected.c_str(), 5000 );
+        device.Write( sExpected.c_str() + 5000, 5000 );
+
+        // Overwrite the end of the file, as PdfImmediateWriter does
+        device.Seek( device.Tell() - 7 );
+        device.Write( "stream\n", 7 );
+        sExpected.replace( sExpected.size() - 7, 7, "stream\n" );
+
+        // Overwrite data which has been written to the file already
+        device.Seek( 10 );
+        device.Write( "0123456789", 10 );
+        sExpected.replace( 10, 10, "0123456789" );
+        CPPUNIT_ASSERT_EQUAL( static_cast<size_t>(20), device.Tell() );
+        CPPUNIT_ASSERT_EQUAL( sExpected.size(), device.GetLength() );
+
+        // Reading has to return data which was still in the buffer
+        char szBuffer[16];
+        device.Seek( 5 );
+        CPPUNIT_ASSERT_EQUAL( static_cast<size_t>(16), device.Read( szBuffer, 16 ) );
+        CPPUNIT_ASSERT_EQUAL( sExpected.substr( 5, 16 ), std::string( szBuffer, 16 ) );
+        CPPUNIT_ASSERT_EQUAL( static_cast<size_t>(21), device.Tell() );
+
+        device.Seek( sExpected.size() - 4 );
+        CPPUNIT_ASSERT_EQUAL( static_cast<size_t>(4), device.Read( szBuffer, 16 ) );
+        CPPUNIT_ASSERT_EQUAL( sExpected.substr( sExpected.size() - 4 ), std::string( szBuffer, 4 ) );
+
+        // Append after reading
+        device.Write( "%%EOF\n", 6 );
+        sExpected += "%%EOF\n";
+    }
+
+    CPPUNIT_ASSERT_EQUAL( sExpected, ReadFile() );
+}
@@ -0,0 +1,52 @@
+/***************************************************************************
+ *   Copyright (C) 2013 by Dominik Seichter                                *
+ *   domseichter@web.de                                                    *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Library General Public License as       *
+ *   published by the Free Software Foundation; either version 2 of the    *
+ *   License, or (at your option) any later version.                       *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this program; if not, write to the                 *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#ifndef _OUTPUT_DEVICE_TEST_H_
+#define _OUTPUT_DEVICE_TEST_H_
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <string>
+
+/** This test tests the class PdfBufferedOutputDevice
+ */
+class OutputDeviceTest : public CppUnit::TestFixture
+{
+  CPPUNIT_TEST_SUITE( OutputDeviceTest );
+  CPPUNIT_TEST( testBufferedWrite );
+  CPPUNIT_TEST( testBufferedSeekAndRead );
+  CPPUNIT_TEST_SUITE_END();
+
+ public:
+  void setUp();
+  void tearDown();
+
+  void testBufferedWrite();
+  void testBufferedSeekAndRead();
+
+ private:
+  /** Read the complete file written by the test
+   */
+  std::string ReadFile() const;
+
+  std::string m_sFilename;
+};
+
+#endif // _OUTPUT_DEVICE_TEST_H_
@@ -22,6 +22,8 @@
 
 #include <podofo.h>
 
+#include <sstream>
+
 #define PODOFO_TEST_PAGE_KEY "PoDoFoTestPageNumber"
 #define PODOFO_TEST_NUM_PAGES 100
 
@@ -355,6 +357,156 @@ void PagesTreeTest::CreateTestTreeCustom( PoDoFo::PdfMemDocument & rDoc )
 }
 
 
+void PagesTreeTest::testFlushStreamed()
+{
+    PdfRefCountedBuffer buffer;
+    PdfOutputDevice     device( &buffer );
+
+    {
+        PdfStreamedDocument writer( &device );
+        PdfPainter          painter;
+
+        for( int i=0; i<PODOFO_TEST_NUM_PAGES; i++ )
+        {
+            PdfPage* pPage = writer.CreatePage( PdfPage::CreateStandardPageSize( ePdfPageSize_A4 ) );
+            pPage->GetObject()->GetDictionary().AddKey( PODOFO_TEST_PAGE_KEY, static_cast<pdf_int64>(i) );
+            pPage->CreateAnnotation( ePdfAnnotation_Text, PdfRect( 10.0, 10.0, 50.0, 50.0 ) );
+
+            painter.SetPage( pPage );
+            painter.FillRect( 100.0, 100.0, 200.0, 200.0 );
+            painter.FinishPage();
+
+            writer.FlushPage( pPage );
+            CPPUNIT_ASSERT( writer.GetPage( i ) == NULL );
+        }
+
+        // Only the catalog, the info dictionary and the pages tree
+        // are left in memory, independent of the number of pages
+        CPPUNIT_ASSERT( writer.GetObjects()->GetSize() < 5 );
+        CPPUNIT_ASSERT_EQUAL( PODOFO_TEST_NUM_PAGES, writer.GetPageCount() );
+
+        writer.Close();
+    }
+
+    PdfMemDocument doc;
+    doc.Load( buffer.GetBuffer(), static_cast<long>(buffer.GetSize()) );
+
+    CPPUNIT_ASSERT_EQUAL( PODOFO_TEST_NUM_PAGES, doc.GetPageCount() );
+    for( int i=0; i<PODOFO_TEST_NUM_PAGES; i++ )
+    {
+        PdfPage* pPage = doc.GetPage( i );
+        CPPUNIT_ASSERT( pPage != NULL );
+        CPPUNIT_ASSERT( IsPageNumber( pPage, i ) );
+        CPPUNIT_ASSERT_EQUAL( 1, pPage->GetNumAnnots() );
+        CPPUNIT_ASSERT( pPage->GetContents()->HasStream() );
+    }
+}
+
+void PagesTreeTest::testFlushWhilePainting()
+{
+    PdfRefCountedBuffer buffer;
+    PdfOutputDevice     device( &buffer );
+
+    {
+        PdfStreamedDocument writer( &device );
+        PdfPainter          painter;
+        PdfPage*            pLast = NULL;
+
+        for( int i=0; i<PODOFO_TEST_NUM_PAGES; i++ )
+        {
+            PdfPage* pPage = writer.CreatePage( PdfPage::CreateStandardPageSize( ePdfPageSize_A4 ) );
+            pPage->GetObject()->GetDictionary().AddKey( PODOFO_TEST_PAGE_KEY, static_cast<pdf_int64>(i) );
+            pPage->CreateAnnotation( ePdfAnnotation_Text, PdfRect( 10.0, 10.0, 50.0, 50.0 ) );
+
+            // Flush the previous page while the stream
+            // of the current page is open for appending
+            painter.SetPage( pPage );
+            if( pLast ) 
+                writer.FlushPage( pLast );
+
+            painter.FillRect( 100.0, 100.0, 200.0, 200.0 );
+            painter.FinishPage();
+
+            pLast = pPage;
+        }
+
+        writer.FlushPage( pLast );
+        CPPUNIT_ASSERT( writer.GetObjects()->GetSize() < 5 );
+
+        writer.Close();
+    }
+
+    PdfMemDocument doc;
+    doc.Load( buffer.GetBuffer(), static_cast<long>(buffer.GetSize()) );
+
+    CPPUNIT_ASSERT_EQUAL( PODOFO_TEST_NUM_PAGES, doc.GetPageCount() );
+    for( int i=0; i<PODOFO_TEST_NUM_PAGES; i++ )
+    {
+        PdfPage* pPage = doc.GetPage( i );
+        CPPUNIT_ASSERT( pPage != NULL );
+        CPPUNIT_ASSERT( IsPageNumber( pPage, i ) );
+        CPPUNIT_ASSERT_EQUAL( 1, pPage->GetNumAnnots() );
+
+        char*    pBuffer;
+        pdf_long lLen;
+        pPage->GetContents()->GetStream()->GetFilteredCopy( &pBuffer, &lLen );
+        std::string sContents( pBuffer, lLen );
+        podofo_free( pBuffer );
+
+        CPPUNIT_ASSERT( sContents.find( " re" ) != std::string::npos );
+        CPPUNIT_ASSERT( sContents.find( "endstream" ) == std::string::npos );
+    }
+}
+
+static void GenerateTestPage( int nPage, PdfPageBuffer & rBuffer, void* )
+{
+    PdfPainter painter;
+
+    painter.SetPage( &rBuffer );
+    painter.FillRect( 100.0, 100.0, static_cast<double>(nPage + 1), 200.0 );
+    painter.FinishPage();
+}
+
+void PagesTreeTest::testGeneratePages()
+{
+    PdfRefCountedBuffer buffer;
+    PdfOutputDevice     device( &buffer );
+
+    {
+        PdfStreamedDocument writer( &device );
+
+        writer.GeneratePages( PODOFO_TEST_NUM_PAGES, PdfPage::CreateStandardPageSize( ePdfPageSize_A4 ),
+                              GenerateTestPage, NULL, 4, 3 );
+
+        CPPUNIT_ASSERT( writer.GetObjects()->GetSize() < 5 );
+        CPPUNIT_ASSERT_EQUAL( PODOFO_TEST_NUM_PAGES, writer.GetPageCount() );
+
+        writer.Close();
+    }
+
+    PdfMemDocument doc;
+    doc.Load( buffer.GetBuffer(), static_cast<long>(buffer.GetSize()) );
+
+    CPPUNIT_ASSERT_EQUAL( PODOFO_TEST_NUM_PAGES, doc.GetPageCount() );
+    for( int i=0; i<PODOFO_TEST_NUM_PAGES; i++ )
+    {
+        PdfPage* pPage = doc.GetPage( i );
+        CPPUNIT_ASSERT( pPage != NULL );
+
+        char*    pBuffer;
+        pdf_long lLen;
+        pPage->GetContents()->GetStream()->GetFilteredCopy( &pBuffer, &lLen );
+
+        // Pages have to be written in order, even if generated concurrently
+        std::ostringstream oss;
+        oss << " " << (i + 1) << ".000 200.000 re";
+        std::string sContents( pBuffer, lLen );
+        podofo_free( pBuffer );
+
+        CPPUNIT_ASSERT( sContents.find( oss.str() ) != std::string::npos );
+    }
+}
+
 bool PagesTreeTest::IsPageNumber( PoDoFo::PdfPage* pPage, int nNumber )
 {
     long long lPageNumber = pPage->GetObject()->GetDictionary().GetKeyAsLong( PODOFO_TEST_PAGE_KEY, -1 );
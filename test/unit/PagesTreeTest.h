@@ -44,6 +44,9 @@ class PagesTreeTest : public CppUnit::TestFixture
   CPPUNIT_TEST( testInsertPoDoFo );
   CPPUNIT_TEST( testDeleteAllCustom );
   CPPUNIT_TEST( testDeleteAllPoDoFo );
+  CPPUNIT_TEST( testFlushStreamed );
+  CPPUNIT_TEST( testFlushWhilePainting );
+  CPPUNIT_TEST( testGeneratePages );
   CPPUNIT_TEST_SUITE_END();
 
  public:
@@ -61,6 +64,9 @@ class PagesTreeTest : public CppUnit::TestFixture
   void testInsertPoDoFo();
   void testDeleteAllCustom();
   void testDeleteAllPoDoFo();
+  void testFlushStreamed();
+  void testFlushWhilePainting();
+  void testGeneratePages();
     
  private:
   void testGetPages( PoDoFo::PdfMemDocument & doc );
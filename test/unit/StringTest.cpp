@@ -315,4 +315,97 @@ void StringTest::testEmptyString()
 
 }
 
+void StringTest::testConvertUtf8Utf16()
+{
+    // Runs of ASCII characters of different lengths are converted by the
+    // vector kernels, all other characters one by one.
+    const char*          ppszUtf8[]  = { "\xC3\xA9", "\xE4\xB8\xAD", "\xF0\x9F\x98\x80" };
+    const unsigned char  ppszUtf16[][4] = { { 0x00, 0xE9 }, { 0x4E, 0x2D }, { 0xD8, 0x3D, 0xDE, 0x00 } };
+    const int            pnUtf16[]   = { 2, 2, 4 };
+    const int            pnAscii[]   = { 0, 1, 7, 8, 15, 16, 17, 31, 32, 33, 70 };
+
+    std::string sUtf8;
+    std::string sUtf16;
+    for( int i = 0; i < static_cast<int>(sizeof(pnAscii) / sizeof(int)); i++ )
+    {
+        for( int c = 0; c < pnAscii[i]; c++ )
+        {
+            sUtf8  += static_cast<char>('A' + c % 26);
+            sUtf16 += '\0';
+            sUtf16 += static_cast<char>('A' + c % 26);
+        }
+
+        sUtf8 += ppszUtf8[i % 3];
+        sUtf16.append( reinterpret_cast<const char*>(ppszUtf16[i % 3]), pnUtf16[i % 3] );
+    }
+
+    std::vector<pdf_utf16be> vecUtf16( sUtf8.size() + 1 );
+    pdf_long lLen = PdfString::ConvertUTF8toUTF16( reinterpret_cast<const pdf_utf8*>(sUtf8.c_str()), 
+                                                   static_cast<pdf_long>(sUtf8.size()), 
+                                                   &vecUtf16[0], static_cast<pdf_long>(vecUtf16.size()) );
+
+    // The terminating zero is converted as well
+    CPPUNIT_ASSERT_EQUAL( static_cast<pdf_long>(sUtf16.size() / 2 + 1), lLen );
+    CPPUNIT_ASSERT( memcmp( sUtf16.c_str(), &vecUtf16[0], sUtf16.size() ) == 0 );
+    CPPUNIT_ASSERT_EQUAL( static_cast<pdf_utf16be>(0), vecUtf16[lLen - 1] );
+
+    std::vector<pdf_utf8> vecUtf8( sUtf8.size() + 1 );
+    lLen = PdfString::ConvertUTF16toUTF8( &vecUtf16[0], static_cast<pdf_long>(sUtf16.size() / 2), 
+                                          &vecUtf8[0], static_cast<pdf_long>(vecUtf8.size()) );
+
+    CPPUNIT_ASSERT_EQUAL( static_cast<pdf_long>(sUtf8.size() + 1), lLen );
+    CPPUNIT_ASSERT_EQUAL( sUtf8, std::string( reinterpret_cast<const char*>(&vecUtf8[0]) ) );
+
+    // Target buffers which are too small
+    CPPUNIT_ASSERT_THROW( PdfString::ConvertUTF8toUTF16( reinterpret_cast<const pdf_utf8*>(sUtf8.c_str()), 
+                                                         static_cast<pdf_long>(sUtf8.size()), 
+                                                         &vecUtf16[0], 100 ), PdfError );
+    CPPUNIT_ASSERT_THROW( PdfString::ConvertUTF16toUTF8( &vecUtf16[0], static_cast<pdf_long>(sUtf16.size() / 2), 
+                                                         &vecUtf8[0], 100 ), PdfError );
+}
+
+void StringTest::testShortAndLongStrings()
+{
+    // Short strings are stored inside of PdfString,
+    // longer strings in a PdfRefCountedBuffer
+    PdfString sPrevious;
+    for( int i = 0; i < 3 * PDF_STRING_BUFFER_SIZE; i++ )
+    {
+        std::string sData( i, 'x' );
+        PdfString   str( sData );
+        PdfString   copy( str );
+
+        CPPUNIT_ASSERT_EQUAL( static_cast<pdf_long>(i), str.GetLength() );
+        CPPUNIT_ASSERT_EQUAL( sData, std::string( copy.GetString() ) );
+        CPPUNIT_ASSERT_EQUAL( sData, copy.GetStringUtf8() );
+        CPPUNIT_ASSERT( str == copy );
+        CPPUNIT_ASSERT( !(str == sPrevious) );
+
+        copy = sPrevious;
+        CPPUNIT_ASSERT( copy == sPrevious );
+        CPPUNIT_ASSERT_EQUAL( sData, str.GetStringUtf8() );
+
+        sPrevious = str;
+    }
+
+    // Hex data which shrinks because of whitespace
+    PdfString hex;
+    hex.SetHexData( "48                                                  65 6C 6C 6F" );
+    CPPUNIT_ASSERT_EQUAL( static_cast<pdf_long>(5), hex.GetLength() );
+    CPPUNIT_ASSERT_EQUAL( std::string( "Hello" ), hex.GetStringUtf8() );
+
+    // The UTF8 version is updated along with the contents
+    hex.SetHexData( "FEFF00570065006C0074" );
+    CPPUNIT_ASSERT( hex.IsUnicode() );
+    CPPUNIT_ASSERT_EQUAL( static_cast<pdf_long>(4), hex.GetUnicodeLength() );
+    CPPUNIT_ASSERT_EQUAL( std::string( "Welt" ), hex.GetStringUtf8() );
+
+    const char*     pszUtf8 = "Gr\xc3\xbc\xc3\x9f Gott, dies ist ein l\xc3\xa4ngerer Text";
+    const PdfString utf8( reinterpret_cast<const pdf_utf8*>(pszUtf8) );
+    PdfString       utf8Copy;
+    utf8Copy = utf8;
+    CPPUNIT_ASSERT_EQUAL( std::string( pszUtf8 ), utf8Copy.GetStringUtf8() );
+    CPPUNIT_ASSERT( utf8Copy == utf8 );
+}
+
 #endif // __clang__
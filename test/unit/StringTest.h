@@ -36,6 +36,8 @@ class StringTest : public CppUnit::TestFixture
   CPPUNIT_TEST( testEscapeBrackets );
   CPPUNIT_TEST( testWriteEscapeSequences );
   CPPUNIT_TEST( testEmptyString );
+  CPPUNIT_TEST( testConvertUtf8Utf16 );
+  CPPUNIT_TEST( testShortAndLongStrings );
   CPPUNIT_TEST_SUITE_END();
 
  public:
@@ -48,6 +50,8 @@ class StringTest : public CppUnit::TestFixture
   void testEscapeBrackets();
   void testWriteEscapeSequences();
   void testEmptyString();
+  void testConvertUtf8Utf16();
+  void testShortAndLongStrings();
 
  private:
   void TestWriteEscapeSequences(const char* pszSource, const char* pszExpected);
@@ -0,0 +1,441 @@
+/***************************************************************************
+ *   Copyright (C) 2013 by Dominik Seichter                                *
+ *   domseichter@web.de                                                    *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Library General Public License as       *
+ *   published by the Free Software Foundation; either version 2 of the    *
+ *   License, or (at your option) any later version.                       *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this program; if not, write to the                 *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#include "TextExtractorTest.h"
+
+#include <string>
+#include <vector>
+
+using namespace PoDoFo;
+
+// Registers the fixture into the 'registry'
+CPPUNIT_TEST_SUITE_REGISTRATION( TextExtractorTest );
+
+// Widths of Helvetica in 1/1000 text space units
+static const double s_dWidthA     = 0.667;
+static const double s_dWidthB     = 0.667;
+static const double s_dWidthC     = 0.722;
+static const double s_dWidthH     = 0.722;
+static const double s_dWidthSmallA = 0.556;
+static const double s_dWidthSpace = 0.278;
+
+static const double s_dEpsilon    = 0.0001;
+
+// /Widths of Helvetica for the characters 32 to 126
+static const int s_anHelveticaWidths[] = {
+     278,  278,  355,  556,  556,  889,  667,  191,  333,  333,  389,  584,  278,  333,  278,  278,
+     556,  556,  556,  556,  556,  556,  556,  556,  556,  556,  278,  278,  584,  584,  584,  556,
+    1015,  667,  667,  722,  722,  667,  611,  778,  722,  278,  500,  667,  556,  833,  722,  778,
+     667,  778,  722,  667,  611,  722,  667,  944,  667,  667,  611,  278,  278,  278,  469,  556,
+     333,  556,  556,  500,  556,  556,  278,  556,  556,  222,  222,  500,  222,  833,  556,  556,
+     556,  556,  333,  500,  278,  556,  500,  722,  500,  500,  500,  334,  260,  334,  584
+};
+
+static PdfObject* CreateStream( PdfMemDocument* pDoc, const char* pszData )
+{
+    PdfObject* pObject = pDoc->GetObjects().CreateObject();
+    pObject->GetStream()->Set( pszData );
+    return pObject;
+}
+
+static void AddResource( PdfPage* pPage, const char* pszType, const char* pszName, PdfObject* pObject )
+{
+    PdfDictionary & rResources = pPage->GetResources()->GetDictionary();
+    if( !rResources.HasKey( pszType ) )
+        rResources.AddKey( pszType, PdfDictionary() );
+
+    rResources.GetKey( pszType )->GetDictionary().AddKey( pszName, pObject->Reference() );
+}
+
+void TextExtractorTest::setUp()
+{
+    m_pDoc  = new PdfMemDocument();
+    m_pFont = m_pDoc->GetObjects().CreateObject( "Font" );
+    m_pFont->GetDictionary().AddKey( PdfName::KeySubtype, PdfName( "Type1" ) );
+    m_pFont->GetDictionary().AddKey( "BaseFont", PdfName( "Helvetica" ) );
+    m_pFont->GetDictionary().AddKey( "Encoding", PdfName( "WinAnsiEncoding" ) );
+
+    // Do not rely on the standard 14 font metrics,
+    // which are not available in all builds
+    PdfArray widths;
+    for( size_t i = 0; i < sizeof(s_anHelveticaWidths) / sizeof(int); i++ )
+        widths.push_back( static_cast<pdf_int64>(s_anHelveticaWidths[i]) );
+
+    PdfDictionary descriptor;
+    descriptor.AddKey( "Type", PdfName( "FontDescriptor" ) );
+    descriptor.AddKey( "FontName", PdfName( "Helvetica" ) );
+    descriptor.AddKey( "Flags", static_cast<pdf_int64>(32) );
+    descriptor.AddKey( "Ascent", static_cast<pdf_int64>(718) );
+    descriptor.AddKey( "Descent", static_cast<pdf_int64>(-207) );
+
+    m_pFont->GetDictionary().AddKey( "FirstChar", static_cast<pdf_int64>(32) );
+    m_pFont->GetDictionary().AddKey( "LastChar", static_cast<pdf_int64>(126) );
+    m_pFont->GetDictionary().AddKey( "Widths", widths );
+    m_pFont->GetDictionary().AddKey( "FontDescriptor", m_pDoc->GetObjects().CreateObject( descriptor )->Reference() );
+}
+
+void TextExtractorTest::tearDown()
+{
+    delete m_pDoc;
+}
+
+PdfPage* TextExtractorTest::CreatePage( const char* pszContents )
+{
+    PdfPage* pPage = m_pDoc->CreatePage( PdfPage::CreateStandardPageSize( ePdfPageSize_A4 ) );
+
+    pPage->GetContentsForAppending()->GetStream()->Set( pszContents );
+    AddResource( pPage, "Font", "F1", m_pFont );
+    return pPage;
+}
+
+void TextExtractorTest::testSimpleText()
+{
+    PdfPage*         pPage = this->CreatePage( "BT /F1 10 Tf 100 700 Td (Hello) Tj ET" );
+    PdfTextExtractor extractor( m_pDoc );
+    PdfTextPage      text;
+
+    extractor.ExtractText( pPage, text );
+
+    CPPUNIT_ASSERT_EQUAL( std::string( "Hello" ), text.GetText() );
+    CPPUNIT_ASSERT_EQUAL( static_cast<size_t>(1), text.GetRuns().size() );
+    CPPUNIT_ASSERT_EQUAL( static_cast<size_t>(5), text.GetGlyphs().size() );
+
+    const PdfTextPage::TRun & rRun = text.GetRuns()[0];
+    CPPUNIT_ASSERT( rRun.pFont != NULL );
+    CPPUNIT_ASSERT_EQUAL( std::string( "Helvetica" ), rRun.pFont->GetBaseFont().GetName() );
+    CPPUNIT_ASSERT_EQUAL( std::string( "Hello" ), text.GetText( rRun ) );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 10.0, rRun.dFontSize, s_dEpsilon );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 100.0, rRun.dX, s_dEpsilon );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 700.0, rRun.dY, s_dEpsilon );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 122.78, rRun.dEndX, s_dEpsilon );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 700.0, rRun.dEndY, s_dEpsilon );
+    CPPUNIT_ASSERT_EQUAL( static_cast<size_t>(0), rRun.nFirstGlyph );
+    CPPUNIT_ASSERT_EQUAL( static_cast<size_t>(5), rRun.nGlyphCount );
+
+    // The glyph boxes reach from the descent to the ascent of the font
+    const PdfTextPage::TGlyph & rGlyph = text.GetGlyphs()[1];
+    CPPUNIT_ASSERT_EQUAL( static_cast<pdf_uint32>('e'), rGlyph.nCode );
+    CPPUNIT_ASSERT_EQUAL( std::string( "e" ), text.GetText().substr( rGlyph.nTextOffset, rGlyph.nTextLength ) );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 100.0 + s_dWidthH * 10.0, rGlyph.bbox.GetLeft(), s_dEpsilon );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 5.56, rGlyph.bbox.GetWidth(), s_dEpsilon );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 700.0 + rRun.pFont->GetDescent() * 10.0, rGlyph.bbox.GetBottom(), s_dEpsilon );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( (rRun.pFont->GetAscent() - rRun.pFont->GetDescent()) * 10.0, rGlyph.bbox.GetHeight(), s_dEpsilon );
+
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 100.0, rRun.bbox.GetLeft(), s_dEpsilon );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 22.78, rRun.bbox.GetWidth(), s_dEpsilon );
+}
+
+#if defined(PODOFO_HAVE_FREETYPE)
+void TextExtractorTest::testStandardFont()
+{
+    // The standard 14 fonts may be used without /Widths
+    m_pFont->GetDictionary().RemoveKey( "FirstChar" );
+    m_pFont->GetDictionary().RemoveKey( "LastChar" );
+    m_pFont->GetDictionary().RemoveKey( "Widths" );
+    m_pFont->GetDictionary().RemoveKey( "FontDescriptor" );
+
+    PdfPage*         pPage = this->CreatePage( "BT /F1 10 Tf 100 700 Td (Hello) Tj ET" );
+    PdfTextExtractor extractor( m_pDoc );
+    PdfTextPage      text;
+
+    extractor.ExtractText( pPage, text );
+
+    CPPUNIT_ASSERT_EQUAL( std::string( "Hello" ), text.GetText() );
+    CPPUNIT_ASSERT_EQUAL( static_cast<size_t>(1), text.GetRuns().size() );
+
+    const PdfTextPage::TRun & rRun = text.GetRuns()[0];
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 122.78, rRun.dEndX, s_dEpsilon );
+    CPPUNIT_ASSERT( rRun.pFont->GetAscent() > 0.0 );
+    CPPUNIT_ASSERT( rRun.pFont->GetDescent() < 0.0 );
+}
+#endif // PODOFO_HAVE_FREETYPE
+
+void TextExtractorTest::testTextState()
+{
+    PdfPage*         pPage = this->CreatePage( "BT /F1 10 Tf 1 Tc 5 Tw 50 Tz 12 TL 3 Ts 3 Tr (a a) Tj T* (a) Tj ET" );
+    PdfTextExtractor extractor( m_pDoc );
+    PdfTextPage      text;
+
+    extractor.ExtractText( pPage, text );
+
+    CPPUNIT_ASSERT_EQUAL( std::string( "a aa" ), text.GetText() );
+    CPPUNIT_ASSERT_EQUAL( static_cast<size_t>(2), text.GetRuns().size() );
+
+    // Character spacing applies to every glyph, word spacing only to the space,
+    // both are scaled horizontally
+    const PdfTextPage::TRun & rFirst = text.GetRuns()[0];
+    double dAdvance = ((s_dWidthSmallA * 10.0 + 1.0) * 2.0 + s_dWidthSpace * 10.0 + 1.0 + 5.0) * 0.5;
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 0.0, rFirst.dX, s_dEpsilon );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 3.0, rFirst.dY, s_dEpsilon );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( dAdvance, rFirst.dEndX, s_dEpsilon );
+    CPPUNIT_ASSERT_EQUAL( 3, rFirst.nRenderMode );
+
+    const PdfTextPage::TGlyph & rGlyph = text.GetGlyphs()[2];
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( (s_dWidthSmallA * 10.0 + 1.0 + s_dWidthSpace * 10.0 + 6.0) * 0.5, rGlyph.bbox.GetLeft(), s_dEpsilon );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( s_dWidthSmallA * 10.0 * 0.5, rGlyph.bbox.GetWidth(), s_dEpsilon );
+
+    // T* moves to the next line, the rise is kept
+    const PdfTextPage::TRun & rSecond = text.GetRuns()[1];
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 0.0, rSecond.dX, s_dEpsilon );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( -9.0, rSecond.dY, s_dEpsilon );
+}
+
+void TextExtractorTest::testTJ()
+{
+    PdfPage*         pPage = this->CreatePage( "BT /F1 10 Tf [(A) -1000 (B) 500] TJ (C) Tj "
+                                               "0 -20 TD (A) Tj (B) ' 2 1 (C) \" ET" );
+    PdfTextExtractor extractor( m_pDoc );
+    PdfTextPage      text;
+
+    extractor.ExtractText( pPage, text );
+
+    CPPUNIT_ASSERT_EQUAL( std::string( "ABCABC" ), text.GetText() );
+    CPPUNIT_ASSERT_EQUAL( static_cast<size_t>(6), text.GetRuns().size() );
+
+    const std::vector<PdfTextPage::TRun> & rRuns = text.GetRuns();
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 0.0, rRuns[0].dX, s_dEpsilon );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( s_dWidthA * 10.0 + 10.0, rRuns[1].dX, s_dEpsilon );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( (s_dWidthA + s_dWidthB) * 10.0 + 5.0, rRuns[2].dX, s_dEpsilon );
+
+    // TD sets the leading used by ' and "
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 0.0, rRuns[3].dX, s_dEpsilon );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( -20.0, rRuns[3].dY, s_dEpsilon );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 0.0, rRuns[4].dX, s_dEpsilon );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( -40.0, rRuns[4].dY, s_dEpsilon );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 0.0, rRuns[5].dX, s_dEpsilon );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( -60.0, rRuns[5].dY, s_dEpsilon );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( s_dWidthC * 10.0 + 1.0, rRuns[5].dEndX, s_dEpsilon );
+}
+
+void TextExtractorTest::testMatrices()
+{
+    PdfPage*         pPage = this->CreatePage( "q 2 0 0 2 10 20 cm BT /F1 10 Tf 1 0 0 1 5 5 Tm (H) Tj ET Q "
+                                               "q 0 1 -1 0 0 0 cm BT /F1 10 Tf (H) Tj ET Q "
+                                               "BT /F1 10 Tf 100 100 Td (H) Tj ET" );
+    PdfTextExtractor extractor( m_pDoc );
+    PdfTextPage      text;
+
+    extractor.ExtractText( pPage, text );
+
+    CPPUNIT_ASSERT_EQUAL( static_cast<size_t>(3), text.GetRuns().size() );
+
+    const std::vector<PdfTextPage::TRun> & rRuns = text.GetRuns();
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 20.0, rRuns[0].dFontSize, s_dEpsilon );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 20.0, rRuns[0].dX, s_dEpsilon );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 30.0, rRuns[0].dY, s_dEpsilon );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 20.0 + s_dWidthH * 20.0, rRuns[0].dEndX, s_dEpsilon );
+
+    // Rotated by 90 degrees, the text runs upwards
+    const PdfTextFont* pFont = rRuns[1].pFont;
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 10.0, rRuns[1].dFontSize, s_dEpsilon );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 0.0, rRuns[1].dEndX, s_dEpsilon );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( s_dWidthH * 10.0, rRuns[1].dEndY, s_dEpsilon );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( -pFont->GetAscent() * 10.0, rRuns[1].bbox.GetLeft(), s_dEpsilon );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 0.0, rRuns[1].bbox.GetBottom(), s_dEpsilon );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( s_dWidthH * 10.0, rRuns[1].bbox.GetHeight(), s_dEpsilon );
+
+    // Q restored the CTM
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 100.0, rRuns[2].dX, s_dEpsilon );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 100.0, rRuns[2].dY, s_dEpsilon );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 10.0, rRuns[2].dFontSize, s_dEpsilon );
+}
+
+void TextExtractorTest::testForm()
+{
+    PdfPage*   pPage = this->CreatePage( "q 1 0 0 1 10 0 cm /X1 Do Q /X1 Do BT /F1 10 Tf (B) Tj ET" );
+    PdfObject* pForm = CreateStream( m_pDoc, "BT /F2 10 Tf (A) Tj ET /X1 Do" );
+
+    // The form invokes itself, which must not end in an endless loop
+    pForm->GetDictionary().AddKey( PdfName::KeyType, PdfName( "XObject" ) );
+    pForm->GetDictionary().AddKey( PdfName::KeySubtype, PdfName( "Form" ) );
+    PdfArray matrix;
+    matrix.push_back( PdfVariant( 1L ) );
+    matrix.push_back( PdfVariant( 0L ) );
+    matrix.push_back( PdfVariant( 0L ) );
+    matrix.push_back( PdfVariant( 1L ) );
+    matrix.push_back( PdfVariant( 50L ) );
+    matrix.push_back( PdfVariant( 50L ) );
+    pForm->GetDictionary().AddKey( "Matrix", matrix );
+
+    PdfDictionary fonts;
+    fonts.AddKey( "F2", m_pFont->Reference() );
+    PdfDictionary xobjects;
+    xobjects.AddKey( "X1", pForm->Reference() );
+    PdfDictionary resources;
+    resources.AddKey( "Font", fonts );
+    resources.AddKey( "XObject", xobjects );
+    pForm->GetDictionary().AddKey( "Resources", resources );
+
+    AddResource( pPage, "XObject", "X1", pForm );
+
+    PdfTextExtractor extractor( m_pDoc );
+    PdfTextPage      text;
+
+    extractor.ExtractText( pPage, text );
+
+    // Every invocation of the form shows "A" once per nesting level
+    std::string sExpected = std::string( 16, 'A' ) + std::string( 16, 'A' ) + "B";
+    CPPUNIT_ASSERT_EQUAL( sExpected, text.GetText() );
+
+    const std::vector<PdfTextPage::TRun> & rRuns = text.GetRuns();
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 60.0, rRuns[0].dX, s_dEpsilon );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 50.0, rRuns[0].dY, s_dEpsilon );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 110.0, rRuns[1].dX, s_dEpsilon );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 100.0, rRuns[1].dY, s_dEpsilon );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 50.0, rRuns[16].dX, s_dEpsilon );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 50.0, rRuns[16].dY, s_dEpsilon );
+
+    // The form does not change the state of the page
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 0.0, rRuns.back().dX, s_dEpsilon );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 0.0, rRuns.back().dY, s_dEpsilon );
+}
+
+void TextExtractorTest::testToUnicode()
+{
+    PdfPage*   pPage    = this->CreatePage( "BT /F1 10 Tf <0141> Tj ET" );
+    PdfObject* pCMap    = CreateStream( m_pDoc, "/CIDInit /ProcSet findresource begin\n"
+                                                "12 dict begin\nbegincmap\n"
+                                                "1 begincodespacerange <00> <FF> endcodespacerange\n"
+                                                "1 beginbfchar <01> <20AC> endbfchar\n"
+                                                "1 beginbfrange <41> <42> <D835DC00> endbfrange\n"
+                                                "endcmap\nCMapName currentdict /CMap defineresource pop\nend\nend\n" );
+    m_pFont->GetDictionary().AddKey( "ToUnicode", pCMap->Reference() );
+
+    PdfTextExtractor extractor( m_pDoc );
+    PdfTextPage      text;
+
+    extractor.ExtractText( pPage, text );
+
+    // U+20AC and the surrogate pair of U+1D400
+    CPPUNIT_ASSERT_EQUAL( std::string( "\xE2\x82\xAC\xF0\x9D\x90\x80" ), text.GetText() );
+    CPPUNIT_ASSERT_EQUAL( static_cast<size_t>(2), text.GetGlyphs().size() );
+    CPPUNIT_ASSERT_EQUAL( static_cast<pdf_uint32>(3), text.GetGlyphs()[0].nTextLength );
+    CPPUNIT_ASSERT_EQUAL( static_cast<pdf_uint32>(4), text.GetGlyphs()[1].nTextLength );
+}
+
+void TextExtractorTest::testCompositeFont()
+{
+    PdfPage*   pPage     = this->CreatePage( "BT /F2 10 Tf <000100020003> Tj ET" );
+    PdfObject* pCMap     = CreateStream( m_pDoc, "begincmap\n"
+                                                 "1 begincodespacerange <0000> <FFFF> endcodespacerange\n"
+                                                 "1 beginbfrange <0001> <0003> <0041> endbfrange\n"
+                                                 "endcmap\n" );
+    PdfObject* pFont     = m_pDoc->GetObjects().CreateObject( "Font" );
+    PdfObject* pCIDFont  = m_pDoc->GetObjects().CreateObject( "Font" );
+
+    PdfArray widths;
+    PdfArray range;
+    range.push_back( PdfVariant( 500L ) );
+    range.push_back( PdfVariant( 600L ) );
+    widths.push_back( PdfVariant( 1L ) );
+    widths.push_back( range );
+
+    pCIDFont->GetDictionary().AddKey( PdfName::KeySubtype, PdfName( "CIDFontType2" ) );
+    pCIDFont->GetDictionary().AddKey( "BaseFont", PdfName( "Test" ) );
+    pCIDFont->GetDictionary().AddKey( "DW", PdfVariant( 800L ) );
+    pCIDFont->GetDictionary().AddKey( "W", widths );
+
+    PdfArray descendants;
+    descendants.push_back( pCIDFont->Reference() );
+
+    pFont->GetDictionary().AddKey( PdfName::KeySubtype, PdfName( "Type0" ) );
+    pFont->GetDictionary().AddKey( "BaseFont", PdfName( "Test" ) );
+    pFont->GetDictionary().AddKey( "Encoding", PdfName( "Identity-H" ) );
+    pFont->GetDictionary().AddKey( "DescendantFonts", descendants );
+    pFont->GetDictionary().AddKey( "ToUnicode", pCMap->Reference() );
+
+    AddResource( pPage, "Font", "F2", pFont );
+
+    PdfTextExtractor extractor( m_pDoc );
+    PdfTextPage      text;
+
+    extractor.ExtractText( pPage, text );
+
+    CPPUNIT_ASSERT_EQUAL( std::string( "ABC" ), text.GetText() );
+    CPPUNIT_ASSERT_EQUAL( static_cast<size_t>(3), text.GetGlyphs().size() );
+
+    const std::vector<PdfTextPage::TGlyph> & rGlyphs = text.GetGlyphs();
+    CPPUNIT_ASSERT( text.GetRuns()[0].pFont->IsComposite() );
+    CPPUNIT_ASSERT_EQUAL( static_cast<pdf_uint32>(2), rGlyphs[1].nCode );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 5.0, rGlyphs[0].bbox.GetWidth(), s_dEpsilon );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 6.0, rGlyphs[1].bbox.GetWidth(), s_dEpsilon );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 8.0, rGlyphs[2].bbox.GetWidth(), s_dEpsilon );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 19.0, text.GetRuns()[0].dEndX, s_dEpsilon );
+}
+
+void TextExtractorTest::testMalformed()
+{
+    PdfPage*         pPage = this->CreatePage( "BT (x) Tj /F1 Tf /F9 12 Tf (y) Tj /F1 10 Tf 1 Td (z) Tj "
+                                               "[ (a) /b 5 ] TJ 7 Tj Tm ET Q Q" );
+    PdfTextExtractor extractor( m_pDoc );
+    PdfTextPage      text;
+
+    extractor.ExtractText( pPage, text );
+
+    CPPUNIT_ASSERT_EQUAL( std::string( "za" ), text.GetText() );
+    CPPUNIT_ASSERT_EQUAL( static_cast<size_t>(2), text.GetRuns().size() );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 0.0, text.GetRuns()[0].dX, s_dEpsilon );
+}
+
+void TextExtractorTest::testThreads()
+{
+    const int nPages = 24;
+
+    for( int i = 0; i < nPages; i++ )
+    {
+        std::string sContents = "BT /F1 10 Tf 72 700 Td ";
+        for( int j = 0; j <= i; j++ )
+        {
+            PdfVariant  variant( static_cast<pdf_int64>(i * 100 + j) );
+            std::string sNumber;
+            variant.ToString( sNumber );
+
+            sContents += "(Line " + sNumber + ") Tj 0 -12 Td ";
+        }
+        sContents += "ET";
+
+        this->CreatePage( sContents.c_str() );
+    }
+
+    PdfTextExtractor         extractor( m_pDoc );
+    std::vector<PdfTextPage> vecText;
+
+    extractor.ExtractText( 0, nPages, vecText, 4 );
+    CPPUNIT_ASSERT_EQUAL( static_cast<size_t>(nPages), vecText.size() );
+
+    // The result must be the same as extracting the pages one by one
+    for( int i = 0; i < nPages; i++ )
+    {
+        PdfTextPage text;
+        extractor.ExtractText( m_pDoc->GetPage( i ), text );
+
+        CPPUNIT_ASSERT_EQUAL( text.GetText(), vecText[i].GetText() );
+        CPPUNIT_ASSERT_EQUAL( static_cast<size_t>(i + 1), vecText[i].GetRuns().size() );
+        CPPUNIT_ASSERT_EQUAL( text.GetRuns().size(), vecText[i].GetRuns().size() );
+        for( size_t j = 0; j < text.GetRuns().size(); j++ )
+        {
+            CPPUNIT_ASSERT_EQUAL( text.GetRuns()[j].pFont, vecText[i].GetRuns()[j].pFont );
+            CPPUNIT_ASSERT_DOUBLES_EQUAL( text.GetRuns()[j].dX, vecText[i].GetRuns()[j].dX, s_dEpsilon );
+            CPPUNIT_ASSERT_DOUBLES_EQUAL( text.GetRuns()[j].dY, vecText[i].GetRuns()[j].dY, s_dEpsilon );
+        }
+    }
+
+    CPPUNIT_ASSERT_THROW( extractor.ExtractText( 1, nPages, vecText ), PdfError );
+}
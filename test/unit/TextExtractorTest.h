@@ -0,0 +1,74 @@
+/***************************************************************************
+ *   Copyright (C) 2013 by Dominik Seichter                                *
+ *   domseichter@web.de                                                    *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Library General Public License as       *
+ *   published by the Free Software Foundation; either version 2 of the    *
+ *   License, or (at your option) any later version.                       *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this program; if not, write to the                 *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#ifndef _TEXT_EXTRACTOR_TEST_H_
+#define _TEXT_EXTRACTOR_TEST_H_
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <podofo.h>
+
+/** This test tests the classes PdfTextExtractor and PdfTextFont
+ */
+class TextExtractorTest : public CppUnit::TestFixture
+{
+  CPPUNIT_TEST_SUITE( TextExtractorTest );
+  CPPUNIT_TEST( testSimpleText );
+#if defined(PODOFO_HAVE_FREETYPE)
+  CPPUNIT_TEST( testStandardFont );
+#endif // PODOFO_HAVE_FREETYPE
+  CPPUNIT_TEST( testTextState );
+  CPPUNIT_TEST( testTJ );
+  CPPUNIT_TEST( testMatrices );
+  CPPUNIT_TEST( testForm );
+  CPPUNIT_TEST( testToUnicode );
+  CPPUNIT_TEST( testCompositeFont );
+  CPPUNIT_TEST( testMalformed );
+  CPPUNIT_TEST( testThreads );
+  CPPUNIT_TEST_SUITE_END();
+
+ public:
+  void setUp();
+  void tearDown();
+
+  void testSimpleText();
+#if defined(PODOFO_HAVE_FREETYPE)
+  void testStandardFont();
+#endif // PODOFO_HAVE_FREETYPE
+  void testTextState();
+  void testTJ();
+  void testMatrices();
+  void testForm();
+  void testToUnicode();
+  void testCompositeFont();
+  void testMalformed();
+  void testThreads();
+
+ private:
+  /** Create a page which uses Helvetica as /F1
+   *  and has the content stream pszContents.
+   */
+  PoDoFo::PdfPage* CreatePage( const char* pszContents );
+
+  PoDoFo::PdfMemDocument* m_pDoc;
+  PoDoFo::PdfObject*      m_pFont;
+};
+
+#endif // _TEXT_EXTRACTOR_TEST_H_
@@ -22,6 +22,8 @@
 
 #include <podofo.h>
 
+#include <sstream>
+
 using namespace PoDoFo;
 
 // Registers the fixture into the 'registry'
@@ -253,3 +255,215 @@ void VariantTest::testIsDirtyFalse()
     CPPUNIT_ASSERT_EQUAL( static_cast<long>(pStream->GetLength()), 9381L );
     CPPUNIT_ASSERT_EQUAL_MESSAGE( "STREAM    IsDirty() == false", false, parser.IsDirty() );
 }
+
+static std::string WriteVariant( const PdfVariant & rVariant, EPdfWriteMode eWriteMode )
+{
+    std::string sData;
+    rVariant.ToString( sData, eWriteMode );
+    return sData;
+}
+
+void VariantTest::testWriteNumbers()
+{
+    CPPUNIT_ASSERT_EQUAL( std::string("0"), WriteVariant( PdfVariant( static_cast<pdf_int64>(0) ), ePdfWriteMode_Clean ) );
+    CPPUNIT_ASSERT_EQUAL( std::string("-42"), WriteVariant( PdfVariant( static_cast<pdf_int64>(-42) ), ePdfWriteMode_Clean ) );
+    CPPUNIT_ASSERT_EQUAL( std::string(" 1234567890123"), 
+                          WriteVariant( PdfVariant( static_cast<pdf_int64>(1234567890123LL) ), ePdfWriteMode_Compact ) );
+    CPPUNIT_ASSERT_EQUAL( std::string("-9223372036854775808"), 
+                          WriteVariant( PdfVariant( static_cast<pdf_int64>(-9223372036854775807LL - 1) ), ePdfWriteMode_Clean ) );
+
+    // Reals are written like std::fixed does
+    CPPUNIT_ASSERT_EQUAL( std::string("0.000000"), WriteVariant( PdfVariant( 0.0 ), ePdfWriteMode_Clean ) );
+    CPPUNIT_ASSERT_EQUAL( std::string("-0.000000"), WriteVariant( PdfVariant( -0.0 ), ePdfWriteMode_Clean ) );
+    CPPUNIT_ASSERT_EQUAL( std::string(" 1.500000"), WriteVariant( PdfVariant( 1.5 ), ePdfWriteMode_Compact ) );
+    CPPUNIT_ASSERT_EQUAL( std::string("-0.000001"), WriteVariant( PdfVariant( -0.000001 ), ePdfWriteMode_Clean ) );
+    CPPUNIT_ASSERT_EQUAL( std::string("123456.789000"), WriteVariant( PdfVariant( 123456.789 ), ePdfWriteMode_Clean ) );
+    CPPUNIT_ASSERT_EQUAL( std::string("0.999999"), WriteVariant( PdfVariant( 0.9999994 ), ePdfWriteMode_Clean ) );
+    CPPUNIT_ASSERT_EQUAL( std::string("1.000000"), WriteVariant( PdfVariant( 0.9999996 ), ePdfWriteMode_Clean ) );
+    // 1/128 is exactly halfway between two results and rounds to even
+    CPPUNIT_ASSERT_EQUAL( std::string("0.007812"), WriteVariant( PdfVariant( 0.0078125 ), ePdfWriteMode_Clean ) );
+    CPPUNIT_ASSERT_EQUAL( std::string("1000000000000.000000"), WriteVariant( PdfVariant( 1e12 ), ePdfWriteMode_Clean ) );
+
+    CPPUNIT_ASSERT_EQUAL( std::string(" 12 3 R"), WriteVariant( PdfVariant( PdfReference( 12, 3 ) ), ePdfWriteMode_Compact ) );
+    CPPUNIT_ASSERT_EQUAL( std::string("null"), WriteVariant( PdfVariant(), ePdfWriteMode_Clean ) );
+}
+
+/** Write pObject to a buffer and return the number of bytes written
+ */
+static pdf_long WriteObjectLength( const PdfObject* pObject, EPdfWriteMode eWriteMode )
+{
+    PdfRefCountedBuffer buffer;
+    PdfOutputDevice     device( &buffer );
+
+    pObject->WriteObject( &device, eWriteMode, NULL );
+    return static_cast<pdf_long>(device.GetLength());
+}
+
+void VariantTest::testObjectLength()
+{
+    const char* pszObject = 
+        "10 0 obj<</Length 5/Type/XObject/Subtype/Image>>stream\nabcde\nendstream\nendobj\n";
+
+    PdfRefCountedInputDevice device( pszObject, strlen( pszObject ) );
+    PdfRefCountedBuffer buffer( 1024 );
+    PdfVecObjects vecObjects;
+
+    // The stream data of a parsed object is read from the input device only when needed
+    PdfParserObject parser( &vecObjects, device, buffer, 0 );
+    parser.SetLoadOnDemand( true );
+    parser.ParseFile( NULL );
+
+    CPPUNIT_ASSERT_EQUAL( WriteObjectLength( &parser, ePdfWriteMode_Compact ), parser.GetObjectLength( ePdfWriteMode_Compact ) );
+    CPPUNIT_ASSERT_EQUAL( WriteObjectLength( &parser, ePdfWriteMode_Clean ), parser.GetObjectLength( ePdfWriteMode_Clean ) );
+
+    PdfObject* pObject = vecObjects.CreateObject();
+    pObject->GetDictionary().AddKey( PdfName("Key"), PdfString("Value") );
+    CPPUNIT_ASSERT_EQUAL( WriteObjectLength( pObject, ePdfWriteMode_Clean ), pObject->GetObjectLength( ePdfWriteMode_Clean ) );
+
+    pObject->GetStream()->Set( "0 0 m 10 10 l S" );
+    CPPUNIT_ASSERT_EQUAL( WriteObjectLength( pObject, ePdfWriteMode_Compact ), pObject->GetObjectLength( ePdfWriteMode_Compact ) );
+    CPPUNIT_ASSERT_EQUAL( WriteObjectLength( pObject, ePdfWriteMode_Clean ), pObject->GetObjectLength( ePdfWriteMode_Clean ) );
+}
+
+void VariantTest::testObjectLengthStreamNotLoaded()
+{
+    const char* pszObjects = 
+        "10 0 obj\n<</Length 5/Filter/ASCIIHexDecode>>\nstream\n41424\nendstream\nendobj\n"
+        "11 0 obj\n<</Length 12 0 R>>\nstream\r\nabcdefgh\nendstream\nendobj\n"
+        "12 0 obj\n8\nendobj\n";
+
+    PdfRefCountedInputDevice device( pszObjects, strlen( pszObjects ) );
+    PdfRefCountedBuffer buffer( 1024 );
+    PdfVecObjects vecObjects;
+
+    PdfParserObject direct( &vecObjects, device, buffer, strstr( pszObjects, "10 0 obj" ) - pszObjects );
+    PdfParserObject indirect( &vecObjects, device, buffer, strstr( pszObjects, "11 0 obj" ) - pszObjects );
+    PdfParserObject length( &vecObjects, device, buffer, strstr( pszObjects, "12 0 obj" ) - pszObjects );
+    direct.SetLoadOnDemand( true );
+    indirect.SetLoadOnDemand( true );
+    length.SetLoadOnDemand( true );
+    direct.ParseFile( NULL );
+    indirect.ParseFile( NULL );
+    length.ParseFile( NULL );
+    vecObjects.push_back( &length );
+
+    // Counting the bytes of an object must not load its stream,
+    // but the length has to match what is written after loading it
+    pdf_long lDirect   = direct.GetObjectLength( ePdfWriteMode_Clean );
+    pdf_long lIndirect = indirect.GetObjectLength( ePdfWriteMode_Compact );
+    CPPUNIT_ASSERT( !direct.IsStreamLoaded() );
+    CPPUNIT_ASSERT( !indirect.IsStreamLoaded() );
+    CPPUNIT_ASSERT( !direct.IsDirty() );
+    CPPUNIT_ASSERT( !indirect.IsDirty() );
+
+    // An indirect /Length is written as a direct one after loading
+    CPPUNIT_ASSERT_EQUAL( static_cast<pdf_int64>(8), indirect.GetDictionary().GetKeyAsLong( PdfName::KeyLength, 0 ) );
+
+    CPPUNIT_ASSERT_EQUAL( WriteObjectLength( &direct, ePdfWriteMode_Clean ), lDirect );
+    CPPUNIT_ASSERT_EQUAL( WriteObjectLength( &indirect, ePdfWriteMode_Compact ), lIndirect );
+    CPPUNIT_ASSERT( direct.IsStreamLoaded() );
+    CPPUNIT_ASSERT( indirect.IsStreamLoaded() );
+    CPPUNIT_ASSERT_EQUAL( lDirect, direct.GetObjectLength( ePdfWriteMode_Clean ) );
+    CPPUNIT_ASSERT_EQUAL( lIndirect, indirect.GetObjectLength( ePdfWriteMode_Compact ) );
+}
+
+void VariantTest::testSharedTokenizer()
+{
+    const char* pszObjects = 
+        "1 0 obj\n<</Type/Test/Value 42>>\nendobj\n"
+        "2 0 obj\n[1 2 0 R (Text)]\nendobj\n"
+        "3 0 obj\n17\nendobj\n";
+
+    PdfRefCountedInputDevice device( pszObjects, strlen( pszObjects ) );
+    PdfRefCountedBuffer buffer( 1024 );
+    PdfVecObjects vecObjects;
+
+    // All objects read from the same device share one tokenizer,
+    // which is kept alive by the objects
+    PdfParserObjectTokenizer* pTokenizer = new PdfParserObjectTokenizer( device, buffer );
+    PdfParserObject obj1( &vecObjects, pTokenizer, strstr( pszObjects, "1 0 obj" ) - pszObjects );
+    PdfParserObject obj2( &vecObjects, pTokenizer, strstr( pszObjects, "2 0 obj" ) - pszObjects );
+    PdfParserObject obj3( &vecObjects, pTokenizer, strstr( pszObjects, "3 0 obj" ) - pszObjects );
+    pTokenizer->Release();
+
+    obj1.SetLoadOnDemand( true );
+    obj2.SetLoadOnDemand( true );
+    obj3.SetLoadOnDemand( true );
+    obj1.ParseFile( NULL );
+    obj2.ParseFile( NULL );
+    obj3.ParseFile( NULL );
+
+    // A broken object must not leave any tokens
+    // behind for the next object using the tokenizer
+    PdfParserObject broken( &vecObjects, pTokenizer, strstr( pszObjects, "<<" ) - pszObjects );
+    CPPUNIT_ASSERT_THROW( broken.ParseFile( NULL ), PdfError );
+
+    // Load the objects in reverse order
+    CPPUNIT_ASSERT_EQUAL( static_cast<pdf_int64>(17), obj3.GetNumber() );
+    CPPUNIT_ASSERT_EQUAL( static_cast<size_t>(3), obj2.GetArray().size() );
+    CPPUNIT_ASSERT( PdfReference( 2, 0 ) == obj2.GetArray()[1].GetReference() );
+    CPPUNIT_ASSERT_EQUAL( std::string( "Text" ), obj2.GetArray()[2].GetString().GetStringUtf8() );
+    CPPUNIT_ASSERT_EQUAL( static_cast<pdf_int64>(42), obj1.GetDictionary().GetKeyAsLong( "Value", 0 ) );
+    CPPUNIT_ASSERT( PdfReference( 3, 0 ) == obj3.Reference() );
+    CPPUNIT_ASSERT( PdfReference( 1, 0 ) == obj1.Reference() );
+}
+
+void VariantTest::testDictionaryKeys()
+{
+    // Small dictionaries are searched linearly, larger ones
+    // using a binary search, so test both sizes
+    for( int nKeys = 1; nKeys < 3 * PODOFO_KEYMAP_LINEAR_SEARCH; nKeys++ ) 
+    {
+        PdfDictionary dict;
+        for( int i = nKeys - 1; i >= 0; i-- ) 
+        {
+            std::ostringstream oss;
+            oss << "Key" << static_cast<char>('A' + i);
+            dict.AddKey( PdfName( oss.str() ), static_cast<pdf_int64>(i) );
+        }
+        dict.AddKey( PdfName::KeyType, PdfName("Test") );
+
+        CPPUNIT_ASSERT_EQUAL( static_cast<size_t>(nKeys + 1), dict.GetKeys().size() );
+        CPPUNIT_ASSERT( !dict.HasKey( PdfName("KeyZ") ) );
+        CPPUNIT_ASSERT( !dict.HasKey( PdfName("Aaa") ) );
+        CPPUNIT_ASSERT( dict.GetKey( PdfName("Zzz") ) == NULL );
+
+        // Keys are iterated in sorted order
+        std::string sExpected = "<</Type/Test";
+        TCIKeyMap   it        = dict.GetKeys().begin();
+        for( int i = 0; i < nKeys; i++, ++it )
+        {
+            std::ostringstream oss;
+            oss << "Key" << static_cast<char>('A' + i);
+            CPPUNIT_ASSERT_EQUAL( oss.str(), (*it).first.GetName() );
+            CPPUNIT_ASSERT_EQUAL( static_cast<pdf_int64>(i), dict.GetKey( PdfName( oss.str() ) )->GetNumber() );
+
+            oss << " " << i;
+            sExpected += "/" + oss.str();
+        }
+        sExpected += ">>";
+        CPPUNIT_ASSERT( (*it).first == PdfName::KeyType );
+
+        // /Type is always written first
+        std::string sResult;
+        PdfObject( dict ).ToString( sResult, ePdfWriteMode_Compact );
+        CPPUNIT_ASSERT_EQUAL( sExpected, sResult );
+
+        PdfDictionary copy( dict );
+        CPPUNIT_ASSERT( copy == dict );
+
+        // Replace a value by itself
+        copy.AddKey( PdfName("KeyA"), *copy.GetKey( PdfName("KeyA") ) );
+        CPPUNIT_ASSERT( copy == dict );
+
+        copy.AddKey( PdfName("KeyA"), static_cast<pdf_int64>(100) );
+        CPPUNIT_ASSERT( copy != dict );
+        CPPUNIT_ASSERT_EQUAL( static_cast<pdf_int64>(100), copy.GetKey( PdfName("KeyA") )->GetNumber() );
+        CPPUNIT_ASSERT_EQUAL( static_cast<size_t>(nKeys + 1), copy.GetKeys().size() );
+
+        CPPUNIT_ASSERT( copy.RemoveKey( PdfName("KeyA") ) );
+        CPPUNIT_ASSERT( !copy.RemoveKey( PdfName("KeyA") ) );
+        CPPUNIT_ASSERT( !copy.HasKey( PdfName("KeyA") ) );
+        CPPUNIT_ASSERT_EQUAL( static_cast<size_t>(nKeys), copy.GetKeys().size() );
+    }
+}
@@ -33,6 +33,11 @@ class VariantTest : public CppUnit::TestFixture
   CPPUNIT_TEST( testNameObject );
   CPPUNIT_TEST( testIsDirtyTrue );
   CPPUNIT_TEST( testIsDirtyFalse );
+  CPPUNIT_TEST( testWriteNumbers );
+  CPPUNIT_TEST( testObjectLength );
+  CPPUNIT_TEST( testObjectLengthStreamNotLoaded );
+  CPPUNIT_TEST( testSharedTokenizer );
+  CPPUNIT_TEST( testDictionaryKeys );
   CPPUNIT_TEST_SUITE_END();
 
  public:
@@ -46,6 +51,12 @@ class VariantTest : public CppUnit::TestFixture
   void testIsDirtyTrue();
   void testIsDirtyFalse();
 
+  void testWriteNumbers();
+  void testObjectLength();
+  void testObjectLengthStreamNotLoaded();
+  void testSharedTokenizer();
+  void testDictionaryKeys();
+
  private:
 };
 
@@ -0,0 +1,81 @@
+/***************************************************************************
+ *   Copyright (C) 2010 by Dominik Seichter                                *
+ *   domseichter@web.de                                                    *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#include "cmykconverter.h"
+
+CMYKConverter::CMYKConverter()
+    : IConverter()
+{
+}
+
+CMYKConverter::~CMYKConverter()
+{
+}
+
+void CMYKConverter::StartPage( PoDoFo::PdfPage*, int )
+{
+}
+
+void CMYKConverter::EndPage( PoDoFo::PdfPage*, int )
+{
+}
+
+void CMYKConverter::StartXObject( PoDoFo::PdfXObject* )
+{
+}
+
+void CMYKConverter::EndXObject( PoDoFo::PdfXObject* )
+{
+}
+
+PoDoFo::PdfColor CMYKConverter::SetStrokingColorGray( const PoDoFo::PdfColor & rColor )
+{
+    return rColor.ConvertToCMYK();
+}
+
+PoDoFo::PdfColor CMYKConverter::SetStrokingColorRGB( const PoDoFo::PdfColor & rColor )
+{
+    return rColor.ConvertToCMYK();
+}
+
+PoDoFo::PdfColor CMYKConverter::SetStrokingColorCMYK( const PoDoFo::PdfColor & rColor )
+{
+    return rColor.ConvertToCMYK();
+}
+  
+PoDoFo::PdfColor CMYKConverter::SetNonStrokingColorGray( const PoDoFo::PdfColor & rColor )
+{
+    return rColor.ConvertToCMYK();
+}
+
+PoDoFo::PdfColor CMYKConverter::SetNonStrokingColorRGB( const PoDoFo::PdfColor & rColor )
+{
+    return rColor.ConvertToCMYK();
+}
+
+PoDoFo::PdfColor CMYKConverter::SetNonStrokingColorCMYK( const PoDoFo::PdfColor & rColor )
+{
+    return rColor.ConvertToCMYK();
+}
+
+PoDoFo::EPdfColorSpace CMYKConverter::GetImageColorSpace()
+{
+    return PoDoFo::ePdfColorSpace_DeviceCMYK;
+}
@@ -28,6 +28,7 @@ x1 ***************************************************************************/
 
 #include "graphicsstack.h"
 #include "iconverter.h"
+#include "imageconverter.h"
 
 using namespace PoDoFo;
 
@@ -143,6 +144,15 @@ void ColorChanger::start()
         ++it;
     }
 
+    // Convert the samples of all images
+    EPdfColorSpace eImageColorSpace = m_pConverter->GetImageColorSpace();
+    if( eImageColorSpace != ePdfColorSpace_Unknown )
+    {
+        ImageConverter imageConverter( eImageColorSpace );
+        int            nImages = imageConverter.ConvertImages( input.GetObjects() );
+
+        std::cout << "Converted " << nImages << " images" << std::endl;
+    }
 
     input.Write( m_sOutput.c_str() );
 }
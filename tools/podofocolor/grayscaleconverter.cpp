@@ -74,3 +74,8 @@ PoDoFo::PdfColor GrayscaleConverter::SetNonStrokingColorCMYK( const PoDoFo::PdfC
 {
     return rColor.ConvertToGrayScale();
 }
+
+PoDoFo::EPdfColorSpace GrayscaleConverter::GetImageColorSpace()
+{
+    return PoDoFo::ePdfColorSpace_DeviceGray;
+}
@@ -80,6 +80,13 @@ public:
     virtual PoDoFo::PdfColor SetNonStrokingColorGray( const PoDoFo::PdfColor & rColor );
     virtual PoDoFo::PdfColor SetNonStrokingColorRGB( const PoDoFo::PdfColor & rColor );
     virtual PoDoFo::PdfColor SetNonStrokingColorCMYK( const PoDoFo::PdfColor & rColor );
+
+    /**
+     * All images are converted to DeviceGray, too.
+     *
+     * @returns ePdfColorSpace_DeviceGray
+     */
+    virtual PoDoFo::EPdfColorSpace GetImageColorSpace();
   
 };
 
@@ -27,3 +27,8 @@ IConverter::IConverter()
 IConverter::~IConverter()
 {
 }
+
+PoDoFo::EPdfColorSpace IConverter::GetImageColorSpace()
+{
+    return PoDoFo::ePdfColorSpace_Unknown;
+}
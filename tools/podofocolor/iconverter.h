@@ -122,6 +122,17 @@ public:
      */
     virtual PoDoFo::PdfColor SetNonStrokingColorCMYK( const PoDoFo::PdfColor & rColor ) = 0;
 
+    /**
+     * This method is called once per document to find out
+     * into which colorspace all images should be converted.
+     *
+     * The default implementation returns ePdfColorSpace_Unknown,
+     * which leaves all images unchanged.
+     *
+     * @returns ePdfColorSpace_DeviceGray, ePdfColorSpace_DeviceCMYK or ePdfColorSpace_Unknown
+     */
+    virtual PoDoFo::EPdfColorSpace GetImageColorSpace();
+
 };
 
 #endif // _ICONVERTER_H_
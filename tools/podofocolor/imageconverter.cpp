@@ -0,0 +1,829 @@
+/***************************************************************************
+ *   Copyright (C) 2010 by Dominik Seichter                                *
+ *   domseichter@web.de                                                    *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#include "imageconverter.h"
+
+#include "base/util/PdfMutexWrapper.h"
+#include "base/util/PdfThreads.h"
+
+#include <cstring>
+#include <memory>
+
+// Vector kernels for the conversion of 8 bit images.
+// SSE2 is part of every x86-64 CPU, NEON of every AArch64 CPU.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  define PODOFOCOLOR_SSE2
+#  include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#  define PODOFOCOLOR_NEON
+#  include <arm_neon.h>
+#endif
+
+using namespace PoDoFo;
+
+/** Everything needed to convert one image without
+ *  touching the document, so that images can be
+ *  converted on several threads at once.
+ */
+struct TImageJob {
+    PdfObject*          pObject;
+    EPdfColorSpace      eColorSpace;        ///< Colorspace of the samples
+    int                 nBitsPerComponent;
+    pdf_long            lPixels;
+    TVecFilters         vecFilters;         ///< Filters to decode the raw data
+    PdfDictionary       dictionary;         ///< Copy of the stream dictionary for /DecodeParms
+
+    PdfRefCountedBuffer data;               ///< The raw data and after conversion the FlateDecode compressed result
+    pdf_long            lLength;
+    EPdfError           eError;             ///< ePdfError_ErrOk if the conversion was successful
+};
+
+/** Converts nPixels pixels from pSrc to pDst
+ */
+typedef void (*ImageKernel)( const unsigned char* pSrc, unsigned char* pDst, size_t nPixels );
+
+// -----------------------------------------------------
+// Kernels for 8 bits per component
+//
+// gray = 0.299 R + 0.587 G + 0.114 B and RGB = (1 - C)(1 - K) ...
+// like PdfColor, with all weights scaled to 256 and correctly
+// rounded divisions by 255. The vector kernels give exactly the
+// same results as the scalar ones.
+// -----------------------------------------------------
+
+static inline unsigned char RGBToGray( unsigned int r, unsigned int g, unsigned int b )
+{
+    return static_cast<unsigned char>((77 * r + 150 * g + 29 * b + 128) >> 8);
+}
+
+static inline unsigned char CMYKToGray( unsigned int c, unsigned int m, unsigned int y, unsigned int k )
+{
+    unsigned int t = RGBToGray( 255 - c, 255 - m, 255 - y );
+    unsigned int v = t * (255 - k) + 128;
+
+    return static_cast<unsigned char>((v + (v >> 8)) >> 8);
+}
+
+static void RGBToGray8Scalar( const unsigned char* pSrc, unsigned char* pDst, size_t nPixels )
+{
+    for( size_t i = 0; i < nPixels; i++, pSrc += 3 )
+        pDst[i] = RGBToGray( pSrc[0], pSrc[1], pSrc[2] );
+}
+
+static void CMYKToGray8Scalar( const unsigned char* pSrc, unsigned char* pDst, size_t nPixels )
+{
+    for( size_t i = 0; i < nPixels; i++, pSrc += 4 )
+        pDst[i] = CMYKToGray( pSrc[0], pSrc[1], pSrc[2], pSrc[3] );
+}
+
+#if defined(PODOFOCOLOR_SSE2)
+static inline __m128i Load32( const unsigned char* p )
+{
+    int n;
+    memcpy( &n, p, sizeof(int) );
+    return _mm_cvtsi32_si128( n );
+}
+
+/** Sum the two 32 bit halves of the weighted pixels in lo and hi
+ *  \returns the gray values of all 4 pixels as 32 bit integers
+ */
+static inline __m128i SumPairs( __m128i lo, __m128i hi )
+{
+    // lo = a0 b0 a1 b1, hi = a2 b2 a3 b3
+    lo = _mm_shuffle_epi32( lo, _MM_SHUFFLE( 3, 1, 2, 0 ) );
+    hi = _mm_shuffle_epi32( hi, _MM_SHUFFLE( 3, 1, 2, 0 ) );
+
+    __m128i sum = _mm_add_epi32( _mm_unpacklo_epi64( lo, hi ), _mm_unpackhi_epi64( lo, hi ) );
+    return _mm_srli_epi32( _mm_add_epi32( sum, _mm_set1_epi32( 128 ) ), 8 );
+}
+
+/** \returns 77 R + 150 G + 29 B of 4 pixels stored as R G B x,
+ *           rounded and divided by 256
+ */
+static inline __m128i WeightRGB4( __m128i pixels )
+{
+    const __m128i weights = _mm_setr_epi16( 77, 150, 29, 0, 77, 150, 29, 0 );
+    const __m128i zero    = _mm_setzero_si128();
+
+    return SumPairs( _mm_madd_epi16( _mm_unpacklo_epi8( pixels, zero ), weights ),
+                     _mm_madd_epi16( _mm_unpackhi_epi8( pixels, zero ), weights ) );
+}
+
+/** Load 4 RGB pixels as R G B x, reads one byte more than 4 pixels
+ */
+static inline __m128i LoadRGB4( const unsigned char* p )
+{
+    return _mm_unpacklo_epi64( _mm_unpacklo_epi32( Load32( p ), Load32( p + 3 ) ),
+                               _mm_unpacklo_epi32( Load32( p + 6 ), Load32( p + 9 ) ) );
+}
+
+static void RGBToGray8( const unsigned char* pSrc, unsigned char* pDst, size_t nPixels )
+{
+    size_t i = 0;
+
+    // The last load reads one byte of the next pixel
+    for( ; i + 8 < nPixels; i += 8, pSrc += 24 )
+    {
+        __m128i gray = _mm_packs_epi32( WeightRGB4( LoadRGB4( pSrc ) ), WeightRGB4( LoadRGB4( pSrc + 12 ) ) );
+        _mm_storel_epi64( reinterpret_cast<__m128i*>(pDst + i), _mm_packus_epi16( gray, gray ) );
+    }
+
+    RGBToGray8Scalar( pSrc, pDst + i, nPixels - i );
+}
+
+static void CMYKToGray8( const unsigned char* pSrc, unsigned char* pDst, size_t nPixels )
+{
+    const __m128i invert = _mm_set1_epi8( static_cast<char>(0xff) );
+    const __m128i round  = _mm_set1_epi16( 128 );
+    size_t        i      = 0;
+
+    for( ; i + 8 <= nPixels; i += 8, pSrc += 32 )
+    {
+        __m128i a = _mm_xor_si128( _mm_loadu_si128( reinterpret_cast<const __m128i*>(pSrc) ), invert );
+        __m128i b = _mm_xor_si128( _mm_loadu_si128( reinterpret_cast<const __m128i*>(pSrc + 16) ), invert );
+
+        // Gray of the inverted C M Y as RGB and 255 - K, both 16 bit
+        __m128i t = _mm_packs_epi32( WeightRGB4( a ), WeightRGB4( b ) );
+        __m128i k = _mm_packs_epi32( _mm_srli_epi32( a, 24 ), _mm_srli_epi32( b, 24 ) );
+
+        // t * k <= 65025 fits into 16 bits unsigned
+        __m128i v    = _mm_add_epi16( _mm_mullo_epi16( t, k ), round );
+        __m128i gray = _mm_srli_epi16( _mm_add_epi16( v, _mm_srli_epi16( v, 8 ) ), 8 );
+        _mm_storel_epi64( reinterpret_cast<__m128i*>(pDst + i), _mm_packus_epi16( gray, gray ) );
+    }
+
+    CMYKToGray8Scalar( pSrc, pDst + i, nPixels - i );
+}
+#elif defined(PODOFOCOLOR_NEON)
+static inline uint8x8_t WeightRGB8( uint8x8_t r, uint8x8_t g, uint8x8_t b )
+{
+    uint16x8_t sum = vmull_u8( r, vdup_n_u8( 77 ) );
+    sum = vmlal_u8( sum, g, vdup_n_u8( 150 ) );
+    sum = vmlal_u8( sum, b, vdup_n_u8( 29 ) );
+
+    return vrshrn_n_u16( sum, 8 );
+}
+
+static void RGBToGray8( const unsigned char* pSrc, unsigned char* pDst, size_t nPixels )
+{
+    size_t i = 0;
+
+    for( ; i + 16 <= nPixels; i += 16, pSrc += 48 )
+    {
+        uint8x16x3_t rgb = vld3q_u8( pSrc );
+
+        vst1q_u8( pDst + i, vcombine_u8( WeightRGB8( vget_low_u8( rgb.val[0] ), vget_low_u8( rgb.val[1] ), vget_low_u8( rgb.val[2] ) ),
+                                         WeightRGB8( vget_high_u8( rgb.val[0] ), vget_high_u8( rgb.val[1] ), vget_high_u8( rgb.val[2] ) ) ) );
+    }
+
+    RGBToGray8Scalar( pSrc, pDst + i, nPixels - i );
+}
+
+static inline uint8x8_t MultiplyDiv255( uint8x8_t a, uint8x8_t b )
+{
+    uint16x8_t v = vmull_u8( a, b );
+    return vraddhn_u16( v, vrshrq_n_u16( v, 8 ) );
+}
+
+static void CMYKToGray8( const unsigned char* pSrc, unsigned char* pDst, size_t nPixels )
+{
+    size_t i = 0;
+
+    for( ; i + 16 <= nPixels; i += 16, pSrc += 64 )
+    {
+        uint8x16x4_t cmyk = vld4q_u8( pSrc );
+        uint8x16_t   c    = vmvnq_u8( cmyk.val[0] );
+        uint8x16_t   m    = vmvnq_u8( cmyk.val[1] );
+        uint8x16_t   y    = vmvnq_u8( cmyk.val[2] );
+        uint8x16_t   k    = vmvnq_u8( cmyk.val[3] );
+
+        uint8x8_t lo = MultiplyDiv255( WeightRGB8( vget_low_u8( c ), vget_low_u8( m ), vget_low_u8( y ) ), vget_low_u8( k ) );
+        uint8x8_t hi = MultiplyDiv255( WeightRGB8( vget_high_u8( c ), vget_high_u8( m ), vget_high_u8( y ) ), vget_high_u8( k ) );
+        vst1q_u8( pDst + i, vcombine_u8( lo, hi ) );
+    }
+
+    CMYKToGray8Scalar( pSrc, pDst + i, nPixels - i );
+}
+#else
+#define RGBToGray8  RGBToGray8Scalar
+#define CMYKToGray8 CMYKToGray8Scalar
+#endif
+
+/** 255 * 65536 / n rounded, to replace the division in RGBToCMYK8
+ */
+class TReciprocals {
+public:
+    TReciprocals()
+    {
+        m_anValues[0] = 0;
+        for( unsigned int i = 1; i < 256; i++ )
+            m_anValues[i] = (255 * 65536 + i / 2) / i;
+    }
+
+    unsigned int operator[]( unsigned int n ) const
+    {
+        return m_anValues[n];
+    }
+
+private:
+    unsigned int m_anValues[256];
+};
+
+static const TReciprocals s_reciprocals;
+
+static void RGBToCMYK8( const unsigned char* pSrc, unsigned char* pDst, size_t nPixels )
+{
+    for( size_t i = 0; i < nPixels; i++, pSrc += 3, pDst += 4 )
+    {
+        // K = 1 - max and C = (1 - R - K) / (1 - K) = (max - R) / max
+        unsigned int nMax   = PDF_MAX( pSrc[0], PDF_MAX( pSrc[1], pSrc[2] ) );
+        unsigned int nRecip = s_reciprocals[nMax];
+
+        pDst[0] = static_cast<unsigned char>(((nMax - pSrc[0]) * nRecip + 0x8000) >> 16);
+        pDst[1] = static_cast<unsigned char>(((nMax - pSrc[1]) * nRecip + 0x8000) >> 16);
+        pDst[2] = static_cast<unsigned char>(((nMax - pSrc[2]) * nRecip + 0x8000) >> 16);
+        pDst[3] = static_cast<unsigned char>(255 - nMax);
+    }
+}
+
+static void GrayToCMYK8( const unsigned char* pSrc, unsigned char* pDst, size_t nPixels )
+{
+    memset( pDst, 0, nPixels * 4 );
+    for( size_t i = 0; i < nPixels; i++ )
+        pDst[i * 4 + 3] = static_cast<unsigned char>(255 - pSrc[i]);
+}
+
+// -----------------------------------------------------
+// Kernels for 16 bits per component, big endian
+// -----------------------------------------------------
+
+static inline pdf_uint32 Read16( const unsigned char* p )
+{
+    return (static_cast<pdf_uint32>(p[0]) << 8) | p[1];
+}
+
+static inline void Write16( unsigned char* p, pdf_uint32 n )
+{
+    p[0] = static_cast<unsigned char>(n >> 8);
+    p[1] = static_cast<unsigned char>(n & 0xff);
+}
+
+static inline pdf_uint32 RGB16ToGray( pdf_uint32 r, pdf_uint32 g, pdf_uint32 b )
+{
+    return (19595 * r + 38470 * g + 7471 * b + 32768) >> 16;
+}
+
+static void RGBToGray16( const unsigned char* pSrc, unsigned char* pDst, size_t nPixels )
+{
+    for( size_t i = 0; i < nPixels; i++, pSrc += 6, pDst += 2 )
+        Write16( pDst, RGB16ToGray( Read16( pSrc ), Read16( pSrc + 2 ), Read16( pSrc + 4 ) ) );
+}
+
+static void CMYKToGray16( const unsigned char* pSrc, unsigned char* pDst, size_t nPixels )
+{
+    for( size_t i = 0; i < nPixels; i++, pSrc += 8, pDst += 2 )
+    {
+        pdf_uint64 t = RGB16ToGray( 65535 - Read16( pSrc ), 65535 - Read16( pSrc + 2 ), 65535 - Read16( pSrc + 4 ) );
+        pdf_uint64 k = 65535 - Read16( pSrc + 6 );
+
+        Write16( pDst, static_cast<pdf_uint32>((t * k + 32767) / 65535) );
+    }
+}
+
+static void RGBToCMYK16( const unsigned char* pSrc, unsigned char* pDst, size_t nPixels )
+{
+    for( size_t i = 0; i < nPixels; i++, pSrc += 6, pDst += 8 )
+    {
+        pdf_uint64 r    = Read16( pSrc );
+        pdf_uint64 g    = Read16( pSrc + 2 );
+        pdf_uint64 b    = Read16( pSrc + 4 );
+        pdf_uint64 nMax = PDF_MAX( r, PDF_MAX( g, b ) );
+
+        if( nMax )
+        {
+            Write16( pDst,     static_cast<pdf_uint32>(((nMax - r) * 65535 + nMax / 2) / nMax) );
+            Write16( pDst + 2, static_cast<pdf_uint32>(((nMax - g) * 65535 + nMax / 2) / nMax) );
+            Write16( pDst + 4, static_cast<pdf_uint32>(((nMax - b) * 65535 + nMax / 2) / nMax) );
+        }
+        else
+            memset( pDst, 0, 6 );
+
+        Write16( pDst + 6, static_cast<pdf_uint32>(65535 - nMax) );
+    }
+}
+
+static void GrayToCMYK16( const unsigned char* pSrc, unsigned char* pDst, size_t nPixels )
+{
+    memset( pDst, 0, nPixels * 8 );
+    for( size_t i = 0; i < nPixels; i++, pSrc += 2, pDst += 8 )
+        Write16( pDst + 6, 65535 - Read16( pSrc ) );
+}
+
+/** \returns the kernel to convert eSource into eTarget or NULL if not supported
+ *  \param bScalar if true never return a vector kernel
+ */
+static ImageKernel GetKernel( EPdfColorSpace eSource, EPdfColorSpace eTarget, int nBitsPerComponent, 
+                              bool bScalar = false )
+{
+    const bool b16 = (nBitsPerComponent == 16);
+
+    if( eTarget == ePdfColorSpace_DeviceGray )
+    {
+        if( eSource == ePdfColorSpace_DeviceRGB )
+            return b16 ? RGBToGray16 : (bScalar ? RGBToGray8Scalar : RGBToGray8);
+        else if( eSource == ePdfColorSpace_DeviceCMYK )
+            return b16 ? CMYKToGray16 : (bScalar ? CMYKToGray8Scalar : CMYKToGray8);
+    }
+    else if( eTarget == ePdfColorSpace_DeviceCMYK )
+    {
+        if( eSource == ePdfColorSpace_DeviceRGB )
+            return b16 ? RGBToCMYK16 : RGBToCMYK8;
+        else if( eSource == ePdfColorSpace_DeviceGray )
+            return b16 ? GrayToCMYK16 : GrayToCMYK8;
+    }
+
+    return NULL;
+}
+
+static int GetComponentCount( EPdfColorSpace eColorSpace )
+{
+    switch( eColorSpace )
+    {
+        case ePdfColorSpace_DeviceGray:
+            return 1;
+        case ePdfColorSpace_DeviceRGB:
+            return 3;
+        case ePdfColorSpace_DeviceCMYK:
+            return 4;
+        case ePdfColorSpace_Separation:
+        case ePdfColorSpace_CieLab:
+        case ePdfColorSpace_Unknown:
+            break;
+    }
+
+    return 0;
+}
+
+/** Decode, convert and encode the image of a job.
+ *  Does not access the document and can run on any thread.
+ */
+static void ConvertJob( TImageJob* pJob, EPdfColorSpace eTarget )
+{
+    // Convert at most this many pixels at once
+    const size_t CHUNK_SIZE = 16384;
+
+    try {
+        PdfRefCountedBuffer decoded;
+        pdf_long            lDecoded;
+
+        if( pJob->vecFilters.size() )
+        {
+            PdfBufferOutputStream          stream( &decoded );
+            std::auto_ptr<PdfOutputStream> pDecodeStream( PdfFilterFactory::CreateDecodeStream( pJob->vecFilters, &stream,
+                                                                                                &pJob->dictionary ) );
+            pDecodeStream->Write( pJob->data.GetBuffer(), pJob->lLength );
+            pDecodeStream->Close();
+
+            lDecoded = stream.GetLength();
+        }
+        else
+        {
+            decoded  = pJob->data;
+            lDecoded = pJob->lLength;
+        }
+
+        const size_t lInSize  = GetComponentCount( pJob->eColorSpace ) * pJob->nBitsPerComponent / 8;
+        const size_t lOutSize = GetComponentCount( eTarget ) * pJob->nBitsPerComponent / 8;
+        if( lDecoded < static_cast<pdf_long>(pJob->lPixels * lInSize) )
+        {
+            PODOFO_RAISE_ERROR_INFO( ePdfError_UnexpectedEOF, "Image data is shorter than Width * Height" );
+        }
+
+        ImageKernel                pKernel = GetKernel( pJob->eColorSpace, eTarget, pJob->nBitsPerComponent );
+        std::vector<unsigned char> buffer( CHUNK_SIZE * lOutSize );
+        const unsigned char*       pSrc    = reinterpret_cast<const unsigned char*>(decoded.GetBuffer());
+
+        PdfRefCountedBuffer            encoded;
+        PdfBufferOutputStream          stream( &encoded );
+        TVecFilters                    vecFlate( 1, ePdfFilter_FlateDecode );
+        std::auto_ptr<PdfOutputStream> pEncodeStream( PdfFilterFactory::CreateEncodeStream( vecFlate, &stream ) );
+
+        pdf_long lPixels = pJob->lPixels;
+        while( lPixels )
+        {
+            size_t nPixels = static_cast<size_t>(PDF_MIN( lPixels, static_cast<pdf_long>(CHUNK_SIZE) ));
+
+            pKernel( pSrc, &buffer[0], nPixels );
+            pEncodeStream->Write( reinterpret_cast<const char*>(&buffer[0]), nPixels * lOutSize );
+
+            pSrc    += nPixels * lInSize;
+            lPixels -= nPixels;
+        }
+
+        pEncodeStream->Close();
+
+        pJob->data    = encoded;
+        pJob->lLength = stream.GetLength();
+        pJob->eError  = ePdfError_ErrOk;
+    } catch( const PdfError & e ) {
+        pJob->eError = e.GetError();
+    } catch( ... ) {
+        pJob->eError = ePdfError_OutOfMemory;
+    }
+}
+
+// -----------------------------------------------------
+// Running jobs on several threads
+// -----------------------------------------------------
+
+/** The jobs shared by all threads, each thread
+ *  takes the next job until all jobs are done.
+ */
+struct TJobQueue {
+    std::vector<TImageJob*>* pJobs;
+    size_t                   nNext;
+    EPdfColorSpace           eTarget;
+    Util::PdfMutex           mutex;
+};
+
+static TImageJob* NextJob( TJobQueue* pQueue )
+{
+    Util::PdfMutexWrapper wrapper( pQueue->mutex );
+
+    if( pQueue->nNext < pQueue->pJobs->size() )
+        return (*pQueue->pJobs)[pQueue->nNext++];
+
+    return NULL;
+}
+
+static void RunQueue( void* pData )
+{
+    TJobQueue* pQueue = static_cast<TJobQueue*>(pData);
+    TImageJob* pJob;
+
+    while( (pJob = NextJob( pQueue )) )
+        ConvertJob( pJob, pQueue->eTarget );
+}
+
+// -----------------------------------------------------
+// ImageConverter
+// -----------------------------------------------------
+
+ImageConverter::ImageConverter( EPdfColorSpace eColorSpace, int nThreads )
+    : m_eColorSpace( eColorSpace ), m_nThreads( nThreads > 0 ? nThreads : Util::GetCPUCount() ), m_nPalettes( 0 )
+{
+    if( m_eColorSpace != ePdfColorSpace_DeviceGray && m_eColorSpace != ePdfColorSpace_DeviceCMYK )
+    {
+        PODOFO_RAISE_ERROR_INFO( ePdfError_CannotConvertColor, "Images can only be converted to DeviceGray or DeviceCMYK" );
+    }
+}
+
+ImageConverter::~ImageConverter()
+{
+}
+
+bool ImageConverter::ConvertPixels( EPdfColorSpace eSource, EPdfColorSpace eTarget, int nBitsPerComponent,
+                                    const unsigned char* pSrc, unsigned char* pDst, size_t nPixels, bool bScalar )
+{
+    ImageKernel pKernel = GetKernel( eSource, eTarget, nBitsPerComponent, bScalar );
+    if( !pKernel || (nBitsPerComponent != 8 && nBitsPerComponent != 16) )
+        return false;
+
+    pKernel( pSrc, pDst, nPixels );
+    return true;
+}
+
+int ImageConverter::ConvertImages( PdfVecObjects & rObjects )
+{
+    // Keep this much raw image data in memory at once
+    const pdf_long MAX_BATCH_SIZE = 64 * 1024 * 1024;
+
+    std::vector<PdfObject*> vecImages;
+    TIVecObjects            it;
+
+    // Collect all images first, as converting palettes adds objects
+    for( it = rObjects.begin(); it != rObjects.end(); ++it )
+    {
+        if( !(*it)->IsDictionary() || !(*it)->HasStream() )
+            continue;
+
+        const PdfObject* pSubtype = (*it)->GetDictionary().GetKey( PdfName::KeySubtype );
+        if( !pSubtype || !pSubtype->IsName() || pSubtype->GetName() != PdfName("Image") )
+            continue;
+
+        vecImages.push_back( *it );
+
+        const PdfObject* pSMask = (*it)->GetDictionary().GetKey( "SMask" );
+        if( pSMask && pSMask->IsReference() )
+            m_setMasks.insert( pSMask->GetReference() );
+
+        const PdfObject* pMask = (*it)->GetDictionary().GetKey( "Mask" );
+        if( pMask && pMask->IsReference() )
+            m_setMasks.insert( pMask->GetReference() );
+    }
+
+    std::vector<TImageJob*> vecJobs;
+    pdf_long                lBatchSize = 0;
+    int                     nConverted = 0;
+
+    m_nPalettes = 0;
+
+    try {
+        for( size_t i = 0; i < vecImages.size(); i++ )
+        {
+            if( m_setMasks.count( vecImages[i]->Reference() ) )
+                continue;
+
+            TImageJob* pJob = new TImageJob();
+            vecJobs.push_back( pJob );
+
+            if( !this->PrepareJob( vecImages[i], pJob ) )
+            {
+                delete pJob;
+                vecJobs.pop_back();
+                continue;
+            }
+
+            lBatchSize += pJob->lLength;
+            if( lBatchSize >= MAX_BATCH_SIZE )
+            {
+                nConverted += this->RunJobs( vecJobs );
+                lBatchSize  = 0;
+            }
+        }
+
+        nConverted += this->RunJobs( vecJobs );
+    } catch( const PdfError & ) {
+        for( size_t i = 0; i < vecJobs.size(); i++ )
+            delete vecJobs[i];
+
+        throw;
+    }
+
+    return nConverted + m_nPalettes;
+}
+
+bool ImageConverter::PrepareJob( PdfObject* pObject, TImageJob* pJob )
+{
+    const PdfDictionary & dict = pObject->GetDictionary();
+    const PdfReference  & ref  = pObject->Reference();
+
+    // Stencil masks have no colorspace
+    const PdfObject* pImageMask = pObject->GetIndirectKey( "ImageMask" );
+    if( pImageMask && pImageMask->IsBool() && pImageMask->GetBool() )
+        return false;
+
+    PdfObject* pColorSpace = pObject->GetIndirectKey( "ColorSpace" );
+    if( !pColorSpace )
+    {
+        PdfError::LogMessage( eLogSeverity_Warning, "Image %i %i has no /ColorSpace and is not converted.\n",
+                              ref.ObjectNumber(), ref.GenerationNumber() );
+        return false;
+    }
+
+    if( pColorSpace->IsArray() && pColorSpace->GetArray().size()
+        && pColorSpace->GetArray()[0].IsName() && pColorSpace->GetArray()[0].GetName() == PdfName("Indexed") )
+    {
+        // Indexed images only need a new palette, but the palette
+        // of an indirect colorspace must be converted only once
+        if( pColorSpace->Reference().IsIndirect() )
+        {
+            if( m_setColorSpaces.count( pColorSpace->Reference() ) )
+                return false;
+
+            m_setColorSpaces.insert( pColorSpace->Reference() );
+        }
+
+        if( this->ConvertPalette( pObject, pColorSpace ) )
+            ++m_nPalettes;
+        else
+            PdfError::LogMessage( eLogSeverity_Warning, "The palette of image %i %i is not converted.\n",
+                                  ref.ObjectNumber(), ref.GenerationNumber() );
+
+        return false;
+    }
+
+    pJob->pObject     = pObject;
+    pJob->eColorSpace = this->GetDeviceColorSpace( pObject, pColorSpace );
+    if( pJob->eColorSpace == m_eColorSpace )
+        return false;
+    else if( !GetKernel( pJob->eColorSpace, m_eColorSpace, 8 ) )
+    {
+        PdfError::LogMessage( eLogSeverity_Warning, "Image %i %i has an unsupported colorspace and is not converted.\n",
+                              ref.ObjectNumber(), ref.GenerationNumber() );
+        return false;
+    }
+
+    const PdfObject* pBits   = pObject->GetIndirectKey( "BitsPerComponent" );
+    const PdfObject* pWidth  = pObject->GetIndirectKey( "Width" );
+    const PdfObject* pHeight = pObject->GetIndirectKey( "Height" );
+    if( !pBits || !pBits->IsNumber() || !pWidth || !pWidth->IsNumber() || !pHeight || !pHeight->IsNumber() )
+    {
+        PdfError::LogMessage( eLogSeverity_Warning, "Image %i %i has no valid /BitsPerComponent, /Width or /Height.\n",
+                              ref.ObjectNumber(), ref.GenerationNumber() );
+        return false;
+    }
+
+    pJob->nBitsPerComponent = static_cast<int>(pBits->GetNumber());
+    pJob->lPixels           = static_cast<pdf_long>(pWidth->GetNumber() * pHeight->GetNumber());
+    if( (pJob->nBitsPerComponent != 8 && pJob->nBitsPerComponent != 16) || pJob->lPixels <= 0 )
+    {
+        PdfError::LogMessage( eLogSeverity_Warning, "Image %i %i has %i bits per component, only 8 and 16 are supported.\n",
+                              ref.ObjectNumber(), ref.GenerationNumber(), pJob->nBitsPerComponent );
+        return false;
+    }
+
+    if( dict.HasKey( "Decode" ) )
+    {
+        PdfError::LogMessage( eLogSeverity_Warning, "Image %i %i has a /Decode array and is not converted.\n",
+                              ref.ObjectNumber(), ref.GenerationNumber() );
+        return false;
+    }
+
+    pJob->vecFilters = PdfFilterFactory::CreateFilterList( pObject );
+    for( TCIVecFilters itFilter = pJob->vecFilters.begin(); itFilter != pJob->vecFilters.end(); ++itFilter )
+    {
+        std::auto_ptr<PdfFilter> pFilter = PdfFilterFactory::Create( *itFilter );
+        if( !pFilter.get() || !pFilter->CanDecode() )
+        {
+            PdfError::LogMessage( eLogSeverity_Warning, "Image %i %i uses the filter %s, which cannot be decoded.\n",
+                                  ref.ObjectNumber(), ref.GenerationNumber(), PdfFilterFactory::FilterTypeToName( *itFilter ) );
+            return false;
+        }
+    }
+
+    // Copy the raw data, the stream may still be read from the input device
+    PdfBufferOutputStream stream( &pJob->data );
+    pObject->GetStream()->GetCopy( &stream );
+    stream.Close();
+
+    pJob->lLength    = stream.GetLength();
+    pJob->dictionary = dict;
+    pJob->eError     = ePdfError_ErrOk;
+
+    return true;
+}
+
+EPdfColorSpace ImageConverter::GetDeviceColorSpace( PdfObject* pImage, PdfObject* pColorSpace ) const
+{
+    if( pColorSpace->IsReference() )
+        pColorSpace = pImage->GetOwner()->GetObject( pColorSpace->GetReference() );
+
+    if( !pColorSpace )
+        return ePdfColorSpace_Unknown;
+    else if( pColorSpace->IsName() )
+        return PdfColor::GetColorSpaceForName( pColorSpace->GetName() );
+    else if( !pColorSpace->IsArray() || pColorSpace->GetArray().size() != 2 
+             || !pColorSpace->GetArray()[0].IsName() || pColorSpace->GetArray()[0].GetName() != PdfName("ICCBased") )
+        return ePdfColorSpace_Unknown;
+
+    PdfObject* pProfile = &pColorSpace->GetArray()[1];
+    if( pProfile->IsReference() )
+        pProfile = pImage->GetOwner()->GetObject( pProfile->GetReference() );
+
+    if( !pProfile || !pProfile->IsDictionary() )
+        return ePdfColorSpace_Unknown;
+
+    // Use the alternate colorspace if it is a device colorspace,
+    // otherwise the device colorspace with the same number of components
+    const PdfObject* pAlternate = pProfile->GetIndirectKey( "Alternate" );
+    if( pAlternate && pAlternate->IsName() )
+        return PdfColor::GetColorSpaceForName( pAlternate->GetName() );
+
+    switch( pProfile->GetDictionary().GetKeyAsLong( "N", 0 ) )
+    {
+        case 1:
+            return ePdfColorSpace_DeviceGray;
+        case 3:
+            return ePdfColorSpace_DeviceRGB;
+        case 4:
+            return ePdfColorSpace_DeviceCMYK;
+        default:
+            break;
+    }
+
+    return ePdfColorSpace_Unknown;
+}
+
+bool ImageConverter::ConvertPalette( PdfObject* pImage, PdfObject* pColorSpace )
+{
+    const PdfReference & ref    = pImage->Reference();
+    PdfArray           & array  = pColorSpace->GetArray();
+
+    if( array.size() != 4 || !array[2].IsNumber() )
+        return false;
+
+    EPdfColorSpace eBase   = this->GetDeviceColorSpace( pImage, &array[1] );
+    ImageKernel    pKernel = GetKernel( eBase, m_eColorSpace, 8 );
+    if( !pKernel )
+        return false;
+
+    PdfObject* pLookup = &array[3];
+    if( pLookup->IsReference() )
+        pLookup = pImage->GetOwner()->GetObject( pLookup->GetReference() );
+
+    if( !pLookup )
+        return false;
+
+    // The lookup table is a string or a stream with 8 bits per component
+    PdfRefCountedBuffer lookup;
+    pdf_long            lLookup;
+    if( (pLookup->IsString() || pLookup->IsHexString()) && !pLookup->GetString().IsUnicode() )
+    {
+        lLookup = pLookup->GetString().GetLength();
+        lookup  = PdfRefCountedBuffer( lLookup );
+        memcpy( lookup.GetBuffer(), pLookup->GetString().GetString(), lLookup );
+    }
+    else if( pLookup->HasStream() )
+    {
+        PdfBufferOutputStream stream( &lookup );
+        pLookup->GetStream()->GetFilteredCopy( &stream );
+        lLookup = stream.GetLength();
+    }
+    else
+    {
+        PdfError::LogMessage( eLogSeverity_Warning, "Image %i %i has an unsupported palette.\n",
+                              ref.ObjectNumber(), ref.GenerationNumber() );
+        return false;
+    }
+
+    size_t nEntries = static_cast<size_t>(array[2].GetNumber()) + 1;
+    size_t nInSize  = GetComponentCount( eBase );
+    size_t nOutSize = GetComponentCount( m_eColorSpace );
+
+    // Missing entries of a short palette stay 0
+    std::vector<unsigned char> palette( nEntries * nOutSize, 0 );
+    pKernel( reinterpret_cast<const unsigned char*>(lookup.GetBuffer()), &palette[0],
+             PDF_MIN( nEntries, static_cast<size_t>(lLookup) / nInSize ) );
+
+    // Store the new palette as stream, strings starting with 0xFE 0xFF
+    // would be taken as unicode
+    PdfObject* pPalette = pImage->GetOwner()->CreateObject();
+    pPalette->GetStream()->Set( reinterpret_cast<const char*>(&palette[0]), static_cast<pdf_long>(palette.size()) );
+
+    array[1] = PdfName( PdfColor::GetNameForColorSpace( m_eColorSpace ) );
+    array[3] = pPalette->Reference();
+
+    return true;
+}
+
+int ImageConverter::RunJobs( std::vector<TImageJob*> & rJobs )
+{
+    TJobQueue queue;
+    int       nThreads = static_cast<int>(PDF_MIN( static_cast<size_t>(m_nThreads), rJobs.size() ));
+
+    queue.pJobs   = &rJobs;
+    queue.nNext   = 0;
+    queue.eTarget = m_eColorSpace;
+
+    // The calling thread works, too. If no thread could be
+    // created, it converts all images alone.
+    Util::RunOnThreads( RunQueue, &queue, nThreads );
+
+    // Store the results in the document
+    int nConverted = 0;
+    for( size_t i = 0; i < rJobs.size(); i++ )
+    {
+        TImageJob*           pJob = rJobs[i];
+        const PdfReference & ref  = pJob->pObject->Reference();
+
+        if( pJob->eError == ePdfError_ErrOk )
+        {
+            PdfDictionary & dict = pJob->pObject->GetDictionary();
+            dict.AddKey( "ColorSpace", PdfColor::GetNameForColorSpace( m_eColorSpace ) );
+            dict.AddKey( PdfName::KeyFilter, PdfName( PdfFilterFactory::FilterTypeToName( ePdfFilter_FlateDecode ) ) );
+            dict.RemoveKey( "DecodeParms" );
+
+            PdfMemoryInputStream stream( pJob->data.GetBuffer(), pJob->lLength );
+            pJob->pObject->GetStream()->SetRawData( &stream, pJob->lLength );
+            ++nConverted;
+        }
+        else
+        {
+            PdfError::LogMessage( eLogSeverity_Warning, "Image %i %i could not be converted: %s\n",
+                                  ref.ObjectNumber(), ref.GenerationNumber(), PdfError::ErrorName( pJob->eError ) );
+        }
+
+        delete pJob;
+    }
+
+    rJobs.clear();
+    return nConverted;
+}
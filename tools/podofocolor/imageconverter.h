@@ -0,0 +1,140 @@
+/***************************************************************************
+ *   Copyright (C) 2010 by Dominik Seichter                                *
+ *   domseichter@web.de                                                    *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#ifndef _IMAGE_CONVERTER_H_
+#define _IMAGE_CONVERTER_H_
+
+#include <podofo.h>
+
+#include <set>
+#include <vector>
+
+struct TImageJob;
+
+/**
+ * Converts the samples of all image XObjects in a document
+ * into DeviceGray or DeviceCMYK.
+ *
+ * Images in DeviceGray, DeviceRGB and DeviceCMYK with 8 or 16 bits
+ * per component are decoded, converted and stored FlateDecode
+ * compressed. ICCBased images are converted like images in their
+ * alternate colorspace, or if there is none in the device colorspace
+ * with the same number of components. For Indexed images only the 
+ * palette is converted.
+ * The conversion uses the same formulas as PdfColor::ConvertToGrayScale
+ * and PdfColor::ConvertToCMYK in fixed point arithmetics.
+ *
+ * Images which cannot be converted (other colorspaces, /Decode arrays,
+ * filters PoDoFo cannot decode) are left unchanged and a warning
+ * is logged for each of them. Soft masks and explicit masks are 
+ * never converted.
+ */
+class ImageConverter {
+public:
+    /**
+     * @param eColorSpace the colorspace into which all images are converted,
+     *                    ePdfColorSpace_DeviceGray or ePdfColorSpace_DeviceCMYK
+     * @param nThreads number of threads used for the conversion,
+     *                 0 uses one thread per CPU
+     */
+    ImageConverter( PoDoFo::EPdfColorSpace eColorSpace, int nThreads = 0 );
+    ~ImageConverter();
+
+    /**
+     * Convert all images in a list of objects.
+     *
+     * The image data is read and written back to the objects
+     * on the calling thread, decoding, converting and encoding
+     * the images runs on all threads.
+     *
+     * @param rObjects all objects of a document
+     * @returns the number of converted images, including Indexed
+     *          images of which only the palette was converted
+     */
+    int ConvertImages( PoDoFo::PdfVecObjects & rObjects );
+
+    /**
+     * Convert pixels with the same kernel ConvertImages() uses.
+     *
+     * This allows to compare the SSE2 and NEON kernels
+     * with the scalar implementation.
+     *
+     * @param eSource colorspace of the pixels in pSrc
+     * @param eTarget colorspace of the pixels written to pDst
+     * @param nBitsPerComponent 8 or 16
+     * @param pSrc nPixels pixels in eSource
+     * @param pDst receives nPixels pixels in eTarget
+     * @param nPixels number of pixels to convert
+     * @param bScalar if true the scalar kernel is used even 
+     *                if a vector kernel is available
+     * @returns false if the conversion is not supported
+     */
+    static bool ConvertPixels( PoDoFo::EPdfColorSpace eSource, PoDoFo::EPdfColorSpace eTarget, int nBitsPerComponent,
+                               const unsigned char* pSrc, unsigned char* pDst, size_t nPixels, 
+                               bool bScalar = false );
+
+private:
+    /**
+     * Check if an object is a convertible image and read its data.
+     *
+     * @param pObject an image XObject
+     * @param pJob filled with everything needed to convert the image
+     * @returns true if the image data has to be converted
+     */
+    bool PrepareJob( PoDoFo::PdfObject* pObject, TImageJob* pJob );
+
+    /**
+     * Get the device colorspace in which the samples of an image are converted.
+     *
+     * @param pImage the image using the colorspace
+     * @param pColorSpace a colorspace name, ICCBased colorspace array
+     *                    or a reference to one of both
+     * @returns the device colorspace or ePdfColorSpace_Unknown
+     *          if the colorspace cannot be converted
+     */
+    PoDoFo::EPdfColorSpace GetDeviceColorSpace( PoDoFo::PdfObject* pImage, PoDoFo::PdfObject* pColorSpace ) const;
+
+    /**
+     * Convert the palette of an Indexed colorspace.
+     *
+     * @param pImage the image using the colorspace
+     * @param pColorSpace the colorspace array
+     * @returns true if the palette was converted
+     */
+    bool ConvertPalette( PoDoFo::PdfObject* pImage, PoDoFo::PdfObject* pColorSpace );
+
+    /**
+     * Convert all jobs on all threads and store the results
+     * in the image objects.
+     *
+     * @returns the number of converted images
+     */
+    int RunJobs( std::vector<TImageJob*> & rJobs );
+
+private:
+    PoDoFo::EPdfColorSpace m_eColorSpace;
+    int                    m_nThreads;
+    int                    m_nPalettes;                ///< Number of converted Indexed palettes
+
+    std::set<PoDoFo::PdfReference> m_setMasks;       ///< Soft masks and masks, which must not be converted
+    std::set<PoDoFo::PdfReference> m_setColorSpaces; ///< Indirect Indexed colorspaces which were already converted
+};
+
+#endif // _IMAGE_CONVERTER_H_
@@ -26,6 +26,7 @@
 
 #include "podofo_config.h"
 #include "colorchanger.h"
+#include "cmykconverter.h"
 #include "dummyconverter.h"
 #include "grayscaleconverter.h"
 #ifdef PODOFO_HAVE_LUA
@@ -36,11 +37,12 @@ static void print_help()
 {
 	std::cerr << "Usage: podofocolor [converter] [inputfile] [outpufile]\n";
 #ifdef PODOFO_HAVE_LUA
-    std::cerr << "\t[converter] can be one of: dummy|grayscale|lua [planfile]\n";
+    std::cerr << "\t[converter] can be one of: dummy|grayscale|cmyk|lua [planfile]\n";
 #else
-    std::cerr << "\t[converter] can be one of: dummy|grayscale\n";
+    std::cerr << "\t[converter] can be one of: dummy|grayscale|cmyk\n";
 #endif //  PODOFO_HAVE_LUA
 	std::cerr << "\tpodofocolor is a tool to change all colors in a PDF file based on a predefined or Lua description.\n";
+	std::cerr << "\tThe grayscale and cmyk converters also convert all DeviceRGB, DeviceCMYK and DeviceGray images.\n";
 	std::cerr << "\nPoDoFo Version: "<< PODOFO_VERSION_STRING <<"\n\n";
 }
 
@@ -58,6 +60,10 @@ static IConverter* ConverterForName( const std::string & converter, const std::s
     {
         pConverter = new GrayscaleConverter();
     }
+    else if( converter == "cmyk" )
+    {
+        pConverter = new CMYKConverter();
+    }
 #ifdef PODOFO_HAVE_LUA
     else if( converter == "lua" )
     {
@@ -42,6 +42,9 @@ void merge( const char* pszInput1, const char* pszInput2, const char* pszOutput
     printf("Reading file: %s\n", pszInput2 );
     PdfMemDocument input2( pszInput2 );
 
+    // copy the streams of input2 directly from its file when writing
+    input1.SetStreamPassthrough( true );
+
 // #define TEST_ONLY_SOME_PAGES
 #ifdef TEST_ONLY_SOME_PAGES
     input1.InsertPages( input2, 1, 2 );
@@ -20,8 +20,6 @@
 
 #include "TextExtractor.h"
 
-#include <stack>
-
 TextExtractor::TextExtractor()
 {
 
@@ -38,139 +36,28 @@ void TextExtractor::Init( const char* pszInput )
         PODOFO_RAISE_ERROR( ePdfError_InvalidHandle );
     }
 
-    PdfMemDocument document( pszInput );
-
-    int nCount = document.GetPageCount();
-    for( int i=0; i<nCount; i++ ) 
-    {
-        PdfPage* pPage = document.GetPage( i );
-        
-        this->ExtractText( &document, pPage );
-    }
-}
-
-void TextExtractor::ExtractText( PdfMemDocument* pDocument, PdfPage* pPage ) 
-{
-    const char*      pszToken = NULL;
-    PdfVariant       var;
-    EPdfContentsType eType;
-
-    PdfContentsTokenizer tokenizer( pPage );
+    PdfMemDocument           document( pszInput );
+    PdfTextExtractor         extractor( &document );
+    std::vector<PdfTextPage> vecText;
 
-    double dCurPosX     = 0.0;
-    double dCurPosY     = 0.0;
-    double dCurFontSize = 0.0;
-    bool   bTextBlock   = false;
-    PdfFont* pCurFont   = NULL;
+    // Extract all pages at once, so that they
+    // are processed on all CPUs of this machine
+    extractor.ExtractText( 0, document.GetPageCount(), vecText );
 
-    std::stack<PdfVariant> stack;
-
-    while( tokenizer.ReadNext( eType, pszToken, var ) )
-    {
-        if( eType == ePdfContentsType_Keyword )
-        {
-            // support 'l' and 'm' tokens
-            if( strcmp( pszToken, "l" ) == 0 || 
-                strcmp( pszToken, "m" ) == 0 )
-            {
-                dCurPosX = stack.top().GetReal();
-                stack.pop();
-                dCurPosY = stack.top().GetReal();
-                stack.pop();
-            }
-            else if( strcmp( pszToken, "BT" ) == 0 ) 
-            {
-                bTextBlock   = true;     
-                // BT does not reset font
-                // dCurFontSize = 0.0;
-                // pCurFont     = NULL;
-            }
-            else if( strcmp( pszToken, "ET" ) == 0 ) 
-            {
-                if( !bTextBlock ) 
-                    fprintf( stderr, "WARNING: Found ET without BT!\n" );
-            }
-
-            if( bTextBlock ) 
-            {
-                if( strcmp( pszToken, "Tf" ) == 0 ) 
-                {
-                    dCurFontSize = stack.top().GetReal();
-                    stack.pop();
-                    PdfName fontName = stack.top().GetName();
-                    PdfObject* pFont = pPage->GetFromResources( PdfName("Font"), fontName );
-                    if( !pFont ) 
-                    {
-                        PODOFO_RAISE_ERROR_INFO( ePdfError_InvalidHandle, "Cannot create font!" );
-                    }
-
-                    pCurFont = pDocument->GetFont( pFont );
-                    if( !pCurFont ) 
-                    {
-                        fprintf( stderr, "WARNING: Unable to create font for object %i %i R\n",
-                                 pFont->Reference().ObjectNumber(),
-                                 pFont->Reference().GenerationNumber() );
-                    }
-                }
-                else if( strcmp( pszToken, "Tj" ) == 0 ||
-                         strcmp( pszToken, "'" ) == 0 ) 
-                {
-                    AddTextElement( dCurPosX, dCurPosY, pCurFont, stack.top().GetString() );
-                    stack.pop();
-                }
-                else if( strcmp( pszToken, "\"" ) == 0 )
-                {
-                    AddTextElement( dCurPosX, dCurPosY, pCurFont, stack.top().GetString() );
-                    stack.pop();
-                    stack.pop(); // remove char spacing from stack
-                    stack.pop(); // remove word spacing from stack
-                }
-                else if( strcmp( pszToken, "TJ" ) == 0 ) 
-                {
-                    PdfArray array = stack.top().GetArray();
-                    stack.pop();
-                    
-                    for( int i=0; i<static_cast<int>(array.GetSize()); i++ ) 
-                    {
-                        if( array[i].IsString() || array[i].IsHexString() )
-                            AddTextElement( dCurPosX, dCurPosY, pCurFont, array[i].GetString() );
-                    }
-                }
-            }
-        }
-        else if ( eType == ePdfContentsType_Variant )
-        {
-            stack.push( var );
-        }
-        else
-        {
-            // Impossible; type must be keyword or variant
-            PODOFO_RAISE_ERROR( ePdfError_InternalLogic );
-        }
-    }
+    for( size_t i=0; i<vecText.size(); i++ ) 
+        this->PrintText( vecText[i] );
 }
 
-void TextExtractor::AddTextElement( double dCurPosX, double dCurPosY, 
-		PdfFont* pCurFont, const PdfString & rString )
+void TextExtractor::PrintText( const PdfTextPage & rText )
 {
-    if( !pCurFont ) 
-    {
-        fprintf( stderr, "WARNING: Found text but do not have a current font: %s\n", rString.GetString() );
-        return;
-    }
+    const std::vector<PdfTextPage::TRun> & rRuns = rText.GetRuns();
 
-    if( !pCurFont->GetEncoding() ) 
+    for( size_t i=0; i<rRuns.size(); i++ ) 
     {
-        fprintf( stderr, "WARNING: Found text but do not have a current encoding: %s\n", rString.GetString() );
-        return;
-    }
+        if( !rRuns[i].nTextLength )
+            continue;
 
-    // For now just write to console
-    PdfString unicode = pCurFont->GetEncoding()->ConvertToUnicode( rString, pCurFont );
-    const char* pszData = unicode.GetStringUtf8().c_str();
-    while( *pszData ) {
-        //printf("%02x", static_cast<unsigned char>(*pszData) );
-        ++pszData;
+        // For now just write to console
+        printf("(%.3f,%.3f) %s \n", rRuns[i].dX, rRuns[i].dY, rText.GetText( rRuns[i] ).c_str() );
     }
-	printf("(%.3f,%.3f) %s \n", dCurPosX, dCurPosY, unicode.GetStringUtf8().c_str() );
 }
@@ -26,10 +26,6 @@
 
 using namespace PoDoFo;
 
-#ifndef MAX_PATH
-#define MAX_PATH 512
-#endif // MAX_PATH
-
 /** This class uses the PoDoFo lib to parse 
  *  a PDF file and to write all text it finds
  *  in this PDF document to stdout.
@@ -42,26 +38,12 @@ class TextExtractor {
     void Init( const char* pszInput );
 
  private:
-    /** Extract all text from the given page
+    /** Write the text of a page to stdout, one line
+     *  per string with its position on the page.
      *
-     *  \param pDocument the owning document
-     *  \param pPage extract the text of this page.
+     *  \param rText the text of a page
      */
-    void ExtractText( PdfMemDocument* pDocument, PdfPage* pPage );
-
-    /** Adds a text string to a list which can be sorted by 
-     *  position on the page later, so that the whole structure 
-     *  of the text including formatting can be reconstructed.
-     *
-     *  \param dCurPosX x position of the text
-     *  \param dCurPosY y position of the text
-     *  \param pCurFont font of the text
-     *  \param rString the actual string
-     */
-    void AddTextElement( double dCurPosX, double dCurPosY, 
-                         PdfFont* pCurFont, const PdfString & rString );
- private:
-    char         m_szBuffer[MAX_PATH];
+    void PrintText( const PdfTextPage & rText );
 };
 
 #endif // _TEXT_EXTRACTOR_H_
@@ -41,6 +41,10 @@ void UnCompress::Init( const char* pszInput, const char* pszOutput )
 
     m_pDocument = new PdfMemDocument( pszInput );
 
+    // Decrypt and decode all streams on all CPUs first,
+    // UncompressObjects() only handles the remaining streams then
+    m_pDocument->PreloadStreams( true );
+
     this->UncompressObjects();
 
     PdfWriter writer( &(m_pDocument->GetObjects()), new PdfObject( *(m_pDocument->GetTrailer() ) ) );